@@ -0,0 +1,488 @@
+/* GStreamer
+ *
+ * audio-resampler-x86-avx2.c: AVX2/FMA inner products for the audio resampler
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "audio-resampler-x86-avx2.h"
+
+#if defined (HAVE_IMMINTRIN_H) && defined (__AVX2__) && defined (__FMA__)
+#include <immintrin.h>
+
+/* The taps are only 16 byte aligned so all loads are unaligned. The loops
+ * never read further past @len than the SSE versions, the 128 bit tails
+ * handle the lengths that are not a multiple of the vector size.
+ *
+ * The integer versions sum up exactly like the C versions and then do the
+ * same rounding, so they produce the same output. */
+
+#define LOAD256(p) _mm256_loadu_si256 ((const __m256i *) (p))
+#define LOAD128(p) _mm_loadu_si128 ((const __m128i *) (p))
+
+static inline gfloat
+hsum_ps (__m256 v)
+{
+  __m128 s = _mm_add_ps (_mm256_castps256_ps128 (v),
+      _mm256_extractf128_ps (v, 1));
+
+  s = _mm_add_ps (s, _mm_movehl_ps (s, s));
+  s = _mm_add_ss (s, _mm_shuffle_ps (s, s, 0x55));
+  return _mm_cvtss_f32 (s);
+}
+
+static inline gdouble
+hsum_pd (__m256d v)
+{
+  __m128d s = _mm_add_pd (_mm256_castpd256_pd128 (v),
+      _mm256_extractf128_pd (v, 1));
+
+  s = _mm_add_sd (s, _mm_unpackhi_pd (s, s));
+  return _mm_cvtsd_f64 (s);
+}
+
+static inline gint32
+hsum128_epi32 (__m128i s)
+{
+  s = _mm_add_epi32 (s, _mm_shuffle_epi32 (s, _MM_SHUFFLE (1, 0, 3, 2)));
+  s = _mm_add_epi32 (s, _mm_shuffle_epi32 (s, _MM_SHUFFLE (2, 3, 0, 1)));
+  return _mm_cvtsi128_si32 (s);
+}
+
+static inline gint32
+hsum_epi32 (__m256i v)
+{
+  return hsum128_epi32 (_mm_add_epi32 (_mm256_castsi256_si128 (v),
+          _mm256_extracti128_si256 (v, 1)));
+}
+
+static inline gint64
+hsum128_epi64 (__m128i s)
+{
+  gint64 res;
+
+  /* _mm_cvtsi128_si64() is not available on 32 bit x86 */
+  s = _mm_add_epi64 (s, _mm_unpackhi_epi64 (s, s));
+  _mm_storel_epi64 ((__m128i *) & res, s);
+  return res;
+}
+
+static inline gint64
+hsum_epi64 (__m256i v)
+{
+  return hsum128_epi64 (_mm_add_epi64 (_mm256_castsi256_si128 (v),
+          _mm256_extracti128_si256 (v, 1)));
+}
+
+/* adds the 64 bit products of the 32 bit samples in @a and @b to @sum */
+static inline __m256i
+madd_epi32 (__m256i sum, __m256i a, __m256i b)
+{
+  sum = _mm256_add_epi64 (sum, _mm256_mul_epi32 (a, b));
+  return _mm256_add_epi64 (sum, _mm256_mul_epi32 (_mm256_srli_epi64 (a, 32),
+          _mm256_srli_epi64 (b, 32)));
+}
+
+static inline __m128i
+madd128_epi32 (__m128i sum, __m128i a, __m128i b)
+{
+  sum = _mm_add_epi64 (sum, _mm_mul_epi32 (a, b));
+  return _mm_add_epi64 (sum, _mm_mul_epi32 (_mm_srli_epi64 (a, 32),
+          _mm_srli_epi64 (b, 32)));
+}
+
+static inline void
+inner_product_gint16_full_1_avx2 (gint16 * o, const gint16 * a,
+    const gint16 * b, gint len, const gint16 * icoeff, gint bstride)
+{
+  gint i;
+  gint32 res;
+  __m256i sum[2];
+
+  sum[0] = sum[1] = _mm256_setzero_si256 ();
+
+  for (i = 0; i + 32 <= len; i += 32) {
+    sum[0] = _mm256_add_epi32 (sum[0],
+        _mm256_madd_epi16 (LOAD256 (a + i), LOAD256 (b + i)));
+    sum[1] = _mm256_add_epi32 (sum[1],
+        _mm256_madd_epi16 (LOAD256 (a + i + 16), LOAD256 (b + i + 16)));
+  }
+  for (; i < len; i += 16)
+    sum[0] = _mm256_add_epi32 (sum[0],
+        _mm256_madd_epi16 (LOAD256 (a + i), LOAD256 (b + i)));
+
+  res = hsum_epi32 (_mm256_add_epi32 (sum[0], sum[1]));
+  res = (res + (1 << (PRECISION_S16 - 1))) >> PRECISION_S16;
+  *o = CLAMP (res, G_MININT16, G_MAXINT16);
+}
+
+static inline void
+inner_product_gint16_linear_1_avx2 (gint16 * o, const gint16 * a,
+    const gint16 * b, gint len, const gint16 * icoeff, gint bstride)
+{
+  gint i;
+  gint32 res[2];
+  __m256i sum[2], t;
+  const gint16 *c[2] = { (gint16 *) ((gint8 *) b + 0 * bstride),
+    (gint16 *) ((gint8 *) b + 1 * bstride)
+  };
+
+  sum[0] = sum[1] = _mm256_setzero_si256 ();
+
+  for (i = 0; i < len; i += 16) {
+    t = LOAD256 (a + i);
+    sum[0] = _mm256_add_epi32 (sum[0],
+        _mm256_madd_epi16 (t, LOAD256 (c[0] + i)));
+    sum[1] = _mm256_add_epi32 (sum[1],
+        _mm256_madd_epi16 (t, LOAD256 (c[1] + i)));
+  }
+  res[0] = hsum_epi32 (sum[0]) >> PRECISION_S16;
+  res[1] = hsum_epi32 (sum[1]) >> PRECISION_S16;
+
+  res[0] = ((gint32) (gint16) res[0] - (gint32) (gint16) res[1]) * icoeff[0] +
+      ((gint32) (gint16) res[1] << PRECISION_S16);
+  res[0] = (res[0] + (1 << (PRECISION_S16 - 1))) >> PRECISION_S16;
+  *o = CLAMP (res[0], G_MININT16, G_MAXINT16);
+}
+
+static inline void
+inner_product_gint16_cubic_1_avx2 (gint16 * o, const gint16 * a,
+    const gint16 * b, gint len, const gint16 * icoeff, gint bstride)
+{
+  gint i, j;
+  gint32 res;
+  __m256i sum[4], t;
+  __m128i tsum[4], tt;
+  const gint16 *c[4] = { (gint16 *) ((gint8 *) b + 0 * bstride),
+    (gint16 *) ((gint8 *) b + 1 * bstride),
+    (gint16 *) ((gint8 *) b + 2 * bstride),
+    (gint16 *) ((gint8 *) b + 3 * bstride)
+  };
+
+  for (j = 0; j < 4; j++) {
+    sum[j] = _mm256_setzero_si256 ();
+    tsum[j] = _mm_setzero_si128 ();
+  }
+
+  for (i = 0; i + 16 <= len; i += 16) {
+    t = LOAD256 (a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = _mm256_add_epi32 (sum[j],
+          _mm256_madd_epi16 (t, LOAD256 (c[j] + i)));
+  }
+  for (; i < len; i += 8) {
+    tt = LOAD128 (a + i);
+    for (j = 0; j < 4; j++)
+      tsum[j] = _mm_add_epi32 (tsum[j], _mm_madd_epi16 (tt,
+              LOAD128 (c[j] + i)));
+  }
+
+  res = 0;
+  for (j = 0; j < 4; j++) {
+    gint32 r = hsum_epi32 (sum[j]) + hsum128_epi32 (tsum[j]);
+
+    res += (gint32) (gint16) (r >> PRECISION_S16) * (gint32) icoeff[j];
+  }
+  res = (res + (1 << (PRECISION_S16 - 1))) >> PRECISION_S16;
+  *o = CLAMP (res, G_MININT16, G_MAXINT16);
+}
+
+static inline void
+inner_product_gint32_full_1_avx2 (gint32 * o, const gint32 * a,
+    const gint32 * b, gint len, const gint32 * icoeff, gint bstride)
+{
+  gint i;
+  gint64 res;
+  __m256i sum;
+
+  sum = _mm256_setzero_si256 ();
+
+  for (i = 0; i < len; i += 8)
+    sum = madd_epi32 (sum, LOAD256 (a + i), LOAD256 (b + i));
+
+  res = hsum_epi64 (sum);
+  res = (res + (1 << (PRECISION_S32 - 1))) >> PRECISION_S32;
+  *o = CLAMP (res, G_MININT32, G_MAXINT32);
+}
+
+static inline void
+inner_product_gint32_linear_1_avx2 (gint32 * o, const gint32 * a,
+    const gint32 * b, gint len, const gint32 * icoeff, gint bstride)
+{
+  gint i, j;
+  gint64 res[2];
+  __m256i sum[2], t;
+  __m128i tsum[2], tt;
+  const gint32 *c[2] = { (gint32 *) ((gint8 *) b + 0 * bstride),
+    (gint32 *) ((gint8 *) b + 1 * bstride)
+  };
+
+  for (j = 0; j < 2; j++) {
+    sum[j] = _mm256_setzero_si256 ();
+    tsum[j] = _mm_setzero_si128 ();
+  }
+
+  for (i = 0; i + 8 <= len; i += 8) {
+    t = LOAD256 (a + i);
+    sum[0] = madd_epi32 (sum[0], t, LOAD256 (c[0] + i));
+    sum[1] = madd_epi32 (sum[1], t, LOAD256 (c[1] + i));
+  }
+  for (; i < len; i += 4) {
+    tt = LOAD128 (a + i);
+    tsum[0] = madd128_epi32 (tsum[0], tt, LOAD128 (c[0] + i));
+    tsum[1] = madd128_epi32 (tsum[1], tt, LOAD128 (c[1] + i));
+  }
+  for (j = 0; j < 2; j++)
+    res[j] = (hsum_epi64 (sum[j]) + hsum128_epi64 (tsum[j])) >> PRECISION_S32;
+
+  res[0] = ((gint64) (gint32) res[0] - (gint64) (gint32) res[1]) * icoeff[0] +
+      ((gint64) (gint32) res[1] << PRECISION_S32);
+  res[0] = (res[0] + ((gint64) 1 << (PRECISION_S32 - 1))) >> PRECISION_S32;
+  *o = CLAMP (res[0], G_MININT32, G_MAXINT32);
+}
+
+static inline void
+inner_product_gint32_cubic_1_avx2 (gint32 * o, const gint32 * a,
+    const gint32 * b, gint len, const gint32 * icoeff, gint bstride)
+{
+  gint i, j;
+  gint64 res;
+  __m256i sum[4], t;
+  __m128i tsum[4], tt;
+  const gint32 *c[4] = { (gint32 *) ((gint8 *) b + 0 * bstride),
+    (gint32 *) ((gint8 *) b + 1 * bstride),
+    (gint32 *) ((gint8 *) b + 2 * bstride),
+    (gint32 *) ((gint8 *) b + 3 * bstride)
+  };
+
+  for (j = 0; j < 4; j++) {
+    sum[j] = _mm256_setzero_si256 ();
+    tsum[j] = _mm_setzero_si128 ();
+  }
+
+  for (i = 0; i + 8 <= len; i += 8) {
+    t = LOAD256 (a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = madd_epi32 (sum[j], t, LOAD256 (c[j] + i));
+  }
+  for (; i < len; i += 4) {
+    tt = LOAD128 (a + i);
+    for (j = 0; j < 4; j++)
+      tsum[j] = madd128_epi32 (tsum[j], tt, LOAD128 (c[j] + i));
+  }
+
+  res = 0;
+  for (j = 0; j < 4; j++) {
+    gint64 r = hsum_epi64 (sum[j]) + hsum128_epi64 (tsum[j]);
+
+    res += (gint64) (gint32) (r >> PRECISION_S32) * (gint64) icoeff[j];
+  }
+  res = (res + ((gint64) 1 << (PRECISION_S32 - 1))) >> PRECISION_S32;
+  *o = CLAMP (res, G_MININT32, G_MAXINT32);
+}
+
+static inline void
+inner_product_gfloat_full_1_avx2 (gfloat * o, const gfloat * a,
+    const gfloat * b, gint len, const gfloat * icoeff, gint bstride)
+{
+  gint i;
+  __m256 sum[2];
+
+  sum[0] = sum[1] = _mm256_setzero_ps ();
+
+  for (i = 0; i + 16 <= len; i += 16) {
+    sum[0] = _mm256_fmadd_ps (_mm256_loadu_ps (a + i),
+        _mm256_loadu_ps (b + i), sum[0]);
+    sum[1] = _mm256_fmadd_ps (_mm256_loadu_ps (a + i + 8),
+        _mm256_loadu_ps (b + i + 8), sum[1]);
+  }
+  for (; i < len; i += 8)
+    sum[0] = _mm256_fmadd_ps (_mm256_loadu_ps (a + i),
+        _mm256_loadu_ps (b + i), sum[0]);
+
+  *o = hsum_ps (_mm256_add_ps (sum[0], sum[1]));
+}
+
+static inline void
+inner_product_gfloat_linear_1_avx2 (gfloat * o, const gfloat * a,
+    const gfloat * b, gint len, const gfloat * icoeff, gint bstride)
+{
+  gint i;
+  gfloat res[2];
+  __m256 sum[2], t;
+  const gfloat *c[2] = { (gfloat *) ((gint8 *) b + 0 * bstride),
+    (gfloat *) ((gint8 *) b + 1 * bstride)
+  };
+
+  sum[0] = sum[1] = _mm256_setzero_ps ();
+
+  for (i = 0; i < len; i += 8) {
+    t = _mm256_loadu_ps (a + i);
+    sum[0] = _mm256_fmadd_ps (t, _mm256_loadu_ps (c[0] + i), sum[0]);
+    sum[1] = _mm256_fmadd_ps (t, _mm256_loadu_ps (c[1] + i), sum[1]);
+  }
+  res[0] = hsum_ps (sum[0]);
+  res[1] = hsum_ps (sum[1]);
+
+  *o = (res[0] - res[1]) * icoeff[0] + res[1];
+}
+
+static inline void
+inner_product_gfloat_cubic_1_avx2 (gfloat * o, const gfloat * a,
+    const gfloat * b, gint len, const gfloat * icoeff, gint bstride)
+{
+  gint i, j;
+  __m256 sum[4], t;
+  __m128 tsum[4], tt, res;
+  const gfloat *c[4] = { (gfloat *) ((gint8 *) b + 0 * bstride),
+    (gfloat *) ((gint8 *) b + 1 * bstride),
+    (gfloat *) ((gint8 *) b + 2 * bstride),
+    (gfloat *) ((gint8 *) b + 3 * bstride)
+  };
+
+  for (j = 0; j < 4; j++) {
+    sum[j] = _mm256_setzero_ps ();
+    tsum[j] = _mm_setzero_ps ();
+  }
+
+  for (i = 0; i + 8 <= len; i += 8) {
+    t = _mm256_loadu_ps (a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = _mm256_fmadd_ps (t, _mm256_loadu_ps (c[j] + i), sum[j]);
+  }
+  for (; i < len; i += 4) {
+    tt = _mm_loadu_ps (a + i);
+    for (j = 0; j < 4; j++)
+      tsum[j] = _mm_fmadd_ps (tt, _mm_loadu_ps (c[j] + i), tsum[j]);
+  }
+
+  /* fold everything into 4 lanes and transpose so that lane j holds the
+   * partial sums for phase j */
+  for (j = 0; j < 4; j++)
+    tsum[j] = _mm_add_ps (tsum[j], _mm_add_ps (_mm256_castps256_ps128 (sum[j]),
+            _mm256_extractf128_ps (sum[j], 1)));
+  _MM_TRANSPOSE4_PS (tsum[0], tsum[1], tsum[2], tsum[3]);
+  res = _mm_add_ps (_mm_add_ps (tsum[0], tsum[1]),
+      _mm_add_ps (tsum[2], tsum[3]));
+  res = _mm_mul_ps (res, _mm_loadu_ps (icoeff));
+  res = _mm_add_ps (res, _mm_movehl_ps (res, res));
+  res = _mm_add_ss (res, _mm_shuffle_ps (res, res, 0x55));
+  _mm_store_ss (o, res);
+}
+
+static inline void
+inner_product_gdouble_full_1_avx2 (gdouble * o, const gdouble * a,
+    const gdouble * b, gint len, const gdouble * icoeff, gint bstride)
+{
+  gint i;
+  __m256d sum[2];
+
+  sum[0] = sum[1] = _mm256_setzero_pd ();
+
+  for (i = 0; i < len; i += 8) {
+    sum[0] = _mm256_fmadd_pd (_mm256_loadu_pd (a + i),
+        _mm256_loadu_pd (b + i), sum[0]);
+    sum[1] = _mm256_fmadd_pd (_mm256_loadu_pd (a + i + 4),
+        _mm256_loadu_pd (b + i + 4), sum[1]);
+  }
+  *o = hsum_pd (_mm256_add_pd (sum[0], sum[1]));
+}
+
+static inline void
+inner_product_gdouble_linear_1_avx2 (gdouble * o, const gdouble * a,
+    const gdouble * b, gint len, const gdouble * icoeff, gint bstride)
+{
+  gint i;
+  gdouble res[2];
+  __m256d sum[2], t;
+  const gdouble *c[2] = { (gdouble *) ((gint8 *) b + 0 * bstride),
+    (gdouble *) ((gint8 *) b + 1 * bstride)
+  };
+
+  sum[0] = sum[1] = _mm256_setzero_pd ();
+
+  for (i = 0; i < len; i += 4) {
+    t = _mm256_loadu_pd (a + i);
+    sum[0] = _mm256_fmadd_pd (t, _mm256_loadu_pd (c[0] + i), sum[0]);
+    sum[1] = _mm256_fmadd_pd (t, _mm256_loadu_pd (c[1] + i), sum[1]);
+  }
+  res[0] = hsum_pd (sum[0]);
+  res[1] = hsum_pd (sum[1]);
+
+  *o = (res[0] - res[1]) * icoeff[0] + res[1];
+}
+
+static inline void
+inner_product_gdouble_cubic_1_avx2 (gdouble * o, const gdouble * a,
+    const gdouble * b, gint len, const gdouble * icoeff, gint bstride)
+{
+  gint i, j;
+  __m256d sum[4], t;
+  __m128d tsum[4], tt;
+  gdouble res = 0.0;
+  const gdouble *c[4] = { (gdouble *) ((gint8 *) b + 0 * bstride),
+    (gdouble *) ((gint8 *) b + 1 * bstride),
+    (gdouble *) ((gint8 *) b + 2 * bstride),
+    (gdouble *) ((gint8 *) b + 3 * bstride)
+  };
+
+  for (j = 0; j < 4; j++) {
+    sum[j] = _mm256_setzero_pd ();
+    tsum[j] = _mm_setzero_pd ();
+  }
+
+  for (i = 0; i + 4 <= len; i += 4) {
+    t = _mm256_loadu_pd (a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = _mm256_fmadd_pd (t, _mm256_loadu_pd (c[j] + i), sum[j]);
+  }
+  for (; i < len; i += 2) {
+    tt = _mm_loadu_pd (a + i);
+    for (j = 0; j < 4; j++)
+      tsum[j] = _mm_fmadd_pd (tt, _mm_loadu_pd (c[j] + i), tsum[j]);
+  }
+
+  for (j = 0; j < 4; j++) {
+    __m128d s = _mm_add_pd (tsum[j], _mm_add_pd (_mm256_castpd256_pd128 (sum[j]),
+            _mm256_extractf128_pd (sum[j], 1)));
+
+    s = _mm_add_sd (s, _mm_unpackhi_pd (s, s));
+    res += _mm_cvtsd_f64 (s) * icoeff[j];
+  }
+  *o = res;
+}
+
+MAKE_RESAMPLE_FUNC (gint16, full, 1, avx2);
+MAKE_RESAMPLE_FUNC (gint16, linear, 1, avx2);
+MAKE_RESAMPLE_FUNC (gint16, cubic, 1, avx2);
+
+MAKE_RESAMPLE_FUNC (gint32, full, 1, avx2);
+MAKE_RESAMPLE_FUNC (gint32, linear, 1, avx2);
+MAKE_RESAMPLE_FUNC (gint32, cubic, 1, avx2);
+
+MAKE_RESAMPLE_FUNC (gfloat, full, 1, avx2);
+MAKE_RESAMPLE_FUNC (gfloat, linear, 1, avx2);
+MAKE_RESAMPLE_FUNC (gfloat, cubic, 1, avx2);
+
+MAKE_RESAMPLE_FUNC (gdouble, full, 1, avx2);
+MAKE_RESAMPLE_FUNC (gdouble, linear, 1, avx2);
+MAKE_RESAMPLE_FUNC (gdouble, cubic, 1, avx2);
+
+#endif
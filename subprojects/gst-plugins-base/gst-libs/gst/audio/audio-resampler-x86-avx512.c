@@ -0,0 +1,446 @@
+/* GStreamer
+ *
+ * audio-resampler-x86-avx512.c: AVX-512 inner products for the audio resampler
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "audio-resampler-x86-avx512.h"
+
+#if defined (HAVE_IMMINTRIN_H) && defined (__AVX512F__) && defined (__AVX512BW__)
+
+#include <immintrin.h>
+
+/* The taps are only 16 byte aligned so all loads are unaligned. The last
+ * partial vector is loaded with a mask so nothing past @len is read.
+ *
+ * The integer versions sum up exactly like the C versions and then do the
+ * same rounding, so they produce the same output. */
+
+#define LOAD512(p) _mm512_loadu_si512 ((const void *) (p))
+
+/* adds the 64 bit products of the 32 bit samples in @a and @b to @sum */
+static inline __m512i
+madd_epi32 (__m512i sum, __m512i a, __m512i b)
+{
+  sum = _mm512_add_epi64 (sum, _mm512_mul_epi32 (a, b));
+  return _mm512_add_epi64 (sum, _mm512_mul_epi32 (_mm512_srli_epi64 (a, 32),
+          _mm512_srli_epi64 (b, 32)));
+}
+
+static inline void
+inner_product_gint16_full_1_avx512 (gint16 * o, const gint16 * a,
+    const gint16 * b, gint len, const gint16 * icoeff, gint bstride)
+{
+  gint i;
+  gint32 res;
+  __m512i sum = _mm512_setzero_si512 ();
+
+  for (i = 0; i + 32 <= len; i += 32)
+    sum = _mm512_add_epi32 (sum,
+        _mm512_madd_epi16 (LOAD512 (a + i), LOAD512 (b + i)));
+  if (i < len) {
+    __mmask32 m = (__mmask32) ((1U << (len - i)) - 1);
+
+    sum = _mm512_add_epi32 (sum,
+        _mm512_madd_epi16 (_mm512_maskz_loadu_epi16 (m, a + i),
+            _mm512_maskz_loadu_epi16 (m, b + i)));
+  }
+
+  res = _mm512_reduce_add_epi32 (sum);
+  res = (res + (1 << (PRECISION_S16 - 1))) >> PRECISION_S16;
+  *o = CLAMP (res, G_MININT16, G_MAXINT16);
+}
+
+static inline void
+inner_product_gint16_linear_1_avx512 (gint16 * o, const gint16 * a,
+    const gint16 * b, gint len, const gint16 * icoeff, gint bstride)
+{
+  gint i;
+  gint32 res[2];
+  __m512i sum[2], t;
+  const gint16 *c[2] = { (gint16 *) ((gint8 *) b + 0 * bstride),
+    (gint16 *) ((gint8 *) b + 1 * bstride)
+  };
+
+  sum[0] = sum[1] = _mm512_setzero_si512 ();
+
+  for (i = 0; i + 32 <= len; i += 32) {
+    t = LOAD512 (a + i);
+    sum[0] = _mm512_add_epi32 (sum[0],
+        _mm512_madd_epi16 (t, LOAD512 (c[0] + i)));
+    sum[1] = _mm512_add_epi32 (sum[1],
+        _mm512_madd_epi16 (t, LOAD512 (c[1] + i)));
+  }
+  if (i < len) {
+    __mmask32 m = (__mmask32) ((1U << (len - i)) - 1);
+
+    t = _mm512_maskz_loadu_epi16 (m, a + i);
+    sum[0] = _mm512_add_epi32 (sum[0],
+        _mm512_madd_epi16 (t, _mm512_maskz_loadu_epi16 (m, c[0] + i)));
+    sum[1] = _mm512_add_epi32 (sum[1],
+        _mm512_madd_epi16 (t, _mm512_maskz_loadu_epi16 (m, c[1] + i)));
+  }
+  res[0] = _mm512_reduce_add_epi32 (sum[0]) >> PRECISION_S16;
+  res[1] = _mm512_reduce_add_epi32 (sum[1]) >> PRECISION_S16;
+
+  res[0] = ((gint32) (gint16) res[0] - (gint32) (gint16) res[1]) * icoeff[0] +
+      ((gint32) (gint16) res[1] << PRECISION_S16);
+  res[0] = (res[0] + (1 << (PRECISION_S16 - 1))) >> PRECISION_S16;
+  *o = CLAMP (res[0], G_MININT16, G_MAXINT16);
+}
+
+static inline void
+inner_product_gint16_cubic_1_avx512 (gint16 * o, const gint16 * a,
+    const gint16 * b, gint len, const gint16 * icoeff, gint bstride)
+{
+  gint i, j;
+  gint32 res;
+  __m512i sum[4], t;
+  const gint16 *c[4] = { (gint16 *) ((gint8 *) b + 0 * bstride),
+    (gint16 *) ((gint8 *) b + 1 * bstride),
+    (gint16 *) ((gint8 *) b + 2 * bstride),
+    (gint16 *) ((gint8 *) b + 3 * bstride)
+  };
+
+  for (j = 0; j < 4; j++)
+    sum[j] = _mm512_setzero_si512 ();
+
+  for (i = 0; i + 32 <= len; i += 32) {
+    t = LOAD512 (a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = _mm512_add_epi32 (sum[j],
+          _mm512_madd_epi16 (t, LOAD512 (c[j] + i)));
+  }
+  if (i < len) {
+    __mmask32 m = (__mmask32) ((1U << (len - i)) - 1);
+
+    t = _mm512_maskz_loadu_epi16 (m, a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = _mm512_add_epi32 (sum[j],
+          _mm512_madd_epi16 (t, _mm512_maskz_loadu_epi16 (m, c[j] + i)));
+  }
+
+  res = 0;
+  for (j = 0; j < 4; j++)
+    res += (gint32) (gint16) (_mm512_reduce_add_epi32 (sum[j]) >>
+        PRECISION_S16) * (gint32) icoeff[j];
+  res = (res + (1 << (PRECISION_S16 - 1))) >> PRECISION_S16;
+  *o = CLAMP (res, G_MININT16, G_MAXINT16);
+}
+
+static inline void
+inner_product_gint32_full_1_avx512 (gint32 * o, const gint32 * a,
+    const gint32 * b, gint len, const gint32 * icoeff, gint bstride)
+{
+  gint i;
+  gint64 res;
+  __m512i sum = _mm512_setzero_si512 ();
+
+  for (i = 0; i + 16 <= len; i += 16)
+    sum = madd_epi32 (sum, LOAD512 (a + i), LOAD512 (b + i));
+  if (i < len) {
+    __mmask16 m = (__mmask16) ((1U << (len - i)) - 1);
+
+    sum = madd_epi32 (sum, _mm512_maskz_loadu_epi32 (m, a + i),
+        _mm512_maskz_loadu_epi32 (m, b + i));
+  }
+
+  res = _mm512_reduce_add_epi64 (sum);
+  res = (res + (1 << (PRECISION_S32 - 1))) >> PRECISION_S32;
+  *o = CLAMP (res, G_MININT32, G_MAXINT32);
+}
+
+static inline void
+inner_product_gint32_linear_1_avx512 (gint32 * o, const gint32 * a,
+    const gint32 * b, gint len, const gint32 * icoeff, gint bstride)
+{
+  gint i;
+  gint64 res[2];
+  __m512i sum[2], t;
+  const gint32 *c[2] = { (gint32 *) ((gint8 *) b + 0 * bstride),
+    (gint32 *) ((gint8 *) b + 1 * bstride)
+  };
+
+  sum[0] = sum[1] = _mm512_setzero_si512 ();
+
+  for (i = 0; i + 16 <= len; i += 16) {
+    t = LOAD512 (a + i);
+    sum[0] = madd_epi32 (sum[0], t, LOAD512 (c[0] + i));
+    sum[1] = madd_epi32 (sum[1], t, LOAD512 (c[1] + i));
+  }
+  if (i < len) {
+    __mmask16 m = (__mmask16) ((1U << (len - i)) - 1);
+
+    t = _mm512_maskz_loadu_epi32 (m, a + i);
+    sum[0] = madd_epi32 (sum[0], t, _mm512_maskz_loadu_epi32 (m, c[0] + i));
+    sum[1] = madd_epi32 (sum[1], t, _mm512_maskz_loadu_epi32 (m, c[1] + i));
+  }
+  res[0] = _mm512_reduce_add_epi64 (sum[0]) >> PRECISION_S32;
+  res[1] = _mm512_reduce_add_epi64 (sum[1]) >> PRECISION_S32;
+
+  res[0] = ((gint64) (gint32) res[0] - (gint64) (gint32) res[1]) * icoeff[0] +
+      ((gint64) (gint32) res[1] << PRECISION_S32);
+  res[0] = (res[0] + ((gint64) 1 << (PRECISION_S32 - 1))) >> PRECISION_S32;
+  *o = CLAMP (res[0], G_MININT32, G_MAXINT32);
+}
+
+static inline void
+inner_product_gint32_cubic_1_avx512 (gint32 * o, const gint32 * a,
+    const gint32 * b, gint len, const gint32 * icoeff, gint bstride)
+{
+  gint i, j;
+  gint64 res;
+  __m512i sum[4], t;
+  const gint32 *c[4] = { (gint32 *) ((gint8 *) b + 0 * bstride),
+    (gint32 *) ((gint8 *) b + 1 * bstride),
+    (gint32 *) ((gint8 *) b + 2 * bstride),
+    (gint32 *) ((gint8 *) b + 3 * bstride)
+  };
+
+  for (j = 0; j < 4; j++)
+    sum[j] = _mm512_setzero_si512 ();
+
+  for (i = 0; i + 16 <= len; i += 16) {
+    t = LOAD512 (a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = madd_epi32 (sum[j], t, LOAD512 (c[j] + i));
+  }
+  if (i < len) {
+    __mmask16 m = (__mmask16) ((1U << (len - i)) - 1);
+
+    t = _mm512_maskz_loadu_epi32 (m, a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = madd_epi32 (sum[j], t, _mm512_maskz_loadu_epi32 (m, c[j] + i));
+  }
+
+  res = 0;
+  for (j = 0; j < 4; j++)
+    res += (gint64) (gint32) (_mm512_reduce_add_epi64 (sum[j]) >>
+        PRECISION_S32) * (gint64) icoeff[j];
+  res = (res + ((gint64) 1 << (PRECISION_S32 - 1))) >> PRECISION_S32;
+  *o = CLAMP (res, G_MININT32, G_MAXINT32);
+}
+
+static inline void
+inner_product_gfloat_full_1_avx512 (gfloat * o, const gfloat * a,
+    const gfloat * b, gint len, const gfloat * icoeff, gint bstride)
+{
+  gint i;
+  __m512 sum[2];
+
+  sum[0] = sum[1] = _mm512_setzero_ps ();
+
+  for (i = 0; i + 32 <= len; i += 32) {
+    sum[0] = _mm512_fmadd_ps (_mm512_loadu_ps (a + i),
+        _mm512_loadu_ps (b + i), sum[0]);
+    sum[1] = _mm512_fmadd_ps (_mm512_loadu_ps (a + i + 16),
+        _mm512_loadu_ps (b + i + 16), sum[1]);
+  }
+  for (; i + 16 <= len; i += 16)
+    sum[0] = _mm512_fmadd_ps (_mm512_loadu_ps (a + i),
+        _mm512_loadu_ps (b + i), sum[0]);
+  if (i < len) {
+    __mmask16 m = (__mmask16) ((1U << (len - i)) - 1);
+
+    sum[1] = _mm512_fmadd_ps (_mm512_maskz_loadu_ps (m, a + i),
+        _mm512_maskz_loadu_ps (m, b + i), sum[1]);
+  }
+
+  *o = _mm512_reduce_add_ps (_mm512_add_ps (sum[0], sum[1]));
+}
+
+static inline void
+inner_product_gfloat_linear_1_avx512 (gfloat * o, const gfloat * a,
+    const gfloat * b, gint len, const gfloat * icoeff, gint bstride)
+{
+  gint i;
+  gfloat res[2];
+  __m512 sum[2], t;
+  const gfloat *c[2] = { (gfloat *) ((gint8 *) b + 0 * bstride),
+    (gfloat *) ((gint8 *) b + 1 * bstride)
+  };
+
+  sum[0] = sum[1] = _mm512_setzero_ps ();
+
+  for (i = 0; i + 16 <= len; i += 16) {
+    t = _mm512_loadu_ps (a + i);
+    sum[0] = _mm512_fmadd_ps (t, _mm512_loadu_ps (c[0] + i), sum[0]);
+    sum[1] = _mm512_fmadd_ps (t, _mm512_loadu_ps (c[1] + i), sum[1]);
+  }
+  if (i < len) {
+    __mmask16 m = (__mmask16) ((1U << (len - i)) - 1);
+
+    t = _mm512_maskz_loadu_ps (m, a + i);
+    sum[0] = _mm512_fmadd_ps (t, _mm512_maskz_loadu_ps (m, c[0] + i), sum[0]);
+    sum[1] = _mm512_fmadd_ps (t, _mm512_maskz_loadu_ps (m, c[1] + i), sum[1]);
+  }
+  res[0] = _mm512_reduce_add_ps (sum[0]);
+  res[1] = _mm512_reduce_add_ps (sum[1]);
+
+  *o = (res[0] - res[1]) * icoeff[0] + res[1];
+}
+
+static inline void
+inner_product_gfloat_cubic_1_avx512 (gfloat * o, const gfloat * a,
+    const gfloat * b, gint len, const gfloat * icoeff, gint bstride)
+{
+  gint i, j;
+  gfloat res = 0.0;
+  __m512 sum[4], t;
+  const gfloat *c[4] = { (gfloat *) ((gint8 *) b + 0 * bstride),
+    (gfloat *) ((gint8 *) b + 1 * bstride),
+    (gfloat *) ((gint8 *) b + 2 * bstride),
+    (gfloat *) ((gint8 *) b + 3 * bstride)
+  };
+
+  for (j = 0; j < 4; j++)
+    sum[j] = _mm512_setzero_ps ();
+
+  for (i = 0; i + 16 <= len; i += 16) {
+    t = _mm512_loadu_ps (a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = _mm512_fmadd_ps (t, _mm512_loadu_ps (c[j] + i), sum[j]);
+  }
+  if (i < len) {
+    __mmask16 m = (__mmask16) ((1U << (len - i)) - 1);
+
+    t = _mm512_maskz_loadu_ps (m, a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = _mm512_fmadd_ps (t, _mm512_maskz_loadu_ps (m, c[j] + i),
+          sum[j]);
+  }
+
+  for (j = 0; j < 4; j++)
+    res += _mm512_reduce_add_ps (sum[j]) * icoeff[j];
+  *o = res;
+}
+
+static inline void
+inner_product_gdouble_full_1_avx512 (gdouble * o, const gdouble * a,
+    const gdouble * b, gint len, const gdouble * icoeff, gint bstride)
+{
+  gint i;
+  __m512d sum[2];
+
+  sum[0] = sum[1] = _mm512_setzero_pd ();
+
+  for (i = 0; i + 16 <= len; i += 16) {
+    sum[0] = _mm512_fmadd_pd (_mm512_loadu_pd (a + i),
+        _mm512_loadu_pd (b + i), sum[0]);
+    sum[1] = _mm512_fmadd_pd (_mm512_loadu_pd (a + i + 8),
+        _mm512_loadu_pd (b + i + 8), sum[1]);
+  }
+  for (; i + 8 <= len; i += 8)
+    sum[0] = _mm512_fmadd_pd (_mm512_loadu_pd (a + i),
+        _mm512_loadu_pd (b + i), sum[0]);
+  if (i < len) {
+    __mmask8 m = (__mmask8) ((1U << (len - i)) - 1);
+
+    sum[1] = _mm512_fmadd_pd (_mm512_maskz_loadu_pd (m, a + i),
+        _mm512_maskz_loadu_pd (m, b + i), sum[1]);
+  }
+
+  *o = _mm512_reduce_add_pd (_mm512_add_pd (sum[0], sum[1]));
+}
+
+static inline void
+inner_product_gdouble_linear_1_avx512 (gdouble * o, const gdouble * a,
+    const gdouble * b, gint len, const gdouble * icoeff, gint bstride)
+{
+  gint i;
+  gdouble res[2];
+  __m512d sum[2], t;
+  const gdouble *c[2] = { (gdouble *) ((gint8 *) b + 0 * bstride),
+    (gdouble *) ((gint8 *) b + 1 * bstride)
+  };
+
+  sum[0] = sum[1] = _mm512_setzero_pd ();
+
+  for (i = 0; i + 8 <= len; i += 8) {
+    t = _mm512_loadu_pd (a + i);
+    sum[0] = _mm512_fmadd_pd (t, _mm512_loadu_pd (c[0] + i), sum[0]);
+    sum[1] = _mm512_fmadd_pd (t, _mm512_loadu_pd (c[1] + i), sum[1]);
+  }
+  if (i < len) {
+    __mmask8 m = (__mmask8) ((1U << (len - i)) - 1);
+
+    t = _mm512_maskz_loadu_pd (m, a + i);
+    sum[0] = _mm512_fmadd_pd (t, _mm512_maskz_loadu_pd (m, c[0] + i), sum[0]);
+    sum[1] = _mm512_fmadd_pd (t, _mm512_maskz_loadu_pd (m, c[1] + i), sum[1]);
+  }
+  res[0] = _mm512_reduce_add_pd (sum[0]);
+  res[1] = _mm512_reduce_add_pd (sum[1]);
+
+  *o = (res[0] - res[1]) * icoeff[0] + res[1];
+}
+
+static inline void
+inner_product_gdouble_cubic_1_avx512 (gdouble * o, const gdouble * a,
+    const gdouble * b, gint len, const gdouble * icoeff, gint bstride)
+{
+  gint i, j;
+  gdouble res = 0.0;
+  __m512d sum[4], t;
+  const gdouble *c[4] = { (gdouble *) ((gint8 *) b + 0 * bstride),
+    (gdouble *) ((gint8 *) b + 1 * bstride),
+    (gdouble *) ((gint8 *) b + 2 * bstride),
+    (gdouble *) ((gint8 *) b + 3 * bstride)
+  };
+
+  for (j = 0; j < 4; j++)
+    sum[j] = _mm512_setzero_pd ();
+
+  for (i = 0; i + 8 <= len; i += 8) {
+    t = _mm512_loadu_pd (a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = _mm512_fmadd_pd (t, _mm512_loadu_pd (c[j] + i), sum[j]);
+  }
+  if (i < len) {
+    __mmask8 m = (__mmask8) ((1U << (len - i)) - 1);
+
+    t = _mm512_maskz_loadu_pd (m, a + i);
+    for (j = 0; j < 4; j++)
+      sum[j] = _mm512_fmadd_pd (t, _mm512_maskz_loadu_pd (m, c[j] + i),
+          sum[j]);
+  }
+
+  for (j = 0; j < 4; j++)
+    res += _mm512_reduce_add_pd (sum[j]) * icoeff[j];
+  *o = res;
+}
+
+MAKE_RESAMPLE_FUNC (gint16, full, 1, avx512);
+MAKE_RESAMPLE_FUNC (gint16, linear, 1, avx512);
+MAKE_RESAMPLE_FUNC (gint16, cubic, 1, avx512);
+
+MAKE_RESAMPLE_FUNC (gint32, full, 1, avx512);
+MAKE_RESAMPLE_FUNC (gint32, linear, 1, avx512);
+MAKE_RESAMPLE_FUNC (gint32, cubic, 1, avx512);
+
+MAKE_RESAMPLE_FUNC (gfloat, full, 1, avx512);
+MAKE_RESAMPLE_FUNC (gfloat, linear, 1, avx512);
+MAKE_RESAMPLE_FUNC (gfloat, cubic, 1, avx512);
+
+MAKE_RESAMPLE_FUNC (gdouble, full, 1, avx512);
+MAKE_RESAMPLE_FUNC (gdouble, linear, 1, avx512);
+MAKE_RESAMPLE_FUNC (gdouble, cubic, 1, avx512);
+
+#endif
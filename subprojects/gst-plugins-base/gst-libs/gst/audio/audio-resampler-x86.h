@@ -21,7 +21,10 @@
 #include "audio-resampler-x86-sse.h"
 #include "audio-resampler-x86-sse2.h"
 #include "audio-resampler-x86-sse41.h"
+#include "audio-resampler-x86-avx2.h"
+#include "audio-resampler-x86-avx512.h"
 
+#ifdef CHECK_X86
 static void
 audio_resampler_check_x86 (const gchar *option)
 {
@@ -69,3 +72,61 @@ audio_resampler_check_x86 (const gchar *option)
 #endif
   }
 }
+#endif
+
+#ifdef CHECK_X86_AVX
+/* Called after the orc flags were checked so that the AVX versions replace
+ * the SSE versions of the resample functions. The interpolate functions only
+ * fill the tap cache and are left alone. */
+static void
+audio_resampler_check_x86_avx (void)
+{
+  __builtin_cpu_init ();
+
+  if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma")) {
+#if defined (HAVE_IMMINTRIN_H) && HAVE_AVX2
+    GST_DEBUG ("enable AVX2 optimisations");
+    resample_gint16_full_1 = resample_gint16_full_1_avx2;
+    resample_gint16_linear_1 = resample_gint16_linear_1_avx2;
+    resample_gint16_cubic_1 = resample_gint16_cubic_1_avx2;
+
+    resample_gint32_full_1 = resample_gint32_full_1_avx2;
+    resample_gint32_linear_1 = resample_gint32_linear_1_avx2;
+    resample_gint32_cubic_1 = resample_gint32_cubic_1_avx2;
+
+    resample_gfloat_full_1 = resample_gfloat_full_1_avx2;
+    resample_gfloat_linear_1 = resample_gfloat_linear_1_avx2;
+    resample_gfloat_cubic_1 = resample_gfloat_cubic_1_avx2;
+
+    resample_gdouble_full_1 = resample_gdouble_full_1_avx2;
+    resample_gdouble_linear_1 = resample_gdouble_linear_1_avx2;
+    resample_gdouble_cubic_1 = resample_gdouble_cubic_1_avx2;
+#else
+    GST_DEBUG ("AVX2 optimisations not enabled");
+#endif
+  }
+
+  if (__builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512bw")) {
+#if defined (HAVE_IMMINTRIN_H) && HAVE_AVX512
+    GST_DEBUG ("enable AVX-512 optimisations");
+    resample_gint16_full_1 = resample_gint16_full_1_avx512;
+    resample_gint16_linear_1 = resample_gint16_linear_1_avx512;
+    resample_gint16_cubic_1 = resample_gint16_cubic_1_avx512;
+
+    resample_gint32_full_1 = resample_gint32_full_1_avx512;
+    resample_gint32_linear_1 = resample_gint32_linear_1_avx512;
+    resample_gint32_cubic_1 = resample_gint32_cubic_1_avx512;
+
+    resample_gfloat_full_1 = resample_gfloat_full_1_avx512;
+    resample_gfloat_linear_1 = resample_gfloat_linear_1_avx512;
+    resample_gfloat_cubic_1 = resample_gfloat_cubic_1_avx512;
+
+    resample_gdouble_full_1 = resample_gdouble_full_1_avx512;
+    resample_gdouble_linear_1 = resample_gdouble_linear_1_avx512;
+    resample_gdouble_cubic_1 = resample_gdouble_cubic_1_avx512;
+#else
+    GST_DEBUG ("AVX-512 optimisations not enabled");
+#endif
+  }
+}
+#endif
@@ -829,10 +829,19 @@ static ResampleFunc resample_funcs[] = {
 # endif
 # if defined (__i386__) || defined (__x86_64__)
 #  define CHECK_X86
-#  include "audio-resampler-x86.h"
 # endif
 #endif
 
+#if defined (HAVE_AVX2) || defined (HAVE_AVX512)
+# if defined (__i386__) || defined (__x86_64__)
+#  define CHECK_X86_AVX
+# endif
+#endif
+
+#if defined (CHECK_X86) || defined (CHECK_X86_AVX)
+# include "audio-resampler-x86.h"
+#endif
+
 static void
 audio_resampler_init (void)
 {
@@ -874,6 +883,9 @@ audio_resampler_init (void)
         }
       }
     }
+#endif
+#ifdef CHECK_X86_AVX
+    audio_resampler_check_x86_avx ();
 #endif
     g_once_init_leave (&init_gonce, 1);
   }
@@ -338,6 +338,7 @@ gst_audio_aggregator_convert_pad_convert_buffer (GstAudioAggregatorPad *
         insamples);
     gint outsize = outsamples * out_info->bpf;
     GstMapInfo inmap, outmap;
+    gint in_rate, out_rate;
 
     res = gst_buffer_new_allocate (NULL, outsize, NULL);
 
@@ -347,6 +348,17 @@ gst_audio_aggregator_convert_pad_convert_buffer (GstAudioAggregatorPad *
         GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS |
         GST_BUFFER_COPY_META, 0, -1);
 
+    /* The contents of GAP buffers are never mixed, only their size is used.
+     * Without resampling the converter has no history that needs to see
+     * the samples, so don't touch the memory at all */
+    gst_audio_converter_get_config (aaggcpad->priv->converter, &in_rate,
+        &out_rate);
+    if (GST_BUFFER_FLAG_IS_SET (input_buffer, GST_BUFFER_FLAG_GAP)
+        && in_rate == out_rate) {
+      GST_LOG_OBJECT (aaggpad, "Not converting GAP buffer");
+      return res;
+    }
+
     gst_buffer_map (input_buffer, &inmap, GST_MAP_READ);
     gst_buffer_map (res, &outmap, GST_MAP_WRITE);
 
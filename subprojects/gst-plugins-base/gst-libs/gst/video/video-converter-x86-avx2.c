@@ -0,0 +1,237 @@
+/* GStreamer
+ *
+ * video-converter-x86-avx2.c: AVX2 line kernels for the video converter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "video-converter-x86-avx2.h"
+
+#if defined (HAVE_IMMINTRIN_H) && defined (__AVX2__)
+
+#include <immintrin.h>
+
+#define SHUF(a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p) \
+  _mm256_setr_epi8 (a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p, \
+      a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p)
+
+gint
+video_converter_shift_right_u16_avx2 (guint16 * d, const guint16 * s,
+    guint shift, gint n)
+{
+  __m128i count = _mm_cvtsi32_si128 (shift);
+  gint i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    __m256i t = _mm256_loadu_si256 ((const __m256i *) (s + i));
+
+    _mm256_storeu_si256 ((__m256i *) (d + i), _mm256_srl_epi16 (t, count));
+  }
+  return i;
+}
+
+gint
+video_converter_shift_left_u16_avx2 (guint16 * d, const guint16 * s,
+    guint shift, gint n)
+{
+  __m128i count = _mm_cvtsi32_si128 (shift);
+  gint i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    __m256i t = _mm256_loadu_si256 ((const __m256i *) (s + i));
+
+    _mm256_storeu_si256 ((__m256i *) (d + i), _mm256_sll_epi16 (t, count));
+  }
+  return i;
+}
+
+/* splits @n interleaved sample pairs from @s into @du and @dv */
+gint
+video_converter_deinterleave_u16_avx2 (guint16 * du, guint16 * dv,
+    const guint16 * s, guint shift, gint n)
+{
+  __m128i count = _mm_cvtsi32_si128 (shift);
+  __m256i mask = _mm256_set1_epi32 (0xffff);
+  gint i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    __m256i a, b, u, v;
+
+    a = _mm256_loadu_si256 ((const __m256i *) (s + 2 * i));
+    b = _mm256_loadu_si256 ((const __m256i *) (s + 2 * i + 16));
+    a = _mm256_srl_epi16 (a, count);
+    b = _mm256_srl_epi16 (b, count);
+
+    /* packus works per 128 bit lane, fix up the order of the 64 bit
+     * quarters afterwards */
+    u = _mm256_packus_epi32 (_mm256_and_si256 (a, mask),
+        _mm256_and_si256 (b, mask));
+    v = _mm256_packus_epi32 (_mm256_srli_epi32 (a, 16),
+        _mm256_srli_epi32 (b, 16));
+
+    _mm256_storeu_si256 ((__m256i *) (du + i),
+        _mm256_permute4x64_epi64 (u, _MM_SHUFFLE (3, 1, 2, 0)));
+    _mm256_storeu_si256 ((__m256i *) (dv + i),
+        _mm256_permute4x64_epi64 (v, _MM_SHUFFLE (3, 1, 2, 0)));
+  }
+  return i;
+}
+
+/* merges @n samples from @su and @sv into sample pairs in @d */
+gint
+video_converter_interleave_u16_avx2 (guint16 * d, const guint16 * su,
+    const guint16 * sv, guint shift, gint n)
+{
+  __m128i count = _mm_cvtsi32_si128 (shift);
+  gint i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    __m256i u, v, lo, hi;
+
+    u = _mm256_loadu_si256 ((const __m256i *) (su + i));
+    v = _mm256_loadu_si256 ((const __m256i *) (sv + i));
+    u = _mm256_sll_epi16 (u, count);
+    v = _mm256_sll_epi16 (v, count);
+
+    lo = _mm256_unpacklo_epi16 (u, v);
+    hi = _mm256_unpackhi_epi16 (u, v);
+
+    _mm256_storeu_si256 ((__m256i *) (d + 2 * i),
+        _mm256_permute2x128_si256 (lo, hi, 0x20));
+    _mm256_storeu_si256 ((__m256i *) (d + 2 * i + 16),
+        _mm256_permute2x128_si256 (lo, hi, 0x31));
+  }
+  return i;
+}
+
+static inline __m256i
+load_2x128 (const guint16 * lo, const guint16 * hi)
+{
+  return _mm256_inserti128_si256 (_mm256_castsi128_si256 (_mm_loadu_si128
+          ((const __m128i *) lo)), _mm_loadu_si128 ((const __m128i *) hi), 1);
+}
+
+/* packs 4:2:2 planar 10 bit samples into v210, two groups of 6 pixels per
+ * iteration, one in each 128 bit lane */
+gint
+video_converter_pack_v210_avx2 (guint8 * d, const guint16 * sy,
+    const guint16 * su, const guint16 * sv, gint width)
+{
+  const __m256i mask = _mm256_set1_epi16 (0x3ff);
+  const __m256i y_0 = SHUF (-1, -1, -1, -1, 2, 3, -1, -1,
+      -1, -1, -1, -1, 8, 9, -1, -1);
+  const __m256i u_0 = SHUF (0, 1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i v_0 = SHUF (-1, -1, -1, -1, -1, -1, -1, -1,
+      2, 3, -1, -1, -1, -1, -1, -1);
+  const __m256i y_1 = SHUF (0, 1, -1, -1, -1, -1, -1, -1,
+      6, 7, -1, -1, -1, -1, -1, -1);
+  const __m256i u_1 = SHUF (-1, -1, -1, -1, 2, 3, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i v_1 = SHUF (-1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, 4, 5, -1, -1);
+  const __m256i y_2 = SHUF (-1, -1, -1, -1, 4, 5, -1, -1,
+      -1, -1, -1, -1, 10, 11, -1, -1);
+  const __m256i u_2 = SHUF (-1, -1, -1, -1, -1, -1, -1, -1,
+      4, 5, -1, -1, -1, -1, -1, -1);
+  const __m256i v_2 = SHUF (0, 1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1);
+  gint i;
+
+  /* the loads read 8 samples, stay away from the end of the lines */
+  for (i = 0; i + 24 <= width; i += 12) {
+    __m256i y, u, v, f0, f1, f2;
+
+    y = _mm256_and_si256 (load_2x128 (sy + i, sy + i + 6), mask);
+    u = _mm256_and_si256 (load_2x128 (su + i / 2, su + i / 2 + 3), mask);
+    v = _mm256_and_si256 (load_2x128 (sv + i / 2, sv + i / 2 + 3), mask);
+
+    /* f0 = u0 y1 v1 y4, f1 = y0 u1 y3 v2, f2 = v0 y2 u2 y5 */
+    f0 = _mm256_or_si256 (_mm256_shuffle_epi8 (y, y_0),
+        _mm256_or_si256 (_mm256_shuffle_epi8 (u, u_0),
+            _mm256_shuffle_epi8 (v, v_0)));
+    f1 = _mm256_or_si256 (_mm256_shuffle_epi8 (y, y_1),
+        _mm256_or_si256 (_mm256_shuffle_epi8 (u, u_1),
+            _mm256_shuffle_epi8 (v, v_1)));
+    f2 = _mm256_or_si256 (_mm256_shuffle_epi8 (y, y_2),
+        _mm256_or_si256 (_mm256_shuffle_epi8 (u, u_2),
+            _mm256_shuffle_epi8 (v, v_2)));
+
+    f0 = _mm256_or_si256 (f0, _mm256_slli_epi32 (f1, 10));
+    f0 = _mm256_or_si256 (f0, _mm256_slli_epi32 (f2, 20));
+
+    _mm256_storeu_si256 ((__m256i *) (d + (i / 6) * 16), f0);
+  }
+  return i;
+}
+
+/* unpacks v210 into 4:2:2 planar 10 bit samples, two groups of 6 pixels per
+ * iteration, one in each 128 bit lane */
+gint
+video_converter_unpack_v210_avx2 (guint16 * dy, guint16 * du, guint16 * dv,
+    const guint8 * s, gint width)
+{
+  const __m256i mask = _mm256_set1_epi32 (0x3ff);
+  const __m256i y_t = SHUF (2, 3, 4, 5, -1, -1, 10, 11,
+      12, 13, -1, -1, -1, -1, -1, -1);
+  const __m256i y_f2 = SHUF (-1, -1, -1, -1, 4, 5, -1, -1,
+      -1, -1, 12, 13, -1, -1, -1, -1);
+  const __m256i uv_t = SHUF (0, 1, 6, 7, -1, -1, -1, -1,
+      -1, -1, 8, 9, 14, 15, -1, -1);
+  const __m256i uv_f2 = SHUF (-1, -1, -1, -1, 8, 9, -1, -1,
+      0, 1, -1, -1, -1, -1, -1, -1);
+  gint i;
+
+  /* the stores write 8 luma and 4 chroma samples per group, stay away from
+   * the end of the lines */
+  for (i = 0; i + 14 <= width; i += 12) {
+    __m256i a, t, f2, y, uv;
+    __m128i lo, hi;
+
+    a = _mm256_loadu_si256 ((const __m256i *) (s + (i / 6) * 16));
+
+    /* t has the first and second component of each word as 16 bit values,
+     * f2 the third one in the low half of each 32 bit value */
+    t = _mm256_or_si256 (_mm256_and_si256 (a, mask),
+        _mm256_slli_epi32 (_mm256_and_si256 (_mm256_srli_epi32 (a, 10),
+                mask), 16));
+    f2 = _mm256_and_si256 (_mm256_srli_epi32 (a, 20), mask);
+
+    y = _mm256_or_si256 (_mm256_shuffle_epi8 (t, y_t),
+        _mm256_shuffle_epi8 (f2, y_f2));
+    uv = _mm256_or_si256 (_mm256_shuffle_epi8 (t, uv_t),
+        _mm256_shuffle_epi8 (f2, uv_f2));
+
+    lo = _mm256_castsi256_si128 (y);
+    hi = _mm256_extracti128_si256 (y, 1);
+    _mm_storeu_si128 ((__m128i *) (dy + i), lo);
+    _mm_storeu_si128 ((__m128i *) (dy + i + 6), hi);
+
+    lo = _mm256_castsi256_si128 (uv);
+    hi = _mm256_extracti128_si256 (uv, 1);
+    _mm_storel_epi64 ((__m128i *) (du + i / 2), lo);
+    _mm_storel_epi64 ((__m128i *) (du + i / 2 + 3), hi);
+    _mm_storel_epi64 ((__m128i *) (dv + i / 2), _mm_srli_si128 (lo, 8));
+    _mm_storel_epi64 ((__m128i *) (dv + i / 2 + 3), _mm_srli_si128 (hi, 8));
+  }
+  return i;
+}
+
+#endif
@@ -0,0 +1,48 @@
+/* GStreamer
+ *
+ * video-converter-x86-avx2.h: AVX2 line kernels for the video converter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef VIDEO_CONVERTER_X86_AVX2_H
+#define VIDEO_CONVERTER_X86_AVX2_H
+
+#include <glib.h>
+
+/* All functions return the number of samples (or pixels for v210) they
+ * handled, the caller converts the remaining ones */
+
+G_GNUC_INTERNAL
+gint video_converter_shift_right_u16_avx2 (guint16 * d, const guint16 * s,
+    guint shift, gint n);
+G_GNUC_INTERNAL
+gint video_converter_shift_left_u16_avx2 (guint16 * d, const guint16 * s,
+    guint shift, gint n);
+G_GNUC_INTERNAL
+gint video_converter_deinterleave_u16_avx2 (guint16 * du, guint16 * dv,
+    const guint16 * s, guint shift, gint n);
+G_GNUC_INTERNAL
+gint video_converter_interleave_u16_avx2 (guint16 * d, const guint16 * su,
+    const guint16 * sv, guint shift, gint n);
+G_GNUC_INTERNAL
+gint video_converter_pack_v210_avx2 (guint8 * d, const guint16 * sy,
+    const guint16 * su, const guint16 * sv, gint width);
+G_GNUC_INTERNAL
+gint video_converter_unpack_v210_avx2 (guint16 * dy, guint16 * du,
+    guint16 * dv, const guint8 * s, gint width);
+
+#endif /* VIDEO_CONVERTER_X86_AVX2_H */
@@ -0,0 +1,127 @@
+/* GStreamer
+ *
+ * video-converter-x86-avx512.c: AVX-512 line kernels for the video converter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "video-converter-x86-avx512.h"
+
+#if defined (HAVE_IMMINTRIN_H) && defined (__AVX512F__) && defined (__AVX512BW__)
+
+#include <immintrin.h>
+
+/* permutation indices, values >= 32 select from the second source */
+static const guint16 interleave_lo[32] = {
+  0, 32, 1, 33, 2, 34, 3, 35, 4, 36, 5, 37, 6, 38, 7, 39,
+  8, 40, 9, 41, 10, 42, 11, 43, 12, 44, 13, 45, 14, 46, 15, 47
+};
+
+static const guint16 interleave_hi[32] = {
+  16, 48, 17, 49, 18, 50, 19, 51, 20, 52, 21, 53, 22, 54, 23, 55,
+  24, 56, 25, 57, 26, 58, 27, 59, 28, 60, 29, 61, 30, 62, 31, 63
+};
+
+static const guint16 deinterleave_even[32] = {
+  0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30,
+  32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62
+};
+
+static const guint16 deinterleave_odd[32] = {
+  1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31,
+  33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59, 61, 63
+};
+
+gint
+video_converter_shift_right_u16_avx512 (guint16 * d, const guint16 * s,
+    guint shift, gint n)
+{
+  __m128i count = _mm_cvtsi32_si128 (shift);
+  gint i;
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    __m512i t = _mm512_loadu_si512 (s + i);
+
+    _mm512_storeu_si512 (d + i, _mm512_srl_epi16 (t, count));
+  }
+  return i;
+}
+
+gint
+video_converter_shift_left_u16_avx512 (guint16 * d, const guint16 * s,
+    guint shift, gint n)
+{
+  __m128i count = _mm_cvtsi32_si128 (shift);
+  gint i;
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    __m512i t = _mm512_loadu_si512 (s + i);
+
+    _mm512_storeu_si512 (d + i, _mm512_sll_epi16 (t, count));
+  }
+  return i;
+}
+
+/* splits @n interleaved sample pairs from @s into @du and @dv */
+gint
+video_converter_deinterleave_u16_avx512 (guint16 * du, guint16 * dv,
+    const guint16 * s, guint shift, gint n)
+{
+  __m128i count = _mm_cvtsi32_si128 (shift);
+  __m512i even = _mm512_loadu_si512 (deinterleave_even);
+  __m512i odd = _mm512_loadu_si512 (deinterleave_odd);
+  gint i;
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    __m512i a, b;
+
+    a = _mm512_srl_epi16 (_mm512_loadu_si512 (s + 2 * i), count);
+    b = _mm512_srl_epi16 (_mm512_loadu_si512 (s + 2 * i + 32), count);
+
+    _mm512_storeu_si512 (du + i, _mm512_permutex2var_epi16 (a, even, b));
+    _mm512_storeu_si512 (dv + i, _mm512_permutex2var_epi16 (a, odd, b));
+  }
+  return i;
+}
+
+/* merges @n samples from @su and @sv into sample pairs in @d */
+gint
+video_converter_interleave_u16_avx512 (guint16 * d, const guint16 * su,
+    const guint16 * sv, guint shift, gint n)
+{
+  __m128i count = _mm_cvtsi32_si128 (shift);
+  __m512i lo = _mm512_loadu_si512 (interleave_lo);
+  __m512i hi = _mm512_loadu_si512 (interleave_hi);
+  gint i;
+
+  for (i = 0; i + 32 <= n; i += 32) {
+    __m512i u, v;
+
+    u = _mm512_sll_epi16 (_mm512_loadu_si512 (su + i), count);
+    v = _mm512_sll_epi16 (_mm512_loadu_si512 (sv + i), count);
+
+    _mm512_storeu_si512 (d + 2 * i, _mm512_permutex2var_epi16 (u, lo, v));
+    _mm512_storeu_si512 (d + 2 * i + 32,
+        _mm512_permutex2var_epi16 (u, hi, v));
+  }
+  return i;
+}
+
+#endif
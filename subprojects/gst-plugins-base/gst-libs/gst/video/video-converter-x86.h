@@ -0,0 +1,54 @@
+/* GStreamer
+ *
+ * video-converter-x86.h: runtime selection of the x86 line kernels
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "video-converter-x86-avx2.h"
+#include "video-converter-x86-avx512.h"
+
+static void
+video_converter_check_x86 (void)
+{
+  __builtin_cpu_init ();
+
+  if (__builtin_cpu_supports ("avx2")) {
+#if defined (HAVE_IMMINTRIN_H) && HAVE_AVX2
+    GST_DEBUG ("enable AVX2 optimisations");
+    shift_right_u16_simd = video_converter_shift_right_u16_avx2;
+    shift_left_u16_simd = video_converter_shift_left_u16_avx2;
+    deinterleave_u16_simd = video_converter_deinterleave_u16_avx2;
+    interleave_u16_simd = video_converter_interleave_u16_avx2;
+    pack_v210_simd = video_converter_pack_v210_avx2;
+    unpack_v210_simd = video_converter_unpack_v210_avx2;
+#else
+    GST_DEBUG ("AVX2 optimisations not enabled");
+#endif
+  }
+
+  if (__builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512bw")) {
+#if defined (HAVE_IMMINTRIN_H) && HAVE_AVX512
+    GST_DEBUG ("enable AVX-512 optimisations");
+    shift_right_u16_simd = video_converter_shift_right_u16_avx512;
+    shift_left_u16_simd = video_converter_shift_left_u16_avx512;
+    deinterleave_u16_simd = video_converter_deinterleave_u16_avx512;
+    interleave_u16_simd = video_converter_interleave_u16_avx512;
+#else
+    GST_DEBUG ("AVX-512 optimisations not enabled");
+#endif
+  }
+}
@@ -474,6 +474,13 @@ struct _GstVideoConverter
   {
     GstVideoScaler **scaler;
   } fv_scaler[4];
+  struct
+  {
+    guint8 **lines;
+    gint in_width;
+    gint pstride;
+    gint width;
+  } ftile[4];
   FastConvertFunc fconvert[4];
 
   /* for parallel async running */
@@ -793,6 +800,7 @@ get_opt_enum (GstVideoConverter * convert, const gchar * opt, GType type,
 #define DEFAULT_OPT_DITHER_METHOD GST_VIDEO_DITHER_BAYER
 #define DEFAULT_OPT_DITHER_QUANTIZATION 1
 #define DEFAULT_OPT_ASYNC_TASKS FALSE
+#define DEFAULT_OPT_TILE_CACHE_SIZE (256 * 1024)
 
 #define GET_OPT_FILL_BORDER(c) get_opt_bool(c, \
     GST_VIDEO_CONVERTER_OPT_FILL_BORDER, DEFAULT_OPT_FILL_BORDER)
@@ -825,6 +833,8 @@ get_opt_enum (GstVideoConverter * convert, const gchar * opt, GType type,
     GST_VIDEO_CONVERTER_OPT_DITHER_QUANTIZATION, DEFAULT_OPT_DITHER_QUANTIZATION)
 #define GET_OPT_ASYNC_TASKS(c) get_opt_bool(c, \
     GST_VIDEO_CONVERTER_OPT_ASYNC_TASKS, DEFAULT_OPT_ASYNC_TASKS)
+#define GET_OPT_TILE_CACHE_SIZE(c) get_opt_uint(c, \
+    GST_VIDEO_CONVERTER_OPT_TILE_CACHE_SIZE, DEFAULT_OPT_TILE_CACHE_SIZE)
 
 #define CHECK_ALPHA_COPY(c) (GET_OPT_ALPHA_MODE(c) == GST_VIDEO_ALPHA_MODE_COPY)
 #define CHECK_ALPHA_SET(c) (GET_OPT_ALPHA_MODE(c) == GST_VIDEO_ALPHA_MODE_SET)
@@ -2456,6 +2466,8 @@ gst_video_converter_new_with_pool (const GstVideoInfo * in_info,
   convert->conversion_runner =
       gst_parallelized_task_runner_new (n_threads, pool, async_tasks);
 
+  video_converter_init_simd ();
+
   if (video_converter_lookup_fastpath (convert))
     goto done;
 
@@ -2667,6 +2679,12 @@ gst_video_converter_free (GstVideoConverter * convert)
     }
     g_free (convert->fv_scaler[i].scaler);
     g_free (convert->fh_scaler[i].scaler);
+
+    if (convert->ftile[i].lines) {
+      for (j = 0; j < convert->conversion_runner->n_threads; j++)
+        g_free (convert->ftile[i].lines[j]);
+      g_free (convert->ftile[i].lines);
+    }
   }
 
   if (convert->conversion_runner)
@@ -4024,6 +4042,375 @@ convert_v210_I420 (GstVideoConverter * convert, const GstVideoFrame * src,
   }
 }
 
+/* High bit depth line kernels. The SIMD versions are selected at runtime and
+ * return how many samples they converted, the C code does the rest. */
+typedef gint (*ShiftLineFunc) (guint16 * d, const guint16 * s, guint shift,
+    gint n);
+typedef gint (*DeinterleaveLineFunc) (guint16 * du, guint16 * dv,
+    const guint16 * s, guint shift, gint n);
+typedef gint (*InterleaveLineFunc) (guint16 * d, const guint16 * su,
+    const guint16 * sv, guint shift, gint n);
+typedef gint (*PackV210LineFunc) (guint8 * d, const guint16 * sy,
+    const guint16 * su, const guint16 * sv, gint width);
+typedef gint (*UnpackV210LineFunc) (guint16 * dy, guint16 * du, guint16 * dv,
+    const guint8 * s, gint width);
+
+static gint
+shift_u16_none (guint16 * d, const guint16 * s, guint shift, gint n)
+{
+  return 0;
+}
+
+static gint
+deinterleave_u16_none (guint16 * du, guint16 * dv, const guint16 * s,
+    guint shift, gint n)
+{
+  return 0;
+}
+
+static gint
+interleave_u16_none (guint16 * d, const guint16 * su, const guint16 * sv,
+    guint shift, gint n)
+{
+  return 0;
+}
+
+static gint
+pack_v210_none (guint8 * d, const guint16 * sy, const guint16 * su,
+    const guint16 * sv, gint width)
+{
+  return 0;
+}
+
+static gint
+unpack_v210_none (guint16 * dy, guint16 * du, guint16 * dv, const guint8 * s,
+    gint width)
+{
+  return 0;
+}
+
+static ShiftLineFunc shift_right_u16_simd = shift_u16_none;
+static ShiftLineFunc shift_left_u16_simd = shift_u16_none;
+static DeinterleaveLineFunc deinterleave_u16_simd = deinterleave_u16_none;
+static InterleaveLineFunc interleave_u16_simd = interleave_u16_none;
+static PackV210LineFunc pack_v210_simd = pack_v210_none;
+static UnpackV210LineFunc unpack_v210_simd = unpack_v210_none;
+
+#if defined (HAVE_AVX2) || defined (HAVE_AVX512)
+# if defined (__i386__) || defined (__x86_64__)
+#  define CHECK_X86
+#  include "video-converter-x86.h"
+# endif
+#endif
+
+static void
+video_converter_init_simd (void)
+{
+  static gsize init_gonce = 0;
+
+  if (g_once_init_enter (&init_gonce)) {
+#ifdef CHECK_X86
+    video_converter_check_x86 ();
+#endif
+    g_once_init_leave (&init_gonce, 1);
+  }
+}
+
+static void
+shift_right_u16 (guint16 * d, const guint16 * s, guint shift, gint n)
+{
+  gint i;
+
+  for (i = shift_right_u16_simd (d, s, shift, n); i < n; i++)
+    d[i] = s[i] >> shift;
+}
+
+static void
+shift_left_u16 (guint16 * d, const guint16 * s, guint shift, gint n)
+{
+  gint i;
+
+  for (i = shift_left_u16_simd (d, s, shift, n); i < n; i++)
+    d[i] = s[i] << shift;
+}
+
+static void
+deinterleave_u16 (guint16 * du, guint16 * dv, const guint16 * s, guint shift,
+    gint n)
+{
+  gint i;
+
+  for (i = deinterleave_u16_simd (du, dv, s, shift, n); i < n; i++) {
+    du[i] = s[2 * i] >> shift;
+    dv[i] = s[2 * i + 1] >> shift;
+  }
+}
+
+static void
+interleave_u16 (guint16 * d, const guint16 * su, const guint16 * sv,
+    guint shift, gint n)
+{
+  gint i;
+
+  for (i = interleave_u16_simd (d, su, sv, shift, n); i < n; i++) {
+    d[2 * i] = su[i] << shift;
+    d[2 * i + 1] = sv[i] << shift;
+  }
+}
+
+/* same as pack_v210() with the I422_10LE unpacking folded in, including the
+ * handling of the last incomplete group */
+static void
+pack_v210_line (guint8 * d, const guint16 * sy, const guint16 * su,
+    const guint16 * sv, gint width)
+{
+  gint i;
+  guint32 a0, a1, a2, a3;
+  guint16 y0, y1, y2, y3, y4, y5;
+  guint16 u0, u1, u2;
+  guint16 v0, v1, v2;
+
+  for (i = pack_v210_simd (d, sy, su, sv, width); i < width; i += 6) {
+    y1 = y2 = y3 = y4 = y5 = 0;
+    u1 = u2 = v1 = v2 = 0;
+
+    y0 = sy[i] & 0x3ff;
+    u0 = su[i / 2] & 0x3ff;
+    v0 = sv[i / 2] & 0x3ff;
+
+    if (i < width - 1) {
+      y1 = sy[i + 1] & 0x3ff;
+    }
+    if (i < width - 2) {
+      y2 = sy[i + 2] & 0x3ff;
+      u1 = su[i / 2 + 1] & 0x3ff;
+      v1 = sv[i / 2 + 1] & 0x3ff;
+    }
+    if (i < width - 3) {
+      y3 = sy[i + 3] & 0x3ff;
+    }
+    if (i < width - 4) {
+      y4 = sy[i + 4] & 0x3ff;
+      u2 = su[i / 2 + 2] & 0x3ff;
+      v2 = sv[i / 2 + 2] & 0x3ff;
+    }
+    if (i < width - 5) {
+      y5 = sy[i + 5] & 0x3ff;
+    }
+
+    a0 = u0 | (y0 << 10) | (v0 << 20);
+    a1 = y1 | (u1 << 10) | (y2 << 20);
+    a2 = v1 | (y3 << 10) | (u2 << 20);
+    a3 = y4 | (v2 << 10) | (y5 << 20);
+
+    GST_WRITE_UINT32_LE (d + (i / 6) * 16 + 0, a0);
+    GST_WRITE_UINT32_LE (d + (i / 6) * 16 + 4, a1);
+    GST_WRITE_UINT32_LE (d + (i / 6) * 16 + 8, a2);
+    GST_WRITE_UINT32_LE (d + (i / 6) * 16 + 12, a3);
+  }
+}
+
+static void
+unpack_v210_line (guint16 * dy, guint16 * du, guint16 * dv, const guint8 * s,
+    gint width)
+{
+  gint i;
+  guint32 a0, a1, a2, a3;
+
+  for (i = unpack_v210_simd (dy, du, dv, s, width); i < width; i += 6) {
+    a0 = GST_READ_UINT32_LE (s + (i / 6) * 16 + 0);
+    a1 = GST_READ_UINT32_LE (s + (i / 6) * 16 + 4);
+    a2 = GST_READ_UINT32_LE (s + (i / 6) * 16 + 8);
+    a3 = GST_READ_UINT32_LE (s + (i / 6) * 16 + 12);
+
+    dy[i] = (a0 >> 10) & 0x3ff;
+    du[i / 2] = a0 & 0x3ff;
+    dv[i / 2] = (a0 >> 20) & 0x3ff;
+
+    if (i < width - 1) {
+      dy[i + 1] = a1 & 0x3ff;
+    }
+    if (i < width - 2) {
+      dy[i + 2] = (a1 >> 20) & 0x3ff;
+      du[i / 2 + 1] = (a1 >> 10) & 0x3ff;
+      dv[i / 2 + 1] = a2 & 0x3ff;
+    }
+    if (i < width - 3) {
+      dy[i + 3] = (a2 >> 10) & 0x3ff;
+    }
+    if (i < width - 4) {
+      dy[i + 4] = a3 & 0x3ff;
+      du[i / 2 + 2] = (a2 >> 20) & 0x3ff;
+      dv[i / 2 + 2] = (a3 >> 10) & 0x3ff;
+    }
+    if (i < width - 5) {
+      dy[i + 5] = (a3 >> 20) & 0x3ff;
+    }
+  }
+}
+
+typedef struct
+{
+  const GstVideoFrame *src;
+  GstVideoFrame *dest;
+  gint height_0, height_1;
+  gint chroma_height_0, chroma_height_1;
+
+  /* parameters */
+  gint width, chroma_width;
+  guint shift;
+} FConvertHighBitTask;
+
+typedef void (*FConvertHighBitTaskFunc) (FConvertHighBitTask * task);
+
+static void
+convert_P01x_I420_1x_task (FConvertHighBitTask * task)
+{
+  gint i;
+
+  for (i = task->height_0; i < task->height_1; i++) {
+    shift_right_u16 (FRAME_GET_Y_LINE (task->dest, i),
+        FRAME_GET_PLANE_LINE (task->src, 0, i), task->shift, task->width);
+  }
+  for (i = task->chroma_height_0; i < task->chroma_height_1; i++) {
+    deinterleave_u16 (FRAME_GET_U_LINE (task->dest, i),
+        FRAME_GET_V_LINE (task->dest, i),
+        FRAME_GET_PLANE_LINE (task->src, 1, i), task->shift,
+        task->chroma_width);
+  }
+}
+
+static void
+convert_I420_1x_P01x_task (FConvertHighBitTask * task)
+{
+  gint i;
+
+  for (i = task->height_0; i < task->height_1; i++) {
+    shift_left_u16 (FRAME_GET_PLANE_LINE (task->dest, 0, i),
+        FRAME_GET_Y_LINE (task->src, i), task->shift, task->width);
+  }
+  for (i = task->chroma_height_0; i < task->chroma_height_1; i++) {
+    interleave_u16 (FRAME_GET_PLANE_LINE (task->dest, 1, i),
+        FRAME_GET_U_LINE (task->src, i), FRAME_GET_V_LINE (task->src, i),
+        task->shift, task->chroma_width);
+  }
+}
+
+static void
+convert_I422_10LE_v210_task (FConvertHighBitTask * task)
+{
+  gint i;
+
+  for (i = task->height_0; i < task->height_1; i++) {
+    pack_v210_line (FRAME_GET_LINE (task->dest, i),
+        FRAME_GET_Y_LINE (task->src, i), FRAME_GET_U_LINE (task->src, i),
+        FRAME_GET_V_LINE (task->src, i), task->width);
+  }
+}
+
+static void
+convert_v210_I422_10LE_task (FConvertHighBitTask * task)
+{
+  gint i;
+
+  for (i = task->height_0; i < task->height_1; i++) {
+    unpack_v210_line (FRAME_GET_Y_LINE (task->dest, i),
+        FRAME_GET_U_LINE (task->dest, i), FRAME_GET_V_LINE (task->dest, i),
+        FRAME_GET_LINE (task->src, i), task->width);
+  }
+}
+
+/* The conversions between the high bit depth formats below only move and
+ * shift samples. All planes are converted line by line, so interlacing
+ * does not matter, and the result is the same as the generic path without
+ * dithering. */
+static void
+convert_high_bit_depth (GstVideoConverter * convert, const GstVideoFrame * src,
+    GstVideoFrame * dest, FConvertHighBitTaskFunc func, guint shift)
+{
+  const GstVideoFormatInfo *finfo = src->info.finfo;
+  gint width = convert->in_width;
+  gint height = convert->in_height;
+  gint chroma_width, chroma_height;
+  FConvertHighBitTask *tasks;
+  FConvertHighBitTask **tasks_p;
+  gint i, n_threads, lines_per_thread;
+
+  chroma_width = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (finfo, 1, width);
+  chroma_height = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, 1, height);
+
+  n_threads = convert->conversion_runner->n_threads;
+  tasks = convert->tasks[0] =
+      g_renew (FConvertHighBitTask, convert->tasks[0], n_threads);
+  tasks_p = convert->tasks_p[0] =
+      g_renew (FConvertHighBitTask *, convert->tasks_p[0], n_threads);
+
+  lines_per_thread = GST_ROUND_UP_2 ((height + n_threads - 1) / n_threads);
+
+  for (i = 0; i < n_threads; i++) {
+    tasks[i].src = src;
+    tasks[i].dest = dest;
+
+    tasks[i].width = width;
+    tasks[i].chroma_width = chroma_width;
+    tasks[i].shift = shift;
+
+    tasks[i].height_0 = MIN (height, i * lines_per_thread);
+    tasks[i].height_1 = MIN (height, tasks[i].height_0 + lines_per_thread);
+    tasks[i].chroma_height_0 =
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, 1, tasks[i].height_0);
+    tasks[i].chroma_height_1 = MIN (chroma_height,
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, 1, tasks[i].height_1));
+
+    tasks_p[i] = &tasks[i];
+  }
+
+  gst_parallelized_task_runner_run (convert->conversion_runner,
+      (GstParallelizedTaskFunc) func, (gpointer) tasks_p);
+}
+
+static void
+convert_P010_I420_10LE (GstVideoConverter * convert, const GstVideoFrame * src,
+    GstVideoFrame * dest)
+{
+  convert_high_bit_depth (convert, src, dest, convert_P01x_I420_1x_task, 6);
+}
+
+static void
+convert_P012_I420_12LE (GstVideoConverter * convert, const GstVideoFrame * src,
+    GstVideoFrame * dest)
+{
+  convert_high_bit_depth (convert, src, dest, convert_P01x_I420_1x_task, 4);
+}
+
+static void
+convert_I420_10LE_P010 (GstVideoConverter * convert, const GstVideoFrame * src,
+    GstVideoFrame * dest)
+{
+  convert_high_bit_depth (convert, src, dest, convert_I420_1x_P01x_task, 6);
+}
+
+static void
+convert_I420_12LE_P012 (GstVideoConverter * convert, const GstVideoFrame * src,
+    GstVideoFrame * dest)
+{
+  convert_high_bit_depth (convert, src, dest, convert_I420_1x_P01x_task, 4);
+}
+
+static void
+convert_I422_10LE_v210 (GstVideoConverter * convert, const GstVideoFrame * src,
+    GstVideoFrame * dest)
+{
+  convert_high_bit_depth (convert, src, dest, convert_I422_10LE_v210_task, 0);
+}
+
+static void
+convert_v210_I422_10LE (GstVideoConverter * convert, const GstVideoFrame * src,
+    GstVideoFrame * dest)
+{
+  convert_high_bit_depth (convert, src, dest, convert_v210_I422_10LE_task, 0);
+}
+
 typedef struct
 {
   const guint8 *s, *s2, *su, *sv;
@@ -7138,11 +7525,67 @@ typedef struct
   guint8 *d;
   gint sstride, dstride;
   guint x, y, w, h;
+  /* for scaling in tiles */
+  guint8 *tmp;
+  gint in_width, pstride, tile_width;
 } FScaleTask;
 
+/* output lines per tile */
+#define TILE_LINES 16
+
+static void
+convert_plane_hv_tiled_task (FScaleTask * task)
+{
+  gpointer *lines;
+  guint v_taps, n_taps, src_inc, in, j;
+  gint x, y, i, n, w, tmp_stride;
+
+  v_taps = gst_video_scaler_get_max_taps (task->v_scaler);
+  gst_video_scaler_get_coeff (task->v_scaler, 0, NULL, &n_taps);
+  src_inc = n_taps / v_taps;
+
+  lines = g_newa (gpointer, n_taps);
+  memset (lines, 0, n_taps * sizeof (gpointer));
+
+  tmp_stride = task->in_width * task->pstride;
+
+  for (y = task->y; y < task->h; y += TILE_LINES) {
+    n = MIN (TILE_LINES, task->h - y);
+
+    /* scale the lines of the tile vertically one stripe at a time, the input
+     * lines of a stripe stay in the cache for all the output lines that
+     * share them */
+    for (x = 0; x < task->in_width; x += task->tile_width) {
+      w = MIN (task->tile_width, task->in_width - x);
+
+      for (i = 0; i < n; i++) {
+        gst_video_scaler_get_coeff (task->v_scaler, y + i, &in, NULL);
+        for (j = 0; j < v_taps; j++)
+          lines[j * src_inc] = (guint8 *) task->s +
+              (in + j * src_inc) * task->sstride + x * task->pstride;
+
+        gst_video_scaler_vertical (task->v_scaler, task->format, lines,
+            task->tmp + i * tmp_stride + x * task->pstride, y + i, w);
+      }
+    }
+
+    /* then scale the whole lines of the tile horizontally */
+    for (i = 0; i < n; i++) {
+      gst_video_scaler_horizontal (task->h_scaler, task->format,
+          task->tmp + i * tmp_stride, task->d + (y + i) * task->dstride, 0,
+          task->w);
+    }
+  }
+}
+
 static void
 convert_plane_hv_task (FScaleTask * task)
 {
+  if (task->tmp) {
+    convert_plane_hv_tiled_task (task);
+    return;
+  }
+
   gst_video_scaler_2d (task->h_scaler, task->v_scaler, task->format,
       (guint8 *) task->s, task->sstride,
       task->d, task->dstride, task->x, task->y, task->w, task->h);
@@ -7205,6 +7648,22 @@ convert_plane_hv (GstVideoConverter * convert,
     tasks[i].h = tasks[i].y + lines_per_thread;
     tasks[i].h = MIN (out_height, tasks[i].h);
 
+    tasks[i].tmp = NULL;
+    if (convert->ftile[plane].lines && tasks[i].y < tasks[i].h) {
+      guint in;
+
+      /* only tile when gst_video_scaler_2d() would also scale vertically
+       * first, the result is then the same */
+      gst_video_scaler_get_coeff (tasks[i].v_scaler, tasks[i].h - 1, &in,
+          NULL);
+      if (in > tasks[i].h) {
+        tasks[i].tmp = convert->ftile[plane].lines[i];
+        tasks[i].in_width = convert->ftile[plane].in_width;
+        tasks[i].pstride = convert->ftile[plane].pstride;
+        tasks[i].tile_width = convert->ftile[plane].width;
+      }
+    }
+
     tasks_p[i] = &tasks[i];
   }
 
@@ -7380,6 +7839,48 @@ is_merge_yuv (GstVideoInfo * info)
   }
 }
 
+/* The vertical pass of gst_video_scaler_2d() reads all the taps of an output
+ * line over the full input width. For large frames these lines do not fit in
+ * the cache anymore and are read again from memory for every output line that
+ * uses them. Set up scratch lines so that the workers can scale their lines
+ * vertically in stripes that fit in the cache instead. */
+static void
+setup_scale_tiles (GstVideoConverter * convert, gint plane, gint in_width,
+    gint in_height, gint out_height, gint pstride)
+{
+  guint cache_size, n_taps, n_lines, n_threads, j;
+  gint width;
+
+  if (!convert->fh_scaler[plane].scaler || !convert->fv_scaler[plane].scaler)
+    return;
+
+  cache_size = GET_OPT_TILE_CACHE_SIZE (convert);
+  gst_video_scaler_get_coeff (convert->fv_scaler[plane].scaler[0], 0, NULL,
+      &n_taps);
+
+  if (cache_size == 0 || n_taps * in_width * pstride <= cache_size)
+    return;
+
+  /* the input lines needed for the output lines of one tile */
+  n_lines = n_taps + (TILE_LINES - 1) * in_height / out_height + 1;
+  width = cache_size / (n_lines * pstride);
+  width = MAX (width & ~63, 64);
+  if (width >= in_width)
+    return;
+
+  GST_DEBUG ("plane %d: scale in %d pixel wide stripes of %d lines", plane,
+      width, TILE_LINES);
+
+  n_threads = convert->conversion_runner->n_threads;
+  convert->ftile[plane].lines = g_new (guint8 *, n_threads);
+  for (j = 0; j < n_threads; j++)
+    convert->ftile[plane].lines[j] =
+        g_malloc (TILE_LINES * in_width * pstride);
+  convert->ftile[plane].in_width = in_width;
+  convert->ftile[plane].pstride = pstride;
+  convert->ftile[plane].width = width;
+}
+
 static gboolean
 setup_scale (GstVideoConverter * convert)
 {
@@ -7514,6 +8015,9 @@ setup_scale (GstVideoConverter * convert)
     convert->fconvert[0] = convert_plane_hv;
     convert->fformat[0] = get_scale_format (in_format, 0);
     convert->fsplane[0] = 0;
+
+    if (!is_merge_yuv (in_info))
+      setup_scale_tiles (convert, 0, in_width, in_height, out_height, pstride);
   } else {
     for (i = 0; i < n_planes; i++) {
       gint out_comp[GST_VIDEO_MAX_COMPONENTS];
@@ -7669,6 +8173,8 @@ setup_scale (GstVideoConverter * convert)
 
       gst_structure_free (config);
       convert->fformat[i] = get_scale_format (in_format, i);
+
+      setup_scale_tiles (convert, i, iw, ih, oh, pstride);
     }
   }
 
@@ -8099,6 +8605,22 @@ static const VideoTransform transforms[] = {
   {GST_VIDEO_FORMAT_A420, GST_VIDEO_FORMAT_BGR16, FALSE, TRUE, TRUE, TRUE,
       TRUE, FALSE, FALSE, FALSE, 0, 0, convert_I420_pack_ARGB},
 
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  /* high bit depth */
+  {GST_VIDEO_FORMAT_P010_10LE, GST_VIDEO_FORMAT_I420_10LE, TRUE, FALSE, TRUE,
+      FALSE, FALSE, FALSE, FALSE, FALSE, 0, 0, convert_P010_I420_10LE},
+  {GST_VIDEO_FORMAT_I420_10LE, GST_VIDEO_FORMAT_P010_10LE, TRUE, FALSE, TRUE,
+      FALSE, FALSE, FALSE, FALSE, FALSE, 0, 0, convert_I420_10LE_P010},
+  {GST_VIDEO_FORMAT_P012_LE, GST_VIDEO_FORMAT_I420_12LE, TRUE, FALSE, TRUE,
+      FALSE, FALSE, FALSE, FALSE, FALSE, 0, 0, convert_P012_I420_12LE},
+  {GST_VIDEO_FORMAT_I420_12LE, GST_VIDEO_FORMAT_P012_LE, TRUE, FALSE, TRUE,
+      FALSE, FALSE, FALSE, FALSE, FALSE, 0, 0, convert_I420_12LE_P012},
+  {GST_VIDEO_FORMAT_I422_10LE, GST_VIDEO_FORMAT_v210, TRUE, FALSE, TRUE,
+      FALSE, FALSE, FALSE, FALSE, FALSE, 0, 0, convert_I422_10LE_v210},
+  {GST_VIDEO_FORMAT_v210, GST_VIDEO_FORMAT_I422_10LE, TRUE, FALSE, TRUE,
+      FALSE, FALSE, FALSE, FALSE, FALSE, 0, 0, convert_v210_I422_10LE},
+#endif
+
   /* scalers */
   {GST_VIDEO_FORMAT_GBR, GST_VIDEO_FORMAT_GBR, TRUE, FALSE, FALSE, TRUE,
       TRUE, FALSE, FALSE, FALSE, 0, 0, convert_scale_planes},
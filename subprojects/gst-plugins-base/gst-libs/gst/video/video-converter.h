@@ -285,6 +285,17 @@ typedef enum {
  */
 #define GST_VIDEO_CONVERTER_OPT_ASYNC_TASKS   "GstVideoConverter.async-tasks"
 
+/**
+ * GST_VIDEO_CONVERTER_OPT_TILE_CACHE_SIZE:
+ *
+ * #G_TYPE_UINT, the number of bytes of cache that the working set of one tile
+ * should fit in when scaling. Frames whose lines do not fit are scaled in
+ * vertical stripes. Default 262144, 0 disables tiling.
+ *
+ * Since: 1.24
+ */
+#define GST_VIDEO_CONVERTER_OPT_TILE_CACHE_SIZE   "GstVideoConverter.tile-cache-size"
+
 typedef struct _GstVideoConverter GstVideoConverter;
 
 GST_VIDEO_API
@@ -67,6 +67,16 @@
 #define DEFAULT_PAD_VOLUME (1.0)
 #define DEFAULT_PAD_MUTE (FALSE)
 
+#define DEFAULT_MAX_THREADS 1
+
+/* The output is mixed in blocks of this many bytes, all pads are added to a
+ * block before moving on to the next one so that it stays in the cache */
+#define MIX_BLOCK_SIZE 16384
+
+/* Number of samples, summed over all pads, each thread should at least have
+ * to mix before it is worth waking up the other threads */
+#define MIN_SAMPLES_PER_THREAD 65536
+
 /* some defines for audio processing */
 /* the volume factor is a range from 0.0 to (arbitrary) VOLUME_MAX_DOUBLE = 10.0
  * we map 1.0 to VOLUME_UNITY_INT*
@@ -164,9 +174,36 @@ gst_audiomixer_pad_init (GstAudioMixerPad * pad)
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_MAX_THREADS,
+  PROP_STATS
 };
 
+/* Input of one pad that is added to the output buffer when it is finished,
+ * offsets and sizes are in samples */
+typedef struct
+{
+  GstBuffer *inbuf;
+  GstMapInfo inmap;
+  guint in_offset;
+  guint out_offset;
+  guint n_samples;
+  gdouble volume;
+  gint volume_i;
+} MixEntry;
+
+/* Range of the output buffer that is mixed by one thread */
+typedef struct
+{
+  GstAudioFormat format;
+  guint bps;
+  guint8 *out;
+  const MixEntry *entries;
+  guint n_entries;
+  guint start;
+  guint end;
+} MixTask;
+
 /* These are the formats we can mix natively */
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
@@ -212,14 +249,147 @@ static gboolean
 gst_audiomixer_aggregate_one_buffer (GstAudioAggregator * aagg,
     GstAudioAggregatorPad * aaggpad, GstBuffer * inbuf, guint in_offset,
     GstBuffer * outbuf, guint out_offset, guint num_samples);
+static GstFlowReturn gst_audiomixer_finish_buffer (GstAggregator * agg,
+    GstBuffer * buffer);
+static gboolean gst_audiomixer_negotiated_src_caps (GstAggregator * agg,
+    GstCaps * caps);
+static gboolean gst_audiomixer_start (GstAggregator * agg);
+static gboolean gst_audiomixer_stop (GstAggregator * agg);
+static GstFlowReturn gst_audiomixer_flush (GstAggregator * agg);
+
+static void
+gst_audiomixer_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstAudioMixer *self = GST_AUDIO_MIXER (object);
+
+  switch (prop_id) {
+    case PROP_MAX_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->max_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static GstStructure *
+gst_audiomixer_create_stats (GstAudioMixer * self)
+{
+  GstStructure *s;
+
+  GST_OBJECT_LOCK (self);
+  s = gst_structure_new ("application/x-audiomixer-stats",
+      "cycles", G_TYPE_UINT64, self->cycles,
+      "mixed-pads", G_TYPE_UINT, self->mixed_pads,
+      "skipped-pads", G_TYPE_UINT, self->skipped_pads,
+      "max-mixed-pads", G_TYPE_UINT, self->max_mixed_pads,
+      "average-mixed-pads", G_TYPE_DOUBLE, self->cycles > 0 ?
+      (gdouble) self->mixed_pads_total / self->cycles : 0.0, NULL);
+  GST_OBJECT_UNLOCK (self);
+
+  return s;
+}
 
+static void
+gst_audiomixer_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstAudioMixer *self = GST_AUDIO_MIXER (object);
+
+  switch (prop_id) {
+    case PROP_MAX_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->max_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_audiomixer_create_stats (self));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_audiomixer_clear_entries (GArray * entries)
+{
+  guint i;
+
+  for (i = 0; i < entries->len; i++)
+    gst_buffer_unref (g_array_index (entries, MixEntry, i).inbuf);
+  g_array_set_size (entries, 0);
+}
+
+static void
+gst_audiomixer_finalize (GObject * object)
+{
+  GstAudioMixer *self = GST_AUDIO_MIXER (object);
+
+  gst_audiomixer_clear_entries (self->mix_entries);
+  g_array_unref (self->mix_entries);
+  g_array_unref (self->mix_entries_in_use);
+  if (self->mix_pool) {
+    gst_task_pool_cleanup (self->mix_pool);
+    gst_object_unref (self->mix_pool);
+  }
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
 
 static void
 gst_audiomixer_class_init (GstAudioMixerClass * klass)
 {
+  GObjectClass *gobject_class = (GObjectClass *) klass;
   GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstAggregatorClass *agg_class = (GstAggregatorClass *) klass;
   GstAudioAggregatorClass *aagg_class = (GstAudioAggregatorClass *) klass;
 
+  gobject_class->set_property = gst_audiomixer_set_property;
+  gobject_class->get_property = gst_audiomixer_get_property;
+  gobject_class->finalize = gst_audiomixer_finalize;
+
+  /**
+   * GstAudioMixer:max-threads:
+   *
+   * Maximum number of threads used for mixing (0 = auto). The output buffer
+   * is split into ranges that are mixed in parallel, this is only done when
+   * there is enough work, for example with a large number of pads.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_THREADS,
+      g_param_spec_uint ("max-threads", "Max Threads",
+          "Maximum number of mixing threads to spawn (0 = auto)", 0, G_MAXINT,
+          DEFAULT_MAX_THREADS, GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAudioMixer:stats:
+   *
+   * Mixing statistics. This property returns a GstStructure with name
+   * application/x-audiomixer-stats with the following fields:
+   *
+   * * #guint64 `cycles`: the number of output buffers mixed.
+   * * #guint `mixed-pads`: the number of pads mixed into the last output
+   *   buffer.
+   * * #guint `skipped-pads`: the number of muted pads skipped for the last
+   *   output buffer. Pads that only had GAP buffers are not counted.
+   * * #guint `max-mixed-pads`: the largest number of pads mixed into one
+   *   output buffer.
+   * * #gdouble `average-mixed-pads`: the average number of pads mixed into
+   *   one output buffer.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Various statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
       &gst_audiomixer_src_template, GST_TYPE_AUDIO_AGGREGATOR_CONVERT_PAD);
   gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
@@ -233,6 +403,13 @@ gst_audiomixer_class_init (GstAudioMixerClass * klass)
   gstelement_class->release_pad =
       GST_DEBUG_FUNCPTR (gst_audiomixer_release_pad);
 
+  agg_class->finish_buffer = GST_DEBUG_FUNCPTR (gst_audiomixer_finish_buffer);
+  agg_class->negotiated_src_caps =
+      GST_DEBUG_FUNCPTR (gst_audiomixer_negotiated_src_caps);
+  agg_class->start = GST_DEBUG_FUNCPTR (gst_audiomixer_start);
+  agg_class->stop = GST_DEBUG_FUNCPTR (gst_audiomixer_stop);
+  agg_class->flush = GST_DEBUG_FUNCPTR (gst_audiomixer_flush);
+
   aagg_class->aggregate_one_buffer = gst_audiomixer_aggregate_one_buffer;
 
   gst_type_mark_as_plugin_api (GST_TYPE_AUDIO_MIXER_PAD, 0);
@@ -241,6 +418,90 @@ gst_audiomixer_class_init (GstAudioMixerClass * klass)
 static void
 gst_audiomixer_init (GstAudioMixer * audiomixer)
 {
+  audiomixer->max_threads = DEFAULT_MAX_THREADS;
+  audiomixer->mix_entries = g_array_new (FALSE, FALSE, sizeof (MixEntry));
+  audiomixer->mix_entries_in_use =
+      g_array_new (FALSE, FALSE, sizeof (MixEntry));
+}
+
+/* Call with the object lock */
+static void
+gst_audiomixer_reset (GstAudioMixer * self)
+{
+  GList *l;
+
+  gst_audiomixer_clear_entries (self->mix_entries);
+  self->mix_outbuf = NULL;
+
+  for (l = GST_ELEMENT (self)->sinkpads; l; l = l->next)
+    GST_AUDIO_MIXER_PAD (l->data)->cycle = 0;
+
+  self->cycles = 0;
+  self->mixed_pads_total = 0;
+  self->mixed_pads = 0;
+  self->skipped_pads = 0;
+  self->max_mixed_pads = 0;
+  self->cycle_mixed_pads = 0;
+  self->cycle_skipped_pads = 0;
+}
+
+static gboolean
+gst_audiomixer_start (GstAggregator * agg)
+{
+  GstAudioMixer *self = GST_AUDIO_MIXER (agg);
+  guint n_threads;
+
+  GST_OBJECT_LOCK (self);
+  gst_audiomixer_reset (self);
+  n_threads = self->max_threads;
+  GST_OBJECT_UNLOCK (self);
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  if (n_threads > 1) {
+    GST_DEBUG_OBJECT (self, "Mixing with up to %u threads", n_threads);
+    self->mix_pool = gst_shared_task_pool_new ();
+    gst_shared_task_pool_set_max_threads (GST_SHARED_TASK_POOL
+        (self->mix_pool), n_threads - 1);
+    gst_task_pool_prepare (self->mix_pool, NULL);
+    self->mix_n_threads = n_threads;
+  }
+
+  return GST_AGGREGATOR_CLASS (parent_class)->start (agg);
+}
+
+static gboolean
+gst_audiomixer_stop (GstAggregator * agg)
+{
+  GstAudioMixer *self = GST_AUDIO_MIXER (agg);
+
+  GST_OBJECT_LOCK (self);
+  gst_audiomixer_reset (self);
+  GST_OBJECT_UNLOCK (self);
+
+  if (self->mix_pool) {
+    gst_task_pool_cleanup (self->mix_pool);
+    gst_object_unref (self->mix_pool);
+    self->mix_pool = NULL;
+  }
+
+  return GST_AGGREGATOR_CLASS (parent_class)->stop (agg);
+}
+
+static GstFlowReturn
+gst_audiomixer_flush (GstAggregator * agg)
+{
+  GstAudioMixer *self = GST_AUDIO_MIXER (agg);
+
+  /* the output buffer is dropped, so is everything that was still to be
+   * added to it */
+  GST_OBJECT_LOCK (self);
+  gst_audiomixer_clear_entries (self->mix_entries);
+  self->mix_outbuf = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  return GST_AGGREGATOR_CLASS (parent_class)->flush (agg);
 }
 
 static GstPad *
@@ -284,138 +545,320 @@ gst_audiomixer_release_pad (GstElement * element, GstPad * pad)
 }
 
 
-static gboolean
-gst_audiomixer_aggregate_one_buffer (GstAudioAggregator * aagg,
-    GstAudioAggregatorPad * aaggpad, GstBuffer * inbuf, guint in_offset,
-    GstBuffer * outbuf, guint out_offset, guint num_frames)
+static void
+gst_audiomixer_mix_samples (GstAudioFormat format, const MixEntry * entry,
+    gpointer out, gconstpointer in, guint n_samples)
 {
-  GstAudioMixerPad *pad = GST_AUDIO_MIXER_PAD (aaggpad);
-  GstMapInfo inmap;
-  GstMapInfo outmap;
-  gint bpf;
-  GstAggregator *agg = GST_AGGREGATOR (aagg);
-  GstAudioAggregatorPad *srcpad = GST_AUDIO_AGGREGATOR_PAD (agg->srcpad);
-
-  GST_OBJECT_LOCK (aagg);
-  GST_OBJECT_LOCK (aaggpad);
-
-  if (pad->mute || pad->volume < G_MINDOUBLE) {
-    GST_DEBUG_OBJECT (pad, "Skipping muted pad");
-    GST_OBJECT_UNLOCK (aaggpad);
-    GST_OBJECT_UNLOCK (aagg);
-    return FALSE;
-  }
-
-  bpf = GST_AUDIO_INFO_BPF (&srcpad->info);
-
-  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
-  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
-  GST_LOG_OBJECT (pad, "mixing %u bytes at offset %u from offset %u",
-      num_frames * bpf, out_offset * bpf, in_offset * bpf);
-
-  /* further buffers, need to add them */
-  if (pad->volume == 1.0) {
-    switch (srcpad->info.finfo->format) {
+  if (entry->volume == 1.0) {
+    switch (format) {
       case GST_AUDIO_FORMAT_U8:
-        audiomixer_orc_add_u8 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * srcpad->info.channels);
+        audiomixer_orc_add_u8 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_S8:
-        audiomixer_orc_add_s8 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * srcpad->info.channels);
+        audiomixer_orc_add_s8 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_U16:
-        audiomixer_orc_add_u16 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * srcpad->info.channels);
+        audiomixer_orc_add_u16 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_S16:
-        audiomixer_orc_add_s16 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * srcpad->info.channels);
+        audiomixer_orc_add_s16 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_U32:
-        audiomixer_orc_add_u32 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * srcpad->info.channels);
+        audiomixer_orc_add_u32 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_S32:
-        audiomixer_orc_add_s32 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * srcpad->info.channels);
+        audiomixer_orc_add_s32 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_F32:
-        audiomixer_orc_add_f32 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * srcpad->info.channels);
+        audiomixer_orc_add_f32 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_F64:
-        audiomixer_orc_add_f64 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * srcpad->info.channels);
+        audiomixer_orc_add_f64 (out, in, n_samples);
         break;
       default:
         g_assert_not_reached ();
         break;
     }
   } else {
-    switch (srcpad->info.finfo->format) {
+    switch (format) {
       case GST_AUDIO_FORMAT_U8:
-        audiomixer_orc_add_volume_u8 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i8, num_frames * srcpad->info.channels);
+        audiomixer_orc_add_volume_u8 (out, in, entry->volume_i, n_samples);
         break;
       case GST_AUDIO_FORMAT_S8:
-        audiomixer_orc_add_volume_s8 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i8, num_frames * srcpad->info.channels);
+        audiomixer_orc_add_volume_s8 (out, in, entry->volume_i, n_samples);
         break;
       case GST_AUDIO_FORMAT_U16:
-        audiomixer_orc_add_volume_u16 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i16, num_frames * srcpad->info.channels);
+        audiomixer_orc_add_volume_u16 (out, in, entry->volume_i, n_samples);
         break;
       case GST_AUDIO_FORMAT_S16:
-        audiomixer_orc_add_volume_s16 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i16, num_frames * srcpad->info.channels);
+        audiomixer_orc_add_volume_s16 (out, in, entry->volume_i, n_samples);
         break;
       case GST_AUDIO_FORMAT_U32:
-        audiomixer_orc_add_volume_u32 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i32, num_frames * srcpad->info.channels);
+        audiomixer_orc_add_volume_u32 (out, in, entry->volume_i, n_samples);
         break;
       case GST_AUDIO_FORMAT_S32:
-        audiomixer_orc_add_volume_s32 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i32, num_frames * srcpad->info.channels);
+        audiomixer_orc_add_volume_s32 (out, in, entry->volume_i, n_samples);
         break;
       case GST_AUDIO_FORMAT_F32:
-        audiomixer_orc_add_volume_f32 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume, num_frames * srcpad->info.channels);
+        audiomixer_orc_add_volume_f32 (out, in, entry->volume, n_samples);
         break;
       case GST_AUDIO_FORMAT_F64:
-        audiomixer_orc_add_volume_f64 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume, num_frames * srcpad->info.channels);
+        audiomixer_orc_add_volume_f64 (out, in, entry->volume, n_samples);
         break;
       default:
         g_assert_not_reached ();
         break;
     }
   }
-  gst_buffer_unmap (inbuf, &inmap);
+}
+
+static void
+gst_audiomixer_mix_task (gpointer user_data)
+{
+  MixTask *task = user_data;
+  guint block_samples = MIX_BLOCK_SIZE / task->bps;
+  guint block_start, block_end, i;
+
+  /* add all pads to one block of the output before going to the next one,
+   * instead of walking the whole output buffer once per pad */
+  for (block_start = task->start; block_start < task->end;
+      block_start = block_end) {
+    block_end = MIN (block_start + block_samples, task->end);
+
+    for (i = 0; i < task->n_entries; i++) {
+      const MixEntry *entry = &task->entries[i];
+      guint start = MAX (entry->out_offset, block_start);
+      guint end = MIN (entry->out_offset + entry->n_samples, block_end);
+
+      if (start >= end)
+        continue;
+
+      gst_audiomixer_mix_samples (task->format, entry,
+          task->out + start * task->bps,
+          entry->inmap.data + (entry->in_offset + start -
+              entry->out_offset) * task->bps, end - start);
+    }
+  }
+}
+
+/* Adds all pending input to @outbuf. With @finish the output buffer is
+ * complete and the statistics are updated. */
+static void
+gst_audiomixer_mix_pending (GstAudioMixer * self, GstBuffer * outbuf,
+    gboolean finish)
+{
+  GstAudioAggregatorPad *srcpad =
+      GST_AUDIO_AGGREGATOR_PAD (GST_AGGREGATOR_SRC_PAD (self));
+  GArray *entries;
+  GstAudioFormat format;
+  GstMapInfo outmap;
+  guint bps, out_samples, i, n_entries = 0;
+  guint64 total = 0;
+
+  GST_OBJECT_LOCK (self);
+  entries = self->mix_entries;
+  if (outbuf == self->mix_outbuf) {
+    self->mix_entries = self->mix_entries_in_use;
+    self->mix_entries_in_use = entries;
+  } else {
+    entries = NULL;
+  }
+  self->mix_outbuf = NULL;
+  format = GST_AUDIO_INFO_FORMAT (&srcpad->info);
+  bps = GST_AUDIO_INFO_WIDTH (&srcpad->info) / 8;
+
+  if (finish) {
+    self->cycles++;
+    self->mixed_pads = self->cycle_mixed_pads;
+    self->skipped_pads = self->cycle_skipped_pads;
+    self->mixed_pads_total += self->cycle_mixed_pads;
+    self->max_mixed_pads = MAX (self->max_mixed_pads, self->cycle_mixed_pads);
+    self->cycle_mixed_pads = 0;
+    self->cycle_skipped_pads = 0;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (entries == NULL || entries->len == 0)
+    return;
+
+  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
+  out_samples = outmap.size / bps;
+
+  /* the output buffer might have been shrunk at EOS */
+  for (i = 0; i < entries->len; i++) {
+    MixEntry *entry = &g_array_index (entries, MixEntry, i);
+
+    if (entry->out_offset >= out_samples) {
+      entry->n_samples = 0;
+      continue;
+    }
+    entry->n_samples = MIN (entry->n_samples, out_samples - entry->out_offset);
+
+    gst_buffer_map (entry->inbuf, &entry->inmap, GST_MAP_READ);
+    total += entry->n_samples;
+    n_entries = i + 1;
+  }
+
+  GST_LOG_OBJECT (self, "mixing %u pads, %" G_GUINT64_FORMAT " samples",
+      entries->len, total);
+
+  if (self->mix_pool && total >= 2 * MIN_SAMPLES_PER_THREAD) {
+    guint n_threads = self->mix_n_threads;
+    MixTask *tasks = g_newa (MixTask, n_threads);
+    gpointer *ids = g_newa (gpointer, n_threads);
+    guint align = MAX (64 / bps, 1);
+    guint chunk;
+
+    /* each thread adds all pads to its own range of the output, keep the
+     * ranges cache line aligned so that threads never share a line */
+    chunk = (out_samples + n_threads - 1) / n_threads;
+    chunk = (chunk + align - 1) / align * align;
+
+    for (i = 0; i < n_threads; i++) {
+      tasks[i].format = format;
+      tasks[i].bps = bps;
+      tasks[i].out = outmap.data;
+      tasks[i].entries = (const MixEntry *) entries->data;
+      tasks[i].n_entries = n_entries;
+      tasks[i].start = MIN (i * chunk, out_samples);
+      tasks[i].end = MIN (tasks[i].start + chunk, out_samples);
+    }
+
+    /* the last range is mixed in the current thread */
+    for (i = 0; i < n_threads - 1; i++) {
+      ids[i] = gst_task_pool_push (self->mix_pool, gst_audiomixer_mix_task,
+          &tasks[i], NULL);
+      /* the shared task pool only fails when it was not prepared */
+      g_assert (ids[i] != NULL);
+    }
+
+    gst_audiomixer_mix_task (&tasks[n_threads - 1]);
+
+    for (i = 0; i < n_threads - 1; i++)
+      gst_task_pool_join (self->mix_pool, ids[i]);
+  } else {
+    MixTask task;
+
+    task.format = format;
+    task.bps = bps;
+    task.out = outmap.data;
+    task.entries = (const MixEntry *) entries->data;
+    task.n_entries = n_entries;
+    task.start = 0;
+    task.end = out_samples;
+
+    gst_audiomixer_mix_task (&task);
+  }
+
+  for (i = 0; i < entries->len; i++) {
+    MixEntry *entry = &g_array_index (entries, MixEntry, i);
+
+    if (entry->n_samples > 0)
+      gst_buffer_unmap (entry->inbuf, &entry->inmap);
+  }
   gst_buffer_unmap (outbuf, &outmap);
 
+  gst_audiomixer_clear_entries (entries);
+}
+
+static gboolean
+gst_audiomixer_aggregate_one_buffer (GstAudioAggregator * aagg,
+    GstAudioAggregatorPad * aaggpad, GstBuffer * inbuf, guint in_offset,
+    GstBuffer * outbuf, guint out_offset, guint num_frames)
+{
+  GstAudioMixer *self = GST_AUDIO_MIXER (aagg);
+  GstAudioMixerPad *pad = GST_AUDIO_MIXER_PAD (aaggpad);
+  GstAudioAggregatorPad *srcpad =
+      GST_AUDIO_AGGREGATOR_PAD (GST_AGGREGATOR_SRC_PAD (aagg));
+  gboolean counted;
+  guint channels;
+  MixEntry entry;
+
+  GST_OBJECT_LOCK (aagg);
+  GST_OBJECT_LOCK (aaggpad);
+
+  /* anything still pending belongs to an output buffer that was dropped */
+  if (outbuf != self->mix_outbuf) {
+    gst_audiomixer_clear_entries (self->mix_entries);
+    self->mix_outbuf = outbuf;
+  }
+
+  /* a pad can be called multiple times for one output buffer */
+  counted = pad->cycle == self->cycles + 1;
+  pad->cycle = self->cycles + 1;
+
+  if (pad->mute || pad->volume < G_MINDOUBLE) {
+    GST_DEBUG_OBJECT (pad, "Skipping muted pad");
+    if (!counted)
+      self->cycle_skipped_pads++;
+    GST_OBJECT_UNLOCK (aaggpad);
+    GST_OBJECT_UNLOCK (aagg);
+    return FALSE;
+  }
+
+  if (!counted)
+    self->cycle_mixed_pads++;
+
+  channels = GST_AUDIO_INFO_CHANNELS (&srcpad->info);
+
+  GST_LOG_OBJECT (pad, "queueing %u frames at offset %u from offset %u",
+      num_frames, out_offset, in_offset);
+
+  /* the actual mixing is done for all pads at once when the output buffer
+   * is finished, see gst_audiomixer_mix_pending() */
+  entry.inbuf = gst_buffer_ref (inbuf);
+  entry.in_offset = in_offset * channels;
+  entry.out_offset = out_offset * channels;
+  entry.n_samples = num_frames * channels;
+  entry.volume = pad->volume;
+  switch (GST_AUDIO_INFO_WIDTH (&srcpad->info)) {
+    case 8:
+      entry.volume_i = pad->volume_i8;
+      break;
+    case 16:
+      entry.volume_i = pad->volume_i16;
+      break;
+    case 32:
+      entry.volume_i = pad->volume_i32;
+      break;
+    default:
+      entry.volume_i = 0;
+      break;
+  }
+  g_array_append_val (self->mix_entries, entry);
+
   GST_OBJECT_UNLOCK (aaggpad);
   GST_OBJECT_UNLOCK (aagg);
 
   return TRUE;
 }
 
+static GstFlowReturn
+gst_audiomixer_finish_buffer (GstAggregator * agg, GstBuffer * buffer)
+{
+  gst_audiomixer_mix_pending (GST_AUDIO_MIXER (agg), buffer, TRUE);
+
+  return GST_AGGREGATOR_CLASS (parent_class)->finish_buffer (agg, buffer);
+}
+
+static gboolean
+gst_audiomixer_negotiated_src_caps (GstAggregator * agg, GstCaps * caps)
+{
+  GstAudioMixer *self = GST_AUDIO_MIXER (agg);
+  GstBuffer *outbuf;
+
+  /* the current output buffer gets converted to the new format, so
+   * everything queued so far has to be mixed in the old format first */
+  GST_OBJECT_LOCK (self);
+  outbuf = self->mix_outbuf;
+  GST_OBJECT_UNLOCK (self);
+
+  if (outbuf)
+    gst_audiomixer_mix_pending (self, outbuf, FALSE);
+
+  return GST_AGGREGATOR_CLASS (parent_class)->negotiated_src_caps (agg, caps);
+}
+
 
 /* GstChildProxy implementation */
 static GObject *
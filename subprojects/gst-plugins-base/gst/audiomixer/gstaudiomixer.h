@@ -41,6 +41,25 @@ G_DECLARE_FINAL_TYPE (GstAudioMixer, gst_audiomixer, GST, AUDIO_MIXER,
  */
 struct _GstAudioMixer {
   GstAudioAggregator element;
+
+  guint max_threads;
+
+  /* Input that still has to be added to mix_outbuf, mixing is done
+   * for all pads at once when the output buffer is finished */
+  GstBuffer *mix_outbuf;
+  GArray *mix_entries;
+  GArray *mix_entries_in_use;
+  GstTaskPool *mix_pool;
+  guint mix_n_threads;
+
+  /* stats, protected by the object lock */
+  guint64 cycles;
+  guint64 mixed_pads_total;
+  guint mixed_pads;
+  guint skipped_pads;
+  guint max_mixed_pads;
+  guint cycle_mixed_pads;
+  guint cycle_skipped_pads;
 };
 
 #define GST_TYPE_AUDIO_MIXER_PAD (gst_audiomixer_pad_get_type())
@@ -55,6 +74,9 @@ struct _GstAudioMixerPad {
   gint volume_i16;
   gint volume_i8;
   gboolean mute;
+
+  /* last mixer cycle this pad was counted in */
+  guint64 cycle;
 };
 
 G_END_DECLS
@@ -286,6 +286,29 @@ gst_compositor_pad_set_property (GObject * object, guint prop_id,
   }
 }
 
+static void
+gst_compositor_pad_notify (GObject * object, GParamSpec * pspec)
+{
+  GstCompositorPad *pad = GST_COMPOSITOR_PAD (object);
+
+  /* Any property, including the converter-config of the parent class, might
+   * change how the pad is drawn */
+  g_atomic_int_set (&pad->damage_props_changed, TRUE);
+
+  if (G_OBJECT_CLASS (gst_compositor_pad_parent_class)->notify)
+    G_OBJECT_CLASS (gst_compositor_pad_parent_class)->notify (object, pspec);
+}
+
+static void
+gst_compositor_pad_finalize (GObject * object)
+{
+  GstCompositorPad *pad = GST_COMPOSITOR_PAD (object);
+
+  gst_clear_buffer (&pad->damage_buffer);
+
+  G_OBJECT_CLASS (gst_compositor_pad_parent_class)->finalize (object);
+}
+
 static void
 _mixer_pad_get_output_size (GstCompositor * comp, GstCompositorPad * comp_pad,
     gint out_par_n, gint out_par_d, gint * width, gint * height,
@@ -427,16 +450,80 @@ is_point_contained (const GstVideoRectangle rect, const gint px, const gint py)
   return FALSE;
 }
 
-/* Test whether rectangle2 contains rectangle 1 (geometrically) */
+/* The visible part of a rectangle after removing the parts obscured by other
+ * rectangles. Only up to MAX_VISIBLE_RECTS pieces are tracked, after that a
+ * rectangle is just assumed to stay visible. */
+#define MAX_VISIBLE_RECTS 32
+
+typedef struct
+{
+  GstVideoRectangle rects[MAX_VISIBLE_RECTS];
+  guint n_rects;
+} VisibleRegion;
+
+static void
+visible_region_init (VisibleRegion * region, const GstVideoRectangle rect)
+{
+  region->rects[0] = rect;
+  region->n_rects = 1;
+}
+
+static void
+visible_region_append (GstVideoRectangle * rects, guint * n_rects, gint x,
+    gint y, gint w, gint h)
+{
+  rects[*n_rects].x = x;
+  rects[*n_rects].y = y;
+  rects[*n_rects].w = w;
+  rects[*n_rects].h = h;
+  (*n_rects)++;
+}
+
+/* Removes @sub from @region, splitting every rectangle it intersects into the
+ * pieces above, below, left and right of it. Returns FALSE and leaves @region
+ * unchanged if that needs more than MAX_VISIBLE_RECTS rectangles. */
 static gboolean
-is_rectangle_contained (const GstVideoRectangle rect1,
-    const GstVideoRectangle rect2)
+visible_region_subtract (VisibleRegion * region, const GstVideoRectangle sub)
 {
-  if ((rect2.x <= rect1.x) && (rect2.y <= rect1.y) &&
-      ((rect2.x + rect2.w) >= (rect1.x + rect1.w)) &&
-      ((rect2.y + rect2.h) >= (rect1.y + rect1.h)))
+  GstVideoRectangle rects[MAX_VISIBLE_RECTS];
+  guint i, n_rects = 0;
+
+  if (sub.w <= 0 || sub.h <= 0)
     return TRUE;
-  return FALSE;
+
+  for (i = 0; i < region->n_rects; i++) {
+    const GstVideoRectangle r = region->rects[i];
+    gint y1, y2;
+
+    if (sub.x >= r.x + r.w || sub.x + sub.w <= r.x ||
+        sub.y >= r.y + r.h || sub.y + sub.h <= r.y) {
+      if (n_rects == MAX_VISIBLE_RECTS)
+        return FALSE;
+      rects[n_rects++] = r;
+      continue;
+    }
+
+    if (n_rects + 4 > MAX_VISIBLE_RECTS)
+      return FALSE;
+
+    y1 = MAX (r.y, sub.y);
+    y2 = MIN (r.y + r.h, sub.y + sub.h);
+
+    if (sub.y > r.y)
+      visible_region_append (rects, &n_rects, r.x, r.y, r.w, sub.y - r.y);
+    if (sub.y + sub.h < r.y + r.h)
+      visible_region_append (rects, &n_rects, r.x, y2, r.w, r.y + r.h - y2);
+    if (sub.x > r.x)
+      visible_region_append (rects, &n_rects, r.x, y1, sub.x - r.x, y2 - y1);
+    if (sub.x + sub.w < r.x + r.w)
+      visible_region_append (rects, &n_rects, sub.x + sub.w, y1,
+          r.x + r.w - sub.x - sub.w, y2 - y1);
+  }
+
+  memcpy (region->rects, rects, n_rects * sizeof (GstVideoRectangle));
+  region->n_rects = n_rects;
+
+  return TRUE;
 }
 
 static GstVideoRectangle
@@ -459,10 +546,11 @@ clamp_rectangle (gint x, gint y, gint w, gint h, gint outer_width,
   return clamped;
 }
 
-/* Call this with the lock taken */
+/* Call this with the lock taken. Removes the part of @region that @pad covers
+ * with opaque pixels, returns TRUE once nothing of @region is visible anymore */
 static gboolean
-_pad_obscures_rectangle (GstVideoAggregator * vagg, GstVideoAggregatorPad * pad,
-    const GstVideoRectangle rect)
+_pad_obscures_region (GstVideoAggregator * vagg, GstVideoAggregatorPad * pad,
+    VisibleRegion * region)
 {
   GstVideoRectangle pad_rect;
   GstCompositorPad *cpad = GST_COMPOSITOR_PAD (pad);
@@ -505,12 +593,11 @@ _pad_obscures_rectangle (GstVideoAggregator * vagg, GstVideoAggregatorPad * pad,
   pad_rect.x += x_offset;
   pad_rect.y += y_offset;
 
-  if (!is_rectangle_contained (rect, pad_rect))
+  if (!visible_region_subtract (region, pad_rect) || region->n_rects > 0)
     return FALSE;
 
-  GST_DEBUG_OBJECT (pad, "Pad %s %ix%i@(%i,%i) obscures rect %ix%i@(%i,%i)",
-      GST_PAD_NAME (pad), pad_rect.w, pad_rect.h, pad_rect.x, pad_rect.y,
-      rect.w, rect.h, rect.x, rect.y);
+  GST_DEBUG_OBJECT (pad, "Pad %s %ix%i@(%i,%i) obscures the rest of the rect",
+      GST_PAD_NAME (pad), pad_rect.w, pad_rect.h, pad_rect.x, pad_rect.y);
 
   return TRUE;
 }
@@ -527,6 +614,7 @@ gst_compositor_pad_prepare_frame_start (GstVideoAggregatorPad * pad,
   /* The rectangle representing this frame, clamped to the video's boundaries.
    * Due to the clamping, this is different from the frame width/height above. */
   GstVideoRectangle frame_rect;
+  VisibleRegion visible;
 
   /* There's three types of width/height here:
    * 1. GST_VIDEO_FRAME_WIDTH/HEIGHT:
@@ -563,9 +651,9 @@ gst_compositor_pad_prepare_frame_start (GstVideoAggregatorPad * pad,
   }
 
   GST_OBJECT_LOCK (vagg);
-  /* Check if this frame is obscured by a higher-zorder frame
-   * TODO: Also skip a frame if it's obscured by a combination of
-   * higher-zorder frames */
+  /* Check if this frame is obscured by a higher-zorder frame or by a
+   * combination of higher-zorder frames */
+  visible_region_init (&visible, frame_rect);
   l = g_list_find (GST_ELEMENT (vagg)->sinkpads, pad);
   /* The pad might've just been removed */
   if (l)
@@ -585,7 +673,7 @@ gst_compositor_pad_prepare_frame_start (GstVideoAggregatorPad * pad,
       continue;
     }
 
-    if (_pad_obscures_rectangle (vagg, l->data, frame_rect)) {
+    if (_pad_obscures_region (vagg, l->data, &visible)) {
       frame_obscured = TRUE;
       break;
     }
@@ -673,6 +761,8 @@ gst_compositor_pad_class_init (GstCompositorPadClass * klass)
 
   gobject_class->set_property = gst_compositor_pad_set_property;
   gobject_class->get_property = gst_compositor_pad_get_property;
+  gobject_class->notify = gst_compositor_pad_notify;
+  gobject_class->finalize = gst_compositor_pad_finalize;
 
   g_object_class_install_property (gobject_class, PROP_PAD_XPOS,
       g_param_spec_int ("xpos", "X Position", "X Position of the picture",
@@ -742,6 +832,7 @@ gst_compositor_pad_init (GstCompositorPad * compo_pad)
 #define DEFAULT_BACKGROUND COMPOSITOR_BACKGROUND_CHECKER
 #define DEFAULT_ZERO_SIZE_IS_UNSCALED TRUE
 #define DEFAULT_MAX_THREADS 0
+#define DEFAULT_DAMAGE_TRACKING FALSE
 
 enum
 {
@@ -750,6 +841,7 @@ enum
   PROP_ZERO_SIZE_IS_UNSCALED,
   PROP_MAX_THREADS,
   PROP_IGNORE_INACTIVE_PADS,
+  PROP_DAMAGE_TRACKING,
 };
 
 static void
@@ -772,6 +864,9 @@ gst_compositor_get_property (GObject * object,
       g_value_set_boolean (value,
           gst_aggregator_get_ignore_inactive_pads (GST_AGGREGATOR (object)));
       break;
+    case PROP_DAMAGE_TRACKING:
+      g_value_set_boolean (value, self->damage_tracking);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -798,6 +893,9 @@ gst_compositor_set_property (GObject * object,
       gst_aggregator_set_ignore_inactive_pads (GST_AGGREGATOR (object),
           g_value_get_boolean (value));
       break;
+    case PROP_DAMAGE_TRACKING:
+      self->damage_tracking = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1382,6 +1480,21 @@ gst_parallelized_task_runner_run (GstParallelizedTaskRunner * self,
   }
 }
 
+/* Call this with the lock taken. Forgets about the last output so that the
+ * next one is drawn completely */
+static void
+_reset_damage (GstCompositor * self)
+{
+  GList *l;
+
+  for (l = GST_ELEMENT (self)->sinkpads; l; l = l->next)
+    gst_clear_buffer (&GST_COMPOSITOR_PAD (l->data)->damage_buffer);
+
+  self->damage_valid = FALSE;
+  gst_clear_buffer (&self->last_output);
+  g_ptr_array_set_size (self->last_pads, 0);
+}
+
 static gboolean
 _negotiated_caps (GstAggregator * agg, GstCaps * caps)
 {
@@ -1405,6 +1518,7 @@ _negotiated_caps (GstAggregator * agg, GstCaps * caps)
   }
 
   GST_OBJECT_LOCK (vagg);
+  _reset_damage (compositor);
   for (iter = GST_ELEMENT (vagg)->sinkpads; iter; iter = g_list_next (iter)) {
     GstVideoAggregatorPad *pad = (GstVideoAggregatorPad *) iter->data;
 
@@ -1489,6 +1603,10 @@ gst_composior_stop (GstAggregator * agg)
   gst_clear_buffer (&self->intermediate_frame);
   g_clear_pointer (&self->intermediate_convert, gst_video_converter_free);
 
+  GST_OBJECT_LOCK (agg);
+  _reset_damage (self);
+  GST_OBJECT_UNLOCK (agg);
+
   return GST_AGGREGATOR_CLASS (parent_class)->stop (agg);
 }
 
@@ -1496,6 +1614,7 @@ static gboolean
 _should_draw_background (GstVideoAggregator * vagg)
 {
   GstVideoRectangle bg_rect;
+  VisibleRegion visible;
   gboolean draw = TRUE;
   GList *l;
 
@@ -1504,8 +1623,9 @@ _should_draw_background (GstVideoAggregator * vagg)
   GST_OBJECT_LOCK (vagg);
   bg_rect.w = GST_VIDEO_INFO_WIDTH (&vagg->info);
   bg_rect.h = GST_VIDEO_INFO_HEIGHT (&vagg->info);
-  /* Check if the background is completely obscured by a pad
-   * TODO: Also skip if it's obscured by a combination of pads */
+  /* Check if the background is completely obscured by a pad or by a
+   * combination of pads */
+  visible_region_init (&visible, bg_rect);
   for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
     if (gst_aggregator_pad_is_inactive (GST_AGGREGATOR_PAD (l->data))
         ||
@@ -1513,7 +1633,7 @@ _should_draw_background (GstVideoAggregator * vagg)
             (l->data)) == NULL)
       continue;
 
-    if (_pad_obscures_rectangle (vagg, l->data, bg_rect)) {
+    if (_pad_obscures_region (vagg, l->data, &visible)) {
       draw = FALSE;
       break;
     }
@@ -1534,6 +1654,205 @@ frames_can_copy (const GstVideoFrame * frame1, const GstVideoFrame * frame2)
   return TRUE;
 }
 
+/* Damage is tracked in ranges of output lines as that is what the blending and
+ * background functions can be restricted to */
+struct DamageLines
+{
+  guint start;
+  guint end;
+};
+
+/* Adds the lines of @rect to @damage, which is kept sorted and merged.
+ * @damage must have space for one more range */
+static void
+damage_add_rect (struct DamageLines *damage, guint * n_damage,
+    const GstVideoRectangle * rect, guint align, guint height)
+{
+  guint start, end, i, j;
+
+  if (rect->w <= 0 || rect->h <= 0)
+    return;
+
+  start = rect->y - rect->y % align;
+  end = MIN (GST_ROUND_UP_N ((guint) (rect->y + rect->h), align), height);
+
+  /* Skip all ranges ending before the new one and merge all the ranges
+   * overlapping or touching it */
+  for (i = 0; i < *n_damage && damage[i].end < start; i++);
+  for (j = i; j < *n_damage && damage[j].start <= end; j++) {
+    start = MIN (start, damage[j].start);
+    end = MAX (end, damage[j].end);
+  }
+
+  if (j == i) {
+    memmove (&damage[i + 1], &damage[i],
+        (*n_damage - i) * sizeof (struct DamageLines));
+    (*n_damage)++;
+  } else if (j > i + 1) {
+    memmove (&damage[i + 1], &damage[j],
+        (*n_damage - j) * sizeof (struct DamageLines));
+    *n_damage -= j - i - 1;
+  }
+
+  damage[i].start = start;
+  damage[i].end = end;
+}
+
+/* Call this with the lock taken. Collects the output lines that changed since
+ * the last output into @damage and remembers how the pads are drawn now for
+ * the next output. Returns FALSE if the whole output has to be redrawn */
+static gboolean
+_collect_damage (GstCompositor * self, GstVideoFrame * outframe,
+    gboolean draw_background, struct DamageLines *damage, guint * n_damage)
+{
+  const GstVideoFormatInfo *finfo = outframe->info.finfo;
+  gint out_width = GST_VIDEO_FRAME_WIDTH (outframe);
+  gint out_height = GST_VIDEO_FRAME_HEIGHT (outframe);
+  guint i, align = 1, n_drawn = 0;
+  gboolean valid;
+  GList *l;
+
+  /* Keep the ranges aligned to the vertical subsampling so that subsampled
+   * lines are always redrawn or copied as a whole */
+  for (i = 0; i < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (finfo); i++)
+    align = MAX (align, 1 << GST_VIDEO_FORMAT_INFO_H_SUB (finfo, i));
+
+  valid = self->damage_valid && (self->intermediate_frame || self->last_output)
+      && self->last_draw_background == draw_background
+      && self->last_background == self->background;
+
+  for (l = GST_ELEMENT (self)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *pad = l->data;
+    GstCompositorPad *cpad = GST_COMPOSITOR_PAD (pad);
+    GstVideoFrame *prepared_frame =
+        gst_video_aggregator_pad_get_prepared_frame (pad);
+    GstBuffer *buffer;
+    GstVideoRectangle rect;
+    gboolean props_changed;
+
+    props_changed =
+        g_atomic_int_compare_and_exchange (&cpad->damage_props_changed, TRUE,
+        FALSE);
+
+    if (prepared_frame == NULL) {
+      gst_clear_buffer (&cpad->damage_buffer);
+      continue;
+    }
+
+    /* The last buffer is kept referenced, so if the pad has the same buffer
+     * it can't be a recycled one with new content */
+    buffer = gst_video_aggregator_pad_get_current_buffer (pad);
+    rect = clamp_rectangle (cpad->xpos + cpad->x_offset,
+        cpad->ypos + cpad->y_offset, GST_VIDEO_FRAME_WIDTH (prepared_frame),
+        GST_VIDEO_FRAME_HEIGHT (prepared_frame), out_width, out_height);
+
+    /* A pad appearing, disappearing or changing its z-order changes what is
+     * drawn below and above it, just redraw everything then */
+    if (n_drawn >= self->last_pads->len
+        || g_ptr_array_index (self->last_pads, n_drawn) != cpad)
+      valid = FALSE;
+
+    if (valid && (props_changed || buffer != cpad->damage_buffer
+            || cpad->alpha != cpad->damage_alpha || cpad->op != cpad->damage_op
+            || rect.x != cpad->damage_rect.x || rect.y != cpad->damage_rect.y
+            || rect.w != cpad->damage_rect.w
+            || rect.h != cpad->damage_rect.h)) {
+      GST_LOG_OBJECT (pad, "Damaged %ix%i@(%i,%i), was %ix%i@(%i,%i)", rect.w,
+          rect.h, rect.x, rect.y, cpad->damage_rect.w, cpad->damage_rect.h,
+          cpad->damage_rect.x, cpad->damage_rect.y);
+      damage_add_rect (damage, n_damage, &cpad->damage_rect, align, out_height);
+      damage_add_rect (damage, n_damage, &rect, align, out_height);
+    }
+
+    gst_buffer_replace (&cpad->damage_buffer, buffer);
+    cpad->damage_rect = rect;
+    cpad->damage_alpha = cpad->alpha;
+    cpad->damage_op = cpad->op;
+
+    if (n_drawn < self->last_pads->len)
+      g_ptr_array_index (self->last_pads, n_drawn) = cpad;
+    else
+      g_ptr_array_add (self->last_pads, cpad);
+    n_drawn++;
+  }
+
+  if (n_drawn != self->last_pads->len)
+    valid = FALSE;
+  g_ptr_array_set_size (self->last_pads, n_drawn);
+
+  self->last_draw_background = draw_background;
+  self->last_background = self->background;
+
+  return valid;
+}
+
+static void
+_copy_lines (GstVideoFrame * dest, const GstVideoFrame * src, guint y_start,
+    guint y_end)
+{
+  guint i, plane, num_planes, height;
+
+  num_planes = GST_VIDEO_FRAME_N_PLANES (dest);
+  for (plane = 0; plane < num_planes; ++plane) {
+    const GstVideoFormatInfo *info;
+    gint comp[GST_VIDEO_MAX_COMPONENTS];
+    const guint8 *sdata;
+    guint8 *ddata;
+    gsize rowsize, dest_stride, src_stride;
+    gint yoffset;
+
+    info = dest->info.finfo;
+    dest_stride = GST_VIDEO_FRAME_PLANE_STRIDE (dest, plane);
+    src_stride = GST_VIDEO_FRAME_PLANE_STRIDE (src, plane);
+
+    gst_video_format_info_component (info, plane, comp);
+    rowsize = GST_VIDEO_FRAME_COMP_WIDTH (dest, comp[0])
+        * GST_VIDEO_FRAME_COMP_PSTRIDE (dest, comp[0]);
+    height = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (info, comp[0],
+        (y_end - y_start));
+
+    yoffset = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (info, comp[0], y_start);
+
+    ddata = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (dest, plane)
+        + yoffset * dest_stride;
+    sdata = (const guint8 *) GST_VIDEO_FRAME_PLANE_DATA (src, plane)
+        + yoffset * src_stride;
+    for (i = 0; i < height; ++i) {
+      memcpy (ddata, sdata, rowsize);
+      ddata += dest_stride;
+      sdata += src_stride;
+    }
+  }
+}
+
+/* Call this with the lock taken. Copies all lines outside of @damage from the
+ * last output */
+static gboolean
+_copy_undamaged_lines (GstCompositor * self, GstVideoFrame * outframe,
+    const struct DamageLines *damage, guint n_damage)
+{
+  GstVideoFrame last_frame;
+  guint i, start = 0, end;
+
+  if (!gst_video_frame_map (&last_frame, &GST_VIDEO_AGGREGATOR (self)->info,
+          self->last_output, GST_MAP_READ)) {
+    GST_WARNING_OBJECT (self, "Could not map last output buffer");
+    return FALSE;
+  }
+
+  for (i = 0; i <= n_damage; i++) {
+    end = i < n_damage ? damage[i].start : GST_VIDEO_FRAME_HEIGHT (outframe);
+    if (end > start)
+      _copy_lines (outframe, &last_frame, start, end);
+    if (i < n_damage)
+      start = damage[i].end;
+  }
+
+  gst_video_frame_unmap (&last_frame);
+
+  return TRUE;
+}
+
 struct CompositePadInfo
 {
   GstVideoFrame *prepared_frame;
@@ -1550,6 +1869,8 @@ struct CompositeTask
   gboolean draw_background;
   guint n_pads;
   struct CompositePadInfo *pads_info;
+  const struct DamageLines *damage;
+  guint n_damage;
 };
 
 static void
@@ -1615,21 +1936,29 @@ static void
 blend_pads (struct CompositeTask *comp)
 {
   BlendFunction composite;
-  guint i;
+  guint i, j, start, end;
 
-  composite = comp->compositor->blend;
+  /* Only draw the damaged lines of this task's part of the output */
+  for (j = 0; j < comp->n_damage; j++) {
+    start = MAX (comp->damage[j].start, comp->dst_line_start);
+    end = MIN (comp->damage[j].end, comp->dst_line_end);
+    if (start >= end)
+      continue;
 
-  if (comp->draw_background) {
-    _draw_background (comp->compositor, comp->out_frame, comp->dst_line_start,
-        comp->dst_line_end, &composite);
-  }
+    composite = comp->compositor->blend;
+
+    if (comp->draw_background) {
+      _draw_background (comp->compositor, comp->out_frame, start, end,
+          &composite);
+    }
 
-  for (i = 0; i < comp->n_pads; i++) {
-    composite (comp->pads_info[i].prepared_frame,
-        comp->pads_info[i].pad->xpos + comp->pads_info[i].pad->x_offset,
-        comp->pads_info[i].pad->ypos + comp->pads_info[i].pad->y_offset,
-        comp->pads_info[i].pad->alpha, comp->out_frame, comp->dst_line_start,
-        comp->dst_line_end, comp->pads_info[i].blend_mode);
+    for (i = 0; i < comp->n_pads; i++) {
+      composite (comp->pads_info[i].prepared_frame,
+          comp->pads_info[i].pad->xpos + comp->pads_info[i].pad->x_offset,
+          comp->pads_info[i].pad->ypos + comp->pads_info[i].pad->y_offset,
+          comp->pads_info[i].pad->alpha, comp->out_frame, start, end,
+          comp->pads_info[i].blend_mode);
+    }
   }
 }
 
@@ -1642,7 +1971,9 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
   gboolean draw_background;
   guint drawn_a_pad = FALSE;
   struct CompositePadInfo *pads_info;
-  guint i, n_pads = 0;
+  struct DamageLines *damage;
+  guint i, n_pads = 0, n_damage = 0;
+  gboolean redraw_all = TRUE;
 
   if (!gst_video_frame_map (&out_frame, &vagg->info, outbuf, GST_MAP_WRITE)) {
     GST_WARNING_OBJECT (vagg, "Could not map output buffer");
@@ -1684,6 +2015,26 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
   if (n_pads == 0)
     draw_background = TRUE;
 
+  if (!compositor->damage_tracking && compositor->damage_valid)
+    _reset_damage (compositor);
+
+  /* Two ranges for each pad (old and new position), or the whole output */
+  damage = g_newa (struct DamageLines, 2 * n_pads + 1);
+  if (compositor->damage_tracking &&
+      _collect_damage (compositor, outframe, draw_background, damage,
+          &n_damage)) {
+    /* The intermediate frame still contains the last output, otherwise copy
+     * everything that did not change from the last output buffer */
+    redraw_all = !compositor->intermediate_frame &&
+        !_copy_undamaged_lines (compositor, outframe, damage, n_damage);
+    GST_LOG_OBJECT (vagg, "Redrawing %u damaged line ranges", n_damage);
+  }
+  if (redraw_all) {
+    damage[0].start = 0;
+    damage[0].end = GST_VIDEO_FRAME_HEIGHT (outframe);
+    n_damage = 1;
+  }
+
   pads_info = g_newa (struct CompositePadInfo, n_pads);
   n_pads = 0;
 
@@ -1716,7 +2067,13 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
        * will be composited on top of it. */
       if (!drawn_a_pad && !draw_background &&
           frames_can_copy (prepared_frame, outframe)) {
-        gst_video_frame_copy (outframe, prepared_frame);
+        if (redraw_all) {
+          gst_video_frame_copy (outframe, prepared_frame);
+        } else {
+          for (i = 0; i < n_damage; i++)
+            _copy_lines (outframe, prepared_frame, damage[i].start,
+                damage[i].end);
+        }
       } else {
         pads_info[n_pads].pad = compo_pad;
         pads_info[n_pads].prepared_frame = prepared_frame;
@@ -1747,6 +2104,8 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
       tasks[i].pads_info = pads_info;
       tasks[i].out_frame = outframe;
       tasks[i].draw_background = draw_background;
+      tasks[i].damage = damage;
+      tasks[i].n_damage = n_damage;
       /* This is a dumb split of the work by number of output lines.
        * If there is a section of the output that reads from a lot of source
        * pads, then that thread will consume more time. Maybe tracking and
@@ -1757,8 +2116,15 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
       tasks_p[i] = &tasks[i];
     }
 
-    gst_parallelized_task_runner_run (compositor->blend_runner,
-        (GstParallelizedTaskFunc) blend_pads, (gpointer *) tasks_p);
+    if (n_damage > 0)
+      gst_parallelized_task_runner_run (compositor->blend_runner,
+          (GstParallelizedTaskFunc) blend_pads, (gpointer *) tasks_p);
+  }
+
+  if (compositor->damage_tracking) {
+    compositor->damage_valid = TRUE;
+    if (!compositor->intermediate_frame)
+      gst_buffer_replace (&compositor->last_output, outbuf);
   }
 
   GST_OBJECT_UNLOCK (vagg);
@@ -1809,6 +2175,11 @@ gst_compositor_release_pad (GstElement * element, GstPad * pad)
 
   GST_DEBUG_OBJECT (compositor, "release pad %s:%s", GST_DEBUG_PAD_NAME (pad));
 
+  /* Whatever the pad drew has to be redrawn */
+  GST_OBJECT_LOCK (compositor);
+  _reset_damage (compositor);
+  GST_OBJECT_UNLOCK (compositor);
+
   gst_child_proxy_child_removed (GST_CHILD_PROXY (compositor), G_OBJECT (pad),
       GST_OBJECT_NAME (pad));
 
@@ -1939,6 +2310,9 @@ gst_compositor_finalize (GObject * object)
     gst_parallelized_task_runner_free (compositor->blend_runner);
   compositor->blend_runner = NULL;
 
+  gst_clear_buffer (&compositor->last_output);
+  g_ptr_array_unref (compositor->last_pads);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -2032,6 +2406,26 @@ gst_compositor_class_init (GstCompositorClass * klass)
           "Avoid timing out waiting for inactive pads", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * compositor:damage-tracking:
+   *
+   * Only redraw the output lines that changed since the previous output,
+   * based on which input buffers and pad properties changed, and copy the
+   * other lines from the previous output. This helps when most inputs are
+   * static or update at a lower framerate than the output.
+   *
+   * The previous output buffer is kept around for this, so it is not
+   * writable anymore for downstream elements and one more buffer of the
+   * output buffer pool is in use.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_DAMAGE_TRACKING,
+      g_param_spec_boolean ("damage-tracking", "Damage tracking",
+          "Only redraw the parts of the output that changed since the "
+          "previous output", DEFAULT_DAMAGE_TRACKING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_type_mark_as_plugin_api (GST_TYPE_COMPOSITOR_PAD, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_COMPOSITOR_OPERATOR, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_COMPOSITOR_BACKGROUND, 0);
@@ -2044,6 +2438,8 @@ gst_compositor_init (GstCompositor * self)
   self->background = DEFAULT_BACKGROUND;
   self->zero_size_is_unscaled = DEFAULT_ZERO_SIZE_IS_UNSCALED;
   self->max_threads = DEFAULT_MAX_THREADS;
+  self->damage_tracking = DEFAULT_DAMAGE_TRACKING;
+  self->last_pads = g_ptr_array_new ();
 }
 
 /* GstChildProxy implementation */
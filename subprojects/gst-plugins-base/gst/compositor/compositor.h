@@ -154,6 +154,18 @@ struct _GstCompositor
   GstVideoConverter *intermediate_convert;
 
   GstParallelizedTaskRunner *blend_runner;
+
+  /* Only redraw the output lines that changed since the last output */
+  gboolean damage_tracking;
+
+  /* State of the last output for damage tracking: whether it can be reused,
+   * the output buffer itself if not drawing into the intermediate frame,
+   * and the pads that were drawn on it in z-order */
+  gboolean damage_valid;
+  GstBuffer *last_output;
+  GPtrArray *last_pads;
+  gboolean last_draw_background;
+  GstCompositorBackground last_background;
 };
 
 /**
@@ -177,6 +189,14 @@ struct _GstCompositorPad
    * keep-aspect-ratio */
   gint x_offset;
   gint y_offset;
+
+  /* damage tracking: the state the pad was drawn with in the last output,
+   * and whether any property changed since then (atomic) */
+  GstBuffer *damage_buffer;
+  GstVideoRectangle damage_rect;
+  gdouble damage_alpha;
+  GstCompositorOperator damage_op;
+  gint damage_props_changed;
 };
 
 GST_ELEMENT_REGISTER_DECLARE (compositor);
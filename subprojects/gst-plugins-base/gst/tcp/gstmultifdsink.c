@@ -117,6 +117,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 
 #include "gsttcpelements.h"
@@ -303,7 +304,10 @@ gst_multi_fd_sink_class_init (GstMultiFdSinkClass * klass)
    *     is/was active (connect-duration), last activity time (in
    *     epoch seconds) (last-activity-time), number of buffers
    *     dropped (buffers-dropped), the timestamp of the first buffer
-   *     (first-buffer-ts) and of the last buffer (last-buffer-ts).
+   *     (first-buffer-ts) and of the last buffer (last-buffer-ts),
+   *     number of buffers sent (buffers-sent), number of write calls
+   *     (send-calls), number of zerocopy sends (zerocopy-sends) and of
+   *     sends the kernel had to copy anyway (zerocopy-copied).
    *     All times are expressed in nanoseconds (GstClockTime).  The
    *     structure can be empty if the client was not found.
    */
@@ -539,6 +543,7 @@ gst_multi_fd_sink_new_client (GstMultiHandleSink * mhsink,
   if (fstat (handle.fd, &statbuf) == 0 && S_ISSOCK (statbuf.st_mode)) {
     client->is_socket = TRUE;
     gst_multi_handle_sink_setup_dscp_client (mhsink, mhclient);
+    gst_multi_handle_sink_setup_zerocopy_client (mhsink, mhclient);
   }
 
   return mhclient;
@@ -661,8 +666,10 @@ ioctl_failed:
  *
  * Sending the buffers from the mhclient->sending queue is basically writing
  * the bytes to the socket and maintaining a count of the bytes that were
- * sent. When the buffer is completely sent, it is removed from the
- * mhclient->sending queue and we try to pick a new buffer for sending.
+ * sent. The pending buffers of the client are gathered and written with a
+ * single writev() or sendmsg() call. When a buffer is completely sent, it is
+ * removed from the mhclient->sending queue and we try to pick a new buffer
+ * for sending.
  *
  * When the sending returns a partial buffer we stop sending more data as
  * the next send operation could block.
@@ -675,10 +682,7 @@ gst_multi_fd_sink_handle_client_write (GstMultiFdSink * sink,
 {
   gboolean more;
   gboolean flushing;
-  GstClockTime now, now_monotonic;
   GstMultiHandleSink *mhsink = GST_MULTI_HANDLE_SINK (sink);
-  GstMultiHandleSinkClass *mhsinkclass =
-      GST_MULTI_HANDLE_SINK_GET_CLASS (mhsink);
   GstMultiHandleClient *mhclient = (GstMultiHandleClient *) client;
   int fd = mhclient->handle.fd;
 
@@ -686,11 +690,6 @@ gst_multi_fd_sink_handle_client_write (GstMultiFdSink * sink,
 
   more = TRUE;
   do {
-    gint maxsize;
-
-    now = g_get_real_time () * GST_USECOND;
-    now_monotonic = g_get_monotonic_time () * GST_USECOND;
-
     if (!mhclient->sending) {
       /* client is not working on a buffer */
       if (mhclient->bufpos == -1) {
@@ -706,8 +705,6 @@ gst_multi_fd_sink_handle_client_write (GstMultiFdSink * sink,
         return TRUE;
       } else {
         /* client can pick a buffer from the global queue */
-        GstBuffer *buf;
-        GstClockTime timestamp;
 
         /* for new connections, we need to find a good spot in the
          * bufqueue to start streaming from */
@@ -731,61 +728,63 @@ gst_multi_fd_sink_handle_client_write (GstMultiFdSink * sink,
         if (mhclient->flushcount == 0)
           goto flushed;
 
-        /* grab buffer */
-        buf = g_array_index (mhsink->bufqueue, GstBuffer *, mhclient->bufpos);
-        mhclient->bufpos--;
-
-        /* update stats */
-        timestamp = GST_BUFFER_TIMESTAMP (buf);
-        if (mhclient->first_buffer_ts == GST_CLOCK_TIME_NONE)
-          mhclient->first_buffer_ts = timestamp;
-        if (timestamp != -1)
-          mhclient->last_buffer_ts = timestamp;
-
-        /* decrease flushcount */
-        if (mhclient->flushcount != -1)
-          mhclient->flushcount--;
-
-        GST_LOG_OBJECT (sink, "%s client %p at position %d",
-            mhclient->debug, client, mhclient->bufpos);
-
-        /* queueing a buffer will ref it */
-        mhsinkclass->client_queue_buffer (mhsink, mhclient, buf);
-
-        /* need to start from the first byte for this new buffer */
-        mhclient->bufoffset = 0;
+        gst_multi_handle_sink_client_take_buffer (mhsink, mhclient);
       }
     }
 
     /* see if we need to send something */
     if (mhclient->sending) {
+      GOutputVector vectors[GST_MULTI_HANDLE_SINK_MAX_VECTORS];
+      GstMapInfo maps[GST_MULTI_HANDLE_SINK_MAX_VECTORS];
+      struct iovec iov[GST_MULTI_HANDLE_SINK_MAX_VECTORS];
+      gboolean zerocopy = FALSE;
       ssize_t wrote;
-      GstBuffer *head;
-      GstMapInfo info;
-      guint8 *data;
+      gsize maxsize;
+      gint i, n_vectors;
 
-      /* pick first buffer from list */
-      head = GST_BUFFER (mhclient->sending->data);
-
-      if (!gst_buffer_map (head, &info, GST_MAP_READ))
+      /* gather the pending buffers of the client */
+      n_vectors = gst_multi_handle_sink_client_map (mhsink, mhclient,
+          GST_MULTI_HANDLE_SINK_MAX_VECTORS, vectors, maps, &maxsize);
+      if (n_vectors < 0)
         g_return_val_if_reached (FALSE);
 
-      data = info.data;
-      maxsize = info.size - mhclient->bufoffset;
+      for (i = 0; i < n_vectors; i++) {
+        iov[i].iov_base = (gpointer) vectors[i].buffer;
+        iov[i].iov_len = vectors[i].size;
+      }
 
       /* FIXME: specific */
-      /* try to write the complete buffer */
+      /* try to write the complete batch */
 #ifdef MSG_NOSIGNAL
 #define FLAGS MSG_NOSIGNAL
 #else
 #define FLAGS 0
 #endif
       if (client->is_socket) {
-        wrote = send (fd, data + mhclient->bufoffset, maxsize, FLAGS);
+        struct msghdr msg = { 0, };
+        int flags = FLAGS;
+
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n_vectors;
+
+#ifdef MSG_ZEROCOPY
+        if (mhclient->zerocopy) {
+          zerocopy = TRUE;
+          flags |= MSG_ZEROCOPY;
+        }
+#endif
+        wrote = sendmsg (fd, &msg, flags);
+#ifdef MSG_ZEROCOPY
+        /* no memory left to pin the pages, send a copy this time */
+        if (wrote < 0 && zerocopy && errno == ENOBUFS) {
+          zerocopy = FALSE;
+          wrote = sendmsg (fd, &msg, FLAGS);
+        }
+#endif
       } else {
-        wrote = write (fd, data + mhclient->bufoffset, maxsize);
+        wrote = writev (fd, iov, n_vectors);
       }
-      gst_buffer_unmap (head, &info);
+      gst_multi_handle_sink_client_unmap (maps, n_vectors);
 
       if (wrote < 0) {
         /* hmm error.. */
@@ -798,26 +797,16 @@ gst_multi_fd_sink_handle_client_write (GstMultiFdSink * sink,
           goto write_error;
         }
       } else {
-        if (wrote < maxsize) {
+        if ((gsize) wrote < maxsize) {
           /* partial write means that the client cannot read more and we should
            * stop sending more */
           GST_LOG_OBJECT (sink,
               "partial write on %s of %" G_GSSIZE_FORMAT " bytes",
               mhclient->debug, wrote);
-          mhclient->bufoffset += wrote;
           more = FALSE;
-        } else {
-          /* complete buffer was written, we can proceed to the next one */
-          mhclient->sending = g_slist_remove (mhclient->sending, head);
-          gst_buffer_unref (head);
-          /* make sure we start from byte 0 for the next buffer */
-          mhclient->bufoffset = 0;
         }
-        /* update stats */
-        mhclient->bytes_sent += wrote;
-        mhclient->last_activity_time = now;
-        mhclient->last_activity_time_monotonic = now_monotonic;
-        mhsink->bytes_served += wrote;
+        /* drops the buffers that were sent completely and updates the stats */
+        gst_multi_handle_sink_client_sent (mhsink, mhclient, wrote, zerocopy);
       }
     }
   } while (more);
@@ -1019,10 +1008,15 @@ restart2:
       continue;
     }
     if (gst_poll_fd_has_error (sink->fdset, &client->gfd)) {
-      GST_WARNING_OBJECT (sink, "gst_poll_fd_has_error for %d", client->gfd.fd);
-      mhclient->status = GST_CLIENT_STATUS_ERROR;
-      gst_multi_handle_sink_remove_client_link (mhsink, clients);
-      continue;
+      /* zerocopy completions are signalled as errors too */
+      if (mhclient->zerocopy_seq == mhclient->zerocopy_completed ||
+          !gst_multi_handle_sink_client_zerocopy_complete (mhsink, mhclient)) {
+        GST_WARNING_OBJECT (sink, "gst_poll_fd_has_error for %d",
+            client->gfd.fd);
+        mhclient->status = GST_CLIENT_STATUS_ERROR;
+        gst_multi_handle_sink_remove_client_link (mhsink, clients);
+        continue;
+      }
     }
     if (gst_poll_fd_can_read (sink->fdset, &client->gfd)) {
       /* handle client read */
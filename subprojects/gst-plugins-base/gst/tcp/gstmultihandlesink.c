@@ -27,6 +27,7 @@
 #endif
 
 #include <glib/gi18n-lib.h>
+#include <gst/net/gstnetcontrolmessagemeta.h>
 
 #include "gstmultihandlesink.h"
 
@@ -38,6 +39,12 @@
 #include <netinet/in.h>
 #endif
 
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#include <linux/errqueue.h>
+#define HAVE_ZEROCOPY 1
+#endif
+
+#include <errno.h>
 #include <string.h>
 
 #define NOT_IMPLEMENTED 0
@@ -89,6 +96,11 @@ enum
 
 #define DEFAULT_RESEND_STREAMHEADER      TRUE
 
+#define DEFAULT_ZEROCOPY                FALSE
+
+/* the maximum number of bytes collected for one write to a client */
+#define MAX_BATCH_SIZE                  (256 * 1024)
+
 enum
 {
   PROP_0,
@@ -120,9 +132,19 @@ enum
 
   PROP_RESEND_STREAMHEADER,
 
-  PROP_NUM_HANDLES
+  PROP_NUM_HANDLES,
+
+  PROP_ZEROCOPY
 };
 
+/* a buffer that was sent with MSG_ZEROCOPY */
+typedef struct
+{
+  GstBuffer *buffer;
+  /* the last zerocopy send that used the buffer */
+  guint32 seq;
+} GstZerocopyBuffer;
+
 GType
 gst_multi_handle_sink_recover_policy_get_type (void)
 {
@@ -366,6 +388,25 @@ gst_multi_handle_sink_class_init (GstMultiHandleSinkClass * klass)
           "The current number of client handles",
           0, G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMultiHandleSink:zerocopy:
+   *
+   * Send to socket clients with MSG_ZEROCOPY, so that the kernel transmits
+   * directly from the buffer memory instead of copying it first. Sent buffers
+   * are kept until the kernel reports that it no longer uses them.
+   *
+   * This is only supported on Linux and only pays off for large buffers.
+   * Clients for which the kernel has to copy the data anyway, such as clients
+   * on the loopback interface, fall back to normal sends. Only applies to
+   * clients added after changing the property.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_ZEROCOPY,
+      g_param_spec_boolean ("zerocopy", "Zerocopy",
+          "Send to socket clients without copying the data (Linux only)",
+          DEFAULT_ZEROCOPY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstMultiHandleSink::clear:
    * @gstmultihandlesink: the multihandlesink element to emit this signal on
@@ -440,6 +481,8 @@ gst_multi_handle_sink_init (GstMultiHandleSink * this)
   this->qos_dscp = DEFAULT_QOS_DSCP;
 
   this->resend_streamheader = DEFAULT_RESEND_STREAMHEADER;
+
+  this->zerocopy = DEFAULT_ZEROCOPY;
 }
 
 static void
@@ -532,7 +575,15 @@ gst_multi_handle_sink_client_init (GstMultiHandleClient * client,
   client->flushcount = -1;
   client->bufoffset = 0;
   client->sending = NULL;
+  client->zerocopy = FALSE;
+  g_queue_init (&client->zerocopy_held);
+  client->zerocopy_seq = 0;
+  client->zerocopy_completed = 0;
   client->bytes_sent = 0;
+  client->buffers_sent = 0;
+  client->send_calls = 0;
+  client->zerocopy_sends = 0;
+  client->zerocopy_copied = 0;
   client->dropped_buffers = 0;
   client->avg_queue_size = 0;
   client->first_buffer_ts = GST_CLOCK_TIME_NONE;
@@ -551,6 +602,317 @@ gst_multi_handle_sink_client_init (GstMultiHandleClient * client,
   client->last_activity_time_monotonic = client->connect_time_monotonic;
 }
 
+/* enables MSG_ZEROCOPY for @client when requested and supported */
+void
+gst_multi_handle_sink_setup_zerocopy_client (GstMultiHandleSink * sink,
+    GstMultiHandleClient * client)
+{
+#ifdef HAVE_ZEROCOPY
+  GstMultiHandleSinkClass *mhsinkclass = GST_MULTI_HANDLE_SINK_GET_CLASS (sink);
+  int one = 1;
+  int fd;
+
+  client->zerocopy = FALSE;
+  if (!sink->zerocopy)
+    return;
+
+  fd = mhsinkclass->client_get_fd (client);
+  if (setsockopt (fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof (one)) < 0) {
+    GST_DEBUG_OBJECT (sink, "%s could not enable zerocopy: %s",
+        client->debug, g_strerror (errno));
+    return;
+  }
+  client->zerocopy = TRUE;
+#endif
+}
+
+/* moves the next buffer of the global queue to the sending queue of
+ * @client, bufpos must be >= 0 */
+void
+gst_multi_handle_sink_client_take_buffer (GstMultiHandleSink * sink,
+    GstMultiHandleClient * client)
+{
+  GstMultiHandleSinkClass *mhsinkclass = GST_MULTI_HANDLE_SINK_GET_CLASS (sink);
+  gboolean was_sending = client->sending != NULL;
+  GstClockTime timestamp;
+  GstBuffer *buf;
+
+  /* grab buffer */
+  buf = g_array_index (sink->bufqueue, GstBuffer *, client->bufpos);
+  client->bufpos--;
+
+  /* update stats */
+  timestamp = GST_BUFFER_TIMESTAMP (buf);
+  if (client->first_buffer_ts == GST_CLOCK_TIME_NONE)
+    client->first_buffer_ts = timestamp;
+  if (timestamp != -1)
+    client->last_buffer_ts = timestamp;
+
+  /* decrease flushcount */
+  if (client->flushcount != -1)
+    client->flushcount--;
+
+  GST_LOG_OBJECT (sink, "%s client %p at position %d",
+      client->debug, client, client->bufpos);
+
+  /* queueing a buffer will ref it */
+  mhsinkclass->client_queue_buffer (sink, client, buf);
+
+  /* need to start from the first byte for this new buffer */
+  if (!was_sending)
+    client->bufoffset = 0;
+}
+
+/*
+ * gst_multi_handle_sink_client_map:
+ * @sink: a #GstMultiHandleSink
+ * @client: the client to send to
+ * @max_buffers: the maximum number of buffers to send
+ * @vectors: (out): GST_MULTI_HANDLE_SINK_MAX_VECTORS vectors
+ * @maps: (out): GST_MULTI_HANDLE_SINK_MAX_VECTORS map infos
+ * @size: (out): the total size of the vectors
+ *
+ * Maps the data that @client still has to send so that it can be written with
+ * a single call. When @max_buffers is more than 1, buffers from the global
+ * queue that the client did not pick up yet are added to its sending queue
+ * first, up to MAX_BATCH_SIZE bytes. Buffers with control messages are only
+ * included as the first buffer.
+ *
+ * Returns: the number of vectors, unmap them with
+ *     gst_multi_handle_sink_client_unmap(). -1 if the memory could not be
+ *     mapped.
+ */
+gint
+gst_multi_handle_sink_client_map (GstMultiHandleSink * sink,
+    GstMultiHandleClient * client, guint max_buffers,
+    GOutputVector * vectors, GstMapInfo * maps, gsize * size)
+{
+  GSList *walk;
+  gsize offset = client->bufoffset, total = 0;
+  guint n_vectors = 0, n_buffers = 0;
+
+  if (max_buffers > 1) {
+    gsize queued = 0;
+
+    for (walk = client->sending; walk; walk = walk->next) {
+      queued += gst_buffer_get_size (walk->data);
+      n_buffers++;
+    }
+    queued -= client->bufoffset;
+
+    /* batch up the buffers that are already available for this client */
+    while (n_buffers < max_buffers && queued < MAX_BATCH_SIZE &&
+        client->bufpos >= 0 && client->flushcount != 0 &&
+        !client->new_connection) {
+      GstBuffer *buf =
+          g_array_index (sink->bufqueue, GstBuffer *, client->bufpos);
+
+      queued += gst_buffer_get_size (buf);
+      n_buffers++;
+      gst_multi_handle_sink_client_take_buffer (sink, client);
+    }
+    n_buffers = 0;
+  }
+
+  for (walk = client->sending; walk && n_buffers < max_buffers;
+      walk = walk->next) {
+    GstBuffer *buf = walk->data;
+    guint i, n_mem = gst_buffer_n_memory (buf);
+
+    /* control messages can only be sent along with the first buffer */
+    if (n_buffers > 0 && gst_buffer_get_meta (buf,
+            GST_NET_CONTROL_MESSAGE_META_API_TYPE))
+      break;
+
+    for (i = 0; i < n_mem && n_vectors < GST_MULTI_HANDLE_SINK_MAX_VECTORS;
+        i++) {
+      GstMemory *mem = gst_buffer_peek_memory (buf, i);
+
+      /* already sent */
+      if (offset >= mem->size) {
+        offset -= mem->size;
+        continue;
+      }
+
+      if (!gst_memory_map (mem, &maps[n_vectors], GST_MAP_READ))
+        goto map_failed;
+
+      vectors[n_vectors].buffer = maps[n_vectors].data + offset;
+      vectors[n_vectors].size = maps[n_vectors].size - offset;
+      total += vectors[n_vectors].size;
+      n_vectors++;
+      offset = 0;
+    }
+    if (n_vectors == GST_MULTI_HANDLE_SINK_MAX_VECTORS)
+      break;
+
+    n_buffers++;
+  }
+
+  *size = total;
+
+  return n_vectors;
+
+  /* ERRORS */
+map_failed:
+  {
+    GST_WARNING_OBJECT (sink, "%s could not map memory", client->debug);
+    gst_multi_handle_sink_client_unmap (maps, n_vectors);
+    return -1;
+  }
+}
+
+void
+gst_multi_handle_sink_client_unmap (GstMapInfo * maps, guint n_maps)
+{
+  guint i;
+
+  for (i = 0; i < n_maps; i++)
+    gst_memory_unmap (maps[i].memory, &maps[i]);
+}
+
+/*
+ * gst_multi_handle_sink_client_sent:
+ * @sink: a #GstMultiHandleSink
+ * @client: the client that was sent to
+ * @wrote: the number of bytes that were written
+ * @zerocopy: if the data was sent with MSG_ZEROCOPY
+ *
+ * Removes the buffers that were completely sent from the sending queue of
+ * @client and updates the statistics. Buffers that the kernel might still
+ * read from are kept until gst_multi_handle_sink_client_zerocopy_complete()
+ * releases them.
+ */
+void
+gst_multi_handle_sink_client_sent (GstMultiHandleSink * sink,
+    GstMultiHandleClient * client, gsize wrote, gboolean zerocopy)
+{
+  gsize left = wrote;
+
+  if (zerocopy) {
+    client->zerocopy_seq++;
+    client->zerocopy_sends++;
+  }
+
+  while (client->sending) {
+    GstBuffer *head = client->sending->data;
+    gsize size = gst_buffer_get_size (head) - client->bufoffset;
+
+    if (left < size) {
+      client->bufoffset += left;
+      break;
+    }
+
+    /* complete buffer was written, we can proceed to the next one */
+    left -= size;
+    client->sending = g_slist_delete_link (client->sending, client->sending);
+    client->bufoffset = 0;
+    client->buffers_sent++;
+
+    if (client->zerocopy_seq != client->zerocopy_completed) {
+      GstZerocopyBuffer *held = g_new (GstZerocopyBuffer, 1);
+
+      held->buffer = head;
+      held->seq = client->zerocopy_seq - 1;
+      g_queue_push_tail (&client->zerocopy_held, held);
+    } else {
+      gst_buffer_unref (head);
+    }
+  }
+
+  /* update stats */
+  client->send_calls++;
+  client->bytes_sent += wrote;
+  client->last_activity_time = g_get_real_time () * GST_USECOND;
+  client->last_activity_time_monotonic = g_get_monotonic_time () * GST_USECOND;
+  sink->bytes_served += wrote;
+}
+
+static void
+gst_multi_handle_sink_client_release_held (GstMultiHandleClient * client,
+    gboolean all)
+{
+  GstZerocopyBuffer *held;
+
+  while ((held = g_queue_peek_head (&client->zerocopy_held))) {
+    if (!all && (gint32) (held->seq - client->zerocopy_completed) >= 0)
+      break;
+
+    g_queue_pop_head (&client->zerocopy_held);
+    gst_buffer_unref (held->buffer);
+    g_free (held);
+  }
+}
+
+/*
+ * gst_multi_handle_sink_client_zerocopy_complete:
+ * @sink: a #GstMultiHandleSink
+ * @client: a client with zerocopy enabled
+ *
+ * Reads the zerocopy completions from the error queue of the socket of
+ * @client and releases the buffers the kernel no longer uses. Call this when
+ * the socket has an error condition.
+ *
+ * Returns: %FALSE if the error queue contained a real error, errno is set then.
+ */
+gboolean
+gst_multi_handle_sink_client_zerocopy_complete (GstMultiHandleSink * sink,
+    GstMultiHandleClient * client)
+{
+#ifdef HAVE_ZEROCOPY
+  GstMultiHandleSinkClass *mhsinkclass = GST_MULTI_HANDLE_SINK_GET_CLASS (sink);
+  int fd = mhsinkclass->client_get_fd (client);
+
+  while (TRUE) {
+    struct msghdr msg = { 0, };
+    struct cmsghdr *cm;
+    gchar control[128];
+
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof (control);
+
+    if (recvmsg (fd, &msg, MSG_ERRQUEUE) < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+      return FALSE;
+    }
+
+    for (cm = CMSG_FIRSTHDR (&msg); cm; cm = CMSG_NXTHDR (&msg, cm)) {
+      struct sock_extended_err *serr;
+
+      if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+          !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+        continue;
+
+      serr = (struct sock_extended_err *) CMSG_DATA (cm);
+      if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0) {
+        errno = serr->ee_errno;
+        return FALSE;
+      }
+
+      /* the sends ee_info to ee_data are done */
+      if ((gint32) (serr->ee_data + 1 - client->zerocopy_completed) > 0)
+        client->zerocopy_completed = serr->ee_data + 1;
+
+      if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+        client->zerocopy_copied += serr->ee_data - serr->ee_info + 1;
+        if (client->zerocopy) {
+          GST_DEBUG_OBJECT (sink, "%s data was copied, disabling zerocopy",
+              client->debug);
+          client->zerocopy = FALSE;
+        }
+      }
+    }
+  }
+
+  gst_multi_handle_sink_client_release_held (client, FALSE);
+#endif
+
+  return TRUE;
+}
+
 static void
 gst_multi_handle_sink_setup_dscp (GstMultiHandleSink * mhsink)
 {
@@ -831,7 +1193,11 @@ gst_multi_handle_sink_get_stats (GstMultiHandleSink * sink,
         mhclient->last_activity_time_monotonic, "buffers-dropped",
         G_TYPE_UINT64, mhclient->dropped_buffers, "first-buffer-ts",
         G_TYPE_UINT64, mhclient->first_buffer_ts, "last-buffer-ts",
-        G_TYPE_UINT64, mhclient->last_buffer_ts, NULL);
+        G_TYPE_UINT64, mhclient->last_buffer_ts, "buffers-sent", G_TYPE_UINT64,
+        mhclient->buffers_sent, "send-calls", G_TYPE_UINT64,
+        mhclient->send_calls, "zerocopy-sends", G_TYPE_UINT64,
+        mhclient->zerocopy_sends, "zerocopy-copied", G_TYPE_UINT64,
+        mhclient->zerocopy_copied, NULL);
   }
 
 noclient:
@@ -907,6 +1273,7 @@ gst_multi_handle_sink_remove_client_link (GstMultiHandleSink * sink,
   g_slist_foreach (mhclient->sending, (GFunc) gst_mini_object_unref, NULL);
   g_slist_free (mhclient->sending);
   mhclient->sending = NULL;
+  gst_multi_handle_sink_client_release_held (mhclient, TRUE);
 
   if (mhclient->caps)
     gst_caps_unref (mhclient->caps);
@@ -1982,6 +2349,9 @@ gst_multi_handle_sink_set_property (GObject * object, guint prop_id,
     case PROP_RESEND_STREAMHEADER:
       multihandlesink->resend_streamheader = g_value_get_boolean (value);
       break;
+    case PROP_ZEROCOPY:
+      multihandlesink->zerocopy = g_value_get_boolean (value);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -2062,6 +2432,9 @@ gst_multi_handle_sink_get_property (GObject * object, guint prop_id,
       g_value_set_uint (value,
           g_hash_table_size (multihandlesink->handle_hash));
       break;
+    case PROP_ZEROCOPY:
+      g_value_set_boolean (value, multihandlesink->zerocopy);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
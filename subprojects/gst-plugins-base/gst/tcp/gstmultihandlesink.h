@@ -145,6 +145,11 @@ typedef struct {
   GSList *sending;              /* the buffers we need to send */
   gint bufoffset;               /* offset in the first buffer */
 
+  gboolean zerocopy;            /* send with MSG_ZEROCOPY */
+  GQueue zerocopy_held;         /* sent buffers the kernel might still use */
+  guint32 zerocopy_seq;         /* number of zerocopy sends */
+  guint32 zerocopy_completed;   /* number of completed zerocopy sends */
+
   gboolean discont;
 
   gboolean new_connection;
@@ -162,6 +167,10 @@ typedef struct {
 
   /* stats */
   guint64 bytes_sent;
+  guint64 buffers_sent;
+  guint64 send_calls;
+  guint64 zerocopy_sends;
+  guint64 zerocopy_copied;
   guint64 connect_time;
   guint64 connect_time_monotonic;
   guint64 disconnect_time;
@@ -179,11 +188,26 @@ typedef struct {
 #define CLIENTS_LOCK(mhsink)            (g_rec_mutex_lock(&(mhsink)->clientslock))
 #define CLIENTS_UNLOCK(mhsink)          (g_rec_mutex_unlock(&(mhsink)->clientslock))
 
+/* the maximum number of memory blocks written with one call */
+#define GST_MULTI_HANDLE_SINK_MAX_VECTORS 64
+
 gint gst_multi_handle_sink_setup_dscp_client (GstMultiHandleSink * sink, GstMultiHandleClient * client);
+void gst_multi_handle_sink_setup_zerocopy_client (GstMultiHandleSink * sink, GstMultiHandleClient * client);
 gint
 gst_multi_handle_sink_new_client_position (GstMultiHandleSink * sink,
     GstMultiHandleClient * client);
 
+void gst_multi_handle_sink_client_take_buffer (GstMultiHandleSink * sink,
+    GstMultiHandleClient * client);
+gint gst_multi_handle_sink_client_map (GstMultiHandleSink * sink,
+    GstMultiHandleClient * client, guint max_buffers,
+    GOutputVector * vectors, GstMapInfo * maps, gsize * size);
+void gst_multi_handle_sink_client_unmap (GstMapInfo * maps, guint n_maps);
+void gst_multi_handle_sink_client_sent (GstMultiHandleSink * sink,
+    GstMultiHandleClient * client, gsize wrote, gboolean zerocopy);
+gboolean gst_multi_handle_sink_client_zerocopy_complete (GstMultiHandleSink * sink,
+    GstMultiHandleClient * client);
+
 /**
  * GstMultiHandleSink:
  *
@@ -233,6 +257,8 @@ struct _GstMultiHandleSink {
 
   gboolean resend_streamheader; /* resend streamheader if it changes */
 
+  gboolean zerocopy;    /* send with MSG_ZEROCOPY where possible */
+
   /* stats */
   gint buffers_queued;  /* number of queued buffers */
   gint bytes_queued;    /* number of queued bytes */
@@ -111,6 +111,10 @@
 #include "gstmultisocketsink.h"
 #include "gsttcpelements.h"
 
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
 #ifndef G_OS_WIN32
 #include <netinet/in.h>
 #endif
@@ -334,7 +338,10 @@ gst_multi_socket_sink_class_init (GstMultiSocketSinkClass * klass)
    *     values that represent: total number of bytes sent, time
    *     when the client was added, time when the client was
    *     disconnected/removed, time the client is/was active, last activity
-   *     time (in epoch seconds), number of buffers dropped.
+   *     time (in epoch seconds), number of buffers dropped, number of
+   *     buffers sent (buffers-sent), number of send calls (send-calls),
+   *     number of zerocopy sends (zerocopy-sends) and of sends the kernel
+   *     had to copy anyway (zerocopy-copied).
    *     All times are expressed in nanoseconds (GstClockTime).
    */
   gst_multi_socket_sink_signals[SIGNAL_GET_STATS] =
@@ -562,6 +569,7 @@ gst_multi_socket_sink_new_client (GstMultiHandleSink * mhsink,
   mhsinkclass->hash_adding (mhsink, mhclient);
 
   gst_multi_handle_sink_setup_dscp_client (mhsink, mhclient);
+  gst_multi_handle_sink_setup_zerocopy_client (mhsink, mhclient);
 
   return mhclient;
 }
@@ -683,78 +691,6 @@ gst_multi_socket_sink_handle_client_read (GstMultiSocketSink * sink,
   return ret;
 }
 
-/**
- * map_memory_output_vector_n:
- * @buf: The #GstBuffer that should be mapped
- * @offset: Offset into the buffer that should be mapped
- * @vectors: (out,array length=num_vectors): an array of #GOutputVector structs to write into
- * @mapinfo: (out,array length=num_vectors): an array of #GstMapInfo structs to write into
- * @num_vectors: the number of elements in @vectors to prevent buffer overruns
- *
- * Maps a buffer into memory, populating a #GOutputVector to use scatter-gather
- * I/O to send the data over a socket.  The whole buffer won't be mapped into
- * memory if it consists of more than @num_vectors #GstMemory s.
- *
- * Use #unmap_n_memorys after you are
- * finished with the mappings.
- *
- * Returns: The number of GstMemorys mapped
- */
-static int
-map_n_memory_output_vector (GstBuffer * buf, size_t offset,
-    GOutputVector * vectors, GstMapInfo * mapinfo, int num_vectors)
-{
-  guint mem_idx, mem_len;
-  gsize mem_skip;
-  size_t maxsize;
-  int i;
-
-  g_return_val_if_fail (num_vectors > 0, 0);
-  memset (vectors, 0, sizeof (GOutputVector) * num_vectors);
-
-  maxsize = gst_buffer_get_size (buf) - offset;
-  if (!gst_buffer_find_memory (buf, offset, maxsize, &mem_idx, &mem_len,
-          &mem_skip))
-    g_error ("Unable to map memory at offset %" G_GSIZE_FORMAT ", buffer "
-        "length is %" G_GSIZE_FORMAT, offset, gst_buffer_get_size (buf));
-
-  for (i = 0; i < mem_len && i < num_vectors; i++) {
-    GstMapInfo map = { 0 };
-    GstMemory *mem = gst_buffer_peek_memory (buf, mem_idx + i);
-    if (!gst_memory_map (mem, &map, GST_MAP_READ))
-      g_error ("Unable to map memory %p.  This should never happen.", mem);
-
-    if (i == 0) {
-      vectors[i].buffer = map.data + mem_skip;
-      vectors[i].size = map.size - mem_skip;
-    } else {
-      vectors[i].buffer = map.data;
-      vectors[i].size = map.size;
-    }
-    mapinfo[i] = map;
-  }
-  return i;
-}
-
-/**
- * map_n_memory_output_vector:
- * @buf: The #GstBuffer that should be mapped
- * @offset: Offset into the buffer that should be mapped
- * @vectors: (out,array length=num_vectors): an array of #GOutputVector structs to write into
- * @num_vectors: the number of elements in @vectors to prevent buffer overruns
- *
- * Returns: The number of GstMemorys mapped
- */
-static void
-unmap_n_memorys (GstMapInfo * mapinfo, int num_mappings)
-{
-  int i;
-  g_return_if_fail (num_mappings > 0);
-
-  for (i = 0; i < num_mappings; i++)
-    gst_memory_unmap (mapinfo[i].memory, &mapinfo[i]);
-}
-
 static gsize
 gst_buffer_get_cmsg_list (GstBuffer * buf, GSocketControlMessage ** msgs,
     gsize msg_space)
@@ -774,26 +710,59 @@ gst_buffer_get_cmsg_list (GstBuffer * buf, GSocketControlMessage ** msgs,
 
 #define CMSG_MAX 255
 
+/* sends the pending data of @client with a single call. With send-dispatched
+ * every buffer is sent on its own so that the dispatched event can be pushed
+ * for it. */
 static gssize
 gst_multi_socket_sink_write (GstMultiSocketSink * sink,
-    GSocket * sock, GstBuffer * buffer, gsize bufoffset,
+    GstMultiHandleClient * client, gsize * maxsize, gboolean * zerocopy,
     GCancellable * cancellable, GError ** err)
 {
-  GstMapInfo maps[8];
-  GOutputVector vec[8];
-  guint mems_mapped;
-  gssize wrote;
+  GstMultiHandleSink *mhsink = GST_MULTI_HANDLE_SINK (sink);
+  GstMapInfo maps[GST_MULTI_HANDLE_SINK_MAX_VECTORS];
+  GOutputVector vec[GST_MULTI_HANDLE_SINK_MAX_VECTORS];
   GSocketControlMessage *cmsgs[CMSG_MAX];
+  GstBuffer *head = GST_BUFFER (client->sending->data);
+  gint n_vectors;
+  gssize wrote;
   gsize msg_count;
+  gint flags = 0;
+
+  n_vectors = gst_multi_handle_sink_client_map (mhsink, client,
+      sink->send_dispatched ? 1 : GST_MULTI_HANDLE_SINK_MAX_VECTORS, vec, maps,
+      maxsize);
+  if (n_vectors < 0) {
+    g_set_error (err, G_IO_ERROR, G_IO_ERROR_FAILED,
+        "Unable to map memory of buffer %p", head);
+    return -1;
+  }
 
-  mems_mapped = map_n_memory_output_vector (buffer, bufoffset, vec, maps, 8);
+  msg_count = gst_buffer_get_cmsg_list (head, cmsgs, CMSG_MAX);
 
-  msg_count = gst_buffer_get_cmsg_list (buffer, cmsgs, CMSG_MAX);
+  *zerocopy = FALSE;
+#ifdef MSG_ZEROCOPY
+  if (client->zerocopy) {
+    *zerocopy = TRUE;
+    flags |= MSG_ZEROCOPY;
+  }
+#endif
 
   wrote =
-      g_socket_send_message (sock, NULL, vec, mems_mapped, cmsgs, msg_count, 0,
-      cancellable, err);
-  unmap_n_memorys (maps, mems_mapped);
+      g_socket_send_message (client->handle.socket, NULL, vec, n_vectors,
+      cmsgs, msg_count, flags, cancellable, err);
+
+  /* the pages could not be pinned, send a copy this time */
+  if (wrote < 0 && *zerocopy
+      && !g_error_matches (*err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)
+      && !g_error_matches (*err, G_IO_ERROR, G_IO_ERROR_CLOSED)) {
+    g_clear_error (err);
+    *zerocopy = FALSE;
+    wrote =
+        g_socket_send_message (client->handle.socket, NULL, vec, n_vectors,
+        cmsgs, msg_count, 0, cancellable, err);
+  }
+  gst_multi_handle_sink_client_unmap (maps, n_vectors);
+
   return wrote;
 }
 
@@ -811,7 +780,8 @@ gst_multi_socket_sink_write (GstMultiSocketSink * sink,
  *
  * Sending the buffers from the mhclient->sending queue is basically writing
  * the bytes to the socket and maintaining a count of the bytes that were
- * sent. When the buffer is completely sent, it is removed from the
+ * sent. The pending buffers of the client are gathered and sent with a single
+ * call. When a buffer is completely sent, it is removed from the
  * mhclient->sending queue and we try to pick a new buffer for sending.
  *
  * When the sending returns a partial buffer we stop sending more data as
@@ -825,16 +795,9 @@ gst_multi_socket_sink_handle_client_write (GstMultiSocketSink * sink,
 {
   gboolean more;
   gboolean flushing;
-  GstClockTime now, now_monotonic;
   GError *err = NULL;
   GstMultiHandleSink *mhsink = GST_MULTI_HANDLE_SINK (sink);
   GstMultiHandleClient *mhclient = (GstMultiHandleClient *) client;
-  GstMultiHandleSinkClass *mhsinkclass =
-      GST_MULTI_HANDLE_SINK_GET_CLASS (mhsink);
-
-
-  now = g_get_real_time () * GST_USECOND;
-  now_monotonic = g_get_monotonic_time () * GST_USECOND;
 
   flushing = mhclient->status == GST_CLIENT_STATUS_FLUSHING;
 
@@ -854,8 +817,6 @@ gst_multi_socket_sink_handle_client_write (GstMultiSocketSink * sink,
         return TRUE;
       } else {
         /* client can pick a buffer from the global queue */
-        GstBuffer *buf;
-        GstClockTime timestamp;
 
         /* for new connections, we need to find a good spot in the
          * bufqueue to start streaming from */
@@ -878,42 +839,18 @@ gst_multi_socket_sink_handle_client_write (GstMultiSocketSink * sink,
         if (mhclient->flushcount == 0)
           goto flushed;
 
-        /* grab buffer */
-        buf = g_array_index (mhsink->bufqueue, GstBuffer *, mhclient->bufpos);
-        mhclient->bufpos--;
-
-        /* update stats */
-        timestamp = GST_BUFFER_TIMESTAMP (buf);
-        if (mhclient->first_buffer_ts == GST_CLOCK_TIME_NONE)
-          mhclient->first_buffer_ts = timestamp;
-        if (timestamp != -1)
-          mhclient->last_buffer_ts = timestamp;
-
-        /* decrease flushcount */
-        if (mhclient->flushcount != -1)
-          mhclient->flushcount--;
-
-        GST_LOG_OBJECT (sink, "%s client %p at position %d",
-            mhclient->debug, client, mhclient->bufpos);
-
-        /* queueing a buffer will ref it */
-        mhsinkclass->client_queue_buffer (mhsink, mhclient, buf);
-
-        /* need to start from the first byte for this new buffer */
-        mhclient->bufoffset = 0;
+        gst_multi_handle_sink_client_take_buffer (mhsink, mhclient);
       }
     }
 
     /* see if we need to send something */
     if (mhclient->sending) {
       gssize wrote;
-      GstBuffer *head;
-
-      /* pick first buffer from list */
-      head = GST_BUFFER (mhclient->sending->data);
+      gsize maxsize;
+      gboolean zerocopy;
 
-      wrote = gst_multi_socket_sink_write (sink, mhclient->handle.socket, head,
-          mhclient->bufoffset, sink->cancellable, &err);
+      wrote = gst_multi_socket_sink_write (sink, mhclient, &maxsize, &zerocopy,
+          sink->cancellable, &err);
 
       if (wrote < 0) {
         /* hmm error.. */
@@ -929,31 +866,22 @@ gst_multi_socket_sink_handle_client_write (GstMultiSocketSink * sink,
           goto write_error;
         }
       } else {
-        if (wrote < (gst_buffer_get_size (head) - mhclient->bufoffset)) {
+        if ((gsize) wrote < maxsize) {
           /* partial write, try again now */
           GST_LOG_OBJECT (sink,
               "partial write on %p of %" G_GSSIZE_FORMAT " bytes",
               mhclient->handle.socket, wrote);
-          mhclient->bufoffset += wrote;
-        } else {
-          if (sink->send_dispatched) {
-            gst_pad_push_event (GST_BASE_SINK_PAD (mhsink),
-                gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
-                    gst_structure_new ("GstNetworkMessageDispatched",
-                        "object", G_TYPE_OBJECT, mhclient->handle.socket,
-                        "buffer", GST_TYPE_BUFFER, head, NULL)));
-          }
-          /* complete buffer was written, we can proceed to the next one */
-          mhclient->sending = g_slist_remove (mhclient->sending, head);
-          gst_buffer_unref (head);
-          /* make sure we start from byte 0 for the next buffer */
-          mhclient->bufoffset = 0;
+        } else if (sink->send_dispatched) {
+          /* only the head buffer was sent */
+          gst_pad_push_event (GST_BASE_SINK_PAD (mhsink),
+              gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+                  gst_structure_new ("GstNetworkMessageDispatched",
+                      "object", G_TYPE_OBJECT, mhclient->handle.socket,
+                      "buffer", GST_TYPE_BUFFER, mhclient->sending->data,
+                      NULL)));
         }
-        /* update stats */
-        mhclient->bytes_sent += wrote;
-        mhclient->last_activity_time = now;
-        mhclient->last_activity_time_monotonic = now_monotonic;
-        mhsink->bytes_served += wrote;
+        /* drops the buffers that were sent completely and updates the stats */
+        gst_multi_handle_sink_client_sent (mhsink, mhclient, wrote, zerocopy);
       }
     }
   } while (more);
@@ -1075,6 +1003,12 @@ gst_multi_socket_sink_socket_condition (GstMultiSinkHandle handle,
     goto done;
   }
 
+  /* zerocopy completions are signalled as errors too */
+  if ((condition & G_IO_ERR) &&
+      mhclient->zerocopy_seq != mhclient->zerocopy_completed &&
+      gst_multi_handle_sink_client_zerocopy_complete (mhsink, mhclient))
+    condition &= ~G_IO_ERR;
+
   if ((condition & G_IO_ERR)) {
     GST_WARNING_OBJECT (sink, "%s has error", mhclient->debug);
     mhclient->status = GST_CLIENT_STATUS_ERROR;
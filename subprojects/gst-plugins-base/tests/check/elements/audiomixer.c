@@ -2220,6 +2220,154 @@ GST_START_TEST (test_qos_message_live)
 
 GST_END_TEST;
 
+#define MIX_PADS_SAMPLES 4800
+
+static gint16
+mix_pads_sample (guint pad, guint sample)
+{
+  return (pad * 37 + sample * 11) % 512 - 256;
+}
+
+/* Mixes 100ms of S16 mono from @n_pads pads, of which the first @n_muted
+ * are muted and the next @n_gap only push GAP buffers */
+static GstBuffer *
+mix_pads (guint max_threads, guint n_pads, guint n_muted, guint n_gap,
+    GstStructure ** stats)
+{
+  static const char *caps_str = "audio/x-raw, format=(string)S16LE, "
+      "rate=(int)48000, channels=(int)1, layout=(string)interleaved";
+  GstHarness **h = g_new0 (GstHarness *, n_pads);
+  GstBuffer *outbuf;
+  guint i, j;
+
+  h[0] = gst_harness_new_with_padnames ("audiomixer", "sink_0", "src");
+  g_object_set (h[0]->element, "output-buffer-duration", 100 * GST_MSECOND,
+      "max-threads", max_threads, NULL);
+  for (i = 1; i < n_pads; i++) {
+    gchar *name = g_strdup_printf ("sink_%u", i);
+
+    h[i] = gst_harness_new_with_element (h[0]->element, name, NULL);
+    g_free (name);
+  }
+
+  for (i = 0; i < n_pads; i++) {
+    gst_harness_play (h[i]);
+    if (i == 0)
+      gst_harness_set_caps_str (h[i], caps_str, caps_str);
+    else
+      gst_harness_set_src_caps_str (h[i], caps_str);
+
+    if (i < n_muted) {
+      GstPad *pad = gst_pad_get_peer (h[i]->srcpad);
+
+      g_object_set (pad, "mute", TRUE, NULL);
+      gst_object_unref (pad);
+    }
+  }
+
+  for (i = 0; i < n_pads; i++) {
+    GstBuffer *buf;
+
+    if (i >= n_muted && i < n_muted + n_gap) {
+      buf = new_buffer (MIX_PADS_SAMPLES * 2, 0, 0, 100 * GST_MSECOND,
+          GST_BUFFER_FLAG_GAP);
+    } else {
+      GstMapInfo map;
+      gint16 *data;
+
+      buf = new_buffer (MIX_PADS_SAMPLES * 2, 0, 0, 100 * GST_MSECOND, 0);
+      gst_buffer_map (buf, &map, GST_MAP_WRITE);
+      data = (gint16 *) map.data;
+      for (j = 0; j < MIX_PADS_SAMPLES; j++)
+        data[j] = GINT16_TO_LE (mix_pads_sample (i, j));
+      gst_buffer_unmap (buf, &map);
+    }
+    fail_unless_equals_int (gst_harness_push (h[i], buf), GST_FLOW_OK);
+  }
+
+  outbuf = gst_harness_pull (h[0]);
+  fail_unless (outbuf != NULL);
+  fail_unless_equals_int (gst_buffer_get_size (outbuf), MIX_PADS_SAMPLES * 2);
+
+  if (stats)
+    g_object_get (h[0]->element, "stats", stats, NULL);
+
+  for (i = n_pads; i > 0; i--)
+    gst_harness_teardown (h[i - 1]);
+  g_free (h);
+
+  return outbuf;
+}
+
+GST_START_TEST (test_many_pads_threads)
+{
+  GstBuffer *single, *threaded;
+  GstMapInfo map;
+  const gint16 *data;
+  guint i, j;
+
+  single = mix_pads (1, 64, 0, 0, NULL);
+  threaded = mix_pads (4, 64, 0, 0, NULL);
+
+  gst_buffer_map (single, &map, GST_MAP_READ);
+
+  /* splitting the output between threads must not change the result */
+  fail_unless (gst_buffer_memcmp (threaded, 0, map.data, map.size) == 0);
+
+  data = (const gint16 *) map.data;
+  for (j = 0; j < MIX_PADS_SAMPLES; j++) {
+    gint expected = 0;
+
+    for (i = 0; i < 64; i++)
+      expected += mix_pads_sample (i, j);
+    fail_unless_equals_int (GINT16_FROM_LE (data[j]), expected);
+  }
+  gst_buffer_unmap (single, &map);
+
+  gst_buffer_unref (single);
+  gst_buffer_unref (threaded);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_many_pads_stats)
+{
+  GstStructure *stats = NULL;
+  GstBuffer *outbuf;
+  GstMapInfo map;
+  const gint16 *data;
+  guint64 cycles;
+  guint mixed, skipped, max_mixed;
+  guint i, j;
+
+  /* 2 muted pads, 3 pads with GAP buffers and 5 pads that are mixed */
+  outbuf = mix_pads (1, 10, 2, 3, &stats);
+
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get (stats, "cycles", G_TYPE_UINT64, &cycles,
+          "mixed-pads", G_TYPE_UINT, &mixed, "skipped-pads", G_TYPE_UINT,
+          &skipped, "max-mixed-pads", G_TYPE_UINT, &max_mixed, NULL));
+  fail_unless_equals_uint64 (cycles, 1);
+  fail_unless_equals_int (mixed, 5);
+  fail_unless_equals_int (skipped, 2);
+  fail_unless_equals_int (max_mixed, 5);
+  gst_structure_free (stats);
+
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  data = (const gint16 *) map.data;
+  for (j = 0; j < MIX_PADS_SAMPLES; j++) {
+    gint expected = 0;
+
+    for (i = 5; i < 10; i++)
+      expected += mix_pads_sample (i, j);
+    fail_unless_equals_int (GINT16_FROM_LE (data[j]), expected);
+  }
+  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unref (outbuf);
+}
+
+GST_END_TEST;
+
 static Suite *
 audiomixer_suite (void)
 {
@@ -2249,6 +2397,8 @@ audiomixer_suite (void)
   tcase_add_test (tc_chain, test_segment_base_handling);
   tcase_add_test (tc_chain, test_sinkpad_property_controller);
   tcase_add_test (tc_chain, test_qos_message_live);
+  tcase_add_test (tc_chain, test_many_pads_threads);
+  tcase_add_test (tc_chain, test_many_pads_stats);
   tcase_add_checked_fixture (tc_chain, test_setup, test_teardown);
   tcase_add_test (tc_chain, test_change_output_caps);
   tcase_add_test (tc_chain, test_change_output_caps_mid_output_buffer);
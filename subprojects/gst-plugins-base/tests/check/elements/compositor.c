@@ -1858,6 +1858,161 @@ GST_START_TEST (test_obscured_skipped)
 
 GST_END_TEST;
 
+static void
+_test_obscured_by_combination (gint xpos2, gint ypos2)
+{
+  GstElement *pipeline, *src0, *sink;
+  GstSample *sample;
+  GstPad *srcpad;
+  gchar *desc;
+
+  desc = g_strdup_printf ("compositor name=mix sink_1::width=10 "
+      "sink_2::xpos=%d sink_2::ypos=%d ! appsink name=sink "
+      "videotestsrc name=src0 num-buffers=5 ! "
+      "video/x-raw,format=I420,width=20,height=20 ! mix.sink_0 "
+      "videotestsrc num-buffers=5 ! "
+      "video/x-raw,format=I420,width=20,height=20 ! mix.sink_1 "
+      "videotestsrc num-buffers=5 ! "
+      "video/x-raw,format=I420,width=10,height=20 ! mix.sink_2", xpos2, ypos2);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  src0 = gst_bin_get_by_name (GST_BIN (pipeline), "src0");
+  srcpad = gst_element_get_static_pad (src0, "src");
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER,
+      test_obscured_pad_probe_cb, NULL, NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (src0);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  do {
+    g_signal_emit_by_name (sink, "pull-sample", &sample);
+    if (sample)
+      gst_sample_unref (sample);
+  } while (sample);
+  gst_object_unref (sink);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_START_TEST (test_obscured_by_combination)
+{
+  /* The left and right halves of sink_0 are obscured by sink_1 and sink_2 */
+  buffer_mapped = FALSE;
+  _test_obscured_by_combination (10, 0);
+  fail_unless (buffer_mapped == FALSE);
+
+  /* A line of sink_0 stays visible below sink_2 */
+  buffer_mapped = FALSE;
+  _test_obscured_by_combination (10, 1);
+  fail_unless (buffer_mapped == TRUE);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+damage_move_pad_probe_cb (GstPad * srcpad, GstPadProbeInfo * info,
+    GstPad * sinkpad)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  gint xpos;
+
+  /* Move sink_1 after every third output frame */
+  if ((GST_BUFFER_PTS (buffer) / (GST_SECOND / 10)) % 3 == 2) {
+    g_object_get (sinkpad, "xpos", &xpos, NULL);
+    g_object_set (sinkpad, "xpos", xpos + 7, NULL);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GList *
+_run_damage_tracking (const gchar * format, gboolean damage_tracking)
+{
+  GstElement *pipeline, *mix, *sink;
+  GstPad *srcpad, *sinkpad;
+  GstSample *sample;
+  GList *buffers = NULL;
+  gchar *desc;
+
+  /* A static background, an overlay that changes every frame and moves
+   * around, and one that only changes once per second */
+  desc = g_strdup_printf ("compositor name=mix damage-tracking=%d "
+      "sink_1::xpos=40 sink_1::ypos=30 sink_1::alpha=0.7 "
+      "sink_2::xpos=201 sink_2::ypos=151 ! video/x-raw,format=%s ! "
+      "appsink name=sink sync=false "
+      "videotestsrc num-buffers=3 pattern=smpte ! "
+      "video/x-raw,format=%s,width=320,height=240,framerate=2/1 ! mix.sink_0 "
+      "videotestsrc num-buffers=15 pattern=ball ! "
+      "video/x-raw,format=%s,width=64,height=64,framerate=10/1 ! mix.sink_1 "
+      "videotestsrc num-buffers=2 pattern=pinwheel ! "
+      "video/x-raw,format=%s,width=65,height=47,framerate=1/1 ! mix.sink_2",
+      damage_tracking, format, format, format, format);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  mix = gst_bin_get_by_name (GST_BIN (pipeline), "mix");
+  srcpad = gst_element_get_static_pad (mix, "src");
+  sinkpad = gst_element_get_static_pad (mix, "sink_1");
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) damage_move_pad_probe_cb, sinkpad,
+      (GDestroyNotify) gst_object_unref);
+  gst_object_unref (srcpad);
+  gst_object_unref (mix);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  do {
+    g_signal_emit_by_name (sink, "pull-sample", &sample);
+    if (sample) {
+      buffers = g_list_append (buffers,
+          gst_buffer_ref (gst_sample_get_buffer (sample)));
+      gst_sample_unref (sample);
+    }
+  } while (sample);
+  gst_object_unref (sink);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return buffers;
+}
+
+GST_START_TEST (test_damage_tracking)
+{
+  const gchar *formats[] = { "I420", "AYUV", "BGRA" };
+  GList *expected, *damaged, *l, *k;
+  GstMapInfo map;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    GST_INFO ("testing %s", formats[i]);
+
+    expected = _run_damage_tracking (formats[i], FALSE);
+    damaged = _run_damage_tracking (formats[i], TRUE);
+
+    fail_unless (expected != NULL);
+    fail_unless_equals_int (g_list_length (damaged),
+        g_list_length (expected));
+
+    for (l = expected, k = damaged; l; l = l->next, k = k->next) {
+      fail_unless (gst_buffer_map (l->data, &map, GST_MAP_READ));
+      fail_unless_equals_int (gst_buffer_get_size (k->data), map.size);
+      fail_unless (gst_buffer_memcmp (k->data, 0, map.data, map.size) == 0);
+      gst_buffer_unmap (l->data, &map);
+    }
+
+    g_list_free_full (expected, (GDestroyNotify) gst_buffer_unref);
+    g_list_free_full (damaged, (GDestroyNotify) gst_buffer_unref);
+  }
+}
+
+GST_END_TEST;
+
 static void
 _pipeline_eos (GstBus * bus, GstMessage * message, GstPipeline * bin)
 {
@@ -2769,6 +2924,8 @@ compositor_suite (void)
   tcase_add_test (tc_chain, test_loop);
   tcase_add_test (tc_chain, test_segment_base_handling);
   tcase_add_test (tc_chain, test_obscured_skipped);
+  tcase_add_test (tc_chain, test_obscured_by_combination);
+  tcase_add_test (tc_chain, test_damage_tracking);
   tcase_add_test (tc_chain, test_repeat_after_eos_1pad);
   tcase_add_test (tc_chain, test_repeat_after_eos_2pads_repeating_first);
   tcase_add_test (tc_chain, test_repeat_after_eos_2pads_repeating_last);
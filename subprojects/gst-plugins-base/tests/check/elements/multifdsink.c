@@ -18,10 +18,21 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
 
 #include <gst/check/gstcheck.h>
+#include <gst/net/gstnetcontrolmessagemeta.h>
+
+#ifdef HAVE_GIO_UNIX_2_0
+#include <gio/gunixfdmessage.h>
+#endif /* HAVE_GIO_UNIX_2_0 */
 
 static GstPad *mysrcpad;
 
@@ -943,6 +954,301 @@ GST_START_TEST (test_client_kick)
 
 GST_END_TEST;
 
+static guint64
+get_client_stat (GstElement * sink, int fd, const gchar * name)
+{
+  GstStructure *stats = NULL;
+  guint64 value;
+
+  g_signal_emit_by_name (sink, "get-stats", fd, &stats);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, name, &value),
+      "no %s in %" GST_PTR_FORMAT, name, stats);
+  gst_structure_free (stats);
+
+  return value;
+}
+
+/* the clients get all the queued buffers with one write */
+GST_START_TEST (test_batch_queued_buffers)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  int pfd[2];
+  gint i;
+
+  sink = setup_multifdsink ();
+  /* keep 112 bytes and burst 80 bytes to the client */
+  g_object_set (sink, "bytes-min", 100, NULL);
+  g_object_set (sink, "sync-method", 3, NULL);  /* 3 = burst */
+  g_object_set (sink, "burst-format", GST_FORMAT_BYTES, NULL);
+  g_object_set (sink, "burst-value", (guint64) 80, NULL);
+
+  fail_if (pipe (pfd) == -1);
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (mysrcpad, sink, caps, GST_FORMAT_BYTES);
+
+  for (i = 0; i < 9; i++) {
+    GstBuffer *buffer = gst_new_buffer (i);
+
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  g_signal_emit_by_name (sink, "add", pfd[1]);
+
+  /* the last buffer makes the client start */
+  fail_unless (gst_pad_push (mysrcpad, gst_new_buffer (9)) == GST_FLOW_OK);
+
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000005");
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000006");
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000007");
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000008");
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000009");
+  wait_bytes_served (sink, 80);
+
+  fail_unless_equals_uint64 (get_client_stat (sink, pfd[1], "buffers-sent"),
+      5);
+  fail_unless_equals_uint64 (get_client_stat (sink, pfd[1], "send-calls"), 1);
+  fail_unless_equals_uint64 (get_client_stat (sink, pfd[1], "bytes-sent"), 80);
+
+  GST_DEBUG ("cleaning up multifdsink");
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  cleanup_multifdsink (sink);
+
+  ASSERT_CAPS_REFCOUNT (caps, "caps", 1);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+
+#ifdef HAVE_GIO_UNIX_2_0
+/* buffers with control messages are only written as the first buffer of a
+ * batch */
+GST_START_TEST (test_batch_control_message)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  int pfd[2];
+  gint i;
+
+  sink = setup_multifdsink ();
+  g_object_set (sink, "bytes-min", 100, NULL);
+  g_object_set (sink, "sync-method", 3, NULL);  /* 3 = burst */
+  g_object_set (sink, "burst-format", GST_FORMAT_BYTES, NULL);
+  g_object_set (sink, "burst-value", (guint64) 80, NULL);
+
+  fail_if (pipe (pfd) == -1);
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (mysrcpad, sink, caps, GST_FORMAT_BYTES);
+
+  for (i = 0; i < 9; i++) {
+    GstBuffer *buffer = gst_new_buffer (i);
+
+    if (i == 7) {
+      GSocketControlMessage *msg = g_unix_fd_message_new ();
+
+      gst_buffer_add_net_control_message_meta (buffer, msg);
+      g_object_unref (msg);
+    }
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  g_signal_emit_by_name (sink, "add", pfd[1]);
+  fail_unless (gst_pad_push (mysrcpad, gst_new_buffer (9)) == GST_FLOW_OK);
+
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000005");
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000006");
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000007");
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000008");
+  fail_unless_read ("client", pfd[0], 16, "deadbee00000009");
+  wait_bytes_served (sink, 80);
+
+  /* buffers 5 and 6, then 7 to 9 */
+  fail_unless_equals_uint64 (get_client_stat (sink, pfd[1], "buffers-sent"),
+      5);
+  fail_unless_equals_uint64 (get_client_stat (sink, pfd[1], "send-calls"), 2);
+
+  GST_DEBUG ("cleaning up multifdsink");
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  cleanup_multifdsink (sink);
+
+  ASSERT_CAPS_REFCOUNT (caps, "caps", 1);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+#endif /* HAVE_GIO_UNIX_2_0 */
+
+#define PATTERN_BUFFER_SIZE 100000
+
+/* fill a buffer with bytes that depend on their offset in the stream */
+static GstBuffer *
+gst_new_buffer_pattern (gsize offset, gsize size)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (size);
+  GstMapInfo info;
+  gsize i;
+
+  g_assert (gst_buffer_map (buffer, &info, GST_MAP_WRITE));
+  for (i = 0; i < size; i++)
+    info.data[i] = (offset + i) % 251;
+  gst_buffer_unmap (buffer, &info);
+
+  return buffer;
+}
+
+static void
+fail_unless_read_pattern (int fd, gsize offset, gsize size)
+{
+  guint8 data[4096];
+
+  while (size > 0) {
+    ssize_t nbytes, i;
+
+    nbytes = read (fd, data, MIN (size, sizeof (data)));
+    fail_unless (nbytes > 0, "read failed at offset %" G_GSIZE_FORMAT, offset);
+    for (i = 0; i < nbytes; i++) {
+      fail_unless (data[i] == (offset + i) % 251,
+          "wrong data at offset %" G_GSIZE_FORMAT, offset + i);
+    }
+    offset += nbytes;
+    size -= nbytes;
+  }
+}
+
+/* the buffers don't fit into the pipe, the sink has to continue in the middle
+ * of a buffer */
+GST_START_TEST (test_partial_write)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  int pfd[2];
+  gint i, num_buffers = 8;
+
+  sink = setup_multifdsink ();
+
+  fail_if (pipe (pfd) == -1);
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (mysrcpad, sink, caps, GST_FORMAT_BYTES);
+
+  g_signal_emit_by_name (sink, "add", pfd[1]);
+
+  for (i = 0; i < num_buffers; i++) {
+    GstBuffer *buffer = gst_new_buffer_pattern (i * PATTERN_BUFFER_SIZE,
+        PATTERN_BUFFER_SIZE);
+
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  fail_unless_read_pattern (pfd[0], 0, num_buffers * PATTERN_BUFFER_SIZE);
+  wait_bytes_served (sink, num_buffers * PATTERN_BUFFER_SIZE);
+
+  fail_unless_equals_uint64 (get_client_stat (sink, pfd[1], "buffers-sent"),
+      num_buffers);
+  fail_unless_equals_uint64 (get_client_stat (sink, pfd[1], "bytes-sent"),
+      num_buffers * PATTERN_BUFFER_SIZE);
+  fail_unless (get_client_stat (sink, pfd[1], "send-calls") > 1);
+
+  GST_DEBUG ("cleaning up multifdsink");
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  cleanup_multifdsink (sink);
+
+  ASSERT_CAPS_REFCOUNT (caps, "caps", 1);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+
+static void
+setup_loopback_sockets (int *sinkfd, int *srcfd)
+{
+  struct sockaddr_in addr = { 0, };
+  socklen_t len = sizeof (addr);
+  int listenfd;
+
+  listenfd = socket (AF_INET, SOCK_STREAM, 0);
+  fail_if (listenfd < 0);
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  fail_if (bind (listenfd, (struct sockaddr *) &addr, sizeof (addr)) < 0);
+  fail_if (listen (listenfd, 1) < 0);
+  fail_if (getsockname (listenfd, (struct sockaddr *) &addr, &len) < 0);
+
+  *srcfd = socket (AF_INET, SOCK_STREAM, 0);
+  fail_if (*srcfd < 0);
+  fail_if (connect (*srcfd, (struct sockaddr *) &addr, sizeof (addr)) < 0);
+  *sinkfd = accept (listenfd, NULL, NULL);
+  fail_if (*sinkfd < 0);
+
+  close (listenfd);
+}
+
+/* the kernel copies the data for loopback clients, the sink has to notice and
+ * the data has to arrive intact anyway */
+GST_START_TEST (test_zerocopy_loopback)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  int sinkfd, srcfd;
+  gint i, num_buffers = 4;
+
+  sink = setup_multifdsink ();
+  g_object_set (sink, "zerocopy", TRUE, NULL);
+
+  setup_loopback_sockets (&sinkfd, &srcfd);
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (mysrcpad, sink, caps, GST_FORMAT_BYTES);
+
+  g_signal_emit_by_name (sink, "add", sinkfd);
+
+  for (i = 0; i < num_buffers; i++) {
+    GstBuffer *buffer = gst_new_buffer_pattern (i * PATTERN_BUFFER_SIZE,
+        PATTERN_BUFFER_SIZE);
+
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  fail_unless_read_pattern (srcfd, 0, num_buffers * PATTERN_BUFFER_SIZE);
+  wait_bytes_served (sink, num_buffers * PATTERN_BUFFER_SIZE);
+
+  /* zerocopy is not available on all systems */
+  if (get_client_stat (sink, sinkfd, "zerocopy-sends") > 0) {
+    gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+
+    /* the completions are reported asynchronously */
+    while (get_client_stat (sink, sinkfd, "zerocopy-copied") == 0) {
+      fail_unless (g_get_monotonic_time () < end_time,
+          "no zerocopy completion received");
+      g_usleep (G_USEC_PER_SEC / 100);
+    }
+  }
+
+  GST_DEBUG ("cleaning up multifdsink");
+  g_signal_emit_by_name (sink, "remove", sinkfd);
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  cleanup_multifdsink (sink);
+
+  close (sinkfd);
+  close (srcfd);
+
+  ASSERT_CAPS_REFCOUNT (caps, "caps", 1);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+
 /* FIXME: add test simulating chained oggs where:
  * sync-method is burst-on-connect
  * (when multifdsink actually does burst-on-connect based on byte size, not
@@ -967,6 +1273,12 @@ multifdsink_suite (void)
   tcase_add_test (tc_chain, test_burst_client_bytes_with_keyframe);
   tcase_add_test (tc_chain, test_client_next_keyframe);
   tcase_add_test (tc_chain, test_client_kick);
+  tcase_add_test (tc_chain, test_batch_queued_buffers);
+#ifdef HAVE_GIO_UNIX_2_0
+  tcase_add_test (tc_chain, test_batch_control_message);
+#endif /* HAVE_GIO_UNIX_2_0 */
+  tcase_add_test (tc_chain, test_partial_write);
+  tcase_add_test (tc_chain, test_zerocopy_loopback);
 
   return s;
 }
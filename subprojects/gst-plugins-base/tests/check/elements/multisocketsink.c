@@ -27,6 +27,11 @@
 
 #include <gio/gio.h>
 #include <gst/check/gstcheck.h>
+#include <gst/net/gstnetcontrolmessagemeta.h>
+
+#ifdef HAVE_GIO_UNIX_2_0
+#include <gio/gunixfdmessage.h>
+#endif /* HAVE_GIO_UNIX_2_0 */
 
 static GstPad *mysrcpad;
 
@@ -965,6 +970,345 @@ GST_START_TEST (test_client_next_keyframe)
 
 GST_END_TEST;
 
+static guint64
+get_client_stat (GstElement * sink, GSocket * socket, const gchar * name)
+{
+  GstStructure *stats = NULL;
+  guint64 value;
+
+  g_signal_emit_by_name (sink, "get-stats", socket, &stats);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, name, &value),
+      "no %s in %" GST_PTR_FORMAT, name, stats);
+  gst_structure_free (stats);
+
+  return value;
+}
+
+/* the clients get all the queued buffers with one send */
+GST_START_TEST (test_batch_queued_buffers)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  GSocket *sinksocket, *srcsocket;
+  gint i;
+
+  sink = setup_multisocketsink ();
+  /* keep 112 bytes and burst 80 bytes to the client */
+  g_object_set (sink, "bytes-min", 100, NULL);
+  g_object_set (sink, "sync-method", 3, NULL);  /* 3 = burst */
+  g_object_set (sink, "burst-format", GST_FORMAT_BYTES, NULL);
+  g_object_set (sink, "burst-value", (guint64) 80, NULL);
+
+  fail_unless (setup_handles (&sinksocket, &srcsocket));
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (mysrcpad, sink, caps, GST_FORMAT_BYTES);
+
+  for (i = 0; i < 9; i++) {
+    GstBuffer *buffer = gst_new_buffer (i);
+
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  g_signal_emit_by_name (sink, "add", sinksocket);
+
+  /* the last buffer makes the client start */
+  fail_unless (gst_pad_push (mysrcpad, gst_new_buffer (9)) == GST_FLOW_OK);
+
+  fail_unless_read ("client", srcsocket, 16, "deadbee00000005");
+  fail_unless_read ("client", srcsocket, 16, "deadbee00000006");
+  fail_unless_read ("client", srcsocket, 16, "deadbee00000007");
+  fail_unless_read ("client", srcsocket, 16, "deadbee00000008");
+  fail_unless_read ("client", srcsocket, 16, "deadbee00000009");
+  wait_bytes_served (sink, 80);
+
+  fail_unless_equals_uint64 (get_client_stat (sink, sinksocket,
+          "buffers-sent"), 5);
+  fail_unless_equals_uint64 (get_client_stat (sink, sinksocket,
+          "send-calls"), 1);
+  fail_unless_equals_uint64 (get_client_stat (sink, sinksocket,
+          "bytes-sent"), 80);
+
+  GST_DEBUG ("cleaning up multisocketsink");
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  cleanup_multisocketsink (sink);
+
+  ASSERT_CAPS_REFCOUNT (caps, "caps", 1);
+  gst_caps_unref (caps);
+
+  g_object_unref (srcsocket);
+  g_object_unref (sinksocket);
+}
+
+GST_END_TEST;
+
+#ifdef HAVE_GIO_UNIX_2_0
+/* buffers with control messages are only sent as the first buffer of a
+ * batch, so that the control message arrives with their data */
+GST_START_TEST (test_batch_control_message)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  GSocket *sinksocket, *srcsocket;
+  gchar data[80], expected[80];
+  gsize received = 0;
+  guint n_fds = 0;
+  int pfd[2];
+  gint i;
+
+  sink = setup_multisocketsink ();
+  g_object_set (sink, "bytes-min", 100, NULL);
+  g_object_set (sink, "sync-method", 3, NULL);  /* 3 = burst */
+  g_object_set (sink, "burst-format", GST_FORMAT_BYTES, NULL);
+  g_object_set (sink, "burst-value", (guint64) 80, NULL);
+
+  fail_unless (setup_handles (&sinksocket, &srcsocket));
+  fail_if (pipe (pfd) == -1);
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (mysrcpad, sink, caps, GST_FORMAT_BYTES);
+
+  for (i = 0; i < 9; i++) {
+    GstBuffer *buffer = gst_new_buffer (i);
+
+    if (i == 7) {
+      GSocketControlMessage *msg = g_unix_fd_message_new ();
+
+      fail_unless (g_unix_fd_message_append_fd ((GUnixFDMessage *) msg,
+              pfd[0], NULL));
+      gst_buffer_add_net_control_message_meta (buffer, msg);
+      g_object_unref (msg);
+    }
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+  close (pfd[0]);
+  close (pfd[1]);
+
+  g_signal_emit_by_name (sink, "add", sinksocket);
+  fail_unless (gst_pad_push (mysrcpad, gst_new_buffer (9)) == GST_FLOW_OK);
+
+  while (received < sizeof (data)) {
+    GInputVector vec = { data + received, sizeof (data) - received };
+    GSocketControlMessage **msgs = NULL;
+    gint n_msgs = 0;
+    gssize ret;
+
+    ret = g_socket_receive_message (srcsocket, NULL, &vec, 1, &msgs, &n_msgs,
+        NULL, NULL, NULL);
+    fail_unless (ret > 0);
+    received += ret;
+
+    for (i = 0; i < n_msgs; i++) {
+      gint *fds, n, j;
+
+      fail_unless (G_IS_UNIX_FD_MESSAGE (msgs[i]));
+      fds = g_unix_fd_message_steal_fds ((GUnixFDMessage *) msgs[i], &n);
+      for (j = 0; j < n; j++)
+        close (fds[j]);
+      n_fds += n;
+      g_free (fds);
+      g_object_unref (msgs[i]);
+    }
+    g_free (msgs);
+  }
+
+  for (i = 0; i < 5; i++)
+    g_snprintf (expected + 16 * i, 16, "deadbee%08x", i + 5);
+  fail_unless (memcmp (data, expected, sizeof (data)) == 0);
+  fail_unless_equals_int (n_fds, 1);
+  wait_bytes_served (sink, 80);
+
+  /* buffers 5 and 6, then 7 with the control message up to 9 */
+  fail_unless_equals_uint64 (get_client_stat (sink, sinksocket,
+          "buffers-sent"), 5);
+  fail_unless_equals_uint64 (get_client_stat (sink, sinksocket,
+          "send-calls"), 2);
+
+  GST_DEBUG ("cleaning up multisocketsink");
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  cleanup_multisocketsink (sink);
+
+  ASSERT_CAPS_REFCOUNT (caps, "caps", 1);
+  gst_caps_unref (caps);
+
+  g_object_unref (srcsocket);
+  g_object_unref (sinksocket);
+}
+
+GST_END_TEST;
+#endif /* HAVE_GIO_UNIX_2_0 */
+
+#define PATTERN_BUFFER_SIZE 100000
+
+/* fill a buffer with bytes that depend on their offset in the stream */
+static GstBuffer *
+gst_new_buffer_pattern (gsize offset, gsize size)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (size);
+  GstMapInfo info;
+  gsize i;
+
+  g_assert (gst_buffer_map (buffer, &info, GST_MAP_WRITE));
+  for (i = 0; i < size; i++)
+    info.data[i] = (offset + i) % 251;
+  gst_buffer_unmap (buffer, &info);
+
+  return buffer;
+}
+
+static void
+fail_unless_read_pattern (GSocket * srchandle, gsize size)
+{
+  guint8 *data = g_malloc (size);
+  gsize i;
+
+  fail_unless (read_handle_n_bytes_exactly (srchandle, data, size));
+  for (i = 0; i < size; i++)
+    fail_unless (data[i] == i % 251, "wrong data at offset %" G_GSIZE_FORMAT,
+        i);
+  g_free (data);
+}
+
+/* the buffers don't fit into the socket buffer, the sink has to continue in
+ * the middle of a buffer */
+GST_START_TEST (test_partial_write)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  GSocket *sinksocket, *srcsocket;
+  gint i, num_buffers = 8;
+
+  sink = setup_multisocketsink ();
+  fail_unless (setup_handles (&sinksocket, &srcsocket));
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (mysrcpad, sink, caps, GST_FORMAT_BYTES);
+
+  g_signal_emit_by_name (sink, "add", sinksocket);
+
+  for (i = 0; i < num_buffers; i++) {
+    GstBuffer *buffer = gst_new_buffer_pattern (i * PATTERN_BUFFER_SIZE,
+        PATTERN_BUFFER_SIZE);
+
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  fail_unless_read_pattern (srcsocket, num_buffers * PATTERN_BUFFER_SIZE);
+  wait_bytes_served (sink, num_buffers * PATTERN_BUFFER_SIZE);
+
+  fail_unless_equals_uint64 (get_client_stat (sink, sinksocket,
+          "buffers-sent"), num_buffers);
+  fail_unless_equals_uint64 (get_client_stat (sink, sinksocket,
+          "bytes-sent"), num_buffers * PATTERN_BUFFER_SIZE);
+  fail_unless (get_client_stat (sink, sinksocket, "send-calls") > 1);
+
+  GST_DEBUG ("cleaning up multisocketsink");
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  cleanup_multisocketsink (sink);
+
+  ASSERT_CAPS_REFCOUNT (caps, "caps", 1);
+  gst_caps_unref (caps);
+
+  g_object_unref (srcsocket);
+  g_object_unref (sinksocket);
+}
+
+GST_END_TEST;
+
+static void
+setup_loopback_handles (GSocket ** sinkhandle, GSocket ** srchandle)
+{
+  GError *error = NULL;
+  GSocket *listener;
+  GInetAddress *loopback;
+  GSocketAddress *addr;
+
+  listener = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_STREAM,
+      G_SOCKET_PROTOCOL_TCP, &error);
+  fail_if (error);
+  loopback = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (loopback, 0);
+  g_object_unref (loopback);
+  fail_unless (g_socket_bind (listener, addr, TRUE, &error));
+  g_object_unref (addr);
+  fail_unless (g_socket_listen (listener, &error));
+  addr = g_socket_get_local_address (listener, &error);
+  fail_if (error);
+
+  *srchandle = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_STREAM,
+      G_SOCKET_PROTOCOL_TCP, &error);
+  fail_if (error);
+  fail_unless (g_socket_connect (*srchandle, addr, NULL, &error));
+  g_object_unref (addr);
+  *sinkhandle = g_socket_accept (listener, NULL, &error);
+  fail_if (error);
+
+  g_object_unref (listener);
+}
+
+/* the kernel copies the data for loopback clients, the sink has to notice and
+ * the data has to arrive intact anyway */
+GST_START_TEST (test_zerocopy_loopback)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  GSocket *sinksocket, *srcsocket;
+  gint i, num_buffers = 4;
+
+  sink = setup_multisocketsink ();
+  g_object_set (sink, "zerocopy", TRUE, NULL);
+
+  setup_loopback_handles (&sinksocket, &srcsocket);
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (mysrcpad, sink, caps, GST_FORMAT_BYTES);
+
+  g_signal_emit_by_name (sink, "add", sinksocket);
+
+  for (i = 0; i < num_buffers; i++) {
+    GstBuffer *buffer = gst_new_buffer_pattern (i * PATTERN_BUFFER_SIZE,
+        PATTERN_BUFFER_SIZE);
+
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  fail_unless_read_pattern (srcsocket, num_buffers * PATTERN_BUFFER_SIZE);
+  wait_bytes_served (sink, num_buffers * PATTERN_BUFFER_SIZE);
+
+  /* zerocopy is not available on all systems */
+  if (get_client_stat (sink, sinksocket, "zerocopy-sends") > 0) {
+    gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+
+    /* the completions are reported asynchronously */
+    while (get_client_stat (sink, sinksocket, "zerocopy-copied") == 0) {
+      fail_unless (g_get_monotonic_time () < end_time,
+          "no zerocopy completion received");
+      g_usleep (G_USEC_PER_SEC / 100);
+    }
+  }
+
+  GST_DEBUG ("cleaning up multisocketsink");
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  cleanup_multisocketsink (sink);
+
+  ASSERT_CAPS_REFCOUNT (caps, "caps", 1);
+  gst_caps_unref (caps);
+
+  g_object_unref (srcsocket);
+  g_object_unref (sinksocket);
+}
+
+GST_END_TEST;
+
 /* FIXME: add test simulating chained oggs where:
  * sync-method is burst-on-connect
  * (when multisocketsink actually does burst-on-connect based on byte size, not
@@ -988,6 +1332,12 @@ multisocketsink_suite (void)
   tcase_add_test (tc_chain, test_burst_client_bytes_keyframe);
   tcase_add_test (tc_chain, test_burst_client_bytes_with_keyframe);
   tcase_add_test (tc_chain, test_client_next_keyframe);
+  tcase_add_test (tc_chain, test_batch_queued_buffers);
+#ifdef HAVE_GIO_UNIX_2_0
+  tcase_add_test (tc_chain, test_batch_control_message);
+#endif /* HAVE_GIO_UNIX_2_0 */
+  tcase_add_test (tc_chain, test_partial_write);
+  tcase_add_test (tc_chain, test_zerocopy_loopback);
 
   return s;
 }
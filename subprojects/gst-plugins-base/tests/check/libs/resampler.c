@@ -0,0 +1,353 @@
+/* GStreamer
+ *
+ * unit tests for the SIMD versions of the audio resampler
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+/* not public API, the test needs to switch between the resample functions
+ * itself */
+#undef GST_CAT_DEFAULT
+#include "../../../gst-libs/gst/audio/audio-resampler.c"
+
+#define N_FRAMES 2000
+
+/* the vector versions sum up in a different order and use FMA */
+#define F32_TOLERANCE 1e-4
+#define F64_TOLERANCE 1e-12
+
+#define SET_RESAMPLE_FUNCS(arch)                                        \
+G_STMT_START {                                                          \
+  resample_gint16_full_1 = resample_gint16_full_1_##arch;               \
+  resample_gint16_linear_1 = resample_gint16_linear_1_##arch;           \
+  resample_gint16_cubic_1 = resample_gint16_cubic_1_##arch;             \
+  resample_gint32_full_1 = resample_gint32_full_1_##arch;               \
+  resample_gint32_linear_1 = resample_gint32_linear_1_##arch;           \
+  resample_gint32_cubic_1 = resample_gint32_cubic_1_##arch;             \
+  resample_gfloat_full_1 = resample_gfloat_full_1_##arch;               \
+  resample_gfloat_linear_1 = resample_gfloat_linear_1_##arch;           \
+  resample_gfloat_cubic_1 = resample_gfloat_cubic_1_##arch;             \
+  resample_gdouble_full_1 = resample_gdouble_full_1_##arch;             \
+  resample_gdouble_linear_1 = resample_gdouble_linear_1_##arch;         \
+  resample_gdouble_cubic_1 = resample_gdouble_cubic_1_##arch;           \
+} G_STMT_END
+
+/* makes the resamplers created after this use the functions of @arch,
+ * returns FALSE when they are not built or the CPU doesn't have them */
+static gboolean
+set_resample_funcs (const gchar * arch)
+{
+  /* the automatic selection must not override ours later */
+  audio_resampler_init ();
+  __builtin_cpu_init ();
+
+  if (g_str_equal (arch, "c")) {
+    SET_RESAMPLE_FUNCS (c);
+    return TRUE;
+  }
+#if defined (HAVE_IMMINTRIN_H) && HAVE_AVX2
+  if (g_str_equal (arch, "avx2")) {
+    if (!__builtin_cpu_supports ("avx2") || !__builtin_cpu_supports ("fma"))
+      return FALSE;
+    SET_RESAMPLE_FUNCS (avx2);
+    return TRUE;
+  }
+#endif
+#if defined (HAVE_IMMINTRIN_H) && HAVE_AVX512
+  if (g_str_equal (arch, "avx512")) {
+    if (!__builtin_cpu_supports ("avx512f") ||
+        !__builtin_cpu_supports ("avx512bw"))
+      return FALSE;
+    SET_RESAMPLE_FUNCS (avx512);
+    return TRUE;
+  }
+#endif
+  return FALSE;
+}
+
+static gpointer
+make_input (GstAudioFormat format, gint channels)
+{
+  GRand *rand = g_rand_new_with_seed (42);
+  gint i, n_samples = N_FRAMES * channels;
+  gpointer in;
+
+  in = g_malloc (n_samples * 8);
+
+  for (i = 0; i < n_samples; i++) {
+    /* a sine with some noise, close to full scale */
+    gdouble v = 0.6 * sin (i * 0.05) + g_rand_double_range (rand, -0.3, 0.3);
+
+    switch (format) {
+      case GST_AUDIO_FORMAT_S16:
+        ((gint16 *) in)[i] = v * G_MAXINT16;
+        break;
+      case GST_AUDIO_FORMAT_S32:
+        ((gint32 *) in)[i] = v * G_MAXINT32;
+        break;
+      case GST_AUDIO_FORMAT_F32:
+        ((gfloat *) in)[i] = v;
+        break;
+      case GST_AUDIO_FORMAT_F64:
+        ((gdouble *) in)[i] = v;
+        break;
+      default:
+        g_assert_not_reached ();
+    }
+  }
+  g_rand_free (rand);
+
+  return in;
+}
+
+/* resamples all of @in in blocks of odd sizes, so the lengths the resample
+ * functions get are not a multiple of the vector size */
+static GByteArray *
+resample (const gchar * arch, GstAudioResamplerMethod method,
+    GstStructure * options, GstAudioFormat format, gint channels,
+    gint in_rate, gint out_rate, gpointer in)
+{
+  static const gsize block_sizes[] = { 1, 7, 31, 97, 333 };
+  const GstAudioFormatInfo *finfo = gst_audio_format_get_info (format);
+  GstAudioResampler *resampler;
+  GByteArray *res;
+  gsize bpf, offset = 0, in_frames, out_frames;
+  gpointer in_data, out;
+  guint i = 0;
+
+  fail_unless (set_resample_funcs (arch));
+
+  resampler = gst_audio_resampler_new (method, GST_AUDIO_RESAMPLER_FLAG_NONE,
+      format, channels, in_rate, out_rate, options);
+  fail_unless (resampler != NULL);
+
+  bpf = GST_AUDIO_FORMAT_INFO_WIDTH (finfo) / 8 * channels;
+  res = g_byte_array_new ();
+
+  while (offset < N_FRAMES) {
+    in_frames = MIN (block_sizes[i++ % G_N_ELEMENTS (block_sizes)],
+        N_FRAMES - offset);
+    out_frames = gst_audio_resampler_get_out_frames (resampler, in_frames);
+
+    in_data = (guint8 *) in + offset * bpf;
+    out = g_malloc0 (out_frames * bpf + 1);
+    gst_audio_resampler_resample (resampler, &in_data, in_frames, &out,
+        out_frames);
+    g_byte_array_append (res, out, out_frames * bpf);
+    g_free (out);
+
+    offset += in_frames;
+  }
+  gst_audio_resampler_free (resampler);
+
+  return res;
+}
+
+static void
+compare_output (GstAudioFormat format, GByteArray * expected,
+    GByteArray * result, const gchar * what)
+{
+  guint i, n_samples;
+
+  fail_unless_equals_int (result->len, expected->len);
+
+  switch (format) {
+    case GST_AUDIO_FORMAT_S16:
+    case GST_AUDIO_FORMAT_S32:
+      /* the integer versions round exactly like the C versions */
+      for (i = 0; i < expected->len; i++) {
+        fail_unless (expected->data[i] == result->data[i],
+            "%s: output differs at byte %u", what, i);
+      }
+      break;
+    case GST_AUDIO_FORMAT_F32:
+      n_samples = expected->len / sizeof (gfloat);
+      for (i = 0; i < n_samples; i++) {
+        gfloat e = ((gfloat *) expected->data)[i];
+        gfloat r = ((gfloat *) result->data)[i];
+
+        fail_unless (fabs (e - r) <= F32_TOLERANCE,
+            "%s: sample %u is %f, expected %f", what, i, r, e);
+      }
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      n_samples = expected->len / sizeof (gdouble);
+      for (i = 0; i < n_samples; i++) {
+        gdouble e = ((gdouble *) expected->data)[i];
+        gdouble r = ((gdouble *) result->data)[i];
+
+        fail_unless (fabs (e - r) <= F64_TOLERANCE,
+            "%s: sample %u is %.15f, expected %.15f", what, i, r, e);
+      }
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+static void
+compare_with_c (const gchar * arch, GstAudioResamplerMethod method,
+    GstStructure * options, GstAudioFormat format, gint channels,
+    gint in_rate, gint out_rate, const gchar * what)
+{
+  GByteArray *expected, *result;
+  gpointer in;
+  gchar *desc;
+
+  in = make_input (format, channels);
+
+  expected = resample ("c", method, options, format, channels, in_rate,
+      out_rate, in);
+  result = resample (arch, method, options, format, channels, in_rate,
+      out_rate, in);
+  fail_unless (expected->len > 0);
+
+  desc = g_strdup_printf ("%s %s %s %d channels %d -> %d", arch,
+      gst_audio_format_to_string (format), what, channels, in_rate, out_rate);
+  GST_DEBUG ("comparing %s", desc);
+  compare_output (format, expected, result, desc);
+  g_free (desc);
+
+  g_byte_array_unref (expected);
+  g_byte_array_unref (result);
+  g_free (in);
+}
+
+static const GstAudioFormat formats[] = {
+  GST_AUDIO_FORMAT_S16, GST_AUDIO_FORMAT_S32,
+  GST_AUDIO_FORMAT_F32, GST_AUDIO_FORMAT_F64
+};
+
+static const struct
+{
+  GstAudioResamplerFilterMode mode;
+  GstAudioResamplerFilterInterpolation interpolation;
+  const gchar *name;
+} filters[] = {
+  {GST_AUDIO_RESAMPLER_FILTER_MODE_FULL,
+      GST_AUDIO_RESAMPLER_FILTER_INTERPOLATION_NONE, "full"},
+  {GST_AUDIO_RESAMPLER_FILTER_MODE_INTERPOLATED,
+      GST_AUDIO_RESAMPLER_FILTER_INTERPOLATION_LINEAR, "linear"},
+  {GST_AUDIO_RESAMPLER_FILTER_MODE_INTERPOLATED,
+      GST_AUDIO_RESAMPLER_FILTER_INTERPOLATION_CUBIC, "cubic"},
+};
+
+static const gint rates[][2] = {
+  {44100, 48000},
+  {48000, 44100},
+};
+
+/* number of taps before they are scaled up for downsampling and rounded up
+ * to a multiple of 8 */
+static const gint n_taps[] = { 8, 20, 40, 72, 132 };
+
+static const guint kaiser_qualities[] = { 0, 4, 10 };
+
+static void
+compare_all (const gchar * arch)
+{
+  GstStructure *options;
+  gchar *what;
+  guint f, m, r, t, q;
+  gint channels;
+
+  if (!set_resample_funcs (arch)) {
+    GST_INFO ("%s not supported, skipping", arch);
+    return;
+  }
+
+  for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+    for (m = 0; m < G_N_ELEMENTS (filters); m++) {
+      for (r = 0; r < G_N_ELEMENTS (rates); r++) {
+        for (channels = 1; channels <= 2; channels++) {
+          for (t = 0; t < G_N_ELEMENTS (n_taps); t++) {
+            options = gst_structure_new ("resampler",
+                GST_AUDIO_RESAMPLER_OPT_N_TAPS, G_TYPE_INT, n_taps[t],
+                GST_AUDIO_RESAMPLER_OPT_FILTER_MODE,
+                GST_TYPE_AUDIO_RESAMPLER_FILTER_MODE, filters[m].mode,
+                GST_AUDIO_RESAMPLER_OPT_FILTER_INTERPOLATION,
+                GST_TYPE_AUDIO_RESAMPLER_FILTER_INTERPOLATION,
+                filters[m].interpolation, NULL);
+            what = g_strdup_printf ("blackman-nuttall %s %d taps",
+                filters[m].name, n_taps[t]);
+
+            compare_with_c (arch, GST_AUDIO_RESAMPLER_METHOD_BLACKMAN_NUTTALL,
+                options, formats[f], channels, rates[r][0], rates[r][1], what);
+
+            g_free (what);
+            gst_structure_free (options);
+          }
+
+          for (q = 0; q < G_N_ELEMENTS (kaiser_qualities); q++) {
+            options = gst_structure_new_empty ("resampler");
+            gst_audio_resampler_options_set_quality
+                (GST_AUDIO_RESAMPLER_METHOD_KAISER, kaiser_qualities[q],
+                rates[r][0], rates[r][1], options);
+            gst_structure_set (options,
+                GST_AUDIO_RESAMPLER_OPT_FILTER_MODE,
+                GST_TYPE_AUDIO_RESAMPLER_FILTER_MODE, filters[m].mode,
+                GST_AUDIO_RESAMPLER_OPT_FILTER_INTERPOLATION,
+                GST_TYPE_AUDIO_RESAMPLER_FILTER_INTERPOLATION,
+                filters[m].interpolation, NULL);
+            what = g_strdup_printf ("kaiser %s q%u", filters[m].name,
+                kaiser_qualities[q]);
+
+            compare_with_c (arch, GST_AUDIO_RESAMPLER_METHOD_KAISER, options,
+                formats[f], channels, rates[r][0], rates[r][1], what);
+
+            g_free (what);
+            gst_structure_free (options);
+          }
+        }
+      }
+    }
+  }
+}
+
+GST_START_TEST (test_resampler_avx2)
+{
+  compare_all ("avx2");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_resampler_avx512)
+{
+  compare_all ("avx512");
+}
+
+GST_END_TEST;
+
+static Suite *
+resampler_suite (void)
+{
+  Suite *s = suite_create ("audio resampler");
+  TCase *tc_chain = tcase_create ("simd");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_resampler_avx2);
+  tcase_add_test (tc_chain, test_resampler_avx512);
+
+  return s;
+}
+
+GST_CHECK_MAIN (resampler);
@@ -2879,6 +2879,270 @@ GST_START_TEST (test_video_convert_multithreading)
 
 GST_END_TEST;
 
+/* random samples with the given number of significant bits, v210 is filled
+ * with random 10 bit components */
+static void
+fill_buffer_random (GstBuffer * buffer, const GstVideoInfo * info,
+    GRand * rand)
+{
+  const GstVideoFormatInfo *finfo = info->finfo;
+  GstMapInfo map;
+  guint16 mask = 0xffff;
+  gsize i;
+
+  if (GST_VIDEO_FORMAT_INFO_SHIFT (finfo, 0) == 0 &&
+      GST_VIDEO_FORMAT_INFO_DEPTH (finfo, 0) > 8)
+    mask = (1 << GST_VIDEO_FORMAT_INFO_DEPTH (finfo, 0)) - 1;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  if (GST_VIDEO_INFO_FORMAT (info) == GST_VIDEO_FORMAT_v210) {
+    for (i = 0; i + 4 <= map.size; i += 4)
+      GST_WRITE_UINT32_LE (map.data + i, g_rand_int (rand) & 0x3fffffff);
+  } else {
+    for (i = 0; i + 2 <= map.size; i += 2)
+      GST_WRITE_UINT16_LE (map.data + i, g_rand_int (rand) & mask);
+  }
+  gst_buffer_unmap (buffer, &map);
+}
+
+#define WIDTH 1283
+#define HEIGHT 31
+/* set to something larger to do benchmarks */
+#define TIME 0.01
+
+static gdouble
+time_convert (GstVideoConverter * convert, GstVideoFrame * inframe,
+    GstVideoFrame * outframe, GTimer * timer)
+{
+  gdouble elapsed;
+  gint count = 0;
+
+  g_timer_start (timer);
+  while (TRUE) {
+    gst_video_converter_frame (convert, inframe, outframe);
+    count++;
+    elapsed = g_timer_elapsed (timer, NULL);
+    if (elapsed >= TIME)
+      break;
+  }
+  return count / elapsed;
+}
+
+/* the fast paths between the high bit depth formats must give the same
+ * result as the generic path when it does not dither */
+GST_START_TEST (test_video_convert_high_bit_depth)
+{
+  static const GstVideoFormat formats[][2] = {
+    {GST_VIDEO_FORMAT_P010_10LE, GST_VIDEO_FORMAT_I420_10LE},
+    {GST_VIDEO_FORMAT_I420_10LE, GST_VIDEO_FORMAT_P010_10LE},
+    {GST_VIDEO_FORMAT_P012_LE, GST_VIDEO_FORMAT_I420_12LE},
+    {GST_VIDEO_FORMAT_I420_12LE, GST_VIDEO_FORMAT_P012_LE},
+    {GST_VIDEO_FORMAT_I422_10LE, GST_VIDEO_FORMAT_v210},
+    {GST_VIDEO_FORMAT_v210, GST_VIDEO_FORMAT_I422_10LE},
+  };
+  GTimer *timer;
+  GRand *rand;
+  gint i;
+
+  timer = g_timer_new ();
+  rand = g_rand_new_with_seed (0);
+
+  GST_DEBUG ("fast/sec\t generic/sec\t format");
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    GstVideoInfo ininfo, outinfo;
+    GstVideoFrame inframe, outframe, refframe;
+    GstBuffer *inbuffer, *outbuffer, *refbuffer;
+    GstVideoConverter *convert, *ref;
+    GstMapInfo map, refmap;
+    gdouble fast_sec, generic_sec;
+
+    fail_unless (gst_video_info_set_format (&ininfo, formats[i][0], WIDTH,
+            HEIGHT));
+    fail_unless (gst_video_info_set_format (&outinfo, formats[i][1], WIDTH,
+            HEIGHT));
+
+    inbuffer = gst_buffer_new_and_alloc (ininfo.size);
+    outbuffer = gst_buffer_new_and_alloc (outinfo.size);
+    refbuffer = gst_buffer_new_and_alloc (outinfo.size);
+    fill_buffer_random (inbuffer, &ininfo, rand);
+    gst_buffer_memset (outbuffer, 0, 0, -1);
+    gst_buffer_memset (refbuffer, 0, 0, -1);
+
+    gst_video_frame_map (&inframe, &ininfo, inbuffer, GST_MAP_READ);
+    gst_video_frame_map (&outframe, &outinfo, outbuffer, GST_MAP_WRITE);
+    gst_video_frame_map (&refframe, &outinfo, refbuffer, GST_MAP_WRITE);
+
+    convert = gst_video_converter_new (&ininfo, &outinfo, NULL);
+    /* a dither quantization other than 1 disables the fast paths */
+    ref = gst_video_converter_new (&ininfo, &outinfo,
+        gst_structure_new ("options",
+            GST_VIDEO_CONVERTER_OPT_DITHER_METHOD,
+            GST_TYPE_VIDEO_DITHER_METHOD, GST_VIDEO_DITHER_NONE,
+            GST_VIDEO_CONVERTER_OPT_DITHER_QUANTIZATION, G_TYPE_UINT, 2,
+            GST_VIDEO_CONVERTER_OPT_CHROMA_MODE,
+            GST_TYPE_VIDEO_CHROMA_MODE, GST_VIDEO_CHROMA_MODE_NONE, NULL));
+
+    fast_sec = time_convert (convert, &inframe, &outframe, timer);
+    generic_sec = time_convert (ref, &inframe, &refframe, timer);
+
+    GST_DEBUG ("%f \t %f \t %s->%s", fast_sec, generic_sec,
+        gst_video_format_to_string (formats[i][0]),
+        gst_video_format_to_string (formats[i][1]));
+
+    gst_video_converter_free (convert);
+    gst_video_converter_free (ref);
+
+    gst_video_frame_unmap (&inframe);
+    gst_video_frame_unmap (&outframe);
+    gst_video_frame_unmap (&refframe);
+
+    gst_buffer_map (outbuffer, &map, GST_MAP_READ);
+    gst_buffer_map (refbuffer, &refmap, GST_MAP_READ);
+    fail_unless (memcmp (map.data, refmap.data, map.size) == 0,
+        "%s->%s differs from the generic path",
+        gst_video_format_to_string (formats[i][0]),
+        gst_video_format_to_string (formats[i][1]));
+    gst_buffer_unmap (outbuffer, &map);
+    gst_buffer_unmap (refbuffer, &refmap);
+
+    gst_buffer_unref (inbuffer);
+    gst_buffer_unref (outbuffer);
+    gst_buffer_unref (refbuffer);
+  }
+
+  g_rand_free (rand);
+  g_timer_destroy (timer);
+}
+
+GST_END_TEST;
+#undef WIDTH
+#undef HEIGHT
+#undef TIME
+
+/* odd sizes so that the stripes don't line up with the frame, 8K downscales
+ * are measured by tests/interactive/benchmark-video-scaling.c */
+#define IN_WIDTH 1283
+#define IN_HEIGHT 720
+#define OUT_WIDTH 321
+#define OUT_HEIGHT 180
+
+static GstVideoConverter *
+new_tiled_converter (const GstVideoInfo * ininfo, const GstVideoInfo * outinfo,
+    guint cache_size)
+{
+  return gst_video_converter_new (ininfo, outinfo,
+      gst_structure_new ("options",
+          GST_VIDEO_CONVERTER_OPT_THREADS, G_TYPE_UINT, 3,
+          GST_VIDEO_CONVERTER_OPT_TILE_CACHE_SIZE, G_TYPE_UINT, cache_size,
+          NULL));
+}
+
+/* scaling in tiles must give the same result as scaling whole lines */
+GST_START_TEST (test_video_convert_scale_tiled)
+{
+  static const struct
+  {
+    GstVideoFormat format;
+    GstVideoInterlaceMode mode;
+  } formats[] = {
+    {GST_VIDEO_FORMAT_I420, GST_VIDEO_INTERLACE_MODE_PROGRESSIVE},
+    {GST_VIDEO_FORMAT_I420, GST_VIDEO_INTERLACE_MODE_INTERLEAVED},
+    {GST_VIDEO_FORMAT_NV12, GST_VIDEO_INTERLACE_MODE_PROGRESSIVE},
+    {GST_VIDEO_FORMAT_GRAY16_LE, GST_VIDEO_INTERLACE_MODE_PROGRESSIVE},
+    {GST_VIDEO_FORMAT_RGB, GST_VIDEO_INTERLACE_MODE_PROGRESSIVE},
+    {GST_VIDEO_FORMAT_RGBA, GST_VIDEO_INTERLACE_MODE_PROGRESSIVE},
+    {GST_VIDEO_FORMAT_AYUV64, GST_VIDEO_INTERLACE_MODE_PROGRESSIVE},
+  };
+  GTimer *timer;
+  GRand *rand;
+  gint i;
+
+  timer = g_timer_new ();
+  rand = g_rand_new_with_seed (0);
+
+  GST_DEBUG ("tiled/sec\t lines/sec\t format");
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    GstVideoInfo ininfo, outinfo;
+    GstVideoFrame inframe, outframe, tiledframe, refframe;
+    GstBuffer *inbuffer, *outbuffer, *tiledbuffer, *refbuffer;
+    GstVideoConverter *convert, *tiled, *ref;
+    GstMapInfo map, refmap;
+    gdouble tiled_sec, lines_sec;
+
+    fail_unless (gst_video_info_set_interlaced_format (&ininfo,
+            formats[i].format, formats[i].mode, IN_WIDTH, IN_HEIGHT));
+    fail_unless (gst_video_info_set_interlaced_format (&outinfo,
+            formats[i].format, formats[i].mode, OUT_WIDTH, OUT_HEIGHT));
+
+    inbuffer = gst_buffer_new_and_alloc (ininfo.size);
+    outbuffer = gst_buffer_new_and_alloc (outinfo.size);
+    tiledbuffer = gst_buffer_new_and_alloc (outinfo.size);
+    refbuffer = gst_buffer_new_and_alloc (outinfo.size);
+    fill_buffer_random (inbuffer, &ininfo, rand);
+    gst_buffer_memset (outbuffer, 0, 0, -1);
+    gst_buffer_memset (tiledbuffer, 0, 0, -1);
+    gst_buffer_memset (refbuffer, 0, 0, -1);
+
+    gst_video_frame_map (&inframe, &ininfo, inbuffer, GST_MAP_READ);
+    gst_video_frame_map (&outframe, &outinfo, outbuffer, GST_MAP_WRITE);
+    gst_video_frame_map (&tiledframe, &outinfo, tiledbuffer, GST_MAP_WRITE);
+    gst_video_frame_map (&refframe, &outinfo, refbuffer, GST_MAP_WRITE);
+
+    /* the default cache size, a cache size small enough to always make
+     * narrow stripes and no tiling */
+    convert = new_tiled_converter (&ininfo, &outinfo, 256 * 1024);
+    tiled = new_tiled_converter (&ininfo, &outinfo, 16 * 1024);
+    ref = new_tiled_converter (&ininfo, &outinfo, 0);
+
+    gst_video_converter_frame (tiled, &inframe, &tiledframe);
+    tiled_sec = time_convert (convert, &inframe, &outframe, timer);
+    lines_sec = time_convert (ref, &inframe, &refframe, timer);
+
+    GST_DEBUG ("%f \t %f \t %s %dx%d->%dx%d%s", tiled_sec, lines_sec,
+        gst_video_format_to_string (formats[i].format), IN_WIDTH, IN_HEIGHT,
+        OUT_WIDTH, OUT_HEIGHT,
+        formats[i].mode == GST_VIDEO_INTERLACE_MODE_PROGRESSIVE ? "" :
+        " interlaced");
+
+    gst_video_converter_free (convert);
+    gst_video_converter_free (tiled);
+    gst_video_converter_free (ref);
+
+    gst_video_frame_unmap (&inframe);
+    gst_video_frame_unmap (&outframe);
+    gst_video_frame_unmap (&tiledframe);
+    gst_video_frame_unmap (&refframe);
+
+    gst_buffer_map (refbuffer, &refmap, GST_MAP_READ);
+    gst_buffer_map (outbuffer, &map, GST_MAP_READ);
+    fail_unless (memcmp (map.data, refmap.data, map.size) == 0,
+        "%s differs when tiled", gst_video_format_to_string (formats[i].format));
+    gst_buffer_unmap (outbuffer, &map);
+    gst_buffer_map (tiledbuffer, &map, GST_MAP_READ);
+    fail_unless (memcmp (map.data, refmap.data, map.size) == 0,
+        "%s differs in narrow tiles",
+        gst_video_format_to_string (formats[i].format));
+    gst_buffer_unmap (tiledbuffer, &map);
+    gst_buffer_unmap (refbuffer, &refmap);
+
+    gst_buffer_unref (inbuffer);
+    gst_buffer_unref (outbuffer);
+    gst_buffer_unref (tiledbuffer);
+    gst_buffer_unref (refbuffer);
+  }
+
+  g_rand_free (rand);
+  g_timer_destroy (timer);
+}
+
+GST_END_TEST;
+#undef IN_WIDTH
+#undef IN_HEIGHT
+#undef OUT_WIDTH
+#undef OUT_HEIGHT
+
 GST_START_TEST (test_video_transfer)
 {
   gint i, j;
@@ -4212,6 +4476,8 @@ video_suite (void)
   tcase_add_test (tc_chain, test_video_size_convert);
   tcase_add_test (tc_chain, test_video_convert);
   tcase_add_test (tc_chain, test_video_convert_multithreading);
+  tcase_add_test (tc_chain, test_video_convert_high_bit_depth);
+  tcase_add_test (tc_chain, test_video_convert_scale_tiled);
   tcase_add_test (tc_chain, test_video_transfer);
   tcase_add_test (tc_chain, test_overlay_blend);
   tcase_add_test (tc_chain, test_video_center_rect);
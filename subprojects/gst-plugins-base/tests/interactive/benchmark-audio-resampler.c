@@ -0,0 +1,199 @@
+/* GStreamer audio resampler benchmark
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+
+#define DEFAULT_IN_RATE 48000
+#define DEFAULT_OUT_RATE 44100
+
+#define DEFAULT_DURATION 0.5
+
+/* input frames per call, 10ms at 48kHz */
+#define BLOCK_SIZE 480
+
+static const gint channel_counts[] = { 1, 2, 8, 16, 64 };
+
+static const guint qualities[] = { 0, GST_AUDIO_RESAMPLER_QUALITY_DEFAULT,
+  GST_AUDIO_RESAMPLER_QUALITY_MAX
+};
+
+static const GstAudioFormat formats[] = {
+  GST_AUDIO_FORMAT_S16, GST_AUDIO_FORMAT_S32,
+  GST_AUDIO_FORMAT_F32, GST_AUDIO_FORMAT_F64
+};
+
+static const struct
+{
+  const gchar *name;
+  GstAudioResamplerFilterMode mode;
+  GstAudioResamplerFilterInterpolation interpolation;
+} filters[] = {
+  {"full", GST_AUDIO_RESAMPLER_FILTER_MODE_FULL,
+      GST_AUDIO_RESAMPLER_FILTER_INTERPOLATION_NONE},
+  {"linear", GST_AUDIO_RESAMPLER_FILTER_MODE_INTERPOLATED,
+      GST_AUDIO_RESAMPLER_FILTER_INTERPOLATION_LINEAR},
+  {"cubic", GST_AUDIO_RESAMPLER_FILTER_MODE_INTERPOLATED,
+      GST_AUDIO_RESAMPLER_FILTER_INTERPOLATION_CUBIC},
+};
+
+static void
+do_benchmark_resample (GstAudioFormat format, const gchar * filter_name,
+    GstAudioResamplerFilterMode mode,
+    GstAudioResamplerFilterInterpolation interpolation, guint quality,
+    gint channels, gint in_rate, gint out_rate, gdouble max_duration)
+{
+  const GstAudioFormatInfo *finfo = gst_audio_format_get_info (format);
+  GstAudioResampler *resampler;
+  GstStructure *options;
+  gpointer in, out;
+  gsize out_frames, bpf, frames = 0;
+  GTimer *timer;
+  gdouble elapsed;
+
+  options = gst_structure_new_empty ("resampler");
+  gst_audio_resampler_options_set_quality (GST_AUDIO_RESAMPLER_METHOD_KAISER,
+      quality, in_rate, out_rate, options);
+  gst_structure_set (options,
+      GST_AUDIO_RESAMPLER_OPT_FILTER_MODE, GST_TYPE_AUDIO_RESAMPLER_FILTER_MODE,
+      mode, GST_AUDIO_RESAMPLER_OPT_FILTER_INTERPOLATION,
+      GST_TYPE_AUDIO_RESAMPLER_FILTER_INTERPOLATION, interpolation, NULL);
+
+  resampler = gst_audio_resampler_new (GST_AUDIO_RESAMPLER_METHOD_KAISER,
+      GST_AUDIO_RESAMPLER_FLAG_NONE, format, channels, in_rate, out_rate,
+      options);
+  gst_structure_free (options);
+
+  bpf = GST_AUDIO_FORMAT_INFO_WIDTH (finfo) / 8 * channels;
+  /* silence is fine, the filter does not look at the sample values */
+  in = g_malloc0 (BLOCK_SIZE * bpf);
+  out = g_malloc0 ((gst_audio_resampler_get_out_frames (resampler,
+              BLOCK_SIZE) + 1) * bpf);
+
+  /* warmup */
+  out_frames = gst_audio_resampler_get_out_frames (resampler, BLOCK_SIZE);
+  gst_audio_resampler_resample (resampler, &in, BLOCK_SIZE, &out, out_frames);
+
+  timer = g_timer_new ();
+  while (TRUE) {
+    out_frames = gst_audio_resampler_get_out_frames (resampler, BLOCK_SIZE);
+    gst_audio_resampler_resample (resampler, &in, BLOCK_SIZE, &out,
+        out_frames);
+    frames += out_frames;
+
+    elapsed = g_timer_elapsed (timer, NULL);
+    if (elapsed >= max_duration)
+      break;
+  }
+
+  /* realtime factor of the output, how many streams could run on one core */
+  gst_println ("%10.1f x realtime %s %-6s q%-2u %2d channels %d -> %d, "
+      "%8.2f Msamples/sec", frames / elapsed / out_rate,
+      GST_AUDIO_FORMAT_INFO_NAME (finfo), filter_name, quality, channels,
+      in_rate, out_rate, frames * channels / elapsed / 1e6);
+
+  g_timer_destroy (timer);
+  g_free (in);
+  g_free (out);
+  gst_audio_resampler_free (resampler);
+}
+
+int
+main (int argc, char **argv)
+{
+  GError *err = NULL;
+  gint in_rate = DEFAULT_IN_RATE;
+  gint out_rate = DEFAULT_OUT_RATE;
+  gint channels = 0;
+  gint quality = -1;
+  gdouble max_dur = DEFAULT_DURATION;
+  gchar *format_str = NULL;
+  gchar *filter_str = NULL;
+  GOptionContext *ctx;
+  GOptionEntry options[] = {
+    {"in-rate", 'i', 0, G_OPTION_ARG_INT, &in_rate, "Input rate", NULL},
+    {"out-rate", 'o', 0, G_OPTION_ARG_INT, &out_rate, "Output rate", NULL},
+    {"channels", 'c', 0, G_OPTION_ARG_INT, &channels,
+        "Number of channels (default: 1, 2, 8, 16 and 64)", NULL},
+    {"quality", 'q', 0, G_OPTION_ARG_INT, &quality,
+        "Quality 0-10 (default: 0, 4 and 10)", NULL},
+    {"format", 'f', 0, G_OPTION_ARG_STRING, &format_str,
+        "Sample format (default: S16, S32, F32 and F64)", NULL},
+    {"filter", 't', 0, G_OPTION_ARG_STRING, &filter_str,
+        "Filter: full, linear or cubic (default: all)", NULL},
+    {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &max_dur,
+        "Benchmark duration for each run (in seconds)", NULL},
+    {NULL}
+  };
+  guint f, t, q, c, n_qualities, n_channels;
+  const guint *quality_list;
+  const gint *channel_list;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_print ("Error initializing: %s\n", GST_STR_NULL (err->message));
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (quality >= 0) {
+    quality = MIN (quality, GST_AUDIO_RESAMPLER_QUALITY_MAX);
+    quality_list = (const guint *) &quality;
+    n_qualities = 1;
+  } else {
+    quality_list = qualities;
+    n_qualities = G_N_ELEMENTS (qualities);
+  }
+
+  if (channels > 0) {
+    channel_list = &channels;
+    n_channels = 1;
+  } else {
+    channel_list = channel_counts;
+    n_channels = G_N_ELEMENTS (channel_counts);
+  }
+
+  for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+    /* allow S16 as well as S16LE */
+    if (format_str != NULL && !g_str_has_prefix (gst_audio_format_to_string
+            (formats[f]), format_str))
+      continue;
+
+    for (t = 0; t < G_N_ELEMENTS (filters); t++) {
+      if (filter_str != NULL && !g_str_equal (filter_str, filters[t].name))
+        continue;
+
+      for (q = 0; q < n_qualities; q++) {
+        for (c = 0; c < n_channels; c++) {
+          do_benchmark_resample (formats[f], filters[t].name,
+              filters[t].mode, filters[t].interpolation, quality_list[q],
+              channel_list[c], in_rate, out_rate, max_dur);
+        }
+      }
+    }
+  }
+  return 0;
+}
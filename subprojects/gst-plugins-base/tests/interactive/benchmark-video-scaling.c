@@ -0,0 +1,169 @@
+/* GStreamer video scaling benchmark
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+/* 8K -> 1080p */
+#define DEFAULT_IN_WIDTH 7680
+#define DEFAULT_IN_HEIGHT 4320
+#define DEFAULT_OUT_WIDTH 1920
+#define DEFAULT_OUT_HEIGHT 1080
+
+#define DEFAULT_CACHE_SIZE (256 * 1024)
+
+#define DEFAULT_DURATION 2.0
+
+static const GstVideoFormat formats[] = {
+  GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_NV12, GST_VIDEO_FORMAT_RGBA,
+  GST_VIDEO_FORMAT_I420_10LE, GST_VIDEO_FORMAT_AYUV64
+};
+
+static gdouble
+time_convert (GstVideoConverter * convert, GstVideoFrame * inframe,
+    GstVideoFrame * outframe, gdouble max_duration)
+{
+  GTimer *timer;
+  gdouble elapsed;
+  gint count = 0;
+
+  /* warmup, also allocates the scratch lines of the tiles */
+  gst_video_converter_frame (convert, inframe, outframe);
+
+  timer = g_timer_new ();
+  while (TRUE) {
+    gst_video_converter_frame (convert, inframe, outframe);
+
+    count++;
+    elapsed = g_timer_elapsed (timer, NULL);
+    if (elapsed >= max_duration)
+      break;
+  }
+  g_timer_destroy (timer);
+
+  return count / elapsed;
+}
+
+static GstVideoConverter *
+new_converter (const GstVideoInfo * ininfo, const GstVideoInfo * outinfo,
+    guint threads, guint cache_size)
+{
+  return gst_video_converter_new (ininfo, outinfo,
+      gst_structure_new ("options",
+          GST_VIDEO_CONVERTER_OPT_THREADS, G_TYPE_UINT, threads,
+          GST_VIDEO_CONVERTER_OPT_TILE_CACHE_SIZE, G_TYPE_UINT, cache_size,
+          NULL));
+}
+
+/* compares scaling in cache sized tiles with scaling whole lines, which is
+ * what a tile cache size of 0 does */
+static void
+do_benchmark_scaling (GstVideoFormat format, gint in_width, gint in_height,
+    gint out_width, gint out_height, guint threads, guint cache_size,
+    gdouble max_duration)
+{
+  GstVideoInfo ininfo, outinfo;
+  GstVideoFrame inframe, outframe;
+  GstBuffer *inbuffer, *outbuffer;
+  GstVideoConverter *convert;
+  gdouble tiled_sec, lines_sec;
+
+  gst_video_info_set_format (&ininfo, format, in_width, in_height);
+  gst_video_info_set_format (&outinfo, format, out_width, out_height);
+
+  inbuffer = gst_buffer_new_and_alloc (ininfo.size);
+  gst_buffer_memset (inbuffer, 0, 0, -1);
+  outbuffer = gst_buffer_new_and_alloc (outinfo.size);
+  gst_video_frame_map (&inframe, &ininfo, inbuffer, GST_MAP_READ);
+  gst_video_frame_map (&outframe, &outinfo, outbuffer, GST_MAP_WRITE);
+
+  convert = new_converter (&ininfo, &outinfo, threads, cache_size);
+  tiled_sec = time_convert (convert, &inframe, &outframe, max_duration);
+  gst_video_converter_free (convert);
+
+  convert = new_converter (&ininfo, &outinfo, threads, 0);
+  lines_sec = time_convert (convert, &inframe, &outframe, max_duration);
+  gst_video_converter_free (convert);
+
+  gst_println ("%8.1f tiled/sec %8.1f lines/sec %5.2fx %-10s %dx%d -> %dx%d, "
+      "%u threads", tiled_sec, lines_sec, tiled_sec / lines_sec,
+      gst_video_format_to_string (format), in_width, in_height, out_width,
+      out_height, threads);
+
+  gst_video_frame_unmap (&inframe);
+  gst_video_frame_unmap (&outframe);
+  gst_buffer_unref (inbuffer);
+  gst_buffer_unref (outbuffer);
+}
+
+int
+main (int argc, char **argv)
+{
+  GError *err = NULL;
+  gint in_width = DEFAULT_IN_WIDTH;
+  gint in_height = DEFAULT_IN_HEIGHT;
+  gint out_width = DEFAULT_OUT_WIDTH;
+  gint out_height = DEFAULT_OUT_HEIGHT;
+  gint threads = 1;
+  gint cache_size = DEFAULT_CACHE_SIZE;
+  gdouble max_dur = DEFAULT_DURATION;
+  gchar *format_str = NULL;
+  GOptionContext *ctx;
+  GOptionEntry options[] = {
+    {"in-width", 'w', 0, G_OPTION_ARG_INT, &in_width, "Input width", NULL},
+    {"in-height", 'h', 0, G_OPTION_ARG_INT, &in_height, "Input height", NULL},
+    {"out-width", 'W', 0, G_OPTION_ARG_INT, &out_width, "Output width", NULL},
+    {"out-height", 'H', 0, G_OPTION_ARG_INT, &out_height, "Output height",
+        NULL},
+    {"format", 'f', 0, G_OPTION_ARG_STRING, &format_str,
+        "Format (default: I420, NV12, RGBA, I420_10LE and AYUV64)", NULL},
+    {"threads", 't', 0, G_OPTION_ARG_INT, &threads,
+        "Number of threads, 0 for the number of cores", NULL},
+    {"cache-size", 'c', 0, G_OPTION_ARG_INT, &cache_size,
+        "Tile cache size in bytes", NULL},
+    {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &max_dur,
+        "Benchmark duration for each run (in seconds)", NULL},
+    {NULL}
+  };
+  guint f;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_print ("Error initializing: %s\n", GST_STR_NULL (err->message));
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+    if (format_str != NULL && !g_str_equal (format_str,
+            gst_video_format_to_string (formats[f])))
+      continue;
+
+    do_benchmark_scaling (formats[f], in_width, in_height, out_width,
+        out_height, MAX (threads, 0), MAX (cache_size, 0), max_dur);
+  }
+  return 0;
+}
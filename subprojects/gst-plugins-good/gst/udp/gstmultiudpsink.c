@@ -44,6 +44,11 @@
 
 #include <gio/gnetworking.h>
 
+/* For UDP_SEGMENT */
+#ifndef G_PLATFORM_WIN32
+#include <netinet/udp.h>
+#endif
+
 #include "gst/net/net.h"
 #include "gst/glib-compat-private.h"
 
@@ -52,6 +57,121 @@ GST_DEBUG_CATEGORY_STATIC (multiudpsink_debug);
 
 #define UDP_MAX_SIZE 65507
 
+/* maximum number of packets the kernel segments from one send */
+#define UDP_MAX_SEGMENTS 64
+
+/* A run of consecutive buffers that are sent as one message and split into
+ * packets by the kernel. All but the last packet have segment_size bytes */
+struct _GstUDPSegmentGroup
+{
+  guint first;
+  guint n_buffers;
+  GSocketControlMessage *segment_msg;
+};
+
+#ifdef UDP_SEGMENT
+GType gst_udp_segment_message_get_type (void);
+
+#define GST_TYPE_UDP_SEGMENT_MESSAGE          (gst_udp_segment_message_get_type ())
+#define GST_UDP_SEGMENT_MESSAGE(o)            (G_TYPE_CHECK_INSTANCE_CAST ((o), GST_TYPE_UDP_SEGMENT_MESSAGE, GstUDPSegmentMessage))
+#define GST_UDP_SEGMENT_MESSAGE_CLASS(c)      (G_TYPE_CHECK_CLASS_CAST ((c), GST_TYPE_UDP_SEGMENT_MESSAGE, GstUDPSegmentMessageClass))
+#define GST_IS_UDP_SEGMENT_MESSAGE(o)         (G_TYPE_CHECK_INSTANCE_TYPE ((o), GST_TYPE_UDP_SEGMENT_MESSAGE))
+#define GST_IS_UDP_SEGMENT_MESSAGE_CLASS(c)   (G_TYPE_CHECK_CLASS_TYPE ((c), GST_TYPE_UDP_SEGMENT_MESSAGE))
+#define GST_UDP_SEGMENT_MESSAGE_GET_CLASS(o)  (G_TYPE_INSTANCE_GET_CLASS ((o), GST_TYPE_UDP_SEGMENT_MESSAGE, GstUDPSegmentMessageClass))
+
+typedef struct _GstUDPSegmentMessage GstUDPSegmentMessage;
+typedef struct _GstUDPSegmentMessageClass GstUDPSegmentMessageClass;
+
+struct _GstUDPSegmentMessageClass
+{
+  GSocketControlMessageClass parent_class;
+};
+
+struct _GstUDPSegmentMessage
+{
+  GSocketControlMessage parent;
+
+  guint16 segment_size;
+};
+
+G_DEFINE_TYPE (GstUDPSegmentMessage, gst_udp_segment_message,
+    G_TYPE_SOCKET_CONTROL_MESSAGE);
+
+static gsize
+gst_udp_segment_message_get_size (GSocketControlMessage * message)
+{
+  return sizeof (guint16);
+}
+
+static int
+gst_udp_segment_message_get_level (GSocketControlMessage * message)
+{
+  return SOL_UDP;
+}
+
+static int
+gst_udp_segment_message_get_msg_type (GSocketControlMessage * message)
+{
+  return UDP_SEGMENT;
+}
+
+static void
+gst_udp_segment_message_serialize (GSocketControlMessage * message,
+    gpointer data)
+{
+  GstUDPSegmentMessage *msg = GST_UDP_SEGMENT_MESSAGE (message);
+
+  memcpy (data, &msg->segment_size, sizeof (guint16));
+}
+
+static GSocketControlMessage *
+gst_udp_segment_message_deserialize (gint level, gint type, gsize size,
+    gpointer data)
+{
+  GstUDPSegmentMessage *message;
+
+  if (level != SOL_UDP || type != UDP_SEGMENT)
+    return NULL;
+
+  if (size < sizeof (guint16))
+    return NULL;
+
+  message = g_object_new (GST_TYPE_UDP_SEGMENT_MESSAGE, NULL);
+  memcpy (&message->segment_size, data, sizeof (guint16));
+
+  return G_SOCKET_CONTROL_MESSAGE (message);
+}
+
+static void
+gst_udp_segment_message_init (GstUDPSegmentMessage * message)
+{
+}
+
+static void
+gst_udp_segment_message_class_init (GstUDPSegmentMessageClass * class)
+{
+  GSocketControlMessageClass *scm_class;
+
+  scm_class = G_SOCKET_CONTROL_MESSAGE_CLASS (class);
+  scm_class->get_size = gst_udp_segment_message_get_size;
+  scm_class->get_level = gst_udp_segment_message_get_level;
+  scm_class->get_type = gst_udp_segment_message_get_msg_type;
+  scm_class->serialize = gst_udp_segment_message_serialize;
+  scm_class->deserialize = gst_udp_segment_message_deserialize;
+}
+
+static GSocketControlMessage *
+gst_udp_segment_message_new (gsize segment_size)
+{
+  GstUDPSegmentMessage *message;
+
+  message = g_object_new (GST_TYPE_UDP_SEGMENT_MESSAGE, NULL);
+  message->segment_size = segment_size;
+
+  return G_SOCKET_CONTROL_MESSAGE (message);
+}
+#endif
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -92,6 +212,7 @@ enum
 #define DEFAULT_BUFFER_SIZE        0
 #define DEFAULT_BIND_ADDRESS       NULL
 #define DEFAULT_BIND_PORT          0
+#define DEFAULT_GSO                FALSE
 
 enum
 {
@@ -114,7 +235,8 @@ enum
   PROP_SEND_DUPLICATES,
   PROP_BUFFER_SIZE,
   PROP_BIND_ADDRESS,
-  PROP_BIND_PORT
+  PROP_BIND_PORT,
+  PROP_GSO
 };
 
 static void gst_multiudpsink_finalize (GObject * object);
@@ -351,6 +473,26 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
           "Port to bind the socket to", 0, G_MAXUINT16,
           DEFAULT_BIND_PORT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMultiUDPSink:gso:
+   *
+   * Use UDP generic segmentation offload if supported by the system.
+   * Consecutive packets of the same size in a buffer list are then passed
+   * to the kernel as a single message per client, which splits them into
+   * separate packets again.
+   *
+   * If the kernel refuses to segment a message, e.g. because the packets
+   * are bigger than the path MTU, the packets are sent separately and
+   * segmentation offload stays disabled until the next restart.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_GSO,
+      g_param_spec_boolean ("gso", "GSO",
+          "Use UDP generic segmentation offload for buffer lists if "
+          "supported by the system", DEFAULT_GSO,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
 
   gst_element_class_set_static_metadata (gstelement_class, "UDP packet sender",
@@ -371,6 +513,10 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
   klass->get_stats = gst_multiudpsink_get_stats;
 
   GST_DEBUG_CATEGORY_INIT (multiudpsink_debug, "multiudpsink", 0, "UDP sink");
+
+#ifdef UDP_SEGMENT
+  GST_TYPE_UDP_SEGMENT_MESSAGE;
+#endif
 }
 
 static void
@@ -419,12 +565,14 @@ gst_multiudpsink_init (GstMultiUDPSink * sink)
   sink->qos_dscp = DEFAULT_QOS_DSCP;
   sink->send_duplicates = DEFAULT_SEND_DUPLICATES;
   sink->multi_iface = g_strdup (DEFAULT_MULTICAST_IFACE);
+  sink->gso = DEFAULT_GSO;
 
   gst_multiudpsink_create_cancellable (sink);
 
   /* pre-allocate OutputVector, MapInfo and OutputMessage arrays
-   * for use in the render and render_list functions */
-  max_mem = gst_buffer_get_max_memory ();
+   * for use in the render and render_list functions, they are grown later
+   * if buffers with more memories show up */
+  max_mem = MIN (gst_buffer_get_max_memory (), 16);
 
   sink->n_vecs = max_mem;
   sink->vecs = g_new (GOutputVector, sink->n_vecs);
@@ -434,9 +582,6 @@ gst_multiudpsink_init (GstMultiUDPSink * sink)
 
   sink->n_messages = 1;
   sink->messages = g_new (GstOutputMessage, sink->n_messages);
-
-  /* we assume that the number of memories per buffer can fit into a guint8 */
-  g_warn_if_fail (max_mem <= G_MAXUINT8);
 }
 
 static GstUDPClient *
@@ -557,6 +702,10 @@ gst_multiudpsink_finalize (GObject * object)
   sink->maps = NULL;
   g_free (sink->messages);
   sink->messages = NULL;
+  g_free (sink->groups);
+  sink->groups = NULL;
+  g_free (sink->gso_messages);
+  sink->gso_messages = NULL;
 
   g_free (sink->bind_address);
   sink->bind_address = NULL;
@@ -634,6 +783,39 @@ gst_udp_address_get_string (GSocketAddress * addr, gchar * s, gsize size)
   return s;
 }
 
+#ifdef UDP_SEGMENT
+/* Sends the packets of a message the kernel refused to segment one by one.
+ * The vectors of each packet add up to exactly segment_size bytes */
+static gboolean
+gst_multiudpsink_send_segments (GstMultiUDPSink * sink, GSocket * socket,
+    GstOutputMessage * msg, GError ** err)
+{
+  GstUDPSegmentMessage *segment_msg;
+  guint i = 0;
+
+  segment_msg = GST_UDP_SEGMENT_MESSAGE (msg->control_messages[0]);
+  msg->bytes_sent = 0;
+
+  while (i < msg->num_vectors) {
+    guint first = i;
+    gsize size = 0;
+    gssize ret;
+
+    while (i < msg->num_vectors && size < segment_msg->segment_size)
+      size += msg->vectors[i++].size;
+
+    ret = g_socket_send_message (socket, msg->address, &msg->vectors[first],
+        i - first, NULL, 0, 0, sink->cancellable, err);
+    if (ret < 0)
+      return FALSE;
+
+    msg->bytes_sent += ret;
+  }
+
+  return TRUE;
+}
+#endif
+
 /* Wrapper around g_socket_send_messages() plus error handling (ignoring).
  * Returns FALSE if we got cancelled, otherwise TRUE. */
 static GstFlowReturn
@@ -674,6 +856,36 @@ gst_multiudpsink_send_messages (GstMultiUDPSink * sink, GSocket * socket,
       msg = &messages[err_idx];
       msg_size = gst_udp_calc_message_size (msg);
 
+#ifdef UDP_SEGMENT
+      if (msg->num_control_messages > 0
+          && GST_IS_UDP_SEGMENT_MESSAGE (msg->control_messages[0])) {
+        GST_WARNING_OBJECT (sink, "kernel refused to segment %u bytes for "
+            "client %s, disabling GSO: %s", msg_size,
+            gst_udp_address_get_string (msg->address, astr, sizeof (astr)),
+            err->message);
+        sink->gso_enabled = FALSE;
+        g_clear_error (&err);
+
+        if (gst_multiudpsink_send_segments (sink, socket, msg, &err)) {
+          ret = err_idx + 1;
+          goto next;
+        }
+
+        if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+          GstFlowReturn flow_ret;
+
+          g_clear_error (&err);
+
+          flow_ret = gst_base_sink_wait_preroll (GST_BASE_SINK (sink));
+
+          if (flow_ret == GST_FLOW_OK)
+            continue;
+
+          return flow_ret;
+        }
+      }
+#endif
+
       GST_LOG_OBJECT (sink, "error sending %u bytes to client %s: %s", msg_size,
           gst_udp_address_get_string (msg->address, astr, sizeof (astr)),
           err->message);
@@ -705,6 +917,9 @@ gst_multiudpsink_send_messages (GstMultiUDPSink * sink, GSocket * socket,
       ret = skip;
     }
 
+#ifdef UDP_SEGMENT
+  next:
+#endif
     g_assert (ret <= num_messages);
 
     messages += ret;
@@ -714,11 +929,95 @@ gst_multiudpsink_send_messages (GstMultiUDPSink * sink, GSocket * socket,
   return GST_FLOW_OK;
 }
 
+#ifdef UDP_SEGMENT
+/* Collects runs of consecutive packets where all but the last have the same
+ * size into groups that the kernel can segment, and prepares one message per
+ * group in sink->gso_messages. Returns the number of groups */
+static guint
+gst_multiudpsink_build_segment_groups (GstMultiUDPSink * sink,
+    GstOutputMessage * msgs, guint num_buffers, guint num_addr)
+{
+  GstOutputMessage *gso_msgs;
+  guint i, n_groups = 0;
+
+  if (sink->n_groups < num_buffers) {
+    sink->n_groups = GST_ROUND_UP_16 (num_buffers);
+    g_free (sink->groups);
+    sink->groups = g_new (GstUDPSegmentGroup, sink->n_groups);
+  }
+
+  for (i = 0; i < num_buffers;) {
+    GstUDPSegmentGroup *group = &sink->groups[n_groups++];
+    gsize segment_size, total_size;
+
+    segment_size = total_size = gst_udp_calc_message_size (&msgs[i]);
+
+    group->first = i;
+    group->n_buffers = 1;
+    group->segment_msg = NULL;
+
+    while (segment_size > 0 && i + group->n_buffers < num_buffers
+        && group->n_buffers < UDP_MAX_SEGMENTS) {
+      gsize size = gst_udp_calc_message_size (&msgs[i + group->n_buffers]);
+
+      if (size == 0 || size > segment_size
+          || total_size + size > UDP_MAX_SIZE)
+        break;
+
+      total_size += size;
+      group->n_buffers++;
+
+      /* only the last packet of a group may be smaller */
+      if (size < segment_size)
+        break;
+    }
+
+    i += group->n_buffers;
+  }
+
+  /* nothing to coalesce, use the normal path */
+  if (n_groups == num_buffers)
+    return n_groups;
+
+  if (sink->n_gso_messages < n_groups * num_addr) {
+    sink->n_gso_messages = GST_ROUND_UP_16 (n_groups * num_addr);
+    g_free (sink->gso_messages);
+    sink->gso_messages = g_new (GstOutputMessage, sink->n_gso_messages);
+  }
+  gso_msgs = sink->gso_messages;
+
+  /* the vectors of consecutive buffers are consecutive too */
+  for (i = 0; i < n_groups; ++i) {
+    GstUDPSegmentGroup *group = &sink->groups[i];
+    GstOutputMessage *first = &msgs[group->first];
+    guint j;
+
+    gso_msgs[i] = *first;
+    for (j = 1; j < group->n_buffers; ++j)
+      gso_msgs[i].num_vectors += msgs[group->first + j].num_vectors;
+
+    if (group->n_buffers > 1) {
+      group->segment_msg =
+          gst_udp_segment_message_new (gst_udp_calc_message_size (first));
+      gso_msgs[i].control_messages = &group->segment_msg;
+      gso_msgs[i].num_control_messages = 1;
+    }
+  }
+
+  GST_LOG_OBJECT (sink, "coalesced %u packets into %u messages", num_buffers,
+      n_groups);
+
+  return n_groups;
+}
+#endif
+
 static GstFlowReturn
 gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
-    guint num_buffers, guint8 * mem_nums, guint total_mem_num)
+    guint num_buffers, guint * mem_nums, guint total_mem_num)
 {
   GstOutputMessage *msgs;
+  GstUDPSegmentGroup *groups = NULL;
+  guint num_units;
   gboolean send_duplicates;
   GstUDPClient **clients;
   GOutputVector *vecs;
@@ -799,12 +1098,30 @@ gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
   /* FIXME: how about some locking? (there wasn't any before either, but..) */
   sink->bytes_to_serve += size;
 
-  /* now copy the pre-filled num_buffer messages over to the next num_buffer
+  /* with GSO one message per group of packets is sent to every client,
+   * otherwise one message per buffer */
+  num_units = num_buffers;
+#ifdef UDP_SEGMENT
+  if (sink->gso_enabled && num_buffers > 1) {
+    guint n_groups;
+
+    n_groups = gst_multiudpsink_build_segment_groups (sink, msgs, num_buffers,
+        num_addr);
+    if (n_groups < num_buffers) {
+      groups = sink->groups;
+      num_units = n_groups;
+      msgs = sink->gso_messages;
+    }
+  }
+#endif
+  num_msgs = num_addr * num_units;
+
+  /* now copy the pre-filled num_units messages over to the next num_units
    * messages for the next client, where we also change the target address */
   for (i = 1; i < num_addr; ++i) {
-    for (j = 0; j < num_buffers; ++j) {
-      msgs[i * num_buffers + j] = msgs[j];
-      msgs[i * num_buffers + j].address = clients[i]->addr;
+    for (j = 0; j < num_units; ++j) {
+      msgs[i * num_units + j] = msgs[j];
+      msgs[i * num_units + j].address = clients[i]->addr;
     }
   }
 
@@ -815,8 +1132,8 @@ gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
     flow_ret = gst_multiudpsink_send_messages (sink, sink->used_socket_v6,
         msgs, num_msgs);
   } else {
-    guint num_msgs_v4 = num_buffers * num_addr_v4;
-    guint num_msgs_v6 = num_buffers * num_addr_v6;
+    guint num_msgs_v4 = num_units * num_addr_v4;
+    guint num_msgs_v6 = num_units * num_addr_v6;
 
     /* our client list is sorted with IPv4 clients first and IPv6 ones last */
     flow_ret = gst_multiudpsink_send_messages (sink, sink->used_socket,
@@ -838,13 +1155,13 @@ gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
   for (i = 0; i < num_addr; ++i) {
     GstUDPClient *client = clients[i];
 
-    for (j = 0; j < num_buffers; ++j) {
+    for (j = 0; j < num_units; ++j) {
       gsize bytes_sent;
 
-      bytes_sent = msgs[i * num_buffers + j].bytes_sent;
+      bytes_sent = msgs[i * num_units + j].bytes_sent;
 
       client->bytes_sent += bytes_sent;
-      client->packets_sent++;
+      client->packets_sent += groups ? groups[j].n_buffers : 1;
       sink->bytes_served += bytes_sent;
     }
     gst_udp_client_unref (client);
@@ -854,6 +1171,9 @@ gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
 
 out:
 
+  for (i = 0; groups != NULL && i < num_units; ++i)
+    g_clear_object (&groups[i].segment_msg);
+
   for (i = 0; i < mem; ++i)
     gst_memory_unmap (map_infos[i].memory, &map_infos[i]);
 
@@ -883,7 +1203,7 @@ gst_multiudpsink_render_list (GstBaseSink * bsink, GstBufferList * buffer_list)
   GstMultiUDPSink *sink;
   GstBuffer **buffers;
   GstFlowReturn flow;
-  guint8 *mem_nums;
+  guint *mem_nums;
   guint total_mems;
   guint i, num_buffers;
 
@@ -894,7 +1214,7 @@ gst_multiudpsink_render_list (GstBaseSink * bsink, GstBufferList * buffer_list)
     goto no_data;
 
   buffers = g_newa (GstBuffer *, num_buffers);
-  mem_nums = g_newa (guint8, num_buffers);
+  mem_nums = g_newa (guint, num_buffers);
   for (i = 0, total_mems = 0; i < num_buffers; ++i) {
     buffers[i] = gst_buffer_list_get (buffer_list, i);
     mem_nums[i] = gst_buffer_n_memory (buffers[i]);
@@ -918,7 +1238,7 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
 {
   GstMultiUDPSink *sink;
   GstFlowReturn flow;
-  guint8 n_mem;
+  guint n_mem;
 
   sink = GST_MULTIUDPSINK_CAST (bsink);
 
@@ -1094,6 +1414,9 @@ gst_multiudpsink_set_property (GObject * object, guint prop_id,
     case PROP_BIND_PORT:
       udpsink->bind_port = g_value_get_int (value);
       break;
+    case PROP_GSO:
+      udpsink->gso = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1167,6 +1490,9 @@ gst_multiudpsink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_BIND_PORT:
       g_value_set_int (value, udpsink->bind_port);
       break;
+    case PROP_GSO:
+      g_value_set_boolean (value, udpsink->gso);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1440,6 +1766,29 @@ gst_multiudpsink_start (GstBaseSink * bsink)
   gst_multiudpsink_setup_qos_dscp (sink, sink->used_socket);
   gst_multiudpsink_setup_qos_dscp (sink, sink->used_socket_v6);
 
+  sink->gso_enabled = FALSE;
+  if (sink->gso) {
+#ifdef UDP_SEGMENT
+    gint segment_size;
+
+    /* UDP_SEGMENT is only known to the kernel if it can segment for us */
+    sink->gso_enabled = TRUE;
+    if (sink->used_socket && !g_socket_get_option (sink->used_socket, SOL_UDP,
+            UDP_SEGMENT, &segment_size, NULL))
+      sink->gso_enabled = FALSE;
+    if (sink->used_socket_v6 && !g_socket_get_option (sink->used_socket_v6,
+            SOL_UDP, UDP_SEGMENT, &segment_size, NULL))
+      sink->gso_enabled = FALSE;
+
+    if (sink->gso_enabled)
+      GST_DEBUG_OBJECT (sink, "using UDP segmentation offload");
+    else
+      GST_WARNING_OBJECT (sink, "UDP segmentation offload not supported");
+#else
+    GST_WARNING_OBJECT (sink, "UDP segmentation offload not supported");
+#endif
+  }
+
   /* look for multicast clients and join multicast groups appropriately
      set also ttl and multicast loopback delivery appropriately  */
   for (clients = sink->clients; clients; clients = g_list_next (clients)) {
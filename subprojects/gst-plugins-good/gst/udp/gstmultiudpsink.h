@@ -40,6 +40,8 @@ typedef struct _GstMultiUDPSinkClass GstMultiUDPSinkClass;
 
 typedef GOutputMessage GstOutputMessage;
 
+typedef struct _GstUDPSegmentGroup GstUDPSegmentGroup;
+
 typedef struct {
   gint ref_count;         /* for memory management */
   gint add_count;         /* how often this address has been added */
@@ -81,6 +83,10 @@ struct _GstMultiUDPSink {
   guint             n_maps;
   GstOutputMessage *messages;
   guint             n_messages;
+  GstUDPSegmentGroup *groups;
+  guint             n_groups;
+  GstOutputMessage *gso_messages;
+  guint             n_gso_messages;
 
   /* properties */
   guint64        bytes_to_serve;
@@ -102,6 +108,10 @@ struct _GstMultiUDPSink {
   gint           buffer_size;
   gchar         *bind_address;
   gint           bind_port;
+  gboolean       gso;
+
+  /* TRUE if the kernel supports UDP_SEGMENT on our sockets */
+  gboolean       gso_enabled;
 };
 
 struct _GstMultiUDPSinkClass {
@@ -125,6 +125,8 @@
  * on non-Windows and can be included after glib.h */
 #ifndef G_PLATFORM_WIN32
 #include <netinet/ip.h>
+/* For UDP_GRO */
+#include <netinet/udp.h>
 #endif
 
 /* Control messages for getting the destination address */
@@ -507,6 +509,111 @@ gst_socket_timestamp_message_class_init (GstSocketTimestampMessageClass * class)
 }
 #endif
 
+#ifdef UDP_GRO
+GType gst_udp_gro_message_get_type (void);
+
+#define GST_TYPE_UDP_GRO_MESSAGE          (gst_udp_gro_message_get_type ())
+#define GST_UDP_GRO_MESSAGE(o)            (G_TYPE_CHECK_INSTANCE_CAST ((o), GST_TYPE_UDP_GRO_MESSAGE, GstUDPGroMessage))
+#define GST_UDP_GRO_MESSAGE_CLASS(c)      (G_TYPE_CHECK_CLASS_CAST ((c), GST_TYPE_UDP_GRO_MESSAGE, GstUDPGroMessageClass))
+#define GST_IS_UDP_GRO_MESSAGE(o)         (G_TYPE_CHECK_INSTANCE_TYPE ((o), GST_TYPE_UDP_GRO_MESSAGE))
+#define GST_IS_UDP_GRO_MESSAGE_CLASS(c)   (G_TYPE_CHECK_CLASS_TYPE ((c), GST_TYPE_UDP_GRO_MESSAGE))
+#define GST_UDP_GRO_MESSAGE_GET_CLASS(o)  (G_TYPE_INSTANCE_GET_CLASS ((o), GST_TYPE_UDP_GRO_MESSAGE, GstUDPGroMessageClass))
+
+typedef struct _GstUDPGroMessage GstUDPGroMessage;
+typedef struct _GstUDPGroMessageClass GstUDPGroMessageClass;
+
+struct _GstUDPGroMessageClass
+{
+  GSocketControlMessageClass parent_class;
+};
+
+struct _GstUDPGroMessage
+{
+  GSocketControlMessage parent;
+
+  /* size of each coalesced datagram, the last one may be shorter */
+  guint gso_size;
+};
+
+G_DEFINE_TYPE (GstUDPGroMessage, gst_udp_gro_message,
+    G_TYPE_SOCKET_CONTROL_MESSAGE);
+
+static gsize
+gst_udp_gro_message_get_size (GSocketControlMessage * message)
+{
+  return sizeof (int);
+}
+
+static int
+gst_udp_gro_message_get_level (GSocketControlMessage * message)
+{
+  return SOL_UDP;
+}
+
+static int
+gst_udp_gro_message_get_msg_type (GSocketControlMessage * message)
+{
+  return UDP_GRO;
+}
+
+static GSocketControlMessage *
+gst_udp_gro_message_deserialize (gint level, gint type, gsize size,
+    gpointer data)
+{
+  GstUDPGroMessage *message;
+  int gso_size;
+
+  if (level != SOL_UDP || type != UDP_GRO)
+    return NULL;
+
+  if (size < sizeof (int))
+    return NULL;
+
+  memcpy (&gso_size, data, sizeof (int));
+  if (gso_size <= 0)
+    return NULL;
+
+  message = g_object_new (GST_TYPE_UDP_GRO_MESSAGE, NULL);
+  message->gso_size = gso_size;
+
+  return G_SOCKET_CONTROL_MESSAGE (message);
+}
+
+static void
+gst_udp_gro_message_init (GstUDPGroMessage * message)
+{
+}
+
+static void
+gst_udp_gro_message_class_init (GstUDPGroMessageClass * class)
+{
+  GSocketControlMessageClass *scm_class;
+
+  scm_class = G_SOCKET_CONTROL_MESSAGE_CLASS (class);
+  scm_class->get_size = gst_udp_gro_message_get_size;
+  scm_class->get_level = gst_udp_gro_message_get_level;
+  scm_class->get_type = gst_udp_gro_message_get_msg_type;
+  scm_class->deserialize = gst_udp_gro_message_deserialize;
+}
+#endif
+
+/* One entry per datagram of a batched receive. Buffers that did not get
+ * any data are kept around for the next call */
+struct _GstUDPSrcBatchSlot
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  GInputVector vec;
+  GSocketAddress *saddr;
+  GSocketControlMessage **msgs;
+  guint n_msgs;
+};
+
+/* not 100% correct, but a good upper bound for memory allocation purposes */
+#define MAX_IPV4_UDP_PACKET_SIZE (65536 - 8)
+
+static void gst_udpsrc_clear_batch (GstUDPSrc * udpsrc);
+
 static gboolean
 gst_udpsrc_decide_allocation (GstBaseSrc * bsrc, GstQuery * query)
 {
@@ -515,38 +622,42 @@ gst_udpsrc_decide_allocation (GstBaseSrc * bsrc, GstQuery * query)
   gboolean update;
   GstStructure *config;
   GstCaps *caps = NULL;
+  guint size;
 
   udpsrc = GST_UDPSRC (bsrc);
 
+  /* buffers kept for batched receive belong to the previous pool */
+  gst_udpsrc_clear_batch (udpsrc);
+
   if (gst_query_get_n_allocation_pools (query) > 0) {
     update = TRUE;
   } else {
     update = FALSE;
   }
 
+  /* with GRO the kernel hands us several coalesced datagrams at once */
+  size = udpsrc->gro_enabled ? MAX_IPV4_UDP_PACKET_SIZE : udpsrc->mtu;
+
   pool = gst_buffer_pool_new ();
 
   config = gst_buffer_pool_get_config (pool);
 
   gst_query_parse_allocation (query, &caps, NULL);
 
-  gst_buffer_pool_config_set_params (config, caps, udpsrc->mtu, 0, 0);
+  gst_buffer_pool_config_set_params (config, caps, size, 0, 0);
 
   gst_buffer_pool_set_config (pool, config);
 
   if (update)
-    gst_query_set_nth_allocation_pool (query, 0, pool, udpsrc->mtu, 0, 0);
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, 0, 0);
   else
-    gst_query_add_allocation_pool (query, pool, udpsrc->mtu, 0, 0);
+    gst_query_add_allocation_pool (query, pool, size, 0, 0);
 
   gst_object_unref (pool);
 
   return TRUE;
 }
 
-/* not 100% correct, but a good upper bound for memory allocation purposes */
-#define MAX_IPV4_UDP_PACKET_SIZE (65536 - 8)
-
 GST_DEBUG_CATEGORY_STATIC (udpsrc_debug);
 #define GST_CAT_DEFAULT (udpsrc_debug)
 
@@ -572,6 +683,10 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
 #define UDP_DEFAULT_RETRIEVE_SENDER_ADDRESS TRUE
 #define UDP_DEFAULT_MTU                (1492)
 #define UDP_DEFAULT_MULTICAST_SOURCE   NULL
+#define UDP_DEFAULT_BATCH_SIZE         1
+#define UDP_DEFAULT_GRO                FALSE
+
+#define UDP_MAX_BATCH_SIZE             1024
 
 enum
 {
@@ -596,6 +711,8 @@ enum
   PROP_MTU,
   PROP_SOCKET_TIMESTAMP,
   PROP_MULTICAST_SOURCE,
+  PROP_BATCH_SIZE,
+  PROP_GRO,
 };
 
 static void gst_udpsrc_uri_handler_init (gpointer g_iface, gpointer iface_data);
@@ -604,7 +721,7 @@ static GstCaps *gst_udpsrc_getcaps (GstBaseSrc * src, GstCaps * filter);
 static gboolean gst_udpsrc_close (GstUDPSrc * src);
 static gboolean gst_udpsrc_unlock (GstBaseSrc * bsrc);
 static gboolean gst_udpsrc_unlock_stop (GstBaseSrc * bsrc);
-static GstFlowReturn gst_udpsrc_fill (GstPushSrc * psrc, GstBuffer * outbuf);
+static GstFlowReturn gst_udpsrc_create (GstPushSrc * psrc, GstBuffer ** buf);
 
 static void gst_udpsrc_finalize (GObject * object);
 
@@ -649,6 +766,9 @@ gst_udpsrc_class_init (GstUDPSrcClass * klass)
 #ifdef SO_TIMESTAMPNS
   GST_TYPE_SOCKET_TIMESTAMP_MESSAGE;
 #endif
+#ifdef UDP_GRO
+  GST_TYPE_UDP_GRO_MESSAGE;
+#endif
 
   gobject_class->set_property = gst_udpsrc_set_property;
   gobject_class->get_property = gst_udpsrc_get_property;
@@ -798,6 +918,40 @@ gst_udpsrc_class_init (GstUDPSrcClass * klass)
           UDP_DEFAULT_MULTICAST_SOURCE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstUDPSrc:batch-size:
+   *
+   * Maximum number of packets to read from the socket with a single system
+   * call. When bigger than 1, all packets that are available are pushed
+   * downstream together in a #GstBufferList.
+   *
+   * In batch mode packets bigger than #GstUDPSrc:mtu are dropped, so the
+   * mtu needs to be set to the largest expected packet size.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch Size",
+          "Maximum number of packets to receive with a single system call "
+          "and push downstream as one buffer list (1 = disabled)",
+          1, UDP_MAX_BATCH_SIZE, UDP_DEFAULT_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstUDPSrc:gro:
+   *
+   * Enable UDP generic receive offload if supported by the system. The
+   * kernel then coalesces consecutive packets of the same flow and size,
+   * which are split again into separate buffers without copying and pushed
+   * downstream in a #GstBufferList.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_GRO,
+      g_param_spec_boolean ("gro", "GRO",
+          "Enable UDP generic receive offload if supported by the system",
+          UDP_DEFAULT_GRO, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -813,7 +967,7 @@ gst_udpsrc_class_init (GstUDPSrcClass * klass)
   gstbasesrc_class->get_caps = gst_udpsrc_getcaps;
   gstbasesrc_class->decide_allocation = gst_udpsrc_decide_allocation;
 
-  gstpushsrc_class->fill = gst_udpsrc_fill;
+  gstpushsrc_class->create = gst_udpsrc_create;
 
   gst_type_mark_as_plugin_api (GST_TYPE_SOCKET_TIMESTAMP_MODE, 0);
 }
@@ -840,6 +994,8 @@ gst_udpsrc_init (GstUDPSrc * udpsrc)
   udpsrc->loop = UDP_DEFAULT_LOOP;
   udpsrc->retrieve_sender_address = UDP_DEFAULT_RETRIEVE_SENDER_ADDRESS;
   udpsrc->mtu = UDP_DEFAULT_MTU;
+  udpsrc->batch_size = UDP_DEFAULT_BATCH_SIZE;
+  udpsrc->gro = UDP_DEFAULT_GRO;
   udpsrc->source_list =
       g_ptr_array_new_with_free_func ((GDestroyNotify) g_free);
 
@@ -884,6 +1040,13 @@ gst_udpsrc_finalize (GObject * object)
     gst_memory_unref (udpsrc->extra_mem);
   udpsrc->extra_mem = NULL;
 
+  gst_udpsrc_clear_batch (udpsrc);
+  g_free (udpsrc->batch_slots);
+  udpsrc->batch_slots = NULL;
+  g_free (udpsrc->batch_msgs);
+  udpsrc->batch_msgs = NULL;
+  udpsrc->n_batch_slots = 0;
+
   g_ptr_array_unref (udpsrc->source_list);
   g_free (udpsrc->multicast_source);
 
@@ -936,6 +1099,188 @@ gst_udpsrc_free_cancellable (GstUDPSrc * src)
   src->cancellable = NULL;
 }
 
+static gboolean
+gst_udpsrc_needs_control_messages (GstUDPSrc * udpsrc)
+{
+  gboolean res;
+
+  /* optimization: use messages only in multicast mode and
+   * if we can't let the kernel do the filtering for us */
+  res =
+      g_inet_address_get_is_multicast (g_inet_socket_address_get_address
+      (udpsrc->addr));
+#ifdef IP_MULTICAST_ALL
+  if (g_inet_address_get_family (g_inet_socket_address_get_address
+          (udpsrc->addr)) == G_SOCKET_FAMILY_IPV4)
+    res = FALSE;
+#endif
+#ifdef SO_TIMESTAMPNS
+  if (udpsrc->socket_timestamp_mode == GST_SOCKET_TIMESTAMP_MODE_REALTIME)
+    res = TRUE;
+#endif
+
+  return res;
+}
+
+/* Checks the control messages received together with a packet, applies
+ * socket timestamps to @outbuf and returns the GRO segment size in
+ * @gso_size if there is one. Takes ownership of @msgs.
+ *
+ * Returns TRUE if the packet was for a different multicast address and
+ * needs to be dropped */
+static gboolean
+gst_udpsrc_handle_control_messages (GstUDPSrc * udpsrc, GstBuffer * outbuf,
+    GSocketControlMessage ** msgs, gint n_msgs, guint * gso_size)
+{
+  GInetAddress *iaddr = g_inet_socket_address_get_address (udpsrc->addr);
+  gboolean skip_packet = FALSE;
+  gsize iaddr_size = g_inet_address_get_native_size (iaddr);
+  const guint8 *iaddr_bytes = g_inet_address_to_bytes (iaddr);
+  gint i;
+
+  if (gso_size)
+    *gso_size = 0;
+
+  for (i = 0; i < n_msgs && !skip_packet; i++) {
+#ifdef IP_PKTINFO
+    if (GST_IS_IP_PKTINFO_MESSAGE (msgs[i])) {
+      GstIPPktinfoMessage *msg = GST_IP_PKTINFO_MESSAGE (msgs[i]);
+
+      if (sizeof (msg->addr) == iaddr_size
+          && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
+        skip_packet = TRUE;
+    }
+#endif
+#ifdef IPV6_PKTINFO
+    if (GST_IS_IPV6_PKTINFO_MESSAGE (msgs[i])) {
+      GstIPV6PktinfoMessage *msg = GST_IPV6_PKTINFO_MESSAGE (msgs[i]);
+
+      if (sizeof (msg->addr) == iaddr_size
+          && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
+        skip_packet = TRUE;
+    }
+#endif
+#ifdef IP_RECVDSTADDR
+    if (GST_IS_IP_RECVDSTADDR_MESSAGE (msgs[i])) {
+      GstIPRecvdstaddrMessage *msg = GST_IP_RECVDSTADDR_MESSAGE (msgs[i]);
+
+      if (sizeof (msg->addr) == iaddr_size
+          && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
+        skip_packet = TRUE;
+    }
+#endif
+#ifdef SO_TIMESTAMPNS
+    if (GST_IS_SOCKET_TIMESTAMP_MESSAGE (msgs[i])) {
+      GstSocketTimestampMessage *msg = GST_SOCKET_TIMESTAMP_MESSAGE (msgs[i]);
+      GstClock *clock;
+      GstClockTime socket_ts;
+
+      socket_ts = GST_TIMESPEC_TO_TIME (msg->socket_ts);
+      GST_TRACE_OBJECT (udpsrc,
+          "Got SCM_TIMESTAMPNS %" GST_TIME_FORMAT " in msg",
+          GST_TIME_ARGS (socket_ts));
+
+      clock = gst_element_get_clock (GST_ELEMENT_CAST (udpsrc));
+      if (clock != NULL) {
+        gint64 adjust_dts, cur_sys_time, delta;
+        GstClockTime base_time, cur_gst_clk_time, running_time;
+
+        /*
+         * We use g_get_real_time as the time reference for SCM timestamps
+         * is always CLOCK_REALTIME.
+         */
+        cur_sys_time = g_get_real_time () * GST_USECOND;
+        cur_gst_clk_time = gst_clock_get_time (clock);
+
+        delta = (gint64) cur_sys_time - (gint64) socket_ts;
+        if (delta < 0) {
+          /*
+           * The current system time will always be greater than the SCM
+           * timestamp as the packet would have been timestamped at least
+           * some clock cycles before. If it is not, then the system time
+           * was adjusted. Since we cannot rely on the delta calculation in
+           * such a case, set the DTS to current pipeline clock when this
+           * happens.
+           */
+          GST_LOG_OBJECT (udpsrc,
+              "Current system time is behind SCM timestamp, setting DTS to pipeline clock");
+          GST_BUFFER_DTS (outbuf) = cur_gst_clk_time;
+        } else {
+          base_time = gst_element_get_base_time (GST_ELEMENT_CAST (udpsrc));
+          running_time = cur_gst_clk_time - base_time;
+          adjust_dts = (gint64) running_time - delta;
+          /*
+           * If the system time was adjusted much further ahead, we might
+           * end up with delta > cur_gst_clk_time. Set the DTS to current
+           * pipeline clock for this scenario as well.
+           */
+          if (adjust_dts < 0) {
+            GST_LOG_OBJECT (udpsrc,
+                "Current system time much ahead in time, setting DTS to pipeline clock");
+            GST_BUFFER_DTS (outbuf) = cur_gst_clk_time;
+          } else {
+            GST_BUFFER_DTS (outbuf) = adjust_dts;
+            GST_LOG_OBJECT (udpsrc, "Setting DTS to %" GST_TIME_FORMAT,
+                GST_TIME_ARGS (GST_BUFFER_DTS (outbuf)));
+          }
+        }
+        g_object_unref (clock);
+      } else {
+        GST_ERROR_OBJECT (udpsrc,
+            "Failed to get element clock, not setting DTS");
+      }
+    }
+#endif
+#ifdef UDP_GRO
+    if (GST_IS_UDP_GRO_MESSAGE (msgs[i])) {
+      GstUDPGroMessage *msg = GST_UDP_GRO_MESSAGE (msgs[i]);
+
+      if (gso_size)
+        *gso_size = msg->gso_size;
+    }
+#endif
+  }
+
+  for (i = 0; i < n_msgs; i++) {
+    g_object_unref (msgs[i]);
+  }
+  g_free (msgs);
+
+  return skip_packet;
+}
+
+/* Waits until data can be read from the socket, posting a timeout message
+ * every time the timeout property expires without data. Returns FALSE with
+ * @err set if the wait was cancelled or failed */
+static gboolean
+gst_udpsrc_wait_readable (GstUDPSrc * udpsrc, GError ** err)
+{
+  gint64 timeout;
+
+  if (udpsrc->timeout)
+    timeout = udpsrc->timeout / 1000;
+  else
+    timeout = -1;
+
+  while (TRUE) {
+    GST_LOG_OBJECT (udpsrc, "doing select, timeout %" G_GINT64_FORMAT, timeout);
+
+    if (g_socket_condition_timed_wait (udpsrc->used_socket, G_IO_IN | G_IO_PRI,
+            timeout, udpsrc->cancellable, err))
+      return TRUE;
+
+    if (!g_error_matches (*err, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+      return FALSE;
+
+    g_clear_error (err);
+    /* timeout, post element message */
+    gst_element_post_message (GST_ELEMENT_CAST (udpsrc),
+        gst_message_new_element (GST_OBJECT_CAST (udpsrc),
+            gst_structure_new ("GstUDPSrcTimeout",
+                "timeout", G_TYPE_UINT64, udpsrc->timeout, NULL)));
+  }
+}
+
 static GstFlowReturn
 gst_udpsrc_fill (GstPushSrc * psrc, GstBuffer * outbuf)
 {
@@ -943,33 +1288,19 @@ gst_udpsrc_fill (GstPushSrc * psrc, GstBuffer * outbuf)
   GSocketAddress *saddr = NULL;
   GSocketAddress **p_saddr;
   gint flags = G_SOCKET_MSG_NONE;
-  gboolean try_again;
   GError *err = NULL;
   gssize res;
   gsize offset;
   GSocketControlMessage **msgs = NULL;
   GSocketControlMessage ***p_msgs;
-  gint n_msgs = 0, i;
+  gint n_msgs = 0;
   GstMapInfo info;
   GstMapInfo extra_info;
   GInputVector ivec[2];
 
   udpsrc = GST_UDPSRC_CAST (psrc);
 
-  /* optimization: use messages only in multicast mode and
-   * if we can't let the kernel do the filtering for us */
-  p_msgs =
-      (g_inet_address_get_is_multicast (g_inet_socket_address_get_address
-          (udpsrc->addr))) ? &msgs : NULL;
-#ifdef IP_MULTICAST_ALL
-  if (g_inet_address_get_family (g_inet_socket_address_get_address
-          (udpsrc->addr)) == G_SOCKET_FAMILY_IPV4)
-    p_msgs = NULL;
-#endif
-#ifdef SO_TIMESTAMPNS
-  if (udpsrc->socket_timestamp_mode == GST_SOCKET_TIMESTAMP_MODE_REALTIME)
-    p_msgs = &msgs;
-#endif
+  p_msgs = gst_udpsrc_needs_control_messages (udpsrc) ? &msgs : NULL;
 
   /* Retrieve sender address unless we've been configured not to do so */
   p_saddr = (udpsrc->retrieve_sender_address) ? &saddr : NULL;
@@ -1012,37 +1343,12 @@ retry:
     saddr = NULL;
   }
 
-  do {
-    gint64 timeout;
-
-    try_again = FALSE;
-
-    if (udpsrc->timeout)
-      timeout = udpsrc->timeout / 1000;
-    else
-      timeout = -1;
-
-    GST_LOG_OBJECT (udpsrc, "doing select, timeout %" G_GINT64_FORMAT, timeout);
-
-    if (!g_socket_condition_timed_wait (udpsrc->used_socket, G_IO_IN | G_IO_PRI,
-            timeout, udpsrc->cancellable, &err)) {
-      if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_BUSY)
-          || g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-        goto stopped;
-      } else if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_TIMED_OUT)) {
-        g_clear_error (&err);
-        /* timeout, post element message */
-        gst_element_post_message (GST_ELEMENT_CAST (udpsrc),
-            gst_message_new_element (GST_OBJECT_CAST (udpsrc),
-                gst_structure_new ("GstUDPSrcTimeout",
-                    "timeout", G_TYPE_UINT64, udpsrc->timeout, NULL)));
-      } else {
-        goto select_error;
-      }
-
-      try_again = TRUE;
-    }
-  } while (G_UNLIKELY (try_again));
+  if (!gst_udpsrc_wait_readable (udpsrc, &err)) {
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_BUSY)
+        || g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      goto stopped;
+    goto select_error;
+  }
 
   res =
       g_socket_receive_message (udpsrc->used_socket, p_saddr, ivec, 2,
@@ -1064,107 +1370,12 @@ retry:
   /* Retry if multicast and the destination address is not ours. We don't want
    * to receive arbitrary packets */
   if (p_msgs) {
-    GInetAddress *iaddr = g_inet_socket_address_get_address (udpsrc->addr);
-    gboolean skip_packet = FALSE;
-    gsize iaddr_size = g_inet_address_get_native_size (iaddr);
-    const guint8 *iaddr_bytes = g_inet_address_to_bytes (iaddr);
-
-    for (i = 0; i < n_msgs && !skip_packet; i++) {
-#ifdef IP_PKTINFO
-      if (GST_IS_IP_PKTINFO_MESSAGE (msgs[i])) {
-        GstIPPktinfoMessage *msg = GST_IP_PKTINFO_MESSAGE (msgs[i]);
-
-        if (sizeof (msg->addr) == iaddr_size
-            && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
-          skip_packet = TRUE;
-      }
-#endif
-#ifdef IPV6_PKTINFO
-      if (GST_IS_IPV6_PKTINFO_MESSAGE (msgs[i])) {
-        GstIPV6PktinfoMessage *msg = GST_IPV6_PKTINFO_MESSAGE (msgs[i]);
-
-        if (sizeof (msg->addr) == iaddr_size
-            && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
-          skip_packet = TRUE;
-      }
-#endif
-#ifdef IP_RECVDSTADDR
-      if (GST_IS_IP_RECVDSTADDR_MESSAGE (msgs[i])) {
-        GstIPRecvdstaddrMessage *msg = GST_IP_RECVDSTADDR_MESSAGE (msgs[i]);
+    gboolean skip_packet;
 
-        if (sizeof (msg->addr) == iaddr_size
-            && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
-          skip_packet = TRUE;
-      }
-#endif
-#ifdef SO_TIMESTAMPNS
-      if (GST_IS_SOCKET_TIMESTAMP_MESSAGE (msgs[i])) {
-        GstSocketTimestampMessage *msg = GST_SOCKET_TIMESTAMP_MESSAGE (msgs[i]);
-        GstClock *clock;
-        GstClockTime socket_ts;
-
-        socket_ts = GST_TIMESPEC_TO_TIME (msg->socket_ts);
-        GST_TRACE_OBJECT (udpsrc,
-            "Got SCM_TIMESTAMPNS %" GST_TIME_FORMAT " in msg",
-            GST_TIME_ARGS (socket_ts));
-
-        clock = gst_element_get_clock (GST_ELEMENT_CAST (udpsrc));
-        if (clock != NULL) {
-          gint64 adjust_dts, cur_sys_time, delta;
-          GstClockTime base_time, cur_gst_clk_time, running_time;
-
-          /*
-           * We use g_get_real_time as the time reference for SCM timestamps
-           * is always CLOCK_REALTIME.
-           */
-          cur_sys_time = g_get_real_time () * GST_USECOND;
-          cur_gst_clk_time = gst_clock_get_time (clock);
-
-          delta = (gint64) cur_sys_time - (gint64) socket_ts;
-          if (delta < 0) {
-            /*
-             * The current system time will always be greater than the SCM
-             * timestamp as the packet would have been timestamped at least
-             * some clock cycles before. If it is not, then the system time
-             * was adjusted. Since we cannot rely on the delta calculation in
-             * such a case, set the DTS to current pipeline clock when this
-             * happens.
-             */
-            GST_LOG_OBJECT (udpsrc,
-                "Current system time is behind SCM timestamp, setting DTS to pipeline clock");
-            GST_BUFFER_DTS (outbuf) = cur_gst_clk_time;
-          } else {
-            base_time = gst_element_get_base_time (GST_ELEMENT_CAST (udpsrc));
-            running_time = cur_gst_clk_time - base_time;
-            adjust_dts = (gint64) running_time - delta;
-            /*
-             * If the system time was adjusted much further ahead, we might
-             * end up with delta > cur_gst_clk_time. Set the DTS to current
-             * pipeline clock for this scenario as well.
-             */
-            if (adjust_dts < 0) {
-              GST_LOG_OBJECT (udpsrc,
-                  "Current system time much ahead in time, setting DTS to pipeline clock");
-              GST_BUFFER_DTS (outbuf) = cur_gst_clk_time;
-            } else {
-              GST_BUFFER_DTS (outbuf) = adjust_dts;
-              GST_LOG_OBJECT (udpsrc, "Setting DTS to %" GST_TIME_FORMAT,
-                  GST_TIME_ARGS (GST_BUFFER_DTS (outbuf)));
-            }
-          }
-          g_object_unref (clock);
-        } else {
-          GST_ERROR_OBJECT (udpsrc,
-              "Failed to get element clock, not setting DTS");
-        }
-      }
-#endif
-    }
-
-    for (i = 0; i < n_msgs; i++) {
-      g_object_unref (msgs[i]);
-    }
-    g_free (msgs);
+    skip_packet = gst_udpsrc_handle_control_messages (udpsrc, outbuf, msgs,
+        n_msgs, NULL);
+    msgs = NULL;
+    n_msgs = 0;
 
     if (skip_packet) {
       GST_DEBUG_OBJECT (udpsrc,
@@ -1258,6 +1469,331 @@ skip_error:
   }
 }
 
+static void
+gst_udpsrc_batch_slot_clear_received (GstUDPSrcBatchSlot * slot)
+{
+  guint i;
+
+  for (i = 0; i < slot->n_msgs; i++)
+    g_object_unref (slot->msgs[i]);
+  g_clear_pointer (&slot->msgs, g_free);
+  slot->n_msgs = 0;
+  g_clear_object (&slot->saddr);
+}
+
+static void
+gst_udpsrc_clear_batch (GstUDPSrc * udpsrc)
+{
+  guint i;
+
+  for (i = 0; i < udpsrc->n_batch_slots; i++) {
+    GstUDPSrcBatchSlot *slot = &udpsrc->batch_slots[i];
+
+    gst_udpsrc_batch_slot_clear_received (slot);
+    gst_clear_buffer (&slot->buffer);
+  }
+}
+
+static GstClockTime
+gst_udpsrc_get_running_time (GstUDPSrc * udpsrc)
+{
+  GstClock *clock;
+  GstClockTime now, base_time;
+
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (udpsrc));
+  if (clock == NULL)
+    return GST_CLOCK_TIME_NONE;
+
+  now = gst_clock_get_time (clock);
+  base_time = gst_element_get_base_time (GST_ELEMENT_CAST (udpsrc));
+  gst_object_unref (clock);
+
+  return now - base_time;
+}
+
+/* Maps one pool buffer per slot and reads as many packets as are available,
+ * up to @n_slots, with a single system call */
+static GstFlowReturn
+gst_udpsrc_receive_batch (GstUDPSrc * udpsrc, GstBufferPool * pool,
+    guint n_slots, gboolean need_msgs, guint * n_received)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GError *err = NULL;
+  gint flags = G_SOCKET_MSG_NONE;
+  guint i, n_mapped;
+  gint res;
+
+  *n_received = 0;
+
+  for (n_mapped = 0; n_mapped < n_slots; n_mapped++) {
+    GstUDPSrcBatchSlot *slot = &udpsrc->batch_slots[n_mapped];
+    GInputMessage *msg = &udpsrc->batch_msgs[n_mapped];
+
+    if (slot->buffer == NULL) {
+      ret = gst_buffer_pool_acquire_buffer (pool, &slot->buffer, NULL);
+      if (ret != GST_FLOW_OK)
+        goto out;
+    }
+
+    if (!gst_buffer_map (slot->buffer, &slot->map, GST_MAP_WRITE)) {
+      GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+          ("Failed to map memory"));
+      ret = GST_FLOW_ERROR;
+      goto out;
+    }
+
+    slot->vec.buffer = slot->map.data;
+    slot->vec.size = slot->map.size;
+
+    msg->address = udpsrc->retrieve_sender_address ? &slot->saddr : NULL;
+    msg->vectors = &slot->vec;
+    msg->num_vectors = 1;
+    msg->bytes_received = 0;
+    msg->flags = 0;
+    msg->control_messages = need_msgs ? &slot->msgs : NULL;
+    msg->num_control_messages = need_msgs ? &slot->n_msgs : NULL;
+  }
+
+#ifdef MSG_DONTWAIT
+  /* we wait for the first packet ourselves below and then only want to
+   * take what is already queued instead of waiting for a full batch */
+  flags |= MSG_DONTWAIT;
+#endif
+
+  while (TRUE) {
+    if (!gst_udpsrc_wait_readable (udpsrc, &err)) {
+      res = -1;
+      break;
+    }
+
+    res =
+        g_socket_receive_messages (udpsrc->used_socket, udpsrc->batch_msgs,
+        n_slots, flags, udpsrc->cancellable, &err);
+    if (res >= 0)
+      break;
+
+    /* Ignore ICMP port unreachable errors, see gst_udpsrc_fill() */
+    if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_HOST_UNREACHABLE) &&
+        !g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CONNECTION_CLOSED) &&
+        !g_error_matches (err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+      break;
+
+    g_clear_error (&err);
+  }
+
+  if (G_UNLIKELY (res < 0)) {
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_BUSY) ||
+        g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      GST_DEBUG_OBJECT (udpsrc, "stop called");
+      ret = GST_FLOW_FLUSHING;
+    } else {
+      GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+          ("receive error: %s", err->message));
+      ret = GST_FLOW_ERROR;
+    }
+    g_clear_error (&err);
+    goto out;
+  }
+
+  GST_LOG_OBJECT (udpsrc, "received %d of at most %u packets", res, n_slots);
+  *n_received = res;
+
+out:
+  for (i = 0; i < n_mapped; i++) {
+    GstUDPSrcBatchSlot *slot = &udpsrc->batch_slots[i];
+
+    gst_buffer_unmap (slot->buffer, &slot->map);
+  }
+
+  return ret;
+}
+
+/* Receives up to batch-size packets at once and pushes them downstream as a
+ * buffer list, splitting packets coalesced by GRO into separate buffers */
+static GstFlowReturn
+gst_udpsrc_create_list (GstUDPSrc * udpsrc, GstBuffer ** buf)
+{
+  GstBaseSrc *bsrc = GST_BASE_SRC_CAST (udpsrc);
+  GstBufferPool *pool;
+  GstBufferList *list;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gboolean need_msgs;
+  guint n_slots, n_received, i;
+  gsize offset;
+
+  n_slots = udpsrc->batch_size;
+  if (n_slots > udpsrc->n_batch_slots) {
+    udpsrc->batch_slots =
+        g_renew (GstUDPSrcBatchSlot, udpsrc->batch_slots, n_slots);
+    memset (&udpsrc->batch_slots[udpsrc->n_batch_slots], 0,
+        (n_slots - udpsrc->n_batch_slots) * sizeof (GstUDPSrcBatchSlot));
+    udpsrc->batch_msgs = g_renew (GInputMessage, udpsrc->batch_msgs, n_slots);
+    udpsrc->n_batch_slots = n_slots;
+  }
+
+  need_msgs = udpsrc->gro_enabled || gst_udpsrc_needs_control_messages (udpsrc);
+
+  pool = gst_base_src_get_buffer_pool (bsrc);
+  if (G_UNLIKELY (pool == NULL))
+    goto no_pool;
+
+  offset = udpsrc->skip_first_bytes;
+  list = gst_buffer_list_new_sized (n_slots);
+
+  while (ret == GST_FLOW_OK && gst_buffer_list_length (list) == 0) {
+    GstClockTime running_time = GST_CLOCK_TIME_NONE;
+
+    ret = gst_udpsrc_receive_batch (udpsrc, pool, n_slots, need_msgs,
+        &n_received);
+    if (ret != GST_FLOW_OK)
+      break;
+
+    if (gst_base_src_get_do_timestamp (bsrc))
+      running_time = gst_udpsrc_get_running_time (udpsrc);
+
+    for (i = 0; i < n_received; i++) {
+      GstUDPSrcBatchSlot *slot = &udpsrc->batch_slots[i];
+      GInputMessage *msg = &udpsrc->batch_msgs[i];
+      GstBuffer *outbuf = slot->buffer;
+      gsize size = msg->bytes_received;
+      gboolean skip_packet = FALSE;
+      guint gso_size = 0;
+
+      if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+        gst_udpsrc_batch_slot_clear_received (slot);
+        continue;
+      }
+
+      if (need_msgs) {
+        skip_packet = gst_udpsrc_handle_control_messages (udpsrc, outbuf,
+            slot->msgs, slot->n_msgs, &gso_size);
+        slot->msgs = NULL;
+        slot->n_msgs = 0;
+      }
+#ifdef MSG_TRUNC
+      if (msg->flags & MSG_TRUNC) {
+        GST_WARNING_OBJECT (udpsrc, "Dropping packet bigger than %"
+            G_GSIZE_FORMAT " bytes, increase the mtu", slot->vec.size);
+        skip_packet = TRUE;
+      }
+#endif
+
+      if (skip_packet) {
+        GST_DEBUG_OBJECT (udpsrc, "Dropping packet");
+        /* keep the buffer around for the next receive */
+        GST_BUFFER_DTS (outbuf) = GST_CLOCK_TIME_NONE;
+        gst_udpsrc_batch_slot_clear_received (slot);
+        continue;
+      }
+
+      slot->buffer = NULL;
+
+      if (!GST_CLOCK_TIME_IS_VALID (GST_BUFFER_DTS (outbuf)))
+        GST_BUFFER_DTS (outbuf) = running_time;
+      GST_BUFFER_PTS (outbuf) = GST_BUFFER_DTS (outbuf);
+
+      /* use buffer metadata so receivers can also track the address */
+      if (slot->saddr) {
+        gst_buffer_add_net_address_meta (outbuf, slot->saddr);
+        g_clear_object (&slot->saddr);
+      }
+
+      GST_LOG_OBJECT (udpsrc, "read packet of %" G_GSIZE_FORMAT " bytes, "
+          "segment size %u", size, gso_size);
+
+      if (gso_size == 0 || gso_size >= size) {
+        if (G_UNLIKELY (size < offset)) {
+          gst_buffer_unref (outbuf);
+          ret = GST_FLOW_ERROR;
+          continue;
+        }
+
+        gst_buffer_resize (outbuf, offset, size - offset);
+        gst_buffer_list_add (list, outbuf);
+      } else {
+        gsize pos;
+
+        /* the memory is shared between the segments, no copy involved */
+        for (pos = 0; pos < size && ret == GST_FLOW_OK; pos += gso_size) {
+          gsize len = MIN (gso_size, size - pos);
+
+          if (G_UNLIKELY (len < offset)) {
+            ret = GST_FLOW_ERROR;
+            break;
+          }
+
+          gst_buffer_list_add (list, gst_buffer_copy_region (outbuf,
+                  GST_BUFFER_COPY_ALL, pos + offset, len - offset));
+        }
+        gst_buffer_unref (outbuf);
+      }
+    }
+
+    if (ret == GST_FLOW_ERROR)
+      GST_ELEMENT_ERROR (udpsrc, STREAM, DECODE, (NULL),
+          ("UDP buffer to small to skip header"));
+  }
+
+  gst_object_unref (pool);
+
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_list_unref (list);
+    return ret;
+  }
+
+  if (gst_buffer_list_length (list) == 1) {
+    *buf = gst_buffer_ref (gst_buffer_list_get (list, 0));
+    gst_buffer_list_unref (list);
+  } else {
+    GST_LOG_OBJECT (udpsrc, "pushing list of %u buffers",
+        gst_buffer_list_length (list));
+    gst_base_src_submit_buffer_list (bsrc, list);
+    *buf = NULL;
+  }
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+no_pool:
+  {
+    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL), ("No buffer pool"));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_udpsrc_create (GstPushSrc * psrc, GstBuffer ** buf)
+{
+  GstUDPSrc *udpsrc = GST_UDPSRC_CAST (psrc);
+  GstBaseSrc *bsrc = GST_BASE_SRC_CAST (psrc);
+  GstBuffer *outbuf;
+  GstFlowReturn ret;
+
+  if (udpsrc->batch_size > 1 || udpsrc->gro_enabled)
+    return gst_udpsrc_create_list (udpsrc, buf);
+
+  /* same as the GstBaseSrc default create: allocate from our pool unless
+   * a buffer was passed in and fill it with a single packet */
+  outbuf = *buf;
+  if (outbuf == NULL) {
+    ret = GST_BASE_SRC_GET_CLASS (bsrc)->alloc (bsrc, -1, udpsrc->mtu,
+        &outbuf);
+    if (G_UNLIKELY (ret != GST_FLOW_OK))
+      return ret;
+  }
+
+  ret = gst_udpsrc_fill (psrc, outbuf);
+  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+    if (outbuf != *buf)
+      gst_buffer_unref (outbuf);
+    return ret;
+  }
+
+  *buf = outbuf;
+
+  return GST_FLOW_OK;
+}
+
 static gboolean
 gst_udpsrc_set_uri (GstUDPSrc * src, const gchar * uri, GError ** error)
 {
@@ -1430,6 +1966,12 @@ gst_udpsrc_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_SOCKET_TIMESTAMP:
       udpsrc->socket_timestamp_mode = g_value_get_enum (value);
       break;
+    case PROP_BATCH_SIZE:
+      udpsrc->batch_size = g_value_get_uint (value);
+      break;
+    case PROP_GRO:
+      udpsrc->gro = g_value_get_boolean (value);
+      break;
     case PROP_MULTICAST_SOURCE:
       GST_OBJECT_LOCK (udpsrc);
       g_free (udpsrc->multicast_source);
@@ -1512,6 +2054,12 @@ gst_udpsrc_get_property (GObject * object, guint prop_id, GValue * value,
       g_value_set_string (value, udpsrc->multicast_source);
       GST_OBJECT_UNLOCK (udpsrc);
       break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, udpsrc->batch_size);
+      break;
+    case PROP_GRO:
+      g_value_set_boolean (value, udpsrc->gro);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1873,6 +2421,21 @@ gst_udpsrc_open (GstUDPSrc * src)
   }
 #endif
 
+  src->gro_enabled = FALSE;
+  if (src->gro) {
+#ifdef UDP_GRO
+    if (!g_socket_set_option (src->used_socket, SOL_UDP, UDP_GRO, TRUE, &err)) {
+      GST_WARNING_OBJECT (src, "Failed to enable UDP GRO: %s", err->message);
+      g_clear_error (&err);
+    } else {
+      GST_LOG_OBJECT (src, "UDP GRO enabled");
+      src->gro_enabled = TRUE;
+    }
+#else
+    GST_WARNING_OBJECT (src, "gro was requested but UDP_GRO is not defined");
+#endif
+  }
+
   /* NOTE: sockaddr_in.sin_port works for ipv4 and ipv6 because sin_port
    * follows ss_family on both */
   {
@@ -2057,6 +2620,9 @@ gst_udpsrc_close (GstUDPSrc * src)
     src->addr = NULL;
   }
 
+  gst_udpsrc_clear_batch (src);
+  src->gro_enabled = FALSE;
+
   gst_udpsrc_free_cancellable (src);
 
   return TRUE;
@@ -43,6 +43,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstUDPSrc GstUDPSrc;
 typedef struct _GstUDPSrcClass GstUDPSrcClass;
+typedef struct _GstUDPSrcBatchSlot GstUDPSrcBatchSlot;
 
 
 /**
@@ -85,6 +86,8 @@ struct _GstUDPSrc {
   gboolean   loop;
   GstSocketTimestampMode socket_timestamp_mode;
   gchar     *multicast_source;
+  guint      batch_size;
+  gboolean   gro;
 
   /* stats */
   guint      max_size;
@@ -98,6 +101,13 @@ struct _GstUDPSrc {
   /* Extra memory for buffers with a size superior to max_packet_size */
   GstMemory *extra_mem;
 
+  /* batched receive state, only touched from the streaming thread */
+  GstUDPSrcBatchSlot *batch_slots;
+  GInputMessage *batch_msgs;
+  guint      n_batch_slots;
+  /* TRUE if UDP_GRO could be enabled on the socket */
+  gboolean   gro_enabled;
+
   gchar     *uri;
   GPtrArray *source_list;
 };
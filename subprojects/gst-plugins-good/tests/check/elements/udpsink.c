@@ -244,6 +244,78 @@ GST_START_TEST (test_udpsink_dscp)
 
 GST_END_TEST;
 
+GST_START_TEST (test_udpsink_gso)
+{
+  static const gsize sizes[] = { 1000, 1000, 1000, 400, 1200, 1200, 10 };
+  GInetAddress *inet_addr;
+  GSocketAddress *addr;
+  GSocket *socket;
+  GstElement *udpsink;
+  GstBufferList *list;
+  GstPad *srcpad;
+  GstSegment segment;
+  gchar data[2048];
+  guint i;
+  gint port;
+
+  /* bind a socket to receive the packets on */
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (socket != NULL);
+  inet_addr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (inet_addr, 0);
+  fail_unless (g_socket_bind (socket, addr, FALSE, NULL));
+  g_object_unref (addr);
+  g_object_unref (inet_addr);
+
+  addr = g_socket_get_local_address (socket, NULL);
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr));
+  g_object_unref (addr);
+
+  udpsink = gst_check_setup_element ("udpsink");
+  g_object_set (udpsink, "host", "127.0.0.1", "port", port, "gso", TRUE,
+      "sync", FALSE, NULL);
+
+  srcpad = gst_check_setup_src_pad_by_name (udpsink, &srctemplate, "sink");
+
+  gst_element_set_state (udpsink, GST_STATE_PLAYING);
+  gst_pad_set_active (srcpad, TRUE);
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("hey there!"));
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  /* runs of equally sized packets, each one terminated by a smaller one.
+   * With or without segmentation offload these have to arrive as separate
+   * datagrams */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, sizes[i], NULL);
+
+    gst_buffer_memset (buf, 0, i, sizes[i]);
+    gst_buffer_list_add (list, buf);
+  }
+
+  fail_unless_equals_int (gst_pad_push_list (srcpad, list), GST_FLOW_OK);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    gssize ret;
+
+    ret = g_socket_receive (socket, data, sizeof (data), NULL, NULL);
+    fail_unless_equals_int (ret, sizes[i]);
+    fail_unless_equals_int (data[0], i);
+    fail_unless_equals_int (data[ret - 1], i);
+  }
+
+  gst_check_teardown_pad_by_name (udpsink, "sink");
+  gst_check_teardown_element (udpsink);
+
+  g_object_unref (socket);
+}
+
+GST_END_TEST;
+
 static Suite *
 udpsink_suite (void)
 {
@@ -256,6 +328,7 @@ udpsink_suite (void)
   tcase_add_test (tc_chain, test_udpsink_bufferlist);
   tcase_add_test (tc_chain, test_udpsink_client_add_remove);
   tcase_add_test (tc_chain, test_udpsink_dscp);
+  tcase_add_test (tc_chain, test_udpsink_gso);
 
   return s;
 }
@@ -17,6 +17,7 @@
  * Boston, MA 02110-1301, USA.
  */
 #include <gst/check/gstcheck.h>
+#include <gst/net/gstnetaddressmeta.h>
 #include <gio/gio.h>
 #include <stdlib.h>
 
@@ -26,8 +27,8 @@ static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_STATIC_CAPS_ANY);
 
 static gboolean
-udpsrc_setup (GstElement ** udpsrc, GSocket ** socket,
-    GstPad ** sinkpad, GSocketAddress ** sa)
+udpsrc_setup_full (GstElement ** udpsrc, GSocket ** socket,
+    GstPad ** sinkpad, GSocketAddress ** sa, guint batch_size)
 {
   GInetAddress *ia;
   int port = 0;
@@ -35,7 +36,7 @@ udpsrc_setup (GstElement ** udpsrc, GSocket ** socket,
 
   *udpsrc = gst_check_setup_element ("udpsrc");
   fail_unless (*udpsrc != NULL);
-  g_object_set (*udpsrc, "port", 0, NULL);
+  g_object_set (*udpsrc, "port", 0, "batch-size", batch_size, NULL);
 
   *sinkpad = gst_check_setup_sink_pad_by_name (*udpsrc, &sinktemplate, "src");
   fail_unless (*sinkpad != NULL);
@@ -63,6 +64,13 @@ udpsrc_setup (GstElement ** udpsrc, GSocket ** socket,
   return TRUE;
 }
 
+static gboolean
+udpsrc_setup (GstElement ** udpsrc, GSocket ** socket,
+    GstPad ** sinkpad, GSocketAddress ** sa)
+{
+  return udpsrc_setup_full (udpsrc, socket, sinkpad, sa, 1);
+}
+
 GST_START_TEST (test_udpsrc_empty_packet)
 {
   GSocketAddress *sa = NULL;
@@ -247,6 +255,71 @@ send_failure:
 
 GST_END_TEST;
 
+GST_START_TEST (test_udpsrc_batch)
+{
+  GSocketAddress *sa = NULL;
+  GstElement *udpsrc = NULL;
+  GSocket *socket = NULL;
+  GstPad *sinkpad = NULL;
+  gchar data[1000];
+  gssize sent;
+  GError *err = NULL;
+  GList *l;
+  int i, len = 0;
+
+  for (i = 0; i < G_N_ELEMENTS (data); ++i)
+    data[i] = i & 0xff;
+
+  if (!udpsrc_setup_full (&udpsrc, &socket, &sinkpad, &sa, 4))
+    goto no_socket;
+
+  /* more packets than the batch size, so we get at least two lists */
+  for (i = 0; i < 10; i++) {
+    if ((sent = g_socket_send_to (socket, sa, data, 100 + i, NULL, &err)) == -1)
+      goto send_failure;
+    fail_unless_equals_int (sent, 100 + i);
+  }
+
+  GST_INFO ("sent some packets");
+
+  g_mutex_lock (&check_mutex);
+  len = g_list_length (buffers);
+  while (len < 10) {
+    g_cond_wait (&check_cond, &check_mutex);
+    len = g_list_length (buffers);
+    GST_INFO ("%u buffers", len);
+  }
+
+  /* every packet ends up in its own buffer, in order */
+  for (l = buffers, i = 0; l != NULL; l = l->next, i++) {
+    GstBuffer *buf = GST_BUFFER (l->data);
+
+    fail_unless_equals_int (gst_buffer_get_size (buf), 100 + i);
+    fail_unless (gst_buffer_memcmp (buf, 0, data, 100 + i) == 0);
+    fail_unless (gst_buffer_get_net_address_meta (buf) != NULL);
+  }
+
+  g_mutex_unlock (&check_mutex);
+
+no_socket:
+send_failure:
+  if (err) {
+    GST_WARNING ("Socket send error, skipping test: %s", err->message);
+    g_clear_error (&err);
+  }
+
+  gst_element_set_state (udpsrc, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_check_teardown_pad_by_name (udpsrc, "src");
+  gst_check_teardown_element (udpsrc);
+
+  g_object_unref (socket);
+  g_object_unref (sa);
+}
+
+GST_END_TEST;
+
 static void
 on_multicast_source_updated (GObject * src, GParamSpec * pspec, guint * count)
 {
@@ -305,6 +378,7 @@ udpsrc_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_udpsrc_empty_packet);
   tcase_add_test (tc_chain, test_udpsrc);
+  tcase_add_test (tc_chain, test_udpsrc_batch);
   tcase_add_test (tc_chain, test_udpsrc_multicast_source);
 
   return s;
@@ -662,6 +662,7 @@ init_post (GOptionContext * context, GOptionGroup * group, gpointer data,
   }
 
   _priv_gst_mini_object_initialize ();
+  _priv_gst_slab_initialize ();
   _priv_gst_quarks_initialize ();
   _priv_gst_allocator_initialize ();
   _priv_gst_memory_initialize ();
@@ -1121,6 +1122,7 @@ gst_deinit (void)
 
   _priv_gst_registry_cleanup ();
   _priv_gst_allocator_cleanup ();
+  _priv_gst_slab_cleanup ();
 
   /* We want to destroy tracers as late as possible for the leaks tracer
    * but still need to keep the caps system alive as it may have to use
@@ -136,9 +136,11 @@ G_GNUC_INTERNAL  void  _priv_gst_context_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_toc_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_date_time_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_plugin_feature_rank_initialize (void);
+G_GNUC_INTERNAL  void  _priv_gst_slab_initialize (void);
 
 /* cleanup functions called from gst_deinit(). */
 G_GNUC_INTERNAL  void  _priv_gst_allocator_cleanup (void);
+G_GNUC_INTERNAL  void  _priv_gst_slab_cleanup (void);
 G_GNUC_INTERNAL  void  _priv_gst_caps_features_cleanup (void);
 G_GNUC_INTERNAL  void  _priv_gst_caps_cleanup (void);
 G_GNUC_INTERNAL  void  _priv_gst_debug_cleanup (void);
@@ -147,6 +149,30 @@ G_GNUC_INTERNAL  void  _priv_gst_meta_cleanup (void);
 /* called from gst_task_cleanup_all(). */
 G_GNUC_INTERNAL  void  _priv_gst_element_cleanup (void);
 
+/* per-thread free lists for the structs of buffers, events and queries, see
+ * gstslab.c */
+typedef struct _GstSlabCache GstSlabCache;
+
+G_GNUC_INTERNAL
+GstSlabCache * _priv_gst_slab_cache_new (const gchar * name, gsize size);
+
+G_GNUC_INTERNAL  gpointer  _priv_gst_slab_alloc  (GstSlabCache * cache);
+
+G_GNUC_INTERNAL  gpointer  _priv_gst_slab_alloc0 (GstSlabCache * cache);
+
+G_GNUC_INTERNAL  void      _priv_gst_slab_free   (GstSlabCache * cache, gpointer mem);
+
+/* the #GstBufferPool that is allocating a buffer in the calling thread, see
+ * gstbufferpool.c */
+G_GNUC_INTERNAL  GstBufferPool * _priv_gst_buffer_pool_get_allocating (void);
+
+/* runs @func once on a worker of a #GstCooperativeTaskPool, see
+ * gsttaskpool.c */
+G_GNUC_INTERNAL
+void _priv_gst_cooperative_task_pool_schedule (GstTaskPool * pool,
+                                               GstTaskPoolFunction func,
+                                               gpointer user_data);
+
 /* Private registry functions */
 G_GNUC_INTERNAL
 gboolean _priv_gst_registry_remove_cache_plugins (GstRegistry *registry);
@@ -217,6 +243,9 @@ G_GNUC_INTERNAL
 void      __gst_element_factory_add_interface           (GstElementFactory    * elementfactory,
                                                          const gchar          * interfacename);
 
+G_GNUC_INTERNAL
+void      __gst_element_factory_ensure_details          (GstElementFactory    * elementfactory);
+
 /* used in gstvalue.c and gststructure.c */
 #define GST_ASCII_IS_STRING(c) (g_ascii_isalnum((c)) || ((c) == '_') || \
     ((c) == '-') || ((c) == '+') || ((c) == '/') || ((c) == ':') || \
@@ -466,6 +495,10 @@ struct _GstElementFactory {
 
   GList *               interfaces;             /* interface type names this element implements */
 
+  /* registry cache the metadata and pad templates are lazily read from */
+  GBytes *              cache;
+  const gchar *         cache_details;          /* NULL once materialized */
+
   /*< private >*/
   gpointer _gst_reserved[GST_PADDING];
 };
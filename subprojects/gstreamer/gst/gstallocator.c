@@ -336,6 +336,9 @@ gst_allocator_alloc (GstAllocator * allocator, gsize size,
   else
     mem = NULL;
 
+  if (mem)
+    GST_TRACER_MEMORY_ALLOC (allocator, mem);
+
   return mem;
 }
 
@@ -139,14 +139,21 @@
 
 GType _gst_buffer_type = 0;
 
+static GstSlabCache *buffer_cache = NULL;
+
 /* info->size will be sizeof(FooMeta) which contains a GstMeta at the beginning
  * too, and then there is again a GstMeta in GstMetaItem, so subtract one. */
 #define ITEM_SIZE(info) ((info)->size + sizeof (GstMetaItem) - sizeof (GstMeta))
 
-#define GST_BUFFER_MEM_MAX         16
+/* number of memory blocks stored in the buffer itself, more blocks are
+ * stored in an array that is allocated separately */
+#define GST_BUFFER_MEM_INLINE      16
+#define GST_BUFFER_MEM_MAX         1024
 
 #define GST_BUFFER_MEM_LEN(b)      (((GstBufferImpl *)(b))->len)
+#define GST_BUFFER_MEM_SIZE(b)     (((GstBufferImpl *)(b))->mem_size)
 #define GST_BUFFER_MEM_ARRAY(b)    (((GstBufferImpl *)(b))->mem)
+#define GST_BUFFER_MEM_INLINE_ARRAY(b) (((GstBufferImpl *)(b))->mem_inline)
 #define GST_BUFFER_MEM_PTR(b,i)    (((GstBufferImpl *)(b))->mem[i])
 #define GST_BUFFER_BUFMEM(b)       (((GstBufferImpl *)(b))->bufmem)
 #define GST_BUFFER_META(b)         (((GstBufferImpl *)(b))->item)
@@ -156,9 +163,12 @@ typedef struct
 {
   GstBuffer buffer;
 
-  /* the memory blocks */
+  /* the memory blocks, mem points to mem_inline until more than
+   * GST_BUFFER_MEM_INLINE blocks are added */
   guint len;
-  GstMemory *mem[GST_BUFFER_MEM_MAX];
+  guint mem_size;
+  GstMemory **mem;
+  GstMemory *mem_inline[GST_BUFFER_MEM_INLINE];
 
   /* memory of the buffer when allocated from 1 chunk */
   GstMemory *bufmem;
@@ -292,6 +302,8 @@ _actual_merged_memory (GstBuffer * buffer, guint idx, guint length)
       gst_memory_unmap (mem[i], &sinfo);
     }
     gst_memory_unmap (result, &dinfo);
+
+    GST_TRACER_MEMORY_MERGE (buffer, length, result);
   }
 
   return result;
@@ -452,6 +464,28 @@ _memory_get_exclusive_reference (GstMemory * mem)
   return ret;
 }
 
+/* make room for more memory blocks by moving the array out of the buffer or
+ * by doubling the size of the out-of-line array */
+static void
+_memory_grow (GstBuffer * buffer)
+{
+  guint len = GST_BUFFER_MEM_LEN (buffer);
+  guint size = MIN (GST_BUFFER_MEM_SIZE (buffer) * 2, GST_BUFFER_MEM_MAX);
+
+  GST_CAT_DEBUG (GST_CAT_PERFORMANCE, "growing memory array of buffer %p "
+      "to %u blocks", buffer, size);
+
+  if (GST_BUFFER_MEM_ARRAY (buffer) == GST_BUFFER_MEM_INLINE_ARRAY (buffer)) {
+    GST_BUFFER_MEM_ARRAY (buffer) = g_new (GstMemory *, size);
+    memcpy (GST_BUFFER_MEM_ARRAY (buffer), GST_BUFFER_MEM_INLINE_ARRAY (buffer),
+        len * sizeof (gpointer));
+  } else {
+    GST_BUFFER_MEM_ARRAY (buffer) =
+        g_renew (GstMemory *, GST_BUFFER_MEM_ARRAY (buffer), size);
+  }
+  GST_BUFFER_MEM_SIZE (buffer) = size;
+}
+
 static inline void
 _memory_add (GstBuffer * buffer, gint idx, GstMemory * mem)
 {
@@ -459,6 +493,10 @@ _memory_add (GstBuffer * buffer, gint idx, GstMemory * mem)
 
   GST_CAT_LOG (GST_CAT_BUFFER, "buffer %p, idx %d, mem %p", buffer, idx, mem);
 
+  if (G_UNLIKELY (len >= GST_BUFFER_MEM_SIZE (buffer)
+          && len < GST_BUFFER_MEM_MAX))
+    _memory_grow (buffer);
+
   if (G_UNLIKELY (len >= GST_BUFFER_MEM_MAX)) {
     /* too many buffer, span them. */
     /* FIXME, there is room for improvement here: We could only try to merge
@@ -494,6 +532,8 @@ _priv_gst_buffer_initialize (void)
 {
   _gst_buffer_type = gst_buffer_get_type ();
 
+  buffer_cache = _priv_gst_slab_cache_new ("buffer", sizeof (GstBufferImpl));
+
 #ifdef NO_64BIT_ATOMIC_INT_FOR_PLATFORM
   GST_CAT_WARNING (GST_CAT_PERFORMANCE,
       "No 64-bit atomic int defined for this platform/toolchain!");
@@ -509,6 +549,11 @@ _priv_gst_buffer_initialize (void)
  * When more memory blocks are added, existing memory blocks will be merged
  * together to make room for the new block.
  *
+ * Since 1.24 the first 16 memory blocks are stored in the buffer itself and
+ * more blocks are stored in a separately allocated array, so buffers can hold
+ * hundreds of memory blocks without copying. Code that sizes arrays with
+ * this value should be prepared for it to be larger than 16.
+ *
  * Returns: the maximum amount of memory blocks that a buffer can hold.
  *
  * Since: 1.2
@@ -809,6 +854,8 @@ _gst_buffer_free (GstBuffer * buffer)
             (buffer, i)), GST_MINI_OBJECT_CAST (buffer));
     gst_memory_unref (GST_BUFFER_MEM_PTR (buffer, i));
   }
+  if (GST_BUFFER_MEM_ARRAY (buffer) != GST_BUFFER_MEM_INLINE_ARRAY (buffer))
+    g_free (GST_BUFFER_MEM_ARRAY (buffer));
 
   /* free metadata */
   for (walk = GST_BUFFER_META (buffer); walk; walk = next) {
@@ -827,7 +874,7 @@ _gst_buffer_free (GstBuffer * buffer)
 #ifdef USE_POISONING
   memset (buffer, 0xff, sizeof (GstBufferImpl));
 #endif
-  g_free (buffer);
+  _priv_gst_slab_free (buffer_cache, buffer);
 }
 
 static void
@@ -846,6 +893,8 @@ gst_buffer_init (GstBufferImpl * buffer)
   GST_BUFFER_OFFSET_END (buffer) = GST_BUFFER_OFFSET_NONE;
 
   GST_BUFFER_MEM_LEN (buffer) = 0;
+  GST_BUFFER_MEM_SIZE (buffer) = GST_BUFFER_MEM_INLINE;
+  GST_BUFFER_MEM_ARRAY (buffer) = GST_BUFFER_MEM_INLINE_ARRAY (buffer);
   GST_BUFFER_META (buffer) = NULL;
 }
 
@@ -861,7 +910,7 @@ gst_buffer_new (void)
 {
   GstBufferImpl *newbuf;
 
-  newbuf = g_new (GstBufferImpl, 1);
+  newbuf = _priv_gst_slab_alloc (buffer_cache);
   GST_CAT_LOG (GST_CAT_BUFFER, "new %p", newbuf);
 
   gst_buffer_init (newbuf);
@@ -1134,7 +1183,8 @@ gst_buffer_append_memory (GstBuffer * buffer, GstMemory * mem)
  *
  * Only gst_buffer_get_max_memory() can be added to a buffer. If more memory is
  * added, existing memory blocks will automatically be merged to make room for
- * the new memory.
+ * the new memory. Below that limit no memory is merged or copied, the
+ * array of memory blocks grows as needed.
  */
 void
 gst_buffer_insert_memory (GstBuffer * buffer, gint idx, GstMemory * mem)
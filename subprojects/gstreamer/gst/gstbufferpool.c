@@ -59,41 +59,81 @@
  * The bufferpool can be deactivated again with gst_buffer_pool_set_active().
  * All further gst_buffer_pool_acquire_buffer() calls will return an error. When
  * all buffers are returned to the pool they will be freed.
+ *
+ * When #GST_BUFFER_POOL_OPTION_THREAD_CACHE is enabled in the configuration,
+ * the default acquire and release implementations keep free buffers in small
+ * per-thread magazines and only exchange complete magazines with the shared
+ * depot of the pool. Threads that acquire and release buffers in a loop then
+ * rarely touch state shared with other threads. Buffers released by another
+ * thread come back through the depot once that thread filled its magazines.
+ * Only when the pool is exhausted are free buffers taken from the magazines
+ * of other threads.
  */
 
 #include "gst_private.h"
 #include "glib-compat-private.h"
 
-#include <errno.h>
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
 #endif
 #include <sys/types.h>
 
 #include "gstatomicqueue.h"
-#include "gstpoll.h"
 #include "gstinfo.h"
 #include "gstquark.h"
 #include "gstvalue.h"
 
 #include "gstbufferpool.h"
 
-#ifdef G_OS_WIN32
-#  ifndef EWOULDBLOCK
-#  define EWOULDBLOCK EAGAIN    /* This is just to placate gcc */
-#  endif
-#endif /* G_OS_WIN32 */
-
 GST_DEBUG_CATEGORY_STATIC (gst_buffer_pool_debug);
 #define GST_CAT_DEFAULT gst_buffer_pool_debug
 
 #define GST_BUFFER_POOL_LOCK(pool)   (g_rec_mutex_lock(&pool->priv->rec_lock))
 #define GST_BUFFER_POOL_UNLOCK(pool) (g_rec_mutex_unlock(&pool->priv->rec_lock))
 
+/* number of buffers in one magazine of the thread cache */
+#define MAGAZINE_SIZE 16
+/* upper bound for the number of thread cache slots of a pool */
+#define MAX_CACHE_SLOTS 64
+
+typedef struct _GstBufferPoolMagazine GstBufferPoolMagazine;
+
+struct _GstBufferPoolMagazine
+{
+  GstBufferPoolMagazine *next;
+  guint n_buffers;
+  GstBuffer *buffers[MAGAZINE_SIZE];
+};
+
+/* a thread cache slot holds a loaded and a previous magazine, each of them is
+ * always either completely full or completely empty when it is not the loaded
+ * one. Threads are spread over the slots so that, with enough slots, every
+ * thread only ever takes the uncontended lock of its own slot. */
+typedef struct
+{
+  GMutex lock;
+  GstBufferPoolMagazine *loaded;
+  GstBufferPoolMagazine *previous;
+  /* keep slots used by different threads on different cache lines */
+  guint8 padding[64];
+} GstBufferPoolCacheSlot;
+
 struct _GstBufferPoolPrivate
 {
   GstAtomicQueue *queue;
-  GstPoll *poll;
+
+  /* waiting for buffers when the pool is exhausted */
+  GMutex wait_lock;
+  GCond wait_cond;
+  gint waiters;
+
+  /* thread cache, see GST_BUFFER_POOL_OPTION_THREAD_CACHE */
+  gboolean thread_cache;
+  GstBufferPoolCacheSlot *slots;
+  guint n_slots;
+  GMutex depot_lock;
+  GstBufferPoolMagazine *depot_full;
+  GstBufferPoolMagazine *depot_empty;
 
   GRecMutex rec_lock;
 
@@ -158,8 +198,10 @@ gst_buffer_pool_init (GstBufferPool * pool)
   priv = pool->priv = gst_buffer_pool_get_instance_private (pool);
 
   g_rec_mutex_init (&priv->rec_lock);
+  g_mutex_init (&priv->wait_lock);
+  g_cond_init (&priv->wait_cond);
+  g_mutex_init (&priv->depot_lock);
 
-  priv->poll = gst_poll_new_timer ();
   priv->queue = gst_atomic_queue_new (16);
   pool->flushing = 1;
   priv->active = FALSE;
@@ -171,14 +213,215 @@ gst_buffer_pool_init (GstBufferPool * pool)
   gst_allocation_params_init (&priv->params);
   gst_buffer_pool_config_set_allocator (priv->config, priv->allocator,
       &priv->params);
-  /* 1 control write for flushing - the flush token */
-  gst_poll_write_control (priv->poll);
-  /* 1 control write for marking that we are not waiting for poll - the wait token */
-  gst_poll_write_control (priv->poll);
 
   GST_DEBUG_OBJECT (pool, "created");
 }
 
+static void
+free_magazines (GstBufferPoolMagazine * mag)
+{
+  while (mag) {
+    GstBufferPoolMagazine *next = mag->next;
+
+    g_free (mag);
+    mag = next;
+  }
+}
+
+/* called when the pool is not active and all buffers were freed */
+static void
+free_thread_cache (GstBufferPool * pool)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  guint i;
+
+  if (priv->slots == NULL)
+    return;
+
+  for (i = 0; i < priv->n_slots; i++) {
+    GstBufferPoolCacheSlot *slot = &priv->slots[i];
+
+    free_magazines (slot->loaded);
+    free_magazines (slot->previous);
+    g_mutex_clear (&slot->lock);
+  }
+  g_free (priv->slots);
+  priv->slots = NULL;
+  priv->n_slots = 0;
+
+  free_magazines (priv->depot_full);
+  priv->depot_full = NULL;
+  free_magazines (priv->depot_empty);
+  priv->depot_empty = NULL;
+}
+
+static void
+alloc_thread_cache (GstBufferPool * pool)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  guint i;
+
+  if (priv->slots != NULL)
+    return;
+
+  priv->n_slots = CLAMP (g_get_num_processors () * 2, 1, MAX_CACHE_SLOTS);
+  priv->slots = g_new0 (GstBufferPoolCacheSlot, priv->n_slots);
+  for (i = 0; i < priv->n_slots; i++) {
+    GstBufferPoolCacheSlot *slot = &priv->slots[i];
+
+    g_mutex_init (&slot->lock);
+    slot->loaded = g_new0 (GstBufferPoolMagazine, 1);
+    slot->previous = g_new0 (GstBufferPoolMagazine, 1);
+  }
+  GST_DEBUG_OBJECT (pool, "allocated thread cache with %u slots",
+      priv->n_slots);
+}
+
+static GPrivate thread_cache_index = G_PRIVATE_INIT (NULL);
+static gint thread_cache_counter = 0;
+
+static GstBufferPoolCacheSlot *
+get_cache_slot (GstBufferPoolPrivate * priv)
+{
+  guint index;
+
+  /* every thread gets a process wide index once, that index selects the
+   * slot in all pools */
+  index = GPOINTER_TO_UINT (g_private_get (&thread_cache_index));
+  if (G_UNLIKELY (index == 0)) {
+    index = ((guint) g_atomic_int_add (&thread_cache_counter, 1)) + 1;
+    if (G_UNLIKELY (index == 0))
+      index = 1;
+    g_private_set (&thread_cache_index, GUINT_TO_POINTER (index));
+  }
+  return &priv->slots[(index - 1) % priv->n_slots];
+}
+
+/* must be called with the slot lock */
+static GstBuffer *
+cache_slot_pop (GstBufferPoolPrivate * priv, GstBufferPoolCacheSlot * slot)
+{
+  GstBufferPoolMagazine *mag;
+
+  if (slot->loaded->n_buffers == 0) {
+    if (slot->previous->n_buffers > 0) {
+      /* previous one is full, swap */
+      mag = slot->previous;
+      slot->previous = slot->loaded;
+      slot->loaded = mag;
+    } else {
+      /* both empty, exchange an empty magazine for a full one from the
+       * depot */
+      g_mutex_lock (&priv->depot_lock);
+      if ((mag = priv->depot_full)) {
+        priv->depot_full = mag->next;
+        slot->previous->next = priv->depot_empty;
+        priv->depot_empty = slot->previous;
+        slot->previous = slot->loaded;
+        slot->loaded = mag;
+      }
+      g_mutex_unlock (&priv->depot_lock);
+
+      if (mag == NULL)
+        return NULL;
+    }
+  }
+  return slot->loaded->buffers[--slot->loaded->n_buffers];
+}
+
+/* must be called with the slot lock */
+static void
+cache_slot_push (GstBufferPoolPrivate * priv, GstBufferPoolCacheSlot * slot,
+    GstBuffer * buffer)
+{
+  GstBufferPoolMagazine *mag;
+
+  if (slot->loaded->n_buffers == MAGAZINE_SIZE) {
+    if (slot->previous->n_buffers == 0) {
+      /* previous one is empty, swap */
+      mag = slot->previous;
+      slot->previous = slot->loaded;
+      slot->loaded = mag;
+    } else {
+      /* both full, hand a full magazine to the depot and continue with an
+       * empty one */
+      g_mutex_lock (&priv->depot_lock);
+      if ((mag = priv->depot_empty))
+        priv->depot_empty = mag->next;
+      else
+        mag = g_new0 (GstBufferPoolMagazine, 1);
+      slot->previous->next = priv->depot_full;
+      priv->depot_full = slot->previous;
+      slot->previous = slot->loaded;
+      slot->loaded = mag;
+      g_mutex_unlock (&priv->depot_lock);
+    }
+  }
+  slot->loaded->buffers[slot->loaded->n_buffers++] = buffer;
+}
+
+/* get a free buffer from the cache of the current thread or from the queue.
+ * With @steal, the cache slots of all other threads are tried as well. */
+static GstBuffer *
+pop_free_buffer (GstBufferPool * pool, gboolean steal)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  GstBufferPoolCacheSlot *slot;
+  GstBuffer *buffer;
+  guint i;
+
+  if (!priv->thread_cache)
+    return gst_atomic_queue_pop (priv->queue);
+
+  slot = get_cache_slot (priv);
+  g_mutex_lock (&slot->lock);
+  buffer = cache_slot_pop (priv, slot);
+  g_mutex_unlock (&slot->lock);
+
+  for (i = 0; buffer == NULL && steal && i < priv->n_slots; i++) {
+    GstBufferPoolCacheSlot *other = &priv->slots[i];
+
+    if (other == slot)
+      continue;
+
+    g_mutex_lock (&other->lock);
+    buffer = cache_slot_pop (priv, other);
+    g_mutex_unlock (&other->lock);
+  }
+  return buffer;
+}
+
+static void
+push_free_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  GstBufferPoolCacheSlot *slot;
+
+  if (!priv->thread_cache) {
+    gst_atomic_queue_push (priv->queue, buffer);
+    return;
+  }
+
+  slot = get_cache_slot (priv);
+  g_mutex_lock (&slot->lock);
+  cache_slot_push (priv, slot, buffer);
+  g_mutex_unlock (&slot->lock);
+}
+
+/* wake up a thread waiting for a free buffer, this is only a memory read when
+ * nobody is waiting */
+static inline void
+wake_waiter (GstBufferPool * pool)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+
+  if (G_UNLIKELY (g_atomic_int_get (&priv->waiters) > 0)) {
+    g_mutex_lock (&priv->wait_lock);
+    g_cond_signal (&priv->wait_cond);
+    g_mutex_unlock (&priv->wait_lock);
+  }
+}
+
 static void
 gst_buffer_pool_dispose (GObject * object)
 {
@@ -208,8 +451,11 @@ gst_buffer_pool_finalize (GObject * object)
   GST_DEBUG_OBJECT (pool, "%p finalize", pool);
 
   gst_atomic_queue_unref (priv->queue);
-  gst_poll_free (priv->poll);
+  free_thread_cache (pool);
   gst_structure_free (priv->config);
+  g_mutex_clear (&priv->depot_lock);
+  g_cond_clear (&priv->wait_cond);
+  g_mutex_clear (&priv->wait_lock);
   g_rec_mutex_clear (&priv->rec_lock);
 
   G_OBJECT_CLASS (gst_buffer_pool_parent_class)->finalize (object);
@@ -262,6 +508,16 @@ mark_meta_pooled (GstBuffer * buffer, GstMeta ** meta, gpointer user_data)
   return TRUE;
 }
 
+/* the pool that is allocating a buffer in this thread, for tracers that want
+ * to tell pooled memory allocations from others */
+static GPrivate allocating_pool = G_PRIVATE_INIT (NULL);
+
+GstBufferPool *
+_priv_gst_buffer_pool_get_allocating (void)
+{
+  return g_private_get (&allocating_pool);
+}
+
 static GstFlowReturn
 do_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
     GstBufferPoolAcquireParams * params)
@@ -283,7 +539,19 @@ do_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
   if (max_buffers && cur_buffers >= max_buffers)
     goto max_reached;
 
-  result = pclass->alloc_buffer (pool, buffer, params);
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+  /* only tracers look at the allocating pool */
+  if (G_UNLIKELY (GST_TRACER_IS_ENABLED)) {
+    GstBufferPool *prev_pool = g_private_get (&allocating_pool);
+
+    g_private_set (&allocating_pool, pool);
+    result = pclass->alloc_buffer (pool, buffer, params);
+    g_private_set (&allocating_pool, prev_pool);
+  } else
+#endif
+  {
+    result = pclass->alloc_buffer (pool, buffer, params);
+  }
   if (G_UNLIKELY (result != GST_FLOW_OK))
     goto alloc_failed;
 
@@ -407,20 +675,9 @@ default_stop (GstBufferPool * pool)
   GstBuffer *buffer;
 
   /* clear the pool */
-  while ((buffer = gst_atomic_queue_pop (priv->queue))) {
-    while (!gst_poll_read_control (priv->poll)) {
-      if (errno == EWOULDBLOCK) {
-        /* We put the buffer into the queue but did not finish writing control
-         * yet, let's wait a bit and retry */
-        g_thread_yield ();
-        continue;
-      } else {
-        /* Critical error but GstPoll already complained */
-        break;
-      }
-    }
+  while ((buffer = pop_free_buffer (pool, TRUE)))
     do_free_buffer (pool, buffer);
-  }
+
   return priv->cur_buffers == 0;
 }
 
@@ -459,8 +716,10 @@ do_set_flushing (GstBufferPool * pool, gboolean flushing)
 
   if (flushing) {
     g_atomic_int_set (&pool->flushing, 1);
-    /* Write the flush token to wake up any waiters */
-    gst_poll_write_control (priv->poll);
+    /* wake up all waiters, they check the flushing flag with the lock */
+    g_mutex_lock (&priv->wait_lock);
+    g_cond_broadcast (&priv->wait_cond);
+    g_mutex_unlock (&priv->wait_lock);
 
     if (pclass->flush_start)
       pclass->flush_start (pool);
@@ -468,19 +727,6 @@ do_set_flushing (GstBufferPool * pool, gboolean flushing)
     if (pclass->flush_stop)
       pclass->flush_stop (pool);
 
-    while (!gst_poll_read_control (priv->poll)) {
-      if (errno == EWOULDBLOCK) {
-        /* This should not really happen unless flushing and unflushing
-         * happens on different threads. Let's wait a bit to get back flush
-         * token from the thread that was setting it to flushing */
-        g_thread_yield ();
-        continue;
-      } else {
-        /* Critical error but GstPoll already complained */
-        break;
-      }
-    }
-
     g_atomic_int_set (&pool->flushing, 0);
   }
 }
@@ -626,6 +872,14 @@ default_set_config (GstBufferPool * pool, GstStructure * config)
   priv->max_buffers = max_buffers;
   priv->cur_buffers = 0;
 
+  /* the pool is stopped here so the cache holds no buffers */
+  priv->thread_cache = gst_buffer_pool_config_has_option (config,
+      GST_BUFFER_POOL_OPTION_THREAD_CACHE);
+  if (priv->thread_cache)
+    alloc_thread_cache (pool);
+  else
+    free_thread_cache (pool);
+
   if (priv->allocator)
     gst_object_unref (priv->allocator);
   if ((priv->allocator = allocator))
@@ -1116,20 +1370,10 @@ default_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
     if (G_UNLIKELY (GST_BUFFER_POOL_IS_FLUSHING (pool)))
       goto flushing;
 
-    /* try to get a buffer from the queue */
-    *buffer = gst_atomic_queue_pop (priv->queue);
+    /* try to get a buffer from the queue or the cache of this thread and
+     * the depot */
+    *buffer = pop_free_buffer (pool, FALSE);
     if (G_LIKELY (*buffer)) {
-      while (!gst_poll_read_control (priv->poll)) {
-        if (errno == EWOULDBLOCK) {
-          /* We put the buffer into the queue but did not finish writing control
-           * yet, let's wait a bit and retry */
-          g_thread_yield ();
-          continue;
-        } else {
-          /* Critical error but GstPoll already complained */
-          break;
-        }
-      }
       result = GST_FLOW_OK;
       GST_LOG_OBJECT (pool, "acquired buffer %p", *buffer);
       break;
@@ -1146,40 +1390,38 @@ default_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
       /* something went wrong, return error */
       break;
 
+    /* the pool is exhausted but other threads might still cache free
+     * buffers */
+    if (priv->thread_cache && (*buffer = pop_free_buffer (pool, TRUE))) {
+      result = GST_FLOW_OK;
+      GST_LOG_OBJECT (pool, "acquired buffer %p from another thread", *buffer);
+      break;
+    }
+
     /* check if we need to wait */
     if (params && (params->flags & GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT)) {
       GST_LOG_OBJECT (pool, "no more buffers");
       break;
     }
 
-    /* now we release the control socket, we wait for a buffer release or
-     * flushing */
-    if (!gst_poll_read_control (pool->priv->poll)) {
-      if (errno == EWOULDBLOCK) {
-        /* This means that we have two threads trying to allocate buffers
-         * already, and the other one already got the wait token. This
-         * means that we only have to wait for the poll now and not write the
-         * token afterwards: we will be woken up once the other thread is
-         * woken up and that one will write the wait token it removed */
-        GST_LOG_OBJECT (pool, "waiting for free buffers or flushing");
-        gst_poll_wait (priv->poll, GST_CLOCK_TIME_NONE);
-      } else {
-        /* This is a critical error, GstPoll already gave a warning */
-        result = GST_FLOW_ERROR;
-        break;
-      }
-    } else {
-      /* We're the first thread waiting, we got the wait token and have to
-       * write it again later
-       * OR
-       * We're a second thread and just consumed the flush token and block all
-       * other threads, in which case we must not wait and give it back
-       * immediately */
-      if (!GST_BUFFER_POOL_IS_FLUSHING (pool)) {
-        GST_LOG_OBJECT (pool, "waiting for free buffers or flushing");
-        gst_poll_wait (priv->poll, GST_CLOCK_TIME_NONE);
-      }
-      gst_poll_write_control (pool->priv->poll);
+    /* wait for a buffer release or flushing. Releasing threads only take
+     * the lock when they see a waiter, so announce ourselves first and then
+     * check everything again before going to sleep */
+    g_mutex_lock (&priv->wait_lock);
+    g_atomic_int_inc (&priv->waiters);
+    *buffer = pop_free_buffer (pool, TRUE);
+    if (*buffer == NULL && !GST_BUFFER_POOL_IS_FLUSHING (pool)
+        && (guint) g_atomic_int_get (&priv->cur_buffers) >= priv->max_buffers) {
+      GST_LOG_OBJECT (pool, "waiting for free buffers or flushing");
+      g_cond_wait (&priv->wait_cond, &priv->wait_lock);
+    }
+    g_atomic_int_add (&priv->waiters, -1);
+    g_mutex_unlock (&priv->wait_lock);
+
+    if (*buffer) {
+      result = GST_FLOW_OK;
+      GST_LOG_OBJECT (pool, "acquired buffer %p", *buffer);
+      break;
     }
   }
 
@@ -1325,8 +1567,8 @@ default_release_buffer (GstBufferPool * pool, GstBuffer * buffer)
     goto not_writable;
 
   /* keep it around in our queue */
-  gst_atomic_queue_push (pool->priv->queue, buffer);
-  gst_poll_write_control (pool->priv->poll);
+  push_free_buffer (pool, buffer);
+  wake_waiter (pool);
 
   return;
 
@@ -1352,7 +1594,7 @@ not_writable:
 discard:
   {
     do_free_buffer (pool, buffer);
-    gst_poll_write_control (pool->priv->poll);
+    wake_waiter (pool);
     return;
   }
 }
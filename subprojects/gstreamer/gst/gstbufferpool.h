@@ -61,6 +61,22 @@ typedef enum {
   GST_BUFFER_POOL_ACQUIRE_FLAG_LAST     = (1 << 16),
 } GstBufferPoolAcquireFlags;
 
+/**
+ * GST_BUFFER_POOL_OPTION_THREAD_CACHE:
+ *
+ * A bufferpool option to keep free buffers in per-thread caches. Threads that
+ * acquire and release buffers then mostly avoid synchronizing with other
+ * threads. Free buffers in the cache of one thread reach other threads in
+ * batches through a shared depot, and are only taken directly from its cache
+ * when the pool is exhausted.
+ *
+ * The option is handled by the default acquire_buffer and release_buffer
+ * implementations of #GstBufferPool.
+ *
+ * Since: 1.24
+ */
+#define GST_BUFFER_POOL_OPTION_THREAD_CACHE "GstBufferPoolOptionThreadCache"
+
 typedef struct _GstBufferPoolAcquireParams GstBufferPoolAcquireParams;
 
 /**
@@ -60,6 +60,14 @@
  * message on the bus. This should only be used if the application is able
  * to deal with messages from different threads.
  *
+ * Applications that receive many messages, for example level or QoS messages
+ * from a lot of elements, can let a bus watch handle several messages per
+ * main loop iteration with gst_bus_set_max_dispatch(). With
+ * gst_bus_set_coalesce_types() a newly posted message of one of the given
+ * types replaces a message of the same type and source that is still queued,
+ * so that only the latest one is delivered. gst_bus_get_stats() returns the
+ * number of posted, dropped and coalesced messages.
+ *
  * Every #GstPipeline has one bus.
  *
  * Note that a #GstPipeline will set its bus into flushing state when changing
@@ -97,6 +105,7 @@ enum
 };
 
 #define DEFAULT_ENABLE_ASYNC (TRUE)
+#define DEFAULT_MAX_DISPATCH 1
 
 enum
 {
@@ -117,6 +126,18 @@ typedef struct
   gint ref_count;
 } SyncHandler;
 
+/* a queued message of a coalesced type, @latest is delivered instead of
+ * @queued when it is set */
+typedef struct
+{
+  GstObject *src;
+  GstMessageType type;
+  GQuark name;
+
+  GstMessage *queued;
+  GstMessage *latest;
+} CoalesceEntry;
+
 static SyncHandler *
 sync_handler_ref (SyncHandler * handler)
 {
@@ -152,6 +173,21 @@ struct _GstBusPrivate
   gboolean enable_async;
   GstPoll *poll;
   GPollFD pollfd;
+
+  /* with the object lock */
+  guint max_dispatch;
+  GstMessageType coalesce_types;
+  guint64 n_posted;
+  guint64 n_dropped;
+  guint64 n_dispatches;
+  guint64 n_dispatched;
+
+  /* with the coalesce lock */
+  GMutex coalesce_lock;
+  GHashTable *coalesce;
+  guint64 n_coalesced;
+  /* atomic, number of entries in the coalesce table */
+  gint n_coalescing;
 };
 
 #define gst_bus_parent_class parent_class
@@ -250,7 +286,9 @@ gst_bus_init (GstBus * bus)
 {
   bus->priv = gst_bus_get_instance_private (bus);
   bus->priv->enable_async = DEFAULT_ENABLE_ASYNC;
+  bus->priv->max_dispatch = DEFAULT_MAX_DISPATCH;
   g_mutex_init (&bus->priv->queue_lock);
+  g_mutex_init (&bus->priv->coalesce_lock);
   bus->priv->queue = gst_atomic_queue_new (32);
 
   GST_DEBUG_OBJECT (bus, "created");
@@ -275,6 +313,20 @@ gst_bus_dispose (GObject * object)
     g_mutex_unlock (&bus->priv->queue_lock);
     g_mutex_clear (&bus->priv->queue_lock);
 
+    /* the queued messages are gone, only the replacements are left */
+    if (bus->priv->coalesce) {
+      GHashTableIter iter;
+      CoalesceEntry *entry;
+
+      g_hash_table_iter_init (&iter, bus->priv->coalesce);
+      while (g_hash_table_iter_next (&iter, (gpointer *) & entry, NULL)) {
+        if (entry->latest)
+          gst_message_unref (entry->latest);
+      }
+      g_hash_table_unref (bus->priv->coalesce);
+      bus->priv->coalesce = NULL;
+    }
+
     if (bus->priv->poll)
       gst_poll_free (bus->priv->poll);
     bus->priv->poll = NULL;
@@ -291,6 +343,8 @@ gst_bus_finalize (GObject * object)
   if (bus->priv->sync_handler)
     sync_handler_unref (g_steal_pointer (&bus->priv->sync_handler));
 
+  g_mutex_clear (&bus->priv->coalesce_lock);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -315,6 +369,114 @@ gst_bus_new (void)
   return result;
 }
 
+static void
+coalesce_entry_init (CoalesceEntry * entry, GstMessage * message)
+{
+  const GstStructure *s = gst_message_get_structure (message);
+
+  entry->src = GST_MESSAGE_SRC (message);
+  entry->type = GST_MESSAGE_TYPE (message);
+  entry->name = s ? gst_structure_get_name_id (s) : 0;
+  entry->queued = message;
+  entry->latest = NULL;
+}
+
+static guint
+coalesce_entry_hash (gconstpointer key)
+{
+  const CoalesceEntry *entry = key;
+
+  return g_direct_hash (entry->src) ^ (guint) entry->type ^ entry->name;
+}
+
+static gboolean
+coalesce_entry_equal (gconstpointer a, gconstpointer b)
+{
+  const CoalesceEntry *ea = a, *eb = b;
+
+  return ea->src == eb->src && ea->type == eb->type && ea->name == eb->name;
+}
+
+/* Remembers @message as the queued message for its type and source, or makes
+ * it replace the already queued one. Returns %FALSE when @message replaced a
+ * queued message and must not be pushed on the queue. */
+static gboolean
+gst_bus_coalesce_message (GstBus * bus, GstMessage * message)
+{
+  CoalesceEntry key, *entry;
+  GstMessage *old = NULL;
+  gboolean push;
+
+  coalesce_entry_init (&key, message);
+
+  g_mutex_lock (&bus->priv->coalesce_lock);
+  if (G_UNLIKELY (bus->priv->coalesce == NULL))
+    bus->priv->coalesce = g_hash_table_new_full (coalesce_entry_hash,
+        coalesce_entry_equal, g_free, NULL);
+
+  entry = g_hash_table_lookup (bus->priv->coalesce, &key);
+  if (entry) {
+    old = entry->latest;
+    entry->latest = message;
+    bus->priv->n_coalesced++;
+    push = FALSE;
+  } else {
+    g_hash_table_add (bus->priv->coalesce, g_memdup2 (&key, sizeof (key)));
+    g_atomic_int_inc (&bus->priv->n_coalescing);
+    push = TRUE;
+  }
+  g_mutex_unlock (&bus->priv->coalesce_lock);
+
+  if (old) {
+    GST_DEBUG_OBJECT (bus, "[msg %p] replaced by %p", old, message);
+    gst_message_unref (old);
+  }
+
+  return push;
+}
+
+/* called after @message was taken from the queue, returns the message that
+ * should be delivered in its place */
+static GstMessage *
+gst_bus_take_latest_message (GstBus * bus, GstMessage * message)
+{
+  CoalesceEntry key, *entry;
+  GstMessage *latest = NULL;
+
+  coalesce_entry_init (&key, message);
+
+  g_mutex_lock (&bus->priv->coalesce_lock);
+  entry = bus->priv->coalesce ?
+      g_hash_table_lookup (bus->priv->coalesce, &key) : NULL;
+  if (entry && entry->queued == message) {
+    latest = entry->latest;
+    g_hash_table_remove (bus->priv->coalesce, entry);
+    g_atomic_int_add (&bus->priv->n_coalescing, -1);
+  }
+  g_mutex_unlock (&bus->priv->coalesce_lock);
+
+  if (latest) {
+    GST_DEBUG_OBJECT (bus, "[msg %p] delivering latest message %p", message,
+        latest);
+    gst_message_unref (message);
+    message = latest;
+  }
+
+  return message;
+}
+
+static inline gboolean
+message_type_matches (GstMessage * message, GstMessageType types)
+{
+  if ((GST_MESSAGE_TYPE (message) & types) == 0)
+    return FALSE;
+
+  /* Extra check to ensure extended types don't get matched unless
+   * asked for */
+  return !GST_MESSAGE_TYPE_IS_EXTENDED (message)
+      || (types & GST_MESSAGE_EXTENDED);
+}
+
 /**
  * gst_bus_post:
  * @bus: a #GstBus to post on
@@ -330,6 +492,7 @@ gst_bus_post (GstBus * bus, GstMessage * message)
 {
   GstBusSyncReply reply = GST_BUS_PASS;
   gboolean emit_sync_message;
+  GstMessageType coalesce_types;
   SyncHandler *sync_handler = NULL;
 
   g_return_val_if_fail (GST_IS_BUS (bus), FALSE);
@@ -350,6 +513,8 @@ gst_bus_post (GstBus * bus, GstMessage * message)
   if (bus->priv->sync_handler)
     sync_handler = sync_handler_ref (bus->priv->sync_handler);
   emit_sync_message = bus->priv->num_sync_message_emitters > 0;
+  coalesce_types = bus->priv->coalesce_types;
+  bus->priv->n_posted++;
   GST_OBJECT_UNLOCK (bus);
 
   /* first call the sync handler if it is installed */
@@ -369,6 +534,11 @@ gst_bus_post (GstBus * bus, GstMessage * message)
    * always drop the message */
   if (!bus->priv->poll)
     reply = GST_BUS_DROP;
+  else if (reply == GST_BUS_DROP) {
+    GST_OBJECT_LOCK (bus);
+    bus->priv->n_dropped++;
+    GST_OBJECT_UNLOCK (bus);
+  }
 
   /* now see what we should do with the message */
   switch (reply) {
@@ -377,6 +547,14 @@ gst_bus_post (GstBus * bus, GstMessage * message)
       GST_DEBUG_OBJECT (bus, "[msg %p] dropped", message);
       break;
     case GST_BUS_PASS:
+      if (G_UNLIKELY (coalesce_types != 0)
+          && message_type_matches (message, coalesce_types)
+          && !gst_bus_coalesce_message (bus, message)) {
+        /* replaced a queued message, which already woke up the reader */
+        GST_DEBUG_OBJECT (bus, "[msg %p] coalesced", message);
+        break;
+      }
+
       /* pass the message to the async queue, refcount passed in the queue */
       GST_DEBUG_OBJECT (bus, "[msg %p] pushing on async queue", message);
       gst_atomic_queue_push (bus->priv->queue, message);
@@ -432,6 +610,7 @@ gst_bus_post (GstBus * bus, GstMessage * message)
 is_flushing:
   {
     GST_DEBUG_OBJECT (bus, "bus is flushing");
+    bus->priv->n_dropped++;
     GST_OBJECT_UNLOCK (bus);
     gst_message_unref (message);
 
@@ -498,6 +677,162 @@ gst_bus_set_flushing (GstBus * bus, gboolean flushing)
   g_list_free_full (message_list, (GDestroyNotify) gst_message_unref);
 }
 
+/**
+ * gst_bus_set_max_dispatch:
+ * @bus: a #GstBus
+ * @max_messages: the maximum number of messages to handle per dispatch, or 0
+ *
+ * Sets the maximum number of messages the bus watch passes to its callback
+ * each time it is dispatched by the main loop. With the default of 1, every
+ * message costs one main loop iteration. Handling several messages per
+ * dispatch makes the application thread a lot cheaper when many messages are
+ * posted, at the expense of the latency of the other sources of the main
+ * context.
+ *
+ * If @max_messages is 0, all messages that are on the bus when the watch is
+ * dispatched are handled.
+ *
+ * The watch stops handling messages early when its callback returns %FALSE
+ * or removes the watch.
+ *
+ * Since: 1.24
+ */
+void
+gst_bus_set_max_dispatch (GstBus * bus, guint max_messages)
+{
+  g_return_if_fail (GST_IS_BUS (bus));
+
+  GST_OBJECT_LOCK (bus);
+  bus->priv->max_dispatch = max_messages;
+  GST_OBJECT_UNLOCK (bus);
+}
+
+/**
+ * gst_bus_get_max_dispatch:
+ * @bus: a #GstBus
+ *
+ * Gets the maximum number of messages handled per dispatch of the bus watch,
+ * see gst_bus_set_max_dispatch().
+ *
+ * Returns: the maximum number of messages per dispatch, 0 for all pending
+ * messages.
+ *
+ * Since: 1.24
+ */
+guint
+gst_bus_get_max_dispatch (GstBus * bus)
+{
+  guint result;
+
+  g_return_val_if_fail (GST_IS_BUS (bus), 0);
+
+  GST_OBJECT_LOCK (bus);
+  result = bus->priv->max_dispatch;
+  GST_OBJECT_UNLOCK (bus);
+
+  return result;
+}
+
+/**
+ * gst_bus_set_coalesce_types:
+ * @bus: a #GstBus
+ * @types: message types to coalesce, 0 to disable coalescing
+ *
+ * Makes the bus keep only the latest message of the given @types for every
+ * message source. When a message of one of the @types is posted while a
+ * message of the same type from the same source is still queued on the bus,
+ * the new message takes the place of the queued one in the queue and the
+ * queued message is dropped. For messages with a structure, such as element
+ * or application messages, the structure names have to match as well.
+ *
+ * This is useful for periodic messages like the ones from the level or
+ * spectrum elements or QoS messages, of which the application is usually
+ * only interested in the current value. Messages that were handled
+ * synchronously with %GST_BUS_ASYNC are never coalesced.
+ *
+ * Messages that are already queued when coalescing is enabled are not
+ * replaced.
+ *
+ * Since: 1.24
+ */
+void
+gst_bus_set_coalesce_types (GstBus * bus, GstMessageType types)
+{
+  g_return_if_fail (GST_IS_BUS (bus));
+
+  GST_OBJECT_LOCK (bus);
+  bus->priv->coalesce_types = types;
+  GST_OBJECT_UNLOCK (bus);
+}
+
+/**
+ * gst_bus_get_coalesce_types:
+ * @bus: a #GstBus
+ *
+ * Gets the message types that are coalesced on @bus, see
+ * gst_bus_set_coalesce_types().
+ *
+ * Returns: the coalesced message types.
+ *
+ * Since: 1.24
+ */
+GstMessageType
+gst_bus_get_coalesce_types (GstBus * bus)
+{
+  GstMessageType result;
+
+  g_return_val_if_fail (GST_IS_BUS (bus), 0);
+
+  GST_OBJECT_LOCK (bus);
+  result = bus->priv->coalesce_types;
+  GST_OBJECT_UNLOCK (bus);
+
+  return result;
+}
+
+/**
+ * gst_bus_get_stats:
+ * @bus: a #GstBus
+ *
+ * Gets the message counters of @bus in a #GstStructure named
+ * "application/x-gst-bus-stats" with the following #G_TYPE_UINT64 fields:
+ *
+ * - "posted": the number of messages posted on the bus
+ * - "dropped": the number of messages dropped by the sync handler or because
+ *   the bus was flushing
+ * - "coalesced": the number of queued messages that were replaced by a newer
+ *   message, see gst_bus_set_coalesce_types()
+ * - "dispatches": the number of times the bus watch was dispatched
+ * - "dispatched": the number of messages handled by the bus watch
+ *
+ * Returns: (transfer full): a new #GstStructure with the counters.
+ *
+ * Since: 1.24
+ */
+GstStructure *
+gst_bus_get_stats (GstBus * bus)
+{
+  GstStructure *s;
+  guint64 coalesced;
+
+  g_return_val_if_fail (GST_IS_BUS (bus), NULL);
+
+  g_mutex_lock (&bus->priv->coalesce_lock);
+  coalesced = bus->priv->n_coalesced;
+  g_mutex_unlock (&bus->priv->coalesce_lock);
+
+  GST_OBJECT_LOCK (bus);
+  s = gst_structure_new ("application/x-gst-bus-stats",
+      "posted", G_TYPE_UINT64, bus->priv->n_posted,
+      "dropped", G_TYPE_UINT64, bus->priv->n_dropped,
+      "coalesced", G_TYPE_UINT64, coalesced,
+      "dispatches", G_TYPE_UINT64, bus->priv->n_dispatches,
+      "dispatched", G_TYPE_UINT64, bus->priv->n_dispatched, NULL);
+  GST_OBJECT_UNLOCK (bus);
+
+  return s;
+}
+
 /**
  * gst_bus_timed_pop_filtered:
  * @bus: a #GstBus to pop from
@@ -557,17 +892,15 @@ gst_bus_timed_pop_filtered (GstBus * bus, GstClockTime timeout,
         }
       }
 
+      if (G_UNLIKELY (g_atomic_int_get (&bus->priv->n_coalescing) > 0))
+        message = gst_bus_take_latest_message (bus, message);
+
       GST_DEBUG_OBJECT (bus, "got message %p, %s from %s, type mask is %u",
           message, GST_MESSAGE_TYPE_NAME (message),
           GST_MESSAGE_SRC_NAME (message), (guint) types);
-      if ((GST_MESSAGE_TYPE (message) & types) != 0) {
-        /* Extra check to ensure extended types don't get matched unless
-         * asked for */
-        if ((!GST_MESSAGE_TYPE_IS_EXTENDED (message))
-            || (types & GST_MESSAGE_EXTENDED)) {
-          /* exit the loop, we have a message */
-          goto beach;
-        }
+      if (message_type_matches (message, types)) {
+        /* exit the loop, we have a message */
+        goto beach;
       }
 
       GST_DEBUG_OBJECT (bus, "discarding message, does not match mask");
@@ -796,7 +1129,8 @@ gst_bus_source_dispatch (GSource * source, GSourceFunc callback,
   GstBusFunc handler = (GstBusFunc) callback;
   GstBusSource *bsource = (GstBusSource *) source;
   GstMessage *message;
-  gboolean keep;
+  gboolean keep = TRUE;
+  guint max_dispatch, n_dispatched = 0;
   GstBus *bus;
 
   g_return_val_if_fail (bsource != NULL, FALSE);
@@ -805,23 +1139,44 @@ gst_bus_source_dispatch (GSource * source, GSourceFunc callback,
 
   g_return_val_if_fail (GST_IS_BUS (bus), FALSE);
 
-  message = gst_bus_pop (bus);
+  GST_OBJECT_LOCK (bus);
+  max_dispatch = bus->priv->max_dispatch;
+  GST_OBJECT_UNLOCK (bus);
+
+  /* don't keep on dispatching messages that are posted while we are busy,
+   * other sources of the main context need to run too */
+  if (max_dispatch == 0)
+    max_dispatch = MAX (gst_atomic_queue_length (bus->priv->queue), 1);
 
-  /* The message queue might be empty if some other thread or callback set
-   * the bus to flushing between check/prepare and dispatch */
-  if (G_UNLIKELY (message == NULL))
-    return TRUE;
+  while (keep && n_dispatched < max_dispatch) {
+    message = gst_bus_pop (bus);
 
-  if (!handler)
-    goto no_handler;
+    /* The message queue might be empty if some other thread or callback set
+     * the bus to flushing between check/prepare and dispatch */
+    if (G_UNLIKELY (message == NULL))
+      break;
+
+    if (!handler)
+      goto no_handler;
 
-  GST_DEBUG_OBJECT (bus, "source %p calling dispatch with %" GST_PTR_FORMAT,
-      source, message);
+    GST_DEBUG_OBJECT (bus, "source %p calling dispatch with %" GST_PTR_FORMAT,
+        source, message);
 
-  keep = handler (bus, message, user_data);
-  gst_message_unref (message);
+    keep = handler (bus, message, user_data);
+    gst_message_unref (message);
+    n_dispatched++;
 
-  GST_DEBUG_OBJECT (bus, "source %p handler returns %d", source, keep);
+    GST_DEBUG_OBJECT (bus, "source %p handler returns %d", source, keep);
+
+    /* the handler removed the watch */
+    if (g_source_is_destroyed (source))
+      break;
+  }
+
+  GST_OBJECT_LOCK (bus);
+  bus->priv->n_dispatches++;
+  bus->priv->n_dispatched += n_dispatched;
+  GST_OBJECT_UNLOCK (bus);
 
   return keep;
 
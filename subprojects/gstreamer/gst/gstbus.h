@@ -185,6 +185,21 @@ GstMessage *            gst_bus_timed_pop_filtered      (GstBus * bus, GstClockT
 GST_API
 void                    gst_bus_set_flushing            (GstBus * bus, gboolean flushing);
 
+GST_API
+void                    gst_bus_set_max_dispatch        (GstBus * bus, guint max_messages);
+
+GST_API
+guint                   gst_bus_get_max_dispatch        (GstBus * bus);
+
+GST_API
+void                    gst_bus_set_coalesce_types      (GstBus * bus, GstMessageType types);
+
+GST_API
+GstMessageType          gst_bus_get_coalesce_types      (GstBus * bus);
+
+GST_API
+GstStructure *          gst_bus_get_stats               (GstBus * bus);
+
 /* synchronous dispatching */
 
 GST_API
@@ -129,6 +129,9 @@ static void gst_caps_transform_to_string (const GValue * src_value,
     GValue * dest_value);
 static gboolean gst_caps_from_string_inplace (GstCaps * caps,
     const gchar * string);
+static GstCaps *_gst_caps_copy (const GstCaps * caps);
+static gboolean gst_caps_can_intersect_zig_zag (const GstCaps * caps1,
+    const GstCaps * caps2);
 
 GType _gst_caps_type = 0;
 GstCaps *_gst_caps_any;
@@ -136,6 +139,277 @@ GstCaps *_gst_caps_none;
 
 GST_DEFINE_MINI_OBJECT_TYPE (GstCaps, gst_caps);
 
+/* Cache for the results of intersections and subset checks.
+ *
+ * Autoplugging and renegotiation keep comparing the same template caps with
+ * the same stream caps. Results are only cached when at least one side is a
+ * long-lived caps, such as static caps and pad template caps that are flagged
+ * as MAY_BE_LEAKED and shared. Those are keyed by pointer and referenced by
+ * the cache, which keeps them immutable. The other side is keyed by its
+ * contents and stored as a copy, so that the refcount and writability of caps
+ * owned by the caller never change.
+ */
+typedef enum
+{
+  CAPS_CACHE_INTERSECT_ZIG_ZAG,
+  CAPS_CACHE_INTERSECT_FIRST,
+  CAPS_CACHE_CAN_INTERSECT,
+  CAPS_CACHE_IS_SUBSET,
+} GstCapsCacheOp;
+
+static const gchar *caps_cache_op_names[] = {
+  "intersect", "intersect-first", "can-intersect", "is-subset"
+};
+
+#define CAPS_CACHE_N_SETS 64
+#define CAPS_CACHE_N_WAYS 4
+/* minimum number of structure pairs to compare, below that the lookup costs
+ * about as much as the operation itself */
+#define CAPS_CACHE_MIN_PAIRS 4
+
+#define CAPS_IS_LONG_LIVED(caps) \
+  (GST_MINI_OBJECT_FLAG_IS_SET (caps, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED) && \
+   !IS_WRITABLE (caps))
+
+typedef struct
+{
+  GstCapsCacheOp op;
+  const GstCaps *caps1;
+  const GstCaps *caps2;
+  gboolean long_lived1;
+  gboolean long_lived2;
+  guint hash;
+} GstCapsCacheKey;
+
+typedef struct
+{
+  GstCapsCacheOp op;
+  guint hash;
+  /* NULL if the entry is unused */
+  GstCaps *caps1;
+  GstCaps *caps2;
+  /* whether caps1/caps2 are copies instead of the long-lived caps */
+  gboolean copy1;
+  gboolean copy2;
+
+  GstCaps *result;              /* intersections */
+  gboolean res;                 /* can_intersect and is_subset */
+} GstCapsCacheEntry;
+
+typedef struct
+{
+  GstCapsCacheEntry entries[CAPS_CACHE_N_WAYS];
+  guint next;                   /* entry to replace next */
+} GstCapsCacheSet;
+
+G_LOCK_DEFINE_STATIC (caps_cache_lock);
+static GstCapsCacheSet caps_cache[CAPS_CACHE_N_SETS];
+
+static gboolean
+caps_cache_hash_field (GQuark field_id, const GValue * value,
+    gpointer user_data)
+{
+  guint *hash = user_data;
+  GType type = G_VALUE_TYPE (value);
+
+  /* only cheap values, the rest is left to the equality check */
+  *hash = *hash * 31 + field_id;
+  if (type == G_TYPE_INT)
+    *hash = *hash * 31 + g_value_get_int (value);
+  else if (type == G_TYPE_STRING && g_value_get_string (value))
+    *hash = *hash * 31 + g_str_hash (g_value_get_string (value));
+
+  return TRUE;
+}
+
+static guint
+caps_cache_hash_caps (const GstCaps * caps, gboolean long_lived)
+{
+  GstCapsFeatures *features;
+  GstStructure *structure;
+  guint i, n, hash;
+
+  if (long_lived)
+    return g_direct_hash (caps);
+
+  n = GST_CAPS_LEN (caps);
+  hash = n;
+  for (i = 0; i < n; i++) {
+    structure = gst_caps_get_structure_unchecked (caps, i);
+    features = gst_caps_get_features_unchecked (caps, i);
+
+    hash = hash * 31 + gst_structure_get_name_id (structure);
+    if (features)
+      hash = hash * 31 + gst_caps_features_get_size (features);
+    gst_structure_foreach (structure, caps_cache_hash_field, &hash);
+  }
+
+  return hash;
+}
+
+/* Returns FALSE if the result for @caps1 and @caps2 is not cached */
+static gboolean
+caps_cache_key_init (GstCapsCacheKey * key, GstCapsCacheOp op,
+    const GstCaps * caps1, const GstCaps * caps2)
+{
+  if (GST_CAPS_LEN (caps1) * GST_CAPS_LEN (caps2) < CAPS_CACHE_MIN_PAIRS)
+    return FALSE;
+
+  key->long_lived1 = CAPS_IS_LONG_LIVED (caps1);
+  key->long_lived2 = CAPS_IS_LONG_LIVED (caps2);
+  if (!key->long_lived1 && !key->long_lived2)
+    return FALSE;
+
+  key->op = op;
+  key->caps1 = caps1;
+  key->caps2 = caps2;
+  key->hash = op;
+  key->hash = key->hash * 31 + caps_cache_hash_caps (caps1, key->long_lived1);
+  key->hash = key->hash * 31 + caps_cache_hash_caps (caps2, key->long_lived2);
+
+  return TRUE;
+}
+
+static inline gboolean
+caps_cache_caps_match (const GstCaps * stored, gboolean copy,
+    const GstCaps * caps, gboolean long_lived)
+{
+  if (long_lived)
+    return !copy && stored == caps;
+
+  return copy && gst_caps_is_strictly_equal (stored, caps);
+}
+
+static GstCapsCacheEntry *
+caps_cache_find_locked (const GstCapsCacheKey * key)
+{
+  GstCapsCacheSet *set = &caps_cache[key->hash % CAPS_CACHE_N_SETS];
+  guint i;
+
+  for (i = 0; i < CAPS_CACHE_N_WAYS; i++) {
+    GstCapsCacheEntry *entry = &set->entries[i];
+
+    if (entry->caps1 && entry->hash == key->hash && entry->op == key->op &&
+        caps_cache_caps_match (entry->caps1, entry->copy1, key->caps1,
+            key->long_lived1) &&
+        caps_cache_caps_match (entry->caps2, entry->copy2, key->caps2,
+            key->long_lived2))
+      return entry;
+  }
+
+  return NULL;
+}
+
+static GstCaps *
+caps_cache_copy (const GstCaps * caps)
+{
+  GstCaps *copy = _gst_caps_copy (caps);
+
+  GST_MINI_OBJECT_FLAG_UNSET (copy, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+
+  return copy;
+}
+
+/* Returns TRUE on a cache hit, with a new copy of the cached intersection in
+ * @result if not NULL */
+static gboolean
+caps_cache_lookup (const GstCapsCacheKey * key, GstCaps ** result,
+    gboolean * res)
+{
+  GstCapsCacheEntry *entry;
+  GstCaps *cached = NULL;
+  gboolean hit = FALSE;
+
+  G_LOCK (caps_cache_lock);
+  entry = caps_cache_find_locked (key);
+  if (entry) {
+    if (entry->result)
+      cached = gst_caps_ref (entry->result);
+    *res = entry->res;
+    hit = TRUE;
+  }
+  G_UNLOCK (caps_cache_lock);
+
+  GST_TRACER_CAPS_CACHE_LOOKUP (caps_cache_op_names[key->op], hit);
+
+  if (cached) {
+    /* callers own the result of an intersection and may modify it */
+    if (result)
+      *result = caps_cache_copy (cached);
+    gst_caps_unref (cached);
+  }
+
+  return hit;
+}
+
+static GstCaps *
+caps_cache_store_caps (const GstCaps * caps, gboolean long_lived)
+{
+  GstCaps *stored;
+
+  if (long_lived)
+    return gst_caps_ref ((GstCaps *) caps);
+
+  /* caps owned by the cache are freed in _priv_gst_caps_cleanup() */
+  stored = _gst_caps_copy (caps);
+  GST_MINI_OBJECT_FLAG_SET (stored, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+
+  return stored;
+}
+
+static void
+caps_cache_entry_clear (GstCapsCacheEntry * entry)
+{
+  gst_clear_caps (&entry->caps1);
+  gst_clear_caps (&entry->caps2);
+  gst_clear_caps (&entry->result);
+}
+
+static void
+caps_cache_store (const GstCapsCacheKey * key, const GstCaps * result,
+    gboolean res)
+{
+  GstCapsCacheEntry new_entry, old_entry = { 0, };
+  GstCapsCacheSet *set;
+
+  new_entry.op = key->op;
+  new_entry.hash = key->hash;
+  new_entry.caps1 = caps_cache_store_caps (key->caps1, key->long_lived1);
+  new_entry.caps2 = caps_cache_store_caps (key->caps2, key->long_lived2);
+  new_entry.copy1 = !key->long_lived1;
+  new_entry.copy2 = !key->long_lived2;
+  new_entry.result = result ? caps_cache_store_caps (result, FALSE) : NULL;
+  new_entry.res = res;
+
+  G_LOCK (caps_cache_lock);
+  /* another thread might have stored the same result in the meantime */
+  if (caps_cache_find_locked (key)) {
+    old_entry = new_entry;
+  } else {
+    set = &caps_cache[key->hash % CAPS_CACHE_N_SETS];
+    old_entry = set->entries[set->next];
+    set->entries[set->next] = new_entry;
+    set->next = (set->next + 1) % CAPS_CACHE_N_WAYS;
+  }
+  G_UNLOCK (caps_cache_lock);
+
+  caps_cache_entry_clear (&old_entry);
+}
+
+static void
+caps_cache_clear (void)
+{
+  guint i, j;
+
+  G_LOCK (caps_cache_lock);
+  for (i = 0; i < CAPS_CACHE_N_SETS; i++) {
+    for (j = 0; j < CAPS_CACHE_N_WAYS; j++)
+      caps_cache_entry_clear (&caps_cache[i].entries[j]);
+    caps_cache[i].next = 0;
+  }
+  G_UNLOCK (caps_cache_lock);
+}
+
 void
 _priv_gst_caps_initialize (void)
 {
@@ -151,6 +425,8 @@ _priv_gst_caps_initialize (void)
 void
 _priv_gst_caps_cleanup (void)
 {
+  caps_cache_clear ();
+
   gst_caps_unref (_gst_caps_any);
   _gst_caps_any = NULL;
   gst_caps_unref (_gst_caps_none);
@@ -1323,6 +1599,8 @@ gst_caps_is_subset (const GstCaps * subset, const GstCaps * superset)
 {
   GstStructure *s1, *s2;
   GstCapsFeatures *f1, *f2;
+  GstCapsCacheKey key;
+  gboolean use_cache;
   gboolean ret = TRUE;
   gint i, j;
 
@@ -1334,6 +1612,11 @@ gst_caps_is_subset (const GstCaps * subset, const GstCaps * superset)
   if (CAPS_IS_ANY (subset) || CAPS_IS_EMPTY (superset))
     return FALSE;
 
+  use_cache =
+      caps_cache_key_init (&key, CAPS_CACHE_IS_SUBSET, subset, superset);
+  if (use_cache && caps_cache_lookup (&key, NULL, &ret))
+    return ret;
+
   for (i = GST_CAPS_LEN (subset) - 1; i >= 0; i--) {
     s1 = gst_caps_get_structure_unchecked (subset, i);
     f1 = gst_caps_get_features_unchecked (subset, i);
@@ -1362,6 +1645,9 @@ gst_caps_is_subset (const GstCaps * subset, const GstCaps * superset)
     }
   }
 
+  if (use_cache)
+    caps_cache_store (&key, NULL, ret);
+
   return ret;
 }
 
@@ -1538,12 +1824,8 @@ gst_caps_is_strictly_equal (const GstCaps * caps1, const GstCaps * caps2)
 gboolean
 gst_caps_can_intersect (const GstCaps * caps1, const GstCaps * caps2)
 {
-  guint64 i;                    /* index can be up to 2 * G_MAX_UINT */
-  guint j, k, len1, len2;
-  GstStructure *struct1;
-  GstStructure *struct2;
-  GstCapsFeatures *features1;
-  GstCapsFeatures *features2;
+  GstCapsCacheKey key;
+  gboolean ret;
 
   g_return_val_if_fail (GST_IS_CAPS (caps1), FALSE);
   g_return_val_if_fail (GST_IS_CAPS (caps2), FALSE);
@@ -1560,6 +1842,27 @@ gst_caps_can_intersect (const GstCaps * caps1, const GstCaps * caps2)
   if (G_UNLIKELY (CAPS_IS_ANY (caps1) || CAPS_IS_ANY (caps2)))
     return TRUE;
 
+  if (!caps_cache_key_init (&key, CAPS_CACHE_CAN_INTERSECT, caps1, caps2))
+    return gst_caps_can_intersect_zig_zag (caps1, caps2);
+
+  if (!caps_cache_lookup (&key, NULL, &ret)) {
+    ret = gst_caps_can_intersect_zig_zag (caps1, caps2);
+    caps_cache_store (&key, NULL, ret);
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_caps_can_intersect_zig_zag (const GstCaps * caps1, const GstCaps * caps2)
+{
+  guint64 i;                    /* index can be up to 2 * G_MAX_UINT */
+  guint j, k, len1, len2;
+  GstStructure *struct1;
+  GstStructure *struct2;
+  GstCapsFeatures *features1;
+  GstCapsFeatures *features2;
+
   /* run zigzag on top line then right line, this preserves the caps order
    * much better than a simple loop.
    *
@@ -1755,6 +2058,10 @@ GstCaps *
 gst_caps_intersect_full (GstCaps * caps1, GstCaps * caps2,
     GstCapsIntersectMode mode)
 {
+  GstCapsCacheKey key;
+  GstCaps *result;
+  gboolean use_cache, res;
+
   g_return_val_if_fail (GST_IS_CAPS (caps1), NULL);
   g_return_val_if_fail (GST_IS_CAPS (caps2), NULL);
 
@@ -1774,15 +2081,27 @@ gst_caps_intersect_full (GstCaps * caps1, GstCaps * caps2,
   if (G_UNLIKELY (CAPS_IS_ANY (caps2)))
     return gst_caps_ref (caps1);
 
+  use_cache = caps_cache_key_init (&key, mode == GST_CAPS_INTERSECT_FIRST ?
+      CAPS_CACHE_INTERSECT_FIRST : CAPS_CACHE_INTERSECT_ZIG_ZAG, caps1, caps2);
+  if (use_cache && caps_cache_lookup (&key, &result, &res))
+    return result;
+
   switch (mode) {
     case GST_CAPS_INTERSECT_FIRST:
-      return gst_caps_intersect_first (caps1, caps2);
+      result = gst_caps_intersect_first (caps1, caps2);
+      break;
     default:
       g_warning ("Unknown caps intersect mode: %d", mode);
       /* fallthrough */
     case GST_CAPS_INTERSECT_ZIG_ZAG:
-      return gst_caps_intersect_zig_zag (caps1, caps2);
+      result = gst_caps_intersect_zig_zag (caps1, caps2);
+      break;
   }
+
+  if (use_cache)
+    caps_cache_store (&key, result, FALSE);
+
+  return result;
 }
 
 /**
@@ -61,6 +61,7 @@
 #include "gstinfo.h"
 #include "gsturi.h"
 #include "gstregistry.h"
+#include "gstregistrychunks.h"
 #include "gst.h"
 
 #include "glib-compat-private.h"
@@ -176,6 +177,31 @@ gst_element_factory_cleanup (GstElementFactory * factory)
 
   g_list_free (factory->interfaces);
   factory->interfaces = NULL;
+
+  /* only after the pad templates, their strings may point into the cache */
+  factory->cache_details = NULL;
+  if (factory->cache) {
+    g_bytes_unref (factory->cache);
+    factory->cache = NULL;
+  }
+}
+
+/* Element factories loaded from the registry cache only read their metadata
+ * and pad templates when they are first needed */
+void
+__gst_element_factory_ensure_details (GstElementFactory * factory)
+{
+  if (G_LIKELY (g_atomic_pointer_get (&factory->cache_details) == NULL))
+    return;
+
+  GST_OBJECT_LOCK (factory);
+  if (factory->cache_details != NULL) {
+    GST_LOG_OBJECT (factory, "loading details from registry cache");
+    if (!_priv_gst_registry_chunks_load_element_factory_details (factory))
+      GST_ERROR_OBJECT (factory, "failed to load details from registry cache");
+    g_atomic_pointer_set (&factory->cache_details, NULL);
+  }
+  GST_OBJECT_UNLOCK (factory);
 }
 
 #define CHECK_METADATA_FIELD(klass, name, key)                                 \
@@ -873,6 +899,8 @@ gst_element_factory_get_metadata (GstElementFactory * factory,
 {
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), NULL);
 
+  __gst_element_factory_ensure_details (factory);
+
   return gst_structure_get_string ((GstStructure *) factory->metadata, key);
 }
 
@@ -895,6 +923,8 @@ gst_element_factory_get_metadata_keys (GstElementFactory * factory)
 
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), NULL);
 
+  __gst_element_factory_ensure_details (factory);
+
   metadata = (GstStructure *) factory->metadata;
   if (metadata == NULL)
     return NULL;
@@ -962,6 +992,8 @@ gst_element_factory_get_static_pad_templates (GstElementFactory * factory)
 {
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), NULL);
 
+  __gst_element_factory_ensure_details (factory);
+
   return factory->staticpadtemplates;
 }
 
@@ -84,6 +84,8 @@
 
 GType _gst_event_type = 0;
 
+static GstSlabCache *event_cache = NULL;
+
 typedef struct
 {
   GstEvent event;
@@ -147,6 +149,8 @@ _priv_gst_event_initialize (void)
 
   _gst_event_type = gst_event_get_type ();
 
+  event_cache = _priv_gst_slab_cache_new ("event", sizeof (GstEventImpl));
+
   g_type_class_ref (gst_seek_flags_get_type ());
   g_type_class_ref (gst_seek_type_get_type ());
 
@@ -261,7 +265,7 @@ _gst_event_free (GstEvent * event)
   memset (event, 0xff, sizeof (GstEventImpl));
 #endif
 
-  g_free (event);
+  _priv_gst_slab_free (event_cache, event);
 }
 
 static void gst_event_init (GstEventImpl * event, GstEventType type);
@@ -272,7 +276,7 @@ _gst_event_copy (GstEvent * event)
   GstEventImpl *copy;
   GstStructure *s;
 
-  copy = g_new0 (GstEventImpl, 1);
+  copy = _priv_gst_slab_alloc0 (event_cache);
 
   gst_event_init (copy, GST_EVENT_TYPE (event));
 
@@ -332,7 +336,7 @@ gst_event_new_custom (GstEventType type, GstStructure * structure)
 {
   GstEventImpl *event;
 
-  event = g_new0 (GstEventImpl, 1);
+  event = _priv_gst_slab_alloc0 (event_cache);
 
   GST_CAT_DEBUG (GST_CAT_EVENT, "creating new event %p %s %d", event,
       gst_event_type_get_name (type), type);
@@ -353,7 +357,7 @@ gst_event_new_custom (GstEventType type, GstStructure * structure)
   /* ERRORS */
 had_parent:
   {
-    g_free (event);
+    _priv_gst_slab_free (event_cache, event);
     g_warning ("structure is already owned by another object");
     return NULL;
   }
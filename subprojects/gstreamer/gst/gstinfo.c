@@ -120,6 +120,15 @@
 static char *gst_info_printf_pointer_extension_func (const char *format,
     void *ptr);
 
+#ifndef GST_DISABLE_GST_DEBUG
+/* size of the per-thread buffers of the binary logger set up from
+ * GST_DEBUG_OPTIONS */
+#define BINARY_LOG_DEFAULT_SIZE_PER_THREAD (1 << 20)
+
+static gboolean gst_binary_logger_add (FILE * file, guint max_size_per_thread);
+static void gst_binary_logger_cleanup (void);
+#endif
+
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>           /* getpid on UNIX */
 #endif
@@ -394,13 +403,19 @@ _priv_gst_debug_init (void)
   FILE *log_file;
 
   if (add_default_log_func) {
+    gboolean binary = FALSE;
+
+    env = g_getenv ("GST_DEBUG_OPTIONS");
+    if (env != NULL && strstr (env, "binary"))
+      binary = TRUE;
+
     env = g_getenv ("GST_DEBUG_FILE");
     if (env != NULL && *env != '\0') {
       if (strcmp (env, "-") == 0) {
         log_file = stdout;
       } else {
         gchar *name = _priv_gst_debug_file_name (env);
-        log_file = g_fopen (name, "w");
+        log_file = g_fopen (name, binary ? "wb" : "w");
         g_free (name);
         if (log_file == NULL) {
           g_printerr ("Could not open log file '%s' for writing: %s\n", env,
@@ -412,7 +427,14 @@ _priv_gst_debug_init (void)
       log_file = stderr;
     }
 
-    gst_debug_add_log_function (gst_debug_log_default, log_file, NULL);
+    if (binary && log_file == stderr) {
+      g_printerr ("Binary debug logs need to go to GST_DEBUG_FILE\n");
+      binary = FALSE;
+    }
+
+    if (!binary || !gst_binary_logger_add (log_file,
+            BINARY_LOG_DEFAULT_SIZE_PER_THREAD))
+      gst_debug_add_log_function (gst_debug_log_default, log_file, NULL);
   }
 
   __gst_printf_pointer_extension_set_func
@@ -2550,6 +2572,8 @@ _priv_gst_debug_cleanup (void)
     __log_functions = g_slist_delete_link (__log_functions, __log_functions);
   }
   g_mutex_unlock (&__log_func_mutex);
+
+  gst_binary_logger_cleanup ();
 }
 
 static void
@@ -3766,6 +3790,750 @@ gst_debug_remove_ring_buffer_logger (void)
   gst_debug_remove_log_function (gst_ring_buffer_logger_log);
 }
 
+
+/* Binary logger
+ *
+ * Instead of formatting messages, the binary logger stores records with the
+ * category, level, timestamp, location, format string and the raw arguments
+ * of every message in a ring buffer of the logging thread. A background
+ * thread regularly moves the contents of all ring buffers to the log file,
+ * which can be turned into the usual text output with gst-debug-render-1.0.
+ *
+ * The file starts with a header:
+ *   8 bytes  "GSTBLOG\0"
+ *   guint32  BINARY_LOG_BYTE_ORDER, in the byte order of the writer
+ *   guint32  BINARY_LOG_VERSION
+ *   guint32  size of a pointer
+ *   guint32  process id
+ *
+ * followed by records that start with a guint32 size of the whole record
+ * (a multiple of 8), a guint8 type and 3 bytes padding:
+ *
+ * BINARY_RECORD_STRING: guint64 thread, guint64 key, string. Defines the
+ *   string for a key in the records of this thread. Keys are the pointers
+ *   to the categories, file, function names and format strings.
+ * BINARY_RECORD_MESSAGE: guint64 timestamp, guint64 thread, guint64 category
+ *   key, guint64 file key, guint64 function key, guint64 format key, guint32
+ *   line, guint32 level, string object id, then the arguments. Every argument
+ *   is a guint8 BINARY_ARG_* tag followed by its value, until BINARY_ARG_END.
+ *   A format key of 0 means the message was stored formatted, as a single
+ *   string argument.
+ * BINARY_RECORD_DROPPED: guint64 thread, guint64 number of messages that
+ *   were dropped because the ring buffer of the thread was full.
+ *
+ * Strings are a guint32 length followed by the characters, without
+ * terminator. All values are in the byte order of the writer.
+ */
+#define BINARY_LOG_MAGIC "GSTBLOG"
+#define BINARY_LOG_BYTE_ORDER 0x01020304
+#define BINARY_LOG_VERSION 1
+
+/* how often the ring buffers are written to the file */
+#define BINARY_LOG_FLUSH_INTERVAL (50 * G_TIME_SPAN_MILLISECOND)
+
+enum
+{
+  BINARY_RECORD_STRING = 1,
+  BINARY_RECORD_MESSAGE = 2,
+  BINARY_RECORD_DROPPED = 3,
+};
+
+enum
+{
+  BINARY_ARG_END = 0,
+  BINARY_ARG_INT = 1,           /* gint32, for %c and '*' width/precision */
+  BINARY_ARG_INT64 = 2,         /* gint64, all other integer conversions */
+  BINARY_ARG_DOUBLE = 3,
+  BINARY_ARG_STRING = 4,
+  BINARY_ARG_POINTER = 5,       /* guint64 */
+};
+
+typedef struct _GstBinaryLogger GstBinaryLogger;
+
+typedef struct
+{
+  gint refcount;
+  GstBinaryLogger *logger;
+  GThread *thread;
+
+  /* written by the logging thread, read by the flush thread. Positions
+   * increase monotonically and wrap around, size is a power of two */
+  guint8 *data;
+  guint size;
+  guint head;
+  guint tail;
+
+  /* only used by the logging thread */
+  guint64 dropped;
+  GHashTable *strings;
+  GByteArray *scratch;
+} GstBinaryLogRing;
+
+struct _GstBinaryLogger
+{
+  /* one reference for the log function, one for each log call in flight */
+  gint refcount;
+  /* set when the last reference wrote out the messages and closed the file */
+  gint closed;
+  FILE *file;
+  guint ring_size;
+
+  GMutex lock;
+  GCond cond;
+  GThread *flush_thread;
+  gboolean running;
+  /* protected by lock */
+  GList *rings;
+};
+
+G_LOCK_DEFINE_STATIC (binary_logger);
+static GstBinaryLogger *binary_logger = NULL;
+/* removed loggers, log calls might still be about to use them so they are
+ * only freed at deinit */
+static GSList *removed_binary_loggers = NULL;
+
+static void
+gst_binary_log_ring_unref (GstBinaryLogRing * ring)
+{
+  if (!g_atomic_int_dec_and_test (&ring->refcount))
+    return;
+
+  if (ring->strings)
+    g_hash_table_unref (ring->strings);
+  if (ring->scratch)
+    g_byte_array_unref (ring->scratch);
+  g_free (ring->data);
+  g_free (ring);
+}
+
+static GPrivate binary_log_ring_key =
+G_PRIVATE_INIT ((GDestroyNotify) gst_binary_log_ring_unref);
+
+static GstBinaryLogRing *
+gst_binary_log_ring_get (GstBinaryLogger * logger)
+{
+  GstBinaryLogRing *ring = g_private_get (&binary_log_ring_key);
+
+  if (G_LIKELY (ring != NULL && ring->logger == logger))
+    return ring;
+
+  ring = g_new0 (GstBinaryLogRing, 1);
+  /* owned by the thread and by the logger */
+  ring->refcount = 2;
+  ring->logger = logger;
+  ring->thread = g_thread_self ();
+  ring->size = logger->ring_size;
+  ring->data = g_malloc (ring->size);
+  ring->strings = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+  ring->scratch = g_byte_array_sized_new (256);
+
+  g_mutex_lock (&logger->lock);
+  logger->rings = g_list_prepend (logger->rings, ring);
+  g_mutex_unlock (&logger->lock);
+
+  g_private_replace (&binary_log_ring_key, ring);
+
+  return ring;
+}
+
+/* flush thread, called with the logger lock */
+static void
+gst_binary_log_ring_flush (GstBinaryLogger * logger, GstBinaryLogRing * ring)
+{
+  guint head = ring->head;
+  guint tail = g_atomic_int_get (&ring->tail);
+  guint offset = head & (ring->size - 1);
+  guint len = tail - head;
+
+  if (len == 0)
+    return;
+
+  if (offset + len > ring->size) {
+    fwrite (ring->data + offset, 1, ring->size - offset, logger->file);
+    fwrite (ring->data, 1, len - (ring->size - offset), logger->file);
+  } else {
+    fwrite (ring->data + offset, 1, len, logger->file);
+  }
+
+  g_atomic_int_set (&ring->head, tail);
+}
+
+static void
+gst_binary_logger_flush (GstBinaryLogger * logger)
+{
+  GList *l, *next;
+
+  for (l = logger->rings; l; l = next) {
+    GstBinaryLogRing *ring = l->data;
+
+    next = l->next;
+    gst_binary_log_ring_flush (logger, ring);
+
+    /* only we hold a reference, the thread exited */
+    if (g_atomic_int_get (&ring->refcount) == 1) {
+      logger->rings = g_list_delete_link (logger->rings, l);
+      gst_binary_log_ring_unref (ring);
+    }
+  }
+  fflush (logger->file);
+}
+
+static gpointer
+gst_binary_logger_flush_func (GstBinaryLogger * logger)
+{
+  g_mutex_lock (&logger->lock);
+  while (logger->running) {
+    g_cond_wait_until (&logger->cond, &logger->lock,
+        g_get_monotonic_time () + BINARY_LOG_FLUSH_INTERVAL);
+    gst_binary_logger_flush (logger);
+  }
+  g_mutex_unlock (&logger->lock);
+
+  return NULL;
+}
+
+static void
+gst_binary_logger_unref (GstBinaryLogger * logger)
+{
+  GList *l;
+
+  if (!g_atomic_int_dec_and_test (&logger->refcount))
+    return;
+
+  /* log calls that arrive after this take and drop a reference again */
+  if (!g_atomic_int_compare_and_exchange (&logger->closed, FALSE, TRUE))
+    return;
+
+  gst_binary_logger_flush (logger);
+  for (l = logger->rings; l; l = l->next) {
+    GstBinaryLogRing *ring = l->data;
+
+    /* threads that log again will notice and create a new ring */
+    ring->logger = NULL;
+    gst_binary_log_ring_unref (ring);
+  }
+  g_list_free (logger->rings);
+  logger->rings = NULL;
+
+  if (logger->file != stdout && logger->file != stderr)
+    fclose (logger->file);
+  logger->file = NULL;
+}
+
+/* logging thread, copies a record to the ring buffer. Returns FALSE if it
+ * does not fit */
+static gboolean
+gst_binary_log_ring_write (GstBinaryLogger * logger, GstBinaryLogRing * ring,
+    const guint8 * data, guint len)
+{
+  guint head = g_atomic_int_get (&ring->head);
+  guint tail = ring->tail;
+  guint offset = tail & (ring->size - 1);
+  guint used = tail - head;
+
+  if (G_UNLIKELY (len > ring->size - used))
+    return FALSE;
+
+  if (offset + len > ring->size) {
+    memcpy (ring->data + offset, data, ring->size - offset);
+    memcpy (ring->data, data + (ring->size - offset),
+        len - (ring->size - offset));
+  } else {
+    memcpy (ring->data + offset, data, len);
+  }
+
+  g_atomic_int_set (&ring->tail, tail + len);
+
+  /* wake up the flush thread early when getting more than half full, waiting
+   * for the timeout could make us drop messages */
+  if (G_UNLIKELY (used < ring->size / 2 && used + len >= ring->size / 2))
+    g_cond_signal (&logger->cond);
+
+  return TRUE;
+}
+
+static inline void
+binary_log_append_u8 (GByteArray * buf, guint8 val)
+{
+  g_byte_array_append (buf, &val, 1);
+}
+
+static inline void
+binary_log_append_u32 (GByteArray * buf, guint32 val)
+{
+  g_byte_array_append (buf, (const guint8 *) &val, 4);
+}
+
+static inline void
+binary_log_append_u64 (GByteArray * buf, guint64 val)
+{
+  g_byte_array_append (buf, (const guint8 *) &val, 8);
+}
+
+static inline void
+binary_log_append_string (GByteArray * buf, const gchar * str)
+{
+  guint32 len = str ? strlen (str) : 0;
+
+  binary_log_append_u32 (buf, len);
+  g_byte_array_append (buf, (const guint8 *) str, len);
+}
+
+static void
+binary_log_begin_record (GByteArray * buf, guint8 type)
+{
+  g_byte_array_set_size (buf, 0);
+  /* size is filled in by binary_log_end_record() */
+  binary_log_append_u32 (buf, 0);
+  binary_log_append_u8 (buf, type);
+  binary_log_append_u8 (buf, 0);
+  binary_log_append_u8 (buf, 0);
+  binary_log_append_u8 (buf, 0);
+}
+
+static void
+binary_log_end_record (GByteArray * buf)
+{
+  guint32 size = GST_ROUND_UP_8 (buf->len);
+
+  g_byte_array_set_size (buf, size);
+  memcpy (buf->data, &size, 4);
+}
+
+/* Stores the arguments for @format in @buf. Returns FALSE if @format has
+ * conversions that have to be formatted right away, like the GStreamer
+ * pointer extensions, positional arguments or long doubles. */
+static gboolean
+binary_log_append_args (GByteArray * buf, const gchar * format, va_list args)
+{
+  const gchar *p = format;
+
+  while ((p = strchr (p, '%'))) {
+    gint longs = 0, shorts = 0;
+    gboolean size_t_arg = FALSE;
+
+    p++;
+    if (*p == '%') {
+      p++;
+      continue;
+    }
+
+    /* flags */
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0'
+        || *p == '\'')
+      p++;
+
+    /* width and precision */
+    if (*p == '*') {
+      binary_log_append_u8 (buf, BINARY_ARG_INT);
+      binary_log_append_u32 (buf, va_arg (args, gint));
+      p++;
+    } else {
+      while (g_ascii_isdigit (*p))
+        p++;
+    }
+    if (*p == '.') {
+      p++;
+      if (*p == '*') {
+        binary_log_append_u8 (buf, BINARY_ARG_INT);
+        binary_log_append_u32 (buf, va_arg (args, gint));
+        p++;
+      } else {
+        while (g_ascii_isdigit (*p))
+          p++;
+      }
+    }
+
+    /* length modifiers */
+    switch (*p) {
+      case 'h':
+        shorts = p[1] == 'h' ? 2 : 1;
+        p += shorts;
+        break;
+      case 'l':
+        longs = p[1] == 'l' ? 2 : 1;
+        p += longs;
+        break;
+      case 'q':
+      case 'j':
+        longs = 2;
+        p++;
+        break;
+      case 'z':
+      case 't':
+        size_t_arg = TRUE;
+        p++;
+        break;
+      case 'I':
+        if (p[1] == '6' && p[2] == '4') {
+          longs = 2;
+          p += 3;
+        } else {
+          return FALSE;
+        }
+        break;
+      case 'L':
+        return FALSE;
+      default:
+        break;
+    }
+
+    switch (*p) {
+      case 'd':
+      case 'i':{
+        gint64 val;
+
+        if (longs == 2)
+          val = va_arg (args, gint64);
+        else if (longs == 1)
+          val = va_arg (args, glong);
+        else if (size_t_arg)
+          val = va_arg (args, gssize);
+        else if (shorts == 2)
+          val = (gint8) va_arg (args, gint);
+        else if (shorts == 1)
+          val = (gshort) va_arg (args, gint);
+        else
+          val = va_arg (args, gint);
+
+        binary_log_append_u8 (buf, BINARY_ARG_INT64);
+        binary_log_append_u64 (buf, val);
+        break;
+      }
+      case 'o':
+      case 'u':
+      case 'x':
+      case 'X':{
+        guint64 val;
+
+        if (longs == 2)
+          val = va_arg (args, guint64);
+        else if (longs == 1)
+          val = va_arg (args, gulong);
+        else if (size_t_arg)
+          val = va_arg (args, gsize);
+        else if (shorts == 2)
+          val = (guint8) va_arg (args, guint);
+        else if (shorts == 1)
+          val = (gushort) va_arg (args, guint);
+        else
+          val = va_arg (args, guint);
+
+        binary_log_append_u8 (buf, BINARY_ARG_INT64);
+        binary_log_append_u64 (buf, val);
+        break;
+      }
+      case 'c':
+        if (longs)
+          return FALSE;
+        binary_log_append_u8 (buf, BINARY_ARG_INT);
+        binary_log_append_u32 (buf, va_arg (args, gint));
+        break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':{
+        gdouble val = va_arg (args, gdouble);
+
+        binary_log_append_u8 (buf, BINARY_ARG_DOUBLE);
+        g_byte_array_append (buf, (const guint8 *) &val, 8);
+        break;
+      }
+      case 's':
+        if (longs)
+          return FALSE;
+        binary_log_append_u8 (buf, BINARY_ARG_STRING);
+        binary_log_append_string (buf, va_arg (args, const gchar *));
+        break;
+      case 'p':
+        /* GST_PTR_FORMAT and friends */
+        if (p[1] == '\a')
+          return FALSE;
+        binary_log_append_u8 (buf, BINARY_ARG_POINTER);
+        binary_log_append_u64 (buf, GPOINTER_TO_SIZE (va_arg (args,
+                    gpointer)));
+        break;
+      default:
+        return FALSE;
+    }
+    p++;
+  }
+  binary_log_append_u8 (buf, BINARY_ARG_END);
+
+  return TRUE;
+}
+
+/* Writes a string record for @key unless this thread already did that since
+ * the last dropped message. Returns FALSE if the ring buffer is full. */
+static gboolean
+gst_binary_log_ring_intern (GstBinaryLogger * logger, GstBinaryLogRing * ring,
+    gconstpointer key, const gchar * str)
+{
+  const gchar *written = g_hash_table_lookup (ring->strings, key);
+  GByteArray *buf = ring->scratch;
+
+  /* compare the contents, format strings are not necessarily static */
+  if (G_LIKELY (written != NULL && strcmp (written, str) == 0))
+    return TRUE;
+
+  binary_log_begin_record (buf, BINARY_RECORD_STRING);
+  binary_log_append_u64 (buf, GPOINTER_TO_SIZE (ring->thread));
+  binary_log_append_u64 (buf, GPOINTER_TO_SIZE (key));
+  binary_log_append_string (buf, str);
+  binary_log_end_record (buf);
+
+  if (!gst_binary_log_ring_write (logger, ring, buf->data, buf->len))
+    return FALSE;
+
+  g_hash_table_insert (ring->strings, (gpointer) key, g_strdup (str));
+
+  return TRUE;
+}
+
+static void
+gst_binary_logger_log (GstDebugCategory * category,
+    GstDebugLevel level, const gchar * file, const gchar * function,
+    gint line, GObject * object, GstDebugMessage * message, gpointer user_data)
+{
+  GstBinaryLogger *logger = user_data;
+  GstBinaryLogRing *ring;
+  GstClockTime elapsed;
+  GByteArray *buf;
+  const gchar *format = NULL;
+  guint format_offset, args_start;
+  gchar c;
+
+  /* the logger might be removed concurrently, its memory stays valid until
+   * deinit and the reference keeps it from closing the file under us */
+  g_atomic_int_inc (&logger->refcount);
+  if (G_UNLIKELY (!g_atomic_int_get (&logger->running)))
+    goto done;
+
+  elapsed = GST_CLOCK_DIFF (_priv_gst_start_time, gst_util_get_timestamp ());
+  ring = gst_binary_log_ring_get (logger);
+
+  /* messages that were already formatted, e.g. by another log function or
+   * because they were logged as literals, are stored as they are */
+  if (message->message == NULL)
+    format = message->format;
+
+  c = file[0];
+  if (c == '.' || c == '/' || c == '\\' || (c != '\0' && file[1] == ':'))
+    file = gst_path_basename (file);
+
+  if (G_UNLIKELY (ring->dropped > 0)) {
+    buf = ring->scratch;
+    binary_log_begin_record (buf, BINARY_RECORD_DROPPED);
+    binary_log_append_u64 (buf, GPOINTER_TO_SIZE (ring->thread));
+    binary_log_append_u64 (buf, ring->dropped);
+    binary_log_end_record (buf);
+    if (!gst_binary_log_ring_write (logger, ring, buf->data, buf->len))
+      goto dropped;
+    ring->dropped = 0;
+  }
+
+  if (!gst_binary_log_ring_intern (logger, ring, category,
+          gst_debug_category_get_name (category))
+      || !gst_binary_log_ring_intern (logger, ring, file, file)
+      || !gst_binary_log_ring_intern (logger, ring, function, function)
+      || (format && !gst_binary_log_ring_intern (logger, ring, format,
+              format)))
+    goto dropped;
+
+  buf = ring->scratch;
+  binary_log_begin_record (buf, BINARY_RECORD_MESSAGE);
+  binary_log_append_u64 (buf, elapsed);
+  binary_log_append_u64 (buf, GPOINTER_TO_SIZE (ring->thread));
+  binary_log_append_u64 (buf, GPOINTER_TO_SIZE (category));
+  binary_log_append_u64 (buf, GPOINTER_TO_SIZE (file));
+  binary_log_append_u64 (buf, GPOINTER_TO_SIZE (function));
+  format_offset = buf->len;
+  binary_log_append_u64 (buf, GPOINTER_TO_SIZE (format));
+  binary_log_append_u32 (buf, line);
+  binary_log_append_u32 (buf, level);
+  binary_log_append_string (buf, gst_debug_message_get_id (message));
+
+  args_start = buf->len;
+  if (format) {
+    va_list args;
+    gboolean stored;
+
+    G_VA_COPY (args, message->arguments);
+    stored = binary_log_append_args (buf, format, args);
+    va_end (args);
+
+    if (!stored) {
+      guint64 no_format = 0;
+
+      memcpy (buf->data + format_offset, &no_format, 8);
+      format = NULL;
+      g_byte_array_set_size (buf, args_start);
+    }
+  }
+  if (!format) {
+    binary_log_append_u8 (buf, BINARY_ARG_STRING);
+    binary_log_append_string (buf, gst_debug_message_get (message));
+    binary_log_append_u8 (buf, BINARY_ARG_END);
+  }
+  binary_log_end_record (buf);
+
+  if (!gst_binary_log_ring_write (logger, ring, buf->data, buf->len))
+    goto dropped;
+
+done:
+  gst_binary_logger_unref (logger);
+  return;
+
+dropped:
+  {
+    /* the string records might have been dropped too, write them again */
+    ring->dropped++;
+    g_hash_table_remove_all (ring->strings);
+    goto done;
+  }
+}
+
+static void
+gst_binary_logger_free (GstBinaryLogger * logger)
+{
+  G_LOCK (binary_logger);
+  if (binary_logger == logger)
+    binary_logger = NULL;
+  removed_binary_loggers = g_slist_prepend (removed_binary_loggers, logger);
+  G_UNLOCK (binary_logger);
+
+  g_mutex_lock (&logger->lock);
+  g_atomic_int_set (&logger->running, FALSE);
+  g_cond_signal (&logger->cond);
+  g_mutex_unlock (&logger->lock);
+  g_thread_join (logger->flush_thread);
+
+  /* log calls that are still in flight keep the file open, the last one
+   * writes out what is left */
+  gst_binary_logger_unref (logger);
+}
+
+static void
+gst_binary_logger_cleanup (void)
+{
+  G_LOCK (binary_logger);
+  while (removed_binary_loggers) {
+    GstBinaryLogger *logger = removed_binary_loggers->data;
+
+    g_mutex_clear (&logger->lock);
+    g_cond_clear (&logger->cond);
+    g_free (logger);
+    removed_binary_loggers = g_slist_delete_link (removed_binary_loggers,
+        removed_binary_loggers);
+  }
+  G_UNLOCK (binary_logger);
+}
+
+
+static gboolean
+gst_binary_logger_add (FILE * file, guint max_size_per_thread)
+{
+  GstBinaryLogger *logger;
+  guint32 header[4];
+
+  G_LOCK (binary_logger);
+
+  if (binary_logger) {
+    g_warn_if_reached ();
+    G_UNLOCK (binary_logger);
+    return FALSE;
+  }
+
+  logger = binary_logger = g_new0 (GstBinaryLogger, 1);
+
+  logger->refcount = 1;
+  logger->file = file;
+  logger->ring_size = g_bit_nth_msf (MAX (max_size_per_thread, 4096), -1);
+  logger->ring_size = 1U << MIN (logger->ring_size, 30);
+  g_mutex_init (&logger->lock);
+  g_cond_init (&logger->cond);
+  logger->running = TRUE;
+
+  header[0] = BINARY_LOG_BYTE_ORDER;
+  header[1] = BINARY_LOG_VERSION;
+  header[2] = GLIB_SIZEOF_VOID_P;
+  header[3] = _gst_getpid ();
+  fwrite (BINARY_LOG_MAGIC, 1, 8, file);
+  fwrite (header, 4, 4, file);
+
+  logger->flush_thread = g_thread_new ("gst-binary-log",
+      (GThreadFunc) gst_binary_logger_flush_func, logger);
+
+  gst_debug_add_log_function (gst_binary_logger_log, logger,
+      (GDestroyNotify) gst_binary_logger_free);
+  G_UNLOCK (binary_logger);
+
+  return TRUE;
+}
+
+/**
+ * gst_debug_add_binary_logger:
+ * @filename: (type filename): the file to write the log to
+ * @max_size_per_thread: size of the buffer for each thread in bytes
+ *
+ * Adds a debug logger that does not format the messages but writes binary
+ * records with the raw arguments of each message to @filename. Logging
+ * threads store the records without locking in a ring buffer of
+ * @max_size_per_thread bytes, which is written to the file from a separate
+ * thread. Messages are dropped when a ring buffer is full.
+ *
+ * This disturbs the timing of the application much less than the default log
+ * function, the log can be turned into the usual text format afterwards with
+ * gst-debug-render-1.0. It is also used instead of the default log function
+ * if "binary" is set in the GST_DEBUG_OPTIONS environment variable.
+ *
+ * The logger can be removed again with gst_debug_remove_binary_logger(). Only
+ * one logger at a time is possible.
+ *
+ * Returns: %TRUE if the logger was added
+ *
+ * Since: 1.24
+ */
+gboolean
+gst_debug_add_binary_logger (const gchar * filename, guint max_size_per_thread)
+{
+  FILE *file;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  file = g_fopen (filename, "wb");
+  if (file == NULL) {
+    GST_WARNING ("Could not open log file '%s' for writing: %s", filename,
+        g_strerror (errno));
+    return FALSE;
+  }
+
+  if (!gst_binary_logger_add (file, max_size_per_thread)) {
+    fclose (file);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+ * gst_debug_remove_binary_logger:
+ *
+ * Removes any previously added binary logger with
+ * gst_debug_add_binary_logger() and writes out the pending messages.
+ *
+ * Since: 1.24
+ */
+void
+gst_debug_remove_binary_logger (void)
+{
+  gst_debug_remove_log_function (gst_binary_logger_log);
+}
+
 #else /* GST_DISABLE_GST_DEBUG */
 #ifndef GST_REMOVE_DISABLED
 
@@ -3786,5 +4554,16 @@ gst_debug_remove_ring_buffer_logger (void)
 {
 }
 
+gboolean
+gst_debug_add_binary_logger (const gchar * filename, guint max_size_per_thread)
+{
+  return FALSE;
+}
+
+void
+gst_debug_remove_binary_logger (void)
+{
+}
+
 #endif /* GST_REMOVE_DISABLED */
 #endif /* GST_DISABLE_GST_DEBUG */
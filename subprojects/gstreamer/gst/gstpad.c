@@ -138,9 +138,16 @@ struct _GstPadPrivate
   GArray *events;
   guint last_cookie;
 
+  /* number of threads pushing or pulling through the pad, modified with
+   * atomic operations because the push fast path releases it without
+   * taking the object lock */
   gint using;
   guint probe_list_cookie;
 
+  /* an idle probe was added while the pad was in use and still needs to be
+   * called by the last thread leaving it. Protected by the object lock */
+  gboolean idle_delayed;
+
   /* counter of how many idle probes are running directly from the add_probe
    * call. Used to block any data flowing in the pad while the idle callback
    * Doesn't finish its work */
@@ -1398,7 +1405,7 @@ cleanup_hook (GstPad * pad, GHook * hook)
     }
   }
   g_hook_destroy_link (&pad->probes, hook);
-  pad->num_probes--;
+  g_atomic_int_add (&pad->num_probes, -1);
 }
 
 /**
@@ -1461,7 +1468,9 @@ gst_pad_add_probe (GstPad * pad, GstPadProbeType mask,
 
   /* add the probe */
   g_hook_append (&pad->probes, hook);
-  pad->num_probes++;
+  /* atomically, so that either we see the pad in use below or the push
+   * fast path sees the new probe when leaving the pad */
+  g_atomic_int_inc (&pad->num_probes);
   /* incremenent cookie so that the new hook gets called */
   pad->priv->probe_list_cookie++;
 
@@ -1484,12 +1493,13 @@ gst_pad_add_probe (GstPad * pad, GstPadProbeType mask,
 
   /* call the callback if we need to be called for idle callbacks */
   if ((mask & GST_PAD_PROBE_TYPE_IDLE) && (callback != NULL)) {
-    if (pad->priv->using > 0) {
+    if (g_atomic_int_get (&pad->priv->using) > 0) {
       /* the pad is in use, we can't signal the idle callback yet. Since we set the
        * flag above, the last thread to leave the push will do the callback. New
        * threads going into the push will block. */
       GST_CAT_LOG_OBJECT (GST_CAT_SCHEDULING, pad,
           "pad is in use, delay idle callback");
+      pad->priv->idle_delayed = TRUE;
       GST_OBJECT_UNLOCK (pad);
     } else {
       GstPadProbeInfo info = { GST_PAD_PROBE_TYPE_IDLE, res, };
@@ -4677,6 +4687,51 @@ gst_pad_chain_list (GstPad * pad, GstBufferList * list)
       GST_PAD_PROBE_TYPE_BUFFER_LIST | GST_PAD_PROBE_TYPE_PUSH, list);
 }
 
+/* flags that make gst_pad_push_data() take the slow path */
+#define PAD_PUSH_SLOW_FLAGS \
+    (GST_PAD_FLAG_FLUSHING | GST_PAD_FLAG_EOS | GST_PAD_FLAG_PENDING_EVENTS)
+
+#ifdef GST_ENABLE_EXTRA_CHECKS
+#define PAD_PUSH_CHECKED(pad) \
+    ((pad)->priv->last_cookie == (pad)->priv->events_cookie)
+#else
+#define PAD_PUSH_CHECKED(pad) TRUE
+#endif
+
+/* TRUE when data can be pushed on @pad without checking for flushing, EOS or
+ * sticky events and without running probes. Call with the pad LOCK. */
+#define PAD_CAN_PUSH_FAST(pad) \
+    ((pad)->num_probes == 0 && \
+     (GST_OBJECT_FLAGS (pad) & PAD_PUSH_SLOW_FLAGS) == 0 && \
+     GST_PAD_MODE (pad) == GST_PAD_MODE_PUSH && PAD_PUSH_CHECKED (pad))
+
+/* called without the pad LOCK by the last thread leaving the push fast path
+ * when probes were added while it was pushing. Runs the idle probes that
+ * gst_pad_add_probe() left for us. */
+static GstFlowReturn
+gst_pad_push_data_idle (GstPad * pad, GstFlowReturn ret)
+{
+  GST_OBJECT_LOCK (pad);
+  if (pad->priv->idle_delayed && g_atomic_int_get (&pad->priv->using) == 0) {
+    pad->priv->idle_delayed = FALSE;
+    PROBE_NO_DATA (pad, GST_PAD_PROBE_TYPE_PUSH | GST_PAD_PROBE_TYPE_IDLE,
+        probe_stopped, ret);
+  }
+  GST_OBJECT_UNLOCK (pad);
+
+  return ret;
+
+  /* ERRORS */
+probe_stopped:
+  {
+    if (ret == GST_FLOW_CUSTOM_SUCCESS || ret == GST_FLOW_CUSTOM_SUCCESS_1)
+      ret = GST_FLOW_OK;
+    pad->ABI.abi.last_flowret = ret;
+    GST_OBJECT_UNLOCK (pad);
+    return ret;
+  }
+}
+
 static GstFlowReturn
 gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
 {
@@ -4685,6 +4740,34 @@ gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
   gboolean handled = FALSE;
 
   GST_OBJECT_LOCK (pad);
+  if (G_LIKELY (PAD_CAN_PUSH_FAST (pad))) {
+    /* common case: nothing to check but the peer, and unless probes are
+     * added meanwhile no need to take the lock again after pushing */
+    if (G_UNLIKELY ((peer = GST_PAD_PEER (pad)) == NULL))
+      goto not_linked;
+
+    gst_object_ref (peer);
+    g_atomic_int_inc (&pad->priv->using);
+    GST_OBJECT_UNLOCK (pad);
+
+    ret = gst_pad_chain_data_unchecked (peer, type, data);
+
+    gst_object_unref (peer);
+
+    /* the flow return rarely changes, only take the lock again when it
+     * does */
+    if (G_UNLIKELY (pad->ABI.abi.last_flowret != ret)) {
+      GST_OBJECT_LOCK (pad);
+      pad->ABI.abi.last_flowret = ret;
+      GST_OBJECT_UNLOCK (pad);
+    }
+    if (g_atomic_int_dec_and_test (&pad->priv->using) &&
+        G_UNLIKELY (g_atomic_int_get (&pad->num_probes) > 0))
+      ret = gst_pad_push_data_idle (pad, ret);
+
+    return ret;
+  }
+
   if (G_UNLIKELY (GST_PAD_IS_FLUSHING (pad)))
     goto flushing;
 
@@ -4733,7 +4816,7 @@ gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
 
   /* take ref to peer pad before releasing the lock */
   gst_object_ref (peer);
-  pad->priv->using++;
+  g_atomic_int_inc (&pad->priv->using);
   GST_OBJECT_UNLOCK (pad);
 
   ret = gst_pad_chain_data_unchecked (peer, type, data);
@@ -4743,9 +4826,9 @@ gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
 
   GST_OBJECT_LOCK (pad);
   pad->ABI.abi.last_flowret = ret;
-  pad->priv->using--;
-  if (pad->priv->using == 0) {
+  if (g_atomic_int_dec_and_test (&pad->priv->using)) {
     /* pad is not active anymore, trigger idle callbacks */
+    pad->priv->idle_delayed = FALSE;
     PROBE_NO_DATA (pad, GST_PAD_PROBE_TYPE_PUSH | GST_PAD_PROBE_TYPE_IDLE,
         probe_stopped, ret);
   }
@@ -5187,7 +5270,7 @@ gst_pad_pull_range (GstPad * pad, guint64 offset, guint size,
     goto not_linked;
 
   gst_object_ref (peer);
-  pad->priv->using++;
+  g_atomic_int_inc (&pad->priv->using);
   GST_OBJECT_UNLOCK (pad);
 
   ret = gst_pad_get_range_unchecked (peer, offset, size, &res_buf);
@@ -5195,10 +5278,10 @@ gst_pad_pull_range (GstPad * pad, guint64 offset, guint size,
   gst_object_unref (peer);
 
   GST_OBJECT_LOCK (pad);
-  pad->priv->using--;
   pad->ABI.abi.last_flowret = ret;
-  if (pad->priv->using == 0) {
+  if (g_atomic_int_dec_and_test (&pad->priv->using)) {
     /* pad is not active anymore, trigger idle callbacks */
+    pad->priv->idle_delayed = FALSE;
     PROBE_NO_DATA (pad, GST_PAD_PROBE_TYPE_PULL | GST_PAD_PROBE_TYPE_IDLE,
         probe_stopped_unref, ret);
   }
@@ -5563,7 +5646,7 @@ gst_pad_push_event_unchecked (GstPad * pad, GstEvent * event,
     goto not_linked;
 
   gst_object_ref (peerpad);
-  pad->priv->using++;
+  g_atomic_int_inc (&pad->priv->using);
   GST_OBJECT_UNLOCK (pad);
 
   GST_LOG_OBJECT (pad,
@@ -5581,9 +5664,9 @@ gst_pad_push_event_unchecked (GstPad * pad, GstEvent * event,
   gst_object_unref (peerpad);
 
   GST_OBJECT_LOCK (pad);
-  pad->priv->using--;
-  if (pad->priv->using == 0) {
+  if (g_atomic_int_dec_and_test (&pad->priv->using)) {
     /* pad is not active anymore, trigger idle callbacks */
+    pad->priv->idle_delayed = FALSE;
     PROBE_NO_DATA (pad, GST_PAD_PROBE_TYPE_PUSH | GST_PAD_PROBE_TYPE_IDLE,
         idle_probe_stopped, ret);
   }
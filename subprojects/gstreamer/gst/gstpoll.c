@@ -51,6 +51,11 @@
  * descriptor, and gst_poll_fd_can_write() to see if it is possible to
  * write to it.
  *
+ * On Linux, sets created with gst_poll_new() switch to epoll once they contain
+ * more than a few dozen file descriptors, so that the cost of a wait depends
+ * on the number of file descriptors with activity instead of the size of the
+ * set. Setting GST_POLL_EPOLL=no in the environment disables this.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -83,6 +88,10 @@
 #endif
 #include <sys/time.h>
 #include <sys/socket.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#define HAVE_EPOLL 1
+#endif
 #endif
 
 #ifdef G_OS_WIN32
@@ -124,7 +133,8 @@ typedef enum
   GST_POLL_MODE_PSELECT,
   GST_POLL_MODE_POLL,
   GST_POLL_MODE_PPOLL,
-  GST_POLL_MODE_WINDOWS
+  GST_POLL_MODE_WINDOWS,
+  GST_POLL_MODE_EPOLL
 } GstPollMode;
 
 struct _GstPoll
@@ -142,6 +152,21 @@ struct _GstPoll
 #ifndef G_OS_WIN32
   GstPollFD control_read_fd;
   GstPollFD control_write_fd;
+#ifdef HAVE_EPOLL
+  /* the epoll instance once the set switched to epoll, -1 before. The results
+   * of a wait are then stored in the revents of fds instead of active_fds */
+  gint epoll_fd;
+  gboolean epoll_allowed;
+  /* index in fds for each fd number, -1 if not in the set */
+  GArray *epoll_index;
+  /* fds with results from the last wait */
+  GArray *epoll_reported;
+  /* fds that were readable, had an error or were hung up in the last wait,
+   * checked again before the next wait */
+  GArray *epoll_recheck;
+  struct epoll_event *epoll_events;
+  guint n_epoll_events;
+#endif
 #else
   GArray *active_fds_ignored;
   GArray *events;
@@ -172,6 +197,19 @@ static gboolean gst_poll_add_fd_unlocked (GstPoll * set, GstPollFD * fd);
 #define TEST_REBUILD(s)     (g_atomic_int_compare_and_exchange(&(s)->rebuild, 1, 0))
 #define MARK_REBUILD(s)     (g_atomic_int_set(&(s)->rebuild, 1))
 
+#ifdef HAVE_EPOLL
+#define USE_EPOLL(s)        ((s)->epoll_fd >= 0)
+/* the array holding the results of the last wait */
+#define RESULT_FDS(s)       (USE_EPOLL (s) ? (s)->fds : (s)->active_fds)
+
+/* number of fds from which on a set switches to epoll */
+#define EPOLL_MIN_FDS       64
+/* initial number of events collected per epoll_wait() */
+#define EPOLL_MIN_EVENTS    64
+#else
+#define RESULT_FDS(s)       ((s)->active_fds)
+#endif
+
 #ifndef G_OS_WIN32
 
 static gboolean
@@ -434,11 +472,262 @@ pollable_timeout (GstClockTime timeout)
 }
 #endif
 
+#ifdef HAVE_EPOLL
+static guint32
+pollfd_to_epoll_events (gshort events)
+{
+  /* hangups and errors are always reported */
+  guint32 res = EPOLLET;
+
+  if (events & POLLIN)
+    res |= EPOLLIN;
+  if (events & POLLPRI)
+    res |= EPOLLPRI;
+  if (events & POLLOUT)
+    res |= EPOLLOUT;
+
+  return res;
+}
+
+static gshort
+epoll_to_pollfd_events (guint32 events)
+{
+  gshort res = 0;
+
+  if (events & EPOLLIN)
+    res |= POLLIN;
+  if (events & EPOLLPRI)
+    res |= POLLPRI;
+  if (events & EPOLLOUT)
+    res |= POLLOUT;
+  if (events & EPOLLERR)
+    res |= POLLERR;
+  if (events & EPOLLHUP)
+    res |= POLLHUP;
+
+  return res;
+}
+
+/* must be called with the lock */
+static void
+epoll_set_index (GstPoll * set, gint fd, gint idx)
+{
+  if (fd >= (gint) set->epoll_index->len) {
+    guint i = set->epoll_index->len;
+
+    g_array_set_size (set->epoll_index, fd + 1);
+    for (; i < set->epoll_index->len; i++)
+      g_array_index (set->epoll_index, gint, i) = -1;
+  }
+  g_array_index (set->epoll_index, gint, fd) = idx;
+}
+
+/* must be called with the lock */
+static struct pollfd *
+epoll_lookup (GstPoll * set, gint fd)
+{
+  gint idx;
+
+  if (fd < 0 || fd >= (gint) set->epoll_index->len)
+    return NULL;
+
+  idx = g_array_index (set->epoll_index, gint, fd);
+  if (idx < 0)
+    return NULL;
+
+  return &g_array_index (set->fds, struct pollfd, idx);
+}
+
+/* must be called with the lock */
+static void
+epoll_update (GstPoll * set, gint op, struct pollfd *pfd)
+{
+  struct epoll_event ev = { 0, };
+
+  ev.events = pollfd_to_epoll_events (pfd->events);
+  ev.data.fd = pfd->fd;
+
+  if (epoll_ctl (set->epoll_fd, op, pfd->fd, &ev) < 0) {
+    /* fds that were closed before removing them are already gone */
+    if (op == EPOLL_CTL_DEL) {
+      GST_DEBUG ("%p: can't remove fd %d from epoll: %s", set, pfd->fd,
+          g_strerror (errno));
+    } else {
+      GST_WARNING ("%p: can't update fd %d in epoll: %s", set, pfd->fd,
+          g_strerror (errno));
+    }
+  }
+}
+
+/* switch to epoll when the set is large enough, must be called from the
+ * waiting thread. Returns TRUE when the set uses epoll. */
+static gboolean
+epoll_check (GstPoll * set)
+{
+  guint i;
+
+  if (USE_EPOLL (set))
+    return TRUE;
+  if (!set->epoll_allowed || set->timer)
+    return FALSE;
+
+  g_mutex_lock (&set->lock);
+  if (set->fds->len < EPOLL_MIN_FDS)
+    goto done;
+
+  set->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  if (set->epoll_fd < 0)
+    goto no_epoll;
+
+  GST_DEBUG ("%p: switching to epoll with %u fds", set, set->fds->len);
+
+  set->epoll_index = g_array_new (FALSE, FALSE, sizeof (gint));
+  set->epoll_reported = g_array_new (FALSE, FALSE, sizeof (gint));
+  set->epoll_recheck = g_array_new (FALSE, FALSE, sizeof (struct pollfd));
+  set->n_epoll_events = EPOLL_MIN_EVENTS;
+  set->epoll_events = g_new (struct epoll_event, set->n_epoll_events);
+
+  for (i = 0; i < set->fds->len; i++) {
+    struct pollfd *pfd = &g_array_index (set->fds, struct pollfd, i);
+
+    pfd->revents = 0;
+    epoll_set_index (set, pfd->fd, i);
+    epoll_update (set, EPOLL_CTL_ADD, pfd);
+  }
+
+done:
+  g_mutex_unlock (&set->lock);
+
+  return USE_EPOLL (set);
+
+  /* ERRORS */
+no_epoll:
+  {
+    GST_WARNING ("%p: can't create epoll instance: %s", set,
+        g_strerror (errno));
+    set->epoll_allowed = FALSE;
+    g_mutex_unlock (&set->lock);
+    return FALSE;
+  }
+}
+
+/* must be called with the lock */
+static void
+epoll_add_result (GstPoll * set, gint fd, gshort revents)
+{
+  struct pollfd *pfd;
+
+  /* removed while waiting */
+  if (!(pfd = epoll_lookup (set, fd)))
+    return;
+
+  revents &= pfd->events | POLLERR | POLLHUP;
+  if (revents == 0)
+    return;
+
+  if (pfd->revents == 0)
+    g_array_append_val (set->epoll_reported, fd);
+  pfd->revents |= revents;
+}
+
+/* Wait for events on the epoll instance and store them in the revents of the
+ * fds. All fds are registered edge-triggered, which makes write readiness
+ * edge-triggered too: it is reported once and then only again after a write
+ * failed with EAGAIN or after gst_poll_fd_ctl_write() or
+ * gst_poll_fd_ignored() was called for the fd. Everything else keeps the
+ * level-triggered behaviour of poll(): fds that were readable, had an error
+ * or were hung up are checked again with poll() before the next wait. */
+static gint
+epoll_wait_fds (GstPoll * set, GstClockTime timeout)
+{
+  guint i, n_checks;
+  gint res, n_checked = 0, t;
+
+  g_mutex_lock (&set->lock);
+  /* forget the results of the last wait */
+  for (i = 0; i < set->epoll_reported->len; i++) {
+    struct pollfd *pfd =
+        epoll_lookup (set, g_array_index (set->epoll_reported, gint, i));
+
+    if (pfd)
+      pfd->revents = 0;
+  }
+  g_array_set_size (set->epoll_reported, 0);
+  g_mutex_unlock (&set->lock);
+
+  /* the recheck array is only used by the waiting thread */
+  n_checks = set->epoll_recheck->len;
+  if (n_checks > 0) {
+    n_checked = poll ((struct pollfd *) set->epoll_recheck->data, n_checks, 0);
+    if (n_checked < 0)
+      return -1;
+  }
+
+  if (n_checked > 0) {
+    t = 0;
+  } else if (timeout != GST_CLOCK_TIME_NONE) {
+    /* round up, epoll_wait() must not return before the timeout */
+    t = MIN (GST_TIME_AS_MSECONDS (timeout + GST_MSECOND - 1), G_MAXINT);
+  } else {
+    t = -1;
+  }
+
+  res = epoll_wait (set->epoll_fd, set->epoll_events, set->n_epoll_events, t);
+  if (res < 0)
+    return -1;
+
+  g_mutex_lock (&set->lock);
+  for (i = 0; n_checked > 0 && i < n_checks; i++) {
+    struct pollfd *check =
+        &g_array_index (set->epoll_recheck, struct pollfd, i);
+
+    if (check->revents)
+      epoll_add_result (set, check->fd, check->revents);
+  }
+  for (i = 0; i < res; i++) {
+    epoll_add_result (set, set->epoll_events[i].data.fd,
+        epoll_to_pollfd_events (set->epoll_events[i].events));
+  }
+
+  /* check the fds with lasting conditions again before the next wait */
+  g_array_set_size (set->epoll_recheck, 0);
+  for (i = 0; i < set->epoll_reported->len; i++) {
+    gint fd = g_array_index (set->epoll_reported, gint, i);
+    struct pollfd *pfd = epoll_lookup (set, fd);
+
+    if (pfd && (pfd->revents & (POLLIN | POLLPRI | POLLERR | POLLHUP))) {
+      struct pollfd check;
+
+      check.fd = fd;
+      check.events = pfd->events & (POLLIN | POLLPRI);
+      check.revents = 0;
+      g_array_append_val (set->epoll_recheck, check);
+    }
+  }
+  n_checked = set->epoll_reported->len;
+  g_mutex_unlock (&set->lock);
+
+  /* collect more events per call when they did not all fit */
+  if (res == set->n_epoll_events) {
+    set->n_epoll_events *= 2;
+    set->epoll_events = g_renew (struct epoll_event, set->epoll_events,
+        set->n_epoll_events);
+  }
+
+  return n_checked;
+}
+#endif
+
 static GstPollMode
 choose_mode (GstPoll * set, GstClockTime timeout)
 {
   GstPollMode mode;
 
+#ifdef HAVE_EPOLL
+  if (set->mode == GST_POLL_MODE_AUTO && epoll_check (set))
+    return GST_POLL_MODE_EPOLL;
+#endif
+
   if (set->mode == GST_POLL_MODE_AUTO) {
 #ifdef HAVE_PPOLL
     mode = GST_POLL_MODE_PPOLL;
@@ -686,6 +975,14 @@ gst_poll_new (gboolean controllable)
   nset->active_fds = g_array_new (FALSE, FALSE, sizeof (struct pollfd));
   nset->control_read_fd.fd = -1;
   nset->control_write_fd.fd = -1;
+#ifdef HAVE_EPOLL
+  nset->epoll_fd = -1;
+  {
+    const gchar *env = g_getenv ("GST_POLL_EPOLL");
+
+    nset->epoll_allowed = !(env && strcmp (env, "no") == 0);
+  }
+#endif
   {
     gint control_sock[2];
 
@@ -776,6 +1073,15 @@ gst_poll_free (GstPoll * set)
     close (set->control_write_fd.fd);
   if (set->control_read_fd.fd >= 0)
     close (set->control_read_fd.fd);
+#ifdef HAVE_EPOLL
+  if (USE_EPOLL (set)) {
+    close (set->epoll_fd);
+    g_array_free (set->epoll_index, TRUE);
+    g_array_free (set->epoll_reported, TRUE);
+    g_array_free (set->epoll_recheck, TRUE);
+    g_free (set->epoll_events);
+  }
+#endif
 #else
   CloseHandle (set->wakeup_event);
 
@@ -859,6 +1165,12 @@ gst_poll_add_fd_unlocked (GstPoll * set, GstPollFD * fd)
     g_array_append_val (set->fds, nfd);
 
     fd->idx = set->fds->len - 1;
+#ifdef HAVE_EPOLL
+    if (USE_EPOLL (set)) {
+      epoll_set_index (set, nfd.fd, fd->idx);
+      epoll_update (set, EPOLL_CTL_ADD, &nfd);
+    }
+#endif
 #else
     WinsockFd wfd;
     HANDLE event;
@@ -938,6 +1250,17 @@ gst_poll_remove_fd (GstPoll * set, GstPollFD * fd)
 #ifdef G_OS_WIN32
     gst_poll_free_winsock_event (set, idx);
     g_array_remove_index_fast (set->events, idx);
+#elif defined(HAVE_EPOLL)
+    if (USE_EPOLL (set)) {
+      struct pollfd *pfd = &g_array_index (set->fds, struct pollfd, idx);
+      struct pollfd *last =
+          &g_array_index (set->fds, struct pollfd, set->fds->len - 1);
+
+      epoll_update (set, EPOLL_CTL_DEL, pfd);
+      /* the last fd is moved to idx below */
+      epoll_set_index (set, last->fd, idx);
+      epoll_set_index (set, pfd->fd, -1);
+    }
 #endif
 
     /* remove the fd at index, we use _remove_index_fast, which copies the last
@@ -992,6 +1315,11 @@ gst_poll_fd_ctl_write (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events &= ~POLLOUT;
 
     GST_LOG ("%p: pfd->events now %d (POLLOUT:%d)", set, pfd->events, POLLOUT);
+#ifdef HAVE_EPOLL
+    /* this also rearms the edge-triggered write readiness */
+    if (USE_EPOLL (set))
+      epoll_update (set, EPOLL_CTL_MOD, pfd);
+#endif
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_WRITE | FD_CONNECT,
         active);
@@ -1024,6 +1352,10 @@ gst_poll_fd_ctl_read_unlocked (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events |= POLLIN;
     else
       pfd->events &= ~POLLIN;
+#ifdef HAVE_EPOLL
+    if (USE_EPOLL (set))
+      epoll_update (set, EPOLL_CTL_MOD, pfd);
+#endif
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_READ | FD_ACCEPT, active);
 #endif
@@ -1106,6 +1438,10 @@ gst_poll_fd_ctl_pri (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events &= ~POLLPRI;
 
     GST_LOG ("%p: pfd->events now %d (POLLPRI:%d)", set, pfd->events, POLLOUT);
+#ifdef HAVE_EPOLL
+    if (USE_EPOLL (set))
+      epoll_update (set, EPOLL_CTL_MOD, pfd);
+#endif
     MARK_REBUILD (set);
   } else {
     GST_WARNING ("%p: couldn't find fd !", set);
@@ -1129,7 +1465,8 @@ gst_poll_fd_ctl_pri (GstPoll * set, GstPollFD * fd, gboolean active)
  *
  * The reason why this is needed is because the underlying implementation
  * might not allow querying the fd more than once between calls to one of
- * the re-enabling operations.
+ * the re-enabling operations. This is the case on Windows and for the
+ * edge-triggered write readiness of sets that use epoll.
  */
 void
 gst_poll_fd_ignored (GstPoll * set, GstPollFD * fd)
@@ -1151,6 +1488,21 @@ gst_poll_fd_ignored (GstPoll * set, GstPollFD * fd)
     MARK_REBUILD (set);
   }
 
+  g_mutex_unlock (&set->lock);
+#elif defined(HAVE_EPOLL)
+  gint idx;
+
+  g_return_if_fail (set != NULL);
+  g_return_if_fail (fd != NULL);
+  g_return_if_fail (fd->fd >= 0);
+
+  g_mutex_lock (&set->lock);
+
+  /* rearm the fd so that its current state is reported again */
+  if (USE_EPOLL (set) && (idx = find_index (set->fds, fd)) >= 0)
+    epoll_update (set, EPOLL_CTL_MOD,
+        &g_array_index (set->fds, struct pollfd, idx));
+
   g_mutex_unlock (&set->lock);
 #endif
 }
@@ -1176,14 +1528,15 @@ gst_poll_fd_has_closed (const GstPoll * set, GstPollFD * fd)
 
   g_mutex_lock (&((GstPoll *) set)->lock);
 
-  idx = find_index (set->active_fds, fd);
+  idx = find_index (RESULT_FDS (set), fd);
   if (idx >= 0) {
 #ifndef G_OS_WIN32
-    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, idx);
+    struct pollfd *pfd =
+        &g_array_index (RESULT_FDS (set), struct pollfd, idx);
 
     res = (pfd->revents & POLLHUP) != 0;
 #else
-    WinsockFd *wfd = &g_array_index (set->active_fds, WinsockFd, idx);
+    WinsockFd *wfd = &g_array_index (RESULT_FDS (set), WinsockFd, idx);
 
     res = (wfd->events.lNetworkEvents & FD_CLOSE) != 0;
 #endif
@@ -1218,14 +1571,15 @@ gst_poll_fd_has_error (const GstPoll * set, GstPollFD * fd)
 
   g_mutex_lock (&((GstPoll *) set)->lock);
 
-  idx = find_index (set->active_fds, fd);
+  idx = find_index (RESULT_FDS (set), fd);
   if (idx >= 0) {
 #ifndef G_OS_WIN32
-    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, idx);
+    struct pollfd *pfd =
+        &g_array_index (RESULT_FDS (set), struct pollfd, idx);
 
     res = (pfd->revents & (POLLERR | POLLNVAL)) != 0;
 #else
-    WinsockFd *wfd = &g_array_index (set->active_fds, WinsockFd, idx);
+    WinsockFd *wfd = &g_array_index (RESULT_FDS (set), WinsockFd, idx);
 
     res = (wfd->events.iErrorCode[FD_CLOSE_BIT] != 0) ||
         (wfd->events.iErrorCode[FD_READ_BIT] != 0) ||
@@ -1249,14 +1603,15 @@ gst_poll_fd_can_read_unlocked (const GstPoll * set, GstPollFD * fd)
   gboolean res = FALSE;
   gint idx;
 
-  idx = find_index (set->active_fds, fd);
+  idx = find_index (RESULT_FDS (set), fd);
   if (idx >= 0) {
 #ifndef G_OS_WIN32
-    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, idx);
+    struct pollfd *pfd =
+        &g_array_index (RESULT_FDS (set), struct pollfd, idx);
 
     res = (pfd->revents & POLLIN) != 0;
 #else
-    WinsockFd *wfd = &g_array_index (set->active_fds, WinsockFd, idx);
+    WinsockFd *wfd = &g_array_index (RESULT_FDS (set), WinsockFd, idx);
 
     res = (wfd->events.lNetworkEvents & (FD_READ | FD_ACCEPT)) != 0;
 #endif
@@ -1316,14 +1671,15 @@ gst_poll_fd_can_write (const GstPoll * set, GstPollFD * fd)
 
   g_mutex_lock (&((GstPoll *) set)->lock);
 
-  idx = find_index (set->active_fds, fd);
+  idx = find_index (RESULT_FDS (set), fd);
   if (idx >= 0) {
 #ifndef G_OS_WIN32
-    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, idx);
+    struct pollfd *pfd =
+        &g_array_index (RESULT_FDS (set), struct pollfd, idx);
 
     res = (pfd->revents & POLLOUT) != 0;
 #else
-    WinsockFd *wfd = &g_array_index (set->active_fds, WinsockFd, idx);
+    WinsockFd *wfd = &g_array_index (RESULT_FDS (set), WinsockFd, idx);
 
     res = (wfd->events.lNetworkEvents & FD_WRITE) != 0;
 #endif
@@ -1365,9 +1721,10 @@ gst_poll_fd_has_pri (const GstPoll * set, GstPollFD * fd)
 
   g_mutex_lock (&((GstPoll *) set)->lock);
 
-  idx = find_index (set->active_fds, fd);
+  idx = find_index (RESULT_FDS (set), fd);
   if (idx >= 0) {
-    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, idx);
+    struct pollfd *pfd =
+        &g_array_index (RESULT_FDS (set), struct pollfd, idx);
 
     res = (pfd->revents & POLLPRI) != 0;
   } else {
@@ -1397,6 +1754,11 @@ gst_poll_fd_has_pri (const GstPoll * set, GstPollFD * fd)
  * gst_poll_new_timer(), where it is allowed to have multiple threads waiting
  * simultaneously.
  *
+ * When @set uses epoll, write readiness is edge-triggered: after a wait
+ * reported that a file descriptor can be written to, it is only reported
+ * again once a write failed with EAGAIN or after gst_poll_fd_ctl_write() or
+ * gst_poll_fd_ignored() was called for it.
+ *
  * Returns: The number of #GstPollFD in @set that have activity or 0 when no
  * activity was detected after @timeout. If an error occurs, -1 is returned
  * and errno is set.
@@ -1434,7 +1796,8 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
 
     mode = choose_mode (set, timeout);
 
-    if (TEST_REBUILD (set)) {
+    /* epoll keeps track of the fds itself */
+    if (mode != GST_POLL_MODE_EPOLL && TEST_REBUILD (set)) {
       g_mutex_lock (&set->lock);
 #ifndef G_OS_WIN32
       g_array_set_size (set->active_fds, set->fds->len);
@@ -1451,6 +1814,16 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
       case GST_POLL_MODE_AUTO:
         g_assert_not_reached ();
         break;
+      case GST_POLL_MODE_EPOLL:
+      {
+#ifdef HAVE_EPOLL
+        res = epoll_wait_fds (set, timeout);
+#else
+        g_assert_not_reached ();
+        errno = ENOSYS;
+#endif
+        break;
+      }
       case GST_POLL_MODE_PPOLL:
       {
 #ifdef HAVE_PPOLL
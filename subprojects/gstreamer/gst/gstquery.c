@@ -68,6 +68,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_query_debug);
 
 GType _gst_query_type = 0;
 
+static GstSlabCache *query_cache = NULL;
+
 typedef struct
 {
   GstQuery query;
@@ -119,6 +121,8 @@ _priv_gst_query_initialize (void)
 
   _gst_query_type = gst_query_get_type ();
 
+  query_cache = _priv_gst_slab_cache_new ("query", sizeof (GstQueryImpl));
+
   GST_DEBUG_CATEGORY_INIT (gst_query_debug, "query", 0, "query system");
 
   for (i = 0; query_quarks[i].name; i++) {
@@ -200,7 +204,7 @@ _gst_query_free (GstQuery * query)
   memset (query, 0xff, sizeof (GstQueryImpl));
 #endif
 
-  g_free (query);
+  _priv_gst_slab_free (query_cache, query);
 }
 
 static GstQuery *
@@ -674,7 +678,7 @@ gst_query_new_custom (GstQueryType type, GstStructure * structure)
 {
   GstQueryImpl *query;
 
-  query = g_new0 (GstQueryImpl, 1);
+  query = _priv_gst_slab_alloc0 (query_cache);
 
   GST_DEBUG ("creating new query %p %s", query, gst_query_type_get_name (type));
 
@@ -697,7 +701,7 @@ gst_query_new_custom (GstQueryType type, GstStructure * structure)
   /* ERRORS */
 had_parent:
   {
-    g_free (query);
+    _priv_gst_slab_free (query_cache, query);
     g_warning ("structure is already owned by another object");
     return NULL;
   }
@@ -574,6 +574,7 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
     const char *location)
 {
   GMappedFile *mapped = NULL;
+  GBytes *cache = NULL;
   gchar *contents = NULL;
   gchar *in = NULL;
   gsize size;
@@ -615,10 +616,12 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
       g_error_free (err);
       return FALSE;
     }
+    cache = g_bytes_new_take (contents, size);
   } else {
     /* This can't fail if g_mapped_file_new() succeeded */
     contents = g_mapped_file_get_contents (mapped);
     size = g_mapped_file_get_length (mapped);
+    cache = g_mapped_file_get_bytes (mapped);
   }
 
   /* in is a cursor pointer, we initialize it with the begin of registry and is updated on each read */
@@ -666,7 +669,8 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
       GST_DEBUG ("reading binary registry %" G_GSIZE_FORMAT "(%x)/%"
           G_GSIZE_FORMAT, (gsize) in - (gsize) contents,
           (guint) ((gsize) in - (gsize) contents), size);
-      if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end, NULL)) {
+      if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end, NULL,
+              cache)) {
         GST_ERROR ("Problem while reading binary registry %s", location);
         goto Error;
       }
@@ -683,16 +687,15 @@ done:
   GST_INFO ("loaded %s in %lf seconds", location, seconds);
 
   res = TRUE;
-  /* TODO: once we re-use the pointers to registry contents, return here */
 
 Error:
 #ifndef GST_DISABLE_GST_DEBUG
   g_timer_destroy (timer);
 #endif
-  if (mapped) {
+  /* element factories read from the cache keep their own reference to the
+   * contents, their pad templates point into it */
+  g_bytes_unref (cache);
+  if (mapped)
     g_mapped_file_unref (mapped);
-  } else {
-    g_free (contents);
-  }
   return res;
 }
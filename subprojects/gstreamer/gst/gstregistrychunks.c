@@ -108,6 +108,13 @@ _strnlen (const gchar * str, gint maxlen)
   inptr += _len + 1; \
 }G_STMT_END
 
+#define skip_string(inptr, endptr, error_label)  G_STMT_START{\
+  gint _len = _strnlen (inptr, (endptr-inptr)); \
+  if (_len == -1) \
+    goto error_label; \
+  inptr += _len + 1; \
+}G_STMT_END
+
 #define ALIGNMENT            (sizeof (void *))
 #define alignment(_address)  (gsize)_address%ALIGNMENT
 #define align(_ptr)          _ptr += (( alignment(_ptr) == 0) ? 0 : ALIGNMENT-alignment(_ptr))
@@ -254,6 +261,9 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
     ef->npadtemplates = ef->ninterfaces = ef->nuriprotocols = 0;
     pf = (GstRegistryChunkPluginFeature *) ef;
 
+    /* details of factories read from the cache are materialized on demand */
+    __gst_element_factory_ensure_details (factory);
+
     /* save interfaces */
     for (walk = factory->interfaces; walk;
         walk = g_list_next (walk), ef->ninterfaces++) {
@@ -508,13 +518,14 @@ fail:
  * gst_registry_chunks_load_pad_template:
  *
  * Make a new GstStaticPadTemplate from current GstRegistryChunkPadTemplate
- * structure.
+ * structure. With @from_cache the strings are referenced from the registry
+ * cache the factory keeps alive instead of being interned.
  *
  * Returns: new GstStaticPadTemplate
  */
 static gboolean
 gst_registry_chunks_load_pad_template (GstElementFactory * factory, gchar ** in,
-    gchar * end)
+    gchar * end, gboolean from_cache)
 {
   GstRegistryChunkPadTemplate *pt;
   GstStaticPadTemplate *template = NULL;
@@ -530,10 +541,19 @@ gst_registry_chunks_load_pad_template (GstElementFactory * factory, gchar ** in,
   template->static_caps.caps = NULL;
 
   /* unpack pad template strings */
-  unpack_const_string (*in, template->name_template, end, fail);
-  unpack_const_string (*in, template->static_caps.string, end, fail);
+  if (from_cache) {
+    unpack_string_nocopy (*in, template->name_template, end, fail);
+    unpack_string_nocopy (*in, template->static_caps.string, end, fail);
+
+    /* numpadtemplates was already set when the factory was loaded */
+    factory->staticpadtemplates =
+        g_list_append (factory->staticpadtemplates, template);
+  } else {
+    unpack_const_string (*in, template->name_template, end, fail);
+    unpack_const_string (*in, template->static_caps.string, end, fail);
 
-  __gst_element_factory_add_static_pad_template (factory, template);
+    __gst_element_factory_add_static_pad_template (factory, template);
+  }
   GST_DEBUG ("Added pad_template %s", template->name_template);
 
   return TRUE;
@@ -544,6 +564,97 @@ fail:
   return FALSE;
 }
 
+/*
+ * gst_registry_chunks_skip_pad_template:
+ *
+ * Move @in past the current GstRegistryChunkPadTemplate structure without
+ * creating anything from it.
+ */
+static gboolean
+gst_registry_chunks_skip_pad_template (gchar ** in, gchar * end)
+{
+  align (*in);
+  if (*in + sizeof (GstRegistryChunkPadTemplate) > end)
+    goto fail;
+  *in += sizeof (GstRegistryChunkPadTemplate);
+
+  skip_string (*in, end, fail);
+  skip_string (*in, end, fail);
+
+  return TRUE;
+fail:
+  GST_INFO ("Skipping pad template failed");
+  return FALSE;
+}
+
+/*
+ * gst_registry_chunks_load_element_factory_metadata:
+ *
+ * Deserialize the metadata structure of an element factory.
+ */
+static gboolean
+gst_registry_chunks_load_element_factory_metadata (GstElementFactory * factory,
+    const gchar * meta_data_str)
+{
+  if (meta_data_str && *meta_data_str) {
+    factory->metadata = gst_structure_from_string (meta_data_str, NULL);
+    if (!factory->metadata) {
+      GST_ERROR
+          ("Error when trying to deserialize structure for metadata '%s'",
+          meta_data_str);
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/*
+ * _priv_gst_registry_chunks_load_element_factory_details:
+ *
+ * Materialize the metadata and pad templates of an element factory that was
+ * loaded from a registry cache. Must be called with the object lock of
+ * @factory held and only while factory->cache_details is set.
+ *
+ * Returns: %TRUE for success
+ */
+gboolean
+_priv_gst_registry_chunks_load_element_factory_details (GstElementFactory *
+    factory)
+{
+  const gchar *meta_data_str;
+  gchar *in, *end;
+  gsize size;
+  guint i;
+
+  g_return_val_if_fail (factory->cache != NULL, FALSE);
+  g_return_val_if_fail (factory->cache_details != NULL, FALSE);
+
+  in = (gchar *) factory->cache_details;
+  end = (gchar *) g_bytes_get_data (factory->cache, &size) + size;
+
+  GST_LOG_OBJECT (factory, "Materializing details from cache at %p", in);
+
+  unpack_string_nocopy (in, meta_data_str, end, fail);
+  if (!gst_registry_chunks_load_element_factory_metadata (factory,
+          meta_data_str))
+    goto fail;
+
+  for (i = 0; i < factory->numpadtemplates; i++) {
+    if (G_UNLIKELY (!gst_registry_chunks_load_pad_template (factory, &in,
+                end, TRUE))) {
+      GST_ERROR ("Error while loading binary pad template");
+      goto fail;
+    }
+  }
+
+  return TRUE;
+
+  /* Errors */
+fail:
+  GST_WARNING_OBJECT (factory, "Reading element factory details failed");
+  return FALSE;
+}
+
 /*
  * gst_registry_chunks_load_feature:
  *
@@ -553,7 +664,7 @@ fail:
  */
 static gboolean
 gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
-    gchar * end, GstPlugin * plugin)
+    gchar * end, GstPlugin * plugin, GBytes * cache)
 {
   GstRegistryChunkPluginFeature *pf = NULL;
   GstPluginFeature *feature = NULL;
@@ -609,26 +720,37 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
     unpack_element (*in, ef, GstRegistryChunkElementFactory, end, fail);
     pf = (GstRegistryChunkPluginFeature *) ef;
 
-    /* unpack element factory strings */
-    unpack_string_nocopy (*in, meta_data_str, end, fail);
-    if (meta_data_str && *meta_data_str) {
-      factory->metadata = gst_structure_from_string (meta_data_str, NULL);
-      if (!factory->metadata) {
-        GST_ERROR
-            ("Error when trying to deserialize structure for metadata '%s'",
-            meta_data_str);
-        goto fail;
-      }
-    }
     n = ef->npadtemplates;
     GST_DEBUG ("Element factory : npadtemplates=%d", n);
 
-    /* load pad templates */
-    for (i = 0; i < n; i++) {
-      if (G_UNLIKELY (!gst_registry_chunks_load_pad_template (factory, in,
-                  end))) {
-        GST_ERROR ("Error while loading binary pad template");
+    if (cache) {
+      /* only remember where metadata and pad templates are, they are
+       * materialized on the first lookup that needs them */
+      factory->cache = g_bytes_ref (cache);
+      factory->cache_details = *in;
+      factory->numpadtemplates = n;
+
+      skip_string (*in, end, fail);
+      for (i = 0; i < n; i++) {
+        if (G_UNLIKELY (!gst_registry_chunks_skip_pad_template (in, end))) {
+          GST_ERROR ("Error while skipping binary pad template");
+          goto fail;
+        }
+      }
+    } else {
+      /* unpack element factory strings */
+      unpack_string_nocopy (*in, meta_data_str, end, fail);
+      if (!gst_registry_chunks_load_element_factory_metadata (factory,
+              meta_data_str))
         goto fail;
+
+      /* load pad templates */
+      for (i = 0; i < n; i++) {
+        if (G_UNLIKELY (!gst_registry_chunks_load_pad_template (factory, in,
+                    end, FALSE))) {
+          GST_ERROR ("Error while loading binary pad template");
+          goto fail;
+        }
       }
     }
 
@@ -817,10 +939,14 @@ fail:
  * Make a new GstPlugin from current GstRegistryChunkPluginElement structure
  * and add it to the GstRegistry. Return an offset to the next
  * GstRegistryChunkPluginElement structure.
+ *
+ * If @cache is not %NULL, @in points into it and element factories keep a
+ * reference to it so that their metadata and pad templates can be
+ * materialized lazily.
  */
 gboolean
 _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
-    gchar * end, GstPlugin ** out_plugin)
+    gchar * end, GstPlugin ** out_plugin, GBytes * cache)
 {
 #ifndef GST_DISABLE_GST_DEBUG
   gchar *start = *in;
@@ -887,7 +1013,7 @@ _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
   /* Load plugin features */
   for (i = 0; i < n; i++) {
     if (G_UNLIKELY (!gst_registry_chunks_load_feature (registry, in, end,
-                plugin))) {
+                plugin, cache))) {
       GST_ERROR ("Error while loading binary feature for plugin '%s'",
           GST_STR_NULL (plugin->desc.name));
       gst_registry_remove_plugin (registry, plugin);
@@ -25,6 +25,7 @@
 
 #include <gst/gstpad.h>
 #include <gst/gstregistry.h>
+#include <gst/gstelementfactory.h>
 
 /*
  * we reference strings directly from the plugins and in this case set CONST to
@@ -171,7 +172,10 @@ _priv_gst_registry_chunks_save_plugin (GList ** list, GstRegistry * registry,
 
 gboolean
 _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
-    gchar *end, GstPlugin **out_plugin);
+    gchar *end, GstPlugin **out_plugin, GBytes * cache);
+
+gboolean
+_priv_gst_registry_chunks_load_element_factory_details (GstElementFactory * factory);
 
 void
 _priv_gst_registry_chunks_save_global_header (GList ** list,
@@ -0,0 +1,363 @@
+/* GStreamer
+ *
+ * gstslab.c: per-thread free lists for fixed-size structs
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The structs of buffers, events and queries are allocated and freed at a
+ * very high rate. Instead of going to malloc every time, freed structs are
+ * kept on a free list of the freeing thread and handed out again by the next
+ * allocation in that thread, without any locking.
+ *
+ * When the free list of a thread grows too long, a batch of structs is moved
+ * to the shared depot of the cache. A thread with an empty free list takes a
+ * batch from the depot before falling back to malloc. The depot is bounded so
+ * that memory is given back to the system after a burst of allocations.
+ *
+ * The structs are plain g_malloc() blocks, so everything that was allocated
+ * here can also be freed with g_free() and the other way around.
+ *
+ * Setting GST_SLAB=no or G_SLICE=always-malloc in the environment disables the
+ * free lists, which is useful when debugging with valgrind.
+ */
+
+#include "gst_private.h"
+
+#include <string.h>
+
+#include "gsttracerutils.h"
+
+/* maximum number of caches, one per struct type */
+#define SLAB_MAX_CACHES 8
+/* number of structs moved between a thread and the depot at once */
+#define SLAB_BATCH 64
+/* maximum number of free structs per thread and cache */
+#define SLAB_MAX_LOCAL (2 * SLAB_BATCH)
+/* maximum number of batches in the depot of a cache */
+#define SLAB_MAX_DEPOT 32
+/* allocations after which a thread reports its counters */
+#define SLAB_STATS_INTERVAL 4096
+
+typedef struct _GstSlabFree GstSlabFree;
+
+/* a free struct, the first one of a batch also links the batches */
+struct _GstSlabFree
+{
+  GstSlabFree *next;
+  GstSlabFree *next_batch;
+};
+
+struct _GstSlabCache
+{
+  const gchar *name;
+  gsize size;
+  guint index;
+
+  GMutex lock;
+  GstSlabFree *depot;
+  guint n_depot;
+};
+
+typedef struct
+{
+  GstSlabFree *free;
+  guint n_free;
+
+  /* counters since the last report */
+  guint allocs;
+  guint hits;
+  guint frees;
+  guint released;
+} GstSlabLocal;
+
+typedef struct
+{
+  GstSlabLocal local[SLAB_MAX_CACHES];
+} GstSlabThread;
+
+static void slab_thread_free (gpointer data);
+
+static GPrivate slab_thread = G_PRIVATE_INIT (slab_thread_free);
+static GstSlabCache *caches[SLAB_MAX_CACHES];
+static guint n_caches = 0;
+static gboolean slab_enabled = FALSE;
+
+static void
+slab_report (GstSlabCache * cache, GstSlabLocal * local)
+{
+  GST_TRACER_SLAB_STATS (cache->name, local->allocs, local->hits,
+      local->frees, local->released);
+
+  local->allocs = local->hits = local->frees = local->released = 0;
+}
+
+/* hand the list of structs starting at @batch to the depot, or back to the
+ * system when the depot is full. Returns the number of structs given back to
+ * the system. */
+static guint
+slab_release_batch (GstSlabCache * cache, GstSlabFree * batch)
+{
+  guint released = 0;
+
+  g_mutex_lock (&cache->lock);
+  if (slab_enabled && cache->n_depot < SLAB_MAX_DEPOT) {
+    batch->next_batch = cache->depot;
+    cache->depot = batch;
+    cache->n_depot++;
+    batch = NULL;
+  }
+  g_mutex_unlock (&cache->lock);
+
+  while (batch) {
+    GstSlabFree *next = batch->next;
+
+    g_free (batch);
+    batch = next;
+    released++;
+  }
+  return released;
+}
+
+static void
+slab_local_flush (GstSlabCache * cache, GstSlabLocal * local)
+{
+  if (local->free) {
+    local->released += slab_release_batch (cache, local->free);
+    local->free = NULL;
+    local->n_free = 0;
+  }
+  if (local->allocs || local->frees)
+    slab_report (cache, local);
+}
+
+static void
+slab_thread_free (gpointer data)
+{
+  GstSlabThread *thread = data;
+  guint i;
+
+  for (i = 0; i < n_caches; i++)
+    slab_local_flush (caches[i], &thread->local[i]);
+
+  g_free (thread);
+}
+
+static inline GstSlabLocal *
+slab_get_local (GstSlabCache * cache)
+{
+  GstSlabThread *thread;
+
+  thread = g_private_get (&slab_thread);
+  if (G_UNLIKELY (thread == NULL)) {
+    thread = g_new0 (GstSlabThread, 1);
+    g_private_set (&slab_thread, thread);
+  }
+  return &thread->local[cache->index];
+}
+
+/*
+ * _priv_gst_slab_cache_new:
+ * @name: the name of the cache, used for statistics
+ * @size: the size of the structs in the cache
+ *
+ * Creates a new cache for structs of @size bytes. Caches are never freed.
+ *
+ * Returns: a new #GstSlabCache
+ */
+GstSlabCache *
+_priv_gst_slab_cache_new (const gchar * name, gsize size)
+{
+  GstSlabCache *cache;
+
+  g_return_val_if_fail (n_caches < SLAB_MAX_CACHES, NULL);
+  g_return_val_if_fail (size >= sizeof (GstSlabFree), NULL);
+
+  cache = g_new0 (GstSlabCache, 1);
+  cache->name = name;
+  cache->size = size;
+  cache->index = n_caches;
+  g_mutex_init (&cache->lock);
+
+  caches[n_caches++] = cache;
+
+  return cache;
+}
+
+/*
+ * _priv_gst_slab_alloc:
+ * @cache: a #GstSlabCache
+ *
+ * Allocates a struct from @cache. The memory is not initialized.
+ *
+ * Returns: the new struct, free with _priv_gst_slab_free() or g_free().
+ */
+gpointer
+_priv_gst_slab_alloc (GstSlabCache * cache)
+{
+  GstSlabLocal *local;
+  GstSlabFree *mem;
+
+  if (G_UNLIKELY (!slab_enabled))
+    return g_malloc (cache->size);
+
+  local = slab_get_local (cache);
+
+  if (G_UNLIKELY (local->free == NULL)) {
+    /* take a batch from the depot */
+    g_mutex_lock (&cache->lock);
+    if ((mem = cache->depot)) {
+      cache->depot = mem->next_batch;
+      cache->n_depot--;
+    }
+    g_mutex_unlock (&cache->lock);
+
+    local->free = mem;
+    for (local->n_free = 0; mem; mem = mem->next)
+      local->n_free++;
+  }
+
+  if (G_LIKELY ((mem = local->free))) {
+    local->free = mem->next;
+    local->n_free--;
+    local->hits++;
+  } else {
+    mem = g_malloc (cache->size);
+  }
+
+  if (G_UNLIKELY (++local->allocs == SLAB_STATS_INTERVAL))
+    slab_report (cache, local);
+
+  return mem;
+}
+
+/*
+ * _priv_gst_slab_alloc0:
+ * @cache: a #GstSlabCache
+ *
+ * Allocates a struct from @cache and sets it to 0.
+ *
+ * Returns: the new struct, free with _priv_gst_slab_free() or g_free().
+ */
+gpointer
+_priv_gst_slab_alloc0 (GstSlabCache * cache)
+{
+  gpointer mem = _priv_gst_slab_alloc (cache);
+
+  memset (mem, 0, cache->size);
+
+  return mem;
+}
+
+/*
+ * _priv_gst_slab_free:
+ * @cache: a #GstSlabCache
+ * @mem: a struct allocated from @cache
+ *
+ * Returns @mem to @cache.
+ */
+void
+_priv_gst_slab_free (GstSlabCache * cache, gpointer mem)
+{
+  GstSlabLocal *local;
+  GstSlabFree *item = mem;
+
+  if (G_UNLIKELY (!slab_enabled)) {
+    g_free (mem);
+    return;
+  }
+
+  local = slab_get_local (cache);
+
+  if (G_UNLIKELY (local->n_free == SLAB_MAX_LOCAL)) {
+    GstSlabFree *batch = local->free, *last = batch;
+    guint i;
+
+    /* move the first SLAB_BATCH structs to the depot */
+    for (i = 1; i < SLAB_BATCH; i++)
+      last = last->next;
+    local->free = last->next;
+    local->n_free -= SLAB_BATCH;
+    last->next = NULL;
+
+    local->released += slab_release_batch (cache, batch);
+  }
+
+  item->next = local->free;
+  local->free = item;
+  local->n_free++;
+
+  if (G_UNLIKELY (++local->frees == SLAB_STATS_INTERVAL))
+    slab_report (cache, local);
+}
+
+void
+_priv_gst_slab_initialize (void)
+{
+  const gchar *env;
+
+  slab_enabled = TRUE;
+
+  if ((env = g_getenv ("GST_SLAB")) && strcmp (env, "no") == 0)
+    slab_enabled = FALSE;
+  if ((env = g_getenv ("G_SLICE")) && strstr (env, "always-malloc"))
+    slab_enabled = FALSE;
+
+  GST_CAT_INFO (GST_CAT_GST_INIT, "slab allocator %s",
+      slab_enabled ? "enabled" : "disabled");
+}
+
+/* called from gst_deinit(), frees the structs of the depots and of the calling
+ * thread. Structs freed afterwards go back to the system directly. */
+void
+_priv_gst_slab_cleanup (void)
+{
+  GstSlabThread *thread;
+  guint i;
+
+  if (!slab_enabled)
+    return;
+
+  /* report the counters of this thread while the tracers are still alive */
+  thread = g_private_get (&slab_thread);
+  for (i = 0; thread && i < n_caches; i++)
+    slab_local_flush (caches[i], &thread->local[i]);
+
+  slab_enabled = FALSE;
+
+  for (i = 0; i < n_caches; i++) {
+    GstSlabCache *cache = caches[i];
+    GstSlabFree *batch;
+
+    g_mutex_lock (&cache->lock);
+    batch = cache->depot;
+    cache->depot = NULL;
+    cache->n_depot = 0;
+    g_mutex_unlock (&cache->lock);
+
+    while (batch) {
+      GstSlabFree *next_batch = batch->next_batch;
+
+      while (batch) {
+        GstSlabFree *next = batch->next;
+
+        g_free (batch);
+        batch = next;
+      }
+      batch = next_batch;
+    }
+  }
+}
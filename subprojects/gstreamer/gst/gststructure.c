@@ -167,6 +167,11 @@ typedef struct
   guint fields_len;             /* Number of valid items in fields */
   guint fields_alloc;           /* Allocated items in fields */
 
+  /* Field name to position + 1, only for structures with more than
+   * STRUCTURE_INDEX_THRESHOLD fields. Only modified together with the fields
+   * so that lookups on immutable structures stay read-only */
+  GHashTable *index;
+
   /* Fields are allocated if GST_STRUCTURE_IS_USING_DYNAMIC_ARRAY(),
    *  else it's a pointer to the arr field. */
   GstStructureField *fields;
@@ -190,6 +195,24 @@ typedef struct
 #define IS_TAGLIST(structure) \
     (structure->name == GST_QUARK (TAGLIST))
 
+/* Above this many fields lookups by name use a hash table instead of a linear
+ * scan, e.g. for big statistics structures and taglists */
+#define STRUCTURE_INDEX_THRESHOLD 16
+
+static void
+_structure_index_build (GstStructureImpl * impl)
+{
+  guint i;
+
+  GST_CAT_LOG (GST_CAT_PERFORMANCE, "indexing structure with %u fields",
+      impl->fields_len);
+
+  impl->index = g_hash_table_new (NULL, NULL);
+  for (i = 0; i < impl->fields_len; i++)
+    g_hash_table_insert (impl->index, GUINT_TO_POINTER (impl->fields[i].name),
+        GUINT_TO_POINTER (i + 1));
+}
+
 /* Replacement for g_array_append_val */
 static void
 _structure_append_val (GstStructure * s, GstStructureField * val)
@@ -218,6 +241,12 @@ _structure_append_val (GstStructure * s, GstStructureField * val)
 
   /* Finally set value */
   impl->fields[impl->fields_len++] = *val;
+
+  if (impl->index)
+    g_hash_table_insert (impl->index, GUINT_TO_POINTER (val->name),
+        GUINT_TO_POINTER (impl->fields_len));
+  else if (G_UNLIKELY (impl->fields_len > STRUCTURE_INDEX_THRESHOLD))
+    _structure_index_build (impl);
 }
 
 /* Replacement for g_array_remove_index */
@@ -230,12 +259,25 @@ _structure_remove_index (GstStructure * s, guint idx)
   if (idx >= impl->fields_len)
     return;
 
+  if (impl->index)
+    g_hash_table_remove (impl->index,
+        GUINT_TO_POINTER (impl->fields[idx].name));
+
   /* Shift everything if it's not the last item */
   if (idx != impl->fields_len)
     memmove (&impl->fields[idx],
         &impl->fields[idx + 1],
         (impl->fields_len - idx - 1) * sizeof (GstStructureField));
   impl->fields_len--;
+
+  /* and update the positions of the shifted fields */
+  if (impl->index) {
+    guint i;
+
+    for (i = idx; i < impl->fields_len; i++)
+      g_hash_table_insert (impl->index,
+          GUINT_TO_POINTER (impl->fields[i].name), GUINT_TO_POINTER (i + 1));
+  }
 }
 
 static void gst_structure_set_field (GstStructure * structure,
@@ -540,6 +582,8 @@ gst_structure_free (GstStructure * structure)
   }
   if (GST_STRUCTURE_IS_USING_DYNAMIC_ARRAY (structure))
     g_free (((GstStructureImpl *) structure)->fields);
+  if (((GstStructureImpl *) structure)->index)
+    g_hash_table_unref (((GstStructureImpl *) structure)->index);
 
 #ifdef USE_POISONING
   memset (structure, 0xff, sizeof (GstStructure));
@@ -1010,9 +1054,6 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
 {
   GstStructureField *f;
   GType field_value_type;
-  guint i, len;
-
-  len = GST_STRUCTURE_LEN (structure);
 
   field_value_type = G_VALUE_TYPE (&field->value);
   if (field_value_type == G_TYPE_STRING) {
@@ -1063,14 +1104,11 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
     }
   }
 
-  for (i = 0; i < len; i++) {
-    f = GST_STRUCTURE_FIELD (structure, i);
-
-    if (G_UNLIKELY (f->name == field->name)) {
-      g_value_unset (&f->value);
-      memcpy (f, field, sizeof (GstStructureField));
-      return;
-    }
+  f = gst_structure_id_get_field (structure, field->name);
+  if (G_UNLIKELY (f != NULL)) {
+    g_value_unset (&f->value);
+    memcpy (f, field, sizeof (GstStructureField));
+    return;
   }
 
   _structure_append_val (structure, field);
@@ -1081,9 +1119,17 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
 static GstStructureField *
 gst_structure_id_get_field (const GstStructure * structure, GQuark field_id)
 {
+  GstStructureImpl *impl = (GstStructureImpl *) structure;
   GstStructureField *field;
   guint i, len;
 
+  if (impl->index) {
+    i = GPOINTER_TO_UINT (g_hash_table_lookup (impl->index,
+            GUINT_TO_POINTER (field_id)));
+
+    return i ? GST_STRUCTURE_FIELD (structure, i - 1) : NULL;
+  }
+
   len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len; i++) {
@@ -1171,26 +1217,19 @@ void
 gst_structure_remove_field (GstStructure * structure, const gchar * fieldname)
 {
   GstStructureField *field;
-  GQuark id;
-  guint i, len;
 
   g_return_if_fail (structure != NULL);
   g_return_if_fail (fieldname != NULL);
   g_return_if_fail (IS_MUTABLE (structure));
 
-  id = g_quark_from_string (fieldname);
-  len = GST_STRUCTURE_LEN (structure);
-
-  for (i = 0; i < len; i++) {
-    field = GST_STRUCTURE_FIELD (structure, i);
-
-    if (field->name == id) {
-      if (G_IS_VALUE (&field->value)) {
-        g_value_unset (&field->value);
-      }
-      _structure_remove_index (structure, i);
-      return;
+  field = gst_structure_id_get_field (structure,
+      g_quark_from_string (fieldname));
+  if (field) {
+    if (G_IS_VALUE (&field->value)) {
+      g_value_unset (&field->value);
     }
+    _structure_remove_index (structure,
+        field - GST_STRUCTURE_FIELD (structure, 0));
   }
 }
 
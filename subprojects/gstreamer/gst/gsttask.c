@@ -65,14 +65,25 @@
  * name on Linux. Please note that the object name should be configured before the
  * task is started; changing the object name after the task has been started, has
  * no effect on the thread name.
+ *
+ * When the task uses a #GstCooperativeTaskPool, it does not own a thread.
+ * Every call of the #GstTaskFunction is scheduled separately on one of the
+ * workers of the pool. Instead of blocking, the task function can call
+ * gst_task_wait_for_wakeup(), gst_task_wait_for_fd() or
+ * gst_task_wait_for_clock_id() and return; it is then not called again until
+ * gst_task_wakeup() is called, the file descriptor is ready or the clock id
+ * fired. These functions also work on tasks with their own thread, where the
+ * thread waits between the calls.
  */
 
 #include "gst_private.h"
 
 #include "gstinfo.h"
+#include "gstpoll.h"
 #include "gsttask.h"
 #include "glib-compat-private.h"
 
+#include <errno.h>
 #include <stdio.h>
 
 #ifdef HAVE_SYS_PRCTL_H
@@ -121,8 +132,31 @@ struct _GstTaskPrivate
   /* remember the pool and id that is currently running. */
   gpointer id;
   GstTaskPool *pool_id;
+
+  /* running on a GstCooperativeTaskPool */
+  gboolean cooperative;
+  /* an iteration is queued or running */
+  gboolean scheduled;
+  /* the enter_func was called */
+  gboolean entered;
+
+  /* waiting for gst_task_wakeup() */
+  gboolean parked;
+  gboolean woken;
+  GstClockID clock_id;
+  /* protected by the reactor_lock */
+  struct _GstTaskFdWait *fd_wait;
 };
 
+/* a task waiting for a file descriptor, all of them are watched by a single
+ * reactor thread */
+typedef struct _GstTaskFdWait
+{
+  GstTask *task;
+  GstPollFD pfd;
+  GIOCondition condition;
+} GstTaskFdWait;
+
 #ifdef _MSC_VER
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -213,11 +247,17 @@ gst_task_win32_set_thread_name (const gchar * name)
 static void gst_task_finalize (GObject * object);
 
 static void gst_task_func (GstTask * task);
+static void gst_task_iterate (GstTask * task);
 
 static GMutex pool_lock;
 
 static GstTaskPool *_global_task_pool = NULL;
 
+static GMutex reactor_lock;
+static GstPoll *reactor_poll = NULL;
+static GThread *reactor_thread = NULL;
+static GList *reactor_waits = NULL;
+
 #define _do_init \
 { \
   GST_DEBUG_CATEGORY_INIT (task_debug, "task", 0, "Processing tasks"); \
@@ -340,6 +380,242 @@ gst_task_configure_name (GstTask * task)
 #endif
 }
 
+static void
+gst_task_fd_wait_free (GstTaskFdWait * wait)
+{
+  gst_object_unref (wait->task);
+  g_free (wait);
+}
+
+static gboolean
+gst_task_fd_wait_is_ready (GstTaskFdWait * wait)
+{
+  if ((wait->condition & G_IO_IN) &&
+      gst_poll_fd_can_read (reactor_poll, &wait->pfd))
+    return TRUE;
+  if ((wait->condition & G_IO_OUT) &&
+      gst_poll_fd_can_write (reactor_poll, &wait->pfd))
+    return TRUE;
+
+  return gst_poll_fd_has_error (reactor_poll, &wait->pfd) ||
+      gst_poll_fd_has_closed (reactor_poll, &wait->pfd);
+}
+
+static gpointer
+gst_task_reactor_func (gpointer data)
+{
+  while (TRUE) {
+    GList *walk, *ready = NULL;
+
+    if (gst_poll_wait (reactor_poll, GST_CLOCK_TIME_NONE) < 0) {
+      /* flushing when shutting down */
+      if (errno == EBUSY)
+        break;
+      continue;
+    }
+
+    g_mutex_lock (&reactor_lock);
+    walk = reactor_waits;
+    while (walk) {
+      GstTaskFdWait *wait = walk->data;
+      GList *next = walk->next;
+
+      if (gst_task_fd_wait_is_ready (wait)) {
+        gst_poll_remove_fd (reactor_poll, &wait->pfd);
+        reactor_waits = g_list_delete_link (reactor_waits, walk);
+        g_atomic_pointer_set (&wait->task->priv->fd_wait, NULL);
+        ready = g_list_prepend (ready, wait);
+      }
+      walk = next;
+    }
+    g_mutex_unlock (&reactor_lock);
+
+    for (walk = ready; walk; walk = walk->next) {
+      GstTaskFdWait *wait = walk->data;
+
+      gst_task_wakeup (wait->task);
+      gst_task_fd_wait_free (wait);
+    }
+    g_list_free (ready);
+  }
+
+  return NULL;
+}
+
+/* removes the fd and clock waits of @task */
+static void
+gst_task_clear_waits (GstTask * task)
+{
+  GstTaskPrivate *priv = task->priv;
+  GstTaskFdWait *wait = NULL;
+  GstClockID id;
+
+  GST_OBJECT_LOCK (task);
+  id = priv->clock_id;
+  priv->clock_id = NULL;
+  GST_OBJECT_UNLOCK (task);
+
+  if (id) {
+    gst_clock_id_unschedule (id);
+    gst_clock_id_unref (id);
+  }
+
+  if (g_atomic_pointer_get (&priv->fd_wait)) {
+    g_mutex_lock (&reactor_lock);
+    if ((wait = priv->fd_wait)) {
+      gst_poll_remove_fd (reactor_poll, &wait->pfd);
+      reactor_waits = g_list_remove (reactor_waits, wait);
+      g_atomic_pointer_set (&priv->fd_wait, NULL);
+    }
+    g_mutex_unlock (&reactor_lock);
+
+    if (wait) {
+      gst_poll_restart (reactor_poll);
+      gst_task_fd_wait_free (wait);
+    }
+  }
+}
+
+/* called from the task thread after the task function parked the task. Waits
+ * with the task lock released until the task is woken up or changes state. */
+static void
+gst_task_wait_parked (GstTask * task, GRecMutex * lock)
+{
+  GstTaskPrivate *priv = task->priv;
+
+  GST_OBJECT_LOCK (task);
+  if (!priv->woken && GET_TASK_STATE (task) == GST_TASK_STARTED) {
+    g_rec_mutex_unlock (lock);
+    GST_LOG_OBJECT (task, "Task waiting for wakeup");
+    while (!priv->woken && GET_TASK_STATE (task) == GST_TASK_STARTED)
+      GST_TASK_WAIT (task);
+    GST_OBJECT_UNLOCK (task);
+    g_rec_mutex_lock (lock);
+    GST_OBJECT_LOCK (task);
+  }
+  priv->parked = FALSE;
+  GST_OBJECT_UNLOCK (task);
+
+  gst_task_clear_waits (task);
+}
+
+/* queues the next iteration of a task on a cooperative pool. Must be called
+ * with the task LOCK. */
+static void
+gst_task_schedule_unlocked (GstTask * task)
+{
+  GstTaskPrivate *priv = task->priv;
+
+  if (priv->scheduled || !task->running)
+    return;
+
+  priv->scheduled = TRUE;
+  _priv_gst_cooperative_task_pool_schedule (priv->pool_id,
+      (GstTaskPoolFunction) gst_task_iterate, task);
+}
+
+/* runs one iteration of a task on a cooperative pool */
+static void
+gst_task_iterate (GstTask * task)
+{
+  GstTaskPrivate *priv = task->priv;
+  GThread *tself = g_thread_self ();
+  GRecMutex *lock;
+  gboolean enter, parked;
+
+  GST_OBJECT_LOCK (task);
+  if (GET_TASK_STATE (task) == GST_TASK_STOPPED)
+    goto stopped;
+  if (GET_TASK_STATE (task) == GST_TASK_PAUSED)
+    goto paused;
+  lock = GST_TASK_GET_LOCK (task);
+  if (G_UNLIKELY (lock == NULL))
+    goto no_lock;
+  task->thread = tself;
+  enter = !priv->entered;
+  priv->entered = TRUE;
+  GST_OBJECT_UNLOCK (task);
+
+  /* fire the enter_func callback before the first iteration */
+  if (enter && priv->enter_func)
+    priv->enter_func (task, tself, priv->enter_user_data);
+
+  g_rec_mutex_lock (lock);
+  if (G_LIKELY (GET_TASK_STATE (task) == GST_TASK_STARTED))
+    task->func (task->user_data);
+  g_rec_mutex_unlock (lock);
+
+  GST_OBJECT_LOCK (task);
+  task->thread = NULL;
+  parked = priv->parked;
+  if (parked && !priv->woken && GET_TASK_STATE (task) == GST_TASK_STARTED) {
+    /* gst_task_wakeup() or a state change schedules the next iteration */
+    priv->scheduled = FALSE;
+    GST_OBJECT_UNLOCK (task);
+    return;
+  }
+  priv->parked = FALSE;
+  GST_OBJECT_UNLOCK (task);
+
+  if (parked)
+    gst_task_clear_waits (task);
+
+  _priv_gst_cooperative_task_pool_schedule (priv->pool_id,
+      (GstTaskPoolFunction) gst_task_iterate, task);
+  return;
+
+paused:
+  {
+    parked = priv->parked;
+    priv->parked = FALSE;
+    GST_TASK_SIGNAL (task);
+    GST_OBJECT_UNLOCK (task);
+
+    if (parked)
+      gst_task_clear_waits (task);
+
+    GST_OBJECT_LOCK (task);
+    GST_INFO_OBJECT (task, "Task paused");
+    priv->scheduled = FALSE;
+    /* resumed or stopped while we were clearing */
+    if (GET_TASK_STATE (task) != GST_TASK_PAUSED)
+      gst_task_schedule_unlocked (task);
+    GST_OBJECT_UNLOCK (task);
+    return;
+  }
+stopped:
+  {
+    enter = priv->entered;
+    priv->entered = FALSE;
+    priv->parked = FALSE;
+    GST_OBJECT_UNLOCK (task);
+
+    gst_task_clear_waits (task);
+
+    if (enter && priv->leave_func)
+      priv->leave_func (task, tself, priv->leave_user_data);
+
+    GST_OBJECT_LOCK (task);
+    /* the join() completes when running is %FALSE, see gst_task_func() */
+    priv->scheduled = FALSE;
+    task->running = FALSE;
+    GST_TASK_SIGNAL (task);
+    GST_OBJECT_UNLOCK (task);
+
+    GST_DEBUG ("Exit task %p", task);
+
+    gst_object_unref (task);
+    return;
+  }
+no_lock:
+  {
+    GST_OBJECT_UNLOCK (task);
+    g_warning ("starting task without a lock");
+    GST_OBJECT_LOCK (task);
+    goto stopped;
+  }
+}
+
 static void
 gst_task_func (GstTask * task)
 {
@@ -397,6 +673,9 @@ gst_task_func (GstTask * task)
     }
 
     task->func (task->user_data);
+
+    if (G_UNLIKELY (priv->parked))
+      gst_task_wait_parked (task, lock);
   }
 
   g_rec_mutex_unlock (lock);
@@ -459,6 +738,24 @@ gst_task_cleanup_all (void)
     }
   }
 
+  /* stop the thread that watches the file descriptors of waiting tasks */
+  g_mutex_lock (&reactor_lock);
+  if (reactor_thread) {
+    GThread *thread = reactor_thread;
+
+    reactor_thread = NULL;
+    gst_poll_set_flushing (reactor_poll, TRUE);
+    g_mutex_unlock (&reactor_lock);
+    g_thread_join (thread);
+    g_mutex_lock (&reactor_lock);
+
+    g_list_free_full (reactor_waits, (GDestroyNotify) gst_task_fd_wait_free);
+    reactor_waits = NULL;
+    gst_poll_free (reactor_poll);
+    reactor_poll = NULL;
+  }
+  g_mutex_unlock (&reactor_lock);
+
   /* GstElement owns a GThreadPool */
   _priv_gst_element_cleanup ();
 }
@@ -723,6 +1020,16 @@ start_task (GstTask * task)
   /* push on the thread pool, we remember the original pool because the user
    * could change it later on and then we join to the wrong pool. */
   priv->pool_id = gst_object_ref (priv->pool);
+
+  /* a cooperative pool runs the iterations of the task instead of a thread */
+  priv->cooperative = GST_IS_COOPERATIVE_TASK_POOL (priv->pool_id);
+  if (priv->cooperative) {
+    priv->id = NULL;
+    priv->scheduled = FALSE;
+    gst_task_schedule_unlocked (task);
+    return TRUE;
+  }
+
   priv->id =
       gst_task_pool_push (priv->pool_id, (GstTaskPoolFunction) gst_task_func,
       task, &error);
@@ -765,9 +1072,15 @@ gst_task_set_state_unlocked (GstTask * task, GstTaskState state)
         break;
       case GST_TASK_STARTED:
         /* if we were started, we'll go to the new state after the next
-         * iteration. */
+         * iteration. A parked thread has to be woken up for that. */
+        if (task->priv->parked)
+          GST_TASK_BROADCAST (task);
         break;
     }
+    /* a cooperative task that is not scheduled needs an iteration to get to
+     * the new state */
+    if (task->priv->cooperative)
+      gst_task_schedule_unlocked (task);
   }
 
   return res;
@@ -934,6 +1247,9 @@ gst_task_join (GstTask * task)
   SET_TASK_STATE (task, GST_TASK_STOPPED);
   /* signal the state change for when it was blocked in PAUSED. */
   GST_TASK_SIGNAL (task);
+  /* a cooperative task needs an iteration to stop */
+  if (priv->cooperative)
+    gst_task_schedule_unlocked (task);
   /* we set the running flag when pushing the task on the thread pool.
    * This means that the task function might not be called when we try
    * to join it here. */
@@ -970,3 +1286,183 @@ joining_self:
     return FALSE;
   }
 }
+
+/**
+ * gst_task_wait_for_wakeup:
+ * @task: The #GstTask to use
+ *
+ * Marks @task as waiting. This must be called from the task function, which
+ * should return afterwards. The task function will not be called again until
+ * gst_task_wakeup() is called or the state of @task changes.
+ *
+ * To not miss a wakeup, the task function should check the condition it is
+ * waiting for and call this function while holding the lock that
+ * the caller of gst_task_wakeup() holds when changing the condition.
+ *
+ * On a #GstCooperativeTaskPool this frees the worker for other tasks. On other
+ * pools the thread of @task waits with the task lock released.
+ *
+ * Since: 1.24
+ */
+void
+gst_task_wait_for_wakeup (GstTask * task)
+{
+  g_return_if_fail (GST_IS_TASK (task));
+
+  GST_OBJECT_LOCK (task);
+  if (G_UNLIKELY (task->thread != g_thread_self ()))
+    goto not_task_thread;
+  task->priv->parked = TRUE;
+  task->priv->woken = FALSE;
+  GST_OBJECT_UNLOCK (task);
+
+  return;
+
+  /* ERRORS */
+not_task_thread:
+  {
+    GST_OBJECT_UNLOCK (task);
+    g_warning ("task %p can only wait from its task function", task);
+  }
+}
+
+/**
+ * gst_task_wait_for_fd:
+ * @task: The #GstTask to use
+ * @fd: a file descriptor or socket
+ * @condition: %G_IO_IN and/or %G_IO_OUT
+ *
+ * Like gst_task_wait_for_wakeup() but @task is also woken up when @fd can be
+ * read from or written to as requested with @condition, or has an error. The
+ * file descriptors of all waiting tasks are watched by a single thread.
+ *
+ * A task can wait for one file descriptor at a time.
+ *
+ * Since: 1.24
+ */
+void
+gst_task_wait_for_fd (GstTask * task, gint fd, GIOCondition condition)
+{
+  GstTaskFdWait *wait, *old;
+
+  g_return_if_fail (GST_IS_TASK (task));
+  g_return_if_fail (fd >= 0);
+
+  gst_task_wait_for_wakeup (task);
+
+  wait = g_new0 (GstTaskFdWait, 1);
+  wait->task = gst_object_ref (task);
+  wait->condition = condition;
+  gst_poll_fd_init (&wait->pfd);
+  wait->pfd.fd = fd;
+
+  g_mutex_lock (&reactor_lock);
+  if (G_UNLIKELY (reactor_poll == NULL)) {
+    reactor_poll = gst_poll_new (TRUE);
+    reactor_thread = g_thread_new ("gst-task-reactor",
+        gst_task_reactor_func, NULL);
+  }
+
+  if ((old = task->priv->fd_wait)) {
+    gst_poll_remove_fd (reactor_poll, &old->pfd);
+    reactor_waits = g_list_remove (reactor_waits, old);
+  }
+
+  gst_poll_add_fd (reactor_poll, &wait->pfd);
+  gst_poll_fd_ctl_read (reactor_poll, &wait->pfd,
+      (condition & G_IO_IN) != 0);
+  gst_poll_fd_ctl_write (reactor_poll, &wait->pfd,
+      (condition & G_IO_OUT) != 0);
+  reactor_waits = g_list_prepend (reactor_waits, wait);
+  g_atomic_pointer_set (&task->priv->fd_wait, wait);
+  g_mutex_unlock (&reactor_lock);
+
+  gst_poll_restart (reactor_poll);
+
+  if (old)
+    gst_task_fd_wait_free (old);
+}
+
+static gboolean
+gst_task_clock_callback (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  gst_task_wakeup (GST_TASK_CAST (user_data));
+
+  return TRUE;
+}
+
+/**
+ * gst_task_wait_for_clock_id:
+ * @task: The #GstTask to use
+ * @id: a single shot #GstClockID
+ *
+ * Like gst_task_wait_for_wakeup() but @task is also woken up when @id fires.
+ * The clock wait is unscheduled when @task is woken up otherwise.
+ *
+ * Since: 1.24
+ */
+void
+gst_task_wait_for_clock_id (GstTask * task, GstClockID id)
+{
+  GstClockReturn ret;
+  GstClockID old;
+
+  g_return_if_fail (GST_IS_TASK (task));
+  g_return_if_fail (id != NULL);
+
+  gst_task_wait_for_wakeup (task);
+
+  GST_OBJECT_LOCK (task);
+  old = task->priv->clock_id;
+  task->priv->clock_id = gst_clock_id_ref (id);
+  GST_OBJECT_UNLOCK (task);
+
+  if (old) {
+    gst_clock_id_unschedule (old);
+    gst_clock_id_unref (old);
+  }
+
+  ret = gst_clock_id_wait_async (id, gst_task_clock_callback,
+      gst_object_ref (task), gst_object_unref);
+  if (G_UNLIKELY (ret != GST_CLOCK_OK)) {
+    GST_DEBUG_OBJECT (task, "clock wait returned %d", ret);
+    gst_task_wakeup (task);
+    /* an unscheduled entry still owns the data */
+    if (ret != GST_CLOCK_UNSCHEDULED)
+      gst_object_unref (task);
+  }
+}
+
+/**
+ * gst_task_wakeup:
+ * @task: The #GstTask to wake up
+ *
+ * Wakes up @task after it called gst_task_wait_for_wakeup(),
+ * gst_task_wait_for_fd() or gst_task_wait_for_clock_id(), so that its task
+ * function is called again. Does nothing if @task is not waiting.
+ *
+ * MT safe.
+ *
+ * Since: 1.24
+ */
+void
+gst_task_wakeup (GstTask * task)
+{
+  GstTaskPrivate *priv;
+
+  g_return_if_fail (GST_IS_TASK (task));
+
+  priv = task->priv;
+
+  GST_OBJECT_LOCK (task);
+  if (priv->parked && !priv->woken) {
+    GST_LOG_OBJECT (task, "waking up task");
+    priv->woken = TRUE;
+    if (priv->cooperative)
+      gst_task_schedule_unlocked (task);
+    else
+      GST_TASK_BROADCAST (task);
+  }
+  GST_OBJECT_UNLOCK (task);
+}
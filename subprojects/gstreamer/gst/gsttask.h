@@ -24,6 +24,7 @@
 #define __GST_TASK_H__
 
 #include <gst/gstobject.h>
+#include <gst/gstclock.h>
 #include <gst/gsttaskpool.h>
 
 G_BEGIN_DECLS
@@ -213,6 +214,18 @@ gboolean        gst_task_resume         (GstTask *task);
 GST_API
 gboolean        gst_task_join           (GstTask *task);
 
+GST_API
+void            gst_task_wait_for_wakeup   (GstTask *task);
+
+GST_API
+void            gst_task_wait_for_fd       (GstTask *task, gint fd,
+                                            GIOCondition condition);
+GST_API
+void            gst_task_wait_for_clock_id (GstTask *task, GstClockID id);
+
+GST_API
+void            gst_task_wakeup            (GstTask *task);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstTask, gst_object_unref)
 
 G_END_DECLS
@@ -546,3 +546,561 @@ gst_shared_task_pool_new (void)
 
   return pool;
 }
+
+/* The cooperative task pool runs short jobs, such as one iteration of a
+ * #GstTask, on a fixed number of worker threads.
+ *
+ * Every worker has its own queue of jobs. Jobs scheduled from a worker go to
+ * the queue of that worker, jobs scheduled from other threads go to a shared
+ * injection queue. A worker without jobs takes the oldest job of the other
+ * workers before going to sleep.
+ *
+ * Jobs are expected to return quickly. When all workers are busy while jobs
+ * are waiting and no job completed for a while, the workers are assumed to
+ * be blocked and a monitor thread starts an extra worker. Extra workers exit
+ * again after being idle for some time. */
+
+/* number of workers that can be started in addition to the configured ones */
+#define COOP_MAX_WORKERS_FACTOR 4
+/* interval in which the monitor checks for blocked workers */
+#define COOP_MONITOR_INTERVAL (20 * G_TIME_SPAN_MILLISECOND)
+/* idle time after which an extra worker exits */
+#define COOP_EXTRA_IDLE_TIME (G_TIME_SPAN_SECOND)
+
+typedef struct
+{
+  GstTaskPoolFunction func;
+  gpointer user_data;
+} CoopJob;
+
+typedef struct
+{
+  GMutex lock;
+  CoopJob *jobs;
+  guint head;
+  gint len;
+  guint size;
+} CoopQueue;
+
+typedef struct
+{
+  GstCooperativeTaskPool *pool;
+  guint index;
+  GThread *thread;
+  gboolean active;
+  gboolean extra;
+  CoopQueue queue;
+} CoopWorker;
+
+struct _GstCooperativeTaskPoolPrivate
+{
+  guint n_workers;
+
+  GMutex lock;
+  GCond cond;
+  GCond monitor_cond;
+  gboolean running;
+  CoopWorker *workers;
+  guint max_workers;
+  guint n_threads;
+  GThread *monitor;
+  CoopQueue inject;
+
+  /* accessed atomically */
+  gint n_pending;
+  gint n_sleeping;
+  gint n_done;
+};
+
+#define GST_COOPERATIVE_TASK_POOL_CAST(pool)  ((GstCooperativeTaskPool*)(pool))
+
+G_DEFINE_TYPE_WITH_PRIVATE (GstCooperativeTaskPool, gst_cooperative_task_pool,
+    GST_TYPE_TASK_POOL);
+
+/* the worker of the calling thread */
+static GPrivate coop_current_worker;
+
+static void
+coop_queue_init (CoopQueue * queue)
+{
+  g_mutex_init (&queue->lock);
+  queue->jobs = NULL;
+  queue->head = 0;
+  queue->len = 0;
+  queue->size = 0;
+}
+
+static void
+coop_queue_clear (CoopQueue * queue)
+{
+  g_mutex_clear (&queue->lock);
+  g_free (queue->jobs);
+}
+
+static void
+coop_queue_push (CoopQueue * queue, GstTaskPoolFunction func,
+    gpointer user_data)
+{
+  CoopJob *job;
+
+  g_mutex_lock (&queue->lock);
+  if (queue->len == queue->size) {
+    guint i, size = MAX (16, queue->size * 2);
+    CoopJob *jobs = g_new (CoopJob, size);
+
+    for (i = 0; i < queue->len; i++)
+      jobs[i] = queue->jobs[(queue->head + i) % queue->size];
+    g_free (queue->jobs);
+    queue->jobs = jobs;
+    queue->size = size;
+    queue->head = 0;
+  }
+  job = &queue->jobs[(queue->head + queue->len) % queue->size];
+  job->func = func;
+  job->user_data = user_data;
+  g_atomic_int_set (&queue->len, queue->len + 1);
+  g_mutex_unlock (&queue->lock);
+}
+
+/* takes the oldest job of @queue */
+static gboolean
+coop_queue_pop (CoopQueue * queue, CoopJob * job)
+{
+  gboolean res = FALSE;
+
+  if (g_atomic_int_get (&queue->len) == 0)
+    return FALSE;
+
+  g_mutex_lock (&queue->lock);
+  if (queue->len > 0) {
+    *job = queue->jobs[queue->head];
+    queue->head = (queue->head + 1) % queue->size;
+    g_atomic_int_set (&queue->len, queue->len - 1);
+    res = TRUE;
+  }
+  g_mutex_unlock (&queue->lock);
+
+  return res;
+}
+
+static gboolean
+coop_find_job (GstCooperativeTaskPoolPrivate * priv, CoopWorker * self,
+    CoopJob * job)
+{
+  guint i;
+
+  if (coop_queue_pop (&self->queue, job))
+    return TRUE;
+  if (coop_queue_pop (&priv->inject, job))
+    return TRUE;
+
+  /* steal from the other workers */
+  for (i = 1; i < priv->max_workers; i++) {
+    CoopWorker *victim = &priv->workers[(self->index + i) % priv->max_workers];
+
+    if (coop_queue_pop (&victim->queue, job))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static gpointer
+coop_worker_func (CoopWorker * self)
+{
+  GstCooperativeTaskPoolPrivate *priv = self->pool->priv;
+  CoopJob job;
+
+  g_private_set (&coop_current_worker, self);
+
+  while (TRUE) {
+    gboolean idle = FALSE;
+
+    if (coop_find_job (priv, self, &job)) {
+      g_atomic_int_add (&priv->n_pending, -1);
+      job.func (job.user_data);
+      g_atomic_int_inc (&priv->n_done);
+      continue;
+    }
+
+    g_mutex_lock (&priv->lock);
+    if (!priv->running) {
+      g_mutex_unlock (&priv->lock);
+      break;
+    }
+
+    /* check again after announcing that we sleep, a job scheduled after this
+     * point wakes us up */
+    g_atomic_int_inc (&priv->n_sleeping);
+    if (g_atomic_int_get (&priv->n_pending) == 0) {
+      if (self->extra) {
+        idle = !g_cond_wait_until (&priv->cond, &priv->lock,
+            g_get_monotonic_time () + COOP_EXTRA_IDLE_TIME);
+      } else {
+        g_cond_wait (&priv->cond, &priv->lock);
+      }
+    }
+    g_atomic_int_add (&priv->n_sleeping, -1);
+
+    if (idle && priv->running && g_atomic_int_get (&priv->n_pending) == 0
+        && g_atomic_int_get (&self->queue.len) == 0) {
+      GST_DEBUG_OBJECT (self->pool, "extra worker %u exits", self->index);
+      if (self->thread) {
+        g_thread_unref (self->thread);
+        self->thread = NULL;
+      }
+      self->active = FALSE;
+      priv->n_threads--;
+      g_mutex_unlock (&priv->lock);
+      break;
+    }
+    g_mutex_unlock (&priv->lock);
+  }
+
+  g_private_set (&coop_current_worker, NULL);
+
+  return NULL;
+}
+
+/* called with the lock */
+static gboolean
+coop_start_worker (GstCooperativeTaskPool * pool, gboolean extra,
+    GError ** error)
+{
+  GstCooperativeTaskPoolPrivate *priv = pool->priv;
+  CoopWorker *worker = NULL;
+  gchar name[16];
+  guint i;
+
+  for (i = 0; i < priv->max_workers; i++) {
+    if (!priv->workers[i].active && !priv->workers[i].thread) {
+      worker = &priv->workers[i];
+      break;
+    }
+  }
+  if (worker == NULL)
+    return FALSE;
+
+  worker->active = TRUE;
+  worker->extra = extra;
+
+  g_snprintf (name, sizeof (name), "coop-worker-%u", worker->index);
+  worker->thread = g_thread_try_new (name, (GThreadFunc) coop_worker_func,
+      worker, error);
+  if (worker->thread == NULL) {
+    worker->active = FALSE;
+    return FALSE;
+  }
+  priv->n_threads++;
+
+  return TRUE;
+}
+
+static gpointer
+coop_monitor_func (GstCooperativeTaskPool * pool)
+{
+  GstCooperativeTaskPoolPrivate *priv = pool->priv;
+  gint last_done = -1;
+
+  g_mutex_lock (&priv->lock);
+  while (priv->running) {
+    gint done;
+
+    g_cond_wait_until (&priv->monitor_cond, &priv->lock,
+        g_get_monotonic_time () + COOP_MONITOR_INTERVAL);
+    if (!priv->running)
+      break;
+
+    /* jobs are waiting while all workers are busy and none of them completed
+     * a job since the last check, they are blocked */
+    done = g_atomic_int_get (&priv->n_done);
+    if (g_atomic_int_get (&priv->n_pending) > 0 &&
+        g_atomic_int_get (&priv->n_sleeping) == 0 && done == last_done) {
+      if (coop_start_worker (pool, TRUE, NULL))
+        GST_INFO_OBJECT (pool, "workers are blocked, now %u workers",
+            priv->n_threads);
+    }
+    last_done = done;
+  }
+  g_mutex_unlock (&priv->lock);
+
+  return NULL;
+}
+
+static void
+coop_push_func (SharedTaskData * tdata)
+{
+  shared_func (tdata, NULL);
+}
+
+/*
+ * _priv_gst_cooperative_task_pool_schedule:
+ * @pool: a #GstCooperativeTaskPool
+ * @func: the function to call
+ * @user_data: data to pass to @func
+ *
+ * Schedules a single call of @func on one of the workers of @pool. This is
+ * used by #GstTask to run its iterations.
+ */
+void
+_priv_gst_cooperative_task_pool_schedule (GstTaskPool * pool,
+    GstTaskPoolFunction func, gpointer user_data)
+{
+  GstCooperativeTaskPoolPrivate *priv =
+      GST_COOPERATIVE_TASK_POOL_CAST (pool)->priv;
+  CoopWorker *self = g_private_get (&coop_current_worker);
+
+  /* keep the job on the current worker, the data it works on is likely still
+   * in its cache */
+  if (self && self->pool == GST_COOPERATIVE_TASK_POOL_CAST (pool))
+    coop_queue_push (&self->queue, func, user_data);
+  else
+    coop_queue_push (&priv->inject, func, user_data);
+
+  g_atomic_int_inc (&priv->n_pending);
+  if (g_atomic_int_get (&priv->n_sleeping) > 0) {
+    g_mutex_lock (&priv->lock);
+    g_cond_signal (&priv->cond);
+    g_mutex_unlock (&priv->lock);
+  }
+}
+
+static gpointer
+coop_push (GstTaskPool * pool, GstTaskPoolFunction func,
+    gpointer user_data, GError ** error)
+{
+  GstCooperativeTaskPoolPrivate *priv =
+      GST_COOPERATIVE_TASK_POOL_CAST (pool)->priv;
+  SharedTaskData *ret;
+
+  g_mutex_lock (&priv->lock);
+  if (!priv->running) {
+    g_mutex_unlock (&priv->lock);
+    g_set_error_literal (error, GST_CORE_ERROR, GST_CORE_ERROR_FAILED,
+        "No worker threads");
+    return NULL;
+  }
+  g_mutex_unlock (&priv->lock);
+
+  ret = g_new (SharedTaskData, 1);
+
+  ret->done = FALSE;
+  ret->func = func;
+  ret->user_data = user_data;
+  g_atomic_int_set (&ret->refcount, 1);
+  g_cond_init (&ret->done_cond);
+  g_mutex_init (&ret->done_lock);
+
+  _priv_gst_cooperative_task_pool_schedule (pool,
+      (GstTaskPoolFunction) coop_push_func, shared_task_data_ref (ret));
+
+  return ret;
+}
+
+static void
+coop_prepare (GstTaskPool * pool, GError ** error)
+{
+  GstCooperativeTaskPool *coop_pool = GST_COOPERATIVE_TASK_POOL_CAST (pool);
+  GstCooperativeTaskPoolPrivate *priv = coop_pool->priv;
+  guint i;
+
+  g_mutex_lock (&priv->lock);
+  if (priv->running)
+    goto done;
+
+  priv->max_workers = priv->n_workers * COOP_MAX_WORKERS_FACTOR;
+  priv->workers = g_new0 (CoopWorker, priv->max_workers);
+  for (i = 0; i < priv->max_workers; i++) {
+    priv->workers[i].pool = coop_pool;
+    priv->workers[i].index = i;
+    coop_queue_init (&priv->workers[i].queue);
+  }
+  coop_queue_init (&priv->inject);
+  priv->running = TRUE;
+
+  for (i = 0; i < priv->n_workers; i++) {
+    if (!coop_start_worker (coop_pool, FALSE, error))
+      goto done;
+  }
+  priv->monitor = g_thread_try_new ("coop-monitor",
+      (GThreadFunc) coop_monitor_func, coop_pool, error);
+
+  GST_DEBUG_OBJECT (pool, "started %u workers", priv->n_threads);
+
+done:
+  g_mutex_unlock (&priv->lock);
+}
+
+static void
+coop_cleanup (GstTaskPool * pool)
+{
+  GstCooperativeTaskPoolPrivate *priv =
+      GST_COOPERATIVE_TASK_POOL_CAST (pool)->priv;
+  GThread *monitor;
+  guint i;
+
+  g_mutex_lock (&priv->lock);
+  if (!priv->workers) {
+    g_mutex_unlock (&priv->lock);
+    return;
+  }
+  priv->running = FALSE;
+  g_cond_broadcast (&priv->cond);
+  g_cond_signal (&priv->monitor_cond);
+  monitor = priv->monitor;
+  priv->monitor = NULL;
+  g_mutex_unlock (&priv->lock);
+
+  if (monitor)
+    g_thread_join (monitor);
+
+  for (i = 0; i < priv->max_workers; i++) {
+    CoopWorker *worker = &priv->workers[i];
+    GThread *thread;
+
+    g_mutex_lock (&priv->lock);
+    thread = worker->thread;
+    worker->thread = NULL;
+    g_mutex_unlock (&priv->lock);
+
+    if (thread)
+      g_thread_join (thread);
+  }
+
+  if (g_atomic_int_get (&priv->n_pending) > 0)
+    GST_WARNING_OBJECT (pool, "dropping %d jobs that did not run",
+        g_atomic_int_get (&priv->n_pending));
+
+  for (i = 0; i < priv->max_workers; i++)
+    coop_queue_clear (&priv->workers[i].queue);
+  coop_queue_clear (&priv->inject);
+  g_free (priv->workers);
+  priv->workers = NULL;
+  priv->max_workers = 0;
+  priv->n_threads = 0;
+  g_atomic_int_set (&priv->n_pending, 0);
+}
+
+static void
+gst_cooperative_task_pool_finalize (GObject * object)
+{
+  GstCooperativeTaskPoolPrivate *priv =
+      GST_COOPERATIVE_TASK_POOL_CAST (object)->priv;
+
+  coop_cleanup (GST_TASK_POOL_CAST (object));
+
+  g_mutex_clear (&priv->lock);
+  g_cond_clear (&priv->cond);
+  g_cond_clear (&priv->monitor_cond);
+
+  G_OBJECT_CLASS (gst_cooperative_task_pool_parent_class)->finalize (object);
+}
+
+static void
+gst_cooperative_task_pool_class_init (GstCooperativeTaskPoolClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstTaskPoolClass *taskpoolclass = GST_TASK_POOL_CLASS (klass);
+
+  gobject_class->finalize = gst_cooperative_task_pool_finalize;
+
+  taskpoolclass->prepare = coop_prepare;
+  taskpoolclass->cleanup = coop_cleanup;
+  taskpoolclass->push = coop_push;
+  taskpoolclass->join = shared_join;
+  taskpoolclass->dispose_handle = shared_dispose_handle;
+}
+
+static void
+gst_cooperative_task_pool_init (GstCooperativeTaskPool * pool)
+{
+  GstCooperativeTaskPoolPrivate *priv;
+
+  priv = pool->priv = gst_cooperative_task_pool_get_instance_private (pool);
+  priv->n_workers = g_get_num_processors ();
+  g_mutex_init (&priv->lock);
+  g_cond_init (&priv->cond);
+  g_cond_init (&priv->monitor_cond);
+}
+
+/**
+ * gst_cooperative_task_pool_set_n_workers:
+ * @pool: a #GstCooperativeTaskPool
+ * @n_workers: the number of worker threads
+ *
+ * Sets the number of worker threads that @pool starts in
+ * gst_task_pool_prepare(). This has no effect on a pool that is already
+ * prepared.
+ *
+ * Since: 1.24
+ */
+void
+gst_cooperative_task_pool_set_n_workers (GstCooperativeTaskPool * pool,
+    guint n_workers)
+{
+  g_return_if_fail (GST_IS_COOPERATIVE_TASK_POOL (pool));
+  g_return_if_fail (n_workers > 0);
+
+  g_mutex_lock (&pool->priv->lock);
+  pool->priv->n_workers = n_workers;
+  g_mutex_unlock (&pool->priv->lock);
+}
+
+/**
+ * gst_cooperative_task_pool_get_n_workers:
+ * @pool: a #GstCooperativeTaskPool
+ *
+ * Returns: the number of worker threads @pool is configured to start
+ *
+ * Since: 1.24
+ */
+guint
+gst_cooperative_task_pool_get_n_workers (GstCooperativeTaskPool * pool)
+{
+  guint ret;
+
+  g_return_val_if_fail (GST_IS_COOPERATIVE_TASK_POOL (pool), 0);
+
+  g_mutex_lock (&pool->priv->lock);
+  ret = pool->priv->n_workers;
+  g_mutex_unlock (&pool->priv->lock);
+
+  return ret;
+}
+
+/**
+ * gst_cooperative_task_pool_new:
+ *
+ * Create a new cooperative task pool. The pool runs the iterations of the
+ * #GstTask objects that use it on a fixed number of worker threads, one per
+ * CPU by default, instead of giving every task its own thread. This allows a
+ * process to host many mostly idle pipelines with few threads.
+ *
+ * A task on this pool does not keep a thread between two calls of its
+ * function. Instead of blocking until data or an event is available, the
+ * task function should register what it waits for with
+ * gst_task_wait_for_wakeup(), gst_task_wait_for_fd() or
+ * gst_task_wait_for_clock_id() and return. Task functions that block occupy a
+ * worker while doing so; when all workers are blocked, the pool temporarily
+ * starts additional workers. The enter and leave callbacks of a task are
+ * called from the workers that run its first and its last iteration.
+ *
+ * Functions pushed with gst_task_pool_push() are run once on one of the
+ * workers and can be joined with gst_task_pool_join().
+ *
+ * Returns: (transfer full): a new #GstCooperativeTaskPool. gst_object_unref()
+ * after usage.
+ *
+ * Since: 1.24
+ */
+GstTaskPool *
+gst_cooperative_task_pool_new (void)
+{
+  GstTaskPool *pool;
+
+  pool = g_object_new (GST_TYPE_COOPERATIVE_TASK_POOL, NULL);
+
+  /* clear floating flag */
+  gst_object_ref_sink (pool);
+
+  return pool;
+}
@@ -172,6 +172,59 @@ guint           gst_shared_task_pool_get_max_threads (GstSharedTaskPool *pool);
 GST_API
 GstTaskPool *   gst_shared_task_pool_new             (void);
 
+typedef struct _GstCooperativeTaskPool GstCooperativeTaskPool;
+typedef struct _GstCooperativeTaskPoolClass GstCooperativeTaskPoolClass;
+typedef struct _GstCooperativeTaskPoolPrivate GstCooperativeTaskPoolPrivate;
+
+#define GST_TYPE_COOPERATIVE_TASK_POOL             (gst_cooperative_task_pool_get_type ())
+#define GST_COOPERATIVE_TASK_POOL(pool)            (G_TYPE_CHECK_INSTANCE_CAST ((pool), GST_TYPE_COOPERATIVE_TASK_POOL, GstCooperativeTaskPool))
+#define GST_IS_COOPERATIVE_TASK_POOL(pool)         (G_TYPE_CHECK_INSTANCE_TYPE ((pool), GST_TYPE_COOPERATIVE_TASK_POOL))
+#define GST_COOPERATIVE_TASK_POOL_CLASS(pclass)    (G_TYPE_CHECK_CLASS_CAST ((pclass), GST_TYPE_COOPERATIVE_TASK_POOL, GstCooperativeTaskPoolClass))
+#define GST_IS_COOPERATIVE_TASK_POOL_CLASS(pclass) (G_TYPE_CHECK_CLASS_TYPE ((pclass), GST_TYPE_COOPERATIVE_TASK_POOL))
+#define GST_COOPERATIVE_TASK_POOL_GET_CLASS(pool)  (G_TYPE_INSTANCE_GET_CLASS ((pool), GST_TYPE_COOPERATIVE_TASK_POOL, GstCooperativeTaskPoolClass))
+
+/**
+ * GstCooperativeTaskPool:
+ *
+ * The #GstCooperativeTaskPool object.
+ *
+ * Since: 1.24
+ */
+struct _GstCooperativeTaskPool {
+  GstTaskPool parent;
+
+  /*< private >*/
+  GstCooperativeTaskPoolPrivate *priv;
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+/**
+ * GstCooperativeTaskPoolClass:
+ *
+ * The #GstCooperativeTaskPoolClass object.
+ *
+ * Since: 1.24
+ */
+struct _GstCooperativeTaskPoolClass {
+  GstTaskPoolClass parent_class;
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GST_API
+GType           gst_cooperative_task_pool_get_type      (void);
+
+GST_API
+void            gst_cooperative_task_pool_set_n_workers (GstCooperativeTaskPool *pool, guint n_workers);
+
+GST_API
+guint           gst_cooperative_task_pool_get_n_workers (GstCooperativeTaskPool *pool);
+
+GST_API
+GstTaskPool *   gst_cooperative_task_pool_new           (void);
+
 G_END_DECLS
 
 #endif /* __GST_TASK_POOL_H__ */
@@ -84,6 +84,11 @@ typedef enum /*< skip >*/
   GST_TRACER_QUARK_HOOK_PAD_CHAIN_POST,
   GST_TRACER_QUARK_HOOK_PAD_CHAIN_LIST_PRE,
   GST_TRACER_QUARK_HOOK_PAD_CHAIN_LIST_POST,
+  GST_TRACER_QUARK_HOOK_CAPS_CACHE_LOOKUP,
+  GST_TRACER_QUARK_HOOK_SLAB_STATS,
+  GST_TRACER_QUARK_HOOK_MEMORY_ALLOC,
+  GST_TRACER_QUARK_HOOK_MEMORY_COPY,
+  GST_TRACER_QUARK_HOOK_MEMORY_MERGE,
   GST_TRACER_QUARK_MAX
 } GstTracerQuarkId;
 
@@ -839,6 +844,168 @@ typedef void (*GstTracerHookPadChainListPost) (GObject *self, GstClockTime ts,
     GstTracerHookPadChainListPost, (GST_TRACER_ARGS, pad, res)); \
 }G_STMT_END
 
+/**
+ * GstTracerHookCapsCacheLookup:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @operation: the caps operation, one of "intersect", "intersect-first",
+ *   "can-intersect" or "is-subset"
+ * @hit: whether the result was found in the cache
+ *
+ * Hook called when the result of a caps operation is looked up in the caps
+ * result cache, named "caps-cache-lookup".
+ *
+ * Since: 1.24
+ */
+typedef void (*GstTracerHookCapsCacheLookup) (GObject *self, GstClockTime ts,
+    const gchar *operation, gboolean hit);
+
+/**
+ * GST_TRACER_CAPS_CACHE_LOOKUP:
+ * @operation: the caps operation
+ * @hit: whether the result was found in the cache
+ *
+ * Dispatches the "caps-cache-lookup" hook.
+ *
+ * Since: 1.24
+ */
+#define GST_TRACER_CAPS_CACHE_LOOKUP(operation, hit) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_CAPS_CACHE_LOOKUP), \
+    GstTracerHookCapsCacheLookup, (GST_TRACER_ARGS, operation, hit)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookSlabStats:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @cache: the name of the struct cache, "buffer", "event" or "query"
+ * @allocs: number of structs allocated
+ * @hits: number of allocations served from the free lists
+ * @frees: number of structs freed
+ * @released: number of free structs given back to the system
+ *
+ * Hook called periodically and when a thread exits with the counters of the
+ * per-thread struct free lists of the calling thread since the previous call,
+ * named "slab-stats".
+ *
+ * Since: 1.24
+ */
+typedef void (*GstTracerHookSlabStats) (GObject *self, GstClockTime ts,
+    const gchar *cache, guint allocs, guint hits, guint frees, guint released);
+
+/**
+ * GST_TRACER_SLAB_STATS:
+ * @cache: the name of the struct cache
+ * @allocs: number of structs allocated
+ * @hits: number of allocations served from the free lists
+ * @frees: number of structs freed
+ * @released: number of free structs given back to the system
+ *
+ * Dispatches the "slab-stats" hook.
+ *
+ * Since: 1.24
+ */
+#define GST_TRACER_SLAB_STATS(cache, allocs, hits, frees, released) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_SLAB_STATS), \
+    GstTracerHookSlabStats, (GST_TRACER_ARGS, cache, allocs, hits, frees, \
+    released)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookMemoryAlloc:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @allocator: the allocator
+ * @memory: the allocated memory
+ * @pool: (nullable): the buffer pool that is allocating a buffer in the
+ *   calling thread, or %NULL
+ *
+ * Hook called after @memory was allocated with gst_allocator_alloc(), named
+ * "memory-alloc".
+ *
+ * Since: 1.24
+ */
+typedef void (*GstTracerHookMemoryAlloc) (GObject *self, GstClockTime ts,
+    GstAllocator *allocator, GstMemory *memory, GstBufferPool *pool);
+
+/**
+ * GST_TRACER_MEMORY_ALLOC:
+ * @allocator: the allocator
+ * @memory: the allocated memory
+ *
+ * Dispatches the "memory-alloc" hook.
+ *
+ * Since: 1.24
+ */
+#define GST_TRACER_MEMORY_ALLOC(allocator, memory) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_MEMORY_ALLOC), \
+    GstTracerHookMemoryAlloc, (GST_TRACER_ARGS, allocator, memory, \
+    _priv_gst_buffer_pool_get_allocating ())); \
+}G_STMT_END
+
+/**
+ * GstTracerHookMemoryCopy:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @memory: the memory that was copied
+ * @copy: the copy
+ *
+ * Hook called after the data of @memory was copied into @copy with
+ * gst_memory_copy(), named "memory-copy". This happens for deep buffer copies
+ * and when memory that can't be written is mapped for writing.
+ *
+ * Since: 1.24
+ */
+typedef void (*GstTracerHookMemoryCopy) (GObject *self, GstClockTime ts,
+    GstMemory *memory, GstMemory *copy);
+
+/**
+ * GST_TRACER_MEMORY_COPY:
+ * @memory: the memory that was copied
+ * @copy: the copy
+ *
+ * Dispatches the "memory-copy" hook.
+ *
+ * Since: 1.24
+ */
+#define GST_TRACER_MEMORY_COPY(memory, copy) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_MEMORY_COPY), \
+    GstTracerHookMemoryCopy, (GST_TRACER_ARGS, memory, copy)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookMemoryMerge:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @buffer: the buffer
+ * @n_memory: the number of memory blocks that were merged
+ * @merged: the new memory with the data of the merged memory blocks
+ *
+ * Hook called after the data of @n_memory memory blocks of @buffer were
+ * copied into one new memory block, named "memory-merge". This happens when
+ * several memory blocks are mapped at once or when a buffer has too many
+ * memory blocks.
+ *
+ * Since: 1.24
+ */
+typedef void (*GstTracerHookMemoryMerge) (GObject *self, GstClockTime ts,
+    GstBuffer *buffer, guint n_memory, GstMemory *merged);
+
+/**
+ * GST_TRACER_MEMORY_MERGE:
+ * @buffer: the buffer
+ * @n_memory: the number of memory blocks that were merged
+ * @merged: the new memory
+ *
+ * Dispatches the "memory-merge" hook.
+ *
+ * Since: 1.24
+ */
+#define GST_TRACER_MEMORY_MERGE(buffer, n_memory, merged) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_MEMORY_MERGE), \
+    GstTracerHookMemoryMerge, (GST_TRACER_ARGS, buffer, n_memory, merged)); \
+}G_STMT_END
+
 #else /* !GST_DISABLE_GST_TRACER_HOOKS */
 
 static inline void
@@ -892,6 +1059,11 @@ _priv_gst_tracing_deinit (void)
 #define GST_TRACER_PAD_CHAIN_POST(pad, res)
 #define GST_TRACER_PAD_CHAIN_LIST_PRE(pad, list)
 #define GST_TRACER_PAD_CHAIN_LIST_POST(pad, res)
+#define GST_TRACER_CAPS_CACHE_LOOKUP(operation, hit)
+#define GST_TRACER_SLAB_STATS(cache, allocs, hits, frees, released)
+#define GST_TRACER_MEMORY_ALLOC(allocator, memory)
+#define GST_TRACER_MEMORY_COPY(memory, copy)
+#define GST_TRACER_MEMORY_MERGE(buffer, n_memory, merged)
 
 #endif /* GST_DISABLE_GST_TRACER_HOOKS */
 
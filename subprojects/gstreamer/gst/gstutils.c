@@ -1378,6 +1378,7 @@ gst_element_factory_can_accept_all_caps_in_direction (GstElementFactory *
   g_return_val_if_fail (factory != NULL, FALSE);
   g_return_val_if_fail (caps != NULL, FALSE);
 
+  __gst_element_factory_ensure_details (factory);
   templates = factory->staticpadtemplates;
 
   while (templates) {
@@ -1407,6 +1408,7 @@ gst_element_factory_can_accept_any_caps_in_direction (GstElementFactory *
   g_return_val_if_fail (factory != NULL, FALSE);
   g_return_val_if_fail (caps != NULL, FALSE);
 
+  __gst_element_factory_ensure_details (factory);
   templates = factory->staticpadtemplates;
 
   while (templates) {
@@ -356,22 +356,25 @@ gst_writev_buffer (GstObject * sink, gint fd, GstPoll * fdset,
     gboolean * flushing)
 {
   GstFlowReturn flow_ret = GST_FLOW_OK;
-  struct iovec *vecs;
-  GstMapInfo *maps;
+  struct iovec *vecs, *vecs_alloc = NULL;
+  GstMapInfo *maps, *maps_alloc = NULL;
   guint i, num_mem, num_vecs;
   gsize left = 0;
 
-  /* Buffers can contain up to 16 memories, so we can safely directly call
-   * writev() here without splitting up */
-  g_assert (gst_buffer_get_max_memory () <= GST_IOV_MAX);
-
   num_mem = num_vecs = gst_buffer_n_memory (buffer);
 
   GST_DEBUG ("Writing buffer %p with %u memories and %" G_GSIZE_FORMAT " bytes",
       buffer, num_mem, gst_buffer_get_size (buffer));
 
-  vecs = g_newa (struct iovec, num_mem);
-  maps = g_newa (GstMapInfo, num_mem);
+  /* Buffers can contain more memories than fit on the stack comfortably, and
+   * more than GST_IOV_MAX, in which case gst_writev() falls back to write() */
+  if (num_mem <= 16) {
+    vecs = g_newa (struct iovec, num_mem);
+    maps = g_newa (GstMapInfo, num_mem);
+  } else {
+    vecs = vecs_alloc = g_new (struct iovec, num_mem);
+    maps = maps_alloc = g_new (GstMapInfo, num_mem);
+  }
 
   /* Map all memories */
   {
@@ -434,6 +437,9 @@ gst_writev_buffer (GstObject * sink, gint fd, GstPoll * fdset,
   for (i = 0; i < num_mem; i++)
     gst_memory_unmap (maps[i].memory, &maps[i]);
 
+  g_free (vecs_alloc);
+  g_free (maps_alloc);
+
   return flow_ret;
 }
 
@@ -32,12 +32,21 @@
  * gst-launch-1.0 v4l2src num-buffers=1 ! jpegenc ! filesink location=capture1.jpeg
  * ]| Capture one frame from a v4l2 camera and save as jpeg image.
  *
+ * |[
+ * gst-launch-1.0 v4l2src ! x264enc ! mp4mux ! filesink location=capture.mp4 max-pending-writes=8
+ * ]| Record without blocking the streaming thread while the disk is busy.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
 #endif
 
+/* for O_DIRECT */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
 #include <glib/gi18n-lib.h>
 
 #include <gst/gst.h>
@@ -135,6 +144,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_file_sink_debug);
 #define DEFAULT_O_SYNC		FALSE
 #define DEFAULT_MAX_TRANSIENT_ERROR_TIMEOUT	0
 #define DEFAULT_FILE_MODE      GST_FILE_SINK_FILE_MODE_TRUNC
+#define DEFAULT_MAX_PENDING_WRITES	0
+#define DEFAULT_O_DIRECT	FALSE
+
+/* alignment of memory, size and file offset needed for O_DIRECT writes,
+ * which covers the logical block size of all common storage */
+#define DIRECT_IO_ALIGN		4096
 
 enum
 {
@@ -146,9 +161,20 @@ enum
   PROP_O_SYNC,
   PROP_MAX_TRANSIENT_ERROR_TIMEOUT,
   PROP_FILE_MODE,
+  PROP_MAX_PENDING_WRITES,
+  PROP_O_DIRECT,
+  PROP_WRITE_STATS,
   PROP_LAST
 };
 
+/* a write handed over to the writer thread */
+typedef struct
+{
+  GstBuffer *buffer;
+  GstBufferList *buffer_list;
+  guint64 offset;
+} GstFileSinkWrite;
+
 /* Copy of glib's g_fopen due to win32 libc/cross-DLL brokenness: we can't
  * use the 'file pointer' opened in glib (and returned from this function)
  * in this library, as they may have unrelated C runtimes. */
@@ -189,6 +215,7 @@ gst_fopen (const gchar * filename, const gchar * mode, gboolean o_sync)
 }
 
 static void gst_file_sink_dispose (GObject * object);
+static void gst_file_sink_finalize (GObject * object);
 
 static void gst_file_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -214,11 +241,17 @@ static gboolean gst_file_sink_get_current_offset (GstFileSink * filesink,
     guint64 * p_pos);
 
 static gboolean gst_file_sink_query (GstBaseSink * bsink, GstQuery * query);
+static gboolean gst_file_sink_propose_allocation (GstBaseSink * bsink,
+    GstQuery * query);
 
 static void gst_file_sink_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
 
 static GstFlowReturn gst_file_sink_flush_buffer (GstFileSink * filesink);
+static GstFlowReturn gst_file_sink_wait_writes (GstFileSink * filesink);
+static void gst_file_sink_start_writer (GstFileSink * filesink);
+static void gst_file_sink_stop_writer (GstFileSink * filesink);
+static void gst_file_sink_setup_direct (GstFileSink * filesink);
 
 #define _do_init \
   G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER, gst_file_sink_uri_handler_init); \
@@ -237,6 +270,7 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
   GstBaseSinkClass *gstbasesink_class = GST_BASE_SINK_CLASS (klass);
 
   gobject_class->dispose = gst_file_sink_dispose;
+  gobject_class->finalize = gst_file_sink_finalize;
 
   gobject_class->set_property = gst_file_sink_set_property;
   gobject_class->get_property = gst_file_sink_get_property;
@@ -292,6 +326,65 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
           G_MAXINT, DEFAULT_MAX_TRANSIENT_ERROR_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFileSink:max-pending-writes
+   *
+   * Write from a separate thread and allow up to this many writes to be
+   * pending before blocking the streaming thread. 0 writes directly from
+   * the streaming thread.
+   *
+   * Pending writes are finished before seeking, on EOS and on flushes, so
+   * that the position and file contents are consistent at these points.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_PENDING_WRITES,
+      g_param_spec_uint ("max-pending-writes", "Max Pending Writes",
+          "Maximum number of writes pending in the writer thread "
+          "(0 = write synchronously)", 0, G_MAXUINT,
+          DEFAULT_MAX_PENDING_WRITES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstFileSink:o-direct
+   *
+   * Bypass the page cache with O_DIRECT for writes where the memory, the
+   * size and the file position are aligned to 4096 bytes. Upstream is asked
+   * to allocate memory with that alignment, and the buffer of buffer-mode
+   * full is allocated with it, so that writes of whole buffers of an aligned
+   * buffer-size qualify. Other writes use the page cache as usual.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_O_DIRECT,
+      g_param_spec_boolean ("o-direct", "Direct IO",
+          "Write aligned data with O_DIRECT, bypassing the page cache",
+          DEFAULT_O_DIRECT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstFileSink:write-stats
+   *
+   * Write statistics. This property returns a #GstStructure with name
+   * `application/x-gst-file-sink-stats` with the following fields:
+   *
+   * - "writes" G_TYPE_UINT64 Number of writes
+   * - "direct-writes" G_TYPE_UINT64 Number of writes done with O_DIRECT
+   * - "bytes-written" G_TYPE_UINT64 Number of bytes written
+   * - "pending-writes" G_TYPE_UINT Number of writes currently pending
+   * - "queue-full" G_TYPE_UINT64 Number of times the streaming thread had to
+   *   wait for a pending write to finish
+   * - "average-latency" G_TYPE_UINT64 Average duration of a write in ns
+   * - "max-latency" G_TYPE_UINT64 Maximum duration of a write in ns
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_WRITE_STATS,
+      g_param_spec_boxed ("write-stats", "Write Statistics",
+          "Write Statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "File Sink",
       "Sink/File", "Write stream to a file",
@@ -301,6 +394,8 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
   gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_file_sink_start);
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_file_sink_stop);
   gstbasesink_class->query = GST_DEBUG_FUNCPTR (gst_file_sink_query);
+  gstbasesink_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_file_sink_propose_allocation);
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_file_sink_render);
   gstbasesink_class->render_list =
       GST_DEBUG_FUNCPTR (gst_file_sink_render_list);
@@ -328,6 +423,12 @@ gst_file_sink_init (GstFileSink * filesink)
   filesink->buffer_size = DEFAULT_BUFFER_SIZE;
   filesink->append = FALSE;
   filesink->file_mode = DEFAULT_FILE_MODE;
+  filesink->max_pending_writes = DEFAULT_MAX_PENDING_WRITES;
+  filesink->o_direct = DEFAULT_O_DIRECT;
+
+  g_mutex_init (&filesink->write_lock);
+  g_cond_init (&filesink->write_cond);
+  g_queue_init (&filesink->pending_writes);
 
   gst_base_sink_set_sync (GST_BASE_SINK (filesink), FALSE);
 }
@@ -345,6 +446,17 @@ gst_file_sink_dispose (GObject * object)
   sink->filename = NULL;
 }
 
+static void
+gst_file_sink_finalize (GObject * object)
+{
+  GstFileSink *sink = GST_FILE_SINK (object);
+
+  g_mutex_clear (&sink->write_lock);
+  g_cond_clear (&sink->write_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static gboolean
 gst_file_sink_set_location (GstFileSink * sink, const gchar * location,
     GError ** error)
@@ -380,6 +492,27 @@ was_open:
   }
 }
 
+static GstStructure *
+gst_file_sink_get_write_stats (GstFileSink * sink)
+{
+  GstStructure *s;
+
+  g_mutex_lock (&sink->write_lock);
+  s = gst_structure_new ("application/x-gst-file-sink-stats",
+      "writes", G_TYPE_UINT64, sink->n_writes,
+      "direct-writes", G_TYPE_UINT64, sink->n_direct_writes,
+      "bytes-written", G_TYPE_UINT64, sink->bytes_written,
+      "pending-writes", G_TYPE_UINT,
+      g_queue_get_length (&sink->pending_writes),
+      "queue-full", G_TYPE_UINT64, sink->n_queue_full,
+      "average-latency", G_TYPE_UINT64,
+      sink->n_writes ? sink->total_write_latency / sink->n_writes : 0,
+      "max-latency", G_TYPE_UINT64, sink->max_write_latency, NULL);
+  g_mutex_unlock (&sink->write_lock);
+
+  return s;
+}
+
 static void
 gst_file_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -408,6 +541,12 @@ gst_file_sink_set_property (GObject * object, guint prop_id,
     case PROP_MAX_TRANSIENT_ERROR_TIMEOUT:
       sink->max_transient_error_timeout = g_value_get_int (value);
       break;
+    case PROP_MAX_PENDING_WRITES:
+      sink->max_pending_writes = g_value_get_uint (value);
+      break;
+    case PROP_O_DIRECT:
+      sink->o_direct = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -442,12 +581,43 @@ gst_file_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_MAX_TRANSIENT_ERROR_TIMEOUT:
       g_value_set_int (value, sink->max_transient_error_timeout);
       break;
+    case PROP_MAX_PENDING_WRITES:
+      g_value_set_uint (value, sink->max_pending_writes);
+      break;
+    case PROP_O_DIRECT:
+      g_value_set_boolean (value, sink->o_direct);
+      break;
+    case PROP_WRITE_STATS:
+      g_value_take_boxed (value, gst_file_sink_get_write_stats (sink));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* allocates the memory for buffer mode full. With O_DIRECT it is aligned so
+ * that full buffers can be written without the page cache */
+static void
+gst_file_sink_alloc_buffer (GstFileSink * sink, gsize size)
+{
+  gsize align = sink->o_direct ? DIRECT_IO_ALIGN - 1 : 0;
+
+  sink->buffer_mem = g_malloc (size + align);
+  sink->buffer =
+      (guint8 *) (((guintptr) sink->buffer_mem + align) & ~(guintptr) align);
+  sink->allocated_buffer_size = size;
+}
+
+static void
+gst_file_sink_free_buffer (GstFileSink * sink)
+{
+  g_free (sink->buffer_mem);
+  sink->buffer_mem = NULL;
+  sink->buffer = NULL;
+  sink->allocated_buffer_size = 0;
+}
+
 static gboolean
 gst_file_sink_open_file (GstFileSink * sink)
 {
@@ -468,9 +638,7 @@ gst_file_sink_open_file (GstFileSink * sink)
   /* try to seek in the file to figure out if it is seekable */
   sink->seekable = gst_file_sink_do_seek (sink, 0);
 
-  if (sink->buffer)
-    g_free (sink->buffer);
-  sink->buffer = NULL;
+  gst_file_sink_free_buffer (sink);
   if (sink->buffer_list)
     gst_buffer_list_unref (sink->buffer_list);
   sink->buffer_list = NULL;
@@ -482,14 +650,27 @@ gst_file_sink_open_file (GstFileSink * sink)
     }
 
     if (sink->buffer_mode == GST_FILE_SINK_BUFFER_MODE_FULL) {
-      sink->buffer = g_malloc (sink->buffer_size);
-      sink->allocated_buffer_size = sink->buffer_size;
+      gst_file_sink_alloc_buffer (sink, sink->buffer_size);
     } else {
       sink->buffer_list = gst_buffer_list_new ();
     }
     sink->current_buffer_size = 0;
   }
 
+  g_mutex_lock (&sink->write_lock);
+  sink->n_writes = 0;
+  sink->n_direct_writes = 0;
+  sink->n_queue_full = 0;
+  sink->bytes_written = 0;
+  sink->total_write_latency = 0;
+  sink->max_write_latency = 0;
+  g_mutex_unlock (&sink->write_lock);
+
+  gst_file_sink_setup_direct (sink);
+
+  if (sink->max_pending_writes > 0)
+    gst_file_sink_start_writer (sink);
+
   GST_DEBUG_OBJECT (sink, "opened file %s, seekable %d",
       sink->filename, sink->seekable);
 
@@ -519,6 +700,9 @@ gst_file_sink_close_file (GstFileSink * sink)
       GST_ELEMENT_ERROR (sink, RESOURCE, CLOSE,
           (_("Error closing file \"%s\"."), sink->filename), NULL);
 
+    /* the writer already posted an error if it failed */
+    gst_file_sink_stop_writer (sink);
+
     if (fclose (sink->file) != 0)
       GST_ELEMENT_ERROR (sink, RESOURCE, CLOSE,
           (_("Error closing file \"%s\"."), sink->filename), GST_ERROR_SYSTEM);
@@ -527,11 +711,7 @@ gst_file_sink_close_file (GstFileSink * sink)
     sink->file = NULL;
   }
 
-  if (sink->buffer) {
-    g_free (sink->buffer);
-    sink->buffer = NULL;
-  }
-  sink->allocated_buffer_size = 0;
+  gst_file_sink_free_buffer (sink);
 
   if (sink->buffer_list) {
     gst_buffer_list_unref (sink->buffer_list);
@@ -540,6 +720,23 @@ gst_file_sink_close_file (GstFileSink * sink)
   sink->current_buffer_size = 0;
 }
 
+static gboolean
+gst_file_sink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
+{
+  GstFileSink *self = GST_FILE_SINK (bsink);
+  GstAllocationParams params;
+
+  if (!self->o_direct)
+    return FALSE;
+
+  /* ask for memory we can write with O_DIRECT */
+  gst_allocation_params_init (&params);
+  params.align = DIRECT_IO_ALIGN - 1;
+  gst_query_add_allocation_param (query, NULL, &params);
+
+  return TRUE;
+}
+
 static gboolean
 gst_file_sink_query (GstBaseSink * bsink, GstQuery * query)
 {
@@ -610,6 +807,9 @@ gst_file_sink_do_seek (GstFileSink * filesink, guint64 new_offset)
   if (gst_file_sink_flush_buffer (filesink) != GST_FLOW_OK)
     goto flush_buffer_failed;
 
+  if (gst_file_sink_wait_writes (filesink) != GST_FLOW_OK)
+    goto flush_buffer_failed;
+
 #ifdef HAVE_FSEEKO
   if (fseeko (filesink->file, (off_t) new_offset, SEEK_SET) != 0)
     goto seek_failed;
@@ -681,6 +881,8 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
       break;
     }
     case GST_EVENT_FLUSH_STOP:
+      /* errors were already posted by the writer */
+      gst_file_sink_wait_writes (filesink);
       if (filesink->current_pos != 0 && filesink->seekable) {
         gst_file_sink_do_seek (filesink, 0);
         if (ftruncate (fileno (filesink->file), 0))
@@ -695,6 +897,8 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
     case GST_EVENT_EOS:
       if (gst_file_sink_flush_buffer (filesink) != GST_FLOW_OK)
         goto flush_buffer_failed;
+      if (gst_file_sink_wait_writes (filesink) != GST_FLOW_OK)
+        goto flush_buffer_failed;
       break;
     default:
       break;
@@ -752,6 +956,314 @@ gst_file_sink_get_current_offset (GstFileSink * filesink, guint64 * p_pos)
   return (ret != (off_t) - 1);
 }
 
+static gboolean
+has_sync_after_buffer (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  if (GST_BUFFER_FLAG_IS_SET (*buffer, GST_BUFFER_FLAG_SYNC_AFTER)) {
+    gboolean *sync_after = user_data;
+
+    *sync_after = TRUE;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+accumulate_size (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  guint *size = user_data;
+
+  *size += gst_buffer_get_size (*buffer);
+
+  return TRUE;
+}
+
+#ifdef O_DIRECT
+static gboolean
+buffer_is_aligned (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  gboolean *aligned = user_data;
+  guint i, n_mem;
+
+  n_mem = gst_buffer_n_memory (*buffer);
+  for (i = 0; i < n_mem && *aligned; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (*buffer, i);
+    GstMapInfo info;
+
+    if (!gst_memory_map (mem, &info, GST_MAP_READ)) {
+      *aligned = FALSE;
+      break;
+    }
+    if ((GPOINTER_TO_SIZE (info.data) | info.size) & (DIRECT_IO_ALIGN - 1))
+      *aligned = FALSE;
+    gst_memory_unmap (mem, &info);
+  }
+
+  return *aligned;
+}
+#endif
+
+/* check if O_DIRECT can be used for the file at all and keep it set if so */
+static void
+gst_file_sink_setup_direct (GstFileSink * sink)
+{
+  sink->direct_io = FALSE;
+  sink->direct = FALSE;
+
+  if (!sink->o_direct)
+    return;
+
+#ifdef O_DIRECT
+  {
+    gint fd = fileno (sink->file);
+    gint flags;
+
+    flags = fcntl (fd, F_GETFL);
+    if (flags < 0 || fcntl (fd, F_SETFL, flags | O_DIRECT) < 0) {
+      GST_WARNING_OBJECT (sink, "O_DIRECT not supported for %s: %s",
+          sink->filename, g_strerror (errno));
+      return;
+    }
+
+    sink->direct_io = TRUE;
+    sink->direct = TRUE;
+  }
+#else
+  GST_WARNING_OBJECT (sink, "O_DIRECT not supported on this platform");
+#endif
+}
+
+/* O_DIRECT needs memory, size and file position to be aligned. It is turned
+ * off for a write that is not and turned on again for the next that is */
+static void
+gst_file_sink_update_direct (GstFileSink * sink, GstBuffer * buffer,
+    GstBufferList * buffer_list, const guint8 * data, gsize size,
+    guint64 offset)
+{
+#ifdef O_DIRECT
+  gboolean aligned;
+  gint fd, flags;
+
+  if (!sink->direct_io)
+    return;
+
+  aligned = (offset & (DIRECT_IO_ALIGN - 1)) == 0;
+  if (aligned && buffer)
+    buffer_is_aligned (&buffer, 0, &aligned);
+  else if (aligned && buffer_list)
+    gst_buffer_list_foreach (buffer_list, buffer_is_aligned, &aligned);
+  else if (aligned)
+    aligned = ((GPOINTER_TO_SIZE (data) | size) & (DIRECT_IO_ALIGN - 1)) == 0;
+
+  if (aligned == sink->direct)
+    return;
+
+  fd = fileno (sink->file);
+  flags = fcntl (fd, F_GETFL);
+  if (flags < 0 || fcntl (fd, F_SETFL,
+          aligned ? (flags | O_DIRECT) : (flags & ~O_DIRECT)) < 0) {
+    GST_WARNING_OBJECT (sink, "Failed to toggle O_DIRECT: %s",
+        g_strerror (errno));
+    return;
+  }
+
+  GST_LOG_OBJECT (sink, "O_DIRECT %s", aligned ? "enabled" : "disabled");
+  sink->direct = aligned;
+#endif
+}
+
+static void
+gst_file_sink_write_done (GstFileSink * sink, GstClockTime start,
+    guint64 bytes_written)
+{
+  GstClockTime latency = gst_util_get_timestamp () - start;
+
+  g_mutex_lock (&sink->write_lock);
+  sink->n_writes++;
+  if (sink->direct)
+    sink->n_direct_writes++;
+  sink->bytes_written += bytes_written;
+  sink->total_write_latency += latency;
+  sink->max_write_latency = MAX (sink->max_write_latency, latency);
+  g_mutex_unlock (&sink->write_lock);
+}
+
+static GstFlowReturn
+gst_file_sink_write_pending (GstFileSink * sink, GstFileSinkWrite * write)
+{
+  GstFlowReturn flow;
+  guint64 bytes_written = 0;
+  GstClockTime start;
+
+  gst_file_sink_update_direct (sink, write->buffer, write->buffer_list, NULL,
+      0, write->offset);
+
+  start = gst_util_get_timestamp ();
+
+  /* nothing can interrupt us here, writes that were accepted are finished */
+  if (write->buffer) {
+    flow = gst_writev_buffer (GST_OBJECT_CAST (sink), fileno (sink->file),
+        NULL, write->buffer, &bytes_written, 0,
+        sink->max_transient_error_timeout, write->offset, NULL);
+  } else {
+    flow = gst_writev_buffer_list (GST_OBJECT_CAST (sink),
+        fileno (sink->file), NULL, write->buffer_list, &bytes_written, 0,
+        sink->max_transient_error_timeout, write->offset, NULL);
+  }
+
+  if (flow == GST_FLOW_OK)
+    gst_file_sink_write_done (sink, start, bytes_written);
+
+  return flow;
+}
+
+static gpointer
+gst_file_sink_writer_func (GstFileSink * sink)
+{
+  g_mutex_lock (&sink->write_lock);
+  for (;;) {
+    GstFileSinkWrite *write;
+    GstFlowReturn flow = GST_FLOW_OK;
+
+    while (g_queue_is_empty (&sink->pending_writes) && !sink->writer_stop)
+      g_cond_wait (&sink->write_cond, &sink->write_lock);
+
+    /* the queue is drained before stopping */
+    write = g_queue_peek_head (&sink->pending_writes);
+    if (write == NULL)
+      break;
+
+    /* after an error everything still pending is dropped */
+    if (sink->write_flow == GST_FLOW_OK) {
+      g_mutex_unlock (&sink->write_lock);
+      flow = gst_file_sink_write_pending (sink, write);
+      g_mutex_lock (&sink->write_lock);
+    }
+
+    if (flow != GST_FLOW_OK && sink->write_flow == GST_FLOW_OK)
+      sink->write_flow = flow;
+
+    /* only remove it now so that it counts as pending while being written */
+    g_queue_pop_head (&sink->pending_writes);
+    g_cond_broadcast (&sink->write_cond);
+
+    if (write->buffer)
+      gst_buffer_unref (write->buffer);
+    if (write->buffer_list)
+      gst_buffer_list_unref (write->buffer_list);
+    g_free (write);
+  }
+  g_mutex_unlock (&sink->write_lock);
+
+  return NULL;
+}
+
+static void
+gst_file_sink_start_writer (GstFileSink * sink)
+{
+  GST_DEBUG_OBJECT (sink, "starting writer thread, up to %u pending writes",
+      sink->max_pending_writes);
+
+  sink->write_flow = GST_FLOW_OK;
+  sink->writer_stop = FALSE;
+  sink->writer = g_thread_new ("filesink-writer",
+      (GThreadFunc) gst_file_sink_writer_func, sink);
+}
+
+static void
+gst_file_sink_stop_writer (GstFileSink * sink)
+{
+  if (sink->writer == NULL)
+    return;
+
+  g_mutex_lock (&sink->write_lock);
+  sink->writer_stop = TRUE;
+  g_cond_broadcast (&sink->write_cond);
+  g_mutex_unlock (&sink->write_lock);
+
+  g_thread_join (sink->writer);
+  sink->writer = NULL;
+
+  GST_DEBUG_OBJECT (sink, "stopped writer thread");
+}
+
+/* Hands @buffer or @buffer_list over to the writer thread, after waiting for
+ * one of the pending writes to finish if there are too many already. */
+static GstFlowReturn
+gst_file_sink_queue_write (GstFileSink * sink, GstBuffer * buffer,
+    GstBufferList * buffer_list, guint64 size)
+{
+  GstFileSinkWrite *write;
+  GstFlowReturn flow;
+  gboolean waited = FALSE;
+
+  g_mutex_lock (&sink->write_lock);
+  while (sink->write_flow == GST_FLOW_OK
+      && g_queue_get_length (&sink->pending_writes) >=
+      sink->max_pending_writes) {
+    if (g_atomic_int_get (&sink->flushing)) {
+      g_mutex_unlock (&sink->write_lock);
+
+      flow = gst_base_sink_wait_preroll (GST_BASE_SINK (sink));
+      if (flow != GST_FLOW_OK)
+        return flow;
+
+      g_mutex_lock (&sink->write_lock);
+      continue;
+    }
+
+    if (!waited) {
+      sink->n_queue_full++;
+      waited = TRUE;
+    }
+    g_cond_wait (&sink->write_cond, &sink->write_lock);
+  }
+
+  if (sink->write_flow != GST_FLOW_OK) {
+    flow = sink->write_flow;
+    g_mutex_unlock (&sink->write_lock);
+    return flow;
+  }
+
+  write = g_new0 (GstFileSinkWrite, 1);
+  if (buffer)
+    write->buffer = gst_buffer_ref (buffer);
+  else
+    /* our own list is reused by the caller */
+    write->buffer_list = gst_buffer_list_copy (buffer_list);
+  write->offset = sink->current_pos;
+
+  g_queue_push_tail (&sink->pending_writes, write);
+  g_cond_broadcast (&sink->write_cond);
+  g_mutex_unlock (&sink->write_lock);
+
+  GST_LOG_OBJECT (sink, "queued write of %" G_GUINT64_FORMAT " bytes at "
+      "position %" G_GUINT64_FORMAT, size, sink->current_pos);
+
+  sink->current_pos += size;
+
+  return GST_FLOW_OK;
+}
+
+/* waits until everything queued so far was written */
+static GstFlowReturn
+gst_file_sink_wait_writes (GstFileSink * sink)
+{
+  GstFlowReturn flow;
+
+  if (sink->writer == NULL)
+    return GST_FLOW_OK;
+
+  g_mutex_lock (&sink->write_lock);
+  while (!g_queue_is_empty (&sink->pending_writes))
+    g_cond_wait (&sink->write_cond, &sink->write_lock);
+  flow = sink->write_flow;
+  g_mutex_unlock (&sink->write_lock);
+
+  return flow;
+}
+
 static GstFlowReturn
 gst_file_sink_render_list_internal (GstFileSink * sink,
     GstBufferList * buffer_list)
@@ -759,15 +1271,29 @@ gst_file_sink_render_list_internal (GstFileSink * sink,
   GstFlowReturn flow;
   guint num_buffers;
   guint64 skip = 0;
+  GstClockTime start;
 
   num_buffers = gst_buffer_list_length (buffer_list);
   if (num_buffers == 0)
     goto no_data;
 
+  if (sink->writer) {
+    guint size = 0;
+
+    gst_buffer_list_foreach (buffer_list, accumulate_size, &size);
+
+    return gst_file_sink_queue_write (sink, NULL, buffer_list, size);
+  }
+
   GST_DEBUG_OBJECT (sink,
       "writing %u buffers at position %" G_GUINT64_FORMAT, num_buffers,
       sink->current_pos);
 
+  gst_file_sink_update_direct (sink, NULL, buffer_list, NULL, 0,
+      sink->current_pos);
+
+  start = gst_util_get_timestamp ();
+
   for (;;) {
     guint64 bytes_written = 0;
 
@@ -788,6 +1314,9 @@ gst_file_sink_render_list_internal (GstFileSink * sink,
       return flow;
   }
 
+  if (flow == GST_FLOW_OK)
+    gst_file_sink_write_done (sink, start, skip);
+
   return flow;
 
 no_data:
@@ -805,8 +1334,28 @@ gst_file_sink_flush_buffer (GstFileSink * filesink)
   GST_DEBUG_OBJECT (filesink, "Flushing out buffer of size %" G_GSIZE_FORMAT,
       filesink->current_buffer_size);
 
-  if (filesink->buffer && filesink->current_buffer_size) {
+  if (filesink->buffer && filesink->current_buffer_size && filesink->writer) {
+    GstBuffer *buffer;
+    gsize offset;
+
+    /* hand over our memory and continue with a new one */
+    offset = filesink->buffer - (guint8 *) filesink->buffer_mem;
+    buffer = gst_buffer_new_wrapped_full (0, filesink->buffer_mem,
+        offset + filesink->allocated_buffer_size, offset,
+        filesink->current_buffer_size, filesink->buffer_mem, g_free);
+    gst_file_sink_alloc_buffer (filesink, filesink->allocated_buffer_size);
+
+    flow_ret = gst_file_sink_queue_write (filesink, buffer, NULL,
+        filesink->current_buffer_size);
+    gst_buffer_unref (buffer);
+  } else if (filesink->buffer && filesink->current_buffer_size) {
     guint64 skip = 0;
+    GstClockTime start;
+
+    gst_file_sink_update_direct (filesink, NULL, NULL, filesink->buffer,
+        filesink->current_buffer_size, filesink->current_pos);
+
+    start = gst_util_get_timestamp ();
 
     for (;;) {
       guint64 bytes_written = 0;
@@ -827,6 +1376,9 @@ gst_file_sink_flush_buffer (GstFileSink * filesink)
       if (flow_ret != GST_FLOW_OK)
         break;
     }
+
+    if (flow_ret == GST_FLOW_OK)
+      gst_file_sink_write_done (filesink, start, skip);
   } else if (filesink->buffer_list && filesink->current_buffer_size) {
     guint length;
 
@@ -846,35 +1398,22 @@ gst_file_sink_flush_buffer (GstFileSink * filesink)
   return flow_ret;
 }
 
-static gboolean
-has_sync_after_buffer (GstBuffer ** buffer, guint idx, gpointer user_data)
-{
-  if (GST_BUFFER_FLAG_IS_SET (*buffer, GST_BUFFER_FLAG_SYNC_AFTER)) {
-    gboolean *sync_after = user_data;
-
-    *sync_after = TRUE;
-    return FALSE;
-  }
-
-  return TRUE;
-}
-
-static gboolean
-accumulate_size (GstBuffer ** buffer, guint idx, gpointer user_data)
-{
-  guint *size = user_data;
-
-  *size += gst_buffer_get_size (*buffer);
-
-  return TRUE;
-}
-
 static GstFlowReturn
 render_buffer (GstFileSink * filesink, GstBuffer * buffer)
 {
   GstFlowReturn flow;
   guint64 bytes_written = 0;
   guint64 skip = 0;
+  GstClockTime start;
+
+  if (filesink->writer)
+    return gst_file_sink_queue_write (filesink, buffer, NULL,
+        gst_buffer_get_size (buffer));
+
+  gst_file_sink_update_direct (filesink, buffer, NULL, NULL, 0,
+      filesink->current_pos);
+
+  start = gst_util_get_timestamp ();
 
   for (;;) {
     flow =
@@ -895,6 +1434,9 @@ render_buffer (GstFileSink * filesink, GstBuffer * buffer)
       break;
   }
 
+  if (flow == GST_FLOW_OK)
+    gst_file_sink_write_done (filesink, start, skip);
+
   return flow;
 }
 
@@ -968,6 +1510,9 @@ gst_file_sink_render_list (GstBaseSink * bsink, GstBufferList * buffer_list)
     }
   }
 
+  if (flow == GST_FLOW_OK && sync_after)
+    flow = gst_file_sink_wait_writes (sink);
+
   if (flow == GST_FLOW_OK && sync_after) {
     do {
       fsync_ret = fsync (fileno (sink->file));
@@ -1052,6 +1597,9 @@ gst_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     flow = GST_FLOW_OK;
   }
 
+  if (flow == GST_FLOW_OK && sync_after)
+    flow = gst_file_sink_wait_writes (filesink);
+
   if (flow == GST_FLOW_OK && sync_after) {
     do {
       fsync_ret = fsync (fileno (filesink->file));
@@ -1097,6 +1645,11 @@ gst_file_sink_unlock (GstBaseSink * basesink)
   filesink = GST_FILE_SINK_CAST (basesink);
   g_atomic_int_set (&filesink->flushing, TRUE);
 
+  /* wake up the streaming thread if it waits for a pending write */
+  g_mutex_lock (&filesink->write_lock);
+  g_cond_broadcast (&filesink->write_cond);
+  g_mutex_unlock (&filesink->write_lock);
+
   return TRUE;
 }
 
@@ -103,6 +103,7 @@ struct _GstFileSink {
 
   /* For full buffer mode */
   guint8 *buffer;
+  gpointer buffer_mem;          /* allocation containing buffer */
   gsize   allocated_buffer_size;
 
   /* For default/full buffer mode */
@@ -113,6 +114,27 @@ struct _GstFileSink {
   gint max_transient_error_timeout;
 
   gboolean flushing;
+
+  guint max_pending_writes;
+  gboolean o_direct;
+  gboolean direct_io;           /* whether O_DIRECT is usable for the file */
+  gboolean direct;              /* whether O_DIRECT is currently set */
+
+  /* asynchronous writes, protected by write_lock */
+  GMutex write_lock;
+  GCond write_cond;
+  GThread *writer;
+  GQueue pending_writes;
+  gboolean writer_stop;
+  GstFlowReturn write_flow;     /* first error of the writer thread */
+
+  /* write statistics, protected by write_lock */
+  guint64 n_writes;
+  guint64 n_direct_writes;
+  guint64 n_queue_full;
+  guint64 bytes_written;
+  GstClockTime total_write_latency;
+  GstClockTime max_write_latency;
 };
 
 struct _GstFileSinkClass {
@@ -31,6 +31,10 @@
  * gst-launch-1.0 filesrc location=song.ogg ! decodebin ! audioconvert ! audioresample ! autoaudiosink
  * ]| Play song.ogg audio file which must be in the current working directory.
  *
+ * |[
+ * gst-launch-1.0 filesrc location=movie.mp4 use-mmap=true ! qtdemux ! ...
+ * ]| Demux a large file without copying the data out of the page cache.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -65,6 +69,10 @@
 #  include <unistd.h>
 #endif
 
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#endif
+
 #define struct_stat struct stat
 
 #ifdef __BIONIC__               /* Android */
@@ -110,13 +118,145 @@ enum
 };
 
 #define DEFAULT_BLOCKSIZE       4*1024
+#define DEFAULT_USE_MMAP        FALSE
+
+/* how far ahead of the current read position we ask the kernel to read */
+#define READAHEAD_SIZE          (2 * 1024 * 1024)
 
 enum
 {
   PROP_0,
-  PROP_LOCATION
+  PROP_LOCATION,
+  PROP_USE_MMAP
 };
 
+#ifdef HAVE_MMAP
+/* Read-only memory pointing into the mapping of the whole file. The
+ * mapping itself is the parent memory of everything we push downstream,
+ * so it is only unmapped once the last buffer referencing it is gone, and
+ * adjacent regions can be merged again without copying. */
+typedef struct
+{
+  GstMemory mem;
+
+  guint8 *data;
+} GstFileSrcMemory;
+
+typedef struct
+{
+  GstAllocator parent;
+} GstFileSrcAllocator;
+
+typedef struct
+{
+  GstAllocatorClass parent_class;
+} GstFileSrcAllocatorClass;
+
+static GType gst_file_src_allocator_get_type (void);
+G_DEFINE_TYPE (GstFileSrcAllocator, gst_file_src_allocator,
+    GST_TYPE_ALLOCATOR);
+
+static GstFileSrcMemory *
+gst_file_src_memory_new (GstAllocator * allocator, GstMemory * parent,
+    guint8 * data, gsize maxsize, gsize offset, gsize size)
+{
+  GstFileSrcMemory *mem;
+
+  mem = g_new (GstFileSrcMemory, 1);
+  gst_memory_init (GST_MEMORY_CAST (mem), GST_MEMORY_FLAG_READONLY |
+      GST_MINI_OBJECT_FLAG_LOCK_READONLY, allocator, parent, maxsize, 0,
+      offset, size);
+  mem->data = data;
+
+  return mem;
+}
+
+static gpointer
+gst_file_src_memory_map (GstFileSrcMemory * mem, gsize maxsize,
+    GstMapFlags flags)
+{
+  /* writable maps are already refused for readonly memory */
+  return mem->data;
+}
+
+static void
+gst_file_src_memory_unmap (GstFileSrcMemory * mem)
+{
+}
+
+static GstFileSrcMemory *
+gst_file_src_memory_share (GstFileSrcMemory * mem, gssize offset, gsize size)
+{
+  GstMemory *parent;
+
+  /* find the real parent */
+  if ((parent = mem->mem.parent) == NULL)
+    parent = (GstMemory *) mem;
+
+  if (size == -1)
+    size = mem->mem.size - offset;
+
+  return gst_file_src_memory_new (mem->mem.allocator, parent, mem->data,
+      mem->mem.maxsize, mem->mem.offset + offset, size);
+}
+
+static gboolean
+gst_file_src_memory_is_span (GstFileSrcMemory * mem1, GstFileSrcMemory * mem2,
+    gsize * offset)
+{
+  /* the parent is the whole file and always starts at offset 0 */
+  if (offset)
+    *offset = mem1->mem.offset;
+
+  return mem1->mem.offset + mem1->mem.size == mem2->mem.offset;
+}
+
+static GstMemory *
+gst_file_src_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  /* we only ever wrap the mapped file */
+  return NULL;
+}
+
+static void
+gst_file_src_allocator_free (GstAllocator * allocator, GstMemory * mem)
+{
+  GstFileSrcMemory *fmem = (GstFileSrcMemory *) mem;
+
+  if (mem->parent == NULL) {
+    GST_DEBUG ("unmapping %" G_GSIZE_FORMAT " bytes at %p", mem->maxsize,
+        fmem->data);
+    munmap (fmem->data, mem->maxsize);
+  }
+
+  g_free (fmem);
+}
+
+static void
+gst_file_src_allocator_class_init (GstFileSrcAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = gst_file_src_allocator_alloc;
+  allocator_class->free = gst_file_src_allocator_free;
+}
+
+static void
+gst_file_src_allocator_init (GstFileSrcAllocator * allocator)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (allocator);
+
+  alloc->mem_type = "FileSrcMmap";
+  alloc->mem_map = (GstMemoryMapFunction) gst_file_src_memory_map;
+  alloc->mem_unmap = (GstMemoryUnmapFunction) gst_file_src_memory_unmap;
+  alloc->mem_share = (GstMemoryShareFunction) gst_file_src_memory_share;
+  alloc->mem_is_span = (GstMemoryIsSpanFunction) gst_file_src_memory_is_span;
+
+  GST_OBJECT_FLAG_SET (allocator, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+}
+#endif
+
 static void gst_file_src_finalize (GObject * object);
 
 static void gst_file_src_set_property (GObject * object, guint prop_id,
@@ -129,6 +269,9 @@ static gboolean gst_file_src_stop (GstBaseSrc * basesrc);
 
 static gboolean gst_file_src_is_seekable (GstBaseSrc * src);
 static gboolean gst_file_src_get_size (GstBaseSrc * src, guint64 * size);
+static gboolean gst_file_src_do_seek (GstBaseSrc * src, GstSegment * segment);
+static GstFlowReturn gst_file_src_create (GstBaseSrc * src, guint64 offset,
+    guint length, GstBuffer ** buffer);
 static GstFlowReturn gst_file_src_fill (GstBaseSrc * src, guint64 offset,
     guint length, GstBuffer * buf);
 
@@ -163,6 +306,24 @@ gst_file_src_class_init (GstFileSrcClass * klass)
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_READY));
 
+  /**
+   * GstFileSrc:use-mmap:
+   *
+   * Map regular files into memory and push read-only buffers pointing into
+   * the mapping instead of reading a copy of every block. This mostly helps
+   * demuxers that pull large amounts of data from big files.
+   *
+   * The file must not be truncated while it is mapped. Where mapping is not
+   * supported or fails, the file is read as usual.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_MMAP,
+      g_param_spec_boolean ("use-mmap", "Use mmap",
+          "Map the file into memory instead of reading it", DEFAULT_USE_MMAP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gobject_class->finalize = gst_file_src_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -176,6 +337,8 @@ gst_file_src_class_init (GstFileSrcClass * klass)
   gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_file_src_stop);
   gstbasesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_file_src_is_seekable);
   gstbasesrc_class->get_size = GST_DEBUG_FUNCPTR (gst_file_src_get_size);
+  gstbasesrc_class->do_seek = GST_DEBUG_FUNCPTR (gst_file_src_do_seek);
+  gstbasesrc_class->create = GST_DEBUG_FUNCPTR (gst_file_src_create);
   gstbasesrc_class->fill = GST_DEBUG_FUNCPTR (gst_file_src_fill);
 
   if (sizeof (off_t) < 8) {
@@ -192,6 +355,7 @@ gst_file_src_init (GstFileSrc * src)
   src->uri = NULL;
 
   src->is_regular = FALSE;
+  src->use_mmap = DEFAULT_USE_MMAP;
 
   gst_base_src_set_blocksize (GST_BASE_SRC (src), DEFAULT_BLOCKSIZE);
 }
@@ -270,6 +434,9 @@ gst_file_src_set_property (GObject * object, guint prop_id,
     case PROP_LOCATION:
       gst_file_src_set_location (src, g_value_get_string (value), NULL);
       break;
+    case PROP_USE_MMAP:
+      src->use_mmap = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -290,12 +457,116 @@ gst_file_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_LOCATION:
       g_value_set_string (value, src->filename);
       break;
+    case PROP_USE_MMAP:
+      g_value_set_boolean (value, src->use_mmap);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* Ask the kernel to start reading the next READAHEAD_SIZE bytes from @offset,
+ * but not beyond the end of the configured segment. Only done again once we
+ * jumped somewhere else or got close to the end of the previous range. */
+static void
+gst_file_src_readahead (GstFileSrc * src, guint64 offset)
+{
+  GstSegment *segment = &GST_BASE_SRC_CAST (src)->segment;
+  guint64 end;
+
+  if (!src->seekable)
+    return;
+
+  if (offset >= src->readahead_start
+      && offset + READAHEAD_SIZE / 2 < src->readahead_end)
+    return;
+
+  end = offset + READAHEAD_SIZE;
+  if (segment->format == GST_FORMAT_BYTES && segment->stop != -1
+      && segment->stop > offset)
+    end = MIN (end, segment->stop);
+
+  src->readahead_start = offset;
+  src->readahead_end = end;
+
+  GST_LOG_OBJECT (src, "read ahead %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT,
+      offset, end);
+
+#if defined (HAVE_MMAP) && defined (HAVE_MADVISE)
+  if (src->mapping) {
+    guint64 size = src->mapping->size;
+
+    if (offset < size) {
+      GstFileSrcMemory *mem = (GstFileSrcMemory *) src->mapping;
+      guint64 page = offset & ~((guint64) sysconf (_SC_PAGESIZE) - 1);
+
+      madvise (mem->data + page, MIN (end, size) - page, MADV_WILLNEED);
+      return;
+    }
+  }
+#endif
+#ifdef HAVE_POSIX_FADVISE
+  posix_fadvise (src->fd, offset, end - offset, POSIX_FADV_WILLNEED);
+#endif
+}
+
+static gboolean
+gst_file_src_do_seek (GstBaseSrc * basesrc, GstSegment * segment)
+{
+  GstFileSrc *src = GST_FILE_SRC_CAST (basesrc);
+
+  if (!GST_BASE_SRC_CLASS (parent_class)->do_seek (basesrc, segment))
+    return FALSE;
+
+  /* start reading ahead from the new position right away */
+  src->readahead_start = src->readahead_end = 0;
+  if (segment->format == GST_FORMAT_BYTES && segment->start != -1)
+    gst_file_src_readahead (src, segment->start);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_file_src_create (GstBaseSrc * basesrc, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  GstFileSrc *src = GST_FILE_SRC_CAST (basesrc);
+
+  if (offset != -1)
+    gst_file_src_readahead (src, offset);
+
+#ifdef HAVE_MMAP
+  /* downstream provided buffers are filled the normal way, as is anything
+   * after the end of the mapping in case the file grew in the meantime */
+  if (src->mapping && *buffer == NULL && offset != -1
+      && offset < src->mapping->size) {
+    GstBuffer *buf;
+    gsize size;
+
+    size = MIN (length, src->mapping->size - offset);
+
+    GST_LOG_OBJECT (src, "Mapping %" G_GSIZE_FORMAT " bytes at offset 0x%"
+        G_GINT64_MODIFIER "x", size, offset);
+
+    buf = gst_buffer_new ();
+    if (size > 0)
+      gst_buffer_append_memory (buf, gst_memory_share (src->mapping, offset,
+              size));
+
+    GST_BUFFER_OFFSET (buf) = offset;
+    GST_BUFFER_OFFSET_END (buf) = offset + size;
+
+    *buffer = buf;
+
+    return GST_FLOW_OK;
+  }
+#endif
+
+  return GST_BASE_SRC_CLASS (parent_class)->create (basesrc, offset, length,
+      buffer);
+}
+
 /***
  * read code below
  * that is to say, you shouldn't read the code below, but the code that reads
@@ -449,6 +720,56 @@ could_not_stat:
   }
 }
 
+/* map the whole file, on failure we just read it as usual */
+static void
+gst_file_src_map (GstFileSrc * src)
+{
+#ifdef HAVE_MMAP
+  struct_stat stat_results;
+  gpointer data;
+  gsize size;
+
+  if (fstat (src->fd, &stat_results) < 0 || stat_results.st_size == 0)
+    return;
+
+  if ((guint64) stat_results.st_size > G_MAXSIZE)
+    goto too_big;
+
+  size = stat_results.st_size;
+  data = mmap (NULL, size, PROT_READ, MAP_SHARED, src->fd, 0);
+  if (data == MAP_FAILED)
+    goto mmap_failed;
+
+#ifdef HAVE_MADVISE
+  madvise (data, size, MADV_SEQUENTIAL);
+#endif
+
+  GST_DEBUG_OBJECT (src, "mapped %" G_GSIZE_FORMAT " bytes at %p", size, data);
+
+  src->allocator = g_object_new (gst_file_src_allocator_get_type (), NULL);
+  gst_object_ref_sink (src->allocator);
+  src->mapping = GST_MEMORY_CAST (gst_file_src_memory_new (src->allocator,
+          NULL, data, size, 0, size));
+
+  return;
+
+  /* ERRORS */
+too_big:
+  {
+    GST_WARNING_OBJECT (src, "file too big to map, reading it instead");
+    return;
+  }
+mmap_failed:
+  {
+    GST_WARNING_OBJECT (src, "mmap failed, reading the file instead: %s",
+        g_strerror (errno));
+    return;
+  }
+#else
+  GST_WARNING_OBJECT (src, "mmap not supported, reading the file instead");
+#endif
+}
+
 /* open the file, necessary to go to READY state */
 static gboolean
 gst_file_src_start (GstBaseSrc * basesrc)
@@ -537,6 +858,18 @@ gst_file_src_start (GstBaseSrc * basesrc)
 
   gst_base_src_set_dynamic_size (basesrc, src->seekable);
 
+  src->readahead_start = src->readahead_end = 0;
+
+  if (src->seekable) {
+#ifdef HAVE_POSIX_FADVISE
+    posix_fadvise (src->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    if (src->use_mmap)
+      gst_file_src_map (src);
+  } else if (src->use_mmap) {
+    GST_WARNING_OBJECT (src, "can only map seekable regular files");
+  }
+
   return TRUE;
 
   /* ERROR */
@@ -600,6 +933,14 @@ gst_file_src_stop (GstBaseSrc * basesrc)
 {
   GstFileSrc *src = GST_FILE_SRC (basesrc);
 
+  /* drop our reference to the mapping, it is unmapped once downstream
+   * released all buffers */
+  if (src->mapping) {
+    gst_memory_unref (src->mapping);
+    src->mapping = NULL;
+  }
+  gst_clear_object (&src->allocator);
+
   /* close the file */
   g_close (src->fd, NULL);
 
@@ -63,6 +63,14 @@ struct _GstFileSrc {
   gboolean seekable;                    /* whether the file is seekable */
   gboolean is_regular;                  /* whether it's a (symlink to a)
                                            regular file */
+
+  gboolean use_mmap;                    /* whether to map the file */
+  GstAllocator *allocator;              /* allocator of the mapped memory */
+  GstMemory *mapping;                   /* the whole mapped file, parent of
+                                           all memory we push */
+
+  guint64 readahead_start;              /* range we last asked the kernel */
+  guint64 readahead_end;                /* to read ahead */
 };
 
 struct _GstFileSrcClass {
@@ -54,6 +54,12 @@
  * the specified minimum thresholds require (by default: when the queue is
  * empty). The #GstQueue::overrun signal is emitted when the queue is filled
  * up. Both signals are emitted from the context of the streaming thread.
+ *
+ * When a queue sits between two busy threads at high packet rates, taking
+ * the queue lock and waking up the other thread for every item can cost more
+ * than the processing itself. The #GstQueue:lockless property makes the
+ * queue pass buffers through a lock-free ring instead and only wake up the
+ * other thread once a batch of items is available.
  */
 
 #include "gst/gst_private.h"
@@ -122,13 +128,25 @@ enum
   PROP_MIN_THRESHOLD_TIME,
   PROP_LEAKY,
   PROP_SILENT,
-  PROP_FLUSH_ON_EOS
+  PROP_FLUSH_ON_EOS,
+  PROP_LOCKLESS
 };
 
 /* default property values */
 #define DEFAULT_MAX_SIZE_BUFFERS  200   /* 200 buffers */
 #define DEFAULT_MAX_SIZE_BYTES    (10 * 1024 * 1024)    /* 10 MB       */
 #define DEFAULT_MAX_SIZE_TIME     GST_SECOND    /* 1 second    */
+#define DEFAULT_LOCKLESS          FALSE
+
+/* lockless mode, see gst_queue_ring_get_level() */
+#define RING_MIN_SIZE             64
+#define RING_MAX_SIZE             (1 << 16)
+#define RING_DEFAULT_SIZE         1024
+#define RING_SPIN_MIN             16
+#define RING_SPIN_MAX             4096
+#define RING_MAX_BATCH            32
+#define RING_DEL_BATCH            16
+#define RING_BATCH_TIMEOUT        (500)         /* microseconds */
 
 #define GST_QUEUE_MUTEX_LOCK(q) G_STMT_START {                          \
   g_mutex_lock (&q->qlock);                                              \
@@ -176,7 +194,10 @@ enum
 } G_STMT_END
 
 #define GST_QUEUE_SIGNAL_ADD(q) G_STMT_START {                          \
-  if (q->waiting_add) {                                                 \
+  if (q->parked_task) {                                                 \
+    STATUS (q, q->sinkpad, "wakeup ADD");                               \
+    gst_task_wakeup (q->parked_task);                                   \
+  } else if (q->waiting_add) {                                          \
     STATUS (q, q->sinkpad, "signal ADD");                               \
     g_cond_signal (&q->item_add);                                        \
   }                                                                     \
@@ -223,12 +244,18 @@ static gboolean gst_queue_sink_activate_mode (GstPad * pad, GstObject * parent,
 static gboolean gst_queue_is_empty (GstQueue * queue);
 static gboolean gst_queue_is_filled (GstQueue * queue);
 
+static void gst_queue_ring_drop (GstQueue * queue, guint until, gboolean full);
+static void gst_queue_ring_query_done (GstQueue * queue, GstQuery * query,
+    gboolean res);
+
 
 typedef struct
 {
   GstMiniObject *item;
   gsize size;
   gboolean is_query;
+  /* running time before and after the item, only used in lockless mode */
+  GstClockTimeDiff start, end;
 } GstQueueItem;
 
 #define GST_TYPE_QUEUE_LEAKY (queue_leaky_get_type ())
@@ -405,6 +432,35 @@ gst_queue_class_init (GstQueueClass * klass)
           G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
           G_PARAM_STATIC_STRINGS));
 
+  /**
+   * queue:lockless:
+   *
+   * Pass items from the upstream to the downstream thread through a lock-free
+   * single producer, single consumer ring instead of a locked queue. Both
+   * threads spin for a short while before they go to sleep and the
+   * downstream thread is woken up for a batch of items at high rates, which
+   * adds at most half a millisecond of latency.
+   *
+   * The levels and leaky modes behave the same. With #GstQueue:leaky set to
+   * downstream the old buffers are dropped by the downstream thread, or by
+   * the upstream thread while downstream is blocked and the ring is full.
+   * The ring holds up to twice #GstQueue:max-size-buffers items, or 1024
+   * items when that is not set, and when it runs full the queue is
+   * considered full as well.
+   *
+   * When the downstream task runs on a #GstCooperativeTaskPool it does not
+   * spin or wait for batches while the ring is empty. It returns the worker
+   * to the pool and is woken up for every new item, as without this
+   * property.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_LOCKLESS,
+      g_param_spec_boolean ("lockless", "Lockless",
+          "Pass items through a lock-free ring", DEFAULT_LOCKLESS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_queue_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -478,6 +534,9 @@ gst_queue_init (GstQueue * queue)
 
   queue->newseg_applied_to_src = FALSE;
 
+  queue->lockless = DEFAULT_LOCKLESS;
+  queue->ring = NULL;
+
   GST_DEBUG_OBJECT (queue,
       "initialized queue's not_empty & not_full conditions");
 }
@@ -498,6 +557,14 @@ gst_queue_finalize (GObject * object)
   }
   gst_queue_array_free (queue->queue);
 
+  if (queue->ring) {
+    gst_queue_ring_drop (queue, queue->ring_tail, TRUE);
+    g_free (queue->ring);
+  }
+
+  gst_clear_object (&queue->parked_task);
+  gst_clear_object (&queue->coop_task);
+
   g_mutex_clear (&queue->qlock);
   g_cond_clear (&queue->item_add);
   g_cond_clear (&queue->item_del);
@@ -539,6 +606,10 @@ update_time_level (GstQueue * queue)
   }
   sink_time = queue->sinktime;
 
+  /* in lockless mode the level is calculated from the items in the ring */
+  if (queue->ring)
+    return;
+
   if (queue->src_tainted) {
     GST_LOG_OBJECT (queue, "update src time");
     queue->srctime =
@@ -698,11 +769,408 @@ apply_buffer_list (GstQueue * queue, GstBufferList * buffer_list,
   update_time_level (queue);
 }
 
+/* lockless mode
+ *
+ * Items are passed from the sinkpad streaming thread (the producer) to the
+ * srcpad task (the consumer) through a ring of GstQueueItem that is only
+ * written at the tail by the producer and only read at the head by the
+ * consumer. The levels are updated atomically and the time level is
+ * calculated from the running times the producer stored with the oldest and
+ * newest item. One slot of the ring is always kept free so that the
+ * consumer can read the newest item and the producer the oldest one while
+ * the other side keeps going.
+ *
+ * The lock is only taken to wait or to wake up the other side and for events,
+ * queries and flushing. Before waiting both sides spin for a while, the
+ * number of spins adapts to how often that succeeded. The producer only wakes
+ * up a waiting consumer once ring_batch items are queued, the consumer waits
+ * at most RING_BATCH_TIMEOUT for that before it takes what is there and
+ * lowers ring_batch. The consumer in turn wakes up a waiting producer only
+ * after it dequeued RING_DEL_BATCH items or the ring ran empty. */
+
+#define RING_ITEM(q,i) \
+    (&((GstQueueItem *) (q)->ring)[(i) & ((q)->ring_size - 1)])
+#define RING_LENGTH(head,tail) ((guint) ((tail) - (head)))
+
+/* the consumer waits for a batch of items or for the next item */
+#define RING_WAITING_BATCH 1
+#define RING_WAITING_ITEM  2
+
+static void
+gst_queue_ring_get_level (GstQueue * queue, guint head, guint tail,
+    GstQueueSize * level)
+{
+  GstQueueItem *first, *last;
+
+  level->buffers = g_atomic_int_get (&queue->cur_level.buffers);
+  level->bytes = g_atomic_int_get (&queue->cur_level.bytes);
+  level->time = 0;
+
+  if (head == tail)
+    return;
+
+  first = RING_ITEM (queue, head);
+  last = RING_ITEM (queue, tail - 1);
+  if (GST_CLOCK_STIME_IS_VALID (first->start)
+      && GST_CLOCK_STIME_IS_VALID (last->end) && last->end >= first->start)
+    level->time = last->end - first->start;
+}
+
+/* only exact when called from the sinkpad streaming thread or the srcpad
+ * task, for everybody else this is an estimate */
+static guint64
+gst_queue_get_level_time (GstQueue * queue)
+{
+  GstQueueSize level;
+
+  if (!queue->ring)
+    return queue->cur_level.time;
+
+  gst_queue_ring_get_level (queue, g_atomic_int_get (&queue->ring_head),
+      g_atomic_int_get (&queue->ring_tail), &level);
+
+  return level.time;
+}
+
+static gboolean
+gst_queue_ring_is_filled (GstQueue * queue)
+{
+  GstQueueSize level;
+  guint head, tail;
+
+  head = g_atomic_int_get (&queue->ring_head);
+  tail = g_atomic_int_get (&queue->ring_tail);
+
+  if (RING_LENGTH (head, tail) >= queue->ring_size - 1)
+    return TRUE;
+
+  gst_queue_ring_get_level (queue, head, tail, &level);
+
+  return ((queue->max_size.buffers > 0 &&
+          level.buffers >= queue->max_size.buffers) ||
+      (queue->max_size.bytes > 0 &&
+          level.bytes >= queue->max_size.bytes) ||
+      (queue->max_size.time > 0 && level.time >= queue->max_size.time));
+}
+
+/* called from the srcpad task */
+static gboolean
+gst_queue_ring_is_empty (GstQueue * queue)
+{
+  GstQueueSize level;
+  GstQueueItem *last;
+  guint head, tail;
+
+  head = g_atomic_int_get (&queue->ring_head);
+  tail = g_atomic_int_get (&queue->ring_tail);
+
+  if (head == tail)
+    return TRUE;
+
+  /* same as gst_queue_is_empty() */
+  last = RING_ITEM (queue, tail - 1);
+  if (last->is_query || (!GST_IS_BUFFER (last->item)
+          && !GST_IS_BUFFER_LIST (last->item)))
+    return FALSE;
+
+  gst_queue_ring_get_level (queue, head, tail, &level);
+
+  return ((queue->min_threshold.buffers > 0 &&
+          level.buffers < queue->min_threshold.buffers) ||
+      (queue->min_threshold.bytes > 0 &&
+          level.bytes < queue->min_threshold.bytes) ||
+      (queue->min_threshold.time > 0 &&
+          level.time < queue->min_threshold.time)) &&
+      !gst_queue_ring_is_filled (queue);
+}
+
+/* called from the sinkpad streaming thread, there must be space in the ring.
+ * The caller wakes up the srcpad task */
+static void
+gst_queue_ring_enqueue (GstQueue * queue, GstMiniObject * item, gsize size,
+    gboolean is_query, GstClockTimeDiff start)
+{
+  GstQueueItem *qitem = RING_ITEM (queue, queue->ring_tail);
+
+  qitem->item = item;
+  qitem->size = size;
+  qitem->is_query = is_query;
+  qitem->start = start;
+  qitem->end = queue->sinktime;
+
+  g_atomic_int_set (&queue->ring_tail, queue->ring_tail + 1);
+}
+
+/* called from the srcpad task or while it is stopped, and from the sinkpad
+ * streaming thread to leak the oldest item when the ring is full. Both can
+ * race for the head, the item is only owned after advancing it. The caller
+ * wakes up the sinkpad streaming thread */
+static GstMiniObject *
+gst_queue_ring_dequeue (GstQueue * queue, gboolean * is_query)
+{
+  GstQueueItem *qitem;
+  GstMiniObject *item;
+  gsize size;
+  guint head;
+  gint buffers = 0;
+
+  do {
+    head = g_atomic_int_get (&queue->ring_head);
+    if (head == g_atomic_int_get (&queue->ring_tail))
+      return NULL;
+
+    qitem = RING_ITEM (queue, head);
+    item = qitem->item;
+    size = qitem->size;
+    *is_query = qitem->is_query;
+  } while (!g_atomic_int_compare_and_exchange (&queue->ring_head, head,
+          head + 1));
+
+  /* the query might be gone already if the queue was flushed */
+  if (!*is_query) {
+    if (GST_IS_BUFFER (item))
+      buffers = 1;
+    else if (GST_IS_BUFFER_LIST (item))
+      buffers = gst_buffer_list_length (GST_BUFFER_LIST_CAST (item));
+  }
+  if (buffers > 0) {
+    g_atomic_int_add (&queue->cur_level.buffers, -buffers);
+    g_atomic_int_add (&queue->cur_level.bytes, -(gint) size);
+  }
+
+  return item;
+}
+
+/* drop all items before @until. Called from the srcpad task or while it is
+ * stopped */
+static void
+gst_queue_ring_drop (GstQueue * queue, guint until, gboolean full)
+{
+  GstMiniObject *item;
+  gboolean is_query;
+
+  while ((gint) (until - g_atomic_int_get (&queue->ring_head)) > 0
+      && (item = gst_queue_ring_dequeue (queue, &is_query))) {
+    if (is_query)
+      continue;
+
+    if (!full && GST_IS_EVENT (item) && GST_EVENT_IS_STICKY (item)
+        && GST_EVENT_TYPE (item) != GST_EVENT_SEGMENT
+        && GST_EVENT_TYPE (item) != GST_EVENT_EOS) {
+      gst_pad_store_sticky_event (queue->srcpad, GST_EVENT_CAST (item));
+    }
+    gst_mini_object_unref (item);
+  }
+}
+
+/* make the srcpad task drop everything queued so far, called from the sinkpad
+ * streaming thread */
+static void
+gst_queue_ring_mark_flush (GstQueue * queue)
+{
+  g_atomic_int_set (&queue->ring_flush, queue->ring_tail);
+}
+
+/* called from the sinkpad streaming thread without the lock */
+static void
+gst_queue_ring_signal_add (GstQueue * queue, gboolean force)
+{
+  gint waiting = g_atomic_int_get (&queue->waiting_add);
+
+  if (!waiting)
+    return;
+
+  if (!force && waiting == RING_WAITING_BATCH &&
+      RING_LENGTH (g_atomic_int_get (&queue->ring_head),
+          queue->ring_tail) < g_atomic_int_get (&queue->ring_batch))
+    return;
+
+  GST_QUEUE_MUTEX_LOCK (queue);
+  GST_QUEUE_SIGNAL_ADD (queue);
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+}
+
+/* called from the srcpad task without the lock */
+static void
+gst_queue_ring_signal_del (GstQueue * queue)
+{
+  guint head = g_atomic_int_get (&queue->ring_head);
+
+  if (!g_atomic_int_get (&queue->waiting_del))
+    return;
+
+  if (head != g_atomic_int_get (&queue->ring_tail) &&
+      RING_LENGTH (g_atomic_int_get (&queue->ring_park_head),
+          head) < RING_DEL_BATCH)
+    return;
+
+  GST_QUEUE_MUTEX_LOCK (queue);
+  GST_QUEUE_SIGNAL_DEL (queue);
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+}
+
+/* wait until the queue is not empty, called from the srcpad task without the
+ * lock. Returns FALSE when flushing */
+static gboolean
+gst_queue_ring_wait_add (GstQueue * queue)
+{
+  gint64 start, deadline, now;
+  gboolean res;
+  guint i;
+
+  for (i = 0; i < queue->ring_spin_add; i++) {
+    if (g_atomic_int_get (&queue->srcresult) != GST_FLOW_OK)
+      return FALSE;
+    if (!gst_queue_ring_is_empty (queue)) {
+      queue->ring_spin_add = MIN (queue->ring_spin_add * 2, RING_SPIN_MAX);
+      return TRUE;
+    }
+  }
+  queue->ring_spin_add = MAX (queue->ring_spin_add / 2, RING_SPIN_MIN);
+
+  GST_QUEUE_MUTEX_LOCK (queue);
+  /* the sinkpad streaming thread might be waiting for a batch of free space
+   * that will not come now, e.g. because of the min thresholds */
+  GST_QUEUE_SIGNAL_DEL (queue);
+  STATUS (queue, queue->srcpad, "wait for ADD");
+  start = g_get_monotonic_time ();
+  deadline = start + RING_BATCH_TIMEOUT;
+  g_atomic_int_set (&queue->waiting_add, RING_WAITING_BATCH);
+  while (queue->srcresult == GST_FLOW_OK && gst_queue_ring_is_empty (queue)) {
+    if (queue->waiting_add == RING_WAITING_ITEM) {
+      g_cond_wait (&queue->item_add, &queue->qlock);
+    } else if (!g_cond_wait_until (&queue->item_add, &queue->qlock, deadline)) {
+      /* the batch did not fill up in time, take what is there now and wake
+       * up for the next item from now on */
+      if (!gst_queue_ring_is_empty (queue) && queue->ring_batch > 1)
+        g_atomic_int_set (&queue->ring_batch, queue->ring_batch / 2);
+      g_atomic_int_set (&queue->waiting_add, RING_WAITING_ITEM);
+    } else {
+      now = g_get_monotonic_time ();
+      /* the batch filled up quickly, wait for more items next time */
+      if (now - start < RING_BATCH_TIMEOUT / 2 &&
+          RING_LENGTH (g_atomic_int_get (&queue->ring_head),
+              g_atomic_int_get (&queue->ring_tail)) >= queue->ring_batch)
+        g_atomic_int_set (&queue->ring_batch,
+            MIN (queue->ring_batch * 2, RING_MAX_BATCH));
+    }
+  }
+  g_atomic_int_set (&queue->waiting_add, FALSE);
+  res = queue->srcresult == GST_FLOW_OK;
+  STATUS (queue, queue->srcpad, "received ADD");
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+
+  return res;
+}
+
+/* wait until the queue is not filled, called from the sinkpad streaming
+ * thread without the lock. Returns FALSE when flushing */
+static gboolean
+gst_queue_ring_wait_del (GstQueue * queue)
+{
+  gboolean res;
+  guint i;
+
+  for (i = 0; i < queue->ring_spin_del; i++) {
+    if (g_atomic_int_get (&queue->srcresult) != GST_FLOW_OK)
+      return FALSE;
+    if (!gst_queue_ring_is_filled (queue)) {
+      queue->ring_spin_del = MIN (queue->ring_spin_del * 2, RING_SPIN_MAX);
+      return TRUE;
+    }
+  }
+  queue->ring_spin_del = MAX (queue->ring_spin_del / 2, RING_SPIN_MIN);
+
+  GST_QUEUE_MUTEX_LOCK (queue);
+  /* the srcpad task might be waiting for a batch that will not come now */
+  GST_QUEUE_SIGNAL_ADD (queue);
+  g_atomic_int_set (&queue->ring_park_head,
+      g_atomic_int_get (&queue->ring_head));
+  g_atomic_int_set (&queue->waiting_del, TRUE);
+  while (queue->srcresult == GST_FLOW_OK && gst_queue_ring_is_filled (queue)) {
+    STATUS (queue, queue->sinkpad, "wait for DEL");
+    g_cond_wait (&queue->item_del, &queue->qlock);
+  }
+  g_atomic_int_set (&queue->waiting_del, FALSE);
+  res = queue->srcresult == GST_FLOW_OK;
+  STATUS (queue, queue->sinkpad, "received DEL");
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+
+  return res;
+}
+
+/* wait until an event or query fits in the ring, called from the sinkpad
+ * streaming thread with the lock. Returns FALSE when flushing */
+static gboolean
+gst_queue_ring_locked_wait_space (GstQueue * queue)
+{
+  while (queue->srcresult == GST_FLOW_OK &&
+      RING_LENGTH (g_atomic_int_get (&queue->ring_head),
+          queue->ring_tail) >= queue->ring_size - 1) {
+    GST_QUEUE_SIGNAL_ADD (queue);
+    g_atomic_int_set (&queue->ring_park_head,
+        g_atomic_int_get (&queue->ring_head));
+    g_atomic_int_set (&queue->waiting_del, TRUE);
+    /* check again now that the srcpad task will wake us up */
+    if (RING_LENGTH (g_atomic_int_get (&queue->ring_head),
+            queue->ring_tail) >= queue->ring_size - 1)
+      g_cond_wait (&queue->item_del, &queue->qlock);
+    g_atomic_int_set (&queue->waiting_del, FALSE);
+  }
+
+  return queue->srcresult == GST_FLOW_OK;
+}
+
+/* (re)allocate the ring according to the lockless property, called when
+ * both pads are inactive */
+static void
+gst_queue_ring_configure (GstQueue * queue)
+{
+  guint size = 0;
+
+  if (queue->lockless) {
+    /* twice the buffer limit leaves room for events and for leaking on the
+     * downstream end */
+    if (queue->max_size.buffers > 0)
+      size = 1 << g_bit_storage (CLAMP (queue->max_size.buffers,
+              RING_MIN_SIZE / 2, RING_MAX_SIZE / 2) * 2 - 1);
+    else
+      size = RING_DEFAULT_SIZE;
+  }
+
+  if (queue->ring && queue->ring_size == size)
+    return;
+
+  if (queue->ring) {
+    gst_queue_ring_drop (queue, queue->ring_tail, TRUE);
+    g_free (queue->ring);
+    queue->ring = NULL;
+  }
+
+  if (size > 0) {
+    GST_DEBUG_OBJECT (queue, "using lockless ring of %u items", size);
+    queue->ring = g_new0 (GstQueueItem, size);
+    queue->ring_size = size;
+    queue->ring_head = queue->ring_tail = queue->ring_flush = 0;
+    queue->ring_leaked = FALSE;
+    queue->ring_spin_add = queue->ring_spin_del = RING_SPIN_MIN;
+    queue->ring_batch = 1;
+    queue->cur_level.buffers = queue->cur_level.bytes = 0;
+  }
+}
+
+/* in lockless mode this may only be called while the srcpad task and the
+ * sinkpad streaming thread are both stopped */
 static void
 gst_queue_locked_flush (GstQueue * queue, gboolean full)
 {
   GstQueueItem *qitem;
 
+  if (queue->ring) {
+    gst_queue_ring_drop (queue, queue->ring_tail, full);
+    queue->ring_flush = queue->ring_tail;
+  }
+
   while ((qitem = gst_queue_array_pop_head_struct (queue->queue))) {
     /* Then lose another reference because we are supposed to destroy that
        data when flushing */
@@ -818,6 +1286,42 @@ gst_queue_locked_enqueue_event (GstQueue * queue, gpointer item)
   GST_QUEUE_SIGNAL_ADD (queue);
 }
 
+/* lockless version of gst_queue_locked_enqueue_event(), called from the
+ * sinkpad streaming thread with QUEUE_LOCK. Returns FALSE when flushing */
+static gboolean
+gst_queue_ring_locked_enqueue_event (GstQueue * queue, GstEvent * event)
+{
+  if (!gst_queue_ring_locked_wait_space (queue))
+    return FALSE;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+      GST_CAT_LOG_OBJECT (queue_dataflow, queue, "got EOS from upstream");
+      /* the srcpad task drops everything before the EOS. No need to clear
+       * the thresholds, the queue is never empty with the EOS at the tail */
+      if (queue->flush_on_eos)
+        gst_queue_ring_mark_flush (queue);
+      queue->eos = TRUE;
+      break;
+    case GST_EVENT_SEGMENT:
+      apply_segment (queue, event, &queue->sink_segment, TRUE);
+      g_atomic_int_set (&queue->unexpected, FALSE);
+      break;
+    case GST_EVENT_GAP:
+      apply_gap (queue, event, &queue->sink_segment, TRUE);
+      break;
+    default:
+      break;
+  }
+
+  update_time_level (queue);
+  gst_queue_ring_enqueue (queue, GST_MINI_OBJECT_CAST (event), 0, FALSE,
+      queue->sinktime);
+  GST_QUEUE_SIGNAL_ADD (queue);
+
+  return TRUE;
+}
+
 /* dequeue an item from the queue and update level stats, with QUEUE_LOCK */
 static GstMiniObject *
 gst_queue_locked_dequeue (GstQueue * queue)
@@ -950,6 +1454,7 @@ gst_queue_handle_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
       GST_QUEUE_MUTEX_LOCK (queue);
       gst_queue_locked_flush (queue, FALSE);
+      gst_clear_object (&queue->parked_task);
       queue->srcresult = GST_FLOW_OK;
       queue->eos = FALSE;
       queue->unexpected = FALSE;
@@ -1020,7 +1525,14 @@ gst_queue_handle_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
           }
         }
 
-        gst_queue_locked_enqueue_event (queue, event);
+        if (queue->ring) {
+          if (!gst_queue_ring_locked_enqueue_event (queue, event)) {
+            GST_QUEUE_MUTEX_UNLOCK (queue);
+            goto out_flow_error;
+          }
+        } else {
+          gst_queue_locked_enqueue_event (queue, event);
+        }
         GST_QUEUE_MUTEX_UNLOCK (queue);
       } else {
         /* non-serialized events are forwarded downstream immediately */
@@ -1066,10 +1578,18 @@ gst_queue_handle_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
         GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
         GST_LOG_OBJECT (queue, "queuing query %p (%s)", query,
             GST_QUERY_TYPE_NAME (query));
-        qitem.item = GST_MINI_OBJECT_CAST (query);
-        qitem.is_query = TRUE;
-        qitem.size = 0;
-        gst_queue_array_push_tail_struct (queue->queue, &qitem);
+        if (queue->ring) {
+          if (!gst_queue_ring_locked_wait_space (queue))
+            goto out_flushing;
+          update_time_level (queue);
+          gst_queue_ring_enqueue (queue, GST_MINI_OBJECT_CAST (query), 0,
+              TRUE, queue->sinktime);
+        } else {
+          qitem.item = GST_MINI_OBJECT_CAST (query);
+          qitem.is_query = TRUE;
+          qitem.size = 0;
+          gst_queue_array_push_tail_struct (queue->queue, &qitem);
+        }
         GST_QUEUE_SIGNAL_ADD (queue);
         while (queue->srcresult == GST_FLOW_OK &&
             queue->last_handled_query != query)
@@ -1178,6 +1698,168 @@ discont_first_buffer (GstBuffer ** buffer, guint i, gpointer user_data)
   return FALSE;
 }
 
+static GstMiniObject *
+gst_queue_mark_discont (GstQueue * queue, GstMiniObject * obj,
+    gboolean is_list)
+{
+  if (!is_list) {
+    GstBuffer *buffer = GST_BUFFER_CAST (obj);
+    GstBuffer *subbuffer = gst_buffer_make_writable (buffer);
+
+    if (subbuffer) {
+      buffer = subbuffer;
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    } else {
+      GST_DEBUG_OBJECT (queue, "Could not mark buffer as DISCONT");
+    }
+
+    obj = GST_MINI_OBJECT_CAST (buffer);
+  } else {
+    GstBufferList *buffer_list = GST_BUFFER_LIST_CAST (obj);
+
+    buffer_list = gst_buffer_list_make_writable (buffer_list);
+    gst_buffer_list_foreach (buffer_list, discont_first_buffer, queue);
+    obj = GST_MINI_OBJECT_CAST (buffer_list);
+  }
+
+  return obj;
+}
+
+/* leak the oldest items until there is space in the ring, called from the
+ * sinkpad streaming thread while the srcpad task might be blocked pushing */
+static void
+gst_queue_ring_leak_oldest (GstQueue * queue)
+{
+  GstMiniObject *leak;
+  gboolean is_query;
+
+  while (RING_LENGTH (g_atomic_int_get (&queue->ring_head),
+          queue->ring_tail) >= queue->ring_size - 1
+      && (leak = gst_queue_ring_dequeue (queue, &is_query))) {
+    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+        "ring is full, leaking item %p on downstream end", leak);
+
+    if (is_query) {
+      gst_queue_ring_query_done (queue, GST_QUERY_CAST (leak), FALSE);
+    } else {
+      if (GST_IS_EVENT (leak) && GST_EVENT_IS_STICKY (leak)) {
+        GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+            "Storing sticky event %s on srcpad", GST_EVENT_TYPE_NAME (leak));
+        gst_pad_store_sticky_event (queue->srcpad, GST_EVENT_CAST (leak));
+      }
+      gst_mini_object_unref (leak);
+    }
+
+    /* the srcpad task marks the next buffer as DISCONT */
+    g_atomic_int_set (&queue->ring_leaked, TRUE);
+  }
+}
+
+/* lockless version of gst_queue_chain_buffer_or_list(), without the lock */
+static GstFlowReturn
+gst_queue_ring_chain (GstQueue * queue, GstMiniObject * obj, gboolean is_list)
+{
+  GstFlowReturn ret;
+  GstClockTimeDiff start;
+  gsize size;
+  gint buffers;
+
+  ret = g_atomic_int_get (&queue->srcresult);
+  if (ret != GST_FLOW_OK)
+    goto out_flushing;
+  /* when we received EOS, we refuse any more data */
+  if (queue->eos || g_atomic_int_get (&queue->unexpected))
+    goto out_eos;
+
+  GST_CAT_LOG_OBJECT (queue_dataflow, queue, "received %s %p",
+      is_list ? "buffer list" : "buffer", obj);
+
+  while (gst_queue_ring_is_filled (queue)) {
+    if (!queue->silent) {
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_OVERRUN], 0);
+      /* we recheck, the signal could have changed the thresholds */
+      if (!gst_queue_ring_is_filled (queue))
+        break;
+    }
+
+    switch (queue->leaky) {
+      case GST_QUEUE_LEAK_DOWNSTREAM:
+        /* the srcpad task leaks the old buffers. When the ring itself is
+         * full, e.g. because downstream blocks, we leak the oldest items
+         * ourselves so that the newest data is kept */
+        gst_queue_ring_leak_oldest (queue);
+        goto enqueue;
+      case GST_QUEUE_LEAK_UPSTREAM:
+        queue->tail_needs_discont = TRUE;
+        GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+            "queue is full, leaking buffer on upstream end");
+        gst_mini_object_unref (obj);
+        return GST_FLOW_OK;
+      default:
+        g_warning ("Unknown leaky type, using default");
+        /* fall-through */
+      case GST_QUEUE_NO_LEAK:
+        GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+            "queue is full, waiting for free space");
+        if (!gst_queue_ring_wait_del (queue)) {
+          ret = g_atomic_int_get (&queue->srcresult);
+          goto out_flushing;
+        }
+        GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is not full");
+        if (!queue->silent)
+          g_signal_emit (queue, gst_queue_signals[SIGNAL_RUNNING], 0);
+        break;
+    }
+  }
+
+enqueue:
+  if (queue->tail_needs_discont) {
+    obj = gst_queue_mark_discont (queue, obj, is_list);
+    queue->tail_needs_discont = FALSE;
+  }
+
+  update_time_level (queue);
+  start = queue->sinktime;
+
+  if (is_list) {
+    GstBufferList *buffer_list = GST_BUFFER_LIST_CAST (obj);
+
+    size = gst_buffer_list_calculate_size (buffer_list);
+    buffers = gst_buffer_list_length (buffer_list);
+    apply_buffer_list (queue, buffer_list, &queue->sink_segment, TRUE);
+  } else {
+    GstBuffer *buffer = GST_BUFFER_CAST (obj);
+
+    size = gst_buffer_get_size (buffer);
+    buffers = 1;
+    apply_buffer (queue, buffer, &queue->sink_segment, TRUE);
+  }
+
+  g_atomic_int_add (&queue->cur_level.buffers, buffers);
+  g_atomic_int_add (&queue->cur_level.bytes, (gint) size);
+  gst_queue_ring_enqueue (queue, obj, size, FALSE, start);
+  gst_queue_ring_signal_add (queue, FALSE);
+
+  return GST_FLOW_OK;
+
+  /* special conditions */
+out_flushing:
+  {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "exit because task paused, reason: %s", gst_flow_get_name (ret));
+    gst_mini_object_unref (obj);
+
+    return ret;
+  }
+out_eos:
+  {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue, "exit because we received EOS");
+    gst_mini_object_unref (obj);
+
+    return GST_FLOW_EOS;
+  }
+}
+
 static GstFlowReturn
 gst_queue_chain_buffer_or_list (GstPad * pad, GstObject * parent,
     GstMiniObject * obj, gboolean is_list)
@@ -1186,6 +1868,9 @@ gst_queue_chain_buffer_or_list (GstPad * pad, GstObject * parent,
 
   queue = GST_QUEUE_CAST (parent);
 
+  if (queue->ring)
+    return gst_queue_ring_chain (queue, obj, is_list);
+
   /* we have to lock the queue since we span threads */
   GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
   /* when we received EOS, we refuse any more data */
@@ -1264,25 +1949,7 @@ gst_queue_chain_buffer_or_list (GstPad * pad, GstObject * parent,
   }
 
   if (queue->tail_needs_discont) {
-    if (!is_list) {
-      GstBuffer *buffer = GST_BUFFER_CAST (obj);
-      GstBuffer *subbuffer = gst_buffer_make_writable (buffer);
-
-      if (subbuffer) {
-        buffer = subbuffer;
-        GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
-      } else {
-        GST_DEBUG_OBJECT (queue, "Could not mark buffer as DISCONT");
-      }
-
-      obj = GST_MINI_OBJECT_CAST (buffer);
-    } else {
-      GstBufferList *buffer_list = GST_BUFFER_LIST_CAST (obj);
-
-      buffer_list = gst_buffer_list_make_writable (buffer_list);
-      gst_buffer_list_foreach (buffer_list, discont_first_buffer, queue);
-      obj = GST_MINI_OBJECT_CAST (buffer_list);
-    }
+    obj = gst_queue_mark_discont (queue, obj, is_list);
     queue->tail_needs_discont = FALSE;
   }
 
@@ -1505,6 +2172,311 @@ out_flushing_query:
   }
 }
 
+/* called from the srcpad task without the lock */
+static void
+gst_queue_ring_query_done (GstQueue * queue, GstQuery * query, gboolean res)
+{
+  GST_QUEUE_MUTEX_LOCK (queue);
+  queue->last_query = res;
+  queue->last_handled_query = query;
+  g_cond_signal (&queue->query_handled);
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+}
+
+/* lockless version of gst_queue_leak_downstream(), called from the srcpad
+ * task */
+static void
+gst_queue_ring_leak_downstream (GstQueue * queue)
+{
+  GstMiniObject *leak;
+  gboolean is_query;
+
+  while (gst_queue_ring_is_filled (queue)
+      && (leak = gst_queue_ring_dequeue (queue, &is_query))) {
+    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+        "queue is full, leaking item %p on downstream end", leak);
+
+    if (is_query) {
+      gst_queue_ring_query_done (queue, GST_QUERY_CAST (leak), FALSE);
+    } else {
+      if (GST_IS_EVENT (leak) && GST_EVENT_IS_STICKY (leak)) {
+        GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+            "Storing sticky event %s on srcpad", GST_EVENT_TYPE_NAME (leak));
+        gst_pad_store_sticky_event (queue->srcpad, GST_EVENT_CAST (leak));
+      }
+      gst_mini_object_unref (leak);
+    }
+
+    /* last buffer needs to get a DISCONT flag */
+    queue->head_needs_discont = TRUE;
+  }
+  gst_queue_ring_signal_del (queue);
+}
+
+/* lockless version of gst_queue_push_one(), called from the srcpad task
+ * without the lock */
+static GstFlowReturn
+gst_queue_ring_push_one (GstQueue * queue)
+{
+  GstFlowReturn result = GST_FLOW_OK;
+  GstMiniObject *data;
+  gboolean is_query;
+
+  data = gst_queue_ring_dequeue (queue, &is_query);
+  if (data == NULL)
+    return GST_FLOW_OK;
+  gst_queue_ring_signal_del (queue);
+
+next:
+  if (is_query) {
+    GstQuery *query = GST_QUERY_CAST (data);
+    gboolean ret;
+
+    ret = gst_pad_peer_query (queue->srcpad, query);
+    result = g_atomic_int_get (&queue->srcresult);
+    gst_queue_ring_query_done (queue, query, result == GST_FLOW_OK && ret);
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "did query %p, return %d", query, ret);
+  } else if (GST_IS_BUFFER (data) || GST_IS_BUFFER_LIST (data)) {
+    gboolean is_list = GST_IS_BUFFER_LIST (data);
+
+    if (queue->head_needs_discont) {
+      data = gst_queue_mark_discont (queue, data, is_list);
+      queue->head_needs_discont = FALSE;
+    }
+
+    if (is_list)
+      result = gst_pad_push_list (queue->srcpad, GST_BUFFER_LIST_CAST (data));
+    else
+      result = gst_pad_push (queue->srcpad, GST_BUFFER_CAST (data));
+
+    if (g_atomic_int_get (&queue->srcresult) != GST_FLOW_OK)
+      return g_atomic_int_get (&queue->srcresult);
+
+    if (result == GST_FLOW_EOS) {
+      GST_CAT_LOG_OBJECT (queue_dataflow, queue, "got EOS from downstream");
+      /* drop everything up to the next item we can push again, see
+       * gst_queue_push_one() */
+      while ((data = gst_queue_ring_dequeue (queue, &is_query))) {
+        if (is_query) {
+          GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+              "dropping query %p because of EOS", data);
+          gst_queue_ring_query_done (queue, GST_QUERY_CAST (data), FALSE);
+        } else if (GST_IS_EVENT (data)) {
+          GstEventType type = GST_EVENT_TYPE (data);
+
+          if (type == GST_EVENT_EOS || type == GST_EVENT_SEGMENT
+              || type == GST_EVENT_STREAM_START) {
+            GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+                "pushing pushable event %s after EOS",
+                GST_EVENT_TYPE_NAME (data));
+            gst_queue_ring_signal_del (queue);
+            goto next;
+          }
+          GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+              "dropping EOS event %p", data);
+          gst_mini_object_unref (data);
+        } else {
+          GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+              "dropping EOS buffer %p", data);
+          gst_mini_object_unref (data);
+        }
+      }
+      gst_queue_ring_signal_del (queue);
+      g_atomic_int_set (&queue->unexpected, TRUE);
+      result = GST_FLOW_OK;
+    }
+  } else if (GST_IS_EVENT (data)) {
+    GstEventType type = GST_EVENT_TYPE (data);
+
+    gst_pad_push_event (queue->srcpad, GST_EVENT_CAST (data));
+
+    result = g_atomic_int_get (&queue->srcresult);
+    /* if we're EOS, return EOS so that the task pauses. */
+    if (result == GST_FLOW_OK && type == GST_EVENT_EOS) {
+      GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+          "pushed EOS event %p, return EOS", data);
+      result = GST_FLOW_EOS;
+    }
+  }
+
+  return result;
+}
+
+/* the task pool is only taken when the task is started from the stopped
+ * state, so it is checked once in the first iteration after that. Called
+ * with the queue lock when the srcpad task is not running */
+static void
+gst_queue_locked_reset_task (GstQueue * queue)
+{
+  gst_clear_object (&queue->parked_task);
+  gst_clear_object (&queue->coop_task);
+  queue->coop_checked = FALSE;
+  queue->ring_parked = FALSE;
+}
+
+/* called from the srcpad task */
+static void
+gst_queue_check_task_pool (GstQueue * queue)
+{
+  GstTask *task;
+  GstTaskPool *pool;
+
+  GST_OBJECT_LOCK (queue->srcpad);
+  task = GST_PAD_TASK (queue->srcpad);
+  if (task)
+    gst_object_ref (task);
+  GST_OBJECT_UNLOCK (queue->srcpad);
+
+  if (task) {
+    pool = gst_task_get_pool (task);
+    if (GST_IS_COOPERATIVE_TASK_POOL (pool)) {
+      GST_DEBUG_OBJECT (queue, "srcpad task runs on a cooperative task pool");
+      queue->coop_task = task;
+    } else {
+      gst_object_unref (task);
+    }
+    gst_object_unref (pool);
+  }
+  queue->coop_checked = TRUE;
+}
+
+/* On a cooperative task pool the srcpad task does not block the worker while
+ * the queue is empty, it returns and is woken up by GST_QUEUE_SIGNAL_ADD.
+ * Must be called with the queue lock. */
+static gboolean
+gst_queue_park_task (GstQueue * queue)
+{
+  if (queue->coop_task == NULL)
+    return FALSE;
+
+  STATUS (queue, queue->srcpad, "park for ADD");
+  gst_task_wait_for_wakeup (queue->coop_task);
+  gst_object_replace ((GstObject **) & queue->parked_task,
+      (GstObject *) queue->coop_task);
+
+  return TRUE;
+}
+
+/* parks the srcpad task on a cooperative task pool until the sinkpad
+ * streaming thread added an item, called from the srcpad task without the
+ * lock. There is no timeout to collect a batch on a worker, so the task is
+ * woken up for every item. Returns FALSE when the ring is not empty anymore
+ * or when flushing */
+static gboolean
+gst_queue_ring_park (GstQueue * queue)
+{
+  gboolean res = FALSE;
+
+  GST_QUEUE_MUTEX_LOCK (queue);
+  /* the sinkpad streaming thread might be waiting for a batch of free space
+   * that will not come now, e.g. because of the min thresholds */
+  GST_QUEUE_SIGNAL_DEL (queue);
+  g_atomic_int_set (&queue->waiting_add, RING_WAITING_ITEM);
+  if (queue->srcresult == GST_FLOW_OK && gst_queue_ring_is_empty (queue))
+    res = gst_queue_park_task (queue);
+  if (!res)
+    g_atomic_int_set (&queue->waiting_add, FALSE);
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+
+  return res;
+}
+
+/* lockless version of gst_queue_loop() */
+static void
+gst_queue_ring_loop (GstQueue * queue)
+{
+  GstFlowReturn ret;
+  gboolean parked = queue->ring_parked;
+
+  if (parked) {
+    GST_QUEUE_MUTEX_LOCK (queue);
+    gst_clear_object (&queue->parked_task);
+    g_atomic_int_set (&queue->waiting_add, FALSE);
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+    queue->ring_parked = FALSE;
+  }
+
+  if (g_atomic_int_get (&queue->srcresult) != GST_FLOW_OK)
+    goto out_flushing;
+
+  /* drop what was flushed on EOS */
+  gst_queue_ring_drop (queue, g_atomic_int_get (&queue->ring_flush), FALSE);
+
+  /* when woken up after parking, the underrun was already signalled */
+  if (gst_queue_ring_is_empty (queue) || parked) {
+    if (!parked) {
+      GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is empty");
+      if (!queue->silent)
+        g_signal_emit (queue, gst_queue_signals[SIGNAL_UNDERRUN], 0);
+    }
+
+    /* we recheck, the signal could have changed the thresholds */
+    while (gst_queue_ring_is_empty (queue)) {
+      if (queue->coop_task && gst_queue_ring_park (queue)) {
+        queue->ring_parked = TRUE;
+        return;
+      }
+      if (!gst_queue_ring_wait_add (queue))
+        goto out_flushing;
+    }
+
+    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is not empty");
+    if (!queue->silent) {
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_RUNNING], 0);
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_PUSHING], 0);
+    }
+    /* check again in the next iteration, the EOS might have flushed */
+    if ((gint) (g_atomic_int_get (&queue->ring_flush) -
+            g_atomic_int_get (&queue->ring_head)) > 0)
+      return;
+  }
+
+  if (queue->leaky == GST_QUEUE_LEAK_DOWNSTREAM)
+    gst_queue_ring_leak_downstream (queue);
+
+  if (g_atomic_int_compare_and_exchange (&queue->ring_leaked, TRUE, FALSE))
+    queue->head_needs_discont = TRUE;
+
+  ret = gst_queue_ring_push_one (queue);
+  if (ret != GST_FLOW_OK) {
+    GST_QUEUE_MUTEX_LOCK (queue);
+    if (queue->srcresult == GST_FLOW_OK)
+      queue->srcresult = ret;
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+    goto out_flushing;
+  }
+
+  return;
+
+  /* ERRORS */
+out_flushing:
+  {
+    gboolean eos;
+
+    GST_QUEUE_MUTEX_LOCK (queue);
+    eos = queue->eos;
+    ret = queue->srcresult;
+
+    gst_pad_pause_task (queue->srcpad);
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "pause task, reason:  %s", gst_flow_get_name (ret));
+    if (ret == GST_FLOW_FLUSHING)
+      gst_queue_ring_drop (queue, g_atomic_int_get (&queue->ring_tail), FALSE);
+    GST_QUEUE_SIGNAL_DEL (queue);
+    queue->last_query = FALSE;
+    g_cond_signal (&queue->query_handled);
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+    /* let app know about us giving up if upstream is not expected to do so */
+    /* EOS is already taken care of elsewhere */
+    if (eos && (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS)) {
+      GST_ELEMENT_FLOW_ERROR (queue, ret);
+      gst_pad_push_event (queue->srcpad, gst_event_new_eos ());
+    }
+    return;
+  }
+}
+
 static void
 gst_queue_loop (GstPad * pad)
 {
@@ -1513,21 +2485,35 @@ gst_queue_loop (GstPad * pad)
 
   queue = (GstQueue *) GST_PAD_PARENT (pad);
 
+  if (G_UNLIKELY (!queue->coop_checked))
+    gst_queue_check_task_pool (queue);
+
+  if (queue->ring) {
+    gst_queue_ring_loop (queue);
+    return;
+  }
+
   /* have to lock for thread-safety */
   GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
 
-  while (gst_queue_is_empty (queue)) {
-    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is empty");
-    if (!queue->silent) {
-      GST_QUEUE_MUTEX_UNLOCK (queue);
-      g_signal_emit (queue, gst_queue_signals[SIGNAL_UNDERRUN], 0);
-      GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
+  /* when woken up after parking, the underrun was already signalled */
+  while (gst_queue_is_empty (queue) || queue->parked_task) {
+    if (!queue->parked_task) {
+      GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is empty");
+      if (!queue->silent) {
+        GST_QUEUE_MUTEX_UNLOCK (queue);
+        g_signal_emit (queue, gst_queue_signals[SIGNAL_UNDERRUN], 0);
+        GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
+      }
     }
 
     /* we recheck, the signal could have changed the thresholds */
     while (gst_queue_is_empty (queue)) {
+      if (gst_queue_park_task (queue))
+        goto parked;
       GST_QUEUE_WAIT_ADD_CHECK (queue, out_flushing);
     }
+    gst_clear_object (&queue->parked_task);
 
     GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is not empty");
     if (!queue->silent) {
@@ -1547,12 +2533,18 @@ gst_queue_loop (GstPad * pad)
 
   return;
 
+parked:
+  {
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+    return;
+  }
   /* ERRORS */
 out_flushing:
   {
     gboolean eos = queue->eos;
     GstFlowReturn ret = queue->srcresult;
 
+    gst_clear_object (&queue->parked_task);
     gst_pad_pause_task (queue->srcpad);
     GST_CAT_LOG_OBJECT (queue_dataflow, queue,
         "pause task, reason:  %s", gst_flow_get_name (ret));
@@ -1645,7 +2637,7 @@ gst_queue_handle_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
             peer_pos = 0;
           break;
         case GST_FORMAT_TIME:
-          peer_pos -= queue->cur_level.time;
+          peer_pos -= gst_queue_get_level_time (queue);
           if (peer_pos < 0)     /* Clamp result to 0 */
             peer_pos = 0;
           break;
@@ -1721,7 +2713,11 @@ gst_queue_sink_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
         /* step 2, wait until streaming thread stopped and flush queue */
         GST_PAD_STREAM_LOCK (pad);
         GST_QUEUE_MUTEX_LOCK (queue);
-        gst_queue_locked_flush (queue, TRUE);
+        /* in lockless mode only the srcpad task may dequeue while it runs */
+        if (queue->ring && gst_pad_is_active (queue->srcpad))
+          gst_queue_ring_mark_flush (queue);
+        else
+          gst_queue_locked_flush (queue, TRUE);
         GST_QUEUE_MUTEX_UNLOCK (queue);
         GST_PAD_STREAM_UNLOCK (pad);
       }
@@ -1750,6 +2746,10 @@ gst_queue_src_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
         queue->srcresult = GST_FLOW_OK;
         queue->eos = FALSE;
         queue->unexpected = FALSE;
+        /* the ring can only be replaced while no data is flowing */
+        if (!gst_pad_is_active (queue->sinkpad))
+          gst_queue_ring_configure (queue);
+        gst_queue_locked_reset_task (queue);
         result =
             gst_pad_start_task (pad, (GstTaskFunction) gst_queue_loop, pad,
             NULL);
@@ -1766,7 +2766,18 @@ gst_queue_src_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
         result = gst_pad_stop_task (pad);
 
         GST_QUEUE_MUTEX_LOCK (queue);
-        gst_queue_locked_flush (queue, FALSE);
+        gst_queue_locked_reset_task (queue);
+        if (queue->ring) {
+          /* the sinkpad streaming thread might still be running, only drop
+           * the items and leave its state alone */
+          gst_queue_ring_drop (queue, g_atomic_int_get (&queue->ring_tail),
+              FALSE);
+          queue->last_query = FALSE;
+          g_cond_signal (&queue->query_handled);
+          GST_QUEUE_SIGNAL_DEL (queue);
+        } else {
+          gst_queue_locked_flush (queue, FALSE);
+        }
         GST_QUEUE_MUTEX_UNLOCK (queue);
       }
       break;
@@ -1780,7 +2791,8 @@ gst_queue_src_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
 static void
 queue_capacity_change (GstQueue * queue)
 {
-  if (queue->leaky == GST_QUEUE_LEAK_DOWNSTREAM) {
+  /* in lockless mode the srcpad task leaks */
+  if (queue->leaky == GST_QUEUE_LEAK_DOWNSTREAM && !queue->ring) {
     gst_queue_leak_downstream (queue);
   }
 
@@ -1844,6 +2856,10 @@ gst_queue_set_property (GObject * object,
     case PROP_FLUSH_ON_EOS:
       queue->flush_on_eos = g_value_get_boolean (value);
       break;
+    case PROP_LOCKLESS:
+      /* takes effect when the pads are activated the next time */
+      queue->lockless = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1868,7 +2884,7 @@ gst_queue_get_property (GObject * object,
       g_value_set_uint (value, queue->cur_level.buffers);
       break;
     case PROP_CUR_LEVEL_TIME:
-      g_value_set_uint64 (value, queue->cur_level.time);
+      g_value_set_uint64 (value, gst_queue_get_level_time (queue));
       break;
     case PROP_MAX_SIZE_BYTES:
       g_value_set_uint (value, queue->max_size.bytes);
@@ -1897,6 +2913,9 @@ gst_queue_get_property (GObject * object,
     case PROP_FLUSH_ON_EOS:
       g_value_set_boolean (value, queue->flush_on_eos);
       break;
+    case PROP_LOCKLESS:
+      g_value_set_boolean (value, queue->lockless);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -124,6 +124,10 @@ struct _GstQueue {
   GCond item_add;      /* signals buffers now available for reading */
   gboolean waiting_del;
   GCond item_del;      /* signals space now available for writing */
+  GstTask *parked_task; /* srcpad task waiting on a cooperative task pool */
+  GstTask *coop_task;   /* srcpad task if it runs on a cooperative task pool */
+  gboolean coop_checked; /* coop_task is valid for the current task */
+  gboolean ring_parked; /* srcpad task was parked in lockless mode */
 
   gboolean head_needs_discont, tail_needs_discont;
   gboolean push_newsegment;
@@ -138,6 +142,21 @@ struct _GstQueue {
   GstQuery *last_handled_query;
 
   gboolean flush_on_eos; /* flush on EOS */
+
+  /* lockless mode: a single producer, single consumer ring of ring_size
+   * GstQueueItem, allocated when the srcpad is activated */
+  gboolean lockless;
+  gpointer ring;
+  guint ring_size;
+  guint ring_head;              /* advanced by the srcpad task, and by the
+                                 * sinkpad thread when leaking downstream */
+  guint ring_tail;              /* written by the sinkpad streaming thread only */
+  guint ring_flush;             /* the srcpad task drops items before this */
+  guint ring_park_head;         /* head when the sinkpad thread started waiting */
+  guint ring_spin_add;          /* adaptive spin counts before waiting */
+  guint ring_spin_del;
+  guint ring_batch;             /* adaptive number of items per ADD wakeup */
+  gint ring_leaked;             /* the sinkpad thread leaked old items */
 };
 
 struct _GstQueueClass {
@@ -0,0 +1,153 @@
+/* GStreamer
+ *
+ * gstcapscache.c: tracer for the caps result cache
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:tracer-capscache
+ * @short_description: log hit rates of the caps result cache
+ *
+ * A tracing module that counts how often the results of caps intersections
+ * and subset checks were found in the caps result cache. The totals per
+ * operation are logged when the tracer is destroyed, that is on gst_deinit().
+ *
+ * ```
+ * $ GST_TRACERS=capscache GST_DEBUG=GST_TRACER:7 gst-play-1.0 file.mkv
+ * ...
+ * caps-cache, operation=(string)can-intersect, hits=(guint64)1520, misses=(guint64)96, hit-rate=(double)0.9405940594059405;
+ * ```
+ *
+ * Since: 1.24
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstcapscache.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_caps_cache_debug);
+#define GST_CAT_DEFAULT gst_caps_cache_debug
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_caps_cache_debug, "capscache", 0, "capscache tracer");
+#define gst_caps_cache_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstCapsCacheTracer, gst_caps_cache_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+static GstTracerRecord *tr_caps_cache;
+
+typedef struct
+{
+  guint64 hits;
+  guint64 misses;
+} GstCapsCacheStats;
+
+static void
+do_caps_cache_lookup (GstCapsCacheTracer * self, GstClockTime ts,
+    const gchar * operation, gboolean hit)
+{
+  GstCapsCacheStats *stats;
+
+  g_mutex_lock (&self->lock);
+  stats = g_hash_table_lookup (self->stats, operation);
+  if (!stats) {
+    stats = g_new0 (GstCapsCacheStats, 1);
+    g_hash_table_insert (self->stats, g_strdup (operation), stats);
+  }
+  if (hit)
+    stats->hits++;
+  else
+    stats->misses++;
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+gst_caps_cache_tracer_finalize (GObject * object)
+{
+  GstCapsCacheTracer *self = GST_CAPS_CACHE_TRACER (object);
+  GHashTableIter iter;
+  const gchar *operation;
+  GstCapsCacheStats *stats;
+
+  g_hash_table_iter_init (&iter, self->stats);
+  while (g_hash_table_iter_next (&iter, (gpointer *) & operation,
+          (gpointer *) & stats)) {
+    guint64 total = stats->hits + stats->misses;
+
+    gst_tracer_record_log (tr_caps_cache, operation, stats->hits,
+        stats->misses, total ? (gdouble) stats->hits / total : 0.0);
+  }
+
+  g_hash_table_unref (self->stats);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_caps_cache_tracer_class_init (GstCapsCacheTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gst_caps_cache_tracer_finalize;
+
+  /* announce trace formats */
+  /* *INDENT-OFF* */
+  tr_caps_cache = gst_tracer_record_new ("caps-cache.class",
+      "operation", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING, "caps operation",
+          NULL),
+      "hits", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "results found in the cache",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "misses", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "results that had to be computed",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "hit-rate", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_DOUBLE,
+          "description", G_TYPE_STRING, "fraction of lookups that were hits",
+          "min", G_TYPE_DOUBLE, 0.0,
+          "max", G_TYPE_DOUBLE, 1.0,
+          NULL),
+      NULL);
+  /* *INDENT-ON* */
+
+  GST_OBJECT_FLAG_SET (tr_caps_cache, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_caps_cache_tracer_init (GstCapsCacheTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  g_mutex_init (&self->lock);
+  self->stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      g_free);
+
+  gst_tracing_register_hook (tracer, "caps-cache-lookup",
+      G_CALLBACK (do_caps_cache_lookup));
+}
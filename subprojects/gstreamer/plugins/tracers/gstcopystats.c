@@ -0,0 +1,452 @@
+/* GStreamer
+ *
+ * gstcopystats.c: tracer for memory copies and allocations
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:tracer-copystats
+ * @short_description: log memory copies and allocations per element and pad
+ *
+ * A tracing module that counts the memory copies, merges and allocations done
+ * by each element and sink pad, to find the copies that make a pipeline
+ * slower than it needs to be.
+ *
+ * - 'copies' are calls to gst_memory_copy(), for example for deep buffer
+ *   copies or when memory that is shared or read-only is mapped for writing.
+ * - 'merges' are copies of several memory blocks of a buffer into one, when
+ *   they are mapped at once or when the buffer has too many of them.
+ * - 'allocs' are memory allocations with gst_allocator_alloc() that are not
+ *   done by a buffer pool.
+ *
+ * The work is attributed to the sink pad whose chain function is running and
+ * its element, or to the source pad that pushed last from the loop function
+ * of the thread. 'received' is the number of bytes of the buffers that were
+ * passed to the chain functions.
+ *
+ * The totals are logged when the tracer is destroyed. Elements that copied
+ * more bytes than they received are marked as 'excessive' and also reported
+ * with a warning.
+ *
+ * ```
+ * $ GST_TRACERS=copystats GST_DEBUG=GST_TRACER:7 gst-launch-1.0 videotestsrc num-buffers=100 ! tee ! videoflip method=clockwise ! fakesink
+ * ...
+ * element-copy-stats, element=(string)/GstPipeline:pipeline0/GstVideoFlip:videoflip0, received=(guint64)11520000, copies=(guint64)0, copy-bytes=(guint64)0, merges=(guint64)0, merge-bytes=(guint64)0, allocs=(guint64)0, alloc-bytes=(guint64)0, copy-ratio=(double)0, excessive=(boolean)false;
+ * ```
+ *
+ * Since: 1.24
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstcopystats.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_copy_stats_debug);
+#define GST_CAT_DEFAULT gst_copy_stats_debug
+
+static GQuark data_quark;
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_copy_stats_debug, "copystats", 0, "copystats tracer"); \
+    data_quark = g_quark_from_static_string ("gstcopystats:data");
+#define gst_copy_stats_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstCopyStatsTracer, gst_copy_stats_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+/* deepest nesting of chain functions per thread that is tracked */
+#define MAX_DEPTH 64
+
+static GstTracerRecord *tr_element_copy_stats;
+static GstTracerRecord *tr_pad_copy_stats;
+
+/* refcounted, owned by the tracer and the element or pad, the counters are
+ * protected by the tracer lock */
+typedef struct
+{
+  gchar *name;
+
+  guint64 received;
+  guint64 copies;
+  guint64 copy_bytes;
+  guint64 merges;
+  guint64 merge_bytes;
+  guint64 allocs;
+  guint64 alloc_bytes;
+} GstCopyStats;
+
+typedef struct
+{
+  GstCopyStats *pad;
+  GstCopyStats *element;
+} GstCopyFrame;
+
+typedef struct
+{
+  /* the sink pads whose chain functions are running */
+  GstCopyFrame frames[MAX_DEPTH];
+  guint depth;
+
+  /* the source pad that pushed last from the loop function */
+  GstCopyFrame loop;
+} GstCopyThread;
+
+static GPrivate thread_key = G_PRIVATE_INIT (g_free);
+
+/* data helpers */
+
+static GstCopyThread *
+get_thread (void)
+{
+  GstCopyThread *thread = g_private_get (&thread_key);
+
+  if (G_UNLIKELY (thread == NULL)) {
+    thread = g_new0 (GstCopyThread, 1);
+    g_private_set (&thread_key, thread);
+  }
+  return thread;
+}
+
+static void
+copy_stats_clear (GstCopyStats * stats)
+{
+  g_free (stats->name);
+}
+
+static void
+copy_stats_unref (gpointer data)
+{
+  g_atomic_rc_box_release_full (data, (GDestroyNotify) copy_stats_clear);
+}
+
+/*
+ * Get the element/bin owning the pad.
+ *
+ * in: a normal pad
+ * out: the element
+ *
+ * in: a proxy pad
+ * out: the element that contains the peer of the proxy
+ *
+ * in: a ghost pad
+ * out: the bin owning the ghostpad
+ */
+static GstElement *
+get_real_pad_parent (GstPad * pad)
+{
+  GstObject *parent;
+
+  if (!pad)
+    return NULL;
+
+  parent = GST_OBJECT_PARENT (pad);
+
+  /* if parent of pad is a ghost-pad, then pad is a proxy_pad */
+  if (parent && GST_IS_GHOST_PAD (parent)) {
+    pad = GST_PAD_CAST (parent);
+    parent = GST_OBJECT_PARENT (pad);
+  }
+  return GST_ELEMENT_CAST (parent);
+}
+
+static GstCopyStats *
+get_stats (GstCopyStatsTracer * self, GstObject * object, GPtrArray * array)
+{
+  GstCopyStats *stats;
+
+  if (!object)
+    return NULL;
+
+  if ((stats = g_object_get_qdata ((GObject *) object, data_quark)))
+    return stats;
+
+  g_mutex_lock (&self->lock);
+  if (!(stats = g_object_get_qdata ((GObject *) object, data_quark))) {
+    stats = g_atomic_rc_box_new0 (GstCopyStats);
+    stats->name = gst_object_get_path_string (object);
+    g_ptr_array_add (array, stats);
+    g_object_set_qdata_full ((GObject *) object, data_quark,
+        g_atomic_rc_box_acquire (stats), copy_stats_unref);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return stats;
+}
+
+static void
+fill_frame (GstCopyStatsTracer * self, GstCopyFrame * frame, GstPad * pad)
+{
+  frame->pad = get_stats (self, GST_OBJECT_CAST (pad), self->pad_stats);
+  frame->element = get_stats (self,
+      GST_OBJECT_CAST (get_real_pad_parent (pad)), self->element_stats);
+}
+
+/* the pad and element that are running in this thread */
+static GstCopyFrame *
+get_current_frame (void)
+{
+  GstCopyThread *thread = get_thread ();
+
+  if (thread->depth > 0)
+    return &thread->frames[MIN (thread->depth, MAX_DEPTH) - 1];
+
+  return &thread->loop;
+}
+
+#define ADD_TO_FRAME(frame,field,value) G_STMT_START { \
+  if ((frame)->pad)                                     \
+    (frame)->pad->field += (value);                     \
+  if ((frame)->element)                                 \
+    (frame)->element->field += (value);                 \
+} G_STMT_END
+
+static void
+log_copy_stats (GstTracerRecord * record, GstCopyStats * stats)
+{
+  guint64 copied = stats->copy_bytes + stats->merge_bytes;
+  gdouble ratio = stats->received ? (gdouble) copied / stats->received : 0.0;
+  gboolean excessive = copied > stats->received;
+
+  if (stats->received == 0 && stats->copies == 0 && stats->merges == 0 &&
+      stats->allocs == 0)
+    return;
+
+  if (record == tr_pad_copy_stats) {
+    gst_tracer_record_log (record, stats->name, stats->received,
+        stats->copies, stats->copy_bytes, stats->merges, stats->merge_bytes,
+        stats->allocs, stats->alloc_bytes, ratio);
+    return;
+  }
+
+  gst_tracer_record_log (record, stats->name, stats->received, stats->copies,
+      stats->copy_bytes, stats->merges, stats->merge_bytes, stats->allocs,
+      stats->alloc_bytes, ratio, excessive);
+
+  if (excessive) {
+    GST_WARNING ("%s copied %" G_GUINT64_FORMAT " bytes but received only %"
+        G_GUINT64_FORMAT " bytes", stats->name, copied, stats->received);
+  }
+}
+
+/* hooks */
+
+static void
+do_chain_enter (GstCopyStatsTracer * self, GstPad * pad, gsize size)
+{
+  GstCopyThread *thread = get_thread ();
+  GstCopyFrame frame;
+
+  fill_frame (self, &frame, pad);
+
+  g_mutex_lock (&self->lock);
+  ADD_TO_FRAME (&frame, received, size);
+  g_mutex_unlock (&self->lock);
+
+  if (thread->depth < MAX_DEPTH)
+    thread->frames[thread->depth] = frame;
+  thread->depth++;
+}
+
+static void
+do_chain_pre (GstCopyStatsTracer * self, guint64 ts, GstPad * pad,
+    GstBuffer * buffer)
+{
+  do_chain_enter (self, pad, gst_buffer_get_size (buffer));
+}
+
+static void
+do_chain_list_pre (GstCopyStatsTracer * self, guint64 ts, GstPad * pad,
+    GstBufferList * list)
+{
+  do_chain_enter (self, pad, gst_buffer_list_calculate_size (list));
+}
+
+static void
+do_chain_post (GstCopyStatsTracer * self, guint64 ts, GstPad * pad)
+{
+  GstCopyThread *thread = get_thread ();
+
+  /* the tracer was created while the thread was in a chain function */
+  if (thread->depth > 0)
+    thread->depth--;
+}
+
+static void
+do_push_pre (GstCopyStatsTracer * self, guint64 ts, GstPad * pad)
+{
+  GstCopyThread *thread = get_thread ();
+
+  if (thread->depth == 0)
+    fill_frame (self, &thread->loop, pad);
+}
+
+static void
+do_memory_alloc (GstCopyStatsTracer * self, guint64 ts,
+    GstAllocator * allocator, GstMemory * memory, GstBufferPool * pool)
+{
+  GstCopyFrame *frame;
+
+  if (pool)
+    return;
+
+  frame = get_current_frame ();
+
+  g_mutex_lock (&self->lock);
+  ADD_TO_FRAME (frame, allocs, 1);
+  ADD_TO_FRAME (frame, alloc_bytes, memory->size);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+do_memory_copy (GstCopyStatsTracer * self, guint64 ts, GstMemory * memory,
+    GstMemory * copy)
+{
+  GstCopyFrame *frame = get_current_frame ();
+
+  GST_LOG ("copied %" G_GSIZE_FORMAT " bytes of memory %p", copy->size,
+      memory);
+
+  g_mutex_lock (&self->lock);
+  ADD_TO_FRAME (frame, copies, 1);
+  ADD_TO_FRAME (frame, copy_bytes, copy->size);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+do_memory_merge (GstCopyStatsTracer * self, guint64 ts, GstBuffer * buffer,
+    guint n_memory, GstMemory * merged)
+{
+  GstCopyFrame *frame = get_current_frame ();
+
+  GST_LOG ("merged %u memory blocks of buffer %p into %" G_GSIZE_FORMAT
+      " bytes", n_memory, buffer, merged->size);
+
+  g_mutex_lock (&self->lock);
+  ADD_TO_FRAME (frame, merges, 1);
+  ADD_TO_FRAME (frame, merge_bytes, merged->size);
+  g_mutex_unlock (&self->lock);
+}
+
+/* tracer class */
+
+static void
+gst_copy_stats_tracer_finalize (GObject * object)
+{
+  GstCopyStatsTracer *self = GST_COPY_STATS_TRACER (object);
+  guint i;
+
+  for (i = 0; i < self->element_stats->len; i++)
+    log_copy_stats (tr_element_copy_stats,
+        g_ptr_array_index (self->element_stats, i));
+  for (i = 0; i < self->pad_stats->len; i++)
+    log_copy_stats (tr_pad_copy_stats, g_ptr_array_index (self->pad_stats, i));
+
+  g_ptr_array_unref (self->element_stats);
+  g_ptr_array_unref (self->pad_stats);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* *INDENT-OFF* */
+#define COUNTER_FIELD(name, desc) \
+    name, GST_TYPE_STRUCTURE, gst_structure_new ("value", \
+        "type", G_TYPE_GTYPE, G_TYPE_UINT64, \
+        "description", G_TYPE_STRING, desc, \
+        "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED, \
+        "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0), \
+        "max", G_TYPE_UINT64, G_MAXUINT64, \
+        NULL)
+
+#define COUNTER_FIELDS \
+    COUNTER_FIELD ("received", "bytes passed to the chain functions"), \
+    COUNTER_FIELD ("copies", "memory copies"), \
+    COUNTER_FIELD ("copy-bytes", "bytes copied"), \
+    COUNTER_FIELD ("merges", "merges of several memory blocks"), \
+    COUNTER_FIELD ("merge-bytes", "bytes copied for merges"), \
+    COUNTER_FIELD ("allocs", "memory allocations outside of buffer pools"), \
+    COUNTER_FIELD ("alloc-bytes", "bytes allocated outside of buffer pools"), \
+    "copy-ratio", GST_TYPE_STRUCTURE, gst_structure_new ("value", \
+        "type", G_TYPE_GTYPE, G_TYPE_DOUBLE, \
+        "description", G_TYPE_STRING, "copied bytes per received byte", \
+        "min", G_TYPE_DOUBLE, 0.0, \
+        "max", G_TYPE_DOUBLE, G_MAXDOUBLE, \
+        NULL)
+/* *INDENT-ON* */
+
+static void
+gst_copy_stats_tracer_class_init (GstCopyStatsTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gst_copy_stats_tracer_finalize;
+
+  /* announce trace formats */
+  /* *INDENT-OFF* */
+  tr_element_copy_stats = gst_tracer_record_new ("element-copy-stats.class",
+      "element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      COUNTER_FIELDS,
+      "excessive", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_BOOLEAN,
+          "description", G_TYPE_STRING,
+              "whether the element copied more bytes than it received",
+          NULL),
+      NULL);
+  tr_pad_copy_stats = gst_tracer_record_new ("pad-copy-stats.class",
+      "pad", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      COUNTER_FIELDS,
+      NULL);
+  /* *INDENT-ON* */
+
+  GST_OBJECT_FLAG_SET (tr_element_copy_stats, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+  GST_OBJECT_FLAG_SET (tr_pad_copy_stats, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_copy_stats_tracer_init (GstCopyStatsTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  g_mutex_init (&self->lock);
+  self->element_stats = g_ptr_array_new_with_free_func (copy_stats_unref);
+  self->pad_stats = g_ptr_array_new_with_free_func (copy_stats_unref);
+
+  gst_tracing_register_hook (tracer, "pad-chain-pre",
+      G_CALLBACK (do_chain_pre));
+  gst_tracing_register_hook (tracer, "pad-chain-post",
+      G_CALLBACK (do_chain_post));
+  gst_tracing_register_hook (tracer, "pad-chain-list-pre",
+      G_CALLBACK (do_chain_list_pre));
+  gst_tracing_register_hook (tracer, "pad-chain-list-post",
+      G_CALLBACK (do_chain_post));
+  gst_tracing_register_hook (tracer, "pad-push-pre", G_CALLBACK (do_push_pre));
+  gst_tracing_register_hook (tracer, "pad-push-list-pre",
+      G_CALLBACK (do_push_pre));
+  gst_tracing_register_hook (tracer, "memory-alloc",
+      G_CALLBACK (do_memory_alloc));
+  gst_tracing_register_hook (tracer, "memory-copy",
+      G_CALLBACK (do_memory_copy));
+  gst_tracing_register_hook (tracer, "memory-merge",
+      G_CALLBACK (do_memory_merge));
+}
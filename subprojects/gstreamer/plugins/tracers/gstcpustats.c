@@ -0,0 +1,507 @@
+/* GStreamer
+ *
+ * gstcpustats.c: tracer for the cpu time spent in each element
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:tracer-cpustats
+ * @short_description: log the cpu time spent in each element
+ *
+ * A tracing module that measures the cpu time of the streaming threads with
+ * `CLOCK_THREAD_CPUTIME_ID` and attributes it to the element that is running.
+ *
+ * Every thread keeps a stack of the elements it is in. Pushing a buffer,
+ * buffer list or event enters the element of the peer pad, pulling a range
+ * enters the upstream element, and the element is left again when the call
+ * returns. The cpu time between two of these points is the 'self' time of the
+ * element on the top of the stack, the 'inclusive' time of an element also
+ * contains the time of the elements it called. The time a thread spends
+ * between two pushes of the same element, for example in the loop function
+ * of a source or queue, is accounted to that element as well.
+ *
+ * Every 'report-interval' milliseconds (default 1000) the times of the last
+ * interval are logged for every element that used the cpu, and the totals
+ * when the tracer is destroyed. 'self-load' is the self time in per mille of
+ * one cpu core. Setting 'report-interval' to 0 only logs the totals.
+ *
+ * ```
+ * $ GST_TRACERS="cpustats(report-interval=5000)" GST_DEBUG=GST_TRACER:7 gst-launch-1.0 videotestsrc num-buffers=300 ! videoconvert ! x264enc ! fakesink
+ * ...
+ * element-cpu, element=(string)/GstPipeline:pipeline0/GstX264Enc:x264enc0, self=(guint64)4391262310, inclusive=(guint64)4391503815, self-load=(uint)878, final=(boolean)false, ts=(guint64)5006219380;
+ * ```
+ *
+ * Bins show up with the time spent in their ghost pads as self time, and the
+ * time of their children that were entered through the ghost pads as
+ * inclusive time. Work done outside of pushing, pulling or the loop
+ * functions, such as state changes, is not accounted.
+ *
+ * Since: 1.24
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <errno.h>
+#include <time.h>
+
+#include "gstcpustats.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_cpu_stats_debug);
+#define GST_CAT_DEFAULT gst_cpu_stats_debug
+
+static GQuark data_quark;
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_cpu_stats_debug, "cpustats", 0, "cpustats tracer"); \
+    data_quark = g_quark_from_static_string ("gstcpustats:data");
+#define gst_cpu_stats_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstCpuStatsTracer, gst_cpu_stats_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+/* deepest nesting of elements per thread that is tracked */
+#define MAX_DEPTH 64
+
+static GstTracerRecord *tr_element_cpu;
+
+/* refcounted, owned by the tracer and the element */
+typedef struct
+{
+  gchar *name;
+
+  /* since the last report, protected by the tracer lock */
+  GstClockTime self;
+  GstClockTime inclusive;
+  /* since the start */
+  GstClockTime total_self;
+  GstClockTime total_inclusive;
+} GstCpuStats;
+
+typedef struct
+{
+  GstElement *element;
+  GstCpuStats *stats;
+  /* thread cpu time when the element was entered */
+  GstClockTime entered;
+} GstCpuFrame;
+
+typedef struct
+{
+  /* frames[0] is the element that started the outermost push or pull */
+  GstCpuFrame frames[MAX_DEPTH];
+  guint depth;
+
+  /* thread cpu time of the last accounting */
+  GstClockTime last;
+  /* the element that was on the bottom of the stack when it got empty */
+  GstElement *idle_element;
+  GstCpuStats *idle_stats;
+} GstCpuThread;
+
+static GPrivate thread_key = G_PRIVATE_INIT (g_free);
+
+/* data helpers */
+
+static GstClockTime
+get_thread_cpu_time (void)
+{
+  struct timespec now;
+
+  if (G_UNLIKELY (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &now))) {
+    GST_WARNING ("clock_gettime (CLOCK_THREAD_CPUTIME_ID,...) failed: %s",
+        g_strerror (errno));
+    return 0;
+  }
+  return GST_TIMESPEC_TO_TIME (now);
+}
+
+static GstCpuThread *
+get_thread (void)
+{
+  GstCpuThread *thread = g_private_get (&thread_key);
+
+  if (G_UNLIKELY (thread == NULL)) {
+    thread = g_new0 (GstCpuThread, 1);
+    g_private_set (&thread_key, thread);
+  }
+  return thread;
+}
+
+static void
+cpu_stats_clear (GstCpuStats * stats)
+{
+  g_free (stats->name);
+}
+
+static void
+cpu_stats_unref (gpointer data)
+{
+  g_atomic_rc_box_release_full (data, (GDestroyNotify) cpu_stats_clear);
+}
+
+/*
+ * Get the element/bin owning the pad.
+ *
+ * in: a normal pad
+ * out: the element
+ *
+ * in: a proxy pad
+ * out: the element that contains the peer of the proxy
+ *
+ * in: a ghost pad
+ * out: the bin owning the ghostpad
+ */
+static GstElement *
+get_real_pad_parent (GstPad * pad)
+{
+  GstObject *parent;
+
+  if (!pad)
+    return NULL;
+
+  parent = GST_OBJECT_PARENT (pad);
+
+  /* if parent of pad is a ghost-pad, then pad is a proxy_pad */
+  if (parent && GST_IS_GHOST_PAD (parent)) {
+    pad = GST_PAD_CAST (parent);
+    parent = GST_OBJECT_PARENT (pad);
+  }
+  return GST_ELEMENT_CAST (parent);
+}
+
+static GstCpuStats *
+get_element_stats (GstCpuStatsTracer * self, GstElement * element)
+{
+  GstCpuStats *stats;
+
+  /* unlinked pads */
+  if (!element)
+    return NULL;
+
+  if ((stats = g_object_get_qdata ((GObject *) element, data_quark)))
+    return stats;
+
+  g_mutex_lock (&self->lock);
+  if (!(stats = g_object_get_qdata ((GObject *) element, data_quark))) {
+    stats = g_atomic_rc_box_new0 (GstCpuStats);
+    stats->name = gst_object_get_path_string (GST_OBJECT_CAST (element));
+    g_ptr_array_add (self->stats, stats);
+    g_object_set_qdata_full ((GObject *) element, data_quark,
+        g_atomic_rc_box_acquire (stats), cpu_stats_unref);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return stats;
+}
+
+/* call with the lock */
+static void
+log_element_cpu (GstCpuStats * stats, GstClockTime self_time,
+    GstClockTime inclusive, GstClockTime elapsed, gboolean final,
+    GstClockTime ts)
+{
+  guint64 load;
+
+  load = elapsed ? gst_util_uint64_scale (self_time, 1000, elapsed) : 0;
+
+  gst_tracer_record_log (tr_element_cpu, stats->name, self_time, inclusive,
+      (guint) MIN (load, G_MAXUINT), final, ts);
+}
+
+/* call with the lock */
+static void
+report_interval (GstCpuStatsTracer * self, GstClockTime ts)
+{
+  guint i;
+
+  for (i = 0; i < self->stats->len; i++) {
+    GstCpuStats *stats = g_ptr_array_index (self->stats, i);
+
+    if (stats->self == 0 && stats->inclusive == 0)
+      continue;
+
+    log_element_cpu (stats, stats->self, stats->inclusive,
+        ts - self->last_report, FALSE, ts);
+    stats->self = stats->inclusive = 0;
+  }
+  self->last_report = ts;
+}
+
+static void
+add_times (GstCpuStatsTracer * self, GstCpuStats * stats,
+    GstClockTime self_time, GstClockTime inclusive, GstClockTime ts)
+{
+  if (!stats)
+    return;
+
+  g_mutex_lock (&self->lock);
+  stats->self += self_time;
+  stats->total_self += self_time;
+  stats->inclusive += inclusive;
+  stats->total_inclusive += inclusive;
+
+  if (self->report_interval > 0 && ts >= self->last_report +
+      self->report_interval)
+    report_interval (self, ts);
+  g_mutex_unlock (&self->lock);
+}
+
+/* accounts the cpu time since the last call to the element on the top of the
+ * stack. The outermost element has no frame above it that would add its time
+ * when leaving, so its self time is also its inclusive time. */
+static void
+account (GstCpuStatsTracer * self, GstCpuThread * thread, GstClockTime now,
+    GstClockTime ts)
+{
+  GstClockTime delta = now - thread->last;
+  GstCpuFrame *top;
+
+  thread->last = now;
+  if (thread->depth == 0 || delta == 0)
+    return;
+
+  top = &thread->frames[MIN (thread->depth, MAX_DEPTH) - 1];
+  add_times (self, top->stats, delta, thread->depth == 1 ? delta : 0, ts);
+}
+
+static void
+enter (GstCpuStatsTracer * self, GstPad * this_pad, GstPad * that_pad,
+    guint64 ts)
+{
+  GstCpuThread *thread = get_thread ();
+  GstElement *this_elem = get_real_pad_parent (this_pad);
+  GstElement *that_elem = get_real_pad_parent (that_pad);
+  GstClockTime now = get_thread_cpu_time ();
+
+  /* the frames are pushed even without elements, to stay in sync with the
+   * post hooks */
+  if (thread->depth == 0) {
+    /* the time since the last push of the same element is spent in its loop
+     * function, anything else in the thread is not ours to account */
+    if (thread->idle_element == this_elem) {
+      GstClockTime delta = now - thread->last;
+
+      add_times (self, thread->idle_stats, delta, delta, ts);
+    }
+    thread->idle_element = NULL;
+    thread->idle_stats = NULL;
+    thread->last = now;
+
+    thread->frames[0].element = this_elem;
+    thread->frames[0].stats = get_element_stats (self, this_elem);
+    thread->frames[0].entered = now;
+    thread->depth = 1;
+  } else {
+    account (self, thread, now, ts);
+  }
+
+  if (thread->depth < MAX_DEPTH) {
+    GstCpuFrame *frame = &thread->frames[thread->depth];
+
+    frame->element = that_elem;
+    frame->stats = get_element_stats (self, that_elem);
+    frame->entered = now;
+  }
+  thread->depth++;
+}
+
+static void
+leave (GstCpuStatsTracer * self, guint64 ts)
+{
+  GstCpuThread *thread = get_thread ();
+  GstClockTime now;
+
+  /* the tracer was created while the thread was in a push */
+  if (thread->depth == 0)
+    return;
+
+  now = get_thread_cpu_time ();
+  account (self, thread, now, ts);
+
+  thread->depth--;
+  if (thread->depth < MAX_DEPTH) {
+    GstCpuFrame *frame = &thread->frames[thread->depth];
+    GstClockTime inclusive = now - frame->entered;
+
+    add_times (self, frame->stats, 0, inclusive, ts);
+    /* the outermost element only gets the inclusive time of its callees */
+    if (thread->depth == 1)
+      add_times (self, thread->frames[0].stats, 0, inclusive, ts);
+  }
+
+  if (thread->depth == 1) {
+    thread->idle_element = thread->frames[0].element;
+    thread->idle_stats = thread->frames[0].stats;
+    thread->depth = 0;
+  }
+}
+
+/* hooks */
+
+static void
+do_push_pre (GstCpuStatsTracer * self, guint64 ts, GstPad * pad)
+{
+  enter (self, pad, GST_PAD_PEER (pad), ts);
+}
+
+static void
+do_push_post (GstCpuStatsTracer * self, guint64 ts, GstPad * pad)
+{
+  leave (self, ts);
+}
+
+/* tracer class */
+
+static void
+gst_cpu_stats_tracer_constructed (GObject * object)
+{
+  GstCpuStatsTracer *self = GST_CPU_STATS_TRACER (object);
+  gchar *params, *tmp;
+  GstStructure *params_struct = NULL;
+  gint interval;
+
+  g_object_get (self, "params", &params, NULL);
+
+  if (!params)
+    return;
+
+  tmp = g_strdup_printf ("cpustats,%s", params);
+  params_struct = gst_structure_from_string (tmp, NULL);
+  g_free (tmp);
+
+  if (params_struct) {
+    const gchar *name;
+
+    /* Set the name if assigned */
+    name = gst_structure_get_string (params_struct, "name");
+    if (name)
+      gst_object_set_name (GST_OBJECT (self), name);
+
+    if (gst_structure_get_int (params_struct, "report-interval", &interval)) {
+      if (interval >= 0)
+        self->report_interval = interval * GST_MSECOND;
+      else
+        GST_WARNING ("Invalid cpustats tracer report-interval %d", interval);
+    }
+
+    gst_structure_free (params_struct);
+  }
+
+  g_free (params);
+}
+
+static void
+gst_cpu_stats_tracer_finalize (GObject * object)
+{
+  GstCpuStatsTracer *self = GST_CPU_STATS_TRACER (object);
+  guint64 ts = gst_util_get_timestamp ();
+  guint i;
+
+  for (i = 0; i < self->stats->len; i++) {
+    GstCpuStats *stats = g_ptr_array_index (self->stats, i);
+
+    log_element_cpu (stats, stats->total_self, stats->total_inclusive,
+        ts - self->start, TRUE, ts);
+  }
+
+  g_ptr_array_unref (self->stats);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_cpu_stats_tracer_class_init (GstCpuStatsTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->constructed = gst_cpu_stats_tracer_constructed;
+  gobject_class->finalize = gst_cpu_stats_tracer_finalize;
+
+  /* announce trace formats */
+  /* *INDENT-OFF* */
+  tr_element_cpu = gst_tracer_record_new ("element-cpu.class",
+      "element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "self", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "cpu time in ns spent in the element itself",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "inclusive", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "cpu time in ns spent in the element and the elements it called",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "self-load", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT,
+          "description", G_TYPE_STRING, "self time in per mille of a cpu core",
+          "min", G_TYPE_UINT, 0,
+          "max", G_TYPE_UINT, G_MAXUINT,
+          NULL),
+      "final", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_BOOLEAN,
+          "description", G_TYPE_STRING,
+              "whether this summarizes the whole run or the last interval",
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the times have been logged",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      NULL);
+  /* *INDENT-ON* */
+
+  GST_OBJECT_FLAG_SET (tr_element_cpu, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_cpu_stats_tracer_init (GstCpuStatsTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  g_mutex_init (&self->lock);
+  self->stats = g_ptr_array_new_with_free_func (cpu_stats_unref);
+  self->report_interval = GST_SECOND;
+  self->start = self->last_report = gst_util_get_timestamp ();
+
+  /* the pre hooks enter the element of the peer pad, the post hooks leave it
+   * again. In pull mode the peer is the upstream element. */
+  gst_tracing_register_hook (tracer, "pad-push-pre", G_CALLBACK (do_push_pre));
+  gst_tracing_register_hook (tracer, "pad-push-post",
+      G_CALLBACK (do_push_post));
+  gst_tracing_register_hook (tracer, "pad-push-list-pre",
+      G_CALLBACK (do_push_pre));
+  gst_tracing_register_hook (tracer, "pad-push-list-post",
+      G_CALLBACK (do_push_post));
+  gst_tracing_register_hook (tracer, "pad-pull-range-pre",
+      G_CALLBACK (do_push_pre));
+  gst_tracing_register_hook (tracer, "pad-pull-range-post",
+      G_CALLBACK (do_push_post));
+  gst_tracing_register_hook (tracer, "pad-push-event-pre",
+      G_CALLBACK (do_push_pre));
+  gst_tracing_register_hook (tracer, "pad-push-event-post",
+      G_CALLBACK (do_push_post));
+}
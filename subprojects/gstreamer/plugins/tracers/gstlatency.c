@@ -31,6 +31,21 @@
  * ```
  * GST_TRACERS="latency(flags=pipeline+element+reported)" GST_DEBUG=GST_TRACER:7 ./...
  * ```
+ *
+ * Logging one record per buffer is too much for pipelines with many streams
+ * or high frame rates. With the 'histogram' parameter the pipeline and
+ * element latencies are instead collected in histograms with a precision of
+ * about 3%. Every 'report-interval' milliseconds (default 1000) a summary
+ * with the 50th, 99th and 99.9th percentile and the maximum of the latencies
+ * since the last summary is logged for each src/sink pair and element, and
+ * a summary over the whole run when the tracer is destroyed. Setting
+ * 'report-interval' to 0 disables the periodic summaries.
+ *
+ * ```
+ * GST_TRACERS="latency(flags=pipeline+element,histogram=true,report-interval=5000)" GST_DEBUG=GST_TRACER:7 ./...
+ * ```
+ *
+ * Since 1.24 for the histograms.
  */
 /* TODO(ensonic): if there are two sources feeding into a mixer/muxer and later
  * we fan-out with tee and have two sinks, each sink would get all two events,
@@ -68,6 +83,8 @@ static GQuark drop_sub_latency_quark;
 static GstTracerRecord *tr_latency;
 static GstTracerRecord *tr_element_latency;
 static GstTracerRecord *tr_element_reported_latency;
+static GstTracerRecord *tr_latency_summary;
+static GstTracerRecord *tr_element_latency_summary;
 
 /* The private stack for each thread */
 static GPrivate latency_query_stack =
@@ -80,6 +97,200 @@ struct LatencyQueryTableValue
   guint64 max;
 };
 
+/* histograms
+ *
+ * Values below 2^HISTOGRAM_SUB_BUCKET_BITS ns are counted exactly, above that
+ * every power of two range is split into 2^(HISTOGRAM_SUB_BUCKET_BITS - 1)
+ * buckets of equal size. Latencies above 2^HISTOGRAM_MAX_BITS ns (about 39
+ * hours) are counted in the last bucket. */
+#define HISTOGRAM_SUB_BUCKET_BITS 6
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_HALF_SUB_BUCKETS (HISTOGRAM_SUB_BUCKETS / 2)
+#define HISTOGRAM_MAX_BITS 47
+#define HISTOGRAM_N_BUCKETS (HISTOGRAM_SUB_BUCKETS + \
+    (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_HALF_SUB_BUCKETS)
+
+typedef struct
+{
+  guint64 count;
+  guint64 min;
+  guint64 max;
+  guint64 buckets[HISTOGRAM_N_BUCKETS];
+} LatencyHistogram;
+
+/* histograms of one src/sink pair or one element */
+typedef struct
+{
+  gchar *src_element_id;
+  gchar *src_element;
+  gchar *src;
+  /* NULL for element latencies */
+  gchar *sink_element_id;
+  gchar *sink_element;
+  gchar *sink;
+
+  /* since the last report and since the start */
+  LatencyHistogram interval;
+  LatencyHistogram total;
+} LatencyStats;
+
+static guint
+histogram_bucket (guint64 value)
+{
+  gint msb;
+
+  if (value < HISTOGRAM_SUB_BUCKETS)
+    return value;
+
+  msb = g_bit_nth_msf (value, -1);
+  if (msb > HISTOGRAM_MAX_BITS)
+    return HISTOGRAM_N_BUCKETS - 1;
+
+  return HISTOGRAM_SUB_BUCKETS +
+      (msb - HISTOGRAM_SUB_BUCKET_BITS) * HISTOGRAM_HALF_SUB_BUCKETS +
+      (value >> (msb - HISTOGRAM_SUB_BUCKET_BITS + 1)) -
+      HISTOGRAM_HALF_SUB_BUCKETS;
+}
+
+/* the highest value that is counted in @bucket */
+static guint64
+histogram_bucket_max (guint bucket)
+{
+  guint range, sub, shift;
+
+  if (bucket < HISTOGRAM_SUB_BUCKETS)
+    return bucket;
+
+  range = (bucket - HISTOGRAM_SUB_BUCKETS) / HISTOGRAM_HALF_SUB_BUCKETS;
+  sub = (bucket - HISTOGRAM_SUB_BUCKETS) % HISTOGRAM_HALF_SUB_BUCKETS +
+      HISTOGRAM_HALF_SUB_BUCKETS;
+  shift = range + 1;
+
+  return (((guint64) sub + 1) << shift) - 1;
+}
+
+static void
+histogram_add (LatencyHistogram * h, guint64 value)
+{
+  if (h->count == 0 || value < h->min)
+    h->min = value;
+  if (h->count == 0 || value > h->max)
+    h->max = value;
+  h->count++;
+  h->buckets[histogram_bucket (value)]++;
+}
+
+static guint64
+histogram_percentile (const LatencyHistogram * h, gdouble percentile)
+{
+  guint64 rank, seen = 0;
+  guint i;
+
+  if (h->count == 0)
+    return 0;
+
+  rank = MAX ((guint64) (percentile / 100.0 * h->count + 0.5), 1);
+  for (i = 0; i < HISTOGRAM_N_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= rank)
+      return CLAMP (histogram_bucket_max (i), h->min, h->max);
+  }
+
+  return h->max;
+}
+
+static void
+latency_stats_free (LatencyStats * stats)
+{
+  g_free (stats->src_element_id);
+  g_free (stats->src_element);
+  g_free (stats->src);
+  g_free (stats->sink_element_id);
+  g_free (stats->sink_element);
+  g_free (stats->sink);
+  g_free (stats);
+}
+
+static void
+log_latency_summary (LatencyStats * stats, LatencyHistogram * h,
+    gboolean final, guint64 ts)
+{
+  if (h->count == 0)
+    return;
+
+  if (stats->sink) {
+    gst_tracer_record_log (tr_latency_summary, stats->src_element_id,
+        stats->src_element, stats->src, stats->sink_element_id,
+        stats->sink_element, stats->sink, h->count, h->min,
+        histogram_percentile (h, 50.0), histogram_percentile (h, 99.0),
+        histogram_percentile (h, 99.9), h->max, final, ts);
+  } else {
+    gst_tracer_record_log (tr_element_latency_summary, stats->src_element_id,
+        stats->src_element, stats->src, h->count, h->min,
+        histogram_percentile (h, 50.0), histogram_percentile (h, 99.0),
+        histogram_percentile (h, 99.9), h->max, final, ts);
+  }
+}
+
+/* call with the lock */
+static void
+report_histograms (GstLatencyTracer * self, guint64 ts)
+{
+  GHashTableIter iter;
+  LatencyStats *stats;
+
+  g_hash_table_iter_init (&iter, self->stats);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & stats)) {
+    log_latency_summary (stats, &stats->interval, FALSE, ts);
+    memset (&stats->interval, 0, sizeof (LatencyHistogram));
+  }
+  self->last_report = ts;
+}
+
+/* takes ownership of the strings */
+static void
+add_to_histogram (GstLatencyTracer * self, gchar * src_element_id,
+    gchar * src_element, gchar * src, gchar * sink_element_id,
+    gchar * sink_element, gchar * sink, GstClockTimeDiff latency, guint64 ts)
+{
+  LatencyStats *stats;
+  gchar *key;
+
+  key = g_strconcat (src_element_id, ":", src, "|", sink_element_id, ":",
+      sink, NULL);
+
+  g_mutex_lock (&self->lock);
+  stats = g_hash_table_lookup (self->stats, key);
+  if (!stats) {
+    stats = g_new0 (LatencyStats, 1);
+    stats->src_element_id = src_element_id;
+    stats->src_element = src_element;
+    stats->src = src;
+    stats->sink_element_id = sink_element_id;
+    stats->sink_element = sink_element;
+    stats->sink = sink;
+    g_hash_table_insert (self->stats, key, stats);
+  } else {
+    g_free (src_element_id);
+    g_free (src_element);
+    g_free (src);
+    g_free (sink_element_id);
+    g_free (sink_element);
+    g_free (sink);
+    g_free (key);
+  }
+
+  /* clock skew between the threads can make this negative */
+  latency = MAX (latency, 0);
+  histogram_add (&stats->interval, latency);
+  histogram_add (&stats->total, latency);
+
+  if (self->report_interval > 0 && ts >= self->last_report +
+      self->report_interval)
+    report_histograms (self, ts);
+  g_mutex_unlock (&self->lock);
+}
+
 /* data helpers */
 
 /*
@@ -171,8 +382,8 @@ local_latency_query_stack_push (struct LatencyQueryTableValue *value)
 /* hooks */
 
 static void
-log_latency (const GstStructure * data, GstElement * sink_parent,
-    GstPad * sink_pad, guint64 sink_ts)
+log_latency (GstLatencyTracer * self, const GstStructure * data,
+    GstElement * sink_parent, GstPad * sink_pad, guint64 sink_ts)
 {
   guint64 src_ts;
   const char *src, *element_src, *id_element_src;
@@ -197,6 +408,14 @@ log_latency (const GstStructure * data, GstElement * sink_parent,
   id_element_sink = g_strdup_printf ("%p", sink_parent);
   element_sink = gst_element_get_name (sink_parent);
   sink = gst_pad_get_name (sink_pad);
+
+  if (self->histogram) {
+    add_to_histogram (self, g_strdup (id_element_src), g_strdup (element_src),
+        g_strdup (src), id_element_sink, element_sink, sink,
+        GST_CLOCK_DIFF (src_ts, sink_ts), sink_ts);
+    return;
+  }
+
   gst_tracer_record_log (tr_latency, id_element_src, element_src, src,
       id_element_sink, element_sink, sink, GST_CLOCK_DIFF (src_ts, sink_ts),
       sink_ts);
@@ -206,8 +425,8 @@ log_latency (const GstStructure * data, GstElement * sink_parent,
 }
 
 static void
-log_element_latency (const GstStructure * data, GstElement * parent,
-    GstPad * pad, guint64 sink_ts)
+log_element_latency (GstLatencyTracer * self, const GstStructure * data,
+    GstElement * parent, GstPad * pad, guint64 sink_ts)
 {
   guint64 src_ts;
   gchar *pad_name, *element_name, *element_id;
@@ -225,6 +444,12 @@ log_element_latency (const GstStructure * data, GstElement * parent,
   value = gst_structure_id_get_value (data, latency_probe_ts);
   src_ts = g_value_get_uint64 (value);
 
+  if (self->histogram) {
+    add_to_histogram (self, element_id, element_name, pad_name, NULL, NULL,
+        NULL, GST_CLOCK_DIFF (src_ts, sink_ts), sink_ts);
+    return;
+  }
+
   gst_tracer_record_log (tr_element_latency, element_id, element_name, pad_name,
       GST_CLOCK_DIFF (src_ts, sink_ts), sink_ts);
 
@@ -297,7 +522,8 @@ send_latency_probe (GstLatencyTracer * self, GstElement * parent, GstPad * pad,
 }
 
 static void
-calculate_latency (GstElement * parent, GstPad * pad, guint64 ts)
+calculate_latency (GstLatencyTracer * self, GstElement * parent, GstPad * pad,
+    guint64 ts)
 {
   if (parent && (!GST_IS_BIN (parent)) &&
       (!GST_OBJECT_FLAG_IS_SET (parent, GST_ELEMENT_FLAG_SOURCE))) {
@@ -312,7 +538,8 @@ calculate_latency (GstElement * parent, GstPad * pad, guint64 ts)
       GST_DEBUG ("%s_%s: Should log full latency now (event %p)",
           GST_DEBUG_PAD_NAME (pad), ev);
       if (ev) {
-        log_latency (gst_event_get_structure (ev), peer_parent, peer_pad, ts);
+        log_latency (self, gst_event_get_structure (ev), peer_parent,
+            peer_pad, ts);
         g_object_set_qdata ((GObject *) pad, latency_probe_id, NULL);
       }
     }
@@ -321,7 +548,8 @@ calculate_latency (GstElement * parent, GstPad * pad, guint64 ts)
     GST_DEBUG ("%s_%s: Should log sub latency now (event %p)",
         GST_DEBUG_PAD_NAME (pad), ev);
     if (ev) {
-      log_element_latency (gst_event_get_structure (ev), parent, pad, ts);
+      log_element_latency (self, gst_event_get_structure (ev), parent, pad,
+          ts);
       g_object_set_qdata ((GObject *) pad, sub_latency_probe_id, NULL);
     }
     if (peer_pad)
@@ -338,7 +566,7 @@ do_push_buffer_pre (GstTracer * tracer, guint64 ts, GstPad * pad)
   GstElement *parent = get_real_pad_parent (pad);
 
   send_latency_probe (self, parent, pad, ts);
-  calculate_latency (parent, pad, ts);
+  calculate_latency (self, parent, pad, ts);
 
   if (parent)
     gst_object_unref (parent);
@@ -358,11 +586,12 @@ do_pull_range_pre (GstTracer * tracer, guint64 ts, GstPad * pad)
 }
 
 static void
-do_pull_range_post (GstTracer * self, guint64 ts, GstPad * pad)
+do_pull_range_post (GstTracer * tracer, guint64 ts, GstPad * pad)
 {
+  GstLatencyTracer *self = (GstLatencyTracer *) tracer;
   GstElement *parent = get_real_pad_parent (pad);
 
-  calculate_latency (parent, pad, ts);
+  calculate_latency (self, parent, pad, ts);
 
   if (parent)
     gst_object_unref (parent);
@@ -550,6 +779,7 @@ gst_latency_tracer_constructed (GObject * object)
   GstLatencyTracer *self = GST_LATENCY_TRACER (object);
   gchar *params, *tmp;
   GstStructure *params_struct = NULL;
+  gint interval;
 
   g_object_get (self, "params", &params, NULL);
 
@@ -589,18 +819,46 @@ gst_latency_tracer_constructed (GObject * object)
 
       g_strfreev (split);
     }
+
+    gst_structure_get_boolean (params_struct, "histogram", &self->histogram);
+    if (gst_structure_get_int (params_struct, "report-interval", &interval)) {
+      if (interval >= 0)
+        self->report_interval = interval * GST_MSECOND;
+      else
+        GST_WARNING ("Invalid latency tracer report-interval %d", interval);
+    }
+
     gst_structure_free (params_struct);
   }
 
   g_free (params);
 }
 
+static void
+gst_latency_tracer_finalize (GObject * object)
+{
+  GstLatencyTracer *self = GST_LATENCY_TRACER (object);
+  GHashTableIter iter;
+  LatencyStats *stats;
+  guint64 ts = gst_util_get_timestamp ();
+
+  g_hash_table_iter_init (&iter, self->stats);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & stats))
+    log_latency_summary (stats, &stats->total, TRUE, ts);
+
+  g_hash_table_unref (self->stats);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_latency_tracer_class_init (GstLatencyTracerClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   gobject_class->constructed = gst_latency_tracer_constructed;
+  gobject_class->finalize = gst_latency_tracer_finalize;
 
   latency_probe_id = g_quark_from_static_string ("latency_probe.id");
   sub_latency_probe_id = g_quark_from_static_string ("sub_latency_probe.id");
@@ -726,12 +984,163 @@ gst_latency_tracer_class_init (GstLatencyTracerClass * klass)
           "max", G_TYPE_UINT64, G_MAXUINT64,
           NULL),
       NULL);
+
+  tr_latency_summary = gst_tracer_record_new ("latency-summary.class",
+      "src-element-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "src-element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "src", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "sink-element-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "sink-element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "sink", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "count", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "number of measured buffers",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "min", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "minimum latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p50", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "median latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p99", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "99th percentile of the latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p999", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "99.9th percentile of the latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "max", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "maximum latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "final", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_BOOLEAN,
+          "description", G_TYPE_STRING,
+              "whether this summarizes the whole run or the last interval",
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the summary has been logged",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      NULL);
+
+  tr_element_latency_summary = gst_tracer_record_new (
+      "element-latency-summary.class",
+      "element-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "src", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "count", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "number of measured buffers",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "min", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "minimum latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p50", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "median latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p99", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "99th percentile of the latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p999", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "99.9th percentile of the latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "max", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "maximum latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "final", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_BOOLEAN,
+          "description", G_TYPE_STRING,
+              "whether this summarizes the whole run or the last interval",
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the summary has been logged",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      NULL);
   /* *INDENT-ON* */
 
   GST_OBJECT_FLAG_SET (tr_latency, GST_OBJECT_FLAG_MAY_BE_LEAKED);
   GST_OBJECT_FLAG_SET (tr_element_latency, GST_OBJECT_FLAG_MAY_BE_LEAKED);
   GST_OBJECT_FLAG_SET (tr_element_reported_latency,
       GST_OBJECT_FLAG_MAY_BE_LEAKED);
+  GST_OBJECT_FLAG_SET (tr_latency_summary, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+  GST_OBJECT_FLAG_SET (tr_element_latency_summary,
+      GST_OBJECT_FLAG_MAY_BE_LEAKED);
 }
 
 static void
@@ -742,6 +1151,11 @@ gst_latency_tracer_init (GstLatencyTracer * self)
   /* only trace pipeline latency by default */
   self->flags = GST_LATENCY_TRACER_FLAG_PIPELINE;
 
+  g_mutex_init (&self->lock);
+  self->stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) latency_stats_free);
+  self->report_interval = GST_SECOND;
+
   /* in push mode, pre/post will be called before/after the peer chain
    * function has been called. For this reaosn, we only use -pre to avoid
    * accounting for the processing time of the peer element (the sink) */
@@ -59,6 +59,15 @@ struct _GstLatencyTracer {
 
   /*< private >*/
   GstLatencyTracerFlags flags;
+
+  /* summarize the latencies in histograms instead of logging them */
+  gboolean histogram;
+  GstClockTime report_interval;
+
+  GMutex lock;
+  /* protected by lock */
+  GHashTable *stats;
+  GstClockTime last_report;
 };
 
 struct _GstLatencyTracerClass {
@@ -0,0 +1,172 @@
+/* GStreamer
+ *
+ * gstslabstats.c: tracer for the struct free lists
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:tracer-slabstats
+ * @short_description: log usage of the buffer, event and query free lists
+ *
+ * A tracing module that sums up how many buffer, event and query structs were
+ * allocated and how many of those allocations were served from the per-thread
+ * free lists instead of malloc. The totals per struct type are logged when the
+ * tracer is destroyed, that is on gst_deinit().
+ *
+ * Threads report their counters in batches and when they exit, so the totals
+ * do not include the last few allocations of threads that are still running.
+ *
+ * ```
+ * $ GST_TRACERS=slabstats GST_DEBUG=GST_TRACER:7 gst-launch-1.0 fakesrc num-buffers=100000 ! fakesink
+ * ...
+ * slab-stats, cache=(string)buffer, allocs=(guint64)98304, hits=(guint64)98240, frees=(guint64)98304, released=(guint64)0, hit-rate=(double)0.99934895833333337;
+ * ```
+ *
+ * Since: 1.24
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstslabstats.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_slab_stats_debug);
+#define GST_CAT_DEFAULT gst_slab_stats_debug
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_slab_stats_debug, "slabstats", 0, "slabstats tracer");
+#define gst_slab_stats_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstSlabStatsTracer, gst_slab_stats_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+static GstTracerRecord *tr_slab_stats;
+
+typedef struct
+{
+  guint64 allocs;
+  guint64 hits;
+  guint64 frees;
+  guint64 released;
+} GstSlabStats;
+
+static void
+do_slab_stats (GstSlabStatsTracer * self, GstClockTime ts,
+    const gchar * cache, guint allocs, guint hits, guint frees, guint released)
+{
+  GstSlabStats *stats;
+
+  g_mutex_lock (&self->lock);
+  stats = g_hash_table_lookup (self->stats, cache);
+  if (!stats) {
+    stats = g_new0 (GstSlabStats, 1);
+    g_hash_table_insert (self->stats, g_strdup (cache), stats);
+  }
+  stats->allocs += allocs;
+  stats->hits += hits;
+  stats->frees += frees;
+  stats->released += released;
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+gst_slab_stats_tracer_finalize (GObject * object)
+{
+  GstSlabStatsTracer *self = GST_SLAB_STATS_TRACER (object);
+  GHashTableIter iter;
+  const gchar *cache;
+  GstSlabStats *stats;
+
+  g_hash_table_iter_init (&iter, self->stats);
+  while (g_hash_table_iter_next (&iter, (gpointer *) & cache,
+          (gpointer *) & stats)) {
+    gst_tracer_record_log (tr_slab_stats, cache, stats->allocs, stats->hits,
+        stats->frees, stats->released,
+        stats->allocs ? (gdouble) stats->hits / stats->allocs : 0.0);
+  }
+
+  g_hash_table_unref (self->stats);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_slab_stats_tracer_class_init (GstSlabStatsTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gst_slab_stats_tracer_finalize;
+
+  /* announce trace formats */
+  /* *INDENT-OFF* */
+  tr_slab_stats = gst_tracer_record_new ("slab-stats.class",
+      "cache", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING, "struct type",
+          NULL),
+      "allocs", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "structs allocated",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "hits", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "allocations served from the free lists",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "frees", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "structs freed",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "released", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "free structs given back to the system",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "hit-rate", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_DOUBLE,
+          "description", G_TYPE_STRING, "fraction of allocations that were hits",
+          "min", G_TYPE_DOUBLE, 0.0,
+          "max", G_TYPE_DOUBLE, 1.0,
+          NULL),
+      NULL);
+  /* *INDENT-ON* */
+
+  GST_OBJECT_FLAG_SET (tr_slab_stats, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_slab_stats_tracer_init (GstSlabStatsTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  g_mutex_init (&self->lock);
+  self->stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      g_free);
+
+  gst_tracing_register_hook (tracer, "slab-stats",
+      G_CALLBACK (do_slab_stats));
+}
@@ -0,0 +1,47 @@
+/* GStreamer
+ *
+ * gstslabstats.h: tracer for the struct free lists
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_SLAB_STATS_TRACER_H__
+#define __GST_SLAB_STATS_TRACER_H__
+
+#include <gst/gst.h>
+#include <gst/gsttracer.h>
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE(GstSlabStatsTracer, gst_slab_stats_tracer, GST,
+    SLAB_STATS_TRACER, GstTracer)
+/**
+ * GstSlabStatsTracer:
+ *
+ * Opaque #GstSlabStatsTracer data structure
+ */
+struct _GstSlabStatsTracer {
+  GstTracer 	 parent;
+
+  /*< private >*/
+  GMutex lock;
+  /* cache name -> GstSlabStats */
+  GHashTable *stats;
+};
+
+G_END_DECLS
+
+#endif /* __GST_SLAB_STATS_TRACER_H__ */
@@ -30,6 +30,10 @@
 #include "gststats.h"
 #include "gstleaks.h"
 #include "gstfactories.h"
+#include "gstcapscache.h"
+#include "gstslabstats.h"
+#include "gstcpustats.h"
+#include "gstcopystats.h"
 
 static gboolean
 plugin_init (GstPlugin * plugin)
@@ -51,6 +55,20 @@ plugin_init (GstPlugin * plugin)
   if (!gst_tracer_register (plugin, "factories",
           gst_factories_tracer_get_type ()))
     return FALSE;
+  if (!gst_tracer_register (plugin, "capscache",
+          gst_caps_cache_tracer_get_type ()))
+    return FALSE;
+  if (!gst_tracer_register (plugin, "slabstats",
+          gst_slab_stats_tracer_get_type ()))
+    return FALSE;
+  if (!gst_tracer_register (plugin, "copystats",
+          gst_copy_stats_tracer_get_type ()))
+    return FALSE;
+#ifdef HAVE_CLOCK_GETTIME
+  if (!gst_tracer_register (plugin, "cpustats",
+          gst_cpu_stats_tracer_get_type ()))
+    return FALSE;
+#endif
   return TRUE;
 }
 
@@ -0,0 +1,120 @@
+/* GStreamer
+ *
+ * bufferpool.c: benchmark for acquiring and releasing pooled buffers from
+ * many threads
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define BUFFER_SIZE (1400)
+#define ITERATIONS (1000000)
+#define MAX_THREADS (32)
+/* buffers each thread holds at the same time, like a decoder holding a few
+ * reference frames */
+#define BUFFERS_IN_FLIGHT (4)
+
+typedef struct
+{
+  GstBufferPool *pool;
+  guint iterations;
+  GstClockTime max_latency;
+} ThreadData;
+
+static gpointer
+run_thread (gpointer user_data)
+{
+  ThreadData *data = user_data;
+  GstBuffer *bufs[BUFFERS_IN_FLIGHT];
+  GstClockTime start, end;
+  guint i, j;
+
+  for (i = 0; i < data->iterations; i += BUFFERS_IN_FLIGHT) {
+    start = gst_util_get_timestamp ();
+    for (j = 0; j < BUFFERS_IN_FLIGHT; j++)
+      gst_buffer_pool_acquire_buffer (data->pool, &bufs[j], NULL);
+    for (j = 0; j < BUFFERS_IN_FLIGHT; j++)
+      gst_buffer_unref (bufs[j]);
+    end = gst_util_get_timestamp ();
+
+    data->max_latency = MAX (data->max_latency,
+        (end - start) / BUFFERS_IN_FLIGHT);
+  }
+  return NULL;
+}
+
+static void
+run_benchmark (guint n_threads, guint iterations, gboolean thread_cache)
+{
+  ThreadData data[MAX_THREADS];
+  GThread *threads[MAX_THREADS];
+  GstBufferPool *pool;
+  GstStructure *conf;
+  GstClockTime start, end, max_latency = 0;
+  guint i;
+
+  pool = gst_buffer_pool_new ();
+  conf = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (conf, NULL, BUFFER_SIZE,
+      n_threads * BUFFERS_IN_FLIGHT, 0);
+  if (thread_cache)
+    gst_buffer_pool_config_add_option (conf,
+        GST_BUFFER_POOL_OPTION_THREAD_CACHE);
+  gst_buffer_pool_set_config (pool, conf);
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_threads; i++) {
+    data[i].pool = pool;
+    data[i].iterations = iterations / n_threads;
+    data[i].max_latency = 0;
+    threads[i] = g_thread_new (NULL, run_thread, &data[i]);
+  }
+  for (i = 0; i < n_threads; i++) {
+    g_thread_join (threads[i]);
+    max_latency = MAX (max_latency, data[i].max_latency);
+  }
+  end = gst_util_get_timestamp ();
+
+  g_print ("%" GST_TIME_FORMAT " - %2u threads %s thread cache, "
+      "%.1f ns per acquire/release, max %" G_GUINT64_FORMAT " ns\n",
+      GST_TIME_ARGS (end - start), n_threads,
+      thread_cache ? "with" : "without",
+      (gdouble) (end - start) * n_threads / iterations, max_latency);
+
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint iterations = ITERATIONS, n_threads;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    iterations = atoi (argv[1]);
+
+  for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2) {
+    run_benchmark (n_threads, iterations, FALSE);
+    run_benchmark (n_threads, iterations, TRUE);
+  }
+
+  return 0;
+}
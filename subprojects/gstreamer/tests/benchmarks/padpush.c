@@ -0,0 +1,109 @@
+/* GStreamer
+ *
+ * padpush.c: benchmark for pushing buffers through a chain of elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define IDENTITY_COUNT (20)
+#define BUFFER_COUNT (1000000)
+
+static GstPadProbeReturn
+buffer_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+run_pipeline (guint identities, guint buffers, gboolean with_probes)
+{
+  GstElement *pipeline, *src, *sink, *current, *last;
+  GstClockTime start, end;
+  GstMessage *msg;
+  GstBus *bus;
+  guint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("fakesrc", NULL);
+  g_assert (src);
+  g_object_set (src, "num-buffers", buffers, "sizetype", 1, NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_assert (sink);
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+  last = src;
+  for (i = 0; i < identities; i++) {
+    current = gst_element_factory_make ("identity", NULL);
+    g_assert (current);
+    g_object_set (current, "silent", TRUE, NULL);
+    gst_bin_add (GST_BIN (pipeline), current);
+    if (!gst_element_link (last, current))
+      g_assert_not_reached ();
+
+    /* a probe on every source pad disables the fast path when pushing */
+    if (with_probes) {
+      GstPad *pad = gst_element_get_static_pad (last, "src");
+
+      gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, buffer_probe, NULL,
+          NULL);
+      gst_object_unref (pad);
+    }
+    last = current;
+  }
+  if (!gst_element_link (last, sink))
+    g_assert_not_reached ();
+
+  bus = gst_element_get_bus (pipeline);
+
+  start = gst_util_get_timestamp ();
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+  msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  end = gst_util_get_timestamp ();
+  gst_message_unref (msg);
+
+  g_print ("%" GST_TIME_FORMAT " - %u buffers through %u identity elements "
+      "%s probes, %.0f buffers/s\n", GST_TIME_ARGS (end - start), buffers,
+      identities, with_probes ? "with" : "without",
+      (gdouble) buffers * GST_SECOND / MAX (end - start, 1));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint buffers = BUFFER_COUNT, identities = IDENTITY_COUNT;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    identities = atoi (argv[1]);
+  if (argc > 2)
+    buffers = atoi (argv[2]);
+
+  run_pipeline (identities, buffers, FALSE);
+  run_pipeline (identities, buffers, TRUE);
+
+  return 0;
+}
@@ -0,0 +1,255 @@
+/* GStreamer
+ *
+ * pollclients.c: benchmark for serving many local TCP clients with GstPoll
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#endif
+
+#define CLIENT_COUNT (5000)
+#define ROUND_COUNT (100)
+/* 7 MPEG-TS packets */
+#define CHUNK_SIZE (1316)
+
+#ifdef G_OS_UNIX
+typedef struct
+{
+  GstPoll *set;
+  GstPollFD *fds;
+  guint n_fds;
+  guint64 expected;
+} Reader;
+
+static void
+set_nonblocking (gint fd)
+{
+  fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+}
+
+/* connects @n clients to a listening socket on the loopback interface */
+static gboolean
+connect_clients (guint n, gint * server_fds, gint * client_fds)
+{
+  struct sockaddr_in addr = { 0, };
+  socklen_t len = sizeof (addr);
+  gint listen_fd;
+  guint i;
+
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  listen_fd = socket (AF_INET, SOCK_STREAM, 0);
+  if (listen_fd < 0 || bind (listen_fd, (struct sockaddr *) &addr, len) < 0 ||
+      listen (listen_fd, 128) < 0 ||
+      getsockname (listen_fd, (struct sockaddr *) &addr, &len) < 0)
+    return FALSE;
+
+  for (i = 0; i < n; i++) {
+    client_fds[i] = socket (AF_INET, SOCK_STREAM, 0);
+    if (client_fds[i] < 0 ||
+        connect (client_fds[i], (struct sockaddr *) &addr, len) < 0)
+      return FALSE;
+    server_fds[i] = accept (listen_fd, NULL, NULL);
+    if (server_fds[i] < 0)
+      return FALSE;
+
+    set_nonblocking (client_fds[i]);
+    set_nonblocking (server_fds[i]);
+  }
+  close (listen_fd);
+
+  return TRUE;
+}
+
+static gpointer
+read_clients (Reader * reader)
+{
+  gchar buf[CHUNK_SIZE];
+  guint64 received = 0;
+  guint i;
+
+  while (received < reader->expected) {
+    if (gst_poll_wait (reader->set, GST_CLOCK_TIME_NONE) < 0) {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+      break;
+    }
+
+    for (i = 0; i < reader->n_fds; i++) {
+      ssize_t res;
+
+      if (!gst_poll_fd_can_read (reader->set, &reader->fds[i]))
+        continue;
+
+      while ((res = read (reader->fds[i].fd, buf, sizeof (buf))) > 0)
+        received += res;
+    }
+  }
+
+  return NULL;
+}
+
+/* the server writes one chunk to every client per round, enabling and
+ * disabling the write readiness for each client the way multifdsink does */
+static void
+serve_clients (guint n_clients, guint rounds)
+{
+  GstPoll *set;
+  GstPollFD *fds;
+  Reader reader;
+  GThread *thread;
+  gint *server_fds, *client_fds;
+  guint *sent;
+  GstClockTime start, end, waiting = 0;
+  guint i, round, waits = 0;
+  gchar chunk[CHUNK_SIZE] = { 0, };
+  const gchar *env;
+
+  server_fds = g_new (gint, n_clients);
+  client_fds = g_new (gint, n_clients);
+  if (!connect_clients (n_clients, server_fds, client_fds))
+    g_error ("failed to connect %u clients: %s", n_clients, g_strerror (errno));
+
+  set = gst_poll_new (TRUE);
+  fds = g_new (GstPollFD, n_clients);
+  sent = g_new (guint, n_clients);
+
+  reader.set = gst_poll_new (TRUE);
+  reader.fds = g_new (GstPollFD, n_clients);
+  reader.n_fds = n_clients;
+  reader.expected = (guint64) n_clients * rounds * CHUNK_SIZE;
+
+  for (i = 0; i < n_clients; i++) {
+    gst_poll_fd_init (&fds[i]);
+    fds[i].fd = server_fds[i];
+    gst_poll_add_fd (set, &fds[i]);
+
+    gst_poll_fd_init (&reader.fds[i]);
+    reader.fds[i].fd = client_fds[i];
+    gst_poll_add_fd (reader.set, &reader.fds[i]);
+    gst_poll_fd_ctl_read (reader.set, &reader.fds[i], TRUE);
+  }
+
+  thread = g_thread_new ("reader", (GThreadFunc) read_clients, &reader);
+
+  start = gst_util_get_timestamp ();
+  for (round = 0; round < rounds; round++) {
+    guint n_pending = n_clients;
+
+    /* a new buffer for all clients */
+    for (i = 0; i < n_clients; i++) {
+      sent[i] = 0;
+      gst_poll_fd_ctl_write (set, &fds[i], TRUE);
+    }
+
+    while (n_pending > 0) {
+      GstClockTime wait_start = gst_util_get_timestamp ();
+      gint res;
+
+      res = gst_poll_wait (set, GST_CLOCK_TIME_NONE);
+      waiting += gst_util_get_timestamp () - wait_start;
+      waits++;
+
+      if (res < 0) {
+        if (errno == EINTR || errno == EAGAIN)
+          continue;
+        g_error ("wait failed: %s", g_strerror (errno));
+      }
+
+      for (i = 0; i < n_clients; i++) {
+        ssize_t written;
+
+        if (sent[i] == CHUNK_SIZE || !gst_poll_fd_can_write (set, &fds[i]))
+          continue;
+
+        /* after a short write the socket buffer is full and the write
+         * readiness is reported again once there is space */
+        written = write (fds[i].fd, chunk + sent[i], CHUNK_SIZE - sent[i]);
+        if (written > 0 && (sent[i] += written) == CHUNK_SIZE) {
+          n_pending--;
+          gst_poll_fd_ctl_write (set, &fds[i], FALSE);
+        }
+      }
+    }
+  }
+  g_thread_join (thread);
+  end = gst_util_get_timestamp ();
+
+  env = g_getenv ("GST_POLL_EPOLL");
+  g_print ("%" GST_TIME_FORMAT " - %u clients, %u rounds with %s, %u waits, "
+      "%" GST_TIME_FORMAT " waiting\n", GST_TIME_ARGS (end - start), n_clients,
+      rounds, env && g_str_equal (env, "no") ? "ppoll" : "the default backend",
+      waits, GST_TIME_ARGS (waiting));
+
+  for (i = 0; i < n_clients; i++) {
+    close (server_fds[i]);
+    close (client_fds[i]);
+  }
+  gst_poll_free (reader.set);
+  gst_poll_free (set);
+  g_free (reader.fds);
+  g_free (fds);
+  g_free (sent);
+  g_free (client_fds);
+  g_free (server_fds);
+}
+#endif
+
+gint
+main (gint argc, gchar * argv[])
+{
+#ifdef G_OS_UNIX
+  guint clients = CLIENT_COUNT, rounds = ROUND_COUNT;
+  struct rlimit rl;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    clients = atoi (argv[1]);
+  if (argc > 2)
+    rounds = atoi (argv[2]);
+
+  /* both ends of every connection are in this process */
+  if (getrlimit (RLIMIT_NOFILE, &rl) == 0) {
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit (RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur != RLIM_INFINITY && 2 * clients + 64 > rl.rlim_cur) {
+      clients = (rl.rlim_cur - 64) / 2;
+      g_print ("fd limit reached, using %u clients\n", clients);
+    }
+  }
+
+  serve_clients (clients, rounds);
+
+  g_setenv ("GST_POLL_EPOLL", "no", TRUE);
+  serve_clients (clients, rounds);
+#else
+  g_print ("not supported on this platform\n");
+#endif
+
+  return 0;
+}
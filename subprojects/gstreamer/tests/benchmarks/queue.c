@@ -0,0 +1,111 @@
+/* GStreamer
+ *
+ * queue.c: benchmark for passing buffers through a queue between two threads
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#ifdef G_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#define BUFFER_COUNT (1000000)
+
+/* the number of context switches is a good estimate for the number of times
+ * the two threads went to sleep waiting for each other */
+static guint64
+get_context_switches (void)
+{
+#ifdef G_OS_UNIX
+  struct rusage ru;
+
+  getrusage (RUSAGE_SELF, &ru);
+
+  return ru.ru_nvcsw + ru.ru_nivcsw;
+#else
+  return 0;
+#endif
+}
+
+static void
+run_pipeline (guint buffers, guint max_size_buffers, gboolean lockless)
+{
+  GstElement *pipeline, *src, *queue, *sink;
+  GstClockTime start, end;
+  guint64 switches;
+  GstMessage *msg;
+  GstBus *bus;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("fakesrc", NULL);
+  g_assert (src);
+  g_object_set (src, "num-buffers", buffers, "sizetype", 1, NULL);
+  queue = gst_element_factory_make ("queue", NULL);
+  g_assert (queue);
+  g_object_set (queue, "lockless", lockless, "max-size-buffers",
+      max_size_buffers, "max-size-bytes", 0, "max-size-time",
+      G_GUINT64_CONSTANT (0), "silent", TRUE, NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_assert (sink);
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, queue, sink, NULL);
+  if (!gst_element_link_many (src, queue, sink, NULL))
+    g_assert_not_reached ();
+
+  bus = gst_element_get_bus (pipeline);
+
+  switches = get_context_switches ();
+  start = gst_util_get_timestamp ();
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+  msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  end = gst_util_get_timestamp ();
+  switches = get_context_switches () - switches;
+  gst_message_unref (msg);
+
+  g_print ("%" GST_TIME_FORMAT " - %u buffers through a %s queue of %u "
+      "buffers, %.0f buffers/s, %.0f context switches/s\n",
+      GST_TIME_ARGS (end - start), buffers, lockless ? "lockless" : "locked",
+      max_size_buffers, (gdouble) buffers * GST_SECOND / MAX (end - start, 1),
+      (gdouble) switches * GST_SECOND / MAX (end - start, 1));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint buffers = BUFFER_COUNT;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    buffers = atoi (argv[1]);
+
+  run_pipeline (buffers, 200, FALSE);
+  run_pipeline (buffers, 200, TRUE);
+  run_pipeline (buffers, 10, FALSE);
+  run_pipeline (buffers, 10, TRUE);
+
+  return 0;
+}
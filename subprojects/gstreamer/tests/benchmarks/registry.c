@@ -0,0 +1,123 @@
+/* GStreamer
+ *
+ * registry.c: benchmark for loading the registry cache on gst_init()
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Run with GST_REGISTRY_UPDATE=no to only measure reading an existing
+ * registry cache, without checking the plugins for changes. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+
+#ifdef HAVE_GETRUSAGE
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+/* peak resident set size in kB, or 0 if unknown */
+static glong
+get_max_rss (void)
+{
+#ifdef HAVE_GETRUSAGE
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) == 0)
+    return usage.ru_maxrss;
+#endif
+
+  return 0;
+}
+
+static guint
+touch_factories (GList * factories)
+{
+  GList *walk;
+  guint n_templates = 0;
+
+  for (walk = factories; walk; walk = walk->next) {
+    GstElementFactory *factory = walk->data;
+
+    gst_element_factory_get_metadata (factory, GST_ELEMENT_METADATA_KLASS);
+    n_templates +=
+        g_list_length ((GList *)
+        gst_element_factory_get_static_pad_templates (factory));
+  }
+
+  return n_templates;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstClockTime start, end;
+  GstElementFactory *factory;
+  GList *plugins, *factories;
+  guint n_templates;
+
+  start = g_get_monotonic_time () * GST_USECOND;
+  gst_init (&argc, &argv);
+  end = g_get_monotonic_time () * GST_USECOND;
+
+  plugins = gst_registry_get_plugin_list (gst_registry_get ());
+  g_print ("%" GST_TIME_FORMAT " - gst_init, %d plugins\n",
+      GST_TIME_ARGS (end - start), g_list_length (plugins));
+  g_print ("%ld kB - max RSS after gst_init\n", get_max_rss ());
+  gst_plugin_list_free (plugins);
+
+  start = gst_util_get_timestamp ();
+  factory = gst_element_factory_find ("fakesrc");
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - factory lookup\n",
+      GST_TIME_ARGS (end - start));
+
+  if (factory) {
+    start = gst_util_get_timestamp ();
+    gst_element_factory_get_static_pad_templates (factory);
+    end = gst_util_get_timestamp ();
+    g_print ("%" GST_TIME_FORMAT " - first pad template lookup\n",
+        GST_TIME_ARGS (end - start));
+    gst_object_unref (factory);
+  }
+
+  /* not gst_element_factory_list_get_elements(), filtering on the klass
+   * would already read all details */
+  factories = gst_registry_get_feature_list (gst_registry_get (),
+      GST_TYPE_ELEMENT_FACTORY);
+
+  start = gst_util_get_timestamp ();
+  n_templates = touch_factories (factories);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - reading details of %d factories, "
+      "%u pad templates\n", GST_TIME_ARGS (end - start),
+      g_list_length (factories), n_templates);
+
+  start = gst_util_get_timestamp ();
+  touch_factories (factories);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - reading details again\n",
+      GST_TIME_ARGS (end - start));
+
+  g_print ("%ld kB - max RSS after reading all details\n", get_max_rss ());
+
+  gst_plugin_feature_list_free (factories);
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+/* GStreamer
+ *
+ * structure.c: benchmark for field access on structures of different sizes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/gst.h>
+
+#define NUM_ITERATIONS 100
+
+static void
+run_benchmark (guint n_fields)
+{
+  GstStructure *s;
+  GstClockTime start, end;
+  GQuark *names;
+  gchar *str;
+  guint i, j;
+  gint val;
+
+  names = g_new (GQuark, n_fields);
+  for (i = 0; i < n_fields; i++) {
+    gchar *name = g_strdup_printf ("field-%u", i);
+
+    names[i] = g_quark_from_string (name);
+    g_free (name);
+  }
+
+  start = gst_util_get_timestamp ();
+  for (j = 0; j < NUM_ITERATIONS; j++) {
+    s = gst_structure_new_empty ("application/x-benchmark");
+    for (i = 0; i < n_fields; i++)
+      gst_structure_id_set (s, names[i], G_TYPE_INT, i, NULL);
+    if (j < NUM_ITERATIONS - 1)
+      gst_structure_free (s);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %u fields: building %d structures\n",
+      GST_TIME_ARGS (end - start), n_fields, NUM_ITERATIONS);
+
+  start = gst_util_get_timestamp ();
+  for (j = 0; j < NUM_ITERATIONS; j++) {
+    for (i = 0; i < n_fields; i++)
+      gst_structure_id_set (s, names[i], G_TYPE_INT, j, NULL);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %u fields: %d x replacing all fields\n",
+      GST_TIME_ARGS (end - start), n_fields, NUM_ITERATIONS);
+
+  start = gst_util_get_timestamp ();
+  for (j = 0; j < NUM_ITERATIONS; j++) {
+    for (i = 0; i < n_fields; i++)
+      gst_structure_id_get (s, names[i], G_TYPE_INT, &val, NULL);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %u fields: %d x getting all fields\n",
+      GST_TIME_ARGS (end - start), n_fields, NUM_ITERATIONS);
+
+  start = gst_util_get_timestamp ();
+  for (j = 0; j < NUM_ITERATIONS; j++) {
+    str = gst_structure_to_string (s);
+    g_free (str);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %u fields: %d x serializing\n",
+      GST_TIME_ARGS (end - start), n_fields, NUM_ITERATIONS);
+
+  str = gst_structure_to_string (s);
+  gst_structure_free (s);
+  start = gst_util_get_timestamp ();
+  for (j = 0; j < NUM_ITERATIONS; j++) {
+    s = gst_structure_from_string (str, NULL);
+    gst_structure_free (s);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %u fields: %d x deserializing\n",
+      GST_TIME_ARGS (end - start), n_fields, NUM_ITERATIONS);
+
+  g_free (str);
+  g_free (names);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gst_init (&argc, &argv);
+
+  run_benchmark (10);
+  run_benchmark (100);
+  run_benchmark (1000);
+
+  return 0;
+}
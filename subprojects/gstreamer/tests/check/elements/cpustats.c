@@ -0,0 +1,232 @@
+/* GStreamer
+ *
+ * Unit tests for the cpustats tracer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#define NUM_BUFFERS 50
+/* wall clock time the busy element spins for every buffer */
+#define SPIN_TIME (2 * G_TIME_SPAN_MILLISECOND)
+
+typedef struct
+{
+  guint64 self;
+  guint64 inclusive;
+} ElementTimes;
+
+static GMutex times_lock;
+/* element path -> ElementTimes, summed over all interval reports */
+static GHashTable *times;
+
+static void
+tracer_log_func (GstDebugCategory * category,
+    GstDebugLevel level, const gchar * file, const gchar * function,
+    gint line, GObject * object, GstDebugMessage * message, gpointer unused)
+{
+  GstStructure *s;
+  const gchar *dbg_msg, *name;
+  ElementTimes *t;
+  guint64 self_time, inclusive;
+  gboolean final;
+
+  if (level != GST_LEVEL_TRACE || !g_str_equal (category->name, "GST_TRACER"))
+    return;
+
+  dbg_msg = gst_debug_message_get (message);
+  if (!g_str_has_prefix (dbg_msg, "element-cpu,"))
+    return;
+
+  s = gst_structure_from_string (dbg_msg, NULL);
+  fail_unless (s != NULL);
+  name = gst_structure_get_string (s, "element");
+  fail_unless (name != NULL);
+  fail_unless (gst_structure_get_uint64 (s, "self", &self_time));
+  fail_unless (gst_structure_get_uint64 (s, "inclusive", &inclusive));
+  fail_unless (gst_structure_get_boolean (s, "final", &final));
+  /* the totals are only logged when the tracer is destroyed at deinit */
+  fail_if (final);
+
+  g_mutex_lock (&times_lock);
+  t = g_hash_table_lookup (times, name);
+  if (t == NULL) {
+    t = g_new0 (ElementTimes, 1);
+    g_hash_table_insert (times, g_strdup (name), t);
+  }
+  t->self += self_time;
+  t->inclusive += inclusive;
+  g_mutex_unlock (&times_lock);
+
+  gst_structure_free (s);
+}
+
+static ElementTimes *
+get_element_times (const gchar * suffix)
+{
+  GHashTableIter iter;
+  const gchar *name;
+  ElementTimes *t, *res = NULL;
+
+  g_mutex_lock (&times_lock);
+  g_hash_table_iter_init (&iter, times);
+  while (g_hash_table_iter_next (&iter, (gpointer *) & name,
+          (gpointer *) & t)) {
+    if (g_str_has_suffix (name, suffix)) {
+      res = t;
+      break;
+    }
+  }
+  g_mutex_unlock (&times_lock);
+
+  fail_unless (res != NULL, "no cpu time reported for %s", suffix);
+  return res;
+}
+
+static void
+setup (void)
+{
+  times = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  gst_debug_remove_log_function (gst_debug_log_default);
+  gst_debug_add_log_function (tracer_log_func, NULL, NULL);
+  gst_debug_set_threshold_for_name ("GST_TRACER", GST_LEVEL_TRACE);
+}
+
+static void
+cleanup (void)
+{
+  gst_debug_set_threshold_for_name ("GST_TRACER", GST_LEVEL_NONE);
+  gst_debug_add_log_function (gst_debug_log_default, NULL, NULL);
+  gst_debug_remove_log_function (tracer_log_func);
+  g_hash_table_unref (times);
+  times = NULL;
+}
+
+static void
+run_pipeline (GstElement * pipeline)
+{
+  GstBus *bus;
+  GstMessage *msg;
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  /* joins the streaming thread, so it left all elements */
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipeline);
+}
+
+static void
+spin_handoff (GstElement * identity, GstBuffer * buffer, gpointer user_data)
+{
+  gint64 end = g_get_monotonic_time () + SPIN_TIME;
+
+  /* burn cpu instead of sleeping, only cpu time is accounted */
+  do {
+  } while (g_get_monotonic_time () < end);
+}
+
+GST_START_TEST (test_busy_element)
+{
+  GstElement *pipeline, *busy;
+  ElementTimes *src, *identity, *sink;
+
+  pipeline = gst_parse_launch ("fakesrc name=src num-buffers="
+      G_STRINGIFY (NUM_BUFFERS) " ! identity name=busy signal-handoffs=true ! "
+      "fakesink name=sink sync=false", NULL);
+  fail_unless (pipeline != NULL);
+  busy = gst_bin_get_by_name (GST_BIN (pipeline), "busy");
+  g_signal_connect (busy, "handoff", G_CALLBACK (spin_handoff), NULL);
+  gst_object_unref (busy);
+
+  run_pipeline (pipeline);
+
+  /* the times of the last interval are only reported by the next push after
+   * the interval elapsed */
+  g_usleep (10 * G_TIME_SPAN_MILLISECOND);
+  pipeline = gst_parse_launch ("fakesrc num-buffers=1 ! fakesink sync=false",
+      NULL);
+  fail_unless (pipeline != NULL);
+  run_pipeline (pipeline);
+
+  src = get_element_times ("/GstFakeSrc:src");
+  identity = get_element_times ("/GstIdentity:busy");
+  sink = get_element_times ("/GstFakeSink:sink");
+
+  GST_INFO ("src: self %" G_GUINT64_FORMAT " inclusive %" G_GUINT64_FORMAT,
+      src->self, src->inclusive);
+  GST_INFO ("busy: self %" G_GUINT64_FORMAT " inclusive %" G_GUINT64_FORMAT,
+      identity->self, identity->inclusive);
+  GST_INFO ("sink: self %" G_GUINT64_FORMAT " inclusive %" G_GUINT64_FORMAT,
+      sink->self, sink->inclusive);
+
+  /* the inclusive time contains the self time */
+  fail_unless (src->self <= src->inclusive);
+  fail_unless (identity->self <= identity->inclusive);
+  fail_unless (sink->self <= sink->inclusive);
+
+  /* the spinning is attributed to the identity and not to its peers, allow
+   * for the thread not being scheduled for part of the spinning */
+  fail_unless (identity->self >= NUM_BUFFERS * SPIN_TIME * GST_USECOND / 2,
+      "busy element self time too low: %" G_GUINT64_FORMAT, identity->self);
+  fail_unless (identity->self > 10 * src->self,
+      "src self time %" G_GUINT64_FORMAT " too high", src->self);
+  fail_unless (identity->self > 10 * sink->self,
+      "sink self time %" G_GUINT64_FORMAT " too high", sink->self);
+
+  /* the source called the identity, so it includes its time */
+  fail_unless (src->inclusive >= identity->self);
+}
+
+GST_END_TEST;
+
+static Suite *
+cpustats_suite (void)
+{
+  Suite *s = suite_create ("cpustats");
+  TCase *tc_chain = tcase_create ("report");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, setup, cleanup);
+  tcase_add_test (tc_chain, test_busy_element);
+
+  return s;
+}
+
+/* Replacement for GST_CHECK_MAIN (cpustats); because we need to set the
+ * env before gst_init() is called */
+int
+main (int argc, char **argv)
+{
+  Suite *s;
+
+  g_setenv ("GST_TRACERS", "cpustats(report-interval=1)", TRUE);
+  gst_check_init (&argc, &argv);
+  s = cpustats_suite ();
+  return gst_check_run_suite (s, "cpustats", __FILE__);
+}
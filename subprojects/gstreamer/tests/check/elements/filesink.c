@@ -565,6 +565,87 @@ GST_START_TEST (test_buffered_write_6_3)
 
 GST_END_TEST;
 
+static void
+test_async_write (const gchar * buffer_mode)
+{
+  GstElement *filesink;
+  GstStructure *stats;
+  GstSegment segment;
+  gchar *tmp_fn, *contents;
+  gsize length;
+  guint64 writes, bytes_written;
+  guint i, j;
+
+  tmp_fn = create_temporary_file ();
+  if (!tmp_fn)
+    return;
+
+  filesink = setup_filesink ();
+  gst_util_set_object_arg (G_OBJECT (filesink), "buffer-mode", buffer_mode);
+  g_object_set (filesink, "location", tmp_fn, "max-pending-writes", 2,
+      "buffer-size", 1024, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_stream_start ("test")));
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  /* more buffers than writes may be pending */
+  for (i = 0; i < 32; i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, 100, NULL);
+
+    gst_buffer_memset (buf, 0, i, 100);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buf), GST_FLOW_OK);
+    CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, (i + 1) * 100);
+  }
+
+  /* everything is written once EOS is handled */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  fail_unless (g_file_get_contents (tmp_fn, &contents, &length, NULL));
+  fail_unless_equals_int (length, 3200);
+  for (i = 0; i < 32; i++) {
+    for (j = 0; j < 100; j++)
+      fail_unless_equals_int (contents[i * 100 + j], i);
+  }
+  g_free (contents);
+
+  g_object_get (filesink, "write-stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "writes", &writes));
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-written",
+          &bytes_written));
+  fail_unless (writes > 0);
+  fail_unless_equals_uint64 (bytes_written, 3200);
+  gst_structure_free (stats);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  cleanup_filesink (filesink);
+
+  g_remove (tmp_fn);
+  g_free (tmp_fn);
+}
+
+GST_START_TEST (test_async_write_unbuffered)
+{
+  test_async_write ("unbuffered");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_async_write_buffered)
+{
+  test_async_write ("default");
+  test_async_write ("full");
+}
+
+GST_END_TEST;
+
 static Suite *
 filesink_suite (void)
 {
@@ -580,6 +661,8 @@ filesink_suite (void)
   tcase_add_test (tc_chain, test_buffered_write_17_1);
   tcase_add_test (tc_chain, test_buffered_write_9_2);
   tcase_add_test (tc_chain, test_buffered_write_6_3);
+  tcase_add_test (tc_chain, test_async_write_unbuffered);
+  tcase_add_test (tc_chain, test_async_write_buffered);
 
   return s;
 }
@@ -174,7 +174,9 @@ GST_START_TEST (test_pull)
 
   src = setup_filesrc ();
 
-  g_object_set (G_OBJECT (src), "location", TESTFILE, NULL);
+  /* run once reading and once mapping the file */
+  g_object_set (G_OBJECT (src), "location", TESTFILE, "use-mmap", __i__ != 0,
+      NULL);
   fail_unless (gst_element_set_state (src,
           GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS,
       "could not set to ready");
@@ -303,6 +305,83 @@ GST_START_TEST (test_pull)
 
 GST_END_TEST;
 
+#ifdef HAVE_MMAP
+GST_START_TEST (test_mmap)
+{
+  GstElement *src;
+  GstPad *pad;
+  GstFlowReturn ret;
+  GstBuffer *buffer1, *buffer2, *buffer3;
+  GstMemory *mem1, *mem2;
+  GstMapInfo info1, info3;
+  gsize offset;
+
+  src = setup_filesrc ();
+
+  g_object_set (G_OBJECT (src), "location", TESTFILE, "use-mmap", TRUE, NULL);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to ready");
+
+  pad = gst_element_get_static_pad (src, "src");
+  fail_unless (pad != NULL);
+  fail_unless (gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, TRUE));
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  buffer1 = NULL;
+  ret = gst_pad_get_range (pad, 0, 100, &buffer1);
+  fail_unless (ret == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer1), 100);
+
+  buffer2 = NULL;
+  ret = gst_pad_get_range (pad, 100, 50, &buffer2);
+  fail_unless (ret == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer2), 50);
+
+  /* the data is read-only and adjacent ranges are contiguous */
+  mem1 = gst_buffer_peek_memory (buffer1, 0);
+  mem2 = gst_buffer_peek_memory (buffer2, 0);
+  fail_unless (GST_MEMORY_IS_READONLY (mem1));
+  fail_unless (gst_memory_is_span (mem1, mem2, &offset));
+  fail_unless_equals_int (offset, 0);
+
+  /* compare with a single pull covering both */
+  buffer3 = NULL;
+  ret = gst_pad_get_range (pad, 0, 150, &buffer3);
+  fail_unless (ret == GST_FLOW_OK);
+  fail_unless (gst_buffer_map (buffer3, &info3, GST_MAP_READ));
+  fail_unless (gst_buffer_map (buffer1, &info1, GST_MAP_READ));
+  fail_unless (memcmp (info1.data, info3.data, 100) == 0);
+  gst_buffer_unmap (buffer1, &info1);
+  fail_unless (gst_buffer_memcmp (buffer2, 0, info3.data + 100, 50) == 0);
+  gst_buffer_unmap (buffer3, &info3);
+  gst_buffer_unref (buffer3);
+
+  /* the mapping stays valid after stopping as long as buffers use it */
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  /* mapping merges both memories into one pointing into the file again */
+  buffer1 = gst_buffer_append (buffer1, buffer2);
+  fail_unless (gst_buffer_map (buffer1, &info1, GST_MAP_READ));
+  fail_unless_equals_int (info1.size, 150);
+  gst_buffer_unmap (buffer1, &info1);
+  fail_unless_equals_int (gst_buffer_n_memory (buffer1), 1);
+  fail_unless (gst_memory_is_type (gst_buffer_peek_memory (buffer1, 0),
+          "FileSrcMmap"));
+  gst_buffer_unref (buffer1);
+
+  /* cleanup */
+  gst_object_unref (pad);
+  cleanup_filesrc (src);
+}
+
+GST_END_TEST;
+#endif
+
 GST_START_TEST (test_coverage)
 {
   GstElement *src;
@@ -553,7 +632,10 @@ filesrc_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_seeking);
   tcase_add_test (tc_chain, test_reverse);
-  tcase_add_test (tc_chain, test_pull);
+  tcase_add_loop_test (tc_chain, test_pull, 0, 2);
+#ifdef HAVE_MMAP
+  tcase_add_test (tc_chain, test_mmap);
+#endif
   tcase_add_test (tc_chain, test_coverage);
   tcase_add_test (tc_chain, test_uri_interface);
   tcase_add_test (tc_chain, test_uri_query);
@@ -0,0 +1,261 @@
+/* GStreamer
+ *
+ * Unit tests for the histograms of the latency tracer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+/* not public API */
+#undef GST_CAT_DEFAULT
+#include "../../../plugins/tracers/gstlatency.c"
+
+static GList *summaries;        /* NULL */
+
+static void
+tracer_log_func (GstDebugCategory * category,
+    GstDebugLevel level, const gchar * file, const gchar * function,
+    gint line, GObject * object, GstDebugMessage * message, gpointer unused)
+{
+  const gchar *dbg_msg;
+  GstStructure *s;
+
+  if (level != GST_LEVEL_TRACE || !g_str_equal (category->name, "GST_TRACER"))
+    return;
+
+  dbg_msg = gst_debug_message_get (message);
+  if (!g_str_has_prefix (dbg_msg, "latency-summary,") &&
+      !g_str_has_prefix (dbg_msg, "element-latency-summary,"))
+    return;
+
+  s = gst_structure_from_string (dbg_msg, NULL);
+  fail_unless (s != NULL);
+  summaries = g_list_append (summaries, s);
+}
+
+static void
+setup (void)
+{
+  gst_debug_remove_log_function (gst_debug_log_default);
+  gst_debug_add_log_function (tracer_log_func, NULL, NULL);
+  gst_debug_set_threshold_for_name ("GST_TRACER", GST_LEVEL_TRACE);
+  summaries = NULL;
+}
+
+static void
+cleanup (void)
+{
+  gst_debug_set_threshold_for_name ("GST_TRACER", GST_LEVEL_NONE);
+  gst_debug_add_log_function (gst_debug_log_default, NULL, NULL);
+  gst_debug_remove_log_function (tracer_log_func);
+  g_list_free_full (summaries, (GDestroyNotify) gst_structure_free);
+  summaries = NULL;
+}
+
+static GstLatencyTracer *
+create_tracer (void)
+{
+  GstLatencyTracer *tracer;
+
+  tracer = g_object_new (gst_latency_tracer_get_type (), "params",
+      "histogram=true", NULL);
+  gst_object_ref_sink (tracer);
+  fail_unless (tracer->histogram);
+
+  /* the test passes the timestamps itself */
+  tracer->report_interval = GST_SECOND;
+  tracer->last_report = 0;
+
+  return tracer;
+}
+
+static void
+add_pipeline_latency (GstLatencyTracer * tracer, GstClockTimeDiff latency,
+    guint64 ts)
+{
+  add_to_histogram (tracer, g_strdup ("0x1"), g_strdup ("src"),
+      g_strdup ("src"), g_strdup ("0x2"), g_strdup ("sink"), g_strdup ("sink"),
+      latency, ts);
+}
+
+/* the reported percentiles are the upper end of a bucket, which is at most
+ * 1/32 above the exact value */
+static void
+check_percentile (const GstStructure * s, const gchar * field, guint64 exact)
+{
+  guint64 value;
+
+  fail_unless (gst_structure_get_uint64 (s, field, &value));
+  fail_unless (value >= exact && value <= exact + exact / 32,
+      "%s is %" G_GUINT64_FORMAT ", expected about %" G_GUINT64_FORMAT,
+      field, value, exact);
+}
+
+static void
+check_summary (const GstStructure * s, gboolean final, guint64 count,
+    guint64 min, guint64 p50, guint64 p99, guint64 p999, guint64 max)
+{
+  guint64 value;
+  gboolean is_final;
+
+  fail_unless (gst_structure_get_boolean (s, "final", &is_final));
+  fail_unless_equals_int (is_final, final);
+  fail_unless (gst_structure_get_uint64 (s, "count", &value));
+  fail_unless_equals_uint64 (value, count);
+  fail_unless (gst_structure_get_uint64 (s, "min", &value));
+  fail_unless_equals_uint64 (value, min);
+  check_percentile (s, "p50", p50);
+  check_percentile (s, "p99", p99);
+  check_percentile (s, "p999", p999);
+  fail_unless (gst_structure_get_uint64 (s, "max", &value));
+  fail_unless_equals_uint64 (value, max);
+}
+
+GST_START_TEST (test_histogram_bucket)
+{
+  guint64 value;
+  guint bucket;
+
+  /* small values are exact */
+  for (value = 0; value < HISTOGRAM_SUB_BUCKETS; value++) {
+    fail_unless_equals_int (histogram_bucket (value), value);
+    fail_unless_equals_uint64 (histogram_bucket_max (value), value);
+  }
+
+  /* every value is at most the maximum of its bucket and above the maximum of
+   * the bucket before */
+  for (value = HISTOGRAM_SUB_BUCKETS; value < G_GUINT64_CONSTANT (1) << 40;
+      value += value / 7 + 1) {
+    bucket = histogram_bucket (value);
+    fail_unless (bucket < HISTOGRAM_N_BUCKETS);
+    fail_unless (value <= histogram_bucket_max (bucket));
+    fail_unless (value > histogram_bucket_max (bucket - 1));
+    fail_unless (histogram_bucket_max (bucket) <= value + value / 32);
+  }
+
+  /* huge values end up in the last bucket */
+  fail_unless_equals_int (histogram_bucket (G_MAXUINT64),
+      HISTOGRAM_N_BUCKETS - 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_histogram_percentiles)
+{
+  GstLatencyTracer *tracer;
+  GHashTableIter iter;
+  LatencyStats *stats;
+  guint i;
+
+  tracer = create_tracer ();
+
+  /* 1000 latencies of 1us to 1ms, in shuffled order */
+  for (i = 0; i < 999; i++)
+    add_pipeline_latency (tracer, ((i * 7) % 1000 + 1) * GST_USECOND, 0);
+  fail_unless (summaries == NULL);
+
+  /* the last one ends the interval */
+  add_pipeline_latency (tracer, ((999 * 7) % 1000 + 1) * GST_USECOND,
+      GST_SECOND);
+  fail_unless_equals_int (g_list_length (summaries), 1);
+  fail_unless (gst_structure_has_name (summaries->data, "latency-summary"));
+  fail_unless_equals_string (gst_structure_get_string (summaries->data,
+          "src-element"), "src");
+  fail_unless_equals_string (gst_structure_get_string (summaries->data,
+          "sink-element"), "sink");
+  check_summary (summaries->data, FALSE, 1000, 1 * GST_USECOND,
+      500 * GST_USECOND, 990 * GST_USECOND, 999 * GST_USECOND, GST_MSECOND);
+
+  /* the next interval only contains the new latencies */
+  for (i = 0; i < 9; i++)
+    add_pipeline_latency (tracer, 5 * GST_MSECOND, GST_SECOND + i);
+  fail_unless_equals_int (g_list_length (summaries), 1);
+  add_pipeline_latency (tracer, 5 * GST_MSECOND, 2 * GST_SECOND);
+  fail_unless_equals_int (g_list_length (summaries), 2);
+  check_summary (summaries->next->data, FALSE, 10, 5 * GST_MSECOND,
+      5 * GST_MSECOND, 5 * GST_MSECOND, 5 * GST_MSECOND, 5 * GST_MSECOND);
+
+  /* an interval without latencies is not reported */
+  g_mutex_lock (&tracer->lock);
+  report_histograms (tracer, 3 * GST_SECOND);
+  g_mutex_unlock (&tracer->lock);
+  fail_unless_equals_int (g_list_length (summaries), 2);
+
+  /* the totals contain all of them */
+  g_mutex_lock (&tracer->lock);
+  fail_unless_equals_int (g_hash_table_size (tracer->stats), 1);
+  g_hash_table_iter_init (&iter, tracer->stats);
+  fail_unless (g_hash_table_iter_next (&iter, NULL, (gpointer *) & stats));
+  log_latency_summary (stats, &stats->total, TRUE, 3 * GST_SECOND);
+  g_mutex_unlock (&tracer->lock);
+  fail_unless_equals_int (g_list_length (summaries), 3);
+  check_summary (g_list_last (summaries)->data, TRUE, 1010, 1 * GST_USECOND,
+      505 * GST_USECOND, GST_MSECOND, 5 * GST_MSECOND, 5 * GST_MSECOND);
+
+  /* the hooks keep a reference */
+  gst_object_unref (tracer);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_histogram_element)
+{
+  GstLatencyTracer *tracer;
+  guint i;
+
+  tracer = create_tracer ();
+
+  /* 99 fast buffers and one slow one */
+  for (i = 0; i < 100; i++) {
+    add_to_histogram (tracer, g_strdup ("0x1"), g_strdup ("identity"),
+        g_strdup ("src"), NULL, NULL, NULL,
+        i == 50 ? 40 * GST_MSECOND : 100 * GST_USECOND,
+        i == 99 ? GST_SECOND : 0);
+  }
+
+  fail_unless_equals_int (g_list_length (summaries), 1);
+  fail_unless (gst_structure_has_name (summaries->data,
+          "element-latency-summary"));
+  fail_unless_equals_string (gst_structure_get_string (summaries->data,
+          "element"), "identity");
+  check_summary (summaries->data, FALSE, 100, 100 * GST_USECOND,
+      100 * GST_USECOND, 100 * GST_USECOND, 40 * GST_MSECOND, 40 * GST_MSECOND);
+
+  gst_object_unref (tracer);
+}
+
+GST_END_TEST;
+
+static Suite *
+latency_tracer_suite (void)
+{
+  Suite *s = suite_create ("latency tracer");
+  TCase *tc_chain = tcase_create ("histogram");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, setup, cleanup);
+  tcase_add_test (tc_chain, test_histogram_bucket);
+  tcase_add_test (tc_chain, test_histogram_percentiles);
+  tcase_add_test (tc_chain, test_histogram_element);
+
+  return s;
+}
+
+GST_CHECK_MAIN (latency_tracer);
@@ -1181,6 +1181,322 @@ GST_START_TEST (test_initial_events_nodelay)
 
 GST_END_TEST;
 
+GST_START_TEST (test_lockless_dataflow)
+{
+  GstSegment segment;
+  GstBuffer *buffer;
+  GstQuery *query;
+  GList *l;
+  guint i;
+
+  g_object_set (queue, "lockless", TRUE, "max-size-buffers", 10, NULL);
+
+  mysinkpad = gst_check_setup_sink_pad (queue, &sinktemplate);
+  gst_pad_set_event_function (mysinkpad, event_func);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment));
+
+  for (i = 0; i < 1000; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_PTS (buffer) = i * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+
+    /* serialized queries are only answered after all data before them */
+    if (i == 500) {
+      query = gst_query_new_drain ();
+      gst_pad_peer_query (mysrcpad, query);
+      gst_query_unref (query);
+
+      g_mutex_lock (&check_mutex);
+      fail_unless_equals_int (g_list_length (buffers), 501);
+      g_mutex_unlock (&check_mutex);
+    }
+  }
+  gst_pad_push_event (mysrcpad, gst_event_new_eos ());
+
+  g_mutex_lock (&events_lock);
+  while (events_count < 3) {
+    g_cond_wait (&events_cond, &events_lock);
+  }
+  g_mutex_unlock (&events_lock);
+
+  fail_unless_equals_int (GST_EVENT_TYPE (g_list_nth_data (events, 2)),
+      GST_EVENT_EOS);
+  fail_unless_equals_int (g_list_length (buffers), 1000);
+  for (l = buffers, i = 0; l; l = l->next, i++)
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data), i * GST_MSECOND);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_lockless_time_level)
+{
+  GstBuffer *buffer;
+  GstClockTime time;
+  GstSegment segment;
+  guint level;
+
+  g_signal_connect (queue, "overrun",
+      G_CALLBACK (queue_overrun_link_and_activate), NULL);
+  g_object_set (G_OBJECT (queue), "lockless", TRUE, "max-size-buffers", 3,
+      "max-size-time", 7 * GST_SECOND, NULL);
+
+  block_src ();
+
+  UNDERRUN_LOCK ();
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  UNDERRUN_WAIT ();
+  UNDERRUN_UNLOCK ();
+
+  /* the stream-start event stays blocked in the src pad */
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment));
+
+  buffer = gst_buffer_new_and_alloc (4);
+  GST_BUFFER_TIMESTAMP (buffer) = GST_SECOND;
+  gst_pad_push (mysrcpad, buffer);
+
+  g_object_get (G_OBJECT (queue), "current-level-time", &time,
+      "current-level-buffers", &level, NULL);
+  fail_unless_equals_uint64 (time, GST_SECOND);
+  fail_unless_equals_int (level, 1);
+
+  buffer = gst_buffer_new_and_alloc (4);
+  GST_BUFFER_TIMESTAMP (buffer) = 3 * GST_SECOND;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND;
+  gst_pad_push (mysrcpad, buffer);
+
+  g_object_get (G_OBJECT (queue), "current-level-time", &time,
+      "current-level-buffers", &level, NULL);
+  fail_unless_equals_uint64 (time, 4 * GST_SECOND);
+  fail_unless_equals_int (level, 2);
+
+  buffer = gst_buffer_new_and_alloc (4);
+  GST_BUFFER_TIMESTAMP (buffer) = 4 * GST_SECOND;
+  gst_pad_push (mysrcpad, buffer);
+
+  g_object_get (G_OBJECT (queue), "current-level-bytes", &level, NULL);
+  fail_unless_equals_int (level, 12);
+
+  /* the fourth push fills the queue and links the src pad in the overrun
+   * handler, after that the queue drains */
+  fail_unless (overrun_count == 0);
+  buffer = gst_buffer_new_and_alloc (4);
+  GST_BUFFER_TIMESTAMP (buffer) = 5 * GST_SECOND;
+  gst_pad_push (mysrcpad, buffer);
+  fail_unless (overrun_count == 1);
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 4)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  GST_DEBUG ("stopping");
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_END_TEST;
+
+static GMutex blocked_lock;
+static GCond blocked_cond;
+static gboolean blocked;
+static gboolean released;
+
+/* blocks in the first buffer until released */
+static GstFlowReturn
+blocking_chain_func (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  g_mutex_lock (&blocked_lock);
+  if (!blocked) {
+    blocked = TRUE;
+    g_cond_broadcast (&blocked_cond);
+    while (!released)
+      g_cond_wait (&blocked_cond, &blocked_lock);
+  }
+  g_mutex_unlock (&blocked_lock);
+
+  g_mutex_lock (&check_mutex);
+  buffers = g_list_append (buffers, buffer);
+  g_cond_signal (&check_cond);
+  g_mutex_unlock (&check_mutex);
+
+  return GST_FLOW_OK;
+}
+
+/* with downstream blocked the ring fills up, the queue has to keep leaking
+ * the oldest buffers instead of the newest ones */
+GST_START_TEST (test_lockless_leaky_downstream_blocked)
+{
+  GstSegment segment;
+  GstBuffer *buffer;
+  GList *l;
+  guint i;
+
+  g_mutex_init (&blocked_lock);
+  g_cond_init (&blocked_cond);
+  blocked = released = FALSE;
+
+  g_object_set (queue, "lockless", TRUE, "max-size-buffers", 2,
+      "max-size-bytes", 0, "max-size-time", G_GUINT64_CONSTANT (0),
+      "leaky", 2, NULL);
+
+  mysinkpad = gst_check_setup_sink_pad (queue, &sinktemplate);
+  gst_pad_set_chain_function (mysinkpad, blocking_chain_func);
+  gst_pad_set_event_function (mysinkpad, event_func);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment));
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = 0;
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+
+  g_mutex_lock (&blocked_lock);
+  while (!blocked)
+    g_cond_wait (&blocked_cond, &blocked_lock);
+  g_mutex_unlock (&blocked_lock);
+
+  /* more than the ring can hold, none of this may block */
+  for (i = 1; i <= 200; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_PTS (buffer) = i * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+  }
+
+  g_mutex_lock (&blocked_lock);
+  released = TRUE;
+  g_cond_broadcast (&blocked_cond);
+  g_mutex_unlock (&blocked_lock);
+
+  gst_pad_push_event (mysrcpad, gst_event_new_eos ());
+
+  g_mutex_lock (&events_lock);
+  while (events_count < 3)
+    g_cond_wait (&events_cond, &events_lock);
+  g_mutex_unlock (&events_lock);
+
+  /* the blocked buffer, then only the newest ones */
+  fail_unless (g_list_length (buffers) >= 2);
+  fail_unless (g_list_length (buffers) <= 3);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buffers->data), 0);
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buffers->next->data,
+          GST_BUFFER_FLAG_DISCONT));
+  for (l = buffers->next; l; l = l->next)
+    fail_unless (GST_BUFFER_PTS (l->data) >= 198 * GST_MSECOND);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (g_list_last (buffers)->data),
+      200 * GST_MSECOND);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  g_mutex_clear (&blocked_lock);
+  g_cond_clear (&blocked_cond);
+}
+
+GST_END_TEST;
+
+static GstBusSyncReply
+coop_sync_handler (GstBus * bus, GstMessage * message, GstTaskPool * pool)
+{
+  GstStreamStatusType type;
+  GstElement *owner;
+  const GValue *val;
+
+  if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_STREAM_STATUS)
+    return GST_BUS_PASS;
+
+  gst_message_parse_stream_status (message, &type, &owner);
+  val = gst_message_get_stream_status_object (message);
+  if (type == GST_STREAM_STATUS_TYPE_CREATE && g_str_equal (GST_OBJECT_NAME
+          (owner), "q") && G_VALUE_HOLDS (val, GST_TYPE_TASK))
+    gst_task_set_pool (g_value_get_object (val), pool);
+
+  return GST_BUS_PASS;
+}
+
+static void
+coop_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gint * count)
+{
+  g_atomic_int_inc (count);
+}
+
+/* the srcpad task returns to the cooperative pool while the queue is empty,
+ * with and without the lockless ring */
+GST_START_TEST (test_cooperative_task_pool)
+{
+  GstElement *pipeline, *sink;
+  GstTaskPool *pool;
+  GstMessage *msg;
+  GstBus *bus;
+  GError *err = NULL;
+  gint lockless, count;
+  gchar *desc;
+
+  pool = gst_cooperative_task_pool_new ();
+  gst_cooperative_task_pool_set_n_workers (GST_COOPERATIVE_TASK_POOL (pool),
+      1);
+  gst_task_pool_prepare (pool, &err);
+  fail_unless (err == NULL);
+
+  for (lockless = 0; lockless < 2; lockless++) {
+    desc = g_strdup_printf ("fakesrc num-buffers=1000 ! queue name=q "
+        "lockless=%d max-size-buffers=10 ! fakesink name=sink sync=false "
+        "signal-handoffs=true", lockless);
+    pipeline = gst_parse_launch (desc, NULL);
+    g_free (desc);
+    fail_unless (pipeline != NULL);
+
+    count = 0;
+    sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+    g_signal_connect (sink, "handoff", G_CALLBACK (coop_handoff), &count);
+    gst_object_unref (sink);
+
+    bus = gst_element_get_bus (pipeline);
+    gst_bus_set_sync_handler (bus, (GstBusSyncHandler) coop_sync_handler,
+        pool, NULL);
+
+    fail_unless (gst_element_set_state (pipeline,
+            GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+    msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+    gst_message_unref (msg);
+    fail_unless_equals_int (g_atomic_int_get (&count), 1000);
+
+    fail_unless (gst_element_set_state (pipeline,
+            GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+    gst_bus_set_sync_handler (bus, NULL, NULL, NULL);
+    gst_object_unref (bus);
+    gst_object_unref (pipeline);
+  }
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
 static Suite *
 queue_suite (void)
 {
@@ -1204,6 +1520,10 @@ queue_suite (void)
   tcase_add_test (tc_chain, test_sticky_not_linked);
   tcase_add_test (tc_chain, test_time_level_buffer_list);
   tcase_add_test (tc_chain, test_initial_events_nodelay);
+  tcase_add_test (tc_chain, test_lockless_dataflow);
+  tcase_add_test (tc_chain, test_lockless_time_level);
+  tcase_add_test (tc_chain, test_lockless_leaky_downstream_blocked);
+  tcase_add_test (tc_chain, test_cooperative_task_pool);
 
   return s;
 }
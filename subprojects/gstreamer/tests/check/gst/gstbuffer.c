@@ -967,6 +967,106 @@ GST_START_TEST (test_auto_unmap)
 
 GST_END_TEST;
 
+#define N_MEMORIES 300
+
+/* buffers can hold more memories than fit in the buffer struct without
+ * merging them */
+GST_START_TEST (test_many_memories)
+{
+  GstMemory *mems[N_MEMORIES];
+  GstBuffer *buf, *copy;
+  guint8 data[N_MEMORIES];
+  guint i, max;
+
+  max = gst_buffer_get_max_memory ();
+  fail_unless (max >= N_MEMORIES);
+
+  buf = gst_buffer_new ();
+  for (i = 0; i < N_MEMORIES; i++) {
+    mems[i] = gst_allocator_alloc (NULL, 1, NULL);
+    gst_memory_memset (mems[i], 0, i & 0xff, 1);
+    gst_buffer_append_memory (buf, mems[i]);
+  }
+  fail_unless_equals_int (gst_buffer_n_memory (buf), N_MEMORIES);
+  fail_unless_equals_int (gst_buffer_get_size (buf), N_MEMORIES);
+
+  /* nothing was merged */
+  for (i = 0; i < N_MEMORIES; i++)
+    fail_unless (gst_buffer_peek_memory (buf, i) == mems[i]);
+
+  fail_unless_equals_int (gst_buffer_extract (buf, 0, data, N_MEMORIES),
+      N_MEMORIES);
+  for (i = 0; i < N_MEMORIES; i++)
+    fail_unless_equals_int (data[i], i & 0xff);
+
+  /* shallow copies share all memories */
+  copy = gst_buffer_copy (buf);
+  fail_unless_equals_int (gst_buffer_n_memory (copy), N_MEMORIES);
+  for (i = 0; i < N_MEMORIES; i++)
+    fail_unless (gst_buffer_peek_memory (copy, i) == mems[i]);
+  gst_buffer_unref (copy);
+
+  /* removing and inserting moves the memories around */
+  gst_buffer_remove_memory_range (buf, 0, N_MEMORIES - 1);
+  fail_unless_equals_int (gst_buffer_n_memory (buf), 1);
+  fail_unless (gst_buffer_peek_memory (buf, 0) == mems[N_MEMORIES - 1]);
+  gst_buffer_insert_memory (buf, 0, gst_allocator_alloc (NULL, 1, NULL));
+  fail_unless_equals_int (gst_buffer_n_memory (buf), 2);
+  fail_unless (gst_buffer_peek_memory (buf, 1) == mems[N_MEMORIES - 1]);
+  gst_buffer_unref (buf);
+
+  /* above the maximum the memories are merged again */
+  buf = gst_buffer_new ();
+  for (i = 0; i < max + 1; i++)
+    gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, 1, NULL));
+  fail_unless (gst_buffer_n_memory (buf) <= max);
+  fail_unless_equals_int (gst_buffer_get_size (buf), max + 1);
+  gst_buffer_unref (buf);
+}
+
+GST_END_TEST;
+
+#define N_THREAD_BUFFERS 1000
+
+static gpointer
+unref_buffers (gpointer data)
+{
+  GstBuffer **bufs = data;
+  guint i;
+
+  for (i = 0; i < N_THREAD_BUFFERS; i++)
+    gst_buffer_unref (bufs[i]);
+
+  return NULL;
+}
+
+/* buffer structs are recycled through per-thread free lists, make sure
+ * buffers can be freed in a different thread than they were created in */
+GST_START_TEST (test_free_in_other_thread)
+{
+  GstBuffer **bufs = g_new (GstBuffer *, N_THREAD_BUFFERS);
+  GThread *thread;
+  guint i, round;
+
+  for (round = 0; round < 4; round++) {
+    for (i = 0; i < N_THREAD_BUFFERS; i++) {
+      bufs[i] = gst_buffer_new ();
+      fail_unless_equals_int (gst_buffer_n_memory (bufs[i]), 0);
+      fail_unless (bufs[i]->pool == NULL);
+      fail_unless_equals_uint64 (GST_BUFFER_PTS (bufs[i]),
+          GST_CLOCK_TIME_NONE);
+      GST_BUFFER_PTS (bufs[i]) = i;
+    }
+
+    thread = g_thread_new ("unref", unref_buffers, bufs);
+    g_thread_join (thread);
+  }
+
+  g_free (bufs);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_buffer_suite (void)
 {
@@ -994,6 +1094,8 @@ gst_buffer_suite (void)
   tcase_add_test (tc_chain, test_wrapped_bytes);
   tcase_add_test (tc_chain, test_new_memdup);
   tcase_add_test (tc_chain, test_auto_unmap);
+  tcase_add_test (tc_chain, test_free_in_other_thread);
+  tcase_add_test (tc_chain, test_many_memories);
 
   return s;
 }
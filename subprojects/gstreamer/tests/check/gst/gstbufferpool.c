@@ -38,6 +38,20 @@ create_pool (guint size, guint min_buf, guint max_buf)
   return pool;
 }
 
+static GstBufferPool *
+create_cached_pool (guint size, guint min_buf, guint max_buf)
+{
+  GstBufferPool *pool = gst_buffer_pool_new ();
+  GstStructure *conf = gst_buffer_pool_get_config (pool);
+
+  gst_buffer_pool_config_set_params (conf, NULL, size, min_buf, max_buf);
+  gst_buffer_pool_config_add_option (conf,
+      GST_BUFFER_POOL_OPTION_THREAD_CACHE);
+  fail_unless (gst_buffer_pool_set_config (pool, conf));
+
+  return pool;
+}
+
 static void
 buffer_destroy_notify (gpointer ptr)
 {
@@ -444,6 +458,181 @@ GST_START_TEST (test_make_writable_parent_meta)
 
 GST_END_TEST;
 
+#define N_CACHED_BUFFERS 40
+
+GST_START_TEST (test_thread_cache_recycle)
+{
+  GstBufferPool *pool = create_cached_pool (10, 0, 0);
+  GstBuffer *bufs[N_CACHED_BUFFERS], *prev[N_CACHED_BUFFERS];
+  gint dcount[N_CACHED_BUFFERS] = { 0, };
+  guint i, j;
+
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  /* more buffers than fit into the magazines of one thread */
+  for (i = 0; i < N_CACHED_BUFFERS; i++) {
+    fail_unless (gst_buffer_pool_acquire_buffer (pool, &bufs[i],
+            NULL) == GST_FLOW_OK);
+    buffer_track_destroy (bufs[i], &dcount[i]);
+    prev[i] = bufs[i];
+  }
+  for (i = 0; i < N_CACHED_BUFFERS; i++)
+    gst_buffer_unref (bufs[i]);
+
+  /* all buffers are recycled, no new buffers are allocated */
+  for (i = 0; i < N_CACHED_BUFFERS; i++) {
+    gboolean found = FALSE;
+
+    fail_unless_equals_int (dcount[i], 0);
+    fail_unless (gst_buffer_pool_acquire_buffer (pool, &bufs[i],
+            NULL) == GST_FLOW_OK);
+    for (j = 0; j < N_CACHED_BUFFERS && !found; j++)
+      found = (bufs[i] == prev[j]);
+    fail_unless (found, "got a fresh buffer instead of a cached one");
+  }
+  for (i = 0; i < N_CACHED_BUFFERS; i++)
+    gst_buffer_unref (bufs[i]);
+
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+
+  /* deactivating frees the buffers in the cache */
+  for (i = 0; i < N_CACHED_BUFFERS; i++)
+    fail_unless_equals_int (dcount[i], 1);
+}
+
+GST_END_TEST;
+
+static gpointer
+acquire_and_release_bufs (gpointer p)
+{
+  GstBufferPool *pool = p;
+  GstBuffer *bufs[4];
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (bufs); i++)
+    fail_unless (gst_buffer_pool_acquire_buffer (pool, &bufs[i],
+            NULL) == GST_FLOW_OK);
+  for (i = 0; i < G_N_ELEMENTS (bufs); i++)
+    gst_buffer_unref (bufs[i]);
+
+  return NULL;
+}
+
+GST_START_TEST (test_thread_cache_steal)
+{
+  GstBufferPool *pool = create_cached_pool (10, 0, 4);
+  GstBufferPoolAcquireParams params = { 0, };
+  GstBuffer *bufs[5];
+  GThread *thread;
+  guint i;
+
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  /* all buffers end up in the cache of another thread */
+  thread = g_thread_new (NULL, acquire_and_release_bufs, pool);
+  g_thread_join (thread);
+
+  /* and can still be acquired without waiting */
+  params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+  for (i = 0; i < 4; i++)
+    fail_unless (gst_buffer_pool_acquire_buffer (pool, &bufs[i],
+            &params) == GST_FLOW_OK);
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &bufs[4],
+          &params) == GST_FLOW_EOS);
+
+  for (i = 0; i < 4; i++)
+    gst_buffer_unref (bufs[i]);
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static gpointer
+release_buf_later (gpointer p)
+{
+  g_usleep (G_USEC_PER_SEC / 100);
+  gst_buffer_unref (GST_BUFFER (p));
+  return NULL;
+}
+
+GST_START_TEST (test_thread_cache_wait)
+{
+  GstBufferPool *pool = create_cached_pool (10, 1, 1);
+  GstBuffer *buf1, *buf2;
+  GThread *thread;
+
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf1,
+          NULL) == GST_FLOW_OK);
+  thread = g_thread_new (NULL, release_buf_later, buf1);
+  /* blocks until buf1 is released into the cache of the other thread */
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf2,
+          NULL) == GST_FLOW_OK);
+  fail_unless_equals_pointer (buf1, buf2);
+  g_thread_join (thread);
+
+  gst_buffer_unref (buf2);
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static gpointer
+release_bufs (gpointer p)
+{
+  GstBuffer **bufs = p;
+  guint i;
+
+  for (i = 0; i < N_CACHED_BUFFERS; i++)
+    gst_buffer_unref (bufs[i]);
+
+  return NULL;
+}
+
+GST_START_TEST (test_thread_cache_reuse_released_elsewhere)
+{
+  GstBufferPool *pool = create_cached_pool (10, 0, 0);
+  GstBuffer *bufs[N_CACHED_BUFFERS], *prev[N_CACHED_BUFFERS];
+  GThread *thread;
+  guint i, j;
+
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  for (i = 0; i < N_CACHED_BUFFERS; i++) {
+    fail_unless (gst_buffer_pool_acquire_buffer (pool, &bufs[i],
+            NULL) == GST_FLOW_OK);
+    prev[i] = bufs[i];
+  }
+
+  /* released into the cache of another thread, like downstream does. That
+   * thread keeps two magazines and hands the next full one to the depot */
+  thread = g_thread_new (NULL, release_bufs, bufs);
+  g_thread_join (thread);
+
+  /* the pool is not limited but takes the magazine from the depot instead of
+   * allocating new buffers */
+  for (i = 0; i < 16; i++) {
+    gboolean found = FALSE;
+
+    fail_unless (gst_buffer_pool_acquire_buffer (pool, &bufs[i],
+            NULL) == GST_FLOW_OK);
+    for (j = 0; j < N_CACHED_BUFFERS && !found; j++)
+      found = (bufs[i] == prev[j]);
+    fail_unless (found, "got a fresh buffer instead of a released one");
+  }
+
+  for (i = 0; i < 16; i++)
+    gst_buffer_unref (bufs[i]);
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_buffer_pool_suite (void)
 {
@@ -465,6 +654,10 @@ gst_buffer_pool_suite (void)
   tcase_add_test (tc_chain, test_no_deadlock_for_buffer_discard);
   tcase_add_test (tc_chain, test_parent_meta);
   tcase_add_test (tc_chain, test_make_writable_parent_meta);
+  tcase_add_test (tc_chain, test_thread_cache_recycle);
+  tcase_add_test (tc_chain, test_thread_cache_steal);
+  tcase_add_test (tc_chain, test_thread_cache_wait);
+  tcase_add_test (tc_chain, test_thread_cache_reuse_released_elsewhere);
 
   return s;
 }
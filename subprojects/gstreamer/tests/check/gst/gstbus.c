@@ -926,6 +926,157 @@ GST_START_TEST (test_single_gsource)
 
 GST_END_TEST;
 
+static GstMessage *
+new_level_message (GstObject * src, gint value)
+{
+  return gst_message_new_element (src, gst_structure_new ("level",
+          "value", G_TYPE_INT, value, NULL));
+}
+
+static gint
+get_message_value (GstMessage * msg)
+{
+  gint value = -1;
+
+  gst_structure_get_int (gst_message_get_structure (msg), "value", &value);
+  return value;
+}
+
+GST_START_TEST (test_coalesce)
+{
+  GstObject *src1, *src2;
+  GstStructure *stats;
+  GstMessage *msg;
+  guint64 coalesced, posted;
+  gint i;
+
+  test_bus = gst_bus_new ();
+  src1 = gst_object_ref_sink (gst_bin_new ("src1"));
+  src2 = gst_object_ref_sink (gst_bin_new ("src2"));
+
+  /* queued before coalescing is enabled, stays on the bus */
+  gst_bus_post (test_bus, new_level_message (src1, 0));
+
+  gst_bus_set_coalesce_types (test_bus, GST_MESSAGE_ELEMENT);
+  fail_unless_equals_int (gst_bus_get_coalesce_types (test_bus),
+      GST_MESSAGE_ELEMENT);
+
+  for (i = 1; i <= 10; i++) {
+    gst_bus_post (test_bus, new_level_message (src1, i));
+    gst_bus_post (test_bus, new_level_message (src2, 100 + i));
+  }
+  /* different structure name, not coalesced with the level messages */
+  gst_bus_post (test_bus, gst_message_new_element (src1,
+          gst_structure_new_empty ("other")));
+  /* different type, not coalesced */
+  gst_bus_post (test_bus, gst_message_new_eos (src1));
+
+  msg = gst_bus_pop (test_bus);
+  fail_unless_equals_int (get_message_value (msg), 0);
+  gst_message_unref (msg);
+
+  /* the latest messages are delivered in the place of the first ones */
+  msg = gst_bus_pop (test_bus);
+  fail_unless (GST_MESSAGE_SRC (msg) == src1);
+  fail_unless_equals_int (get_message_value (msg), 10);
+  gst_message_unref (msg);
+  msg = gst_bus_pop (test_bus);
+  fail_unless (GST_MESSAGE_SRC (msg) == src2);
+  fail_unless_equals_int (get_message_value (msg), 110);
+  gst_message_unref (msg);
+
+  msg = gst_bus_pop (test_bus);
+  fail_unless (gst_message_has_name (msg, "other"));
+  gst_message_unref (msg);
+  msg = gst_bus_pop (test_bus);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  fail_if (gst_bus_have_pending (test_bus));
+
+  /* nothing queued any more, a new message is queued again */
+  gst_bus_post (test_bus, new_level_message (src1, 20));
+  msg = gst_bus_pop (test_bus);
+  fail_unless_equals_int (get_message_value (msg), 20);
+  gst_message_unref (msg);
+
+  /* replaced messages are freed when the bus is flushed */
+  gst_bus_post (test_bus, new_level_message (src1, 30));
+  gst_bus_post (test_bus, new_level_message (src1, 31));
+  gst_bus_set_flushing (test_bus, TRUE);
+  fail_if (gst_bus_have_pending (test_bus));
+  fail_if (gst_bus_post (test_bus, new_level_message (src1, 32)));
+
+  stats = gst_bus_get_stats (test_bus);
+  fail_unless (gst_structure_get_uint64 (stats, "posted", &posted));
+  fail_unless (gst_structure_get_uint64 (stats, "coalesced", &coalesced));
+  fail_unless_equals_uint64 (posted, 26);
+  fail_unless_equals_uint64 (coalesced, 19);
+  gst_structure_free (stats);
+
+  gst_object_unref (test_bus);
+  gst_object_unref (src1);
+  gst_object_unref (src2);
+}
+
+GST_END_TEST;
+
+static gboolean
+count_messages_func (GstBus * bus, GstMessage * message, gpointer data)
+{
+  guint *count = data;
+
+  *count += 1;
+
+  return TRUE;
+}
+
+GST_START_TEST (test_max_dispatch)
+{
+  GMainContext *ctx;
+  GSource *source;
+  GstStructure *stats;
+  guint64 dispatches, dispatched;
+  guint count = 0;
+  gint i;
+
+  test_bus = gst_bus_new ();
+  ctx = g_main_context_new ();
+
+  fail_unless_equals_int (gst_bus_get_max_dispatch (test_bus), 1);
+  gst_bus_set_max_dispatch (test_bus, 4);
+
+  source = gst_bus_create_watch (test_bus);
+  g_source_set_callback (source, (GSourceFunc) count_messages_func, &count,
+      NULL);
+  g_source_attach (source, ctx);
+  g_source_unref (source);
+
+  for (i = 0; i < 10; i++)
+    gst_bus_post (test_bus, new_level_message (NULL, i));
+
+  g_main_context_iteration (ctx, FALSE);
+  fail_unless_equals_int (count, 4);
+
+  /* everything that is pending */
+  gst_bus_set_max_dispatch (test_bus, 0);
+  g_main_context_iteration (ctx, FALSE);
+  fail_unless_equals_int (count, 10);
+  fail_if (gst_bus_have_pending (test_bus));
+
+  stats = gst_bus_get_stats (test_bus);
+  fail_unless (gst_structure_get_uint64 (stats, "dispatches", &dispatches));
+  fail_unless (gst_structure_get_uint64 (stats, "dispatched", &dispatched));
+  fail_unless_equals_uint64 (dispatches, 2);
+  fail_unless_equals_uint64 (dispatched, 10);
+  gst_structure_free (stats);
+
+  g_source_destroy (source);
+  g_main_context_unref (ctx);
+  gst_object_unref (test_bus);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_bus_suite (void)
 {
@@ -949,6 +1100,8 @@ gst_bus_suite (void)
   tcase_add_test (tc_chain, test_custom_main_context);
   tcase_add_test (tc_chain, test_async_message);
   tcase_add_test (tc_chain, test_single_gsource);
+  tcase_add_test (tc_chain, test_coalesce);
+  tcase_add_test (tc_chain, test_max_dispatch);
   return s;
 }
 
@@ -1842,6 +1842,52 @@ GST_START_TEST (test_fixed)
 
 GST_END_TEST;
 
+static GstStaticCaps cache_templ_caps =
+GST_STATIC_CAPS ("video/x-raw, format = (string) { I420, NV12 }, "
+    "width = (int) [ 1, 100 ]; video/x-raw, format = (string) RGB; "
+    "image/jpeg; audio/x-raw");
+
+GST_START_TEST (test_intersect_cache)
+{
+  GstCaps *templ, *caps, *res1, *res2;
+
+  templ = gst_static_caps_get (&cache_templ_caps);
+  caps = gst_caps_from_string ("video/x-raw, format = (string) I420, "
+      "width = (int) 50");
+
+  res1 = gst_caps_intersect (templ, caps);
+  res2 = gst_caps_intersect (templ, caps);
+  fail_unless (res1 != res2);
+  fail_unless (gst_caps_is_equal (res1, res2));
+  fail_unless (gst_caps_is_equal (res1, caps));
+  /* the caller owns the results, also when they come from the cache */
+  fail_unless (gst_caps_is_writable (res1));
+  fail_unless (gst_caps_is_writable (res2));
+  gst_caps_unref (res1);
+  gst_caps_unref (res2);
+
+  fail_unless (gst_caps_can_intersect (templ, caps));
+  fail_unless (gst_caps_can_intersect (templ, caps));
+  fail_unless (gst_caps_is_subset (caps, templ));
+  fail_unless (gst_caps_is_subset (caps, templ));
+
+  /* caps of the caller are not kept by the cache */
+  ASSERT_CAPS_REFCOUNT (caps, "caps", 1);
+
+  /* and changing them changes the results */
+  gst_caps_set_simple (caps, "width", G_TYPE_INT, 200, NULL);
+  fail_if (gst_caps_can_intersect (templ, caps));
+  fail_if (gst_caps_is_subset (caps, templ));
+  res1 = gst_caps_intersect (templ, caps);
+  fail_unless (gst_caps_is_empty (res1));
+  gst_caps_unref (res1);
+
+  gst_caps_unref (caps);
+  gst_caps_unref (templ);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_caps_suite (void)
 {
@@ -1880,6 +1926,7 @@ gst_caps_suite (void)
   tcase_add_test (tc_chain, test_equality);
   tcase_add_test (tc_chain, test_remains_any);
   tcase_add_test (tc_chain, test_fixed);
+  tcase_add_test (tc_chain, test_intersect_cache);
 
   return s;
 }
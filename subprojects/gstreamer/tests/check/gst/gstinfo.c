@@ -26,6 +26,7 @@
 #include <gst/check/gstcheck.h>
 
 #include <string.h>
+#include <glib/gstdio.h>
 
 #ifndef GST_DISABLE_GST_DEBUG
 
@@ -263,6 +264,63 @@ GST_START_TEST (info_log_handler_get_line)
 
 GST_END_TEST;
 
+static gboolean
+contains_bytes (const gchar * data, gsize size, const gchar * str)
+{
+  gsize len = strlen (str), i;
+
+  for (i = 0; i + len <= size; i++) {
+    if (memcmp (data + i, str, len) == 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+GST_START_TEST (info_binary_logger)
+{
+  GstElement *e;
+  gchar *filename, *contents;
+  gsize size;
+  gint fd;
+
+  fd = g_file_open_tmp ("gstinfo-XXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+
+  gst_debug_remove_log_function (gst_debug_log_default);
+  fail_unless (gst_debug_add_binary_logger (filename, 4096));
+
+  e = gst_pipeline_new ("binary-logged-pipeline");
+  gst_debug_set_threshold_from_string ("LOG", TRUE);
+  GST_DEBUG ("raw arguments %d %s %" G_GUINT64_FORMAT, 42, "stored-string",
+      G_GUINT64_CONSTANT (7));
+  GST_DEBUG ("formatted %" GST_PTR_FORMAT, e);
+  gst_debug_set_default_threshold (GST_LEVEL_NONE);
+
+  /* writes out everything */
+  gst_debug_remove_binary_logger ();
+  gst_debug_add_log_function (gst_debug_log_default, NULL, NULL);
+
+  fail_unless (g_file_get_contents (filename, &contents, &size, NULL));
+  fail_unless (size > 8);
+  fail_unless (memcmp (contents, "GSTBLOG", 8) == 0);
+
+  /* format strings and arguments are stored, not the formatted message */
+  fail_unless (contains_bytes (contents, size, "raw arguments %d %s %"));
+  fail_unless (contains_bytes (contents, size, "stored-string"));
+  fail_if (contains_bytes (contents, size, "raw arguments 42"));
+  fail_unless (contains_bytes (contents, size, "info_binary_logger"));
+  /* except when there are pointer extensions */
+  fail_unless (contains_bytes (contents, size, "formatted <binary-logged-"));
+
+  g_free (contents);
+  g_unlink (filename);
+  g_free (filename);
+  gst_object_unref (e);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (info_dump_mem)
 {
   GstDebugCategory *cat = NULL;
@@ -573,6 +631,7 @@ gst_info_suite (void)
   tcase_add_test (tc_chain, info_ptr_format_printf_extension);
   tcase_add_test (tc_chain, info_log_handler);
   tcase_add_test (tc_chain, info_log_handler_get_line);
+  tcase_add_test (tc_chain, info_binary_logger);
   tcase_add_test (tc_chain, info_dump_mem);
   tcase_add_test (tc_chain, info_fixme);
   tcase_add_test (tc_chain, info_old_printf_extensions);
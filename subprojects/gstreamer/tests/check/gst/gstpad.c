@@ -1495,6 +1495,73 @@ GST_START_TEST (test_pad_blocking_with_probe_type_idle)
 
 GST_END_TEST;
 
+static guint idle_probe_count;
+
+static GstPadProbeReturn
+idle_probe_count_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  idle_probe_count++;
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+static GstFlowReturn
+idle_probe_add_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstPad *srcpad = gst_pad_get_peer (pad);
+
+  /* the source pad is in use, the probe must be called after the push */
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_IDLE, idle_probe_count_cb,
+      NULL, NULL);
+  fail_unless_equals_int (idle_probe_count, 0);
+
+  gst_object_unref (srcpad);
+  gst_buffer_unref (buf);
+  return GST_FLOW_OK;
+}
+
+/* pushing without probes takes a fast path that does not lock the pad after
+ * pushing, check that idle probes added meanwhile are still called */
+GST_START_TEST (test_pad_idle_probe_added_while_pushing)
+{
+  GstPad *srcpad, *sinkpad;
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  fail_unless (srcpad != NULL);
+  sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  fail_unless (sinkpad != NULL);
+
+  gst_pad_set_chain_function (sinkpad, idle_probe_add_chain);
+
+  fail_unless (gst_pad_link (srcpad, sinkpad) == GST_PAD_LINK_OK);
+
+  gst_pad_set_active (sinkpad, TRUE);
+  gst_pad_set_active (srcpad, TRUE);
+
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_stream_start ("test")) == TRUE);
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_segment (&dummy_segment)) == TRUE);
+
+  idle_probe_count = 0;
+  fail_unless_equals_int (gst_pad_push (srcpad, gst_buffer_new ()),
+      GST_FLOW_OK);
+  fail_unless_equals_int (idle_probe_count, 1);
+  fail_unless_equals_int (srcpad->num_probes, 0);
+
+  /* the first probe is gone, so this takes the fast path again */
+  fail_unless_equals_int (gst_pad_push (srcpad, gst_buffer_new ()),
+      GST_FLOW_OK);
+  fail_unless_equals_int (idle_probe_count, 2);
+
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+}
+
+GST_END_TEST;
+
 static gboolean pull_probe_called;
 static gboolean pull_probe_called_with_bad_type;
 static gboolean pull_probe_called_with_bad_data;
@@ -3423,6 +3490,7 @@ gst_pad_suite (void)
   tcase_add_test (tc_chain, test_pad_blocking_with_probe_type_block);
   tcase_add_test (tc_chain, test_pad_blocking_with_probe_type_blocking);
   tcase_add_test (tc_chain, test_pad_blocking_with_probe_type_idle);
+  tcase_add_test (tc_chain, test_pad_idle_probe_added_while_pushing);
   tcase_add_test (tc_chain, test_pad_probe_pull);
   tcase_add_test (tc_chain, test_pad_probe_pull_idle);
   tcase_add_test (tc_chain, test_pad_probe_pull_buffer);
@@ -325,6 +325,77 @@ GST_START_TEST (test_poll_controllable)
 
 GST_END_TEST;
 
+#define N_SOCKS 100
+
+/* large enough to make the set switch to epoll where available */
+GST_START_TEST (test_poll_many_fds)
+{
+  GstPoll *set;
+  GstPollFD rfds[N_SOCKS];
+  gint wfds[N_SOCKS];
+  GstPollFD wfd = GST_POLL_FD_INIT;
+  guchar c = 'A';
+  gint i;
+
+  set = gst_poll_new (FALSE);
+  fail_if (set == NULL, "Failed to create a GstPoll");
+
+  for (i = 0; i < N_SOCKS; i++) {
+    gint socks[2];
+
+    fail_if (socketpair (PF_UNIX, SOCK_STREAM, 0, socks) < 0,
+        "Could not create a socket pair");
+    gst_poll_fd_init (&rfds[i]);
+    rfds[i].fd = socks[0];
+    wfds[i] = socks[1];
+
+    fail_unless (gst_poll_add_fd (set, &rfds[i]));
+    fail_unless (gst_poll_fd_ctl_read (set, &rfds[i], TRUE));
+  }
+
+  fail_unless (gst_poll_wait (set, 0) == 0, "No descriptor should be ready");
+
+  fail_unless (write (wfds[42], &c, 1) == 1, "write() failed");
+  fail_unless (gst_poll_wait (set, GST_CLOCK_TIME_NONE) == 1,
+      "One descriptor should be available");
+  fail_unless (gst_poll_fd_can_read (set, &rfds[42]));
+  fail_if (gst_poll_fd_can_read (set, &rfds[41]));
+
+  /* readability is reported until the data is read */
+  fail_unless (gst_poll_wait (set, 0) == 1,
+      "One descriptor should still be available");
+  fail_unless (gst_poll_fd_can_read (set, &rfds[42]));
+  fail_unless (read (rfds[42].fd, &c, 1) == 1, "read() failed");
+  fail_unless (gst_poll_wait (set, 0) == 0, "No descriptor should be ready");
+  fail_if (gst_poll_fd_can_read (set, &rfds[42]));
+
+  /* remove every other descriptor, moving the others around in the set */
+  for (i = 0; i < N_SOCKS; i += 2)
+    fail_unless (gst_poll_remove_fd (set, &rfds[i]));
+
+  fail_unless (write (wfds[42], &c, 1) == 1, "write() failed");
+  fail_unless (write (wfds[43], &c, 1) == 1, "write() failed");
+  fail_unless (gst_poll_wait (set, GST_CLOCK_TIME_NONE) == 1,
+      "One descriptor should be available");
+  fail_unless (gst_poll_fd_can_read (set, &rfds[43]));
+
+  wfd.fd = wfds[7];
+  fail_unless (gst_poll_add_fd (set, &wfd));
+  fail_unless (gst_poll_fd_ctl_write (set, &wfd, TRUE));
+  fail_unless (gst_poll_wait (set, GST_CLOCK_TIME_NONE) == 2,
+      "Two descriptors should be available");
+  fail_unless (gst_poll_fd_can_write (set, &wfd));
+  fail_unless (gst_poll_fd_can_read (set, &rfds[43]));
+
+  gst_poll_free (set);
+  for (i = 0; i < N_SOCKS; i++) {
+    close (rfds[i].fd);
+    close (wfds[i]);
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_poll_suite (void)
 {
@@ -343,6 +414,7 @@ gst_poll_suite (void)
   tcase_add_test (tc_chain, test_poll_wait_restart);
   tcase_add_test (tc_chain, test_poll_wait_flush);
   tcase_add_test (tc_chain, test_poll_controllable);
+  tcase_add_test (tc_chain, test_poll_many_fds);
 #else
   tcase_skip_broken_test (tc_chain, test_poll_basic);
 #ifdef HAVE_PIPE
@@ -353,6 +425,7 @@ gst_poll_suite (void)
   tcase_skip_broken_test (tc_chain, test_poll_wait_restart);
   tcase_skip_broken_test (tc_chain, test_poll_wait_flush);
   tcase_skip_broken_test (tc_chain, test_poll_controllable);
+  tcase_skip_broken_test (tc_chain, test_poll_many_fds);
 #endif
 
   return s;
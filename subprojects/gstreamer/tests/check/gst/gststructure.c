@@ -1034,6 +1034,58 @@ GST_START_TEST (test_flags)
 
 GST_END_TEST;
 
+GST_START_TEST (test_large_structure)
+{
+  GstStructure *s, *s2;
+  gchar *name;
+  gint i, val;
+
+  /* enough fields for lookups to go through the index */
+  s = gst_structure_new_empty ("test-struct");
+  for (i = 0; i < 100; i++) {
+    name = g_strdup_printf ("field-%d", i);
+    gst_structure_set (s, name, G_TYPE_INT, i, NULL);
+    g_free (name);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (s), 100);
+
+  /* replacing keeps the position */
+  gst_structure_set (s, "field-50", G_TYPE_INT, 500, NULL);
+  fail_unless_equals_int (gst_structure_n_fields (s), 100);
+  fail_unless_equals_string (gst_structure_nth_field_name (s, 50), "field-50");
+
+  /* removing shifts the following fields */
+  gst_structure_remove_field (s, "field-10");
+  fail_if (gst_structure_has_field (s, "field-10"));
+  fail_unless_equals_int (gst_structure_n_fields (s), 99);
+  fail_unless_equals_string (gst_structure_nth_field_name (s, 10), "field-11");
+
+  for (i = 0; i < 100; i++) {
+    if (i == 10)
+      continue;
+    name = g_strdup_printf ("field-%d", i);
+    fail_unless (gst_structure_get_int (s, name, &val));
+    fail_unless_equals_int (val, i == 50 ? 500 : i);
+    g_free (name);
+  }
+
+  s2 = gst_structure_copy (s);
+  fail_unless (gst_structure_is_equal (s, s2));
+  fail_unless (gst_structure_get_int (s2, "field-99", &val));
+  fail_unless_equals_int (val, 99);
+  gst_structure_free (s2);
+
+  gst_structure_remove_all_fields (s);
+  fail_unless_equals_int (gst_structure_n_fields (s), 0);
+  fail_if (gst_structure_has_field (s, "field-0"));
+  gst_structure_set (s, "field-0", G_TYPE_INT, 1, NULL);
+  fail_unless (gst_structure_get_int (s, "field-0", &val));
+  fail_unless_equals_int (val, 1);
+  gst_structure_free (s);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_structure_suite (void)
 {
@@ -1067,6 +1119,7 @@ gst_structure_suite (void)
   tcase_add_test (tc_chain, test_filter_and_map_in_place);
   tcase_add_test (tc_chain, test_flagset);
   tcase_add_test (tc_chain, test_flags);
+  tcase_add_test (tc_chain, test_large_structure);
   return s;
 }
 
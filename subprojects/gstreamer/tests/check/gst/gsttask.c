@@ -24,6 +24,11 @@
 
 #include <gst/check/gstcheck.h>
 
+#ifndef G_OS_WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 static GMutex task_lock;
 static GCond task_cond;
 
@@ -464,6 +469,237 @@ GST_START_TEST (test_shared_task_pool_two_threads)
 
 GST_END_TEST;
 
+typedef struct
+{
+  GstTask *task;
+  GRecMutex lock;
+  gint iterations;
+  gint max_iterations;
+  GThread *thread;
+} CoopTaskData;
+
+static GMutex coop_lock;
+static GCond coop_cond;
+
+/* runs max_iterations times and then waits for a wakeup */
+static void
+coop_task_func (CoopTaskData * data)
+{
+  g_mutex_lock (&coop_lock);
+  data->thread = g_thread_self ();
+  if (++data->iterations >= data->max_iterations) {
+    gst_task_wait_for_wakeup (data->task);
+    g_cond_broadcast (&coop_cond);
+  }
+  g_mutex_unlock (&coop_lock);
+}
+
+static void
+coop_task_data_init (CoopTaskData * data, GstTaskPool * pool,
+    GstTaskFunction func, gint max_iterations)
+{
+  data->task = gst_task_new (func, data, NULL);
+  g_rec_mutex_init (&data->lock);
+  gst_task_set_lock (data->task, &data->lock);
+  if (pool)
+    gst_task_set_pool (data->task, pool);
+  data->iterations = 0;
+  data->max_iterations = max_iterations;
+  data->thread = NULL;
+}
+
+static void
+coop_task_data_clear (CoopTaskData * data)
+{
+  fail_unless (gst_task_join (data->task));
+  gst_object_unref (data->task);
+  g_rec_mutex_clear (&data->lock);
+}
+
+static void
+coop_wait_iterations (CoopTaskData * data, gint iterations)
+{
+  g_mutex_lock (&coop_lock);
+  while (data->iterations < iterations)
+    g_cond_wait (&coop_cond, &coop_lock);
+  g_mutex_unlock (&coop_lock);
+}
+
+#define N_COOP_TASKS 200
+
+/* many tasks share the workers of a cooperative pool */
+GST_START_TEST (test_cooperative_task_pool)
+{
+  CoopTaskData data[N_COOP_TASKS];
+  GstTaskPool *pool;
+  GHashTable *threads;
+  GError *err = NULL;
+  gint i;
+
+  pool = gst_cooperative_task_pool_new ();
+  gst_cooperative_task_pool_set_n_workers (GST_COOPERATIVE_TASK_POOL (pool),
+      2);
+  fail_unless_equals_int (gst_cooperative_task_pool_get_n_workers
+      (GST_COOPERATIVE_TASK_POOL (pool)), 2);
+  gst_task_pool_prepare (pool, &err);
+  fail_unless (err == NULL);
+
+  for (i = 0; i < N_COOP_TASKS; i++) {
+    coop_task_data_init (&data[i], pool, (GstTaskFunction) coop_task_func,
+        10);
+    fail_unless (gst_task_start (data[i].task));
+  }
+
+  threads = g_hash_table_new (NULL, NULL);
+  for (i = 0; i < N_COOP_TASKS; i++) {
+    coop_wait_iterations (&data[i], 10);
+    g_hash_table_add (threads, data[i].thread);
+  }
+  /* the tasks did not block, so no extra workers were needed */
+  fail_unless (g_hash_table_size (threads) <= 2);
+  g_hash_table_unref (threads);
+
+  /* all tasks are waiting now and run again when woken up */
+  for (i = 0; i < N_COOP_TASKS; i++)
+    gst_task_wakeup (data[i].task);
+  for (i = 0; i < N_COOP_TASKS; i++)
+    coop_wait_iterations (&data[i], 11);
+
+  for (i = 0; i < N_COOP_TASKS; i++)
+    coop_task_data_clear (&data[i]);
+
+  g_mutex_lock (&coop_lock);
+  for (i = 0; i < N_COOP_TASKS; i++)
+    fail_unless_equals_int (data[i].iterations, 11);
+  g_mutex_unlock (&coop_lock);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+/* waiting for a wakeup also works on a task with its own thread */
+GST_START_TEST (test_wait_for_wakeup)
+{
+  CoopTaskData data;
+
+  coop_task_data_init (&data, NULL, (GstTaskFunction) coop_task_func, 1);
+  fail_unless (gst_task_start (data.task));
+
+  coop_wait_iterations (&data, 1);
+  /* pausing and resuming a waiting task calls the function again */
+  fail_unless (gst_task_pause (data.task));
+  fail_unless (gst_task_resume (data.task));
+  coop_wait_iterations (&data, 2);
+
+  gst_task_wakeup (data.task);
+  coop_wait_iterations (&data, 3);
+
+  coop_task_data_clear (&data);
+  fail_unless_equals_int (data.iterations, 3);
+}
+
+GST_END_TEST;
+
+static void
+coop_clock_task_func (CoopTaskData * data)
+{
+  GstClock *clock = gst_system_clock_obtain ();
+  GstClockID id;
+
+  g_mutex_lock (&coop_lock);
+  data->iterations++;
+  g_cond_broadcast (&coop_cond);
+  g_mutex_unlock (&coop_lock);
+
+  id = gst_clock_new_single_shot_id (clock,
+      gst_clock_get_time (clock) + 10 * GST_MSECOND);
+  gst_task_wait_for_clock_id (data->task, id);
+  gst_clock_id_unref (id);
+  gst_object_unref (clock);
+}
+
+GST_START_TEST (test_cooperative_wait_for_clock_id)
+{
+  CoopTaskData data;
+  GstTaskPool *pool;
+  GstClockTime start;
+
+  pool = gst_cooperative_task_pool_new ();
+  gst_cooperative_task_pool_set_n_workers (GST_COOPERATIVE_TASK_POOL (pool),
+      1);
+  gst_task_pool_prepare (pool, NULL);
+
+  coop_task_data_init (&data, pool, (GstTaskFunction) coop_clock_task_func,
+      0);
+
+  start = gst_util_get_timestamp ();
+  fail_unless (gst_task_start (data.task));
+  coop_wait_iterations (&data, 5);
+  /* every iteration waited for the clock */
+  fail_unless (gst_util_get_timestamp () - start >= 40 * GST_MSECOND);
+
+  coop_task_data_clear (&data);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+#ifndef G_OS_WIN32
+static gint coop_fds[2];
+
+static void
+coop_fd_task_func (CoopTaskData * data)
+{
+  gchar c;
+
+  g_mutex_lock (&coop_lock);
+  if (read (coop_fds[0], &c, 1) == 1) {
+    data->iterations++;
+    g_cond_broadcast (&coop_cond);
+  }
+  g_mutex_unlock (&coop_lock);
+
+  gst_task_wait_for_fd (data->task, coop_fds[0], G_IO_IN);
+}
+
+GST_START_TEST (test_cooperative_wait_for_fd)
+{
+  CoopTaskData data;
+  GstTaskPool *pool;
+  gint i;
+
+  fail_unless (pipe (coop_fds) == 0);
+  fail_unless (fcntl (coop_fds[0], F_SETFL, O_NONBLOCK) == 0);
+
+  pool = gst_cooperative_task_pool_new ();
+  gst_task_pool_prepare (pool, NULL);
+
+  coop_task_data_init (&data, pool, (GstTaskFunction) coop_fd_task_func, 0);
+  fail_unless (gst_task_start (data.task));
+
+  /* the task only runs when there is something to read */
+  for (i = 1; i <= 5; i++) {
+    fail_unless (write (coop_fds[1], "x", 1) == 1);
+    coop_wait_iterations (&data, i);
+  }
+
+  coop_task_data_clear (&data);
+  fail_unless_equals_int (data.iterations, 5);
+
+  close (coop_fds[0]);
+  close (coop_fds[1]);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+#endif
+
 static Suite *
 gst_task_suite (void)
 {
@@ -480,6 +716,12 @@ gst_task_suite (void)
   tcase_add_test (tc_chain, test_resume);
   tcase_add_test (tc_chain, test_shared_task_pool_shared_thread);
   tcase_add_test (tc_chain, test_shared_task_pool_two_threads);
+  tcase_add_test (tc_chain, test_cooperative_task_pool);
+  tcase_add_test (tc_chain, test_wait_for_wakeup);
+  tcase_add_test (tc_chain, test_cooperative_wait_for_clock_id);
+#ifndef G_OS_WIN32
+  tcase_add_test (tc_chain, test_cooperative_wait_for_fd);
+#endif
 
   return s;
 }
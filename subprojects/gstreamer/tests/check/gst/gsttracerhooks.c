@@ -0,0 +1,256 @@
+/* GStreamer
+ *
+ * Unit tests for the memory tracer hooks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+typedef struct
+{
+  GstTracer parent;
+} GstTestTracer;
+
+typedef struct
+{
+  GstTracerClass parent_class;
+} GstTestTracerClass;
+
+static GType gst_test_tracer_get_type (void);
+G_DEFINE_TYPE (GstTestTracer, gst_test_tracer, GST_TYPE_TRACER);
+
+static void
+gst_test_tracer_class_init (GstTestTracerClass * klass)
+{
+}
+
+static void
+gst_test_tracer_init (GstTestTracer * self)
+{
+}
+
+/* sizes of the memory seen by the hooks, in order */
+static GArray *alloc_sizes;
+static GArray *alloc_pooled;
+static GArray *copy_sizes;
+static GArray *merge_sizes;
+static GArray *merge_n_memory;
+
+static gsize
+memory_size (GstMemory * mem)
+{
+  return gst_memory_get_sizes (mem, NULL, NULL);
+}
+
+static void
+do_memory_alloc (GObject * self, GstClockTime ts, GstAllocator * allocator,
+    GstMemory * memory, GstBufferPool * pool)
+{
+  gsize size = memory_size (memory);
+  gboolean pooled = pool != NULL;
+
+  fail_unless (GST_IS_ALLOCATOR (allocator));
+  g_array_append_val (alloc_sizes, size);
+  g_array_append_val (alloc_pooled, pooled);
+}
+
+static void
+do_memory_copy (GObject * self, GstClockTime ts, GstMemory * memory,
+    GstMemory * copy)
+{
+  gsize size = memory_size (copy);
+
+  fail_unless (memory != copy);
+  g_array_append_val (copy_sizes, size);
+}
+
+static void
+do_memory_merge (GObject * self, GstClockTime ts, GstBuffer * buffer,
+    guint n_memory, GstMemory * merged)
+{
+  gsize size = memory_size (merged);
+
+  fail_unless (GST_IS_BUFFER (buffer));
+  g_array_append_val (merge_sizes, size);
+  g_array_append_val (merge_n_memory, n_memory);
+}
+
+static void
+setup (void)
+{
+  static GstTracer *tracer = NULL;
+
+  /* hooks can't be removed again, register them only once */
+  if (tracer == NULL) {
+    tracer = g_object_new (gst_test_tracer_get_type (), NULL);
+    gst_object_ref_sink (tracer);
+    gst_tracing_register_hook (tracer, "memory-alloc",
+        G_CALLBACK (do_memory_alloc));
+    gst_tracing_register_hook (tracer, "memory-copy",
+        G_CALLBACK (do_memory_copy));
+    gst_tracing_register_hook (tracer, "memory-merge",
+        G_CALLBACK (do_memory_merge));
+  }
+
+  alloc_sizes = g_array_new (FALSE, FALSE, sizeof (gsize));
+  alloc_pooled = g_array_new (FALSE, FALSE, sizeof (gboolean));
+  copy_sizes = g_array_new (FALSE, FALSE, sizeof (gsize));
+  merge_sizes = g_array_new (FALSE, FALSE, sizeof (gsize));
+  merge_n_memory = g_array_new (FALSE, FALSE, sizeof (guint));
+}
+
+static void
+cleanup (void)
+{
+  g_array_unref (alloc_sizes);
+  g_array_unref (alloc_pooled);
+  g_array_unref (copy_sizes);
+  g_array_unref (merge_sizes);
+  g_array_unref (merge_n_memory);
+}
+
+GST_START_TEST (test_memory_alloc)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstBuffer *buf;
+  GstMemory *mem;
+
+  mem = gst_allocator_alloc (NULL, 100, NULL);
+  fail_unless_equals_int (alloc_sizes->len, 1);
+  fail_unless_equals_int (g_array_index (alloc_sizes, gsize, 0), 100);
+  fail_unless (!g_array_index (alloc_pooled, gboolean, 0));
+  gst_memory_unref (mem);
+
+  /* allocations of a pool get the pool passed */
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, 200, 0, 0);
+  fail_unless (gst_buffer_pool_set_config (pool, config));
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+          NULL) == GST_FLOW_OK);
+  fail_unless_equals_int (alloc_sizes->len, 2);
+  fail_unless_equals_int (g_array_index (alloc_sizes, gsize, 1), 200);
+  fail_unless (g_array_index (alloc_pooled, gboolean, 1));
+
+  gst_buffer_unref (buf);
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_memory_copy_deep)
+{
+  GstBuffer *buf, *copy;
+
+  buf = gst_buffer_new_allocate (NULL, 100, NULL);
+  gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, 50, NULL));
+  fail_unless_equals_int (copy_sizes->len, 0);
+
+  copy = gst_buffer_copy_deep (buf);
+  fail_unless_equals_int (copy_sizes->len, 2);
+  fail_unless_equals_int (g_array_index (copy_sizes, gsize, 0), 100);
+  fail_unless_equals_int (g_array_index (copy_sizes, gsize, 1), 50);
+  fail_unless_equals_int (merge_sizes->len, 0);
+
+  gst_buffer_unref (copy);
+  gst_buffer_unref (buf);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_memory_copy_map_shared)
+{
+  GstBuffer *buf1, *buf2;
+  GstMemory *mem;
+  GstMapInfo map;
+
+  /* the memory is in two buffers, mapping it writable needs a copy */
+  mem = gst_allocator_alloc (NULL, 64, NULL);
+  buf1 = gst_buffer_new ();
+  gst_buffer_append_memory (buf1, gst_memory_ref (mem));
+  buf2 = gst_buffer_new ();
+  gst_buffer_append_memory (buf2, mem);
+
+  /* reading does not copy */
+  fail_unless (gst_buffer_map (buf1, &map, GST_MAP_READ));
+  gst_buffer_unmap (buf1, &map);
+  fail_unless_equals_int (copy_sizes->len, 0);
+
+  fail_unless (gst_buffer_map (buf1, &map, GST_MAP_WRITE));
+  gst_buffer_unmap (buf1, &map);
+  fail_unless_equals_int (copy_sizes->len, 1);
+  fail_unless_equals_int (g_array_index (copy_sizes, gsize, 0), 64);
+
+  gst_buffer_unref (buf1);
+  gst_buffer_unref (buf2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_memory_merge)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, 10, NULL));
+  gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, 20, NULL));
+  gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, 30, NULL));
+  fail_unless_equals_int (alloc_sizes->len, 3);
+
+  /* mapping all memory at once merges it into a new memory */
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, 60);
+  gst_buffer_unmap (buf, &map);
+
+  fail_unless_equals_int (merge_sizes->len, 1);
+  fail_unless_equals_int (g_array_index (merge_sizes, gsize, 0), 60);
+  fail_unless_equals_int (g_array_index (merge_n_memory, guint, 0), 3);
+  /* the merged memory was allocated too */
+  fail_unless_equals_int (alloc_sizes->len, 4);
+  fail_unless_equals_int (g_array_index (alloc_sizes, gsize, 3), 60);
+  fail_unless_equals_int (copy_sizes->len, 0);
+
+  gst_buffer_unref (buf);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_tracer_hooks_suite (void)
+{
+  Suite *s = suite_create ("GstTracerHooks");
+  TCase *tc_chain = tcase_create ("memory");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, setup, cleanup);
+  tcase_add_test (tc_chain, test_memory_alloc);
+  tcase_add_test (tc_chain, test_memory_copy_deep);
+  tcase_add_test (tc_chain, test_memory_copy_map_shared);
+  tcase_add_test (tc_chain, test_memory_merge);
+
+  return s;
+}
+
+GST_CHECK_MAIN (gst_tracer_hooks);
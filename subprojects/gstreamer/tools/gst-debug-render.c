@@ -0,0 +1,520 @@
+/* GStreamer
+ *
+ * gst-debug-render.c: turn binary debug logs into text
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Reads the files written by gst_debug_add_binary_logger(), see the
+ * description of the format in gst/gstinfo.c */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tools.h"
+
+#define BINARY_LOG_MAGIC "GSTBLOG"
+#define BINARY_LOG_BYTE_ORDER 0x01020304
+#define BINARY_LOG_VERSION 1
+
+enum
+{
+  BINARY_RECORD_STRING = 1,
+  BINARY_RECORD_MESSAGE = 2,
+  BINARY_RECORD_DROPPED = 3,
+};
+
+enum
+{
+  BINARY_ARG_END = 0,
+  BINARY_ARG_INT = 1,
+  BINARY_ARG_INT64 = 2,
+  BINARY_ARG_DOUBLE = 3,
+  BINARY_ARG_STRING = 4,
+  BINARY_ARG_POINTER = 5,
+};
+
+/* same as the output of gst_debug_log_default() without colors */
+#if GLIB_SIZEOF_VOID_P == 8
+#define PTR_FMT "%14p"
+#else
+#define PTR_FMT "%10p"
+#endif
+#define PRINT_FMT " %5u "PTR_FMT" %s %20s %s:%d:%s:%s%s%s %s\n"
+
+typedef struct
+{
+  const guint8 *data;
+  const guint8 *end;
+} Reader;
+
+typedef struct
+{
+  GstClockTime timestamp;
+  guint seqnum;
+  gchar *line;
+} Line;
+
+static gboolean unsorted = FALSE;
+
+static guint pid;
+/* thread -> (key -> string) */
+static GHashTable *strings;
+static GArray *lines;
+
+static gboolean
+read_bytes (Reader * r, gpointer dest, gsize len)
+{
+  if ((gsize) (r->end - r->data) < len)
+    return FALSE;
+  memcpy (dest, r->data, len);
+  r->data += len;
+  return TRUE;
+}
+
+#define read_u8(r,v) read_bytes (r, v, 1)
+#define read_u32(r,v) read_bytes (r, v, 4)
+#define read_u64(r,v) read_bytes (r, v, 8)
+
+static gboolean
+read_string (Reader * r, gchar ** str)
+{
+  guint32 len;
+
+  if (!read_u32 (r, &len) || (gsize) (r->end - r->data) < len)
+    return FALSE;
+  *str = g_strndup ((const gchar *) r->data, len);
+  r->data += len;
+  return TRUE;
+}
+
+static const gchar *
+lookup_string (guint64 thread, guint64 key)
+{
+  GHashTable *table;
+  const gchar *str = NULL;
+
+  table = g_hash_table_lookup (strings, &thread);
+  if (table)
+    str = g_hash_table_lookup (table, &key);
+
+  return str ? str : "???";
+}
+
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#endif
+
+/* appends a single conversion of a printf format, with the given number of
+ * '*' arguments */
+#define APPEND_CONVERSION(out,spec,stars,n_stars,val) G_STMT_START {   \
+  if (n_stars == 2)                                                     \
+    g_string_append_printf (out, spec, stars[0], stars[1], val);        \
+  else if (n_stars == 1)                                                \
+    g_string_append_printf (out, spec, stars[0], val);                  \
+  else                                                                  \
+    g_string_append_printf (out, spec, val);                            \
+} G_STMT_END
+
+static gboolean
+read_arg (Reader * r, guint8 expected)
+{
+  guint8 tag;
+
+  return read_u8 (r, &tag) && tag == expected;
+}
+
+/* the same parsing as binary_log_append_args() in gst/gstinfo.c */
+static gboolean
+render_format (GString * out, const gchar * format, Reader * r)
+{
+  const gchar *p = format;
+  GString *spec = g_string_new (NULL);
+  gboolean ret = FALSE;
+
+  while (*p) {
+    gint stars[2];
+    guint n_stars = 0;
+
+    if (*p != '%') {
+      g_string_append_c (out, *p++);
+      continue;
+    }
+    if (p[1] == '%') {
+      g_string_append_c (out, '%');
+      p += 2;
+      continue;
+    }
+
+    g_string_assign (spec, "%");
+    p++;
+
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0'
+        || *p == '\'')
+      g_string_append_c (spec, *p++);
+
+    if (*p == '*') {
+      if (!read_arg (r, BINARY_ARG_INT) || !read_u32 (r, &stars[n_stars++]))
+        goto done;
+      g_string_append_c (spec, *p++);
+    } else {
+      while (g_ascii_isdigit (*p))
+        g_string_append_c (spec, *p++);
+    }
+    if (*p == '.') {
+      g_string_append_c (spec, *p++);
+      if (*p == '*') {
+        if (!read_arg (r, BINARY_ARG_INT) || !read_u32 (r, &stars[n_stars++]))
+          goto done;
+        g_string_append_c (spec, *p++);
+      } else {
+        while (g_ascii_isdigit (*p))
+          g_string_append_c (spec, *p++);
+      }
+    }
+
+    /* length modifiers, all integers were stored as 64 bit */
+    if (*p == 'h' || *p == 'l')
+      p += p[1] == *p ? 2 : 1;
+    else if (*p == 'q' || *p == 'j' || *p == 'z' || *p == 't')
+      p++;
+    else if (p[0] == 'I' && p[1] == '6' && p[2] == '4')
+      p += 3;
+
+    switch (*p) {
+      case 'd':
+      case 'i':
+      case 'o':
+      case 'u':
+      case 'x':
+      case 'X':{
+        guint64 val;
+
+        if (!read_arg (r, BINARY_ARG_INT64) || !read_u64 (r, &val))
+          goto done;
+        g_string_append_printf (spec, "%" G_GINT64_MODIFIER "%c", *p);
+        APPEND_CONVERSION (out, spec->str, stars, n_stars, val);
+        break;
+      }
+      case 'c':{
+        gint32 val;
+
+        if (!read_arg (r, BINARY_ARG_INT) || !read_u32 (r, &val))
+          goto done;
+        g_string_append_c (spec, *p);
+        APPEND_CONVERSION (out, spec->str, stars, n_stars, val);
+        break;
+      }
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':{
+        gdouble val;
+
+        if (!read_arg (r, BINARY_ARG_DOUBLE) || !read_u64 (r, &val))
+          goto done;
+        g_string_append_c (spec, *p);
+        APPEND_CONVERSION (out, spec->str, stars, n_stars, val);
+        break;
+      }
+      case 's':{
+        gchar *val;
+
+        if (!read_arg (r, BINARY_ARG_STRING) || !read_string (r, &val))
+          goto done;
+        g_string_append_c (spec, *p);
+        APPEND_CONVERSION (out, spec->str, stars, n_stars, val);
+        g_free (val);
+        break;
+      }
+      case 'p':{
+        guint64 val;
+
+        if (!read_arg (r, BINARY_ARG_POINTER) || !read_u64 (r, &val))
+          goto done;
+        g_string_append_c (spec, *p);
+        APPEND_CONVERSION (out, spec->str, stars, n_stars,
+            (gpointer) (guintptr) val);
+        break;
+      }
+      default:
+        goto done;
+    }
+    p++;
+  }
+
+  ret = read_arg (r, BINARY_ARG_END);
+
+done:
+  g_string_free (spec, TRUE);
+  return ret;
+}
+
+static gboolean
+render_message (Reader * r)
+{
+  guint64 timestamp, thread, category, file, function, format;
+  guint32 line, level;
+  gchar *object_id = NULL;
+  GString *message;
+  Line l;
+
+  if (!read_u64 (r, &timestamp) || !read_u64 (r, &thread)
+      || !read_u64 (r, &category) || !read_u64 (r, &file)
+      || !read_u64 (r, &function) || !read_u64 (r, &format)
+      || !read_u32 (r, &line) || !read_u32 (r, &level)
+      || !read_string (r, &object_id))
+    goto error;
+
+  message = g_string_new (NULL);
+  if (format == 0) {
+    if (!render_format (message, "%s", r))
+      goto message_error;
+  } else {
+    if (!render_format (message, lookup_string (thread, format), r))
+      goto message_error;
+  }
+
+  l.timestamp = timestamp;
+  l.seqnum = lines->len;
+  l.line = g_strdup_printf ("%" GST_TIME_FORMAT PRINT_FMT,
+      GST_TIME_ARGS (timestamp), pid, (gpointer) (guintptr) thread,
+      gst_debug_level_get_name (level), lookup_string (thread, category),
+      lookup_string (thread, file), line, lookup_string (thread, function),
+      *object_id ? "<" : "", object_id, *object_id ? ">" : "", message->str);
+
+  if (unsorted) {
+    fputs (l.line, stdout);
+    g_free (l.line);
+  } else {
+    g_array_append_val (lines, l);
+  }
+
+  g_string_free (message, TRUE);
+  g_free (object_id);
+  return TRUE;
+
+message_error:
+  g_string_free (message, TRUE);
+error:
+  g_free (object_id);
+  return FALSE;
+}
+
+static gboolean
+read_string_record (Reader * r)
+{
+  guint64 thread, key, *k;
+  GHashTable *table;
+  gchar *str;
+
+  if (!read_u64 (r, &thread) || !read_u64 (r, &key) || !read_string (r, &str))
+    return FALSE;
+
+  table = g_hash_table_lookup (strings, &thread);
+  if (!table) {
+    table = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free,
+        g_free);
+    k = g_new (guint64, 1);
+    *k = thread;
+    g_hash_table_insert (strings, k, table);
+  }
+  k = g_new (guint64, 1);
+  *k = key;
+  g_hash_table_insert (table, k, str);
+
+  return TRUE;
+}
+
+static gint
+compare_lines (const Line * a, const Line * b)
+{
+  if (a->timestamp != b->timestamp)
+    return a->timestamp < b->timestamp ? -1 : 1;
+  return a->seqnum < b->seqnum ? -1 : (a->seqnum > b->seqnum);
+}
+
+static gboolean
+render_file (const gchar * filename)
+{
+  GMappedFile *file;
+  GError *err = NULL;
+  Reader r;
+  gchar magic[8];
+  guint32 byte_order, version, pointer_size;
+  gboolean ret = FALSE;
+  guint i;
+
+  file = g_mapped_file_new (filename, FALSE, &err);
+  if (!file) {
+    g_printerr ("Could not open %s: %s\n", filename, err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  r.data = (const guint8 *) g_mapped_file_get_contents (file);
+  r.end = r.data + g_mapped_file_get_length (file);
+
+  if (!read_bytes (&r, magic, 8) || memcmp (magic, BINARY_LOG_MAGIC, 8) != 0
+      || !read_u32 (&r, &byte_order) || !read_u32 (&r, &version)
+      || !read_u32 (&r, &pointer_size) || !read_u32 (&r, &pid)) {
+    g_printerr ("%s is not a binary GStreamer log\n", filename);
+    goto done;
+  }
+  if (byte_order != BINARY_LOG_BYTE_ORDER) {
+    g_printerr ("%s was written on a machine with different byte order\n",
+        filename);
+    goto done;
+  }
+  if (version != BINARY_LOG_VERSION) {
+    g_printerr ("%s has unsupported version %u\n", filename, version);
+    goto done;
+  }
+
+  strings = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free,
+      (GDestroyNotify) g_hash_table_unref);
+  lines = g_array_new (FALSE, FALSE, sizeof (Line));
+
+  while (r.data < r.end) {
+    Reader record;
+    guint32 size;
+    guint8 type;
+
+    record = r;
+    if (!read_u32 (&record, &size) || !read_u8 (&record, &type)
+        || size < 8 || size > (gsize) (r.end - r.data)) {
+      g_printerr ("%s is truncated\n", filename);
+      break;
+    }
+    record.data = r.data + 8;
+    record.end = r.data + size;
+    r.data += size;
+
+    switch (type) {
+      case BINARY_RECORD_STRING:
+        if (!read_string_record (&record))
+          g_printerr ("Invalid string record\n");
+        break;
+      case BINARY_RECORD_MESSAGE:
+        if (!render_message (&record))
+          g_printerr ("Invalid message record\n");
+        break;
+      case BINARY_RECORD_DROPPED:{
+        guint64 thread, count;
+
+        if (read_u64 (&record, &thread) && read_u64 (&record, &count))
+          g_printerr ("Thread %p dropped %" G_GUINT64_FORMAT " messages\n",
+              (gpointer) (guintptr) thread, count);
+        break;
+      }
+      default:
+        /* unknown records are skipped */
+        break;
+    }
+  }
+
+  g_array_sort (lines, (GCompareFunc) compare_lines);
+  for (i = 0; i < lines->len; i++) {
+    Line *l = &g_array_index (lines, Line, i);
+
+    fputs (l->line, stdout);
+    g_free (l->line);
+  }
+  g_array_free (lines, TRUE);
+  g_hash_table_unref (strings);
+  ret = TRUE;
+
+done:
+  g_mapped_file_unref (file);
+  return ret;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gchar **filenames = NULL;
+  guint num;
+  GError *err = NULL;
+  GOptionContext *ctx;
+  gboolean ret;
+  GOptionEntry options[] = {
+    {"unsorted", 'u', 0, G_OPTION_ARG_NONE, &unsorted,
+        N_("Print messages in the order they were written instead of sorting "
+              "them by time"), NULL},
+    GST_TOOLS_GOPTION_VERSION,
+    {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL}
+    ,
+    {NULL}
+  };
+
+#ifdef ENABLE_NLS
+  bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
+  bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+  textdomain (GETTEXT_PACKAGE);
+#endif
+
+  g_set_prgname ("gst-debug-render-" GST_API_VERSION);
+
+#ifdef G_OS_WIN32
+  argv = g_win32_get_command_line ();
+#endif
+
+  ctx = g_option_context_new ("FILE");
+  g_option_context_add_main_entries (ctx, options, GETTEXT_PACKAGE);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+#ifdef G_OS_WIN32
+  if (!g_option_context_parse_strv (ctx, &argv, &err))
+#else
+  if (!g_option_context_parse (ctx, &argc, &argv, &err))
+#endif
+  {
+    g_print ("Error initializing: %s\n", GST_STR_NULL (err->message));
+    exit (1);
+  }
+  g_option_context_free (ctx);
+
+  gst_tools_print_version ();
+
+  if (filenames == NULL || *filenames == NULL) {
+    g_print ("Please give one filename to %s\n\n", g_get_prgname ());
+    return 1;
+  }
+  num = g_strv_length (filenames);
+  if (num > 1) {
+    g_print ("Please give exactly one filename to %s (%d given).\n\n",
+        g_get_prgname (), num);
+    return 1;
+  }
+
+  ret = render_file (filenames[0]);
+
+  g_strfreev (filenames);
+
+#ifdef G_OS_WIN32
+  g_strfreev (argv);
+#endif
+
+  return ret ? 0 : 1;
+}